@@ -0,0 +1,204 @@
+/*
+ * binary_parser.c - packed binary block streaming parser
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Binary block streaming
+ *
+ *	Dense jobs - raster laser engraving in particular - are limited by ASCII
+ *	gcode density over the 115200 baud USART, not by the planner. A binary
+ *	record carries the same straight-line move in a fraction of the bytes and
+ *	skips block normalization and gcode word parsing entirely.
+ *
+ *	Records ride the existing line discipline: a record is a line starting
+ *	with '*' and terminated by LF, so flow control, the RX ISR signal traps
+ *	(feedhold, reset, etc.) and the line assembly in xio are all unchanged.
+ *	Since the RX path masks input to 7 bits and traps several byte values,
+ *	raw 8-bit payloads cannot survive the link. Fields are packed in 6-bit
+ *	symbols using the base64 alphabet (A-Za-z0-9+/) instead.
+ *
+ *	Record layout, one symbol = 6 bits, fields big-endian:
+ *
+ *	  '*'					record marker (dispatched in controller.c)
+ *	  symbol  axis mask		bits 0-5 = X,Y,Z,A,B,C axis delta present
+ *	  symbol  flags			see BINARY_FLAG_ definitions in binary_parser.h
+ *	  4 symbols per axis	signed 24 bit axis delta in microns (0.001 mm),
+ *							one field for each bit set in the axis mask,
+ *							in axis order
+ *	  3 symbols				unsigned 18 bit feed rate in mm/min, present
+ *							only if BINARY_FLAG_FEED_RATE is set
+ *	  N symbols				intensity run - present only if BINARY_FLAG_INTENSITY
+ *							is set. Each symbol is one 6-bit laser power sample
+ *							(expanded to 8 bits), queued to the raster ring and
+ *							consumed one per DDA segment (see pwm.c). Runs to
+ *							the end of the record.
+ *	  LF					line terminator
+ *
+ *	Axis deltas are always incremental millimeters and feed is always
+ *	units-per-minute mm - records ignore the G90/G91, G20/G21 and G93 modal
+ *	states so the stream cannot be corrupted by a stray modal block. The
+ *	gcode model position is advanced normally, so binary and ASCII blocks
+ *	can be interleaved (e.g. ASCII setup and M-code blocks around a binary
+ *	raster region).
+ *
+ *	Responses are only sent for errors - a 'go' response per record would
+ *	eat the bandwidth the format exists to save. Hosts should use flow
+ *	control (XON/XOFF or RTS/CTS) and the queue reports for pacing.
+ *
+ *	Raster engraving: BINARY_FLAG_RASTER_ON / _OFF bracket a raster region
+ *	(both are queued so they synchronize with motion - see cm_raster_mode),
+ *	and records inside it carry their row's power samples in the intensity
+ *	run. A record whose axis mask is zero executes no move, so intensity
+ *	data can also be streamed ahead of motion in mask-less records. If the
+ *	raster ring cannot take the whole run the record is rejected with
+ *	STAT_BUFFER_FULL before any of it executes - the host retries it whole.
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>			// precursor for xio.h
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "binary_parser.h"
+#include "canonical_machine.h"
+#include "spindle.h"				// for cm_raster_mode
+#include "pwm.h"					// for the raster intensity ring
+
+static stat_t _get_bits(char **pstr, uint8_t symbols, uint32_t *bits);
+
+/*
+ * bn_binary_parser() - decode and execute one binary block record
+ *
+ *	Accepts the record with its leading '*' marker, as dispatched from
+ *	controller.c. The record is executed at cm_straight_feed() /
+ *	cm_straight_traverse() level with the units and distance modal state
+ *	forced for the duration of the call (and restored afterwards).
+ */
+
+stat_t bn_binary_parser(char_t *block)
+{
+	char *str = (char *)block + 1;		// skip the '*' record marker
+	uint32_t bits;
+	float target[AXES];
+	float flags[AXES];
+	float feed_rate = 0;
+	stat_t status;
+
+	ritorno(_get_bits(&str, 1, &bits));
+	uint8_t axis_mask = (uint8_t)bits;
+	ritorno(_get_bits(&str, 1, &bits));
+	uint8_t record_flags = (uint8_t)bits;
+
+	for (uint8_t axis = 0; axis < AXES; axis++) {
+		if ((axis_mask & (1 << axis)) == 0) {
+			target[axis] = 0;
+			flags[axis] = false;
+			continue;
+		}
+		ritorno(_get_bits(&str, BINARY_AXIS_SYMBOLS, &bits));
+		if (bits & 0x00800000) { bits |= 0xFF000000; }	// sign extend 24 bits
+		target[axis] = (float)(int32_t)bits / 1000;		// microns to mm
+		flags[axis] = true;
+	}
+	if (record_flags & BINARY_FLAG_FEED_RATE) {
+		ritorno(_get_bits(&str, BINARY_FEED_SYMBOLS, &bits));
+		feed_rate = (float)bits;
+	}
+	if (record_flags & BINARY_FLAG_RASTER_ON) {
+		pwm_raster_reset();					// new region - discard stale samples
+	}										//  before this record's run queues
+	if (record_flags & BINARY_FLAG_INTENSITY) {
+		char *run = str;					// validate and size the run before
+		uint8_t samples = 0;				//  queueing so a bad or oversized
+		while (*run != NUL) {				//  record queues nothing at all
+			ritorno(_get_bits(&run, 1, &bits));
+			samples++;
+		}
+		if (samples > pwm_raster_space()) { return (STAT_BUFFER_FULL);}
+		while (*str != NUL) {
+			(void)_get_bits(&str, 1, &bits);
+			pwm_raster_queue((uint8_t)((bits << 2) | (bits >> 4)));	// expand 6 bits to 8
+		}
+	}
+	if (*str != NUL) { return (STAT_UNRECOGNIZED_COMMAND); }	// trailing garbage
+
+	// execute with units and distance modes pinned to mm / incremental
+	uint8_t saved_units_mode = gm.units_mode;
+	float saved_units_scale = gm.units_scale;
+	uint8_t saved_distance_mode = gm.distance_mode;
+	uint8_t saved_inverse_feed_rate_mode = gm.inverse_feed_rate_mode;
+	gm.units_mode = MILLIMETERS;
+	gm.units_scale = 1;					// keep the cached multiplier in step (see cm_set_units_mode)
+	gm.distance_mode = INCREMENTAL_MODE;
+	gm.inverse_feed_rate_mode = false;
+
+	if (record_flags & BINARY_FLAG_FEED_RATE) {
+		cm_set_feed_rate(feed_rate);	// persists for following records
+	}
+	if (record_flags & BINARY_FLAG_RASTER_ON) {		// enters ahead of this record's move
+		(void)cm_raster_mode(true);
+	}
+	if (axis_mask == 0) {							// mask-less control / intensity record
+		status = STAT_OK;
+	} else if (record_flags & BINARY_FLAG_TRAVERSE) {
+		status = cm_straight_traverse(target, flags);
+	} else {
+		status = cm_straight_feed(target, flags);
+	}
+	if (record_flags & BINARY_FLAG_RASTER_OFF) {	// leaves after this record's move
+		(void)cm_raster_mode(false);
+	}
+	gm.units_mode = saved_units_mode;
+	gm.units_scale = saved_units_scale;
+	gm.distance_mode = saved_distance_mode;
+	gm.inverse_feed_rate_mode = saved_inverse_feed_rate_mode;
+	return (status);
+}
+
+/*
+ * _get_bits() - accumulate a big-endian field of N 6-bit symbols
+ *
+ *	Returns STAT_BAD_NUMBER_FORMAT if a symbol is not in the base64
+ *	alphabet or the record ends early.
+ */
+
+static stat_t _get_bits(char **pstr, uint8_t symbols, uint32_t *bits)
+{
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < symbols; i++) {
+		char c = *(*pstr)++;
+		if ((c >= 'A') && (c <= 'Z')) { value = (value << 6) | (c - 'A'); }
+		else if ((c >= 'a') && (c <= 'z')) { value = (value << 6) | (c - 'a' + 26); }
+		else if ((c >= '0') && (c <= '9')) { value = (value << 6) | (c - '0' + 52); }
+		else if (c == '+') { value = (value << 6) | 62; }
+		else if (c == '/') { value = (value << 6) | 63; }
+		else { return (STAT_BAD_NUMBER_FORMAT); }	// includes early NUL
+	}
+	*bits = value;
+	return (STAT_OK);
+}
@@ -0,0 +1,50 @@
+/*
+ * binary_parser.h - packed binary block streaming parser
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef binary_parser_h
+#define binary_parser_h
+
+/* Binary record flag bits (second symbol of a record) */
+
+#define BINARY_FLAG_TRAVERSE	0x01	// move is a traverse (G0), else a feed (G1)
+#define BINARY_FLAG_FEED_RATE	0x02	// record carries a feed rate field
+#define BINARY_FLAG_RASTER_ON	0x04	// enter raster mode before this record's move
+#define BINARY_FLAG_RASTER_OFF	0x08	// leave raster mode after this record's move
+#define BINARY_FLAG_INTENSITY	0x10	// record ends with an intensity run
+
+/* Field widths in 6-bit symbols */
+
+#define BINARY_AXIS_SYMBOLS 4			// 24 bit signed axis delta in microns
+#define BINARY_FEED_SYMBOLS 3			// 18 bit unsigned feed rate in mm/min
+
+/*
+ * Global Scope Functions
+ */
+
+stat_t bn_binary_parser(char_t *block);
+
+#endif
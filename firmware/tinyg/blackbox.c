@@ -0,0 +1,268 @@
+/*
+ * blackbox.c - trajectory flight recorder
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* ---- Trajectory flight recorder ----
+ *
+ *	When a crash scraps a part the evidence is usually gone with it - the
+ *	status reports the host kept are seconds apart and say nothing about
+ *	what the switches saw. With $bbx=1 every executed segment leaves a 32
+ *	byte record (timestamp, XYZA position, velocity, line number, thrown
+ *	switches) in a circular region at the top of the job storage flash,
+ *	and $bbxd dumps the trail after the event:
+ *
+ *	  $bbx=1         arm the recorder (persists - a flight recorder that
+ *	                 needs arming after the crash has missed the point)
+ *	  $bbxd=n        dump the last n seconds as JSON records (0 = all)
+ *
+ *	The exec-side cost is one record copy into a RAM page image - well
+ *	under 1% of the segment budget. Full page images are programmed to the
+ *	flash from the mainline where the (bit-banged) bus only contends with
+ *	the job prefetcher; the exec never waits on the flash. If the mainline
+ *	falls behind, records are dropped - never blocking motion - and the
+ *	next record carries a gap flag so the dump shows where the trail broke.
+ *
+ *	NOR pages must be erased before they are programmed, and a sector
+ *	erase takes long enough to starve the planner, so erases only run
+ *	while no cycle is active. A log that wraps mid-cycle into un-erased
+ *	sectors drops pages (with gap flags) until the machine stops - in
+ *	practice the region holds tens of seconds and the wrap point is
+ *	re-erased between cycles. On boot (or on $bbx=1) the region is scanned
+ *	for the newest record so logging continues where it left off; the few
+ *	records in an unfilled RAM page at power loss are the only ones lost.
+ */
+
+#include <stdio.h>						// precursor for xio.h
+#include <stdbool.h>					// true and false
+#include <string.h>						// for memset
+#include <avr/pgmspace.h>				// precursor for xio.h
+
+#include "tinyg.h"
+#include "config.h"
+#include "canonical_machine.h"			// cycle state gates erases and dumps
+#include "planner.h"					// runtime snapshot getters
+#include "job.h"						// flash geometry - the log shares the part
+#include "blackbox.h"
+#include "gpio.h"						// switch states
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"			// record timestamps
+
+#define BBX_SPI_DEV XIO_DEV_SPI2		// select line the flash is on (see xio_flash.c)
+#define BBX_SEQ_OFFSET (sizeof(bbxRecord_t) - sizeof(uint16_t))	// sequence is the last field
+#define BBX_TICKS_PER_SEC (1000 / RTC_MILLISECONDS)
+
+typedef struct bbxSingleton {
+	uint8_t logging;					// capture is armed
+	uint8_t active;						// page image the exec is filling
+	uint8_t fill;						// records in the filling page image
+	volatile uint8_t flush_pending;		// the other page image is full and unwritten
+	volatile uint8_t gap;				// records were dropped - flag the next one
+	uint16_t sequence;					// next record sequence number
+	uint16_t wr_page;					// next region page to program (region relative)
+	bbxRecord_t page[2][BBX_PAGE_RECORDS];	// double buffered page images
+} bbxSingleton_t;
+static bbxSingleton_t bbx;
+
+static uint32_t _bbx_page_addr(uint16_t page)
+{
+	return (BBX_REGION_ADDR + ((uint32_t)page << 8));
+}
+
+/*
+ * _bbx_scan() - find where the previous session left off
+ * _bbx_start() - arm the recorder
+ *
+ *	Reads the first record's sequence number from every region page: the
+ *	first erased page (0xFFFF) is where logging resumes, and the largest
+ *	sequence seen (16 bit wraparound compare) restarts the counter. The
+ *	scan is a couple of bus-bytes per page - under 100ms at boot.
+ */
+static void _bbx_scan(void)
+{
+	uint16_t seq;
+	uint16_t newest = 0;
+	uint8_t found = false;
+	uint8_t resumed = false;
+
+	bbx.wr_page = 0;
+	for (uint16_t p=0; p<BBX_FLASH_PAGES; p++) {
+		xio_read_spi_flash(BBX_SPI_DEV, _bbx_page_addr(p) + BBX_SEQ_OFFSET, (char *)&seq, 2);
+		if (seq == 0xFFFF) {				// erased - logging can resume here
+			if (resumed == false) {
+				bbx.wr_page = p;
+				resumed = true;
+			}
+			continue;
+		}
+		if ((found == false) || ((int16_t)(seq - newest) > 0)) { newest = seq;}
+		found = true;
+	}
+	bbx.sequence = (found == true) ? newest + 1 : 0;
+	if (bbx.sequence == 0xFFFF) { bbx.sequence = 0;}	// 0xFFFF means erased
+}
+
+static void _bbx_start(void)
+{
+	bbx.fill = 0;
+	bbx.active = 0;
+	bbx.flush_pending = false;
+	bbx.gap = false;
+	_bbx_scan();
+	bbx.logging = true;
+}
+
+void bbx_init()
+{
+	if (cfg.bbx_enable == true) { _bbx_start();}
+}
+
+/*
+ * bbx_set_enable() - $bbx=1/0 - arm or disarm the recorder
+ */
+stat_t bbx_set_enable(cmdObj_t *cmd)
+{
+	if (cmd->value > 1) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	cfg.bbx_enable = (uint8_t)cmd->value;
+	if (cfg.bbx_enable == true) {
+		if (bbx.logging == false) { _bbx_start();}
+	} else {
+		bbx.logging = false;
+	}
+	return (STAT_OK);
+}
+
+/*
+ * bbx_log_segment() - capture one record; called from the segment exec
+ *
+ *	Runs at MED interrupt level right after the runtime snapshot publish
+ *	(see _exec_aline_segment() in plan_line.c). A full page image swaps to
+ *	the spare and hands the full one to bbx_flash_callback(); if the spare
+ *	is still unwritten the record is dropped and the gap is flagged.
+ */
+void bbx_log_segment()
+{
+	if (bbx.logging == false) { return;}
+	if (bbx.fill >= BBX_PAGE_RECORDS) {
+		if (bbx.flush_pending == true) {	// mainline hasn't caught up - drop
+			bbx.gap = true;
+			return;
+		}
+		bbx.active ^= 1;
+		bbx.fill = 0;
+		bbx.flush_pending = true;
+	}
+	bbxRecord_t *r = &bbx.page[bbx.active][bbx.fill++];
+	r->ticks = rtc.clock_ticks;
+	r->linenum = mp_get_runtime_linenum();
+	for (uint8_t i=0; i<4; i++) {
+		r->position[i] = mp_get_runtime_machine_position(i);
+	}
+	r->velocity = mp_get_runtime_velocity();
+	r->switches = 0;
+	for (uint8_t i=0; i<NUM_SWITCHES; i++) {
+		if (sw.state[i] != SW_IDLE) { r->switches |= (1<<i);}
+	}
+	r->flags = (bbx.gap == true) ? BBX_FLAG_GAP : 0;
+	bbx.gap = false;
+	if ((r->sequence = bbx.sequence++) == 0xFFFE) { bbx.sequence = 0;}	// skip 0xFFFF
+}
+
+/*
+ * bbx_flash_callback() - program a full page image into the log region
+ *
+ *	On entering a new 4K sector the sector is probed (an erased sector
+ *	reads 0xFF) and erased if the machine is between cycles; a mid-cycle
+ *	wrap into an un-erased sector drops the page instead - see notes above.
+ */
+stat_t bbx_flash_callback(void)
+{
+	if (bbx.flush_pending == false) { return (STAT_NOOP);}
+
+	uint32_t addr = _bbx_page_addr(bbx.wr_page);
+	if ((bbx.wr_page & (BBX_SECTOR_PAGES-1)) == 0) {	// first page of a sector
+		uint32_t probe;
+		xio_read_spi_flash(BBX_SPI_DEV, addr, (char *)&probe, sizeof(probe));
+		if (probe != 0xFFFFFFFF) {
+			if (cm.cycle_state != CYCLE_OFF) {			// can't erase mid-cycle
+				bbx.flush_pending = false;				// drop the page
+				bbx.gap = true;
+				return (STAT_NOOP);
+			}
+			xio_erase_spi_flash_sector(BBX_SPI_DEV, addr);
+		}
+	}
+	xio_write_spi_flash(BBX_SPI_DEV, addr, (char *)bbx.page[bbx.active ^ 1], sizeof(bbx.page[0]));
+	if (++bbx.wr_page >= BBX_FLASH_PAGES) { bbx.wr_page = 0;}
+	bbx.flush_pending = false;
+	return (STAT_OK);
+}
+
+/*
+ * bbx_dump() - $bbxd=n - dump the last n seconds of records as JSON
+ *
+ *	Walks the region oldest-first from the write pointer, then the RAM
+ *	page images, printing one JSON line per record. The tick cutoff is
+ *	against the current RTC so n seconds reach back into the current
+ *	power-on only; n=0 dumps everything in the region, prior sessions
+ *	included. Blocks for the duration - this is a post-mortem operation,
+ *	so it refuses to run while a cycle is active.
+ */
+static void _bbx_print_record(const bbxRecord_t *r, uint32_t cutoff)
+{
+	if (r->sequence == 0xFFFF) { return;}				// erased slot
+	if ((cutoff != 0) && (r->ticks < cutoff)) { return;}
+	fprintf_P(stderr, PSTR("{\"bbxr\":{\"seq\":%u,\"t\":%lu,\"line\":%lu,"
+		"\"posx\":%1.3f,\"posy\":%1.3f,\"posz\":%1.3f,\"posa\":%1.3f,"
+		"\"vel\":%1.1f,\"sw\":%u,\"gap\":%u}}\n"),
+		r->sequence, r->ticks, r->linenum,
+		(double)r->position[0], (double)r->position[1],
+		(double)r->position[2], (double)r->position[3],
+		(double)r->velocity, r->switches,
+		(r->flags & BBX_FLAG_GAP) ? 1 : 0);
+}
+
+stat_t bbx_dump(cmdObj_t *cmd)
+{
+	bbxRecord_t rec;
+	uint32_t cutoff = 0;
+
+	if (cm.machine_state == MACHINE_CYCLE) { return (STAT_CONFIG_NOT_TAKEN);}
+	if (cmd->value > 0) {
+		uint32_t back = (uint32_t)cmd->value * BBX_TICKS_PER_SEC;
+		if (back < rtc.clock_ticks) { cutoff = rtc.clock_ticks - back;}
+		else { cutoff = 1;}			// whole power-on, but not prior sessions
+	}
+	uint16_t p = bbx.wr_page;								// oldest page in the ring
+	for (uint16_t n=0; n<BBX_FLASH_PAGES; n++) {
+		for (uint8_t i=0; i<BBX_PAGE_RECORDS; i++) {
+			xio_read_spi_flash(BBX_SPI_DEV,
+				_bbx_page_addr(p) + ((uint16_t)i * sizeof(bbxRecord_t)),
+				(char *)&rec, sizeof(bbxRecord_t));
+			_bbx_print_record(&rec, cutoff);
+		}
+		if (++p >= BBX_FLASH_PAGES) { p = 0;}
+	}
+	if (bbx.flush_pending == true) {						// unwritten full page
+		for (uint8_t i=0; i<BBX_PAGE_RECORDS; i++) {
+			_bbx_print_record(&bbx.page[bbx.active ^ 1][i], cutoff);
+		}
+	}
+	for (uint8_t i=0; i<bbx.fill; i++) {					// partially filled page
+		_bbx_print_record(&bbx.page[bbx.active][i], cutoff);
+	}
+	return (STAT_OK);
+}
@@ -0,0 +1,56 @@
+/*
+ * blackbox.h - trajectory flight recorder
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef blackbox_h
+#define blackbox_h
+
+/* Flight recorder flash layout (see notes in blackbox.c)
+ *
+ *	The log is a circular region carved from the top of the job storage
+ *	flash (job.h) - the job allocator grows up from page 0 and is bounded
+ *	at BBX_FIRST_PAGE. Records are 32 bytes so 8 fill one 256 byte flash
+ *	page; the region below holds about 30 seconds of motion at the default
+ *	segment time. Erased records read as sequence 0xFFFF, which is why the
+ *	sequence counter skips that value.
+ */
+#define BBX_FLASH_PAGES 1024		// 256 byte pages in the log region (64 x 4K sectors)
+#define BBX_FIRST_PAGE (JOB_FLASH_PAGES - BBX_FLASH_PAGES)
+#define BBX_REGION_ADDR ((uint32_t)BBX_FIRST_PAGE << 8)
+#define BBX_SECTOR_PAGES 16			// pages per 4K erase sector
+#define BBX_PAGE_RECORDS 8			// records per flash page
+
+#define BBX_FLAG_GAP 0x01			// records were dropped before this one
+
+typedef struct bbxRecord {			// exactly 32 bytes - do not pad
+	uint32_t ticks;					// rtc.clock_ticks at capture (10 ms resolution)
+	uint32_t linenum;				// executing gcode line number
+	float position[4];				// XYZA machine position (always mm, deg)
+	float velocity;					// segment velocity in mm/min
+	uint8_t switches;				// thrown-switch bitmap (bit = swNums index, gpio.h)
+	uint8_t flags;					// BBX_FLAG_ bits
+	uint16_t sequence;				// monotonic record number - 0xFFFF means erased
+} bbxRecord_t;
+
+void bbx_init(void);
+void bbx_log_segment(void);
+stat_t bbx_flash_callback(void);
+stat_t bbx_set_enable(cmdObj_t *cmd);
+stat_t bbx_dump(cmdObj_t *cmd);
+
+#endif
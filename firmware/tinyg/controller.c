@@ -1,398 +1,730 @@
-/*
- * controller.c - tinyg controller and top level parser
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* See the wiki for module details and additional information:
- *	 http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
- */
-
-#include <ctype.h>				// for parsing
-#include <string.h>
-#include <avr/pgmspace.h>		// precursor for xio.h
-#include <avr/interrupt.h>
-#include <avr/wdt.h>			// used for software reset
-
-#include "tinyg.h"				// #1 unfortunately, there are some dependencies
-#include "config.h"				// #2
-#include "controller.h"
-#include "settings.h"
-#include "json_parser.h"
-#include "gcode_parser.h"
-#include "canonical_machine.h"
-#include "plan_arc.h"
-#include "planner.h"
-#include "stepper.h"
-#include "system.h"
-#include "gpio.h"
-#include "report.h"
-#include "util.h"
-#include "help.h"
-#include "xio/xio.h"
-#include "xmega/xmega_rtc.h"
-#include "xmega/xmega_init.h"
-
-// local helpers
-static void _controller_HSM(void);
-static stat_t _dispatch(void);
-static stat_t _reset_handler(void);
-static stat_t _bootloader_handler(void);
-static stat_t _limit_switch_handler(void);
-static stat_t _alarm_idler(void);
-static stat_t _system_assertions(void);
-static stat_t _sync_to_tx_buffer(void);
-static stat_t _sync_to_planner(void);
-
-/*
- * tg_init() - controller init
- */
-
-void tg_init(uint8_t std_in, uint8_t std_out, uint8_t std_err) 
-{
-	tg.magic_start = MAGICNUM;
-	tg.magic_end = MAGICNUM;
-	tg.fw_build = TINYG_FIRMWARE_BUILD;
-	tg.fw_version = TINYG_FIRMWARE_VERSION;	// NB: HW version is set from EEPROM
-
-	tg.reset_requested = false;
-	tg.bootloader_requested = false;
-
-	xio_set_stdin(std_in);
-	xio_set_stdout(std_out);
-	xio_set_stderr(std_err);
-	tg.default_src = std_in;
-	tg_set_primary_source(tg.default_src);	// set primary source
-}
-
-/* 
- * tg_controller() - MAIN LOOP - top-level controller
- *
- * The order of the dispatched tasks is very important. 
- * Tasks are ordered by increasing dependency (blocking hierarchy).
- * Tasks that are dependent on completion of lower-level tasks must be
- * later in the list than the task(s) they are dependent upon. 
- *
- * Tasks must be written as continuations as they will be called repeatedly, 
- * and are called even if they are not currently active. 
- *
- * The DISPATCH macro calls the function and returns to the controller parent 
- * if not finished (STAT_EAGAIN), preventing later routines from running 
- * (they remain blocked). Any other condition - OK or ERR - drops through 
- * and runs the next routine in the list.
- *
- * A routine that had no action (i.e. is OFF or idle) should return STAT_NOOP
- *
- * Useful reference on state machines:
- * http://johnsantic.com/comp/state.html, "Writing Efficient State Machines in C"
- */
-
-void tg_controller() 
-{ 
-	while (true) { 
-		_controller_HSM();
-	}
-}
-
-#define	DISPATCH(func) if (func == STAT_EAGAIN) return; 
-static void _controller_HSM()
-{
-//----- ISRs. These should be considered the highest priority scheduler functions ----//
-/*	
- *	HI	Stepper DDA pulse generation		// see stepper.h
- *	HI	Stepper load routine SW interrupt	// see stepper.h
- *	HI	Dwell timer counter 				// see stepper.h
- *	MED	GPIO1 switch port - limits / homing	// see gpio.h
- *  MED	Serial RX for USB					// see xio_usart.h
- *  LO	Segment execution SW interrupt		// see stepper.h
- *  LO	Serial TX for USB & RS-485			// see xio_usart.h
- *	LO	Real time clock interrupt			// see xmega_rtc.h
- */
-//----- kernel level ISR handlers ----(flags are set in ISRs)-----------//
-											// Order is important:
-	DISPATCH(_reset_handler());				// 1. received software reset request
-	DISPATCH(_bootloader_handler());		// 2. received bootloader request
-	DISPATCH(_limit_switch_handler());		// 3. limit switch has been thrown
-	DISPATCH(_alarm_idler());				// 4. idle in alarm state
-	DISPATCH(_system_assertions());			// 5. system integrity assertions
-	DISPATCH(cm_feedhold_sequencing_callback());
-	DISPATCH(mp_plan_hold_callback());		// plan a feedhold from line runtime
-
-//----- planner hierarchy for gcode and cycles -------------------------//
-	DISPATCH(rpt_status_report_callback());	// conditionally send status report
-	DISPATCH(rpt_queue_report_callback());	// conditionally send queue report
-	DISPATCH(ar_arc_callback());			// arc generation runs behind lines
-	DISPATCH(cm_homing_callback());			// G28.2 continuation
-
-//----- command readers and parsers ------------------------------------//
-	DISPATCH(_sync_to_planner());			// ensure there is at least one free buffer in planning queue
-	DISPATCH(_sync_to_tx_buffer());			// sync with TX buffer (pseudo-blocking)
-	DISPATCH(cfg_baud_rate_callback());		// perform baud rate update (must be after TX sync)
-	DISPATCH(_dispatch());					// read and execute next command
-}
-
-/***************************************************************************** 
- * _dispatch() - dispatch line received from active input device
- *
- *	Reads next command line and dispatches to relevant parser or action
- *	Accepts commands if the move queue has room - EAGAINS if it doesn't
- *	Manages cutback to serial input from file devices (EOF)
- *	Also responsible for prompts and for flow control 
- */
-
-static stat_t _dispatch()
-{
-	uint8_t status;
-
-	// read input line or return if not a completed line
-	// xio_gets() is a non-blocking workalike of fgets()
-	while (true) {
-		if ((status = xio_gets(tg.primary_src, tg.in_buf, sizeof(tg.in_buf))) == STAT_OK) {
-			tg.bufp = tg.in_buf;
-			break;
-		}
-		// handle end-of-file from file devices
-		if (status == STAT_EOF) {					// EOF can come from file devices only
-			if (cfg.comm_mode == TEXT_MODE) {
-				fprintf_P(stderr, PSTR("End of command file\n"));
-			} else {
-				rpt_exception(STAT_EOF, 0);		// not really an exception
-			}
-			tg_reset_source();					// reset to default source
-		}
-		return (status);						// Note: STAT_EAGAIN, errors, etc. will drop through
-	}
-	tg.linelen = strlen(tg.in_buf)+1;					// linelen only tracks primary input
-	strncpy(tg.saved_buf, tg.bufp, SAVED_BUFFER_LEN-1);	// save input buffer for reporting
-
-	// dispatch the new text line
-	switch (toupper(*tg.bufp)) {				// first char
-
-//		case '!': { cm_request_feedhold(); break; }		// include for diagnostics
-//		case '@': { cm_request_queue_flush(); break; }
-//		case '~': { cm_request_cycle_start(); break; }
-
-		case NUL: { 							// blank line (just a CR)
-			if (cfg.comm_mode != JSON_MODE) {
-				tg_text_response(STAT_OK, tg.saved_buf);
-			}
-			break;
-		}
-		case 'H': { 							// intercept help screens
-			cfg.comm_mode = TEXT_MODE;
-			print_general_help();
-			tg_text_response(STAT_OK, tg.bufp);
-			break;
-		}
-		case '$': case '?':{ 					// text-mode configs
-			cfg.comm_mode = TEXT_MODE;
-			tg_text_response(cfg_text_parser(tg.bufp), tg.saved_buf);
-			break;
-		}
-		case '{': { 							// JSON input
-			cfg.comm_mode = JSON_MODE;
-			js_json_parser(tg.bufp);
-			break;
-		}
-		default: {								// anything else must be Gcode
-			if (cfg.comm_mode == JSON_MODE) {
-				strncpy(tg.out_buf, tg.bufp, INPUT_BUFFER_LEN -8);	// use out_buf as temp
-				sprintf(tg.bufp,"{\"gc\":\"%s\"}\n", tg.out_buf);
-				js_json_parser(tg.bufp);
-			} else {
-				tg_text_response(gc_gcode_parser(tg.bufp), tg.saved_buf);
-			}
-		}
-	}
-	return (STAT_OK);
-}
-
-/************************************************************************************
- * tg_text_response() - text mode responses
- */
-static const char prompt_mm[] PROGMEM = "mm";
-static const char prompt_in[] PROGMEM = "inch";
-static const char prompt_ok[] PROGMEM = "tinyg [%S] ok> ";
-static const char prompt_err[] PROGMEM = "tinyg [%S] err: %s: %s ";
-
-void tg_text_response(const uint8_t status, const char *buf)
-{
-	if (cfg.text_verbosity == TV_SILENT) return;	// skip all this
-
-	const char *units;								// becomes pointer to progmem string
-	if (cm_get_model_units_mode() != INCHES) { 
-		units = (PGM_P)&prompt_mm;
-	} else {
-		units = (PGM_P)&prompt_in;
-	}
-//	if ((status == STAT_OK) || (status == STAT_EAGAIN) || (status == STAT_NOOP) || (status == STAT_ZERO_LENGTH_MOVE)) {
-	if ((status == STAT_OK) || (status == STAT_EAGAIN) || (status == STAT_NOOP)) {
-		fprintf_P(stderr, (PGM_P)&prompt_ok, units);
-	} else {
-		char status_message[STATUS_MESSAGE_LEN];
-		fprintf_P(stderr, (PGM_P)prompt_err, units, rpt_get_status_message(status, status_message), buf);
-	}
-	cmdObj_t *cmd = cmd_body+1;
-	if (cmd->token[0] == 'm') {
-		fprintf(stderr, *cmd->stringp);
-	}
-	fprintf(stderr, "\n");
-}
-
-/**** Utilities ****
- * _sync_to_tx_buffer() - return eagain if TX queue is backed up
- * _sync_to_planner() - return eagain if planner is not ready for a new command
- * tg_reset_source() - reset source to default input device (see note)
- * tg_set_active_source() - set current input source
- *
- * Note: Once multiple serial devices are supported reset_source() should
- *	be expanded to also set the stdout/stderr console device so the prompt
- *	and other messages are sent to the active device.
- */
-
-static stat_t _sync_to_tx_buffer()
-{
-	if ((xio_get_tx_bufcount_usart(ds[XIO_DEV_USB].x) >= XOFF_TX_LO_WATER_MARK)) {
-		return (STAT_EAGAIN);
-	}
-	return (STAT_OK);
-}
-
-static stat_t _sync_to_planner()
-{
-	if (mp_get_planner_buffers_available() < PLANNER_BUFFER_HEADROOM) { // allow up to N planner buffers for this line
-		return (STAT_EAGAIN);
-	}
-	return (STAT_OK);
-}
-
-void tg_reset_source() { tg_set_primary_source(tg.default_src);}
-void tg_set_primary_source(uint8_t dev) { tg.primary_src = dev;}
-void tg_set_secondary_source(uint8_t dev) { tg.secondary_src = dev;}
-
-/*
- * tg_request_reset()
- * _reset_handler()
- * tg_reset() - software hard reset using watchdog timer
- */
-void tg_request_reset() { tg.reset_requested = true; }
-
-static stat_t _reset_handler(void)
-{
-	if (tg.reset_requested == false) { return (STAT_NOOP);}
-	tg_reset();							// hard reset - identical to hitting RESET button
-	return (STAT_EAGAIN);
-}
-
-void tg_reset(void)			// software hard reset using the watchdog timer
-{
-	wdt_enable(WDTO_15MS);
-	while (true);			// loops for about 15ms then resets
-}
-
-
-/*
- * tg_request_bootloader()
- * _bootloader_handler() - executes a software reset using CCPWrite
- */
-void tg_request_bootloader() { tg.bootloader_requested = true;}
-
-static stat_t _bootloader_handler(void)
-{
-	if (tg.bootloader_requested == false) { return (STAT_NOOP);}
-	cli();
-	CCPWrite(&RST.CTRL, RST_SWRST_bm);  // fire a software reset
-	return (STAT_EAGAIN);					// never gets here but keeps the compiler happy
-}
-
-/*
- * _limit_switch_handler() - shut down system if limit switch fired
- */
-static stat_t _limit_switch_handler(void)
-{
-	if (cm_get_machine_state() == MACHINE_ALARM) { return (STAT_NOOP);}
-	if (gpio_get_limit_thrown() == false) return (STAT_NOOP);
-//	cm_alarm(gpio_get_sw_thrown); // unexplained complier warning: passing argument 1 of 'cm_shutdown' makes integer from pointer without a cast
-	cm_alarm(sw.sw_num_thrown);
-	return (STAT_OK);
-}
-
-/* 
- * _alarm_idler() - revent any further activity form occurring if shut down
- *
- *	This function returns EAGAIN causing the control loop to never advance beyond
- *	this point. It's important that the reset handler is still called so a SW reset
- *	(ctrl-x) can be processed.
- */
-#define LED_COUNTER 25000
-
-static stat_t _alarm_idler(void)
-{
-	if (cm_get_machine_state() != MACHINE_ALARM) { return (STAT_OK);}
-
-	if (--tg.led_counter < 0) {
-		tg.led_counter = LED_COUNTER;
-		if (tg.led_state == 0) {
-			gpio_led_on(INDICATOR_LED);
-			tg.led_state = 1;
-		} else {
-			gpio_led_off(INDICATOR_LED);
-			tg.led_state = 0;
-		}
-	}
-	return (STAT_EAGAIN);	 // EAGAIN prevents any other actions from running
-}
-
-/* 
- * _system_assertions() - check memory integrity and other assertions
- */
-uint8_t _system_assertions()
-{
-	uint8_t value = 0;
-
-	if (tg.magic_start		!= MAGICNUM) { value = 1; }		// Note: reported VALue is offset by ALARM_MEMORY_OFFSET
-	if (tg.magic_end		!= MAGICNUM) { value = 2; }
-	if (cm.magic_start 		!= MAGICNUM) { value = 3; }
-	if (cm.magic_end		!= MAGICNUM) { value = 4; }
-	if (gm.magic_start		!= MAGICNUM) { value = 5; }
-	if (gm.magic_end 		!= MAGICNUM) { value = 6; }
-	if (cfg.magic_start		!= MAGICNUM) { value = 7; }
-	if (cfg.magic_end		!= MAGICNUM) { value = 8; }
-	if (cmdStr.magic_start	!= MAGICNUM) { value = 9; }
-	if (cmdStr.magic_end	!= MAGICNUM) { value = 10; }
-	if (mb.magic_start		!= MAGICNUM) { value = 11; }
-	if (mb.magic_end		!= MAGICNUM) { value = 12; }
-	if (mr.magic_start		!= MAGICNUM) { value = 13; }
-	if (mr.magic_end		!= MAGICNUM) { value = 14; }
-	if (ar.magic_start		!= MAGICNUM) { value = 15; }
-	if (ar.magic_end		!= MAGICNUM) { value = 16; }
-	if (st_get_st_magic()	!= MAGICNUM) { value = 17; }
-	if (st_get_sps_magic()	!= MAGICNUM) { value = 18; }
-	if (rtc.magic_end 		!= MAGICNUM) { value = 19; }
-	xio_assertions(&value);									// run xio assertions
-
-	if (value == 0) { return (STAT_OK);}
-	rpt_exception(STAT_MEMORY_FAULT, value);
-	cm_alarm(ALARM_MEMORY_OFFSET + value);	
-	return (STAT_EAGAIN);
-}
+/*
+ * controller.c - tinyg controller and top level parser
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* See the wiki for module details and additional information:
+ *	 http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
+ */
+
+#include <ctype.h>				// for parsing
+#include <string.h>
+#include <avr/pgmspace.h>		// precursor for xio.h
+#include <avr/interrupt.h>
+#include <avr/sleep.h>			// used for the idle sleep
+#include <avr/wdt.h>			// used for software reset
+
+#include "tinyg.h"				// #1 unfortunately, there are some dependencies
+#include "config.h"				// #2
+#include "controller.h"
+#include "settings.h"
+#include "json_parser.h"
+#include "gcode_parser.h"
+#include "binary_parser.h"
+#include "canonical_machine.h"
+#include "plan_arc.h"
+#include "planner.h"
+#include "stepper.h"
+#include "network.h"
+#include "system.h"
+#include "gpio.h"
+#include "report.h"
+#include "util.h"
+#include "help.h"
+#include "spindle.h"			// sp_load_callback
+#include "pendant.h"			// pen_callback
+#include "job.h"
+#include "blackbox.h"
+#include "test.h"
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"
+#include "xmega/xmega_crc.h"
+#include "xmega/xmega_init.h"
+
+// local helpers
+static void _controller_HSM(void);
+static stat_t _dispatch(void);
+static stat_t _dispatch_secondary(void);
+static stat_t _dispatch_line(void);
+static stat_t _reset_handler(void);
+static stat_t _bootloader_handler(void);
+static stat_t _limit_switch_handler(void);
+static stat_t _alarm_idler(void);
+static stat_t _system_assertions(void);
+static stat_t _sync_to_tx_buffer(void);
+static stat_t _sync_to_planner(void);
+static uint8_t _verify_checksum(char *buf);
+static uint8_t _controller_active(void);
+static uint8_t _rx_pending(void);
+
+/* Main-loop latency watchdog (__LOOP_PROFILE builds only)
+ *
+ *	Planner starvation traces back to long controller passes, so the watchdog
+ *	samples a free-running timer at the top of each pass and at every DISPATCH
+ *	point, and keeps a high water mark of the worst pass along with the
+ *	duration and line number of the dispatch stage that dominated that pass
+ *	(stage line 0 is the pass prologue). Read the record via the "lp" group.
+ *
+ *	The timebase is TIMER_5 at div64 - 2 uSec per tick, wrapping at ~131 ms.
+ *	A pass longer than the wrap aliases, so treat a saturated reading as
+ *	"at least". Sleep passes are closed out before sleep_mode() so idle time
+ *	is not counted. All sampling is mainline so no atomicity is needed.
+ */
+#ifdef __LOOP_PROFILE
+#if defined(__ISR_PROFILE) || defined(__STEP_PULSE_TIMER)
+#error __LOOP_PROFILE also uses TIMER_5 - enable only one TIMER_5 feature
+#endif
+// TIMER_LOOP and LOOP_USEC_PER_TICK are in controller.h (shared with plan_line.c)
+
+static uint16_t lpf_pass_start;			// TIMER_LOOP count at pass start
+static uint16_t lpf_stage_start;		// TIMER_LOOP count at the last dispatch point
+static uint16_t lpf_stage_line;			// line number of the stage being timed
+static uint16_t lpf_max_ticks;			// dominant stage so far this pass
+static uint16_t lpf_max_line;			// line number of the dominant stage
+static uint8_t lpf_pass_open;			// guards against closing a pass twice
+
+static void _loop_profile_stage(const uint16_t line)
+{
+	uint16_t now = TIMER_LOOP.CNT;
+	uint16_t elapsed = now - lpf_stage_start;	// correct across a timer wrap
+	if (elapsed > lpf_max_ticks) {
+		lpf_max_ticks = elapsed;
+		lpf_max_line = lpf_stage_line;
+	}
+	lpf_stage_line = line;
+	lpf_stage_start = now;
+}
+
+static void _loop_profile_pass_start(void)
+{
+	lpf_pass_start = TIMER_LOOP.CNT;
+	lpf_stage_start = lpf_pass_start;
+	lpf_stage_line = 0;						// stage 0 is the pass prologue
+	lpf_max_ticks = 0;
+	lpf_max_line = 0;
+	lpf_pass_open = true;
+}
+
+static void _loop_profile_pass_end(void)
+{
+	if (lpf_pass_open == false) { return;}	// already closed before sleeping
+	lpf_pass_open = false;
+	_loop_profile_stage(0);					// close out the final stage
+	float pass_usec = (float)(uint16_t)(TIMER_LOOP.CNT - lpf_pass_start) * LOOP_USEC_PER_TICK;
+	if (pass_usec > loop_rpt.pass_max) {
+		loop_rpt.pass_max = pass_usec;
+		loop_rpt.stage_max = (float)lpf_max_ticks * LOOP_USEC_PER_TICK;
+		loop_rpt.stage_line = lpf_max_line;
+	}
+}
+#define LOOP_PROFILE_PASS_START() _loop_profile_pass_start()
+#define LOOP_PROFILE_PASS_END() _loop_profile_pass_end()
+#define LOOP_PROFILE_STAGE() _loop_profile_stage(__LINE__)
+#else
+#define LOOP_PROFILE_PASS_START()
+#define LOOP_PROFILE_PASS_END()
+#define LOOP_PROFILE_STAGE()
+#endif	// __LOOP_PROFILE
+
+/*
+ * tg_init() - controller init
+ */
+
+void tg_init(uint8_t std_in, uint8_t std_out, uint8_t std_err) 
+{
+	tg.magic_start = MAGICNUM;
+	tg.magic_end = MAGICNUM;
+	tg.fw_build = TINYG_FIRMWARE_BUILD;
+	tg.fw_version = TINYG_FIRMWARE_VERSION;	// NB: HW version is set from EEPROM
+
+	tg.reset_requested = false;
+	tg.bootloader_requested = false;
+	tg.events = 0;
+	tg.cpu_busy = true;
+
+#ifdef __LOOP_PROFILE
+	TIMER_LOOP.CTRLA = TC_CLKSEL_DIV64_gc;	// start the free-running pass timebase
+	TIMER_LOOP.CTRLB = 0;					// normal mode, no compares or interrupts
+	TIMER_LOOP.PER = 0xFFFF;				// count the full 16 bit range
+#endif
+
+	xio_set_stdin(std_in);
+	xio_set_stdout(std_out);
+	xio_set_stderr(std_err);
+	tg.default_src = std_in;
+	tg_set_primary_source(tg.default_src);	// set primary source
+	tg_set_secondary_source(XIO_DEV_RS485);	// pendant port - serviced by _dispatch_secondary()
+}
+
+/* 
+ * tg_controller() - MAIN LOOP - top-level controller
+ *
+ * The order of the dispatched tasks is very important. 
+ * Tasks are ordered by increasing dependency (blocking hierarchy).
+ * Tasks that are dependent on completion of lower-level tasks must be
+ * later in the list than the task(s) they are dependent upon. 
+ *
+ * Tasks must be written as continuations as they will be called repeatedly, 
+ * and are called even if they are not currently active. 
+ *
+ * The DISPATCH macro calls the function and returns to the controller parent 
+ * if not finished (STAT_EAGAIN), preventing later routines from running 
+ * (they remain blocked). Any other condition - OK or ERR - drops through 
+ * and runs the next routine in the list.
+ *
+ * A routine that had no action (i.e. is OFF or idle) should return STAT_NOOP
+ *
+ * Event gating: the full sweep used to run unconditionally, which added the
+ * cost of every idle stage to the latency of reading the next command line,
+ * and spun the loop flat-out when there was nothing to do. The ISRs now flag
+ * work in tg.events (see tgEventFlags in controller.h) and the sweep runs in
+ * full only when an event was flagged or when mainline continuations may be
+ * in flight (see _controller_active()). With only serial input pending the
+ * controller skips straight to the readers; with nothing pending it sleeps
+ * until the next interrupt. The RTC tick flags an event every ~10 ms, so the
+ * full sweep - assertions, reports, persistence - is never starved.
+ *
+ * Useful reference on state machines:
+ * http://johnsantic.com/comp/state.html, "Writing Efficient State Machines in C"
+ */
+
+void tg_controller()
+{
+	while (true) {
+		LOOP_PROFILE_PASS_START();
+		_controller_HSM();
+		LOOP_PROFILE_PASS_END();		// catches the early returns from DISPATCH
+	}
+}
+
+#define	DISPATCH(func) { LOOP_PROFILE_STAGE(); if (func == STAT_EAGAIN) return;}
+static void _controller_HSM()
+{
+//----- ISRs. These should be considered the highest priority scheduler functions ----//
+/*
+ *	HI	Stepper DDA pulse generation		// see stepper.h
+ *	HI	Stepper load routine SW interrupt	// see stepper.h
+ *	HI	Dwell timer counter 				// see stepper.h
+ *	MED	GPIO1 switch port - limits / homing	// see gpio.h
+ *  MED	Serial RX for USB					// see xio_usart.h
+ *  LO	Segment execution SW interrupt		// see stepper.h
+ *  LO	Serial TX for USB & RS-485			// see xio_usart.h
+ *	LO	Real time clock interrupt			// see xmega_rtc.h
+ */
+	cli();									// collect and clear the ISR-flagged events;
+	uint8_t events = tg.events;				// 8 bit reads are atomic but read-and-clear is not
+	tg.events = 0;
+	sei();
+
+	// If the previous pass ended blocked on planner buffer headroom there is
+	// nothing useful to do until something happens - sleep instead of spinning
+	// through the sweep. Any interrupt wakes an idle sleep, so a buffer freed
+	// (or a tick, signal or RX char) landing after the collection above is
+	// picked up on the next pass, not lost.
+	if ((events == 0) && (tg.waiting_for_buffer == true)) {
+		LOOP_PROFILE_PASS_END();			// don't count sleep time as pass time
+		tg.cpu_busy = false;
+		sleep_mode();
+		tg.cpu_busy = true;
+		return;
+	}
+
+	if ((events != 0) || (_controller_active() == true)) {
+
+//----- kernel level ISR handlers ----(flags are set in ISRs)-----------//
+												// Order is important:
+		DISPATCH(_reset_handler());				// 1. received software reset request
+		DISPATCH(_bootloader_handler());		// 2. received bootloader request
+		DISPATCH(_limit_switch_handler());		// 3. limit switch has been thrown
+		DISPATCH(_alarm_idler());				// 4. idle in alarm state
+		DISPATCH(_system_assertions());			// 5. system integrity assertions
+		DISPATCH(net_slave_callback());			// apply RS485 segment stream (slaves only)
+		DISPATCH(net_master_sync_callback());	// fire pending sync start pulse (master only)
+		DISPATCH(cm_feedhold_sequencing_callback());
+		DISPATCH(mp_plan_hold_callback());		// plan a feedhold from line runtime
+		DISPATCH(gpio_encoder_callback());		// encoder vs stepper position compare (see gpio.c)
+		DISPATCH(_dispatch_secondary());		// secondary source (pendant) - ahead of the planner sync
+
+//----- planner hierarchy for gcode and cycles -------------------------//
+		DISPATCH(rpt_system_ready_callback());	// deferred startup banner - before any responses
+		DISPATCH(rpt_watch_callback());			// drain $watch samples ahead of the reports
+		DISPATCH(rpt_status_report_callback());	// conditionally send status report
+		DISPATCH(rpt_queue_report_callback());	// conditionally send queue report
+		DISPATCH(cfg_dump_callback());			// print next group of a chunked config dump
+		DISPATCH(tst_benchmark_callback());		// report a completed planner benchmark
+		DISPATCH(tst_dry_run_callback());		// report a completed dry run time estimate
+		DISPATCH(mp_job_stats_callback());		// report end-of-job statistics (see planner.c)
+		DISPATCH(ar_arc_callback());			// arc generation runs behind lines
+		DISPATCH(cm_homing_callback());			// G28.2 continuation
+		DISPATCH(cm_probe_callback());			// G38.2 continuation
+		DISPATCH(cm_jog_callback());			// continuous jog continuation (see cycle_jogging.c)
+		DISPATCH(sp_load_callback());			// spindle load sensing trims the feed override (see spindle.c)
+		DISPATCH(pen_callback());				// analog pendant feed override knob (see pendant.c)
+		DISPATCH(xio_flash_prefetch_callback());// refill spent flash job prefetch pages
+
+	} else if (_rx_pending() == false) {
+		LOOP_PROFILE_PASS_END();			// don't count sleep time as pass time
+		tg.cpu_busy = false;
+		sleep_mode();						// nothing to do - any interrupt wakes us
+		tg.cpu_busy = true;
+		return;
+	}
+
+//----- command readers and parsers ------------------------------------//
+// (when the sweep above is skipped only serial input can be pending)
+	DISPATCH(_sync_to_planner());			// ensure there is at least one free buffer in planning queue
+	DISPATCH(cm_drill_callback());			// G81-G83 expansion (after planner sync, before dispatch)
+	DISPATCH(_sync_to_tx_buffer());			// sync with TX buffer (pseudo-blocking)
+	DISPATCH(cfg_baud_rate_callback());		// perform baud rate update (must be after TX sync)
+	DISPATCH(cfg_nvm_persistence_callback());// flush queued NVM writes while no cycle is active
+	DISPATCH(job_checkpoint_callback());	// record job recovery checkpoints (see job.c)
+	DISPATCH(job_resume_callback());		// sequence a rehome-and-resume (see job.c)
+	DISPATCH(bbx_flash_callback());			// program full flight recorder pages (see blackbox.c)
+	DISPATCH(cm_persist_position_callback());// save machine position at idle (see $pmp)
+	DISPATCH(_dispatch());					// read and execute next command
+}
+
+/*
+ * _controller_active() - true if mainline continuations may have pending work
+ *
+ *	Continuations (arcs, homing, feedholds, the planner) advance from the
+ *	mainline, not from ISRs, so nothing flags an event for them - while any
+ *	could be in flight the full sweep must run every pass, exactly as it
+ *	always did. That is the case whenever the machine is in a cycle (or
+ *	alarmed, or still initializing), and whenever input comes from a file
+ *	device, which delivers lines without RX interrupts.
+ */
+static uint8_t _controller_active(void)
+{
+	uint8_t machine_state = cm_get_machine_state();
+	if ((machine_state == MACHINE_CYCLE) || (machine_state == MACHINE_ALARM) ||
+		(machine_state == MACHINE_INITIALIZING)) {
+		return (true);
+	}
+	if (tg.primary_src != tg.default_src) { return (true);}	// reading from a file device
+	return (false);
+}
+
+/*
+ * tg_cpu_load_rtc_callback() - statistical CPU load sampling (runs at RTC interrupt level)
+ *
+ *	The controller sleeps whenever it has nothing to do, so each RTC tick
+ *	lands either in sleep (idle) or anywhere else (busy - mainline or ISR).
+ *	Sampling cpu_busy on the tick and rolling CPU_LOAD_SAMPLES samples into
+ *	a window yields percent load directly. Read it as "load" ($load, or
+ *	select it into status reports to watch headroom while a job runs).
+ */
+static uint8_t load_samples;			// ticks accumulated in the current window
+static uint8_t load_busy;				// ticks that landed outside sleep
+
+void tg_cpu_load_rtc_callback(void)
+{
+	if (tg.cpu_busy == true) { load_busy++;}
+	if (++load_samples >= CPU_LOAD_SAMPLES) {
+		tg.cpu_load = load_busy;		// 100 samples per window makes each sample 1%
+		load_samples = 0;
+		load_busy = 0;
+	}
+}
+
+/*
+ * _rx_pending() - true if the primary input device has unread characters
+ *
+ *	The RX event is consumed when the sweep that collects it runs, but a burst
+ *	may leave further complete lines in the RX ring, so the ring itself is the
+ *	authority on whether the readers still have work.
+ */
+static uint8_t _rx_pending(void)
+{
+	if (tg.primary_src >= XIO_DEV_USART_COUNT) { return (true);}	// not a usart - always poll
+	return (xio_get_rx_bufcount_usart(ds[tg.primary_src].x) != 0);
+}
+
+/***************************************************************************** 
+ * _dispatch() - dispatch line received from active input device
+ *
+ *	Reads next command line and dispatches to relevant parser or action
+ *	Accepts commands if the move queue has room - EAGAINS if it doesn't
+ *	Manages cutback to serial input from file devices (EOF)
+ *	Also responsible for prompts and for flow control 
+ */
+
+static stat_t _dispatch()
+{
+	uint8_t status;
+
+	// read input line or return if not a completed line
+	// xio_gets_line() is a non-blocking line reader. USART devices hand the
+	// line back in place from the RX ring (zero-copy); file devices fall
+	// back to copying into tg.in_buf. Either way tg.bufp points at the line.
+	while (true) {
+		if ((status = xio_gets_line(tg.primary_src, &tg.bufp, tg.in_buf, sizeof(tg.in_buf))) == STAT_OK) {
+			break;
+		}
+		// handle end-of-file from file devices
+		if (status == STAT_EOF) {					// EOF can come from file devices only
+			// an M98 subprogram call absorbs its EOFs - next pass, or back to the caller (see job.c)
+			if (job_call_eof() == true) { return (STAT_OK);}
+			if (cfg.comm_mode == TEXT_MODE) {
+				fprintf_P(stderr, PSTR("End of command file\n"));
+			} else {
+				rpt_exception(STAT_EOF, 0);		// not really an exception
+			}
+			tg_reset_source();					// reset to default source
+			mp_release_startup_hold();			// no more blocks coming - start what's queued
+		}
+		return (status);						// Note: STAT_EAGAIN, errors, etc. will drop through
+	}
+	// verify and strip the trailing *nnnn checksum, if the host sent one
+	if (_verify_checksum(tg.bufp) == false) {
+		if (cfg.comm_mode == TEXT_MODE) {
+			tg_text_response(STAT_CHECKSUM_FAILURE, tg.bufp);
+		} else {
+			rpt_exception(STAT_CHECKSUM_FAILURE, 0);
+		}
+		return (STAT_OK);						// line is discarded - host resends it
+	}
+	// divert input lines into a job upload if one is in progress (see job.c)
+	if (job_capture_line(tg.bufp) == true) { return (STAT_OK);}
+
+	// divert input lines into a config snapshot import if one is in progress (see config.c)
+	if (cfg_import_line(tg.bufp) == true) { return (STAT_OK);}
+
+	// count lines consumed from a stored job; discards them during a resume fast-forward (see job.c)
+	if (job_count_line() == true) { return (STAT_OK);}
+
+	tg.linelen = strlen(tg.bufp)+1;						// linelen only tracks primary input
+	strncpy(tg.saved_buf, tg.bufp, SAVED_BUFFER_LEN-1);	// save input buffer for reporting
+	if (cfg.ack_mode != ACK_MODE_OFF) {					// parsers mutate the buffer - hash it now
+		tg.ack_checksum = compute_checksum(tg.bufp, 0);
+	}
+
+	// dispatch the new text line
+	return (_dispatch_line());
+}
+
+/*
+ * _dispatch_secondary() - service one line from the secondary input device
+ *
+ *	The secondary source (an RS485 pendant in practice - see tg_init) is
+ *	serviced from the gated sweep, ahead of the planner-headroom sync that
+ *	meters the primary stream, so pendant commands are read and executed
+ *	even while the primary is queue-blocked mid-job. Lines run through the
+ *	same parsers as primary input; a command that needs planner buffers
+ *	while the queue is full fails with its normal status instead of waiting.
+ *	Single-character signals (feedhold etc.) never come through here - the
+ *	RX ISRs trap those before buffering. Only usart devices qualify, so the
+ *	line is read zero-copy from the device's own RX ring (per-source
+ *	buffering comes free), and the RS485 port is left alone whenever the
+ *	network layer owns it.
+ */
+static stat_t _dispatch_secondary()
+{
+	if ((tg.secondary_src == tg.primary_src) ||
+		(tg.secondary_src >= XIO_DEV_USART_COUNT) ||
+		(tg.network_mode != NETWORK_STANDALONE)) {
+		return (STAT_NOOP);
+	}
+	if (xio_gets_line(tg.secondary_src, &tg.bufp, tg.in_buf, sizeof(tg.in_buf)) != STAT_OK) {
+		return (STAT_NOOP);							// no complete line pending
+	}
+	if (_verify_checksum(tg.bufp) == false) {
+		if (cfg.comm_mode == TEXT_MODE) {
+			tg_text_response(STAT_CHECKSUM_FAILURE, tg.bufp);
+		} else {
+			rpt_exception(STAT_CHECKSUM_FAILURE, 0);
+		}
+		return (STAT_OK);							// line is discarded - host resends it
+	}
+	strncpy(tg.saved_buf, tg.bufp, SAVED_BUFFER_LEN-1);	// save for reporting
+	return (_dispatch_line());		// no linelen / ack bookkeeping - those track primary input
+}
+
+/*
+ * _dispatch_line() - parse and execute the line at tg.bufp
+ */
+static stat_t _dispatch_line()
+{
+	uint8_t status;
+
+	switch (toupper(*tg.bufp)) {				// first char
+
+//		case '!': { cm_request_feedhold(); break; }		// include for diagnostics
+//		case '@': { cm_request_queue_flush(); break; }
+//		case '~': { cm_request_cycle_start(); break; }
+
+		case NUL: { 							// blank line (just a CR)
+			if (cfg.comm_mode != JSON_MODE) {
+				tg_text_response(STAT_OK, tg.saved_buf);
+			}
+			break;
+		}
+#ifdef __JSON_ONLY
+		case 'H': case '$': case '?': {			// headless builds have no text mode
+			rpt_exception(STAT_UNRECOGNIZED_COMMAND, 0);
+			break;
+		}
+#else
+		case 'H': { 							// intercept help screens
+			cfg.comm_mode = TEXT_MODE;
+			crc_scan_invalidate();
+			print_general_help();
+			tg_text_response(STAT_OK, tg.bufp);
+			break;
+		}
+		case '$': case '?':{ 					// text-mode configs
+			cfg.comm_mode = TEXT_MODE;
+			crc_scan_invalidate();
+			tg_text_response(cfg_text_parser(tg.bufp), tg.saved_buf);
+			break;
+		}
+#endif	// __JSON_ONLY
+		case '{': case '[': { 					// JSON input - single object or batch array
+			cfg.comm_mode = JSON_MODE;
+			crc_scan_invalidate();
+			js_json_parser(tg.bufp);
+			break;
+		}
+		case '*': { 							// binary block record (see binary_parser.c)
+			status = bn_binary_parser(tg.bufp);
+			if (status != STAT_OK) {			// records are silent unless they fail
+				tg_text_response(status, tg.saved_buf);
+			}
+			break;
+		}
+		default: {								// anything else must be Gcode
+			if (cfg.comm_mode == JSON_MODE) {
+				// wrap into in_buf - tg.bufp may point into the RX ring,
+				// which must not be written past the end of the line
+				strncpy(tg.out_buf, tg.bufp, INPUT_BUFFER_LEN -8);	// use out_buf as temp
+				sprintf(tg.in_buf,"{\"gc\":\"%s\"}\n", tg.out_buf);
+				tg.bufp = tg.in_buf;
+				js_json_parser(tg.bufp);
+			} else {
+				tg_text_response(gc_gcode_parser(tg.bufp), tg.saved_buf);
+			}
+		}
+	}
+	return (STAT_OK);
+}
+
+/*
+ * _verify_checksum() - verify and strip an optional trailing line checksum
+ *
+ *	Hosts may append "*nnnn" to any line, where nnnn is compute_checksum()
+ *	(see util.c) taken over every character before the '*'. This makes the
+ *	higher baud rates safe to run - without integrity checking a single
+ *	corrupted character can scrap a part.
+ *
+ *	Returns true and strips the suffix if the checksum matches (or if the
+ *	line carries no checksum - the protocol is strictly opt-in per line).
+ *	Returns false on a mismatch; the caller NAKs and discards the line.
+ *	Since every line is answered in order (ok/err in text mode, response
+ *	footer in JSON mode) the NAK itself identifies the failed line - the
+ *	host resends from its last unacknowledged line. No resend state is
+ *	kept here.
+ *
+ *	A leading '*' is a binary block record marker, not a checksum, and a
+ *	'*' followed by anything but digits-to-end-of-line is left alone
+ *	(hosts using checksums must not put '*' in comments or JSON strings).
+ */
+static uint8_t _verify_checksum(char *buf)
+{
+	char *mark = strrchr(buf, '*');
+	if ((mark == NULL) || (mark == buf)) { return (true); }	// no checksum on this line
+	if (*(mark+1) == NUL) { return (true); }				// bare trailing '*' is not a checksum
+	uint16_t checksum = 0;
+	for (char *str = mark+1; *str != NUL; str++) {
+		if (isdigit(*str) == false) { return (true); }		// not a checksum suffix
+		checksum = (checksum * 10) + (*str - '0');
+	}
+	if (checksum != compute_checksum(buf, (uint16_t)(mark - buf))) { return (false); }
+	*mark = NUL;											// strip the suffix
+	return (true);
+}
+
+/************************************************************************************
+ * tg_text_response() - text mode responses
+ */
+static const char prompt_mm[] PROGMEM = "mm";
+static const char prompt_in[] PROGMEM = "inch";
+static const char prompt_ok[] PROGMEM = "tinyg [%S] ok> ";
+static const char prompt_err[] PROGMEM = "tinyg [%S] err: %s: %s ";
+
+void tg_text_response(const uint8_t status, const char *buf)
+{
+#ifdef __JSON_ONLY
+	return;											// headless builds have no text responses
+#else
+	if (cfg.text_verbosity == TV_SILENT) return;	// skip all this
+
+	const char *units;								// becomes pointer to progmem string
+	if (cm_get_model_units_mode() != INCHES) { 
+		units = (PGM_P)&prompt_mm;
+	} else {
+		units = (PGM_P)&prompt_in;
+	}
+//	if ((status == STAT_OK) || (status == STAT_EAGAIN) || (status == STAT_NOOP) || (status == STAT_ZERO_LENGTH_MOVE)) {
+	if ((status == STAT_OK) || (status == STAT_EAGAIN) || (status == STAT_NOOP)) {
+		fprintf_P(stderr, (PGM_P)&prompt_ok, units);
+	} else {
+		char status_message[STATUS_MESSAGE_LEN];
+		fprintf_P(stderr, (PGM_P)prompt_err, units, rpt_get_status_message(status, status_message), buf);
+	}
+	cmdObj_t *cmd = cmd_body+1;
+	if (cmd->token[0] == 'm') {
+		fprintf(stderr, *cmd->stringp);
+	}
+	fprintf(stderr, "\n");
+#endif	// __JSON_ONLY
+}
+
+/**** Utilities ****
+ * _sync_to_tx_buffer() - return eagain if TX queue is backed up
+ * _sync_to_planner() - return eagain if planner is not ready for a new command
+ * tg_reset_source() - reset source to default input device (see note)
+ * tg_set_active_source() - set current input source
+ *
+ * Note: Once multiple serial devices are supported reset_source() should
+ *	be expanded to also set the stdout/stderr console device so the prompt
+ *	and other messages are sent to the active device.
+ */
+
+static stat_t _sync_to_tx_buffer()
+{
+	if ((xio_get_tx_bufcount_usart(ds[XIO_DEV_USB].x) >= XOFF_TX_LO_WATER_MARK)) {
+		return (STAT_EAGAIN);
+	}
+	return (STAT_OK);
+}
+
+static stat_t _sync_to_planner()
+{
+	if (mp_get_planner_buffers_available() < PLANNER_BUFFER_HEADROOM) { // allow up to N planner buffers for this line
+		tg.waiting_for_buffer = true;	// sleep until EVENT_BUFFER_bm (or any other event) arrives
+		return (STAT_EAGAIN);
+	}
+	tg.waiting_for_buffer = false;
+	return (STAT_OK);
+}
+
+void tg_reset_source() { tg_set_primary_source(tg.default_src);}
+void tg_set_primary_source(uint8_t dev) { tg.primary_src = dev;}
+void tg_set_secondary_source(uint8_t dev) { tg.secondary_src = dev;}
+
+/*
+ * tg_request_reset()
+ * _reset_handler()
+ * tg_reset() - software hard reset using watchdog timer
+ */
+void tg_request_reset() { tg.reset_requested = true; tg_set_event(EVENT_SIGNAL_bm);}
+
+static stat_t _reset_handler(void)
+{
+	if (tg.reset_requested == false) { return (STAT_NOOP);}
+	tg_reset();							// hard reset - identical to hitting RESET button
+	return (STAT_EAGAIN);
+}
+
+void tg_reset(void)			// software hard reset using the watchdog timer
+{
+	wdt_enable(WDTO_15MS);
+	while (true);			// loops for about 15ms then resets
+}
+
+
+/*
+ * tg_request_bootloader()
+ * _bootloader_handler() - executes a software reset using CCPWrite
+ */
+void tg_request_bootloader() { tg.bootloader_requested = true; tg_set_event(EVENT_SIGNAL_bm);}
+
+static stat_t _bootloader_handler(void)
+{
+	if (tg.bootloader_requested == false) { return (STAT_NOOP);}
+	cli();
+	CCPWrite(&RST.CTRL, RST_SWRST_bm);  // fire a software reset
+	return (STAT_EAGAIN);					// never gets here but keeps the compiler happy
+}
+
+/*
+ * _limit_switch_handler() - shut down system if limit switch fired
+ *
+ *	Step pulse generation was already killed in the switch ISR (see gpio.c),
+ *	so all that happens here is the alarm transition and its reporting.
+ */
+static stat_t _limit_switch_handler(void)
+{
+	if (cm_get_machine_state() == MACHINE_ALARM) { return (STAT_NOOP);}
+	if (gpio_get_limit_thrown() == false) return (STAT_NOOP);
+//	cm_alarm(gpio_get_sw_thrown); // unexplained complier warning: passing argument 1 of 'cm_shutdown' makes integer from pointer without a cast
+	cm_alarm(sw.sw_num_thrown);
+	return (STAT_OK);
+}
+
+/* 
+ * _alarm_idler() - revent any further activity form occurring if shut down
+ *
+ *	This function returns EAGAIN causing the control loop to never advance beyond
+ *	this point. It's important that the reset handler is still called so a SW reset
+ *	(ctrl-x) can be processed.
+ */
+#define LED_COUNTER 25000
+
+static stat_t _alarm_idler(void)
+{
+	if (cm_get_machine_state() != MACHINE_ALARM) { return (STAT_OK);}
+
+	if (--tg.led_counter < 0) {
+		tg.led_counter = LED_COUNTER;
+		if (tg.led_state == 0) {
+			gpio_led_on(INDICATOR_LED);
+			tg.led_state = 1;
+		} else {
+			gpio_led_off(INDICATOR_LED);
+			tg.led_state = 0;
+		}
+	}
+	return (STAT_EAGAIN);	 // EAGAIN prevents any other actions from running
+}
+
+/*
+ * _system_assertions() - check memory integrity and other assertions
+ *
+ *	Memory integrity is checked by the background CRC scan in xmega_crc.c,
+ *	which sweeps the struct boundary sentinels once per scan cycle and CRCs
+ *	the interior of the cfg struct one chunk per pass. Fault values 1-19
+ *	identify a corrupted sentinel (reported offset by ALARM_MEMORY_OFFSET),
+ *	value 20 is corruption inside the cfg body.
+ */
+uint8_t _system_assertions()
+{
+	uint8_t value = crc_scan();								// advance the scan one chunk
+	xio_assertions(&value);									// run xio assertions
+
+	if (value == 0) { return (STAT_OK);}
+	rpt_exception(STAT_MEMORY_FAULT, value);
+	cm_alarm(ALARM_MEMORY_OFFSET + value);	
+	return (STAT_EAGAIN);
+}
@@ -35,6 +35,21 @@
 #define OUTPUT_BUFFER_LEN 512			// text buffer size
 #define STATUS_MESSAGE_LEN 32			// status message string storage allocation
 #define APPLICATION_MESSAGE_LEN 64		// application message string storage allocation
+#define CPU_LOAD_SAMPLES 100			// RTC ticks per load window (100 x 10ms = 1 sec, so 1 sample = 1%)
+
+/* Controller event flags. Set by the ISRs (via tg_set_event) and collected
+ * once per pass by _controller_HSM(), which uses them to skip dispatch stages
+ * that cannot have pending work - see the notes there. The RTC tick fires
+ * every ~10 ms, so nothing gated on events waits longer than that.
+ */
+enum tgEventFlags {
+	EVENT_SIGNAL_bm = (1<<0),			// trapped signal (reset, bootloader, feedhold, switch)
+	EVENT_TICK_bm	= (1<<1),			// RTC tick - time-based callbacks may have work
+	EVENT_RX_bm		= (1<<2),			// character(s) received on a serial device
+	EVENT_BUFFER_bm	= (1<<3)			// planner run buffer freed (set by mp_free_run_buffer)
+};
+// ISRs at different levels can nest, so the read-modify-write must be atomic
+#define tg_set_event(e) { uint8_t sreg_save = SREG; cli(); tg.events |= (e); SREG = sreg_save;}
 
 struct controllerSingleton {			// main TG controller struct
 	uint16_t magic_start;				// magic number to test memory integity	
@@ -48,10 +63,15 @@ struct controllerSingleton {			// main TG controller struct
 	uint8_t default_src;				// default source device
 	uint8_t network_mode;				// 0=master, 1=repeater, 2=slave
 	uint8_t linelen;					// length of currently processing line
+	uint16_t ack_checksum;				// checksum of line being processed (terse ack mode)
 	uint8_t led_state;					// 0=off, 1=on
 	int32_t led_counter;				// a convenience for flashing an LED
 	uint8_t reset_requested;			// flag to perform a software reset
 	uint8_t bootloader_requested;		// flag to enter the bootloader
+	volatile uint8_t events;			// event flags set by ISRs (see tgEventFlags)
+	uint8_t waiting_for_buffer;			// dispatch is blocked on planner buffer headroom
+	volatile uint8_t cpu_busy;			// false only while the controller sleeps (load sampling)
+	volatile uint8_t cpu_load;			// percent of the last sample window not spent sleeping
 	char *bufp;							// pointer to primary or secondary in buffer
 	char in_buf[INPUT_BUFFER_LEN];		// primary input buffer
 	char out_buf[OUTPUT_BUFFER_LEN];	// output buffer
@@ -69,6 +89,21 @@ void tg_application_startup(void);
 void tg_reset_source(void);
 void tg_set_primary_source(uint8_t dev);
 void tg_set_secondary_source(uint8_t dev);
+void tg_cpu_load_rtc_callback(void);
 void tg_text_response(const uint8_t status, const char *buf);
 
+#ifdef __LOOP_PROFILE
+#define TIMER_LOOP			TIMER_5		// free running pass timebase (TCC1)
+#define LOOP_USEC_PER_TICK	2			// div64 off a 32 MHz F_CPU
+
+typedef struct loopProfileReport {	// worst-case controller pass record - see controller.c
+	float pass_max;					// longest controller pass observed (uSec)
+	float stage_max;				// dominant dispatch stage in that pass (uSec)
+	float stage_line;				// controller.c line number of that stage
+	float hold_plan;				// last feedhold planning time (uSec) - see plan_line.c
+	float hold_resume;				// last feedhold resume time (uSec) - see plan_line.c
+} loopProfileReport_t;
+loopProfileReport_t loop_rpt;		// read by the "lp" cmdObj group (config.c)
+#endif
+
 #endif
@@ -0,0 +1,266 @@
+/*
+ * cycle_drilling.c - canned drilling cycle extension to canonical_machine.c
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "planner.h"
+
+/**** Drilling singleton structure ****/
+
+struct drDrillingSingleton {	// persistent drilling cycle runtime variables
+	float x, y;					// hole position (canonical machine coords, mm)
+	float z_bottom;				// Z - hole bottom (sticky across cycle blocks)
+	float r_plane;				// R - retract plane (sticky)
+	float z_initial;			// Z level at cycle entry - the G98 return level
+	float dwell;				// P - dwell at bottom in seconds (sticky)
+	float peck;					// Q - G83 peck increment in mm (sticky)
+	float depth;				// deepest Z reached so far (G83 pecking)
+	uint8_t cycle;				// MOTION_MODE_CANNED_CYCLE_81, _82 or _83
+	uint8_t saved_units_mode;	// G20,G21 global setting
+	uint8_t saved_coord_system;	// G54 - G59 setting
+	uint8_t saved_distance_mode;// G90,G91 global setting
+	stat_t (*func)(void);		// binding for callback function state machine
+};
+static struct drDrillingSingleton dr;
+
+#define DRILL_PECK_CLEARANCE ((float)0.5)	// mm above previous depth to re-engage at
+
+static stat_t _drill_clear_z(void);
+static stat_t _drill_rapid_xy(void);
+static stat_t _drill_plunge(void);
+static stat_t _drill_peck_retract(void);
+static stat_t _drill_peck_reengage(void);
+static stat_t _drill_dwell(void);
+static stat_t _drill_retract(void);
+static stat_t _drill_finalize_exit(void);
+static stat_t _drill_error_exit(stat_t status);
+static stat_t _drill_rapid_z(float z, stat_t (*next)(void));
+
+/*****************************************************************************
+ * cm_drill_cycle_start() - G81/G82/G83 drilling canned cycles
+ * cm_drill_callback()    - main loop callback for running a drilling cycle
+ *
+ *	Expands one canned cycle block into its retract / position / plunge /
+ *	dwell / retract move group on-board, so a drilling job streams one short
+ *	block per hole instead of five. The cycles follow RS274NGC:
+ *
+ *	  G81 X_ Y_ Z_ R_      drill: feed to Z, rapid out
+ *	  G82 X_ Y_ Z_ R_ P_   as G81 with a dwell at the bottom
+ *	  G83 X_ Y_ Z_ R_ Q_   peck drill: Q deep bites with full retracts
+ *
+ *	Motion mode is modal, so follow-on blocks holding just X/Y words drill
+ *	further holes; Z, R, P and Q are sticky for the duration of the series.
+ *	G98/G99 select the return level (previous Z / R plane). Restrictions:
+ *	XY plane (G17) and absolute distance mode (G90) only, and the plunge
+ *	needs an active feed rate.
+ *
+ *	The expansion runs as a main loop continuation one queued move per pass,
+ *	dispatched after _sync_to_planner() so a planner buffer is always free
+ *	and ahead of _dispatch() so the next block isn't read until the whole
+ *	hole is queued. Moves are issued in canonical machine coordinates with
+ *	the gcode model parked in mm / absolute / machine coords (same trick as
+ *	cycle_homing.c) and the user's modes restored on exit. Unlike homing the
+ *	moves are not run to completion between steps - the whole group plans as
+ *	one lookahead chain, which is the throughput point of the exercise.
+ */
+
+stat_t cm_drill_cycle_start(uint8_t motion_mode, float target[], float flags[])
+{
+	// validate up front - nothing is queued if the block is unusable
+	if (gm.select_plane != CANON_PLANE_XY) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (gm.distance_mode != ABSOLUTE_MODE) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (gm.inverse_feed_rate_mode == true) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (fp_ZERO(gm.feed_rate)) { return (STAT_GCODE_FEEDRATE_ERROR);}
+
+	// resolve the block's words to canonical machine coordinates
+	cm_set_target(target, flags);				// updates gm.target; no motion yet
+	if (fp_TRUE(flags[AXIS_X])) { dr.x = gm.target[AXIS_X];} else { dr.x = gm.position[AXIS_X];}
+	if (fp_TRUE(flags[AXIS_Y])) { dr.y = gm.target[AXIS_Y];} else { dr.y = gm.position[AXIS_Y];}
+	if (fp_TRUE(flags[AXIS_Z])) { dr.z_bottom = gm.target[AXIS_Z];}
+	else if (dr.cycle == 0) { return (STAT_GCODE_AXIS_WORD_MISSING);}	// Z required to start a series
+
+	if (fp_TRUE(gf.arc_radius)) {				// R is a Z coordinate - convert like one
+		set_vector_by_axis(gn.arc_radius, AXIS_Z);
+		float r_flags[] = {0,0,1,0,0,0};
+		cm_set_target(vector, r_flags);
+		dr.r_plane = gm.target[AXIS_Z];
+	} else if (dr.cycle == 0) { return (STAT_GCODE_AXIS_WORD_MISSING);}	// R required to start a series
+
+	if (fp_TRUE(gf.parameter)) { dr.dwell = gn.parameter;}
+	if (fp_TRUE(gf.parameter_q)) {
+		dr.peck = gn.parameter_q * gm.units_scale;
+	}
+	if (dr.z_bottom >= dr.r_plane) { return (STAT_INPUT_VALUE_RANGE_ERROR);}	// must drill downward
+	if ((motion_mode == MOTION_MODE_CANNED_CYCLE_82) && (dr.dwell <= 0)) {
+		return (STAT_INPUT_VALUE_RANGE_ERROR);
+	}
+	if ((motion_mode == MOTION_MODE_CANNED_CYCLE_83) && (dr.peck <= 0)) {
+		return (STAT_INPUT_VALUE_RANGE_ERROR);
+	}
+
+	// save relevant non-axis parameters from Gcode model (restored on exit)
+	dr.saved_units_mode = gm.units_mode;
+	dr.saved_coord_system = gm.coord_system;
+	dr.saved_distance_mode = gm.distance_mode;
+
+	// set working values - moves are issued in canonical machine coordinates
+	cm_set_units_mode(MILLIMETERS);
+	cm_set_distance_mode(ABSOLUTE_MODE);
+	cm_set_coord_system(ABSOLUTE_COORDS);
+
+	dr.cycle = motion_mode;
+	dr.z_initial = gm.position[AXIS_Z];
+	dr.depth = dr.r_plane;
+	dr.func = _drill_clear_z;
+	cm_cycle_start();							// keep the controller sweep running
+	return (STAT_OK);
+}
+
+stat_t cm_drill_callback(void)
+{
+	if (dr.func == NULL) { return (STAT_NOOP);}
+	return (dr.func());
+}
+
+/*
+ * cm_drill_reset() - G80 (or any error) ends the cycle series
+ *
+ *	Clears the sticky Z/R/P/Q values so the next canned cycle block must
+ *	carry Z and R again, per RS274NGC series semantics.
+ */
+void cm_drill_reset(void)
+{
+	dr.cycle = 0;
+}
+
+/* Cycle steps - each entry queues (at most) one move and binds the next step.
+ * Returning STAT_EAGAIN holds off _dispatch() until the hole is fully queued.
+ */
+
+static stat_t _drill_clear_z(void)			// preliminary: come up to the R plane if below it
+{
+	if (gm.position[AXIS_Z] < dr.r_plane) {
+		return (_drill_rapid_z(dr.r_plane, _drill_rapid_xy));
+	}
+	dr.func = _drill_rapid_xy;
+	return (STAT_EAGAIN);
+}
+
+static stat_t _drill_rapid_xy(void)			// rapid to the hole position
+{
+	stat_t status;
+	float flags[] = {1,1,0,0,0,0};
+
+	set_vector(dr.x, dr.y, 0,0,0,0);
+	if ((status = cm_straight_traverse(vector, flags)) != STAT_OK) {
+		return (_drill_error_exit(status));
+	}
+	dr.func = _drill_plunge;
+	return (STAT_EAGAIN);
+}
+
+static stat_t _drill_plunge(void)			// feed to the bottom - in Q bites for G83
+{
+	stat_t status;
+	float flags[] = {0,0,1,0,0,0};
+	float z = dr.z_bottom;
+
+	if (dr.cycle == MOTION_MODE_CANNED_CYCLE_83) {
+		z = max(dr.z_bottom, dr.depth - dr.peck);
+	}
+	set_vector_by_axis(z, AXIS_Z);
+	if ((status = cm_straight_feed(vector, flags)) != STAT_OK) {
+		return (_drill_error_exit(status));
+	}
+	dr.depth = z;
+	if (z > dr.z_bottom) { dr.func = _drill_peck_retract;}
+	else if (dr.cycle == MOTION_MODE_CANNED_CYCLE_82) { dr.func = _drill_dwell;}
+	else { dr.func = _drill_retract;}
+	return (STAT_EAGAIN);
+}
+
+static stat_t _drill_peck_retract(void)		// G83: full retract to clear chips
+{
+	return (_drill_rapid_z(dr.r_plane, _drill_peck_reengage));
+}
+
+static stat_t _drill_peck_reengage(void)	// G83: rapid back to just above the last depth
+{
+	return (_drill_rapid_z(dr.depth + DRILL_PECK_CLEARANCE, _drill_plunge));
+}
+
+static stat_t _drill_dwell(void)			// G82: dwell at the bottom
+{
+	stat_t status;
+	if ((status = cm_dwell(dr.dwell)) != STAT_OK) { return (_drill_error_exit(status));}
+	dr.func = _drill_retract;
+	return (STAT_EAGAIN);
+}
+
+static stat_t _drill_retract(void)			// rapid out to the G98/G99 return level
+{
+	float z = dr.r_plane;
+	if ((gm.retract_mode == RETRACT_TO_PREVIOUS) && (dr.z_initial > dr.r_plane)) {
+		z = dr.z_initial;
+	}
+	return (_drill_rapid_z(z, _drill_finalize_exit));
+}
+
+static stat_t _drill_finalize_exit(void)	// restore modes; motion mode stays modal
+{
+	cm_set_units_mode(dr.saved_units_mode);
+	cm_set_coord_system(dr.saved_coord_system);
+	cm_set_distance_mode(dr.saved_distance_mode);
+	dr.func = NULL;
+	return (STAT_OK);
+}
+
+static stat_t _drill_error_exit(stat_t status)	// a queued move failed - unwind and report
+{
+	_drill_finalize_exit();
+	dr.cycle = 0;							// next cycle block must carry Z and R again
+	return (status);
+}
+
+static stat_t _drill_rapid_z(float z, stat_t (*next)(void))
+{
+	stat_t status;
+	float flags[] = {0,0,1,0,0,0};
+
+	set_vector_by_axis(z, AXIS_Z);
+	if ((status = cm_straight_traverse(vector, flags)) != STAT_OK) {
+		return (_drill_error_exit(status));
+	}
+	dr.func = next;
+	return (STAT_EAGAIN);
+}
@@ -0,0 +1,213 @@
+/*
+ * cycle_jogging - continuous jogging cycle extension to canonical_machine.c
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <avr/pgmspace.h>		// needed for exception strings
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "stepper.h"
+#include "xmega/xmega_rtc.h"	// dead man timing
+
+/*
+ *	Jogging constants. The block length is sized so the controller loop tops
+ *	the queue up faster than the steppers drain it; the depth bounds how much
+ *	committed (unreplannable) travel is in flight, which bounds the stopping
+ *	lag on top of the jerk-limited deceleration itself.
+ */
+#define JOG_BLOCK_MS 		((float)50)		// travel per queued jog block, in ms at jog velocity
+#define JOG_QUEUE_DEPTH 	3				// planner blocks kept in flight while the key is down
+#define JOG_DEADMAN_TICKS 	(250 / RTC_MILLISECONDS) // release if the host goes silent this long
+#define JOG_MINIMUM_VELOCITY ((float)10)	// floor keeps blocks above planner minimums (mm/min)
+
+/**** Jogging singleton structure ****/
+
+struct jgJoggingSingleton {		// persistent jogging runtime variables
+	uint8_t axis;				// axis being jogged
+	int8_t direction;			// 1 = positive travel, -1 = negative
+	float velocity;				// commanded jog velocity (mm/min)
+	uint8_t released;			// key has been released - decelerating to exit
+	uint32_t deadline;			// RTC tick deadline for the dead man release
+
+	// state saved from gcode model
+	float saved_feed_rate;		// F setting
+	uint8_t saved_units_mode;	// G20,G21 global setting
+	uint8_t saved_distance_mode;// G90,G91 global setting
+};
+static struct jgJoggingSingleton jog;
+
+
+/**** NOTE: global prototypes and other .h info is located in canonical_machine.h ****/
+
+static stat_t _jog_release(void);
+static stat_t _jog_finalize_exit(void);
+
+/*****************************************************************************
+ * cm_jog()			- start, refresh or release a continuous jog ($jogx=f)
+ * cm_jog_callback()- main loop callback for running the jogging cycle
+ *
+ *	Jogging from a UI by streaming small G1 blocks is either jerky (each block
+ *	plans to a stop) or laggy (blocks queue up behind each other and key
+ *	release waits for the backlog). This cycle makes jogging first-class:
+ *
+ *	A jog is started by writing a signed fraction of the axis maximum velocity
+ *	to the axis jog command, e.g. $jogx=0.25 jogs X in plus at 25% of
+ *	cfg.a[X].velocity_max. The cycle queues short incremental feed blocks and
+ *	keeps only JOG_QUEUE_DEPTH of them in flight. Consecutive blocks on the
+ *	same axis are collinear so the planner's junction handling runs them
+ *	through at full speed - motion is continuous and accel/decel at the ends
+ *	is jerk-limited by the normal move planning. Re-sending the command while
+ *	the key is held refreshes the dead man deadline and can change the
+ *	velocity on the fly; each refresh is constant-time (no moves are queued
+ *	from the command itself).
+ *
+ *	Release is $jog<axis>=0, a direction or axis change, or dead man timeout
+ *	(the host must refresh at least every JOG_DEADMAN_TICKS or the jog stops
+ *	on its own - a stuck key or dropped link cannot run the machine away).
+ *	Release requests a feedhold, so deceleration starts at the next segment
+ *	with the shallow queue bounding the committed travel. Once stopped, the
+ *	unrun remainder is flushed, the model position is synced to where the
+ *	machine actually stopped, and the saved Gcode model state is restored.
+ *
+ *	Jogging runs as its own cycle (CYCLE_JOG) so status reports show it
+ *	distinctly and the planner's startup fill gate stays out of the way
+ *	(see the startup fill gate notes in planner.c). A jog is refused while any
+ *	other cycle is active.
+ */
+
+stat_t cm_jog(const uint8_t axis, const float fraction)
+{
+	if (axis >= AXES) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (fabs(fraction) > 1) { return (STAT_INPUT_VALUE_RANGE_ERROR);}
+
+	if (fabs(fraction) < EPSILON) {				// zero is the key release
+		if (cm.cycle_state == CYCLE_JOG) { _jog_release();}
+		return (STAT_OK);						// releasing an idle axis is a no-op
+	}
+	int8_t direction = (fraction < 0) ? -1 : 1;
+	float velocity = max(fabs(fraction) * cfg.a[axis].velocity_max, JOG_MINIMUM_VELOCITY);
+
+	if (cm.cycle_state == CYCLE_JOG) {
+		if ((jog.released == false) && (axis == jog.axis) && (direction == jog.direction)) {
+			jog.velocity = velocity;			// refresh - feed the dead man and track velocity
+			jog.deadline = rtc.clock_ticks + JOG_DEADMAN_TICKS;
+			return (STAT_OK);
+		}
+		return (_jog_release());				// axis or direction change - stop first
+	}
+	if (cm.cycle_state != CYCLE_OFF) { return (STAT_CONFIG_NOT_TAKEN);} // can't jog mid-cycle
+
+	// save relevant non-axis parameters from Gcode model
+	jog.saved_units_mode = gm.units_mode;
+	jog.saved_distance_mode = gm.distance_mode;
+	jog.saved_feed_rate = gm.feed_rate;
+
+	// set working values
+	cm_set_units_mode(MILLIMETERS);
+	cm_set_distance_mode(INCREMENTAL_MODE);		// jog blocks are incremental extensions
+
+	jog.axis = axis;
+	jog.direction = direction;
+	jog.velocity = velocity;
+	jog.released = false;
+	jog.deadline = rtc.clock_ticks + JOG_DEADMAN_TICKS;
+	cm.cycle_state = CYCLE_JOG;
+	st_enable_motors();							// enable motors if not already enabled
+	return (STAT_OK);
+}
+
+stat_t cm_jog_callback(void)
+{
+	if (cm.cycle_state != CYCLE_JOG) { return (STAT_NOOP);}	// exit if not in a jogging cycle
+
+	if (jog.released == true) {
+		// wait out the feedhold deceleration, or the natural drain if the
+		// queue emptied before the hold could engage
+		if ((cm.hold_state != FEEDHOLD_OFF) && (cm.hold_state != FEEDHOLD_HOLD)) {
+			return (STAT_EAGAIN);
+		}
+		if ((cm.hold_state == FEEDHOLD_OFF) && (cm_isbusy() == true)) { return (STAT_EAGAIN);}
+		return (_jog_finalize_exit());
+	}
+	if (rtc.clock_ticks > jog.deadline) { return (_jog_release());}	// host went silent
+
+	// keep the queue primed to depth with one short collinear block per pass
+	if (mp_get_planner_buffers_available() < (PLANNER_BUFFER_POOL_SIZE - JOG_QUEUE_DEPTH)) {
+		return (STAT_NOOP);						// primed deep enough
+	}
+	float flags[] = {1,1,1,1,1,1};
+	float length = jog.direction * jog.velocity * JOG_BLOCK_MS / 60000;	// mm per block
+	set_vector_by_axis(length, jog.axis);
+	cm_set_feed_rate(jog.velocity);
+	cm_request_cycle_start();
+	if (cm_straight_feed(vector, flags) != STAT_OK) {	// e.g. soft limit reached
+		return (_jog_release());
+	}
+	return (STAT_EAGAIN);
+}
+
+/*
+ * _jog_release() - begin the jerk-limited stop
+ *
+ *	Uses the feedhold machinery so deceleration starts at the next stepper
+ *	segment - the shallow queue is not run out first.
+ */
+static stat_t _jog_release(void)
+{
+	if (jog.released == false) {
+		jog.released = true;
+		cm_request_feedhold();
+	}
+	return (STAT_EAGAIN);
+}
+
+/*
+ * _jog_finalize_exit() - discard the unrun remainder and restore the model
+ */
+static stat_t _jog_finalize_exit(void)
+{
+	mp_flush_planner();							// discard the unrun jog blocks
+	for (uint8_t i=0; i<AXES; i++) {			// sync the model to where the hold stopped
+		mp_set_axis_position(i, mp_get_runtime_machine_position(i));
+		gm.position[i] = mp_get_runtime_machine_position(i);
+		gm.target[i] = gm.position[i];
+	}
+	cm.motion_state = MOTION_STOP;
+	cm.hold_state = FEEDHOLD_OFF;
+	cm_set_units_mode(jog.saved_units_mode);
+	cm_set_distance_mode(jog.saved_distance_mode);
+	cm_set_feed_rate(jog.saved_feed_rate);
+	cm_set_motion_mode(MOTION_MODE_CANCEL_MOTION_MODE);
+	cm.cycle_state = CYCLE_OFF;
+	cm_cycle_end();
+	return (STAT_OK);
+}
@@ -0,0 +1,188 @@
+/*
+ * cycle_probing.c - G38.2 straight probe cycle extension to canonical_machine.c
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <avr/pgmspace.h>		// needed for exception strings
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "stepper.h"
+#include "report.h"
+#include "gpio.h"
+
+/*
+ * The probe contact is read on one of the switch inputs - PROBE_SWITCH in
+ * gpio.h, default Z minimum. Override it in a machine profile to move it.
+ */
+
+/**** Probing singleton structure ****/
+
+struct pbProbingSingleton {		// persistent probing runtime variables
+	stat_t (*func)(void);		// binding for callback function state machine
+
+	// probe destination latched from the Gcode block
+	float target[AXES];			// probe destination (gn.target at cycle start)
+	float flags[AXES];			// axis words present in the G38.2 block
+
+	// switch edge capture (see cm_probe_switch_capture)
+	volatile uint8_t capture_armed;		// one-shot arm for the probe edge
+	volatile uint8_t capture_valid;		// a captured position is available
+	volatile float captured_position[AXES];	// machine position of the probe trip
+};
+static struct pbProbingSingleton pb;
+
+static stat_t _probing_start(void);
+static stat_t _probing_finish(void);
+static stat_t _set_pb_func(stat_t (*func)(void));
+
+/*****************************************************************************
+ * cm_probe_cycle_start()	- G38.2 straight probe
+ * cm_probe_callback() 		- main loop callback for running the probing cycle
+ *
+ *	The cycle is modeled on the homing state machine in cycle_homing.c: the
+ *	G38.2 block latches its target and registers _probing_start(), and the
+ *	controller drives the states through cm_probe_callback() between moves.
+ *
+ *	The probe move is an ordinary straight feed toward the latched target.
+ *	When the probe contact closes the switch ISR latches the machine position
+ *	of the edge - dated to within one DDA segment by the stepper runtime
+ *	counters (see st_get_dda_fraction()) rather than a controller pass later -
+ *	and requests a feedhold so deceleration starts immediately. Once motion
+ *	stops the cycle records the result in cm.probe_state / cm.probe_position[]
+ *	(query with $prb) and reports it. Reaching the target without a contact
+ *	is a failed probe per G38.2, reported but not alarmed.
+ */
+
+uint8_t cm_probe_cycle_start(void)
+{
+	// trap a probe block with no feed rate or no axis words
+	if (gm.feed_rate == 0) { return (STAT_GCODE_FEEDRATE_ERROR);}
+	uint8_t axis_words = false;
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		pb.target[axis] = gn.target[axis];		// latch the block before the next
+		pb.flags[axis] = gf.target[axis];		// one overwrites gn/gf
+		if (gf.target[axis] == true) { axis_words = true;}
+	}
+	if (axis_words == false) { return (STAT_GCODE_AXIS_WORD_MISSING);}
+
+	pb.capture_armed = false;
+	pb.capture_valid = false;
+	cm.probe_state = PROBE_WAITING;
+	cm.cycle_state = CYCLE_PROBE;
+	pb.func = _probing_start; 					// bind initial processing function
+	return (STAT_OK);
+}
+
+uint8_t cm_probe_callback(void)
+{
+	if (cm.cycle_state != CYCLE_PROBE) { return (STAT_NOOP);} // exit if not in a probing cycle
+	if (cm_isbusy() == true) { return (STAT_EAGAIN);}	 // sync to planner move ends
+	return (pb.func());							// execute the current probing state
+}
+
+/*
+ * cm_probe_switch_capture() - latch the probe trip position at ISR level
+ *
+ *	Called from the switch ISR on the raw edge of the probe input (see
+ *	gpio.c). The edge is dated by how far the DDA has run into the loaded
+ *	segment and back-computed to machine positions by the planner runtime,
+ *	so the recorded trip position does not depend on the deglitch delay or
+ *	on the deceleration that follows. The feedhold is requested right here
+ *	so the probe starts slowing within the same tick it makes contact.
+ */
+void cm_probe_switch_capture(uint8_t sw_num)
+{
+	if ((pb.capture_armed == false) || (sw_num != PROBE_SWITCH)) { return;}
+	pb.capture_armed = false;
+	float fraction = st_get_dda_fraction();
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		pb.captured_position[axis] = mp_get_runtime_segment_position(axis, fraction);
+	}
+	pb.capture_valid = true;
+	cm_request_feedhold();						// start decelerating right away
+}
+
+/**** Probing states ********************************************************/
+
+static stat_t _probing_start(void)
+{
+	pb.capture_armed = true;					// arm before any motion can occur
+	cm_request_queue_flush();
+	cm_request_cycle_start();
+	ritorno(cm_straight_feed(pb.target, pb.flags));
+	return (_set_pb_func(_probing_finish));		// re-enter when the move stops
+}
+
+static stat_t _probing_finish(void)
+{
+	pb.capture_armed = false;					// no longer interested in edges
+
+	if (pb.capture_valid == true) {				// probe made contact
+		cm.probe_state = PROBE_SUCCEEDED;
+		for (uint8_t axis=0; axis<AXES; axis++) {
+			cm.probe_position[axis] = pb.captured_position[axis];
+		}
+	} else {									// ran to target without contact
+		cm.probe_state = PROBE_FAILED;
+		for (uint8_t axis=0; axis<AXES; axis++) {
+			cm.probe_position[axis] = mp_get_runtime_machine_position(axis);
+		}
+	}
+	mp_flush_planner(); 						// should be stopped, but in case of a late edge
+	cm_set_motion_mode(MOTION_MODE_CANCEL_MOTION_MODE);
+	cm.cycle_state = CYCLE_OFF;
+	cm_cycle_end();
+
+	// report the result - query $prb for the full position record
+	cmd_reset_list();
+	char message[CMD_MESSAGE_LEN];
+	if (cm.probe_state == PROBE_SUCCEEDED) {
+		sprintf_P(message, PSTR("Probe contact X%0.3f Y%0.3f Z%0.3f"),
+			cm.probe_position[AXIS_X], cm.probe_position[AXIS_Y], cm.probe_position[AXIS_Z]);
+	} else {
+		sprintf_P(message, PSTR("Probe failed to make contact"));
+	}
+	cmd_add_message(message);
+	cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_RESPONSE_FORMAT);
+	return (STAT_OK);
+}
+
+/**** HELPERS ****************************************************************/
+/*
+ * _set_pb_func() - a convenience for setting the next dispatch vector and exiting
+ */
+
+static stat_t _set_pb_func(stat_t (*func)(void))
+{
+	pb.func = func;
+	return (STAT_EAGAIN);
+}
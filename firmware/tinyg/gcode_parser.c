@@ -1,481 +1,637 @@
-/*
- * gcode_interpreter.c - rs274/ngc Gcode parser.
- * Part of TinyG project
- *
- * Copyright (c) 2010-2013 Alden S. Hart, Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* See http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
- */
-
-#include <ctype.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <string.h>					// needed for memcpy, memset
-#include <avr/pgmspace.h>			// precursor for xio.h
-
-#include "tinyg.h"
-#include "util.h"
-#include "config.h"
-#include "gcode_parser.h"
-#include "canonical_machine.h"
-#include "xio/xio.h"				// for char definitions
-
-struct gcodeParserSingleton {	 	  // struct to manage globals
-	uint8_t modals[MODAL_GROUP_COUNT];// collects modal groups in a block
-}; struct gcodeParserSingleton gp;
-
-// local helper functions and macros
-static void _normalize_gcode_block(char_t *cmd, char_t **com, char_t **msg, uint8_t *block_delete_flag);
-static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value);
-static stat_t _point(float value);
-static stat_t _validate_gcode_block(void);
-static stat_t _parse_gcode_block(char_t *line);	// Parse the block into the GN/GF structs
-static stat_t _execute_gcode_block(void);		// Execute the gcode block
-
-#define SET_MODAL(m,parm,val) ({gn.parm=val; gf.parm=1; gp.modals[m]+=1; break;})
-#define SET_NON_MODAL(parm,val) ({gn.parm=val; gf.parm=1; break;})
-#define EXEC_FUNC(f,v) if((uint8_t)gf.v != false) { status = f(gn.v);}
-
-/*
- * gc_gcode_parser() - parse a block (line) of gcode
- *
- *	Top level of gcode parser. Normalizes block and looks for special cases
- */
-
-stat_t gc_gcode_parser(char_t *block)
-{
-	char_t *cmd = block;					// gcode command or NUL string
-	char_t none = NUL;
-	char_t *com = &none;					// gcode comment or NUL string
-	char_t *msg = &none;					// gcode message or NUL string
-	uint8_t block_delete_flag;
-
-	_normalize_gcode_block(cmd, &com, &msg, &block_delete_flag);
-	
-	if ((block_delete_flag == true) && (cm_get_block_delete_switch() == true)) {
-		return (STAT_NOOP);
-	}
-//	if (*msg != NUL) { // +++++ THIS HAS A SERIOUS BUG IN IT SO FOR NOW IT'S DISABLED
-//		(void)cm_message(msg);				// queue the message	
-//	}	
-	return(_parse_gcode_block(block));
-}
-
-/*
- * _normalize_gcode_block() - normalize a block (line) of gcode in place
- *
- *	Normalization functions:
- *   - convert all letters to upper case
- *	 - remove white space, control and other invalid characters 
- *	 - remove (erroneous) leading zeros that might be taken to mean Octal
- *	 - identify and return start of comments and messages
- *	 - signal if a block-delete character (/) was encountered in the first space
- *
- *	So this: "  g1 x100 Y100 f400" becomes this: "G1X100Y100F400"
- *
- *	Comment and message handling:
- *	 - Comments field start with a '(' char or alternately a semicolon ';' 
- *	 - Comments and messages are not normalized - they are left alone
- *	 - The 'MSG' specifier in comment can have mixed case but cannot cannot have embedded white spaces
- *	 - Normalization returns true if there was a message to display, false otherwise
- *	 - Comments always terminate the block - i.e. leading or embedded comments are not supported
- *	 	- Valid cases (examples)			Notes:
- *		    G0X10							 - command only - no comment
- *		    (comment text)                   - There is no command on this line
- *		    G0X10 (comment text)
- *		    G0X10 (comment text				 - It's OK to drop the trailing paren
- *		    G0X10 ;comment text				 - It's OK to drop the trailing paren
- *
- *	 	- Invalid cases (examples)			Notes:
- *		    G0X10 comment text				 - Comment with no separator
- *		    N10 (comment) G0X10 			 - embedded comment. G0X10 will be ignored
- *		    (comment) G0X10 				 - leading comment. G0X10 will be ignored
- * 			G0X10 # comment					 - invalid separator
- *
- *	Returns:
- *	 - com points to comment string or to NUL if no comment
- *	 - msg points to message string or to NUL if no comment
- *	 - block_delete_flag is set true if block delete encountered, false otherwise
- */
-static void _normalize_gcode_block(char_t *cmd, char_t **com, char_t **msg, uint8_t *block_delete_flag)
-{
-	char_t *rd = cmd;				// read pointer
-	char_t *wr = cmd;				// write pointer
-
-	// Preset comments and messages to NUL string
-	// Not required if com and msg already point to NUL on entry
-//	for (rd = cmd; *rd != NUL; rd++) { if (*rd == NUL) { *com = rd; *msg = rd; rd = cmd;} }
-
-	// mark block deletes
-	if (*rd == '/') { *block_delete_flag = true; } 
-	else { *block_delete_flag = false; }
-	
-	// normalize the command block & find the comment (if any)
-	for (; *wr != NUL; rd++) {
-		if (*rd == NUL) { *wr = NUL; }
-//		else if (*rd == '(') { *wr = NUL; *com = rd+1; }
-		else if ((*rd == '(') || (*rd == ';')) { *wr = NUL; *com = rd+1; }
-		else if ((isalnum((char)*rd)) || (strchr("-.", *rd))) { // all valid characters
-			*(wr++) = (char_t)toupper((char)*(rd));
-		}
-	}
-	
-	// Perform Octal stripping - remove invalid leading zeros in number strings
-	rd = cmd;
-	while (*rd != NUL) {
-		if (*rd == '.') break;							// don't strip past a decimal point
-		if ((!isdigit(*rd)) && (*(rd+1) == '0') && (isdigit(*(rd+2)))) {
-			wr = rd+1;
-			while (*wr != NUL) { *wr = *(wr+1); wr++;}	// copy forward w/overwrite
-			continue;
-		}
-		rd++;
-	}
-	
-	// process comments and messages
-	if (**com != NUL) {
-		rd = *com;
-		while (isspace(*rd)) { rd++; }		// skip any leading spaces before "msg"
-		if ((tolower(*rd) == 'm') && (tolower(*(rd+1)) == 's') && (tolower(*(rd+2)) == 'g')) {
-			*msg = rd+3;
-		}
-		for (; *rd != NUL; rd++) {	
-			if (*rd == ')') *rd = NUL;		// NUL terminate on trailing parenthesis, if any
-		}
-	}
-}
-
-/*
- * _get_next_gcode_word() - get gcode word consisting of a letter and a value
- *
- *	This function requires the Gcode string to be normalized.
- *	Normalization must remove any leading zeros or they will be converted to Octal
- *	G0X... is not interpreted as hexadecimal. This is trapped.
- */
-static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value) 
-{
-	if (**pstr == NUL) { return (STAT_COMPLETE); }	// no more words
-
-	// get letter part
-	if(isupper(**pstr) == false) { return (STAT_EXPECTED_COMMAND_LETTER); }
-	*letter = **pstr;
-	(*pstr)++;
-	
-	// X-axis-becomes-a-hexadecimal-number get-value case, e.g. G0X100 --> G255
-	if ((**pstr == '0') && (*(*pstr+1) == 'X')) {
-		*value = 0;
-		(*pstr)++;
-		return (STAT_OK);		// pointer points to X
-	}
-
-	// get-value general case
-	char *end; 
-	*value = strtod(*pstr, &end);
-	if(end == *pstr) { return(STAT_BAD_NUMBER_FORMAT); }	// more robust test then checking for value=0;
-	*pstr = end;
-	return (STAT_OK);			// pointer points to next character after the word
-}
-
-/*
- * _point() - isolate the decimal point value as an integer
- */
-static uint8_t _point(float value) { return((uint8_t)(value*10 - trunc(value)*10));}
-
-/*
- * _validate_gcode_block() - check for some gross Gcode block semantic violations
- */
-
-static stat_t _validate_gcode_block()
-{
-	//	Check for modal group violations. From NIST, section 3.4 "It is an error to put
-	//	a G-code from group 1 and a G-code from group 0 on the same line if both of them 
-	//	use axis words. If an axis word-using G-code from group 1 is implicitly in effect 
-	//	on a line (by having been activated on an earlier line), and a group 0 G-code that 
-	//	uses axis words appears on the line, the activity of the group 1 G-code is suspended 
-	//	for that line. The axis word-using G-codes from group 0 are G10, G28, G30, and G92"
-
-//	if ((gp.modals[MODAL_GROUP_G0] == true) && (gp.modals[MODAL_GROUP_G1] == true)) {
-//		return (STAT_MODAL_GROUP_VIOLATION);
-//	}
-	
-	// look for commands that require an axis word to be present
-//	if ((gp.modals[MODAL_GROUP_G0] == true) || (gp.modals[MODAL_GROUP_G1] == true)) {
-//		if (_axis_changed() == false)
-//		return (STAT_GCODE_AXIS_WORD_MISSING);
-//	}
-	return (STAT_OK);
-}
-
-/*
- * _parse_gcode_block() - parses one line of NULL terminated G-Code. 
- *
- *	All the parser does is load the state values in gn (next model state) and set flags
- *	in gf (model state flags). The execute routine applies them. The buffer is assumed to 
- *	contain only uppercase characters and signed floats (no whitespace).
- *
- *	A number of implicit things happen when the gn struct is zeroed:
- *	  - inverse feed rate mode is cancelled - set back to units_per_minute mode
- */
-static stat_t _parse_gcode_block(char_t *buf) 
-{
-	char *pstr = (char *)buf;		// persistent pointer into gcode block for parsing words
-  	char letter;					// parsed letter, eg.g. G or X or Y
-	float value = 0;				// value parsed from letter (e.g. 2 for G2)
-	stat_t status = STAT_OK;
-
-	// set initial state for new move 
-	memset(&gp, 0, sizeof(gp));		// clear all parser values
-	memset(&gf, 0, sizeof(gf));		// clear all next-state flags
-	memset(&gn, 0, sizeof(gn));		// clear all next-state values
-	gn.motion_mode = cm_get_model_motion_mode();// get motion mode from previous block
-
-  	// extract commands and parameters
-	while((status = _get_next_gcode_word(&pstr, &letter, &value)) == STAT_OK) {
-		switch(letter) {
-			case 'G':
-				switch((uint8_t)value) {
-					case 0:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_TRAVERSE);
-					case 1:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_FEED);
-					case 2:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CW_ARC);
-					case 3:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CCW_ARC);
-					case 4:  SET_NON_MODAL (next_action, NEXT_ACTION_DWELL);
-					case 10: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_COORD_DATA);
-					case 17: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XY);
-					case 18: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XZ);
-					case 19: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_YZ);
-					case 20: SET_MODAL (MODAL_GROUP_G6, units_mode, INCHES);
-					case 21: SET_MODAL (MODAL_GROUP_G6, units_mode, MILLIMETERS);
-					case 28: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G28_POSITION);
-							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G28_POSITION); 
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SEARCH_HOME); 
-							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_SET_ABSOLUTE_ORIGIN);
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-					case 30: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G30_POSITION);
-							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G30_POSITION); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-/*					case 38: 
-						switch (_point(value)) {
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_STRAIGHT_PROBE); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-*/					case 40: break;	// ignore cancel cutter radius compensation
-					case 49: break;	// ignore cancel tool length offset comp.
-					case 53: SET_NON_MODAL (absolute_override, true);
-					case 54: SET_MODAL (MODAL_GROUP_G12, coord_system, G54);
-					case 55: SET_MODAL (MODAL_GROUP_G12, coord_system, G55);
-					case 56: SET_MODAL (MODAL_GROUP_G12, coord_system, G56);
-					case 57: SET_MODAL (MODAL_GROUP_G12, coord_system, G57);
-					case 58: SET_MODAL (MODAL_GROUP_G12, coord_system, G58);
-					case 59: SET_MODAL (MODAL_GROUP_G12, coord_system, G59);
-					case 61: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_PATH);
-							case 1: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_STOP); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-					case 64: SET_MODAL (MODAL_GROUP_G13,path_control, PATH_CONTINUOUS);
-					case 80: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANCEL_MOTION_MODE);
-					case 90: SET_MODAL (MODAL_GROUP_G3, distance_mode, ABSOLUTE_MODE);
-					case 91: SET_MODAL (MODAL_GROUP_G3, distance_mode, INCREMENTAL_MODE);
-					case 92: {
-						switch (_point(value)) {
-							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_ORIGIN_OFFSETS);
-							case 1: SET_NON_MODAL (next_action, NEXT_ACTION_RESET_ORIGIN_OFFSETS);
-							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS);
-							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_RESUME_ORIGIN_OFFSETS); 
-							default: status = STAT_UNRECOGNIZED_COMMAND;
-						}
-						break;
-					}
-					case 93: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, true);
-					case 94: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, false);
-					default: status = STAT_UNRECOGNIZED_COMMAND;
-				}
-				break;
-
-			case 'M':
-				switch((uint8_t)value) {
-					case 0: case 1: case 60:
-							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_STOP);
-					case 2: case 30:
-							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_END);
-					case 3: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CW);
-					case 4: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CCW);
-					case 5: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_OFF);
-					case 6: SET_NON_MODAL (change_tool, true);
-					case 7: SET_MODAL (MODAL_GROUP_M8, mist_coolant, true);
-					case 8: SET_MODAL (MODAL_GROUP_M8, flood_coolant, true);
-					case 9: SET_MODAL (MODAL_GROUP_M8, flood_coolant, false);
-					case 48: SET_MODAL (MODAL_GROUP_M9, override_enables, true);
-					case 49: SET_MODAL (MODAL_GROUP_M9, override_enables, false);
-					case 50: SET_MODAL (MODAL_GROUP_M9, feed_rate_override_enable, true); // conditionally true
-					case 51: SET_MODAL (MODAL_GROUP_M9, spindle_override_enable, true);	  // conditionally true
-					default: status = STAT_UNRECOGNIZED_COMMAND;
-				}
-				break;
-
-			case 'T': SET_NON_MODAL (tool, (uint8_t)trunc(value));
-			case 'F': SET_NON_MODAL (feed_rate, value);
-			case 'P': SET_NON_MODAL (parameter, value);				// used for dwell time, G10 coord select
-			case 'S': SET_NON_MODAL (spindle_speed, value); 
-			case 'X': SET_NON_MODAL (target[AXIS_X], value);
-			case 'Y': SET_NON_MODAL (target[AXIS_Y], value);
-			case 'Z': SET_NON_MODAL (target[AXIS_Z], value);
-			case 'A': SET_NON_MODAL (target[AXIS_A], value);
-			case 'B': SET_NON_MODAL (target[AXIS_B], value);
-			case 'C': SET_NON_MODAL (target[AXIS_C], value);
-		//	case 'U': SET_NON_MODAL (target[AXIS_U], value);		// reserved
-		//	case 'V': SET_NON_MODAL (target[AXIS_V], value);		// reserved
-		//	case 'W': SET_NON_MODAL (target[AXIS_W], value);		// reserved
-			case 'I': SET_NON_MODAL (arc_offset[0], value);
-			case 'J': SET_NON_MODAL (arc_offset[1], value);
-			case 'K': SET_NON_MODAL (arc_offset[2], value);
-			case 'R': SET_NON_MODAL (arc_radius, value);
-			case 'N': SET_NON_MODAL (linenum,(uint32_t)value);		// line number
-			case 'L': break;										// not used for anything
-			default: status = STAT_UNRECOGNIZED_COMMAND;
-		}
-		if(status != STAT_OK) break;
-	}
-	if ((status != STAT_OK) && (status != STAT_COMPLETE)) return (status);
-	ritorno(_validate_gcode_block());
-	return (_execute_gcode_block());		// if successful execute the block
-}
-
-/*
- * _execute_gcode_block() - execute parsed block
- *
- *  Conditionally (based on whether a flag is set in gf) call the canonical 
- *	machining functions in order of execution as per RS274NGC_3 table 8 
- *  (below, with modifications):
- *
- *	    0. record the line number
- *		1. comment (includes message) [handled during block normalization]
- *		2. set feed rate mode (G93, G94 - inverse time or per minute)
- *		3. set feed rate (F)
- *		3a. set feed override rate (M50.1)
- *		3a. set traverse override rate (M50.2)
- *		4. set spindle speed (S)
- *		4a. set spindle override rate (M51.1)
- *		5. select tool (T)
- *		6. change tool (M6)
- *		7. spindle on or off (M3, M4, M5)
- *		8. coolant on or off (M7, M8, M9)
- *		9. enable or disable overrides (M48, M49, M50, M51)
- *		10. dwell (G4)
- *		11. set active plane (G17, G18, G19)
- *		12. set length units (G20, G21)
- *		13. cutter radius compensation on or off (G40, G41, G42)
- *		14. cutter length compensation on or off (G43, G49)
- *		15. coordinate system selection (G54, G55, G56, G57, G58, G59)
- *		16. set path control mode (G61, G61.1, G64)
- *		17. set distance mode (G90, G91)
- *		18. set retract mode (G98, G99)
- *		19a. homing functions (G28.2, G28.3, G28.1, G28, G30)
- *		19b. change coordinate system data (G10)
- *		19c. set axis offsets (G92, G92.1, G92.2, G92.3)
- *		20. perform motion (G0 to G3, G80-G89) as modified (possibly) by G53
- *		21. stop and end (M0, M1, M2, M30, M60)
- *
- *	Values in gn are in original units and should not be unit converted prior 
- *	to calling the canonical functions (which do the unit conversions)
- */
-
-static stat_t _execute_gcode_block()
-{
-	stat_t status = STAT_OK;
-
-	cm_set_model_linenum(gn.linenum);
-	EXEC_FUNC(cm_set_inverse_feed_rate_mode, inverse_feed_rate_mode);
-	EXEC_FUNC(cm_set_feed_rate, feed_rate);
-	EXEC_FUNC(cm_feed_rate_override_factor, feed_rate_override_factor);
-	EXEC_FUNC(cm_traverse_override_factor, traverse_override_factor);
-	EXEC_FUNC(cm_set_spindle_speed, spindle_speed);
-	EXEC_FUNC(cm_spindle_override_factor, spindle_override_factor);
-	EXEC_FUNC(cm_select_tool, tool);
-	EXEC_FUNC(cm_change_tool, tool);
-	EXEC_FUNC(cm_spindle_control, spindle_mode); 	// spindle on or off
-	EXEC_FUNC(cm_mist_coolant_control, mist_coolant); 
-	EXEC_FUNC(cm_flood_coolant_control, flood_coolant);	// also disables mist coolant if OFF 
-	EXEC_FUNC(cm_feed_rate_override_enable, feed_rate_override_enable);
-	EXEC_FUNC(cm_traverse_override_enable, traverse_override_enable);
-	EXEC_FUNC(cm_spindle_override_enable, spindle_override_enable);
-	EXEC_FUNC(cm_override_enables, override_enables);
-
-	if (gn.next_action == NEXT_ACTION_DWELL) { 		// G4 - dwell
-		ritorno(cm_dwell(gn.parameter));			// return if error, otherwise complete the block
-	}
-	EXEC_FUNC(cm_select_plane, select_plane);
-	EXEC_FUNC(cm_set_units_mode, units_mode);
-	//--> cutter radius compensation goes here
-	//--> cutter length compensation goes here
-	EXEC_FUNC(cm_set_coord_system, coord_system);
-	EXEC_FUNC(cm_set_path_control, path_control);
-	EXEC_FUNC(cm_set_distance_mode, distance_mode);
-	//--> set retract mode goes here
-
-	switch (gn.next_action) {
-		case NEXT_ACTION_SEARCH_HOME: { status = cm_homing_cycle_start(); break;}								// G28.2
-//		case NEXT_ACTION_STRAIGHT_PROBE: { status = cm_probe_cycle_start(); break;}
-		case NEXT_ACTION_SET_ABSOLUTE_ORIGIN: { status = cm_set_absolute_origin(gn.target, gf.target); break;}	// G28.3
-		case NEXT_ACTION_SET_G28_POSITION: { status = cm_set_g28_position(); break;}							// G28.1
-		case NEXT_ACTION_GOTO_G28_POSITION: { status = cm_goto_g28_position(gn.target, gf.target); break;}		// G28
-		case NEXT_ACTION_SET_G30_POSITION: { status = cm_set_g30_position(); break;}							// G30.1
-		case NEXT_ACTION_GOTO_G30_POSITION: { status = cm_goto_g30_position(gn.target, gf.target); break;}		// G30	
-
-		case NEXT_ACTION_SET_COORD_DATA: { status = cm_set_coord_offsets(gn.parameter, gn.target, gf.target); break;}
-		case NEXT_ACTION_SET_ORIGIN_OFFSETS: { status = cm_set_origin_offsets(gn.target, gf.target); break;}
-		case NEXT_ACTION_RESET_ORIGIN_OFFSETS: { status = cm_reset_origin_offsets(); break;}
-		case NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS: { status = cm_suspend_origin_offsets(); break;}
-		case NEXT_ACTION_RESUME_ORIGIN_OFFSETS: { status = cm_resume_origin_offsets(); break;}
-
-		case NEXT_ACTION_DEFAULT: { 
-			cm_set_absolute_override(gn.absolute_override);	// apply override setting to gm struct
-			switch (gn.motion_mode) {
-				case MOTION_MODE_CANCEL_MOTION_MODE: { gm.motion_mode = gn.motion_mode; break;}
-				case MOTION_MODE_STRAIGHT_TRAVERSE: { status = cm_straight_traverse(gn.target, gf.target); break;}
-				case MOTION_MODE_STRAIGHT_FEED: { status = cm_straight_feed(gn.target, gf.target); break;}
-				case MOTION_MODE_CW_ARC: case MOTION_MODE_CCW_ARC:
-					// gf.radius sets radius mode if radius was collected in gn
-					{ status = cm_arc_feed(gn.target, gf.target, gn.arc_offset[0], gn.arc_offset[1],
-								gn.arc_offset[2], gn.arc_radius, gn.motion_mode); break;}
-			}
-		}
-	}
-	cm_set_absolute_override(false);		// un-set abs overrride (for reporting purposes) 
-
-	// do the M stops: M0, M1, M2, M30, M60
-	if (gf.program_flow == true) {
-		if (gn.program_flow == PROGRAM_STOP) { cm_program_stop(); } 
-		else { cm_program_end(); }
-	}
-	return (status);
-}
-
+/*
+ * gcode_interpreter.c - rs274/ngc Gcode parser.
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010-2013 Alden S. Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* See http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>					// needed for memcpy, memset
+#include <avr/pgmspace.h>			// precursor for xio.h
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "planner.h"				// for PLANNER_BUFFER_HEADROOM (blocks-per-line cap)
+#include "report.h"					// for the status report dirty marks
+#include "xio/xio.h"				// for char definitions
+
+struct gcodeParserSingleton {	 	  // struct to manage globals
+	uint32_t modal_mask;			  // one bit per modal group seen in this block
+	uint32_t modal_conflict;		  // bits for groups seen more than once (an error)
+	uint8_t state_words;			  // counts words that change modal or settings state
+									  // (gates the settings chain in _execute_gcode_block)
+}; struct gcodeParserSingleton gp;
+
+// local helper functions and macros
+static void _normalize_gcode_block(char_t *cmd, char_t **next, char_t **com, char_t **msg, uint8_t *block_delete_flag);
+static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value);
+static stat_t _point(float value);
+static stat_t _validate_gcode_block(void);
+static stat_t _parse_gcode_block(char_t *line);	// Parse the block into the GN/GF structs
+static stat_t _execute_gcode_block(void);		// Execute the gcode block
+
+#define MODAL_BIT(m) ((uint32_t)1 << (m))
+#define SET_MODAL(m,parm,val) ({gn.parm=val; gf.parm=1; \
+								gp.modal_conflict |= (gp.modal_mask & MODAL_BIT(m)); \
+								gp.modal_mask |= MODAL_BIT(m); gp.state_words+=1; break;})
+#define SET_NON_MODAL(parm,val) ({gn.parm=val; gf.parm=1; break;})
+#define SET_STATE(parm,val) ({gn.parm=val; gf.parm=1; gp.state_words+=1; break;})	// non-modal, but changes settings state
+#define EXEC_FUNC(f,v) if((uint8_t)gf.v != false) { status = f(gn.v);}
+
+/* Gcode word dispatch table
+ *
+ *	Words are routed by a single indexed load from this table instead of a
+ *	compare chain over the letters. The high nibble is the word class, the
+ *	low nibble carries the gn.target[] / gn.arc_offset[] index for axis and
+ *	offset words, or a selector for the singleton value words. The G and M
+ *	word bodies stay as switches - their setters touch heterogeneous modal
+ *	state that doesn't reduce to a table, and they appear once per block
+ *	where the axis words dominate short-line jobs.
+ */
+enum gpWordClass {
+	WORD_CLASS_NONE = 0,			// letter is not a legal gcode word
+	WORD_CLASS_G,					// G word - see G switch
+	WORD_CLASS_M,					// M word - see M switch
+	WORD_CLASS_TARGET,				// X Y Z A B C - value goes to gn.target[index]
+	WORD_CLASS_OFFSET,				// I J K - value goes to gn.arc_offset[index]
+	WORD_CLASS_VALUE				// T F P S R N L singleton values
+};
+
+enum gpValueWord {					// low-nibble selectors for WORD_CLASS_VALUE
+	VALUE_WORD_F = 0, VALUE_WORD_P, VALUE_WORD_S, VALUE_WORD_T,
+	VALUE_WORD_R, VALUE_WORD_N, VALUE_WORD_L, VALUE_WORD_Q
+};
+
+#define WORD(class,index) (((class)<<4) | (index))
+
+static const uint8_t _word_dispatch[] PROGMEM = {	// indexed by letter - 'A'
+#if (AXES >= 4)
+	WORD(WORD_CLASS_TARGET, AXIS_A),	// A
+#else
+	WORD(WORD_CLASS_NONE, 0),			// A - axis not compiled in (see AXES in tinyg.h)
+#endif
+#if (AXES >= 6)
+	WORD(WORD_CLASS_TARGET, AXIS_B),	// B
+	WORD(WORD_CLASS_TARGET, AXIS_C),	// C
+#else
+	WORD(WORD_CLASS_NONE, 0),			// B - axis not compiled in
+	WORD(WORD_CLASS_NONE, 0),			// C - axis not compiled in
+#endif
+	WORD(WORD_CLASS_NONE, 0),			// D
+	WORD(WORD_CLASS_NONE, 0),			// E
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_F),// F
+	WORD(WORD_CLASS_G, 0),				// G
+	WORD(WORD_CLASS_NONE, 0),			// H
+	WORD(WORD_CLASS_OFFSET, 0),			// I
+	WORD(WORD_CLASS_OFFSET, 1),			// J
+	WORD(WORD_CLASS_OFFSET, 2),			// K
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_L),// L
+	WORD(WORD_CLASS_M, 0),				// M
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_N),// N
+	WORD(WORD_CLASS_NONE, 0),			// O
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_P),// P
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_Q),// Q
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_R),// R
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_S),// S
+	WORD(WORD_CLASS_VALUE, VALUE_WORD_T),// T
+	WORD(WORD_CLASS_NONE, 0),			// U (reserved for target[AXIS_U])
+	WORD(WORD_CLASS_NONE, 0),			// V (reserved for target[AXIS_V])
+	WORD(WORD_CLASS_NONE, 0),			// W (reserved for target[AXIS_W])
+	WORD(WORD_CLASS_TARGET, AXIS_X),	// X
+	WORD(WORD_CLASS_TARGET, AXIS_Y),	// Y
+	WORD(WORD_CLASS_TARGET, AXIS_Z)		// Z
+};
+
+/*
+ * gc_gcode_parser() - parse a line of gcode - one or more blocks
+ *
+ *	Top level of gcode parser. Normalizes blocks and looks for special cases.
+ *
+ *	A physical line may carry multiple blocks separated by '|', e.g.
+ *	"g1x10|y10|x0|y0". Each block is normalized and executed in turn and the
+ *	line gets a single aggregate response, so the CR/LF framing, checksum and
+ *	ack round trip are paid once per line instead of once per block - for
+ *	short-line jobs this amortizes dispatch overhead across 4-8 moves.
+ *	(';' could not be the separator - it already introduces a comment.)
+ *
+ *	An error in any block stops the line there and is returned as the line's
+ *	status; blocks before it have already executed, blocks after it are
+ *	dropped, which is the same contract as a stream of single-block lines.
+ *	Blocks per line are capped at PLANNER_BUFFER_HEADROOM - the controller
+ *	guarantees that many free planner buffers before dispatching a line, so
+ *	a full batch can never exhaust the queue mid-line.
+ */
+
+stat_t gc_gcode_parser(char_t *block)
+{
+	char_t *cmd = block;					// gcode command or NUL string
+	stat_t status = STAT_NOOP;				// NOOP if every block is deleted
+	uint8_t blocks = 0;
+
+	while (cmd != NULL) {
+		char_t none = NUL;
+		char_t *com = &none;				// gcode comment or NUL string
+		char_t *msg = &none;				// gcode message or NUL string
+		char_t *next = NULL;				// next block if the line carries more than one
+		uint8_t block_delete_flag;
+
+		if (++blocks > PLANNER_BUFFER_HEADROOM) { return (STAT_INPUT_EXCEEDS_MAX_LENGTH);}
+		_normalize_gcode_block(cmd, &next, &com, &msg, &block_delete_flag);
+
+		if ((block_delete_flag == true) && (cm_get_block_delete_switch() == true)) {
+			cmd = next;
+			continue;
+		}
+//		if (*msg != NUL) { // +++++ THIS HAS A SERIOUS BUG IN IT SO FOR NOW IT'S DISABLED
+//			(void)cm_message(msg);			// queue the message
+//		}
+		if ((status = _parse_gcode_block(cmd)) != STAT_OK) { return (status);}
+		cmd = next;
+	}
+	return (status);
+}
+
+/*
+ * _normalize_gcode_block() - normalize a block (line) of gcode in place
+ *
+ *	Normalization functions:
+ *   - convert all letters to upper case
+ *	 - remove white space, control and other invalid characters
+ *	 - identify and return start of comments and messages
+ *	 - signal if a block-delete character (/) was encountered in the first space
+ *	 - stop at a '|' block separator and return the start of the next block
+ *	   (a comment still terminates the whole line - '|' inside one is text)
+ *
+ *	So this: "  g1 x100 Y100 f400" becomes this: "G1X100Y100F400"
+ *
+ *	The command is normalized in a single read/write pass over the line.
+ *	Leading zeros used to be stripped here to keep strtod() from reading
+ *	them as Octal; read_float() is a fixed-format decimal scanner so the
+ *	extra traversal is no longer needed (the G0X-as-hex case is still
+ *	trapped in _get_next_gcode_word()).
+ *
+ *	Comment and message handling:
+ *	 - Comments field start with a '(' char or alternately a semicolon ';' 
+ *	 - Comments and messages are not normalized - they are left alone
+ *	 - The 'MSG' specifier in comment can have mixed case but cannot cannot have embedded white spaces
+ *	 - Normalization returns true if there was a message to display, false otherwise
+ *	 - Comments always terminate the block - i.e. leading or embedded comments are not supported
+ *	 	- Valid cases (examples)			Notes:
+ *		    G0X10							 - command only - no comment
+ *		    (comment text)                   - There is no command on this line
+ *		    G0X10 (comment text)
+ *		    G0X10 (comment text				 - It's OK to drop the trailing paren
+ *		    G0X10 ;comment text				 - It's OK to drop the trailing paren
+ *
+ *	 	- Invalid cases (examples)			Notes:
+ *		    G0X10 comment text				 - Comment with no separator
+ *		    N10 (comment) G0X10 			 - embedded comment. G0X10 will be ignored
+ *		    (comment) G0X10 				 - leading comment. G0X10 will be ignored
+ * 			G0X10 # comment					 - invalid separator
+ *
+ *	Returns:
+ *	 - com points to comment string or to NUL if no comment
+ *	 - msg points to message string or to NUL if no comment
+ *	 - block_delete_flag is set true if block delete encountered, false otherwise
+ */
+static void _normalize_gcode_block(char_t *cmd, char_t **next, char_t **com, char_t **msg, uint8_t *block_delete_flag)
+{
+	char_t *rd = cmd;				// read pointer
+	char_t *wr = cmd;				// write pointer
+
+	// Preset comments and messages to NUL string
+	// Not required if com and msg already point to NUL on entry
+//	for (rd = cmd; *rd != NUL; rd++) { if (*rd == NUL) { *com = rd; *msg = rd; rd = cmd;} }
+
+	// mark block deletes
+	if (*rd == '/') { *block_delete_flag = true; }
+	else { *block_delete_flag = false; }
+
+	// normalize the command block & find the comment (if any) - single pass
+	for (; *rd != NUL; rd++) {
+		if (*rd == '|') { *next = rd+1; break; }	// block separator - the rest of the line is more blocks
+		if ((*rd == '(') || (*rd == ';')) { *com = rd+1; break; }
+		if ((isalnum((char)*rd)) || (strchr("-.", *rd))) { // all valid characters
+			*(wr++) = (char_t)toupper((char)*(rd));
+		}
+	}
+	*wr = NUL;											// terminate the command
+
+	// process comments and messages
+	if (**com != NUL) {
+		rd = *com;
+		while (isspace(*rd)) { rd++; }		// skip any leading spaces before "msg"
+		if ((tolower(*rd) == 'm') && (tolower(*(rd+1)) == 's') && (tolower(*(rd+2)) == 'g')) {
+			*msg = rd+3;
+		}
+		for (; *rd != NUL; rd++) {	
+			if (*rd == ')') *rd = NUL;		// NUL terminate on trailing parenthesis, if any
+		}
+	}
+}
+
+/*
+ * _get_next_gcode_word() - get gcode word consisting of a letter and a value
+ *
+ *	This function requires the Gcode string to be normalized.
+ *	Normalization must remove any leading zeros or they will be converted to Octal
+ *	G0X... is not interpreted as hexadecimal. This is trapped.
+ */
+static stat_t _get_next_gcode_word(char **pstr, char *letter, float *value) 
+{
+	if (**pstr == NUL) { return (STAT_COMPLETE); }	// no more words
+
+	// get letter part
+	if(isupper(**pstr) == false) { return (STAT_EXPECTED_COMMAND_LETTER); }
+	*letter = **pstr;
+	(*pstr)++;
+	
+	// X-axis-becomes-a-hexadecimal-number get-value case, e.g. G0X100 --> G255
+	if ((**pstr == '0') && (*(*pstr+1) == 'X')) {
+		*value = 0;
+		(*pstr)++;
+		return (STAT_OK);		// pointer points to X
+	}
+
+	// get-value general case (see read_float() in util.c - fixed format, no strtod)
+	if (read_float(pstr, value) == false) { return(STAT_BAD_NUMBER_FORMAT); }
+	return (STAT_OK);			// pointer points to next character after the word
+}
+
+/*
+ * _point() - isolate the decimal point value as an integer
+ */
+static uint8_t _point(float value) { return((uint8_t)(value*10 - trunc(value)*10));}
+
+/*
+ * _validate_gcode_block() - check for some gross Gcode block semantic violations
+ *
+ *	The checks reduce to mask tests: SET_MODAL() collects the modal groups seen
+ *	in the block as bits in gp.modal_mask and latches any group seen twice into
+ *	gp.modal_conflict, and the axis word-using group 0 codes are one bit-test
+ *	over the parsed next_action. No chained compares per block.
+ *
+ *	Two deliberate departures from strict NIST for CAM compatibility:
+ *	  - G80 is exempted from group 1 conflict detection. The standard safety
+ *		block many posts emit (e.g. N1 G00 G17 G21 G40 G49 G80 G90) pairs it
+ *		with G0, and rejecting that block would silently drop the G21.
+ *	  - The "all axis words omitted" errors from the NIST G0/G1/G2/G3
+ *		descriptions are not enforced - bare motion codes are ubiquitous in
+ *		preamble lines, and a full-circle arc carries offset words only.
+ */
+
+// group 0 codes that use axis words - G10, G28, G30 and G92 (as a next_action bit set)
+#define AXIS_WORD_G0_ACTIONS (((uint16_t)1 << NEXT_ACTION_SET_COORD_DATA) | \
+							  ((uint16_t)1 << NEXT_ACTION_GOTO_G28_POSITION) | \
+							  ((uint16_t)1 << NEXT_ACTION_GOTO_G30_POSITION) | \
+							  ((uint16_t)1 << NEXT_ACTION_SET_ORIGIN_OFFSETS))
+
+static stat_t _validate_gcode_block()
+{
+	// From NIST, section 3.4: "It is an error to put two G-codes from the same modal
+	// group on the same line" (ditto for M-codes)
+	if (gp.modal_conflict != 0) {
+		return (STAT_MODAL_GROUP_VIOLATION);
+	}
+
+	//	Also from NIST, section 3.4 "It is an error to put a G-code from group 1 and
+	//	a G-code from group 0 on the same line if both of them use axis words. [...]
+	//	The axis word-using G-codes from group 0 are G10, G28, G30, and G92".
+	//	Every group 1 code but G80 uses axis words.
+	if (((gp.modal_mask & (MODAL_BIT(MODAL_GROUP_G0) | MODAL_BIT(MODAL_GROUP_G1))) ==
+						  (MODAL_BIT(MODAL_GROUP_G0) | MODAL_BIT(MODAL_GROUP_G1))) &&
+		(gn.motion_mode != MOTION_MODE_CANCEL_MOTION_MODE) &&
+		((AXIS_WORD_G0_ACTIONS & ((uint16_t)1 << gn.next_action)) != 0)) {
+		return (STAT_MODAL_GROUP_VIOLATION);
+	}
+	return (STAT_OK);
+}
+
+/*
+ * _parse_gcode_block() - parses one line of NULL terminated G-Code. 
+ *
+ *	All the parser does is load the state values in gn (next model state) and set flags
+ *	in gf (model state flags). The execute routine applies them. The buffer is assumed to 
+ *	contain only uppercase characters and signed floats (no whitespace).
+ *
+ *	A number of implicit things happen when the gn struct is zeroed:
+ *	  - inverse feed rate mode is cancelled - set back to units_per_minute mode
+ */
+static stat_t _parse_gcode_block(char_t *buf) 
+{
+	char *pstr = (char *)buf;		// persistent pointer into gcode block for parsing words
+  	char letter;					// parsed letter, eg.g. G or X or Y
+	float value = 0;				// value parsed from letter (e.g. 2 for G2)
+	stat_t status = STAT_OK;
+
+	// set initial state for new move 
+	memset(&gp, 0, sizeof(gp));		// clear all parser values
+	memset(&gf, 0, sizeof(gf));		// clear all next-state flags
+	memset(&gn, 0, sizeof(gn));		// clear all next-state values
+	gn.motion_mode = cm_get_model_motion_mode();// get motion mode from previous block
+
+  	// extract commands and parameters
+	while((status = _get_next_gcode_word(&pstr, &letter, &value)) == STAT_OK) {
+		uint8_t word = pgm_read_byte(&_word_dispatch[letter - 'A']); // letter is known to be upper case
+		switch(word >> 4) {
+			case WORD_CLASS_G:
+				switch((uint8_t)value) {
+					case 0:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_TRAVERSE);
+					case 1:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_STRAIGHT_FEED);
+					case 2:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CW_ARC);
+					case 3:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CCW_ARC);
+					case 4:  SET_NON_MODAL (next_action, NEXT_ACTION_DWELL);
+					case 5:  SET_MODAL (MODAL_GROUP_G1, motion_mode, MOTION_MODE_CUBIC_SPLINE);
+					case 10: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_COORD_DATA);
+					case 17: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XY);
+					case 18: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_XZ);
+					case 19: SET_MODAL (MODAL_GROUP_G2, select_plane, CANON_PLANE_YZ);
+					case 20: SET_MODAL (MODAL_GROUP_G6, units_mode, INCHES);
+					case 21: SET_MODAL (MODAL_GROUP_G6, units_mode, MILLIMETERS);
+					case 28: {
+						switch (_point(value)) {
+							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G28_POSITION);
+							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G28_POSITION); 
+							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SEARCH_HOME); 
+							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_SET_ABSOLUTE_ORIGIN);
+							default: status = STAT_UNRECOGNIZED_COMMAND;
+						}
+						break;
+					}
+					case 30: {
+						switch (_point(value)) {
+							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_GOTO_G30_POSITION);
+							case 1: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_G30_POSITION); 
+							default: status = STAT_UNRECOGNIZED_COMMAND;
+						}
+						break;
+					}
+/*					case 38: 
+						switch (_point(value)) {
+							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_STRAIGHT_PROBE); 
+							default: status = STAT_UNRECOGNIZED_COMMAND;
+						}
+						break;
+					}
+*/					case 40: break;	// ignore cancel cutter radius compensation
+					case 49: break;	// ignore cancel tool length offset comp.
+					case 53: SET_NON_MODAL (absolute_override, true);
+					case 54: SET_MODAL (MODAL_GROUP_G12, coord_system, G54);
+					case 55: SET_MODAL (MODAL_GROUP_G12, coord_system, G55);
+					case 56: SET_MODAL (MODAL_GROUP_G12, coord_system, G56);
+					case 57: SET_MODAL (MODAL_GROUP_G12, coord_system, G57);
+					case 58: SET_MODAL (MODAL_GROUP_G12, coord_system, G58);
+					case 59: SET_MODAL (MODAL_GROUP_G12, coord_system, G59);
+					case 61: {
+						switch (_point(value)) {
+							case 0: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_PATH);
+							case 1: SET_MODAL (MODAL_GROUP_G13, path_control, PATH_EXACT_STOP); 
+							default: status = STAT_UNRECOGNIZED_COMMAND;
+						}
+						break;
+					}
+					case 64: SET_MODAL (MODAL_GROUP_G13,path_control, PATH_CONTINUOUS);
+					case 80: SET_STATE (motion_mode,  MOTION_MODE_CANCEL_MOTION_MODE);	// see note in _validate_gcode_block
+					case 81: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_81);
+					case 82: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_82);
+					case 83: SET_MODAL (MODAL_GROUP_G1, motion_mode,  MOTION_MODE_CANNED_CYCLE_83);
+					case 90: SET_MODAL (MODAL_GROUP_G3, distance_mode, ABSOLUTE_MODE);
+					case 91: SET_MODAL (MODAL_GROUP_G3, distance_mode, INCREMENTAL_MODE);
+					case 92: {
+						switch (_point(value)) {
+							case 0: SET_MODAL (MODAL_GROUP_G0, next_action, NEXT_ACTION_SET_ORIGIN_OFFSETS);
+							case 1: SET_NON_MODAL (next_action, NEXT_ACTION_RESET_ORIGIN_OFFSETS);
+							case 2: SET_NON_MODAL (next_action, NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS);
+							case 3: SET_NON_MODAL (next_action, NEXT_ACTION_RESUME_ORIGIN_OFFSETS); 
+							default: status = STAT_UNRECOGNIZED_COMMAND;
+						}
+						break;
+					}
+					case 93: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, true);
+					case 94: SET_MODAL (MODAL_GROUP_G5, inverse_feed_rate_mode, false);
+					case 98: SET_MODAL (MODAL_GROUP_G9, retract_mode, RETRACT_TO_PREVIOUS);
+					case 99: SET_MODAL (MODAL_GROUP_G9, retract_mode, RETRACT_TO_R);
+					default: status = STAT_UNRECOGNIZED_COMMAND;
+				}
+				break;
+
+			case WORD_CLASS_M:
+				switch((uint8_t)value) {
+					case 0: case 1: case 60:
+							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_STOP);
+					case 2: case 30:
+							SET_MODAL (MODAL_GROUP_M4, program_flow, PROGRAM_END);
+					case 3: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CW);
+					case 4: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_CCW);
+					case 5: SET_MODAL (MODAL_GROUP_M7, spindle_mode, SPINDLE_OFF);
+					case 6: SET_STATE (change_tool, true);
+					case 7: SET_MODAL (MODAL_GROUP_M8, mist_coolant, true);
+					case 8: SET_MODAL (MODAL_GROUP_M8, flood_coolant, true);
+					case 9: SET_MODAL (MODAL_GROUP_M8, flood_coolant, false);
+					case 62: SET_STATE (sync_output, true);
+					case 63: SET_STATE (sync_output, false);
+					case 98: SET_NON_MODAL (call_subprogram, true);	// P selects the stored job, L repeats
+					case 48: SET_MODAL (MODAL_GROUP_M9, override_enables, true);
+					case 49: SET_MODAL (MODAL_GROUP_M9, override_enables, false);
+					case 50: SET_MODAL (MODAL_GROUP_M9, feed_rate_override_enable, true); // conditionally true
+					case 51: SET_MODAL (MODAL_GROUP_M9, spindle_override_enable, true);	  // conditionally true
+					default: status = STAT_UNRECOGNIZED_COMMAND;
+				}
+				break;
+
+			case WORD_CLASS_TARGET: SET_NON_MODAL (target[word & 0x0F], value);
+			case WORD_CLASS_OFFSET: SET_NON_MODAL (arc_offset[word & 0x0F], value);
+
+			case WORD_CLASS_VALUE:
+				switch(word & 0x0F) {
+					case VALUE_WORD_F: SET_STATE (feed_rate, value);
+					case VALUE_WORD_P: SET_NON_MODAL (parameter, value);			// used for dwell time, G10 coord select
+					case VALUE_WORD_S: SET_STATE (spindle_speed, value);
+					case VALUE_WORD_T: SET_STATE (tool, (uint8_t)trunc(value));
+					case VALUE_WORD_R: SET_NON_MODAL (arc_radius, value);
+					case VALUE_WORD_N: SET_NON_MODAL (linenum,(uint32_t)value);		// line number
+					case VALUE_WORD_L: SET_NON_MODAL (l_word, (uint16_t)trunc(value));	// M98 repeat count
+					case VALUE_WORD_Q: SET_NON_MODAL (parameter_q, value);		// G83 peck increment
+				}
+				break;
+
+			default: status = STAT_UNRECOGNIZED_COMMAND;
+		}
+		if(status != STAT_OK) break;
+	}
+	if ((status != STAT_OK) && (status != STAT_COMPLETE)) return (status);
+	ritorno(_validate_gcode_block());
+	return (_execute_gcode_block());		// if successful execute the block
+}
+
+/*
+ * _execute_gcode_block() - execute parsed block
+ *
+ *  Conditionally (based on whether a flag is set in gf) call the canonical 
+ *	machining functions in order of execution as per RS274NGC_3 table 8 
+ *  (below, with modifications):
+ *
+ *	    0. record the line number
+ *		1. comment (includes message) [handled during block normalization]
+ *		2. set feed rate mode (G93, G94 - inverse time or per minute)
+ *		3. set feed rate (F)
+ *		3a. set feed override rate (M50.1)
+ *		3a. set traverse override rate (M50.2)
+ *		4. set spindle speed (S)
+ *		4a. set spindle override rate (M51.1)
+ *		5. select tool (T)
+ *		6. change tool (M6)
+ *		7. spindle on or off (M3, M4, M5)
+ *		8. coolant on or off (M7, M8, M9)
+ *		8a. set synchronized output (M62, M63) - switched with the next motion
+ *		9. enable or disable overrides (M48, M49, M50, M51)
+ *		10. dwell (G4)
+ *		11. set active plane (G17, G18, G19)
+ *		12. set length units (G20, G21)
+ *		13. cutter radius compensation on or off (G40, G41, G42)
+ *		14. cutter length compensation on or off (G43, G49)
+ *		15. coordinate system selection (G54, G55, G56, G57, G58, G59)
+ *		16. set path control mode (G61, G61.1, G64)
+ *		17. set distance mode (G90, G91)
+ *		18. set retract mode (G98, G99)
+ *		19a. homing functions (G28.2, G28.3, G28.1, G28, G30)
+ *		19b. change coordinate system data (G10)
+ *		19c. set axis offsets (G92, G92.1, G92.2, G92.3)
+ *		20. perform motion (G0 to G3, G80-G89) as modified (possibly) by G53
+ *		21. stop and end (M0, M1, M2, M30, M60)
+ *
+ *	Values in gn are in original units and should not be unit converted prior
+ *	to calling the canonical functions (which do the unit conversions)
+ *
+ *	The settings chain (steps 2 - 18 above) is skipped entirely when the block
+ *	contained no modal or settings words (see gp.state_words). Almost all
+ *	blocks in a typical file are pure motion - axis words and maybe a line
+ *	number - and for these only the motion step runs.
+ */
+
+static stat_t _execute_gcode_block()
+{
+	stat_t status = STAT_OK;
+
+	cm_set_model_linenum(gn.linenum);
+
+	if ((gp.state_words != 0) || (gn.next_action != NEXT_ACTION_DEFAULT)) {
+		rpt_mark_sr_dirty(SR_DIRTY_MODEL_bm);	// model state is about to change
+		EXEC_FUNC(cm_set_inverse_feed_rate_mode, inverse_feed_rate_mode);
+		EXEC_FUNC(cm_set_feed_rate, feed_rate);
+		EXEC_FUNC(cm_feed_rate_override_factor, feed_rate_override_factor);
+		EXEC_FUNC(cm_traverse_override_factor, traverse_override_factor);
+		EXEC_FUNC(cm_set_spindle_speed, spindle_speed);
+		EXEC_FUNC(cm_spindle_override_factor, spindle_override_factor);
+		EXEC_FUNC(cm_select_tool, tool);
+		EXEC_FUNC(cm_change_tool, tool);
+		EXEC_FUNC(cm_spindle_control, spindle_mode); 	// spindle on or off
+		EXEC_FUNC(cm_mist_coolant_control, mist_coolant);
+		EXEC_FUNC(cm_flood_coolant_control, flood_coolant);	// also disables mist coolant if OFF
+		if (gf.sync_output == true) {					// M62, M63 - P word selects the output
+			ritorno(cm_sync_output((uint8_t)gn.parameter, gn.sync_output));
+		}
+		EXEC_FUNC(cm_feed_rate_override_enable, feed_rate_override_enable);
+		EXEC_FUNC(cm_traverse_override_enable, traverse_override_enable);
+		EXEC_FUNC(cm_spindle_override_enable, spindle_override_enable);
+		EXEC_FUNC(cm_override_enables, override_enables);
+
+		if (gn.next_action == NEXT_ACTION_DWELL) { 		// G4 - dwell
+			ritorno(cm_dwell(gn.parameter));			// return if error, otherwise complete the block
+		}
+		EXEC_FUNC(cm_select_plane, select_plane);
+		EXEC_FUNC(cm_set_units_mode, units_mode);
+		//--> cutter radius compensation goes here
+		//--> cutter length compensation goes here
+		EXEC_FUNC(cm_set_coord_system, coord_system);
+		if ((uint8_t)gf.path_control != false) {	// G61, G61.1, G64 [Pn] - P is the blend tolerance
+			status = cm_set_path_control(gn.path_control,
+					 (((uint8_t)gf.parameter != false) && (gn.path_control == PATH_CONTINUOUS)) ? gn.parameter : 0);
+		}
+		EXEC_FUNC(cm_set_distance_mode, distance_mode);
+		EXEC_FUNC(cm_set_retract_mode, retract_mode);
+	}
+
+	switch (gn.next_action) {
+		case NEXT_ACTION_SEARCH_HOME: { status = cm_homing_cycle_start(); break;}								// G28.2
+		case NEXT_ACTION_STRAIGHT_PROBE: { status = cm_probe_cycle_start(); break;}							// G38.2
+		case NEXT_ACTION_SET_ABSOLUTE_ORIGIN: { status = cm_set_absolute_origin(gn.target, gf.target); break;}	// G28.3
+		case NEXT_ACTION_SET_G28_POSITION: { status = cm_set_g28_position(); break;}							// G28.1
+		case NEXT_ACTION_GOTO_G28_POSITION: { status = cm_goto_g28_position(gn.target, gf.target); break;}		// G28
+		case NEXT_ACTION_SET_G30_POSITION: { status = cm_set_g30_position(); break;}							// G30.1
+		case NEXT_ACTION_GOTO_G30_POSITION: { status = cm_goto_g30_position(gn.target, gf.target); break;}		// G30	
+
+		case NEXT_ACTION_SET_COORD_DATA: { status = cm_set_coord_offsets(gn.parameter, gn.target, gf.target); break;}
+		case NEXT_ACTION_SET_ORIGIN_OFFSETS: { status = cm_set_origin_offsets(gn.target, gf.target); break;}
+		case NEXT_ACTION_RESET_ORIGIN_OFFSETS: { status = cm_reset_origin_offsets(); break;}
+		case NEXT_ACTION_SUSPEND_ORIGIN_OFFSETS: { status = cm_suspend_origin_offsets(); break;}
+		case NEXT_ACTION_RESUME_ORIGIN_OFFSETS: { status = cm_resume_origin_offsets(); break;}
+
+		case NEXT_ACTION_DEFAULT: { 
+			cm_set_absolute_override(gn.absolute_override);	// apply override setting to gm struct
+			switch (gn.motion_mode) {
+				case MOTION_MODE_CANCEL_MOTION_MODE: { gm.motion_mode = gn.motion_mode; cm_drill_reset(); break;}
+				case MOTION_MODE_STRAIGHT_TRAVERSE: { status = cm_straight_traverse(gn.target, gf.target); break;}
+				case MOTION_MODE_STRAIGHT_FEED: { status = cm_straight_feed(gn.target, gf.target); break;}
+				case MOTION_MODE_CW_ARC: case MOTION_MODE_CCW_ARC:
+					// gf.radius sets radius mode if radius was collected in gn
+					{ status = cm_arc_feed(gn.target, gf.target, gn.arc_offset[0], gn.arc_offset[1],
+								gn.arc_offset[2], gn.arc_radius, gn.motion_mode); break;}
+				case MOTION_MODE_CUBIC_SPLINE:
+					// I,J are the first control point offset; P,Q the second. All four are required
+					{ if (((uint8_t)gf.arc_offset[0] == false) || ((uint8_t)gf.arc_offset[1] == false) ||
+						  ((uint8_t)gf.parameter == false) || ((uint8_t)gf.parameter_q == false) ) {
+						status = STAT_ARC_SPECIFICATION_ERROR; break;
+					  }
+					  status = cm_spline_feed(gn.target, gf.target, gn.arc_offset[0], gn.arc_offset[1],
+								gn.parameter, gn.parameter_q); break;}
+				case MOTION_MODE_CANNED_CYCLE_81: case MOTION_MODE_CANNED_CYCLE_82:
+				case MOTION_MODE_CANNED_CYCLE_83:
+					{ status = cm_drill_cycle_start(gn.motion_mode, gn.target, gf.target); break;}
+			}
+		}
+	}
+	cm_set_absolute_override(false);		// un-set abs overrride (for reporting purposes) 
+
+	// do the M stops: M0, M1, M2, M30, M60
+	if (gf.program_flow == true) {
+		if (gn.program_flow == PROGRAM_STOP) { cm_program_stop(); }
+		else { cm_program_end(); }
+	}
+
+	// M98 - call a stored subprogram after the rest of the block has executed
+	if (gf.call_subprogram == true) {
+		if ((uint8_t)gf.parameter == false) { return (STAT_GCODE_INPUT_ERROR);}	// P word is required
+		if (status == STAT_OK) {
+			status = cm_call_subprogram((uint16_t)gn.parameter, (gf.l_word == true) ? gn.l_word : 1);
+		}
+	}
+
+	// M6 - run the stored tool change macro, if one exists, after the block
+	if ((gf.change_tool == true) && (status == STAT_OK)) {
+		status = cm_tool_change_macro(gn.tool);
+	}
+	return (status);
+}
+
+
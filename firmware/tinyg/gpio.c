@@ -68,7 +68,10 @@
 #include "system.h"							// gpio port bits are mapped here
 #include "gpio.h"
 #include "canonical_machine.h"
+#include "planner.h"						// needed for encoder position compares
+#include "stepper.h"						// needed for st_kill_motors()
 #include "xio/xio.h"						// signals
+#include "xmega/xmega_rtc.h"				// encoder sample timing
 
 /*
  * variables and settings 
@@ -78,6 +81,7 @@
 #define SW_DEGLITCH_TICKS 3					// 3=30ms
 
 static void _isr_helper(uint8_t sw_num);
+static void _event_log(uint8_t sw_num);
 
 /*
  * gpio_init() - initialize homing/limit switches
@@ -117,6 +121,7 @@ void gpio_init(void)
 		device.sw_port[i]->INTCTRL = GPIO1_INTLVL;				// see gpio.h for setting
 	}
 	gpio_reset_switches();
+	gpio_encoder_init();										// may take over one axis' switch pins
 }
 
 /*
@@ -131,6 +136,15 @@ void gpio_init(void)
  *	When a switch closure is DETECTED the count increments for each RTC tick.
  *	When the count reaches zero the switch is tripped and action occurs.
  *	The counter continues to increment positive until the lockout is exceeded.
+ *
+ *	Limit strikes during motion are the exception: waiting out the deglitch
+ *	interval plus a controller pass before reacting costs a millimeter or more
+ *	of travel at higher feed rates, so _isr_helper() kills pulse generation
+ *	right in the switch ISR and leaves only the alarm and reporting aftermath
+ *	to the main loop (_limit_switch_handler() in controller.c). The deglitch /
+ *	lockout machinery still runs to debounce the flag and the homing feedholds.
+ *	A glitch on a limit input while cutting now stops the machine - that's the
+ *	safe direction to fail in.
  */
 
 ISR(X_MIN_ISR_vect)	{ _isr_helper(SW_MIN_X);}
@@ -145,9 +159,33 @@ ISR(A_MAX_ISR_vect)	{ _isr_helper(SW_MAX_A);}
 static void _isr_helper(uint8_t sw_num)
 {
 	if (sw.mode[sw_num] == SW_MODE_DISABLED) return;	// this is never supposed to happen
+	_event_log(sw_num);									// raw edge diagnostics - logs even during lockout
 	if (sw.state[sw_num] == SW_LOCKOUT) return;			// exit if switch is in lockout
 	sw.state[sw_num] = SW_DEGLITCHING;					// either transitions state from IDLE or overwrites it
 	sw.count[sw_num] = -SW_DEGLITCH_TICKS;				// reset deglitch count regardless of entry state
+
+	// homing - date the raw edge so the latch position doesn't depend on the
+	// deglitch delay or the stopping distance (see cycle_homing.c)
+	if (cm.cycle_state == CYCLE_HOMING) {
+		cm_homing_switch_capture();
+	}
+
+	// probing - latch the contact position and start decelerating (see cycle_probing.c)
+	if (cm.cycle_state == CYCLE_PROBE) {
+		cm_probe_switch_capture(sw_num);
+	}
+
+	// limit strike while in a cycle - kill motion now, report later (see notes above)
+	// a probe contact on the probe input is expected and is not a limit strike
+	if ((sw.mode[sw_num] & SW_LIMIT) &&
+		(cm.cycle_state != CYCLE_HOMING) &&
+		((cm.cycle_state != CYCLE_PROBE) || (sw_num != PROBE_SWITCH)) &&
+		(cm.machine_state == MACHINE_CYCLE)) {
+		st_kill_motors();								// disables TIMER_DDA - no more step pulses
+		sw.sw_num_thrown = sw_num;						// record number of thrown switch
+		sw.limit_flag = true;							// main loop runs the alarm & reporting
+		tg_set_event(EVENT_SIGNAL_bm);					// wake the controller to process it
+	}
 }
 
 void gpio_rtc_callback(void)
@@ -163,8 +201,11 @@ void gpio_rtc_callback(void)
 //			sw_show_switch();							// only called if __DEBUG enabled
 			if (cm.cycle_state == CYCLE_HOMING) {		// regardless of switch type
 				cm_request_feedhold();
+			} else if ((cm.cycle_state == CYCLE_PROBE) && (i == PROBE_SWITCH)) {
+				// expected probe contact - already handled by cycle_probing.c
 			} else if (sw.mode[i] & SW_LIMIT) {			// should be a limit switch, so fire it.
 				sw.limit_flag = true;					// triggers an emergency shutdown
+				tg_set_event(EVENT_SIGNAL_bm);			// wake the controller to process it
 			}
 		}
 	}
@@ -218,6 +259,160 @@ uint8_t gpio_read_switch(uint8_t sw_num)
 	}
 }
 
+/* Switch edge event log
+ *
+ *	A small ring of timestamped raw switch edges, filled at ISR level ahead
+ *	of the deglitch / lockout machinery - which exists precisely to hide
+ *	these details from the rest of the system. After debouncing, a genuine
+ *	strike, a chattering switch and an EMI burst all collapse into the same
+ *	single thrown flag; the raw log tells them apart in the field, so
+ *	lockout and deglitch times can be tuned down from evidence instead of
+ *	padded up from anecdote. Logging costs a handful of cycles per edge and
+ *	runs even during lockout - that's exactly the interval the flag-based
+ *	path goes blind in.
+ *
+ *	Query $swe to pop the oldest event - one "t:<ms> sw:<num> v:<level>"
+ *	string per query, empty when the log is drained (see _get_swe() in
+ *	config.c for the formatting). $swel counts edges that were overwritten
+ *	before being read - the ring keeps the newest events, so a count there
+ *	is itself evidence of a burst.
+ */
+
+#define SW_EVENT_SLOTS 16				// must be a power of 2
+
+static struct swEventLog {
+	struct {
+		uint32_t time_ms;				// RTC time of the edge in milliseconds
+		uint8_t sw_num;
+		uint8_t level;					// SW_OPEN or SW_CLOSED (after NO/NC mapping)
+	} ring[SW_EVENT_SLOTS];
+	volatile uint8_t write;				// next slot to fill
+	volatile uint8_t count;				// filled slots
+	volatile uint16_t lost;				// edges overwritten before being read
+} swe;
+
+static void _event_log(uint8_t sw_num)	// runs at ISR level
+{
+	swe.ring[swe.write].time_ms = (rtc.clock_ticks * RTC_MILLISECONDS) + RTC.CNT;
+	swe.ring[swe.write].sw_num = sw_num;
+	swe.ring[swe.write].level = gpio_read_switch(sw_num);
+	swe.write = (swe.write+1) & (SW_EVENT_SLOTS-1);
+	if (swe.count < SW_EVENT_SLOTS) { swe.count++;} else { swe.lost++;}
+}
+
+uint8_t gpio_event_pop(uint32_t *time_ms, uint8_t *sw_num, uint8_t *level)
+{
+	if (swe.count == 0) { return (false);}
+	cli();								// the switch ISRs write the ring
+	uint8_t read = (swe.write - swe.count) & (SW_EVENT_SLOTS-1);
+	*time_ms = swe.ring[read].time_ms;
+	*sw_num = swe.ring[read].sw_num;
+	*level = swe.ring[read].level;
+	swe.count--;
+	sei();
+	return (true);
+}
+
+uint16_t gpio_event_lost(void) { return (swe.lost);}
+
+/* Encoder monitoring
+ *
+ *	Optional closed-loop verification against a quadrature encoder wired to
+ *	a GPIO2 switch pin pair. The XMEGA event system does the quadrature
+ *	decode in hardware (QDEC mode on event channel 0 clocking TIMER_QDEC),
+ *	so tracking costs zero CPU per edge. The only software is a periodic
+ *	compare - every ENCODER_SAMPLE_TICKS the accumulated count is checked
+ *	against the runtime stepper position for the monitored axis and a
+ *	deviation past $ent alarms the machine, so a spindle-heavy job that
+ *	starts losing steps is stopped in seconds rather than discovered at
+ *	the end.
+ *
+ *	Configuration (monitoring is off until $enc is set non-zero):
+ *	  $ena  axis monitored (0=X,1=Y,2=Z,3=A) - the encoder A/B channels
+ *	        take over that axis' min/max switch inputs (pins 6/7), so set
+ *	        the axis' switch modes to disabled
+ *	  $enc  quadrature counts per mm or deg - 0 disables monitoring
+ *	  $ent  allowed deviation in mm or deg before the alarm fires
+ *
+ *	The compare runs only while machining (MACHINE_CYCLE with no homing or
+ *	probing cycle active - those redefine machine positions mid-cycle).
+ *	Between cycles the reference is rebased so engagement always starts
+ *	aligned. The QDEC counter is sampled modulo 2^16 and accumulated in
+ *	software, which is good to ~32k counts per sample interval. Wire the
+ *	A/B channels so counts increase with positive axis motion - swap them
+ *	if the deviation grows on a straight move.
+ */
+
+#define ENCODER_SAMPLE_TICKS 25				// 25=250ms. RTC ticks are ~10ms each
+
+static const uint8_t en_chmux[] = {			// pin 6 event mux per axis - order matches PORT_SWITCH_X/Y/Z/A
+	EVSYS_CHMUX_PORTA_PIN6_gc, EVSYS_CHMUX_PORTD_PIN6_gc,
+	EVSYS_CHMUX_PORTE_PIN6_gc, EVSYS_CHMUX_PORTF_PIN6_gc
+};
+
+static struct enEncoderSingleton {
+	uint16_t prev_cnt;						// last raw QDEC counter sample
+	int32_t count;							// accumulated quadrature count
+	int32_t count_ref;						// count at the last rebase
+	float position_ref;						// runtime machine position at the last rebase
+	uint32_t next_sample;					// RTC tick of the next compare
+} en;
+
+static void _encoder_sample(void)
+{
+	uint16_t cnt = TIMER_QDEC.CNT;
+	en.count += (int16_t)(cnt - en.prev_cnt);	// 16 bit wrap-safe delta
+	en.prev_cnt = cnt;
+}
+
+static void _encoder_rebase(void)
+{
+	_encoder_sample();
+	en.count_ref = en.count;
+	en.position_ref = mp_get_runtime_machine_position(cfg.enc_axis);
+}
+
+void gpio_encoder_init(void)
+{
+	if (fp_ZERO(cfg.enc_counts_per_unit)) {	// monitoring disabled
+		EVSYS.CH0CTRL = 0;
+		TIMER_QDEC.CTRLA = 0;
+		return;
+	}
+	PORT_t *port = device.sw_port[cfg.enc_axis];
+	port->DIRCLR = (SW_MIN_BIT_bm | SW_MAX_BIT_bm);	// A/B take over the switch inputs
+	port->PIN6CTRL = (PIN_MODE | PORT_ISC_LEVEL_gc);	// QDEC wants level sensing
+	port->PIN7CTRL = (PIN_MODE | PORT_ISC_LEVEL_gc);
+	EVSYS.CH0MUX = en_chmux[cfg.enc_axis];	// pin 6 = phase 0, pin 7 = phase 90
+	EVSYS.CH0CTRL = (EVSYS_QDEN_bm | EVSYS_DIGFILT_2SAMPLES_gc);
+	TIMER_QDEC.CTRLD = (TC_EVACT_QDEC_gc | TC_EVSEL_CH0_gc);
+	TIMER_QDEC.PER = 0xFFFF;
+	TIMER_QDEC.CTRLA = TC_CLKSEL_DIV1_gc;
+	en.prev_cnt = TIMER_QDEC.CNT;
+	en.count = 0;
+	_encoder_rebase();
+}
+
+stat_t gpio_encoder_callback(void)
+{
+	if (fp_ZERO(cfg.enc_counts_per_unit)) { return (STAT_NOOP);}
+	if (rtc.clock_ticks < en.next_sample) { return (STAT_NOOP);}
+	en.next_sample = rtc.clock_ticks + ENCODER_SAMPLE_TICKS;
+
+	if ((cm.machine_state != MACHINE_CYCLE) || (cm.cycle_state != CYCLE_OFF)) {
+		_encoder_rebase();					// track quietly outside of machining moves
+		return (STAT_NOOP);
+	}
+	_encoder_sample();
+	float expected = mp_get_runtime_machine_position(cfg.enc_axis) - en.position_ref;
+	float measured = (en.count - en.count_ref) / cfg.enc_counts_per_unit;
+	if (fabs(expected - measured) > cfg.enc_fault_threshold) {
+		cm_alarm(STAT_STEP_LOSS_DETECTED);	// kills the steppers and the spindle
+		return (STAT_OK);
+	}
+	return (STAT_NOOP);
+}
+
 /*
  * gpio_led_on() - turn led on - assumes TinyG LED mapping
  * gpio_led_off() - turn led on - assumes TinyG LED mapping
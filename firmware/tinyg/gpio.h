@@ -1,9 +1,9 @@
-/*
+/*
  * gpio.c - general purpose IO bits - including limit switches, inputs, outputs
  * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
  * This file ("the software") is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License, version 2 as published by the
  * Free Software Foundation. You should have received a copy of the GNU General Public
@@ -25,8 +25,8 @@
  * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-#ifndef gpio_h
-#define gpio_h
+#ifndef gpio_h
+#define gpio_h
 
 /*
  * Interrupt levels and vectors - The vectors are hard-wired to xmega ports
@@ -69,6 +69,12 @@ enum swNums {	 			// indexes into switch arrays
 #define SW_OFFSET SW_MAX_X	// offset between MIN and MAX switches
 #define NUM_SWITCH_PAIRS (NUM_SWITCHES/2)
 
+// switch input used as the G38.2 probe contact (see cycle_probing.c)
+// override in a machine profile to move the probe to a different input
+#ifndef PROBE_SWITCH
+#define PROBE_SWITCH SW_MIN_Z
+#endif
+
 #define SW_DISABLED -1
 #define SW_OPEN 	 0
 #define SW_CLOSED	 1
@@ -114,6 +120,10 @@ uint8_t gpio_get_limit_thrown(void);
 uint8_t gpio_get_sw_thrown(void);
 void gpio_reset_switches(void);
 uint8_t gpio_read_switch(uint8_t sw_num);
+uint8_t gpio_event_pop(uint32_t *time_ms, uint8_t *sw_num, uint8_t *level);
+uint16_t gpio_event_lost(void);
+void gpio_encoder_init(void);
+stat_t gpio_encoder_callback(void);
 
 void gpio_led_on(uint8_t led);
 void gpio_led_off(uint8_t led);
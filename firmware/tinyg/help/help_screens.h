@@ -0,0 +1,147 @@
+/*
+ * help_screens.h - byte-pair coded help screen text
+ * Part of TinyG project
+ *
+ * GENERATED FILE - DO NOT EDIT. Edit help_screens.txt and re-run
+ * pack_help.py in this directory, then commit both files.
+ *
+ * 128 pairs, 3034 raw bytes packed to 1738 (tables included)
+ */
+
+#define HLP_STACK_SIZE 8		// worst-case decoder stack, measured by pack_help.py
+
+static const uint8_t hlp_pairs[][2] PROGMEM = {
+	{0x20,0x20},{0x65,0x73},{0x80,0x80},{0x65,0x20},{0x69,0x6e},{0x81,0x74},{0x20,0x74},{0x20,0x73},
+	{0x0a,0x80},{0x23,0x23},{0x20,0x61},{0x88,0x24},{0x65,0x74},{0x6f,0x6e},{0x6f,0x72},{0x74,0x85},
+	{0x74,0x69},{0x84,0x67},{0x65,0x72},{0x68,0x6f},{0x82,0x82},{0x65,0x6e},{0x65,0x6c},{0x20,0x63},
+	{0x0a,0x0a},{0x73,0x20},{0x8b,0x8f},{0x6f,0x6d},{0x64,0x20},{0x61,0x72},{0x74,0x20},{0x90,0x8d},
+	{0x20,0x6d},{0x9a,0x3d},{0x61,0x6e},{0x87,0x8c},{0x86,0x68},{0x61,0x74},{0x74,0x91},{0x80,0x20},
+	{0x86,0x85},{0x54,0x84},{0xa9,0x79},{0xaa,0x47},{0x53,0x93},{0xac,0x77},{0xa3,0xa6},{0x89,0x89},
+	{0xa4,0x83},{0x6f,0x73},{0x69,0x73},{0x6c,0x65},{0x6f,0x20},{0x74,0x92},{0x74,0x68},{0x61,0x63},
+	{0x94,0x82},{0x65,0x65},{0xa0,0x6f},{0x61,0x6c},{0x96,0x70},{0xb8,0x20},{0x77,0x69},{0x8e,0x20},
+	{0xab,0x20},{0x0a,0x54},{0x63,0x9b},{0x8a,0x6e},{0x79,0x20},{0xae,0x73},{0x73,0x79},{0xa7,0xad},
+	{0x6f,0x6b},{0x95,0xb5},{0x29,0xa1},{0x20,0xc0},{0x76,0x83},{0x72,0x65},{0x66,0x69},{0x20,0x68},
+	{0x64,0x65},{0x6c,0x6c},{0x98,0x0a},{0xd2,0xaf},{0xd3,0xcb},{0x48,0xbc},{0xd5,0x20},{0xd6,0xaf},
+	{0x6d,0xa2},{0x73,0x8a},{0x20,0x28},{0x6f,0x66},{0x87,0x74},{0x70,0xb1},{0xdd,0x69},{0x73,0x74},
+	{0x8d,0xce},{0xe0,0x67},{0xe1,0x75},{0xe2,0x72},{0xe3,0x61},{0xe4,0x9f},{0x91,0x20},{0x20,0x66},
+	{0x69,0x99},{0xd0,0x66},{0xe9,0x61},{0x86,0xb4},{0xc5,0x8b},{0x8a,0xd1},{0xc8,0x95},{0xa1,0x31},
+	{0xc1,0x68},{0xd8,0x64},{0x66,0x72},{0x63,0x8d},{0x72,0x6f},{0xc3,0x9c},{0xde,0x9f},{0x71,0x75},
+	{0xa5,0x83},{0x6f,0x64},{0xa5,0x65},{0x97,0xe5},{0x93,0x6c},{0x75,0x6e},{0x93,0x6d},{0x3d,0x31},
+};
+
+static const uint8_t hlp_general[] PROGMEM = {
+	0xd4,0xd7,0xf0,0x81,0x83,0xc2,0xf1,0xd9,0x72,0x83,0xb7,0x90,0xcc,0xf2,0x9b,0xb0,
+	0xc2,0xd8,0x9c,0x6c,0x84,0x65,0x3a,0x0a,0x20,0x5e,0x78,0xbd,0x52,0x81,0x8c,0xda,
+	0xf3,0x74,0xf4,0x6c,0x20,0x78,0x29,0x20,0x2d,0x87,0xdb,0x74,0x77,0x9d,0x83,0x72,
+	0x81,0x8c,0x0a,0x20,0x5e,0x63,0xbd,0x4a,0x6f,0x62,0x8a,0x62,0x8e,0x9e,0x28,0xf3,
+	0x74,0xf4,0x6c,0x97,0x29,0x20,0x2d,0xdc,0x6f,0x70,0xf5,0x66,0x6c,0x75,0x73,0x68,
+	0xb0,0x6a,0x6f,0x62,0x2c,0x20,0x6b,0xb9,0x70,0x20,0xf6,0x0a,0x20,0x5e,0x65,0xbd,
+	0x53,0x74,0xa5,0x75,0x99,0xf7,0x92,0xc4,0x28,0xf3,0x74,0xf4,0x6c,0x20,0x65,0x29,
+	0x20,0x2d,0x20,0x69,0x6d,0x6d,0x65,0x64,0x69,0xf8,0xdf,0xa5,0x75,0x99,0xcd,0x70,
+	0x8e,0x74,0x88,0x3f,0xbd,0x4d,0xb7,0x68,0x84,0x83,0xf6,0xf5,0x67,0x63,0xf9,0x83,
+	0x6d,0xf9,0x96,0xdc,0xfa,0x8b,0xbd,0xad,0xc3,0x64,0xa3,0xfb,0xc5,0x88,0x21,0xbd,
+	0x46,0xb9,0x64,0xfc,0x9c,0x2d,0xdc,0x6f,0x70,0xba,0x9f,0x20,0xbe,0x74,0x93,0x75,
+	0x9e,0x6c,0xb1,0xe6,0xf6,0x88,0x7e,0xbd,0x43,0x79,0x63,0x6c,0x83,0x53,0x74,0x9d,
+	0x9e,0x2d,0x20,0x72,0x85,0x9d,0x9e,0xf2,0x9b,0xe7,0xb9,0x64,0xfc,0x64,0x88,0x68,
+	0xbd,0xad,0xa4,0xe8,0x68,0xbc,0x87,0x63,0xcd,0x95,0x8b,0x68,0xb8,0xad,0xfb,0xcf,
+	0xbc,0x87,0x63,0xcd,0x95,0x9a,0x94,0x20,0x4c,0xb2,0x74,0x87,0x96,0x66,0x2d,0x8f,
+	0x73,0xa1,0x4e,0x82,0xa7,0x52,0xfd,0x87,0x96,0x66,0x2d,0x8f,0x20,0x4e,0x8b,0xfe,
+	0x65,0xff,0x82,0xa7,0x52,0xfd,0x8a,0x20,0xfe,0x91,0x97,0x79,0x63,0xb3,0x8b,0xea,
+	0xff,0x82,0xa7,0x52,0x85,0x8e,0x83,0xbb,0x6c,0xc5,0xeb,0x22,0x66,0xb7,0x74,0x8e,
+	0x79,0x22,0x20,0xea,0x75,0x6c,0x74,0x73,0x0a,0x00,
+};
+
+static const uint8_t hlp_config[] PROGMEM = {
+	0xd4,0x43,0x4f,0x4e,0x46,0x49,0x47,0x55,0x52,0x41,0x54,0x49,0x4f,0x4e,0x20,0xd7,
+	0xf0,0x81,0x83,0xc2,0xf1,0xd9,0x72,0x83,0xb7,0x90,0xcc,0x66,0x8e,0xfb,0x3a,0x8b,
+	0xc6,0x99,0xad,0x87,0x79,0xdf,0x65,0x6d,0xda,0x67,0x95,0x92,0xbb,0x29,0xec,0x31,
+	0xc7,0xba,0x74,0xbf,0x31,0xae,0x99,0x28,0xbf,0x77,0x68,0xfa,0x76,0x92,0xba,0x74,
+	0xbf,0x79,0x6f,0x75,0x20,0x77,0xa2,0x9e,0x31,0x2c,0x32,0x2c,0x33,0x2c,0x34,0x29,
+	0x8b,0x78,0xc7,0x20,0x58,0x8a,0x78,0xb2,0xae,0x99,0x28,0xbf,0x77,0x68,0xfa,0x76,
+	0x92,0x8a,0x78,0xe8,0x79,0x6f,0x75,0x20,0x77,0xa2,0x9e,0x78,0x2c,0x79,0x2c,0x7a,
+	0x2c,0x61,0x2c,0x62,0x2c,0x63,0x29,0x8b,0x6d,0xc7,0xed,0xba,0x74,0x8e,0xec,0x71,
+	0xc7,0xed,0x8a,0x78,0xb2,0xec,0x6f,0xc7,0xed,0x20,0xdb,0x66,0x73,0x8c,0xec,0x24,
+	0xc7,0xed,0xec,0x68,0xc7,0xa4,0xe8,0x68,0xbc,0x87,0x63,0xcd,0x95,0x98,0x45,0xb7,
+	0x68,0x20,0x24,0x97,0x9b,0xf1,0x8a,0x62,0x6f,0xcc,0xbb,0x73,0xb4,0x64,0xb2,0x70,
+	0x6c,0x61,0x79,0x73,0xb0,0x74,0xee,0xe7,0xbf,0x65,0xb7,0x68,0xae,0x20,0x84,0x20,
+	0x5b,0x20,0x5d,0x20,0x62,0x72,0xb7,0x6b,0x8c,0x73,0xc1,0xb4,0x76,0x69,0x65,0x77,
+	0xae,0x99,0xc9,0x8a,0x86,0xee,0x3a,0x0a,0x8b,0x3c,0x74,0xee,0x3e,0x98,0x46,0xbf,
+	0x65,0x78,0x61,0x6d,0x70,0x6c,0x83,0x24,0x79,0xf2,0xeb,0x64,0xb2,0x70,0x6c,0x61,
+	0x79,0xb0,0x59,0xa0,0x61,0x78,0xe7,0xb9,0x9c,0x72,0xfa,0x98,0x54,0xb4,0x75,0x70,
+	0x64,0xf8,0x73,0x8c,0xa6,0x99,0xc9,0x86,0xee,0x20,0x65,0xf7,0xbb,0x99,0x76,0xbb,
+	0x75,0x65,0x3a,0x0a,0x8b,0x3c,0x74,0xee,0x3e,0x3d,0x3c,0x76,0xbb,0x75,0x65,0x3e,
+	0x98,0x46,0xbf,0x65,0x78,0x61,0x6d,0x70,0x6c,0x83,0x24,0x79,0xf2,0x3d,0x38,0x30,
+	0x30,0x86,0x6f,0xa3,0xb0,0x59,0xa0,0x61,0x78,0xe7,0xb9,0x9c,0x72,0xf8,0x74,0xb4,
+	0x38,0x30,0x30,0xa0,0x6d,0x2f,0x6d,0x84,0x75,0x74,0x65,0x0a,0x46,0x8e,0xfb,0x20,
+	0x64,0x8c,0x61,0x69,0x6c,0x73,0x87,0xb9,0x3a,0xcf,0x74,0x74,0x70,0x73,0x3a,0x2f,
+	0x2f,0x67,0x69,0xb6,0x75,0x62,0x2e,0xc2,0x2f,0xc6,0x6e,0xb6,0x8c,0xb1,0x2f,0xab,
+	0x2f,0xbe,0x6b,0x69,0x2f,0xab,0x2d,0x43,0xe5,0x0a,0x00,
+};
+
+static const uint8_t hlp_test[] PROGMEM = {
+	0xd4,0x53,0x45,0x4c,0x46,0x20,0x54,0x45,0x53,0x54,0x20,0xd7,0x0a,0x49,0x6e,0x76,
+	0xc8,0x83,0x73,0x96,0x66,0xa8,0x20,0x62,0xc4,0xc9,0xe6,0x24,0x8f,0x3d,0x4e,0x20,
+	0x77,0x68,0x92,0x83,0x4e,0x20,0xe8,0x8d,0x83,0xdb,0x3a,0xef,0x80,0x73,0x6d,0xc8,
+	0x83,0x8f,0xa1,0x32,0x80,0xfe,0x91,0xa8,0xa7,0x28,0x79,0x6f,0x75,0xa0,0x75,0xdf,
+	0x86,0x72,0x69,0x70,0x20,0xfe,0x91,0x87,0xbe,0x74,0x63,0x68,0x81,0xca,0x33,0x80,
+	0x73,0xf7,0x9d,0x83,0x8f,0xa7,0x28,0x61,0x87,0x92,0x69,0x81,0x20,0xdb,0x87,0xf7,
+	0x9d,0x81,0xca,0x34,0x80,0x9d,0x63,0xa8,0x82,0x80,0x28,0x73,0x9b,0x83,0x6c,0x9d,
+	0x67,0x83,0x63,0x69,0x72,0x63,0x6c,0x81,0xca,0x35,0x80,0x64,0x77,0x96,0x6c,0xa8,
+	0x82,0x28,0x6d,0x6f,0x76,0x81,0x87,0x70,0xb7,0x65,0x9c,0x62,0xc4,0x31,0x87,0x65,
+	0xf3,0x9c,0x64,0x77,0x96,0x6c,0x73,0xca,0x36,0x80,0x66,0xb9,0x64,0xfc,0x64,0xa8,
+	0xda,0xc9,0x20,0x21,0xf5,0x7e,0xeb,0xfc,0x64,0xf5,0x72,0x85,0x9d,0x74,0x2c,0x20,
+	0x72,0x81,0x70,0x65,0x63,0x90,0x76,0x96,0x79,0xca,0x37,0x80,0x4d,0x97,0xf9,0x81,
+	0xa8,0x80,0x28,0x4d,0x97,0xf9,0x81,0x20,0x84,0xb5,0x6d,0x91,0xb3,0x9c,0xbe,0xb6,
+	0xba,0x76,0x81,0xca,0x38,0x80,0x4a,0x53,0x4f,0x4e,0xa8,0x82,0xda,0x6d,0x6f,0x9f,
+	0xa8,0x20,0x72,0xfd,0x20,0x75,0x73,0xe6,0x4a,0x53,0x4f,0x4e,0x97,0x9b,0xf1,0x73,
+	0xca,0x39,0x80,0x84,0x76,0x92,0x73,0x83,0x90,0x6d,0x83,0x8f,0xef,0x30,0x20,0xf4,
+	0x74,0x9d,0x79,0xba,0x9f,0xa8,0xef,0x31,0x87,0x6d,0xbb,0x6c,0xba,0x76,0x81,0xa8,
+	0xef,0x32,0x87,0x6c,0x6f,0x77,0xba,0x76,0x81,0xa8,0xef,0x33,0x97,0x6f,0x8e,0x64,
+	0x84,0xf8,0xc6,0xdf,0x65,0x6d,0x20,0xdb,0x66,0x73,0x8c,0xa8,0xda,0x47,0x39,0x32,
+	0x2c,0x20,0x47,0x35,0x34,0x2d,0x47,0x35,0x39,0x29,0x98,0x54,0x85,0xd9,0x73,0x73,
+	0x75,0x6d,0x83,0x61,0x97,0xc9,0x65,0x9c,0x58,0x59,0x20,0x8e,0x69,0x67,0x84,0xc3,
+	0x64,0x8a,0x9e,0xb3,0x61,0x73,0x9e,0x38,0x30,0x6d,0x6d,0x97,0xb3,0x9d,0xa2,0x63,
+	0x83,0x84,0xed,0x20,0x64,0x69,0xcd,0x63,0x9f,0x73,0xc1,0x85,0xd9,0x73,0x73,0x75,
+	0x6d,0x83,0x5a,0xcf,0x61,0xd9,0x9e,0xb3,0x61,0x73,0x9e,0x34,0x30,0x6d,0x6d,0x20,
+	0xde,0x69,0x90,0xcc,0x63,0xb3,0x9d,0xa2,0x63,0x65,0xc1,0x85,0x73,0xdc,0x9d,0x9e,
+	0xbe,0xb6,0x8a,0x20,0x47,0x30,0x20,0x58,0x30,0x20,0x59,0x30,0x20,0x5a,0x30,0xba,
+	0x76,0x65,0x0a,0x48,0x9b,0xe6,0xb2,0xb0,0x65,0x78,0x63,0x65,0x70,0x9f,0x2e,0x20,
+	0x4e,0xb4,0x84,0x69,0x90,0xbb,0x20,0xf6,0x20,0x8e,0x97,0xb3,0x9d,0xa2,0x63,0x83,
+	0xb2,0x8a,0x73,0x73,0x75,0x6d,0x65,0x64,0x0a,0x00,
+};
+
+static const uint8_t hlp_defaults[] PROGMEM = {
+	0xd4,0x52,0x45,0x53,0x54,0x4f,0x52,0x45,0x20,0x44,0x45,0x46,0x41,0x55,0x4c,0x54,
+	0x53,0x20,0xd7,0x0a,0x45,0x6e,0xb5,0x20,0x24,0xea,0x75,0x6c,0x74,0x73,0xff,0xeb,
+	0x72,0x81,0x8c,0xb0,0xc6,0xdf,0x65,0x6d,0x86,0x6f,0xb0,0x66,0xb7,0x74,0x8e,0xc4,
+	0xea,0x75,0x6c,0x9e,0x76,0xbb,0x75,0x81,0x2e,0xf0,0xe8,0xbe,0xd1,0x20,0x6f,0x76,
+	0x92,0x77,0x72,0x69,0x74,0x83,0xa2,0x79,0x97,0x68,0xa2,0x67,0x81,0x20,0x79,0x6f,
+	0x75,0xcf,0x61,0xcc,0x6d,0x61,0xd0,0x2e,0x0a,0x00,
+};
+
+static const uint8_t hlp_boot[] PROGMEM = {
+	0xd4,0x42,0x4f,0x4f,0x54,0x20,0x4c,0x4f,0x41,0x44,0x45,0x52,0x20,0xd7,0x0a,0x45,
+	0x6e,0xb5,0x20,0x24,0x62,0x6f,0x6f,0x74,0xff,0xeb,0xc9,0xb0,0x62,0x6f,0x6f,0x9e,
+	0x6c,0x6f,0x61,0x64,0x92,0x2e,0x0a,0x00,
+};
+
+static const uint8_t hlp_advisory[] PROGMEM = {
+	0x0a,0x4e,0x6f,0x74,0x65,0x3a,0xcb,0x67,0x95,0x92,0xa5,0x81,0x8a,0x75,0x74,0x9b,
+	0x61,0x90,0x63,0xdc,0xa5,0x75,0x99,0xcd,0x70,0x8e,0x74,0x99,0x62,0xc4,0xea,0x75,
+	0x6c,0x74,0xf0,0xb2,0x97,0xa2,0x20,0x62,0x83,0x64,0xb2,0x61,0x62,0xb3,0x9c,0x62,
+	0xc4,0xc9,0xe6,0x24,0x73,0x76,0x3d,0x30,0x0a,0x53,0x65,0x83,0xb6,0x83,0xbe,0x6b,
+	0x69,0x20,0x62,0x96,0x6f,0x77,0xe7,0x8e,0xa0,0x8e,0x83,0x64,0x8c,0x61,0x69,0x6c,
+	0x73,0x2e,0x0a,0x00,
+};
+
+static const uint8_t hlp_postscript[] PROGMEM = {
+	0x0a,0x46,0xbf,0x64,0x8c,0x61,0x69,0xb3,0x9c,0xc0,0x84,0x66,0x6f,0x87,0xb9,0x3a,
+	0xcf,0x74,0x74,0x70,0x73,0x3a,0x2f,0x2f,0x67,0x69,0xb6,0x75,0x62,0x2e,0xc2,0x2f,
+	0xc6,0x6e,0xb6,0x8c,0xb1,0x2f,0xab,0x2f,0xbe,0x6b,0x69,0x2f,0x0a,0x46,0x8e,0xb0,
+	0x6c,0x61,0x8f,0x20,0xce,0x72,0x6d,0x77,0x9d,0x83,0x73,0xb9,0x3a,0xcf,0x74,0x74,
+	0x70,0x73,0x3a,0x2f,0x2f,0x67,0x69,0xb6,0x75,0x62,0x2e,0xc2,0x2f,0xc6,0x6e,0xb6,
+	0x8c,0xb1,0x2f,0xab,0x0a,0x50,0xb3,0x61,0x73,0x83,0x6c,0x6f,0x67,0xc3,0xc4,0xb2,
+	0x73,0x75,0x81,0x8a,0x9e,0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x77,0x77,0x77,0x2e,
+	0xc6,0x6e,0xb6,0x8c,0xb1,0x2e,0xc2,0x2f,0x66,0x8e,0x75,0x6d,0x73,0x0a,0x48,0x61,
+	0xcc,0x66,0xfd,0x0a,0x00,
+};
@@ -0,0 +1,142 @@
+#!/usr/bin/env python
+#
+# pack_help.py - pack the help screens into byte-pair coded PROGMEM arrays
+# Part of TinyG project
+#
+# Reads help_screens.txt and writes help_screens.h. Run it from this
+# directory whenever the text changes and commit both files - the build
+# does not run this script (same arrangement as the canned test files
+# in tests/, which are committed in their converted form).
+#
+#   python pack_help.py
+#
+# Coding: the screens are 7-bit ASCII so codes 0x80-0xff are free. The
+# packer repeatedly finds the most frequent adjacent byte pair across all
+# screens and replaces it with the next free code; pairs may themselves
+# contain codes, so common words and whole phrases collapse to single
+# bytes. The decoder in help.c expands codes through the 2-byte-per-entry
+# pair table using a small explicit stack; HLP_STACK_SIZE below is the
+# worst-case stack depth measured by replaying the decoder here, plus one.
+
+import os
+
+SOURCE = "help_screens.txt"
+OUTPUT = "help_screens.h"
+MAX_PAIRS = 128			# codes 0x80..0xff
+MIN_COUNT = 3			# a pair must save more than its 2 table bytes
+
+def read_sections(path):
+	sections = []		# list of (name, text) in file order
+	name = None
+	lines = []
+	for line in open(path).read().split("\n")[:-1]:	# drop the empty tail after final \n
+		if line.startswith("=== ") and line.endswith(" ==="):
+			if name is not None:
+				sections.append((name, "".join(lines)))
+			name = line[4:-4]
+			lines = []
+		else:
+			lines.append(line + "\n")
+	sections.append((name, "".join(lines)))
+	return sections
+
+def compress(sections):
+	data = [(name, [ord(c) for c in text]) for (name, text) in sections]
+	pairs = []
+	while len(pairs) < MAX_PAIRS:
+		counts = {}
+		for (name, seq) in data:
+			for i in range(len(seq) - 1):
+				pair = (seq[i], seq[i+1])
+				counts[pair] = counts.get(pair, 0) + 1
+		if not counts:
+			break
+		best = max(counts, key=lambda p: counts[p])
+		if counts[best] < MIN_COUNT:
+			break
+		code = 0x80 + len(pairs)
+		pairs.append(best)
+		for (name, seq) in data:
+			out = []
+			i = 0
+			while i < len(seq):
+				if i+1 < len(seq) and (seq[i], seq[i+1]) == best:
+					out.append(code)
+					i += 2
+				else:
+					out.append(seq[i])
+					i += 1
+			seq[:] = out
+	return pairs, data
+
+def measure_stack(pairs, data):
+	# replay the help.c decoder and record the deepest expansion stack
+	deepest = 0
+	for (name, seq) in data:
+		for c in seq:
+			stack = []
+			while True:
+				while c >= 0x80:
+					stack.append(pairs[c - 0x80][1])
+					deepest = max(deepest, len(stack))
+					c = pairs[c - 0x80][0]
+				if not stack:
+					break
+				c = stack.pop()
+	return deepest
+
+def verify(pairs, data, sections):
+	# expand everything back and compare against the source text
+	for ((name, seq), (name2, text)) in zip(data, sections):
+		out = []
+		for c in seq:
+			stack = [c]
+			while stack:
+				c = stack.pop()
+				if c >= 0x80:
+					stack.append(pairs[c - 0x80][1])
+					stack.append(pairs[c - 0x80][0])
+				else:
+					out.append(chr(c))
+		assert "".join(out) == text, "round trip failed for [%s]" % name
+
+def emit_bytes(values):
+	rows = []
+	for i in range(0, len(values), 16):
+		rows.append("\t" + ",".join("0x%02x" % v for v in values[i:i+16]) + ",")
+	return "\n".join(rows)
+
+def main():
+	sections = read_sections(SOURCE)
+	pairs, data = compress(sections)
+	verify(pairs, data, sections)
+	stack = measure_stack(pairs, data) + 1
+	raw = sum(len(text) + 1 for (name, text) in sections)
+	packed = sum(len(seq) + 1 for (name, seq) in data) + 2 * len(pairs)
+
+	out = open(OUTPUT, "w")
+	out.write("/*\n")
+	out.write(" * help_screens.h - byte-pair coded help screen text\n")
+	out.write(" * Part of TinyG project\n")
+	out.write(" *\n")
+	out.write(" * GENERATED FILE - DO NOT EDIT. Edit help_screens.txt and re-run\n")
+	out.write(" * pack_help.py in this directory, then commit both files.\n")
+	out.write(" *\n")
+	out.write(" * %d pairs, %d raw bytes packed to %d (tables included)\n" %
+			  (len(pairs), raw, packed))
+	out.write(" */\n\n")
+	out.write("#define HLP_STACK_SIZE %d\t\t// worst-case decoder stack, measured by pack_help.py\n\n" % stack)
+	out.write("static const uint8_t hlp_pairs[][2] PROGMEM = {\n")
+	for i in range(0, len(pairs), 8):
+		out.write("\t" + "".join("{0x%02x,0x%02x}," % p for p in pairs[i:i+8]) + "\n")
+	out.write("};\n")
+	for (name, seq) in data:
+		out.write("\nstatic const uint8_t hlp_%s[] PROGMEM = {\n" % name)
+		out.write(emit_bytes(seq + [0]))
+		out.write("\n};\n")
+	out.close()
+	print("%s: %d pairs, %d -> %d bytes (%.0f%%), stack %d" %
+		  (OUTPUT, len(pairs), raw, packed, 100.0 * packed / raw, stack))
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,570 @@
+/*
+ * job.c - stored gcode job management
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* ---- Stored jobs ----
+ *
+ *	Named gcode programs stored in the external SPI flash (see xio_flash.c)
+ *	so a host uploads a job once and the board runs it autonomously - the
+ *	serial link carries only status, and host OS scheduling jitter is out
+ *	of the streaming path entirely. Jobs are run through the flash file
+ *	device at local-read speeds, so long jobs become planner-bound.
+ *
+ *	Commands (see cfgArray in config.c):
+ *	  $job           list stored jobs
+ *	  {"jobw":"x"}   store: capture following input lines as job "x"
+ *	                 until a line containing only "%" ends the upload
+ *	  {"jobr":"x"}   run job "x" (input source switches to the flash device;
+ *	                 EOF falls back to the default source)
+ *	  {"jobd":"x"}   delete job "x"
+ *	  $jobx=1        erase the flash and reclaim all job space
+ *
+ *	The directory is the first flash page - 16 entries of 16 bytes. Job
+ *	text follows on 256 byte page boundaries, allocated log-fashion past
+ *	the highest page any entry (live or deleted) has claimed. Deleting
+ *	programs the entry's magic byte to zero in place (NOR can clear bits
+ *	without an erase) but can't reclaim the text pages - $jobx=1 erases
+ *	the whole part when the log fills. The directory entry is written only
+ *	after the upload completes, so an interrupted upload leaves no
+ *	half-stored job - just dead pages the next $jobx=1 reclaims.
+ */
+
+#include <stdio.h>						// precursor for xio.h
+#include <stdbool.h>					// true and false
+#include <string.h>						// for strncmp, strlen
+#include <avr/pgmspace.h>				// precursor for xio.h
+#include <avr/interrupt.h>				// power-fail comparator ISR
+
+#include "tinyg.h"
+#include "config.h"
+#include "controller.h"
+#include "canonical_machine.h"			// checkpoint captures and restores the gcode model
+#include "planner.h"
+#include "stepper.h"					// power-fail dump sheds the motor drivers
+#include "job.h"
+#include "blackbox.h"					// flight recorder owns the top of the flash
+#include "report.h"
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"			// checkpoint interval timing
+#include "xmega/xmega_eeprom.h"
+
+#define JOB_SPI_DEV XIO_DEV_SPI2		// select line the flash is on (see xio_flash.c)
+#define JOB_DIR_ADDR(slot) ((uint32_t)(slot) * sizeof(jobDirEntry_t))
+#define CHECKPOINT_TICKS_PER_SEC (1000 / RTC_MILLISECONDS)
+
+enum jobResumeState {					// resume sequence (see job_resume_callback)
+	JOB_RESUME_OFF = 0,					// no resume in progress
+	JOB_RESUME_HOMING,					// waiting for the homing cycle to finish
+	JOB_RESUME_TRAVERSE					// waiting for the rapid to the checkpoint position
+};
+
+static struct jobSingleton {
+	uint8_t capturing;					// an upload is in progress
+	uint8_t slot;						// directory slot reserved for the upload
+	uint32_t wr_offset;					// next flash byte to program
+	jobDirEntry_t entry;				// entry being built by the upload
+
+	uint16_t start_page;				// first flash page of the running job
+	uint32_t lines_read;				// input lines consumed from the running job
+	uint32_t skip_to;					// discard lines up to this count (resume fast-forward)
+
+	uint8_t call_active;				// an M98 subprogram call is running
+	uint16_t call_page;					// first flash page of the called subprogram
+	uint16_t call_repeats;				// passes left, including the one in progress
+	uint8_t call_source;				// input source to restore when the call returns
+	uint32_t next_checkpoint;			// RTC tick deadline for the next checkpoint capture
+	uint8_t cp_pages;					// checkpoint EEPROM pages left to program
+	uint8_t cp_page;					// next checkpoint page to program
+	uint8_t resume;						// resume sequence state (see jobResumeState)
+	jobCheckpoint_t cp;					// record being checkpointed or resumed
+} job;
+
+#ifdef __POWER_FAIL_CHECKPOINT
+static void _powerfail_arm(void);
+#endif
+
+/*
+ * Directory helpers
+ *
+ *	The directory is read from the flash on every operation rather than
+ *	cached - job commands are rare and a 16 byte read on the bit-banged
+ *	bus is cheap next to keeping a RAM copy coherent.
+ */
+static void _read_entry(uint8_t slot, jobDirEntry_t *entry)
+{
+	xio_read_spi_flash(JOB_SPI_DEV, JOB_DIR_ADDR(slot), (char *)entry, sizeof(jobDirEntry_t));
+}
+
+static int8_t _find_job(const char *name, jobDirEntry_t *entry)
+{
+	for (uint8_t slot=0; slot<JOB_DIR_SLOTS; slot++) {
+		_read_entry(slot, entry);
+		if ((entry->magic == JOB_MAGIC) && (strncmp(entry->name, name, JOB_NAME_LEN) == 0)) {
+			return (slot);
+		}
+	}
+	return (-1);
+}
+
+static uint16_t _next_free_page(void)
+{
+	jobDirEntry_t entry;
+	uint16_t page = JOB_FIRST_PAGE;
+
+	for (uint8_t slot=0; slot<JOB_DIR_SLOTS; slot++) {	// deleted entries still claim their pages
+		_read_entry(slot, &entry);
+		if ((entry.magic != 0xFF) && ((entry.start_page + entry.pages) > page)) {
+			page = entry.start_page + entry.pages;
+		}
+	}
+	return (page);
+}
+
+/*
+ * job_run() - switch the input source to a stored job
+ *
+ *	The flash file device reads the job at local speed and EOF falls back
+ *	to the default source (see _dispatch() in controller.c), so the board
+ *	runs the program with no host in the loop.
+ */
+stat_t job_run(const char *name)
+{
+	jobDirEntry_t entry;
+
+	if (_find_job(name, &entry) < 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (xio_open(XIO_DEV_FLASH, (const char *)(uint16_t)entry.start_page, FLASH_FLAGS) == NULL) {
+		return (STAT_FILE_NOT_OPEN);
+	}
+	job.start_page = entry.start_page;		// arm checkpointing (see job_checkpoint_callback)
+	job.lines_read = 0;
+	job.skip_to = 0;
+	job.next_checkpoint = rtc.clock_ticks + ((uint32_t)cfg.job_checkpoint_sec * CHECKPOINT_TICKS_PER_SEC);
+#ifdef __POWER_FAIL_CHECKPOINT
+	_powerfail_arm();						// pre-erase the dump slot and enable the comparator
+#endif
+	tg_set_primary_source(XIO_DEV_FLASH);
+	return (STAT_OK);
+}
+
+/*
+ * job_call()     - run a stored job as a subprogram (M98)
+ * job_call_eof() - handle EOF on the flash device during a call
+ *
+ *	job_call() opens the named job the way job_run() does, but remembers
+ *	the input source it displaced and how many passes were requested. Each
+ *	EOF comes to job_call_eof() (from _dispatch() in controller.c), which
+ *	re-opens the job at its first page while passes remain and restores
+ *	the caller's source when they run out - M98 P12 L100 replays job "12"
+ *	a hundred times without a repeated byte crossing the serial link.
+ *
+ *	Calls don't nest: there is only one flash read stream, so a running
+ *	job (or subprogram) cannot call another. Recovery checkpoints are
+ *	suspended for the duration of a call - a checkpoint can't record the
+ *	call context, so a resume into a subprogram would finish the wrong
+ *	program (see job_checkpoint_callback).
+ */
+stat_t job_call(const char *name, const uint16_t repeats)
+{
+	jobDirEntry_t entry;
+
+	if (tg.primary_src == XIO_DEV_FLASH) { return (STAT_INPUT_VALUE_UNSUPPORTED);}	// calls don't nest
+	if (repeats == 0) { return (STAT_OK);}			// L0 is legal - zero passes
+	if (_find_job(name, &entry) < 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (xio_open(XIO_DEV_FLASH, (const char *)(uint16_t)entry.start_page, FLASH_FLAGS) == NULL) {
+		return (STAT_FILE_NOT_OPEN);
+	}
+	job.call_active = true;
+	job.call_page = entry.start_page;
+	job.call_repeats = repeats;
+	job.call_source = tg.primary_src;
+	tg_set_primary_source(XIO_DEV_FLASH);
+	return (STAT_OK);
+}
+
+uint8_t job_call_eof(void)
+{
+	if (job.call_active == false) { return (false);}
+	if ((--job.call_repeats > 0) &&
+		(xio_open(XIO_DEV_FLASH, (const char *)(uint16_t)job.call_page, FLASH_FLAGS) != NULL)) {
+		return (true);								// start the next pass
+	}
+	job.call_active = false;
+	tg_set_primary_source(job.call_source);			// return to the caller's stream
+	return (true);
+}
+
+/*
+ * job_delete() - mark a job's directory entry dead
+ */
+stat_t job_delete(const char *name)
+{
+	jobDirEntry_t entry;
+	int8_t slot = _find_job(name, &entry);
+	char dead = 0;
+
+	if (slot < 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	xio_write_spi_flash(JOB_SPI_DEV, JOB_DIR_ADDR(slot), &dead, 1);	// clear the magic byte in place
+	return (STAT_OK);
+}
+
+/*
+ * job_store_begin()   - start capturing input lines into a new job
+ * job_capture_line()  - divert one input line into the job being stored
+ *
+ *	Storing re-uses the ordinary line reader: once jobw names the job,
+ *	every following input line is programmed into the flash instead of
+ *	being parsed, until a line containing only "%" closes the upload (the
+ *	conventional gcode file terminator). Uploading a name that already
+ *	exists deletes the old entry first, so re-uploads just work - the old
+ *	text pages stay dead until the next $jobx=1.
+ *
+ *	job_capture_line() returns true if it consumed the line (see the
+ *	capture hook in _dispatch()). Per-line responses are suppressed during
+ *	an upload; XON/XOFF flow control still paces the host against the
+ *	flash program time.
+ */
+stat_t job_store_begin(const char *name)
+{
+	jobDirEntry_t entry;
+	uint8_t len = strlen(name);
+
+	if ((len == 0) || (len > JOB_NAME_LEN)) { return (STAT_INPUT_VALUE_RANGE_ERROR);}
+	if (_find_job(name, &entry) >= 0) { job_delete(name);}	// re-upload replaces
+
+	int8_t slot = -1;
+	for (uint8_t s=0; s<JOB_DIR_SLOTS; s++) {			// need a never-programmed slot
+		_read_entry(s, &entry);
+		if (entry.magic == 0xFF) { slot = s; break;}
+	}
+	if (slot < 0) { return (STAT_NO_BUFFER_SPACE);}		// directory full - $jobx=1 to reclaim
+
+	memset(&job.entry, 0, sizeof(jobDirEntry_t));
+	job.entry.magic = JOB_MAGIC;
+	strncpy(job.entry.name, name, JOB_NAME_LEN);
+	job.entry.start_page = _next_free_page();
+	job.slot = slot;
+	job.wr_offset = (uint32_t)job.entry.start_page << 8;
+	job.capturing = true;
+	return (STAT_OK);
+}
+
+uint8_t job_capture_line(char *line)
+{
+	if (job.capturing == false) { return (false);}
+
+	if ((line[0] == '%') && (line[1] == NUL)) {			// end of upload
+		xio_write_spi_flash(JOB_SPI_DEV, job.wr_offset++, "", 1);	// NUL terminate the job
+		job.entry.pages = ((job.wr_offset - ((uint32_t)job.entry.start_page << 8)) + 255) >> 8;
+		xio_write_spi_flash(JOB_SPI_DEV, JOB_DIR_ADDR(job.slot),
+							(char *)&job.entry, sizeof(jobDirEntry_t));
+		job.capturing = false;
+		fprintf_P(stderr, PSTR("{\"job\":{\"name\":\"%s\",\"pages\":%d}}\n"),
+			job.entry.name, job.entry.pages);
+		return (true);
+	}
+	uint16_t len = strlen(line);
+	if (((job.wr_offset + len + 2) >> 8) >= BBX_FIRST_PAGE) {	// +2 for \n and final NUL; the flight recorder owns the top pages
+		job.capturing = false;							// out of flash - drop the upload
+		rpt_exception(STAT_NO_BUFFER_SPACE, 0);
+		return (true);
+	}
+	xio_write_spi_flash(JOB_SPI_DEV, job.wr_offset, line, len);
+	job.wr_offset += len;
+	xio_write_spi_flash(JOB_SPI_DEV, job.wr_offset++, "\n", 1);
+	return (true);
+}
+
+/*
+ * job_count_line() - count a line consumed from a running job
+ *
+ *	Called from _dispatch() for every completed input line. Lines from the
+ *	flash job device are counted so checkpoints can record how deep into
+ *	the file the job has read. Returns true if the line should be discarded
+ *	- which is how a resume fast-forwards: the file is re-read from the top
+ *	at local flash speed and every line below the checkpoint is dropped
+ *	here before it reaches the parsers.
+ */
+uint8_t job_count_line(void)
+{
+	if (tg.primary_src != XIO_DEV_FLASH) { return (false);}
+	if (++job.lines_read <= job.skip_to) { return (true);}	// fast-forwarding to a checkpoint
+	return (false);
+}
+
+/*
+ * job_print_list() - list stored jobs; returns the live entry count
+ */
+uint8_t job_print_list(void)
+{
+	jobDirEntry_t entry;
+	uint8_t count = 0;
+
+	for (uint8_t slot=0; slot<JOB_DIR_SLOTS; slot++) {
+		_read_entry(slot, &entry);
+		if (entry.magic != JOB_MAGIC) { continue;}
+		count++;
+		if (cfg.comm_mode == TEXT_MODE) {
+			fprintf_P(stderr, PSTR("job %-10s %5d pages\n"), entry.name, entry.pages);
+		} else {
+			fprintf_P(stderr, PSTR("{\"job\":{\"name\":\"%s\",\"pages\":%d}}\n"),
+				entry.name, entry.pages);
+		}
+	}
+	return (count);
+}
+
+/*
+ * job_erase_all() - bulk erase the flash and reclaim all job space
+ *
+ *	Blocks for the duration of the chip erase (seconds) - this is a bench
+ *	maintenance operation, not something to run mid-job.
+ */
+stat_t job_erase_all(void)
+{
+	if (job.capturing == true) { return (STAT_CONFIG_NOT_TAKEN);}
+	xio_erase_spi_flash(JOB_SPI_DEV);
+	return (STAT_OK);
+}
+
+/**** Recovery checkpoints ***************************************************
+ *
+ *	A fault mid-job (step loss, limit strike, power loss) lands the board in
+ *	an alarm that only a reset clears - and without a record of where the
+ *	job was, the part is scrap. While a stored job is running, a checkpoint
+ *	of the machine state is written to EEPROM every $jcs seconds (0 ships
+ *	disabled). $jobc on the recovered board rehomes, restores the
+ *	checkpointed gcode context, rapids to the checkpoint position and
+ *	re-runs the job from the flash, discarding lines below the checkpoint.
+ *
+ *	The recorded line count is rewound by the number of blocks queued in the
+ *	planner when the checkpoint was captured, so the checkpoint trails what
+ *	has actually been cut (lines are counted as they are read, which runs a
+ *	planner-queue ahead of the tool). The rewind over-corrects for lines
+ *	that queue more than one block (arcs, canned cycles) or none at all, so
+ *	a resume may re-run a short stretch of already-cut path - conservative
+ *	in the right direction.
+ *
+ *	Writes are staggered one EEPROM page per controller pass, same rationale
+ *	as cfg_nvm_persistence_callback() - but unlike the config queue they
+ *	must run mid-cycle, since mid-cycle is the whole point. A write torn by
+ *	a power loss fails the record checksum and $jobc refuses it.
+ */
+
+static uint16_t _checkpoint_sum(const jobCheckpoint_t *cp)
+{
+	const uint8_t *p = (const uint8_t *)cp;
+	uint16_t sum = 0;
+
+	for (uint8_t i=0; i < (sizeof(jobCheckpoint_t) - sizeof(cp->checksum)); i++) {
+		sum += p[i];
+	}
+	return (sum);
+}
+
+static void _checkpoint_capture(void)
+{
+	uint8_t queued = PLANNER_BUFFER_POOL_SIZE - mp_get_planner_buffers_available();
+
+	job.cp.magic = JOB_CHECKPOINT_MAGIC;
+	job.cp.start_page = job.start_page;
+	job.cp.linenum = (job.lines_read > queued) ? (job.lines_read - queued) : 0;
+	for (uint8_t i=0; i<AXES; i++) {
+		job.cp.position[i] = cm_get_runtime_machine_position(i);
+	}
+	job.cp.feed_rate = gm.feed_rate;
+	job.cp.spindle_speed = gm.spindle_speed;
+	job.cp.units_mode = cm_get_model_units_mode();
+	job.cp.distance_mode = cm_get_model_distance_mode();
+	job.cp.coord_system = cm_get_model_coord_system();
+	job.cp.spindle_mode = cm_get_model_spindle_mode();
+	job.cp.checksum = _checkpoint_sum(&job.cp);
+}
+
+stat_t job_checkpoint_callback(void)
+{
+#ifdef __DISABLE_PERSISTENCE	// cutout for faster simulation in test
+	return (STAT_NOOP);
+#endif
+	if (cfg.job_checkpoint_sec == 0) { return (STAT_NOOP);}	// checkpointing disabled
+	if (job.cp_pages == 0) {								// no write in flight - capture due?
+		if (tg.primary_src != XIO_DEV_FLASH) { return (STAT_NOOP);}	// not running a stored job
+		if (job.call_active == true) { return (STAT_NOOP);}	// can't checkpoint an M98 call context
+		if (job.lines_read <= job.skip_to) { return (STAT_NOOP);}	// still fast-forwarding
+		if (cm.machine_state != MACHINE_CYCLE) { return (STAT_NOOP);}	// nothing moving to record
+		if (rtc.clock_ticks < job.next_checkpoint) { return (STAT_NOOP);}
+		job.next_checkpoint = rtc.clock_ticks + ((uint32_t)cfg.job_checkpoint_sec * CHECKPOINT_TICKS_PER_SEC);
+		_checkpoint_capture();
+		job.cp_pages = (sizeof(jobCheckpoint_t) + EEPROM_PAGESIZE-1) / EEPROM_PAGESIZE;
+		job.cp_page = 0;
+	}
+	uint16_t offset = (uint16_t)job.cp_page * EEPROM_PAGESIZE;
+	uint16_t size = sizeof(jobCheckpoint_t) - offset;		// last page is a partial
+	if (size > EEPROM_PAGESIZE) { size = EEPROM_PAGESIZE;}
+	EEPROM_WriteBytes(JOB_CHECKPOINT_ADDR + offset, (int8_t *)&job.cp + offset, size);
+	job.cp_page++;
+	job.cp_pages--;
+	return (STAT_OK);
+}
+
+/**** Power-fail checkpoint **************************************************
+ *
+ *	The periodic checkpoint trails the tool by up to $jcs seconds, so a
+ *	supply blip in between costs that much work. The XMEGA brownout
+ *	detector only resets the part, but the analog comparator watching a
+ *	divider of the unregulated rail (PA3) against the internal bandgap
+ *	fires milliseconds before the regulators drop out - enough budget for
+ *	two EEPROM page programs if the erase has already been paid for.
+ *
+ *	So the dump slot is pre-erased when a stored job starts and the dump
+ *	uses split (write-only) page programs, roughly halving the EEPROM time
+ *	(see EEPROM_SplitWritePage). The interrupt is one-shot: a split write
+ *	onto a programmed page ANDs the bits together, so the ISR disarms
+ *	itself and only the next job (or resume) re-arms it. $jobc prefers
+ *	this slot over the periodic one - it is never older - and consumes it.
+ *
+ *	The motor enables are dropped before anything else. The drivers are
+ *	the big load on the failing DC bus, and shedding them stretches the
+ *	hold-up time left for the writes.
+ */
+#ifdef __POWER_FAIL_CHECKPOINT
+
+#define POWERFAIL_PAGES ((sizeof(jobCheckpoint_t) + EEPROM_PAGESIZE-1) / EEPROM_PAGESIZE)
+#define POWERFAIL_FIRST_PAGE (JOB_POWERFAIL_ADDR / EEPROM_PAGESIZE)
+
+static volatile uint8_t powerfail_armed;	// one-shot gate for the comparator ISR
+
+void job_powerfail_init(void)
+{
+	PORTA.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;	// analog pin - kill the digital input buffer
+	ACA.AC0MUXCTRL = AC_MUXPOS_PIN3_gc | AC_MUXNEG_BANDGAP_gc;	// rail divider vs 1.1v bandgap
+	ACA.AC0CTRL = AC_INTMODE_FALLING_gc | AC_HYSMODE_LARGE_gc | AC_ENABLE_bm;
+}												// interrupt level stays 0 until armed
+
+static void _powerfail_arm(void)
+{
+	for (uint8_t page=0; page < POWERFAIL_PAGES; page++) {
+		EEPROM_ErasePage(POWERFAIL_FIRST_PAGE + page);	// pre-pay the erases
+	}
+	powerfail_armed = true;
+	ACA.STATUS = AC_AC0IF_bm;					// clear any stale event
+	ACA.AC0CTRL |= AC_INTLVL_HI_gc;				// losing the rail outranks everything
+}
+
+ISR(ACA_AC0_vect)
+{
+	ACA.AC0CTRL &= ~AC_INTLVL_gm;				// one shot - see notes above
+	if (powerfail_armed == false) { return;}
+	powerfail_armed = false;
+	st_disable_motors();						// shed the drivers first
+	if (tg.primary_src != XIO_DEV_FLASH) { return;}	// the job already ended - nothing to record
+
+	_checkpoint_capture();
+	const uint8_t *p = (const uint8_t *)&job.cp;
+	for (uint8_t page=0; page < POWERFAIL_PAGES; page++) {
+		uint16_t offset = (uint16_t)page * EEPROM_PAGESIZE;
+		uint16_t size = sizeof(jobCheckpoint_t) - offset;	// last page is a partial
+		if (size > EEPROM_PAGESIZE) { size = EEPROM_PAGESIZE;}
+		for (uint8_t i=0; i < size; i++) {
+			EEPROM_LoadByte(i, p[offset + i]);
+		}
+		EEPROM_SplitWritePage(POWERFAIL_FIRST_PAGE + page);
+	}
+	EEPROM_WaitForNVM();						// committed before the rail can finish falling
+}
+
+#else
+void job_powerfail_init(void) { return;}
+#endif // __POWER_FAIL_CHECKPOINT
+
+/*
+ * job_resume()          - start a rehome-and-resume from the EEPROM checkpoint
+ * job_resume_callback() - sequence the resume, one phase per planner drain
+ *
+ *	$jobc=1 validates the record and kicks off a homing cycle - after an
+ *	alarm (or a power cycle) the position counters are meaningless, and
+ *	homing is what makes the checkpointed machine coordinates real again.
+ *	The callback then waits out each queued phase exactly the way the cycle
+ *	continuations do: spindle up, rapid to the checkpoint position in pure
+ *	machine coordinates, restore the checkpointed parser context, and
+ *	re-open the job with the fast-forward armed (see job_count_line()).
+ */
+stat_t job_resume(void)
+{
+	if (cm.cycle_state != CYCLE_OFF) { return (STAT_CONFIG_NOT_TAKEN);}	// can't resume mid-cycle
+
+	EEPROM_ReadBytes(JOB_CHECKPOINT_ADDR, (int8_t *)&job.cp, sizeof(jobCheckpoint_t));
+#ifdef __POWER_FAIL_CHECKPOINT
+	jobCheckpoint_t pf;									// the power-fail dump is never older - prefer it
+	EEPROM_ReadBytes(JOB_POWERFAIL_ADDR, (int8_t *)&pf, sizeof(jobCheckpoint_t));
+	if ((pf.magic == JOB_CHECKPOINT_MAGIC) && (pf.checksum == _checkpoint_sum(&pf))) {
+		job.cp = pf;
+		uint8_t zero = 0;
+		EEPROM_WriteBytes(JOB_POWERFAIL_ADDR, (int8_t *)&zero, 1);	// one resume per dump
+	}
+#endif
+	if ((job.cp.magic != JOB_CHECKPOINT_MAGIC) ||
+		(job.cp.checksum != _checkpoint_sum(&job.cp))) {
+		return (STAT_INPUT_VALUE_UNSUPPORTED);				// no valid checkpoint on record
+	}
+	ritorno(cm_homing_cycle_start());
+	job.resume = JOB_RESUME_HOMING;
+	return (STAT_OK);
+}
+
+stat_t job_resume_callback(void)
+{
+	if (job.resume == JOB_RESUME_OFF) { return (STAT_NOOP);}
+
+	if (job.resume == JOB_RESUME_HOMING) {
+		if (cm.cycle_state == CYCLE_HOMING) { return (STAT_NOOP);}	// homing continuation still running
+		if (cm.homing_state != HOMING_HOMED) {				// homing failed - abandon the resume
+			job.resume = JOB_RESUME_OFF;
+			return (STAT_OK);								// the homing cycle reported its own failure
+		}
+		if (cm_isbusy() == true) { return (STAT_NOOP);}		// sync to the final homing move
+		cm_set_units_mode(MILLIMETERS);						// checkpoint values are canonical
+		cm_set_distance_mode(ABSOLUTE_MODE);
+		cm_set_spindle_speed(job.cp.spindle_speed);
+		cm_spindle_control(job.cp.spindle_mode);			// at speed before re-entering the cut
+		cm_set_absolute_override(true);						// rapid in pure machine coordinates
+		float flags[] = {1,1,1,1,1,1};
+		cm_straight_traverse(job.cp.position, flags);
+		cm_set_absolute_override(false);					// target was captured at queue time
+		job.resume = JOB_RESUME_TRAVERSE;
+		return (STAT_OK);
+	}
+	// JOB_RESUME_TRAVERSE
+	if (cm_isbusy() == true) { return (STAT_NOOP);}			// wait out the rapid
+	cm_set_feed_rate(job.cp.feed_rate);						// while units are still canonical mm
+	cm_set_units_mode(job.cp.units_mode);					// restore the checkpointed parser context
+	cm_set_distance_mode(job.cp.distance_mode);
+	cm_set_coord_system(job.cp.coord_system);
+	job.resume = JOB_RESUME_OFF;
+	if (xio_open(XIO_DEV_FLASH, (const char *)(uint16_t)job.cp.start_page, FLASH_FLAGS) == NULL) {
+		rpt_exception(STAT_FILE_NOT_OPEN, 0);
+		return (STAT_OK);
+	}
+	job.start_page = job.cp.start_page;
+	job.lines_read = 0;
+	job.skip_to = job.cp.linenum;							// fast-forward to the checkpoint
+	job.next_checkpoint = rtc.clock_ticks + ((uint32_t)cfg.job_checkpoint_sec * CHECKPOINT_TICKS_PER_SEC);
+#ifdef __POWER_FAIL_CHECKPOINT
+	_powerfail_arm();										// the re-run gets its own dump slot
+#endif
+	tg_set_primary_source(XIO_DEV_FLASH);
+	return (STAT_OK);
+}
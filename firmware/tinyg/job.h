@@ -0,0 +1,93 @@
+/*
+ * job.h - stored gcode job management
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef job_h
+#define job_h
+
+/* Stored job layout (see notes in job.c)
+ *
+ *	The job directory lives in the first flash page; job text follows on
+ *	256 byte page boundaries. A directory entry is exactly 16 bytes so the
+ *	directory fills one page. Deleted entries keep their extent fields so
+ *	the allocator can still skip the dead space (NOR flash can clear the
+ *	magic byte in place but can't erase single pages).
+ */
+#define JOB_NAME_LEN 10				// max characters in a job name
+#define JOB_DIR_SLOTS 16			// directory entries (16 x 16 bytes = 1 page)
+#define JOB_MAGIC 0x4A				// live entry marker ('J'); 0x00 = deleted, 0xFF = free
+#define JOB_FIRST_PAGE 1			// first page available for job text
+#define JOB_FLASH_PAGES 0x2000		// total 256 byte pages - set to the fitted part
+
+typedef struct jobDirEntry {		// one 16 byte directory entry
+	uint8_t magic;					// JOB_MAGIC, 0x00 (deleted) or 0xFF (free)
+	char name[JOB_NAME_LEN+1];		// NUL terminated job name
+	uint16_t start_page;			// first 256 byte page of the job text
+	uint16_t pages;					// pages reserved for the job text
+} jobDirEntry_t;
+
+/* Recovery checkpoint (see notes in job.c)
+ *
+ *	The checkpoint record lives near the top of the 2K EEPROM, below the
+ *	benchmark baseline slots (test.h) and above the persistent position
+ *	record (canonical_machine.c) and the config records (which grow up
+ *	from NVM_BASE_ADDR at 4 bytes per cfgArray index - see config.c).
+ *	The record survives a reset, which is the only way out of an alarm,
+ *	so $jobc works on a freshly reset board.
+ */
+#define JOB_CHECKPOINT_MAGIC 0x4350	// "CP" - marks a valid record
+#define JOB_CHECKPOINT_RESERVE 64	// bytes reserved below the baseline slots
+#define JOB_CHECKPOINT_ADDR (0x0780 - JOB_CHECKPOINT_RESERVE)
+
+typedef struct jobCheckpoint {		// keep checksum as the last field
+	uint16_t magic;					// JOB_CHECKPOINT_MAGIC when the record is valid
+	uint16_t start_page;			// first flash page of the job being run
+	uint32_t linenum;				// file lines consumed at the checkpoint
+	float position[AXES];			// machine position in canonical units (mm, deg)
+	float feed_rate;				// in mm (canonical internal form)
+	float spindle_speed;
+	uint8_t units_mode;
+	uint8_t distance_mode;
+	uint8_t coord_system;
+	uint8_t spindle_mode;
+	uint16_t checksum;				// additive sum of all preceding bytes
+} jobCheckpoint_t;
+
+/* Power-fail checkpoint slot (see __POWER_FAIL_CHECKPOINT notes in job.c)
+ *
+ *	Same record format as the periodic checkpoint, in its own reserve
+ *	below the persistent position record (canonical_machine.c).
+ */
+#define JOB_POWERFAIL_RESERVE 64	// bytes reserved below the position record
+#define JOB_POWERFAIL_ADDR (0x0700 - JOB_POWERFAIL_RESERVE)
+
+void job_powerfail_init(void);
+stat_t job_run(const char *name);
+stat_t job_call(const char *name, const uint16_t repeats);
+uint8_t job_call_eof(void);
+stat_t job_delete(const char *name);
+stat_t job_store_begin(const char *name);
+uint8_t job_capture_line(char *line);
+uint8_t job_count_line(void);
+uint8_t job_print_list(void);
+stat_t job_erase_all(void);
+stat_t job_resume(void);
+stat_t job_checkpoint_callback(void);
+stat_t job_resume_callback(void);
+
+#endif
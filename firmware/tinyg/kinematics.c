@@ -1,118 +1,254 @@
-/*
- * kinematics.c - inverse kinematics routines
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-
-#include "tinyg.h"
-#include "config.h"
-#include "gcode_parser.h"
-#include "canonical_machine.h"
-#include "kinematics.h"
-
-//static void _inverse_kinematics(float travel[], float joint[], float microseconds);
-
-/*
- * ik_kinematics() - wrapper routine for inverse kinematics
- *
- *	Calls kinematics function(s). 
- *	Performs axis mapping & conversion of length units to steps (see note)
- *	Also deals with inhibited axes
- *
- *	Note: The reason steps are returned as floats (as opposed to, say,
- *		  uint32_t) is to accommodate fractional DDA steps. The DDA deals 
- *		  with fractional step values as fixed-point binary in order to get
- *		  the smoothest possible operation. Steps are passed to the move prep
- *		  routine as floats and converted to fixed-point binary during queue 
- *		  loading. See stepper.c for details.
- */
-
-void ik_kinematics(float travel[], float steps[], float microseconds)
-{
-	uint8_t i;
-	float joint[AXES];
-
-//	_inverse_kinematics(travel, joint, microseconds);// you can insert inverse kinematics transformations here
-	memcpy(joint, travel, sizeof(float)*AXES);		 //...or just do a memcopy for cartesian machines
-
-	// Map motors to axes and convert length units to steps
-	// Most of the conversion math has already been done in steps_per_unit
-	// which takes axis travel, step angle and microsteps into account.
-	for (i=0; i<AXES; i++) {
-		if (cfg.a[i].axis_mode == AXIS_INHIBITED) { joint[i] = 0;}
-		if (cfg.m[MOTOR_1].motor_map == i) { steps[MOTOR_1] = joint[i] * cfg.m[MOTOR_1].steps_per_unit;}
-		if (cfg.m[MOTOR_2].motor_map == i) { steps[MOTOR_2] = joint[i] * cfg.m[MOTOR_2].steps_per_unit;}
-		if (cfg.m[MOTOR_3].motor_map == i) { steps[MOTOR_3] = joint[i] * cfg.m[MOTOR_3].steps_per_unit;}
-		if (cfg.m[MOTOR_4].motor_map == i) { steps[MOTOR_4] = joint[i] * cfg.m[MOTOR_4].steps_per_unit;}
-	// the above is a loop unrolled version of this:
-	//	for (uint8_t j=0; j<MOTORS; j++) {
-	//		if (cfg.m[j].motor_map == i) { steps[j] = joint[i] * cfg.m[j].steps_per_unit;}
-	//	}
-	}
-}
-
-/*
- * _inverse_kinematics() - inverse kinematics - example is for a cartesian machine
- *
- *	You can glue in inverse kinematics here, but be aware of time budget constrants.
- *	This function is run during the _exec() portion of the cycle and will therefore
- *	be run once per interpolation segment. The total time for the segment load, 
- *	including the inverse kinematics transformation cannot exceed the segment time, 
- *	and ideally should be no more than 25-50% of the segment time. Currently segments 
- *	run avery 5 ms, but this might be lowered. To profile this time look at the 
- *	time it takes to complete the mp_exec_move() function.
- */
-/*
-static void _inverse_kinematics(float travel[], float joint[], float microseconds)
-{
-	for (uint8_t i=0; i<AXES; i++) {
-		joint[i] = travel[i];
-	}	
-}
-*/
-
-//############## UNIT TESTS ################
-
-//#define __UNIT_TEST_KINEMATICS
-#ifdef __UNIT_TESTS
-#ifdef __UNIT_TEST_KINEMATICS
-
-void _ik_test_inverse_kinematics(void);
-
-void ik_unit_tests()
-{
-	_ik_test_inverse_kinematics();
-}
-
-void _ik_test_inverse_kinematics(void)
-{
-	return;
-}
-
-#endif
-#endif
+/*
+ * kinematics.c - inverse kinematics routines
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tinyg.h"
+#include "config.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "kinematics.h"
+#include "q16.h"
+
+//static void _inverse_kinematics(float travel[], float joint[], float microseconds);
+
+/*
+ * ik_kinematics() - wrapper routine for inverse kinematics
+ *
+ *	Calls kinematics function(s). 
+ *	Performs axis mapping & conversion of length units to steps (see note)
+ *	Also deals with inhibited axes
+ *
+ *	Note: The reason steps are returned as floats (as opposed to, say,
+ *		  uint32_t) is to accommodate fractional DDA steps. The DDA deals 
+ *		  with fractional step values as fixed-point binary in order to get
+ *		  the smoothest possible operation. Steps are passed to the move prep
+ *		  routine as floats and converted to fixed-point binary during queue 
+ *		  loading. See stepper.c for details.
+ */
+
+void ik_kinematics(float travel[], float steps[], float microseconds)
+{
+	uint8_t i;
+	float joint[AXES];
+
+//	_inverse_kinematics(travel, joint, microseconds);// you can insert inverse kinematics transformations here
+	memcpy(joint, travel, sizeof(float)*AXES);		 //...or just do a memcopy for cartesian machines
+
+	// Map motors to axes and convert length units to steps
+	// Most of the conversion math has already been done in steps_per_unit
+	// which takes axis travel, step angle and microsteps into account.
+	for (i=0; i<AXES; i++) {
+		if (cfg.a[i].axis_mode == AXIS_INHIBITED) { joint[i] = 0;}
+		if (cfg.m[MOTOR_1].motor_map == i) { steps[MOTOR_1] = joint[i] * cfg.m[MOTOR_1].steps_per_unit;}
+		if (cfg.m[MOTOR_2].motor_map == i) { steps[MOTOR_2] = joint[i] * cfg.m[MOTOR_2].steps_per_unit;}
+		if (cfg.m[MOTOR_3].motor_map == i) { steps[MOTOR_3] = joint[i] * cfg.m[MOTOR_3].steps_per_unit;}
+		if (cfg.m[MOTOR_4].motor_map == i) { steps[MOTOR_4] = joint[i] * cfg.m[MOTOR_4].steps_per_unit;}
+	// the above is a loop unrolled version of this:
+	//	for (uint8_t j=0; j<MOTORS; j++) {
+	//		if (cfg.m[j].motor_map == i) { steps[j] = joint[i] * cfg.m[j].steps_per_unit;}
+	//	}
+	}
+}
+
+/*
+ * ik_kinematics_substeps() - inverse kinematics emitting substep-scaled integers
+ *
+ *	Same as ik_kinematics() but multiplies by substeps_per_unit (steps_per_unit
+ *	pre-scaled by DDA_SUBSTEPS) and converts to int32 here - the single
+ *	float-to-int conversion per motor. This feeds the fixed-point prep path
+ *	(st_prep_line_substeps) which then runs entirely in integer math. The
+ *	fractional step information is preserved in the substep scaling.
+ */
+
+/* Kinematics selection
+ *
+ *	The machine geometry is selected at compile time (tinyg.h) so the
+ *	per-segment transform carries no dispatch indirection:
+ *
+ *	  (default)            general cartesian with runtime motor mapping
+ *	  __KINEMATICS_DIRECT  cartesian, unrolled when motors map 1:1 to XYZA
+ *	  __KINEMATICS_COREXY  CoreXY - motor 1 winds X+Y, motor 2 winds X-Y,
+ *	                       motors 3/4 drive Z/A directly. Takes precedence
+ *	                       over __KINEMATICS_DIRECT; runtime motor mapping
+ *	                       does not apply. The transform is two integer
+ *	                       adds in the same fixed-point units as stepper
+ *	                       prep, so CoreXY pays no float penalty.
+ */
+
+/*
+ * _direct_mapping() - true if the motors are mapped 1:1 onto the first four axes
+ *
+ *	This is the factory default and covers nearly every cartesian machine.
+ *	The mapping is runtime-configurable ($1ma etc.) so the unrolled fast
+ *	paths below verify it on each call - four byte compares, versus the
+ *	24 map lookups the general search performs - and fall through to the
+ *	general code if the machine is mapped differently.
+ */
+
+#if defined(__KINEMATICS_DIRECT) && !defined(__KINEMATICS_COREXY)
+static uint8_t _direct_mapping(void)
+{
+	return ((cfg.m[MOTOR_1].motor_map == AXIS_X) && (cfg.m[MOTOR_2].motor_map == AXIS_Y) &&
+#if (AXES >= 4)
+			(cfg.m[MOTOR_3].motor_map == AXIS_Z) && (cfg.m[MOTOR_4].motor_map == AXIS_A));
+#else
+			(cfg.m[MOTOR_3].motor_map == AXIS_Z) && (cfg.m[MOTOR_4].motor_map >= AXES));
+#endif
+}
+#endif
+
+#if defined(__KINEMATICS_DIRECT) || defined(__KINEMATICS_COREXY)
+#define DIRECT_JOINT(axis) ((cfg.a[axis].axis_mode == AXIS_INHIBITED) ? 0 : travel_q[axis])
+#define DIRECT_JOINT_F(axis) ((cfg.a[axis].axis_mode == AXIS_INHIBITED) ? 0 : travel[axis])
+#if (AXES >= 4)
+#define DIRECT_JOINT_A DIRECT_JOINT(AXIS_A)
+#define DIRECT_JOINT_A_F DIRECT_JOINT_F(AXIS_A)
+#else
+#define DIRECT_JOINT_A 0				// no rotary storage compiled in - motor 4 idles
+#define DIRECT_JOINT_A_F 0
+#endif
+#endif
+
+void ik_kinematics_substeps(float travel[], int32_t steps_X_substeps[])
+{
+#ifdef __KINEMATICS_COREXY
+	float jx = DIRECT_JOINT_F(AXIS_X);
+	float jy = DIRECT_JOINT_F(AXIS_Y);
+	steps_X_substeps[MOTOR_1] = (int32_t)((jx + jy) * cfg.m[MOTOR_1].substeps_per_unit);
+	steps_X_substeps[MOTOR_2] = (int32_t)((jx - jy) * cfg.m[MOTOR_2].substeps_per_unit);
+	steps_X_substeps[MOTOR_3] = (int32_t)(DIRECT_JOINT_F(AXIS_Z) * cfg.m[MOTOR_3].substeps_per_unit);
+	steps_X_substeps[MOTOR_4] = (int32_t)(DIRECT_JOINT_A_F * cfg.m[MOTOR_4].substeps_per_unit);
+#else
+	uint8_t i;
+	float joint[AXES];
+
+#ifdef __KINEMATICS_DIRECT
+	if (_direct_mapping()) {
+		steps_X_substeps[MOTOR_1] = (int32_t)(DIRECT_JOINT_F(AXIS_X) * cfg.m[MOTOR_1].substeps_per_unit);
+		steps_X_substeps[MOTOR_2] = (int32_t)(DIRECT_JOINT_F(AXIS_Y) * cfg.m[MOTOR_2].substeps_per_unit);
+		steps_X_substeps[MOTOR_3] = (int32_t)(DIRECT_JOINT_F(AXIS_Z) * cfg.m[MOTOR_3].substeps_per_unit);
+		steps_X_substeps[MOTOR_4] = (int32_t)(DIRECT_JOINT_A_F * cfg.m[MOTOR_4].substeps_per_unit);
+		return;
+	}
+#endif
+	memcpy(joint, travel, sizeof(float)*AXES);
+
+	for (i=0; i<AXES; i++) {
+		if (cfg.a[i].axis_mode == AXIS_INHIBITED) { joint[i] = 0;}
+		if (cfg.m[MOTOR_1].motor_map == i) { steps_X_substeps[MOTOR_1] = (int32_t)(joint[i] * cfg.m[MOTOR_1].substeps_per_unit);}
+		if (cfg.m[MOTOR_2].motor_map == i) { steps_X_substeps[MOTOR_2] = (int32_t)(joint[i] * cfg.m[MOTOR_2].substeps_per_unit);}
+		if (cfg.m[MOTOR_3].motor_map == i) { steps_X_substeps[MOTOR_3] = (int32_t)(joint[i] * cfg.m[MOTOR_3].substeps_per_unit);}
+		if (cfg.m[MOTOR_4].motor_map == i) { steps_X_substeps[MOTOR_4] = (int32_t)(joint[i] * cfg.m[MOTOR_4].substeps_per_unit);}
+	}
+#endif // __KINEMATICS_COREXY
+}
+
+/*
+ * ik_kinematics_substeps_q16() - inverse kinematics with no float math at all
+ *
+ *	Takes the axis travel in Q16.16 mm (see q16.c) and scales to substeps with
+ *	one 64 bit integer multiply per motor. substeps_per_unit is far too large
+ *	for Q16.16 so it is applied as a plain int32 (substeps_per_unit_i, derived
+ *	in config.c) - rounding it to an integer costs a relative error below
+ *	1e-7, well under a substep over any representable travel.
+ */
+
+void ik_kinematics_substeps_q16(int32_t travel_q[], int32_t steps_X_substeps[])
+{
+#ifdef __KINEMATICS_COREXY
+	int32_t jx = DIRECT_JOINT(AXIS_X);		// CoreXY belt transform - integer adds in the
+	int32_t jy = DIRECT_JOINT(AXIS_Y);		//  same Q16.16 units as the stepper prep
+	steps_X_substeps[MOTOR_1] = q16_mul_int(jx + jy, cfg.m[MOTOR_1].substeps_per_unit_i);
+	steps_X_substeps[MOTOR_2] = q16_mul_int(jx - jy, cfg.m[MOTOR_2].substeps_per_unit_i);
+	steps_X_substeps[MOTOR_3] = q16_mul_int(DIRECT_JOINT(AXIS_Z), cfg.m[MOTOR_3].substeps_per_unit_i);
+	steps_X_substeps[MOTOR_4] = q16_mul_int(DIRECT_JOINT_A, cfg.m[MOTOR_4].substeps_per_unit_i);
+#else
+	uint8_t i;
+
+#ifdef __KINEMATICS_DIRECT
+	if (_direct_mapping()) {
+		steps_X_substeps[MOTOR_1] = q16_mul_int(DIRECT_JOINT(AXIS_X), cfg.m[MOTOR_1].substeps_per_unit_i);
+		steps_X_substeps[MOTOR_2] = q16_mul_int(DIRECT_JOINT(AXIS_Y), cfg.m[MOTOR_2].substeps_per_unit_i);
+		steps_X_substeps[MOTOR_3] = q16_mul_int(DIRECT_JOINT(AXIS_Z), cfg.m[MOTOR_3].substeps_per_unit_i);
+		steps_X_substeps[MOTOR_4] = q16_mul_int(DIRECT_JOINT_A, cfg.m[MOTOR_4].substeps_per_unit_i);
+		return;
+	}
+#endif
+	for (i=0; i<AXES; i++) {
+		int32_t joint = travel_q[i];
+		if (cfg.a[i].axis_mode == AXIS_INHIBITED) { joint = 0;}
+		if (cfg.m[MOTOR_1].motor_map == i) { steps_X_substeps[MOTOR_1] = q16_mul_int(joint, cfg.m[MOTOR_1].substeps_per_unit_i);}
+		if (cfg.m[MOTOR_2].motor_map == i) { steps_X_substeps[MOTOR_2] = q16_mul_int(joint, cfg.m[MOTOR_2].substeps_per_unit_i);}
+		if (cfg.m[MOTOR_3].motor_map == i) { steps_X_substeps[MOTOR_3] = q16_mul_int(joint, cfg.m[MOTOR_3].substeps_per_unit_i);}
+		if (cfg.m[MOTOR_4].motor_map == i) { steps_X_substeps[MOTOR_4] = q16_mul_int(joint, cfg.m[MOTOR_4].substeps_per_unit_i);}
+	}
+#endif // __KINEMATICS_COREXY
+}
+
+/*
+ * _inverse_kinematics() - inverse kinematics - example is for a cartesian machine
+ *
+ *	You can glue in inverse kinematics here, but be aware of time budget constrants.
+ *	This function is run during the _exec() portion of the cycle and will therefore
+ *	be run once per interpolation segment. The total time for the segment load, 
+ *	including the inverse kinematics transformation cannot exceed the segment time, 
+ *	and ideally should be no more than 25-50% of the segment time. Currently segments 
+ *	run avery 5 ms, but this might be lowered. To profile this time look at the 
+ *	time it takes to complete the mp_exec_move() function.
+ */
+/*
+static void _inverse_kinematics(float travel[], float joint[], float microseconds)
+{
+	for (uint8_t i=0; i<AXES; i++) {
+		joint[i] = travel[i];
+	}	
+}
+*/
+
+//############## UNIT TESTS ################
+
+//#define __UNIT_TEST_KINEMATICS
+#ifdef __UNIT_TESTS
+#ifdef __UNIT_TEST_KINEMATICS
+
+void _ik_test_inverse_kinematics(void);
+
+void ik_unit_tests()
+{
+	_ik_test_inverse_kinematics();
+}
+
+void _ik_test_inverse_kinematics(void)
+{
+	return;
+}
+
+#endif
+#endif
@@ -39,6 +39,8 @@
  */
 
 void ik_kinematics(float travel[], float steps[], float microseconds);
+void ik_kinematics_substeps(float travel[], int32_t steps_X_substeps[]);
+void ik_kinematics_substeps_q16(int32_t travel_q[], int32_t steps_X_substeps[]);
 
 //#ifdef __UNIT_TESTS
 //void ik_unit_tests(void);
@@ -26,6 +26,7 @@
 #include "xmega/xmega_interrupts.h"
 //#include "xmega/xmega_eeprom.h"	// uncomment for unit tests
 #include "xmega/xmega_rtc.h"
+#include "xmega/xmega_crc.h"
 #include "xio/xio.h"
 
 #include "tinyg.h"				// #1 There are some dependencies
@@ -40,8 +41,11 @@
 #include "planner.h"
 #include "stepper.h"
 #include "spindle.h"
+#include "pendant.h"
 #include "network.h"
 #include "gpio.h"
+#include "job.h"
+#include "blackbox.h"
 #include "test.h"
 #include "pwm.h"
 
@@ -61,6 +65,8 @@ int main(void)
 
 	cli();
 
+	sys_stack_paint();				// paint free RAM for the $mem diagnostic - RAM only, so it can precede sys_init()
+
 	// system and drivers
 	sys_init();						// system hardware setup 			- must be first
 	rtc_init();						// real time counter
@@ -68,6 +74,7 @@ int main(void)
 	st_init(); 						// stepper subsystem 				- must precede gpio_init()
 	gpio_init();					// switches and parallel IO
 	pwm_init();						// pulse width modulation drivers	- must follow gpio_init()
+	crc_init();						// CRC unit and memory integrity scan
 
 	// application structures
 	tg_init(STD_IN, STD_OUT, STD_ERR);// must be first app init; reqs xio_init()
@@ -76,6 +83,9 @@ int main(void)
 	mp_init();						// motion planning subsystem
 	cm_init();						// canonical machine				- must follow cfg_init()
 	sp_init();						// spindle PWM and variables
+	pen_init();						// analog pendant (override knob)
+	job_powerfail_init();			// brownout early-warning comparator
+	bbx_init();						// trajectory flight recorder		- must follow cfg_init()
 
 	// now bring up the interupts and get started
 	PMIC_SetVectorLocationToApplication();// as opposed to boot ROM
@@ -83,7 +93,7 @@ int main(void)
 	PMIC_EnableMediumLevel();
 	PMIC_EnableLowLevel();
 	sei();							// enable global interrupts
-	rpt_print_system_ready_message();// (LAST) announce system is ready
+	rpt_request_system_ready_message();// banner prints from the first controller pass
 
 	_unit_tests();					// run any unit tests that are enabled
 	tg_canned_startup();			// run any pre-loaded commands
@@ -1,117 +1,387 @@
 /*
- * network.c - tinyg networking protocol
- * Part of TinyG project
- *
+ * network.c - tinyg networking protocol
+ * Part of TinyG project
+ *
  * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
  *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* 	This module is really nothing mre than a placeholder at this time.
- * 	"Networking" refers to a planned RS485 broadcast network to support
- *	multi-board configs and external RS485 devices such as extruders.
- *	Basic operation of RS485 on the TinyG hardware has been verified
- *	using what's in this file, but you won;t find much more.
- */
-
-#include <stdio.h>					// precursor for xio.h
-#include <stdbool.h>				// true and false
-#include <avr/pgmspace.h>			// precursor for xio.h
-#include <util/delay.h>				// for tests
-
-#include "tinyg.h"
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* 	"Networking" is an RS485 broadcast network for multi-board configs -
+ *	machines that need more motors moving in exact sync than one board
+ *	drives (e.g. twin gantries). One board is the master ($net=1): it
+ *	owns the gcode stream and the planner, and its prep stage broadcasts
+ *	every stepper segment it stages. Slave boards ($net=2) run only the
+ *	stepper load/run stages - received segments go straight into the
+ *	prep ring via st_load_segment_remote().
+ *
+ *	Shared time base: a segment is a fixed number of DDA ticks and the
+ *	DDA clocks on all boards derive from the same crystal spec, so boards
+ *	that consume the same segment stream stay aligned to within crystal
+ *	tolerance for the duration of a segment (~5 ms, i.e. sub-microsecond
+ *	error at 50 ppm). Alignment cannot drift cumulatively because slaves
+ *	consume segments in lockstep with the master's broadcast - a slave
+ *	that falls a whole segment behind has necessarily dropped a frame,
+ *	which the per-frame sequence byte catches, and the periodic SYNC
+ *	frame cross-checks the cumulative segment counts as a backstop.
+ *	Either failure alarms the slave (STAT_NETWORK_SYNC_LOST) rather than
+ *	letting a gantry axis free-run past the missing motion.
+ *
+ *	Throughput: a segment frame is 4 + sizeof(netSegment_t) bytes. At
+ *	115200 baud and the nominal 5 ms segment rate the channel runs at
+ *	about 60% occupancy, which the xio TX buffer absorbs. The broadcast
+ *	is called from the exec (MED) interrupt level; the putc's only queue
+ *	bytes, the USART TX interrupt drains them.
+ */
+
+#include <stdio.h>					// precursor for xio.h
+#include <stdbool.h>				// true and false
+#include <string.h>					// for memcpy
+#include <avr/pgmspace.h>			// precursor for xio.h
+#include <util/delay.h>				// for tests
+
+#include "tinyg.h"
 #include "network.h"
-#include "controller.h"
-#include "gpio.h"
+#include "controller.h"
+#include "canonical_machine.h"		// for cm_alarm() on lost sync
+#include "stepper.h"
+#include "gpio.h"
 #include "system.h"
-#include "xio/xio.h"
-
-/*
- * Local Scope Functions and Data
- */
-
-/*
- * net_init()
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"		// for the sync pulse drain timer
+
+/*
+ * Local Scope Functions and Data
+ */
+
+enum netRxState {					// slave frame assembly states
+	NET_RX_SOH = 0,					// waiting for start byte
+	NET_RX_TYPE,					// expecting frame type
+	NET_RX_SEQ,						// expecting sequence byte
+	NET_RX_PAYLOAD,					// assembling payload
+	NET_RX_CHECKSUM					// expecting trailing checksum
+};
+
+static struct netRxSingleton {		// slave receive state
+	uint8_t state;					// netRxState
+	uint8_t type;					// frame type being assembled
+	uint8_t seq;					// sequence byte of the frame being assembled
+	uint8_t expect_seq;				// next sequence number expected
+	uint8_t synced;					// false until the first SYNC frame arrives
+	uint8_t count;					// payload bytes received so far
+	uint8_t length;					// payload length for this frame type
+	uint8_t checksum;				// running XOR of type, seq and payload
+	uint8_t pending;				// a complete frame is waiting for a free prep slot
+	uint32_t segments;				// segments applied since last SYNC
+	uint8_t payload[sizeof(netSegment_t)];
+} nr;
+
+static uint8_t net_tx_seq;			// master's rolling frame sequence number
+static uint32_t net_tx_segments;	// master's segments since last SYNC frame
+
+static struct netMasterSingleton {	// master sync pulse state
+	volatile uint8_t pulse_pending;	// a sync pulse has been requested
+	volatile uint32_t drain_tick;	// RTC tick when the TX buffer was last seen busy
+} ms;
+
+static void _send_frame(uint8_t type, const uint8_t *payload, uint8_t len);
+static uint8_t _payload_length(uint8_t type);
+static stat_t _apply_frame(void);
+
+/*
+ * net_init()
+ *
+ *	Slaves keep USB as the command console - the RS485 byte stream belongs
+ *	exclusively to net_slave_callback()'s frame assembler and must not be
+ *	read by the command dispatcher. Masters announce themselves with an
+ *	initial SYNC frame so slaves that are already up arm their sequence
+ *	tracking; slaves must be online before the master starts a job.
+ */
+void net_init()
+{
+	if (tg.network_mode == NETWORK_SLAVE) {
+		nr.state = NET_RX_SOH;
+		nr.synced = false;
+		nr.pending = false;
+	}
+	if (tg.network_mode == NETWORK_MASTER) {
+		net_tx_segments = 0;
+		ms.pulse_pending = false;
+		_send_frame(NET_FRAME_SYNC, (uint8_t *)&net_tx_segments, sizeof(uint32_t));
+	}
+	if (tg.network_mode != NETWORK_STANDALONE) {	// bring up the sync line
+		if (tg.network_mode == NETWORK_MASTER) {
+			NET_SYNC_PORT.OUTCLR = NET_SYNC_BIT_bm;
+			NET_SYNC_PORT.DIRSET = NET_SYNC_BIT_bm;	// master drives the line
+		} else {
+			NET_SYNC_PORT.DIRCLR = NET_SYNC_BIT_bm;
+		}
+		NET_SYNC_PORT.PIN0CTRL = PORT_ISC_BOTHEDGES_gc;
+		NET_SYNC_PORT.INT0MASK = NET_SYNC_BIT_bm;
+		NET_SYNC_PORT.INTCTRL = PORT_INT0LVL_HI_gc;	// same level as the loader
+	}
+	xio_enable_rs485_rx();		// needed for clean start for RS-485;
+}
+
+/*
+ * net_request_sync_pulse()	  - master: schedule a start pulse on the sync line
+ * net_master_sync_callback() - master: fire the pulse once slaves are ready
+ *
+ *	Called by the loader (via _request_load_move) when motion starts from
+ *	idle - the request is only latched here because the segment frames for
+ *	the start may still be sitting in the RS485 TX buffer. The controller
+ *	callback waits for the TX buffer to drain, then NET_START_DELAY_TICKS
+ *	more so the slaves' controller loops can stage the received segments,
+ *	then toggles the line. The edge interrupt starts all armed DDAs at
+ *	once, including the master's own (see sync line notes in stepper.c).
+ */
+void net_request_sync_pulse()
+{
+	ms.drain_tick = rtc.clock_ticks;
+	ms.pulse_pending = true;
+}
+
+stat_t net_master_sync_callback()
+{
+	if ((tg.network_mode != NETWORK_MASTER) || (ms.pulse_pending == false)) {
+		return (STAT_NOOP);
+	}
+	xioUsart_t *dx = &us[XIO_DEV_RS485 - XIO_DEV_USART_OFFSET];
+	if (xio_get_tx_bufcount_usart(dx) != 0) {		// frames still draining
+		ms.drain_tick = rtc.clock_ticks;
+		return (STAT_EAGAIN);
+	}
+	if ((rtc.clock_ticks - ms.drain_tick) < NET_START_DELAY_TICKS) {
+		return (STAT_EAGAIN);						// let slaves stage the frames
+	}
+	ms.pulse_pending = false;
+	NET_SYNC_PORT.OUTTGL = NET_SYNC_BIT_bm;			// edge starts all armed DDAs
+	return (STAT_OK);
+}
+
+void net_forward(unsigned char c)
+{
+	xio_putc(XIO_DEV_RS485, c);	// write to RS485 port
+}
+
+/*
+ * _send_frame() - serialize one frame onto the RS485 channel
+ *
+ *	The putc's append to the xio TX buffer; the USART TX interrupt drains
+ *	it, so this is safe to call from the exec (MED) interrupt level as
+ *	long as the channel keeps up (see occupancy note in the file header).
+ */
+static void _send_frame(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+	uint8_t checksum = type ^ net_tx_seq;
+
+	xio_putc(XIO_DEV_NET, NET_SOH);
+	xio_putc(XIO_DEV_NET, type);
+	xio_putc(XIO_DEV_NET, net_tx_seq++);
+	for (uint8_t i=0; i<len; i++) {
+		checksum ^= payload[i];
+		xio_putc(XIO_DEV_NET, payload[i]);
+	}
+	xio_putc(XIO_DEV_NET, checksum);
+}
+
+/*
+ * net_broadcast_segment() - master: broadcast one prepped segment
+ * net_broadcast_dwell()   - master: broadcast a dwell
+ *
+ *	Called from the stepper prep functions after the local prep buffer is
+ *	staged (see st_prep_line_substeps). Every NET_SYNC_INTERVAL segments a
+ *	SYNC frame carrying the running segment count is interleaved so slaves
+ *	can cross-check that they applied exactly as many.
  */
-void net_init() 
-{
-	// re-point IO if in slave mode
-	if (tg.network_mode == NETWORK_SLAVE) {
-		tg_init(XIO_DEV_RS485, XIO_DEV_USB, XIO_DEV_USB);
-		tg_set_secondary_source(XIO_DEV_USB);
-	}
-	xio_enable_rs485_rx();		// needed for clean start for RS-485;
+void net_broadcast_segment(netSegment_t *seg)
+{
+	_send_frame(NET_FRAME_SEGMENT, (uint8_t *)seg, sizeof(netSegment_t));
+	if (++net_tx_segments >= NET_SYNC_INTERVAL) {
+		_send_frame(NET_FRAME_SYNC, (uint8_t *)&net_tx_segments, sizeof(uint32_t));
+		net_tx_segments = 0;
+	}
+}
+
+void net_broadcast_dwell(uint32_t ticks)
+{
+	_send_frame(NET_FRAME_DWELL, (uint8_t *)&ticks, sizeof(uint32_t));
+}
+
+static uint8_t _payload_length(uint8_t type)
+{
+	if (type == NET_FRAME_SEGMENT) { return (sizeof(netSegment_t));}
+	return (sizeof(uint32_t));		// SYNC and DWELL both carry a uint32_t
+}
+
+/*
+ * _apply_frame() - hand a completed frame to the stepper subsystem
+ *
+ *	Returns STAT_EAGAIN if the prep ring has no free slot yet - the frame
+ *	stays pending and is retried on the next controller pass. The RS485 RX
+ *	buffer absorbs the stream in the meantime (a full prep ring means the
+ *	slave is ahead of realtime, so the backlog is bounded).
+ */
+static stat_t _apply_frame()
+{
+	switch (nr.type) {
+		case NET_FRAME_SYNC: {
+			uint32_t count;
+			memcpy(&count, nr.payload, sizeof(uint32_t));
+			if ((nr.synced == true) && (nr.segments != count)) {
+				cm_alarm(STAT_NETWORK_SYNC_LOST);
+				return (STAT_NETWORK_SYNC_LOST);
+			}
+			nr.synced = true;		// first SYNC arms sequence tracking
+			nr.expect_seq = nr.seq + 1;
+			nr.segments = 0;
+			return (STAT_OK);
+		}
+		case NET_FRAME_SEGMENT: {
+			if (nr.synced == false) { return (STAT_OK);}	// don't join a stream mid-job
+			ritorno(st_load_segment_remote((netSegment_t *)nr.payload));
+			nr.segments++;
+			return (STAT_OK);
+		}
+		case NET_FRAME_DWELL: {
+			if (nr.synced == false) { return (STAT_OK);}
+			uint32_t ticks;
+			memcpy(&ticks, nr.payload, sizeof(uint32_t));
+			return (st_load_dwell_remote(ticks));
+		}
+	}
+	return (STAT_OK);				// unknown types are skipped silently
+}
+
+/*
+ * net_slave_callback() - assemble and apply frames from the RS485 stream
+ *
+ *	Called from the controller main loop (slaves only). Drains the RX
+ *	buffer through a byte-at-a-time frame assembler. A checksum failure or
+ *	sequence gap means motion was lost on the wire, which on a multi-board
+ *	gantry is a positional error - the slave alarms rather than continue.
+ */
+stat_t net_slave_callback()
+{
+	int c;
+
+	if (tg.network_mode != NETWORK_SLAVE) { return (STAT_NOOP);}
+	if (nr.pending == true) {
+		if (_apply_frame() == STAT_EAGAIN) { return (STAT_EAGAIN);}	// wait for a prep slot
+		nr.pending = false;
+	}
+	while ((c = xio_getc(XIO_DEV_NET)) != _FDEV_ERR) {
+		switch (nr.state) {
+			case NET_RX_SOH: {
+				if ((uint8_t)c == NET_SOH) { nr.state = NET_RX_TYPE;}
+				break;
+			}
+			case NET_RX_TYPE: {
+				nr.type = (uint8_t)c;
+				nr.checksum = (uint8_t)c;
+				nr.length = _payload_length(nr.type);
+				nr.state = NET_RX_SEQ;
+				break;
+			}
+			case NET_RX_SEQ: {
+				nr.seq = (uint8_t)c;
+				nr.checksum ^= (uint8_t)c;
+				nr.count = 0;
+				nr.state = NET_RX_PAYLOAD;
+				break;
+			}
+			case NET_RX_PAYLOAD: {
+				nr.payload[nr.count] = (uint8_t)c;
+				nr.checksum ^= (uint8_t)c;
+				if (++nr.count >= nr.length) { nr.state = NET_RX_CHECKSUM;}
+				break;
+			}
+			case NET_RX_CHECKSUM: {
+				nr.state = NET_RX_SOH;
+				if ((uint8_t)c != nr.checksum) {
+					cm_alarm(STAT_NETWORK_SYNC_LOST);
+					return (STAT_NETWORK_SYNC_LOST);
+				}
+				if ((nr.synced == true) && (nr.seq != nr.expect_seq)) {
+					cm_alarm(STAT_NETWORK_SYNC_LOST);
+					return (STAT_NETWORK_SYNC_LOST);
+				}
+				nr.expect_seq = nr.seq + 1;
+				if (_apply_frame() == STAT_EAGAIN) {
+					nr.pending = true;			// retry on the next pass
+					return (STAT_EAGAIN);
+				}
+				break;
+			}
+		}
+	}
+	return (STAT_OK);
+}
+
+/* 
+ * net_test_rxtx() - test transmission from master to slave
+ * net_test_loopback() - test transmission from master to slave and looping back
+ */
+
+uint8_t net_test_rxtx(uint8_t c) 
+{
+	int d;
+
+	// master operation
+	if (tg.network_mode == NETWORK_MASTER) {
+		if ((c < 0x20) || (c >= 0x7F)) { c = 0x20; }
+		c++;
+		xio_putc(XIO_DEV_RS485, c);			// write to RS485 port
+		xio_putc(XIO_DEV_USB, c);			// write to USB port
+		_delay_ms(2);
+
+	// slave operation
+	} else {
+		if ((d = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
+			xio_putc(XIO_DEV_USB, d);
+		}
+	}
+	return (c);
+}
+
+uint8_t net_test_loopback(uint8_t c)
+{
+	if (tg.network_mode == NETWORK_MASTER) {
+		// send a character
+		if ((c < 0x20) || (c >= 0x7F)) { c = 0x20; }
+		c++;
+		xio_putc(XIO_DEV_RS485, c);			// write to RS485 port
+		
+		// wait for loopback character
+		while (true) {
+			if ((c = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
+				xio_putc(XIO_DEV_USB, c);			// write to USB port
+			}
+		}
+	} else {
+		if ((c = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
+			xio_putc(XIO_DEV_RS485, c);			// write back to master
+			xio_putc(XIO_DEV_USB, c);			// write to slave USB
+		}
+	}
+	_delay_ms(2);
+	return (c);
 }
-
-void net_forward(unsigned char c)
-{
-	xio_putc(XIO_DEV_RS485, c);	// write to RS485 port
-}
-
-/* 
- * net_test_rxtx() - test transmission from master to slave
- * net_test_loopback() - test transmission from master to slave and looping back
- */
-
-uint8_t net_test_rxtx(uint8_t c) 
-{
-	int d;
-
-	// master operation
-	if (tg.network_mode == NETWORK_MASTER) {
-		if ((c < 0x20) || (c >= 0x7F)) { c = 0x20; }
-		c++;
-		xio_putc(XIO_DEV_RS485, c);			// write to RS485 port
-		xio_putc(XIO_DEV_USB, c);			// write to USB port
-		_delay_ms(2);
-
-	// slave operation
-	} else {
-		if ((d = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
-			xio_putc(XIO_DEV_USB, d);
-		}
-	}
-	return (c);
-}
-
-uint8_t net_test_loopback(uint8_t c)
-{
-	if (tg.network_mode == NETWORK_MASTER) {
-		// send a character
-		if ((c < 0x20) || (c >= 0x7F)) { c = 0x20; }
-		c++;
-		xio_putc(XIO_DEV_RS485, c);			// write to RS485 port
-		
-		// wait for loopback character
-		while (true) {
-			if ((c = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
-				xio_putc(XIO_DEV_USB, c);			// write to USB port
-			}
-		}
-	} else {
-		if ((c = xio_getc(XIO_DEV_RS485)) != _FDEV_ERR) {
-			xio_putc(XIO_DEV_RS485, c);			// write back to master
-			xio_putc(XIO_DEV_USB, c);			// write to slave USB
-		}
-	}
-	_delay_ms(2);
-	return (c);
-}
-
+
@@ -1,9 +1,9 @@
-/*
+/*
  * network.h - tinyg networking protocol
  * Part of TinyG project
- *
- * Copyright (c) 2011 - 2012 Alden S. Hart Jr.
- *
+ *
+ * Copyright (c) 2011 - 2012 Alden S. Hart Jr.
+ *
  * This file ("the software") is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License, version 2 as published by the
  * Free Software Foundation. You should have received a copy of the GNU General Public
@@ -23,9 +23,9 @@
  * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
  * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-#ifndef network_h
-#define network_h
+ */
+#ifndef network_h
+#define network_h
 
 /*
  * Global Scope Functions
@@ -44,5 +44,65 @@ uint8_t net_test_loopback(uint8_t c);
 
 #define XIO_DEV_NET XIO_DEV_RS485	// define the network channel
 //#define net_forward(c) (xio_putc(XIO_DEV_NET,c))
-
-#endif
+
+/***** RS485 segment streaming *****
+ *
+ *	Multi-board synchronized motion. The master plans and execs normally;
+ *	every segment its prep stage stages for the loader is also broadcast
+ *	over RS485. Slave boards ($net=2) run no planning at all - received
+ *	segments are written straight into the stepper prep ring and consumed
+ *	by the ordinary load/run stages, so all boards step from identical
+ *	segment streams. See notes in network.c for the shared time base.
+ *
+ *	Frame format:  SOH, type, seq, payload[], checksum
+ *	where checksum is the XOR of type, seq and all payload bytes. The seq
+ *	byte increments per frame so a slave detects dropped frames; a gap on
+ *	a gantry axis is dangerous, so it alarms (STAT_NETWORK_SYNC_LOST)
+ *	rather than free-running past the missing segment.
+ */
+#define NET_SOH 0x85				// frame start byte
+#define NET_SYNC_INTERVAL 256		// master sends a SYNC frame every this many segments
+
+enum netFrameType {
+	NET_FRAME_SYNC = 1,				// carries master's cumulative segment count
+	NET_FRAME_SEGMENT,				// carries one netSegment_t
+	NET_FRAME_DWELL					// carries dwell length in RTC ticks (uint32_t)
+};
+
+typedef struct netSegment {			// wire payload of one prepped segment
+	uint16_t dda_period;			// DDA clock period setting
+	uint32_t dda_ticks;				// DDA ticks for the segment
+	uint32_t dda_ticks_X_substeps;	// DDA ticks scaled by substep factor
+	struct {
+		uint32_t phase_increment;	// total substeps in the segment
+		uint8_t dir;				// raw direction - slaves apply local polarity
+	} m[MOTORS];
+} netSegment_t;
+
+void net_broadcast_segment(netSegment_t *seg);
+void net_broadcast_dwell(uint32_t ticks);
+stat_t net_slave_callback(void);
+
+/***** Sync line *****
+ *
+ *	One spare port pin is wired between all boards and driven by the master.
+ *	An edge on it marks a master segment boundary; an armed board starts its
+ *	DDA on the edge, so DDAs start within interrupt latency (~1-2 us, under
+ *	one DDA tick) of each other. Running slaves use the edges to measure
+ *	clock drift against the master. See the sync line notes in stepper.c.
+ *
+ *	PB0 is used - PORTB is otherwise unclaimed except PB3 (SPI SS2). The
+ *	master also listens to its own pin (XMEGA output pins still feed the
+ *	input buffer), so all boards start from the same edge interrupt.
+ */
+#define NET_SYNC_PORT PORTB				// sync line port (shared board-to-board)
+#define NET_SYNC_BIT_bp (0)				// PB0
+#define NET_SYNC_BIT_bm (1<<NET_SYNC_BIT_bp)
+#define NET_SYNC_ISR_vect PORTB_INT0_vect
+#define NET_START_DELAY_TICKS (2)		// RTC ticks from TX drained to start pulse
+#define NET_SYNC_TRIM_TICKS (4)			// max DDA ticks of drift trimmed per segment
+
+void net_request_sync_pulse(void);
+stat_t net_master_sync_callback(void);
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * pendant.c - analog pendant (override knob) driver
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*
+ *	A feed override knob routed through the host adds a serial round trip and
+ *	competes with the streaming link. This driver reads a potentiometer wired
+ *	to ADCA channel 1 (PA1) instead, and applies it straight to the feed
+ *	override machinery - a zero-serial-cost override source that keeps
+ *	working when the host UI is busy or the link is saturated.
+ *
+ *	pen_rtc_callback() runs in the RTC interrupt chain (see xmega_rtc.c):
+ *	each tick it collects the completed conversion, quantizes it to
+ *	PEN_STEPS knob positions, and starts the next one - a few cycles of ISR
+ *	work, no waiting. When the position moves by more than one step (the
+ *	extra step is hysteresis against boundary chatter) the change is flagged
+ *	for the main loop. pen_callback() then maps the position linearly onto
+ *	[FEED_OVERRIDE_MIN_FACTOR, FEED_OVERRIDE_MAX_FACTOR] and applies it via
+ *	mp_feed_rate_override() - the same bounded-work replan path M50.1 uses.
+ *	Worst-case response is one RTC tick plus one controller pass (~10 ms).
+ *
+ *	The knob honors M48/M49: with overrides disabled it is inert, and the
+ *	model factor still tracks the knob so re-enabling picks up the current
+ *	physical position rather than a stale one. The knob and M50.1 share
+ *	gm.feed_rate_override_factor - last writer wins, which is the expected
+ *	behavior for a physical knob.
+ *
+ *	The ADC common registers are set up identically to the spindle load
+ *	sense init in spindle.c - the two features coexist on channels 0 and 1.
+ */
+
+#include <avr/io.h>
+#include <math.h>
+#include "tinyg.h"
+#include "util.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "config.h"
+#include "pendant.h"
+
+#ifdef __ANALOG_PENDANT
+
+#define PEN_STEPS 128				// knob positions (quantized from 12 bit conversions)
+#define PEN_QUANTIZE_SHIFT 5		// 4096 conversion codes >> 5 = 128 positions
+
+static struct penSingleton {
+	volatile uint8_t position;		// quantized knob position, 0 - PEN_STEPS-1 (ISR written)
+	volatile uint8_t changed;		// knob moved - apply it from the main loop
+} pen;
+
+/*
+ * pen_init() - set up the pendant ADC channel
+ */
+void pen_init(void)
+{
+	ADCA.CTRLB = ADC_RESOLUTION_12BIT_gc;
+	ADCA.REFCTRL = ADC_REFSEL_VCC_gc;					// Vcc/1.6 reference
+	ADCA.PRESCALER = ADC_PRESCALER_DIV128_gc;
+	ADCA.CH1.CTRL = ADC_CH_INPUTMODE_SINGLEENDED_gc;
+	ADCA.CH1.MUXCTRL = ADC_CH_MUXPOS_PIN1_gc;			// knob wiper on PA1
+	ADCA.CTRLA = ADC_ENABLE_bm;
+}
+
+/*
+ * pen_rtc_callback() - sample the knob (runs at RTC interrupt level)
+ */
+void pen_rtc_callback(void)
+{
+	if ((ADCA.CH1.INTFLAGS & ADC_CH_CHIF_bm) != 0) {
+		ADCA.CH1.INTFLAGS = ADC_CH_CHIF_bm;				// written 1 to clear
+		uint8_t position = (uint8_t)(ADCA.CH1.RES >> PEN_QUANTIZE_SHIFT);
+		if (abs(position - pen.position) > 1) {			// > 1 step is hysteresis
+			pen.position = position;
+			pen.changed = true;
+		}
+	}
+	ADCA.CH1.CTRL |= ADC_CH_START_bm;					// start the next conversion
+}
+
+/*
+ * pen_callback() - apply a knob change to the feed override (main loop)
+ */
+stat_t pen_callback(void)
+{
+	if (pen.changed == false) { return (STAT_NOOP);}
+	pen.changed = false;								// single byte - atomic vs the ISR
+
+	float factor = FEED_OVERRIDE_MIN_FACTOR + ((float)pen.position / (PEN_STEPS-1)) *
+				   (FEED_OVERRIDE_MAX_FACTOR - FEED_OVERRIDE_MIN_FACTOR);
+	gm.feed_rate_override_factor = factor;				// track even when inert (see notes)
+	if (gm.feed_rate_override_enable == false) { return (STAT_NOOP);}	// M49 - knob is inert
+	return (mp_feed_rate_override(true, factor));
+}
+
+#else
+
+void pen_init(void) {}
+stat_t pen_callback(void) { return (STAT_NOOP);}
+
+#endif // __ANALOG_PENDANT
@@ -1,475 +1,740 @@
-/*
- * plan_arc.c - arc planning and motion execution
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- * Portions copyright (c) 2009 Simen Svale Skogsrud
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-#include <stdlib.h>
-#include <math.h>
-#include <stdio.h>				// precursor for xio.h
-#include <avr/pgmspace.h>		// precursor for xio.h
-
-#include "xio/xio.h"			// support trap and debug statements
-#include "tinyg.h"
-#include "config.h"
-#include "controller.h"			// only needed for line number
-#include "canonical_machine.h"
-#include "util.h"
-#include "plan_arc.h"
-#include "planner.h"
-#include "kinematics.h"
-
-/*
- * Local functions
- */
-static stat_t _compute_center_arc(void);
-static stat_t _get_arc_radius(void);
-static float _get_arc_time (const float linear_travel, const float angular_travel, const float radius);
-static float _get_theta(const float x, const float y);
-
-/*****************************************************************************
- * mp_arc() - setup an arc move for runtime
- *
- *	Generates an arc by queueing line segments to the move buffer.
- *	The arc is approximated by generating a large number of tiny, linear
- *	segments. The length of the segments is configured in motion_control.h
- *	as MM_PER_ARC_SEGMENT.
- *
- *  Parts of this routine were originally sourced from the grbl project.
- */
-stat_t ar_arc( const float target[], 
-				const float i, const float j, const float k, 
-				const float theta, 		// starting angle
-				const float radius, 		// radius of the circle in mm
-				const float angular_travel,// radians along arc (+CW, -CCW)
-				const float linear_travel, 
-				const uint8_t axis_1, 		// circle plane in tool space
-				const uint8_t axis_2,  		// circle plane in tool space
-				const uint8_t axis_linear,	// linear travel if helical motion
-				const float minutes,		// time to complete the move
-				const float work_offset[],	// offset from work coordinate system
-				const float min_time)		// minimum time for arc for replanning purposes
-{
-	if (ar.run_state != MOVE_STATE_OFF) {
-		return (STAT_INTERNAL_ERROR);			// (not supposed to fail)
-	}
-	ar.linenum = cm_get_model_linenum();	// get gcode model line number as debugging convenience
-
-	// "move_length" is the total mm of travel of the helix (or just arc)
-	ar.length = hypot(angular_travel * radius, fabs(linear_travel));	
-	if (ar.length < cfg.arc_segment_len) {	// too short to draw
-		return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
-	}
-
-	// load the move struct for an arc
-	cm_get_model_canonical_position_vector(ar.position);// set initial arc position
-
-//	copy_axis_vector(ar.endpoint, target);
-	ar.endpoint[axis_1] = target[0];					// save the arc endpoint
-	ar.endpoint[axis_2] = target[1];
-	ar.endpoint[axis_linear] = target[2];
-
-	copy_axis_vector(ar.work_offset, work_offset);		// propagate the work offset
-	ar.time = minutes;
-	ar.min_time = min_time;
-	ar.theta = theta;
-	ar.radius = radius;
-	ar.axis_1 = axis_1;
-	ar.axis_2 = axis_2;
-	ar.axis_linear = axis_linear;
-	ar.angular_travel = angular_travel;
-	ar.linear_travel = linear_travel;
-	
-	// Find the minimum number of segments that meets these constraints...
-	float segments_required_for_chordal_accuracy = ar.length / sqrt(4*cfg.chordal_tolerance * (2 * radius - cfg.chordal_tolerance));
-	float segments_required_for_minimum_distance = ar.length / cfg.arc_segment_len;
-	float segments_required_for_minimum_time = ar.time * MICROSECONDS_PER_MINUTE / MIN_ARC_SEGMENT_USEC;
-	ar.segments = floor(min3(segments_required_for_chordal_accuracy,
-							 segments_required_for_minimum_distance,
-							 segments_required_for_minimum_time));
-	ar.segments = max(ar.segments,1);		//...but is at least 1 segment
-
-	ar.segment_count = (uint32_t)ar.segments;
-	ar.segment_theta = ar.angular_travel / ar.segments;
-	ar.segment_linear_travel = ar.linear_travel / ar.segments;
-	ar.segment_time = ar.time / ar.segments;
-	ar.center_1 = ar.position[ar.axis_1] - sin(ar.theta) * ar.radius;
-	ar.center_2 = ar.position[ar.axis_2] - cos(ar.theta) * ar.radius;
-	ar.target[ar.axis_linear] = ar.position[ar.axis_linear];
-	ar.run_state = MOVE_STATE_RUN;
-	return (STAT_OK);
-}
-
-/*
- * ar_arc_callback() - generate an arc
- *
- *	ar_arc_callback() is structured as a continuation called by mp_move_dispatcher.
- *	Each time it's called it queues as many arc segments (lines) as it can 
- *	before it blocks, then returns.
- *
- *  Parts of this routine were originally sourced from the grbl project.
- */
-
-stat_t ar_arc_callback() 
-{
-	if (ar.run_state == MOVE_STATE_OFF) { return (STAT_NOOP);}
-	if (mp_get_planner_buffers_available() == 0) { return (STAT_EAGAIN);}
-	if (ar.run_state == MOVE_STATE_RUN) {
-		if (--ar.segment_count > 0) {
-			ar.theta += ar.segment_theta;
-			ar.target[ar.axis_1] = ar.center_1 + sin(ar.theta) * ar.radius;
-			ar.target[ar.axis_2] = ar.center_2 + cos(ar.theta) * ar.radius;
-			ar.target[ar.axis_linear] += ar.segment_linear_travel;
-			(void)MP_LINE(ar.target, ar.segment_time, ar.work_offset, 0);
-			copy_axis_vector(ar.position, ar.target);	// update runtime position	
-			return (STAT_EAGAIN);
-		} else {
-			(void)MP_LINE(ar.endpoint, ar.segment_time, ar.work_offset,0);// do last segment to the exact endpoint
-		}
-	}
-	ar.run_state = MOVE_STATE_OFF;
-	return (STAT_OK);
-}
-
-/*
- * ar_abort_arc() - stop an arc.
- *
- *	OK to call if no arc is running
- */
-
-void ar_abort_arc() 
-{
-	ar.run_state = MOVE_STATE_OFF;
-}
-
-/*****************************************************************************
- * Canonical Machining arc functions (arc prep for planning and runtime)
- * cm_arc_feed() 		 - entry point for arc prep
- * _compute_center_arc() - compute arc from I and J (arc center point)
- * _get_arc_radius() 	 - compute arc center (offset) from radius.
- * _get_arc_time()		 - compute time to complete arc at current feed rate
- */
-stat_t cm_arc_feed(float target[], float flags[],	// arc endpoints
-				   float i, float j, float k, 		// offsets
-				   float radius, 					// non-zero sets radius mode
-				   uint8_t motion_mode)				// defined motion mode
-{
-	uint8_t status = STAT_OK;
-
-	// copy parameters into the current state
-	gm.motion_mode = motion_mode;
-
-	// trap zero feed rate condition
-	if ((gm.inverse_feed_rate_mode == false) && (gm.feed_rate == 0)) {
-		return (STAT_GCODE_FEEDRATE_ERROR);
-	}
-
-	// Trap conditions where no arc movement will occur, 
-	// but the system is still in arc motion mode - this is not an error.
-	// This can happen when a F word or M word is by itself.
-	// (The tests below are organized for execution efficiency)
-	if ((i==0) && (j==0) && (radius==0) && (k==0)) {
-		if ((flags[AXIS_X] + flags[AXIS_Y] + flags[AXIS_Z] + 
-			 flags[AXIS_A] + flags[AXIS_B] + flags[AXIS_C]) == 0) {
-			return (STAT_OK);
-		}
-	}
-	// set parameters
-	cm_set_target(target,flags);
-	cm_set_arc_offset(i,j,k);
-	cm_set_arc_radius(radius);
-
-	// A non-zero radius is a radius arc. Compute the IJK offset coordinates.
-	// These will override any IJK offsets provided in the call
-	if (radius > EPSILON) {
-		if ((_get_arc_radius() != STAT_OK)) {
-			return (status);					// error return
-		}
-	}
-
-	// Introduce a short dwell if the machine is idle to enable the planning
-	// queue to begin to fill (avoids first block having to plan down to zero)
-//	if (st_isbusy() == false) {
-//		cm_dwell(PLANNER_STARTUP_DELAY_SECONDS);
-//	}
-
-	// execute the move
-	status = _compute_center_arc();
-	cm_set_gcode_model_endpoint_position(status);
-	return (status);
-}
-
-
-/*
- * _cm_compute_center_arc() - compute arc from I and J (arc center point)
- *
- *	The theta calculation sets up an clockwise or counterclockwise arc from 
- *	the current position to the target position around the center designated 
- *	by the offset vector. All theta-values measured in radians of deviance 
- *	from the positive y-axis. 
- *
- *                      | <- theta == 0
- *                    * * *
- *                  *       *
- *                *           *
- *                *     O ----T   <- theta_end (e.g. 90 degrees: theta_end == PI/2)
- *                *   /
- *                  C   <- theta_start (e.g. -145 degrees: theta_start == -PI*(3/4))
- */
-
-static stat_t _compute_center_arc()
-{
-	// calculate the theta (angle) of the current point (see header notes)
-	float theta_start = _get_theta(-gm.arc_offset[gm.plane_axis_0], -gm.arc_offset[gm.plane_axis_1]);
-	if(isnan(theta_start) == true) { return(STAT_ARC_SPECIFICATION_ERROR);}
-
-	// calculate the theta (angle) of the target point
-	float theta_end = _get_theta(
-		gm.target[gm.plane_axis_0] - gm.arc_offset[gm.plane_axis_0] - gm.position[gm.plane_axis_0], 
- 		gm.target[gm.plane_axis_1] - gm.arc_offset[gm.plane_axis_1] - gm.position[gm.plane_axis_1]);
-	if(isnan(theta_end) == true) { return (STAT_ARC_SPECIFICATION_ERROR); }
-
-	// ensure that the difference is positive so we have clockwise travel
-	if (theta_end < theta_start) { theta_end += 2*M_PI; }
-
-	// compute angular travel and invert if gcode wants a counterclockwise arc
-	// if angular travel is zero interpret it as a full circle
-	float angular_travel = theta_end - theta_start;
-	if (angular_travel == 0) {
-		if (gm.motion_mode == MOTION_MODE_CCW_ARC) { 
-			angular_travel -= 2*M_PI;
-		} else {
-			angular_travel = 2*M_PI;
-		}
-	} else {
-		if (gm.motion_mode == MOTION_MODE_CCW_ARC) { 
-			angular_travel -= 2*M_PI;
-		}
-	}
-
-	// Find the radius, calculate travel in the depth axis of the helix,
-	// and compute the time it should take to perform the move
-	float radius_tmp = hypot(gm.arc_offset[gm.plane_axis_0], gm.arc_offset[gm.plane_axis_1]);
-	float linear_travel = gm.target[gm.plane_axis_2] - gm.position[gm.plane_axis_2];
-	float move_time = _get_arc_time(linear_travel, angular_travel, radius_tmp);
-
-	// Trace the arc
-	set_vector(gm.target[gm.plane_axis_0], gm.target[gm.plane_axis_1], gm.target[gm.plane_axis_2],
-			   gm.target[AXIS_A], gm.target[AXIS_B], gm.target[AXIS_C]);
-
-	return(ar_arc(vector,
-				  gm.arc_offset[gm.plane_axis_0],
-				  gm.arc_offset[gm.plane_axis_1],
-				  gm.arc_offset[gm.plane_axis_2],
-				  theta_start, radius_tmp, angular_travel, linear_travel, 
-				  gm.plane_axis_0, gm.plane_axis_1, gm.plane_axis_2, 
-				  move_time, gm.work_offset, gm.min_time));
-}
-
-/* 
- * _get_arc_radius() - compute arc center (offset) from radius. 
- *
- *  We need to calculate the center of the circle that has the designated 
- *	radius and passes through both the current position and the target position
- *		  
- *	This method calculates the following set of equations where:
- *	`  [x,y] is the vector from current to target position, 
- *		d == magnitude of that vector, 
- *		h == hypotenuse of the triangle formed by the radius of the circle, 
- *			 the distance to the center of the travel vector. 
- *		  
- *	A vector perpendicular to the travel vector [-y,x] is scaled to the length
- *	of h [-y/d*h, x/d*h] and added to the center of the travel vector [x/2,y/2]
- *	to form the new point [i,j] at [x/2-y/d*h, y/2+x/d*h] which will be the 
- *	center of our arc.
- *        
- *		d^2 == x^2 + y^2
- *		h^2 == r^2 - (d/2)^2
- *		i == x/2 - y/d*h
- *		j == y/2 + x/d*h
- *                                        O <- [i,j]
- *                                     -  |
- *                           r      -     |
- *                               -        |
- *                            -           | h
- *                         -              |
- *           [0,0] ->  C -----------------+--------------- T  <- [x,y]
- *                     | <------ d/2 ---->|
- *                  
- *		C - Current position
- *		T - Target position
- *		O - center of circle that pass through both C and T
- *		d - distance from C to T
- *		r - designated radius
- *		h - distance from center of CT to O
- *  
- *	Expanding the equations:
- *		d -> sqrt(x^2 + y^2)
- *		h -> sqrt(4 * r^2 - x^2 - y^2)/2
- *		i -> (x - (y * sqrt(4 * r^2 - x^2 - y^2)) / sqrt(x^2 + y^2)) / 2 
- *		j -> (y + (x * sqrt(4 * r^2 - x^2 - y^2)) / sqrt(x^2 + y^2)) / 2
- * 
- *	Which can be written:  
- *		i -> (x - (y * sqrt(4 * r^2 - x^2 - y^2))/sqrt(x^2 + y^2))/2
- *		j -> (y + (x * sqrt(4 * r^2 - x^2 - y^2))/sqrt(x^2 + y^2))/2
- *  
- *	Which we for size and speed reasons optimize to:
- *		h_x2_div_d = sqrt(4 * r^2 - x^2 - y^2)/sqrt(x^2 + y^2)
- *		i = (x - (y * h_x2_div_d))/2
- *		j = (y + (x * h_x2_div_d))/2
- *
- * ----Computing clockwise vs counter-clockwise motion ----
- *
- *	The counter clockwise circle lies to the left of the target direction. 
- *	When offset is positive, the left hand circle will be generated - 
- *	when it is negative the right hand circle is generated.
- *
- *                                   T  <-- Target position
- *  
- *                                   ^ 
- *      Clockwise circles with       |     Clockwise circles with
- *		this center will have        |     this center will have
- *      > 180 deg of angular travel  |     < 180 deg of angular travel, 
- *                        \          |      which is a good thing!
- *                         \         |         /
- *  center of arc when  ->  x <----- | -----> x <- center of arc when 
- *  h_x2_div_d is positive           |             h_x2_div_d is negative
- *                                   |
- *                                   C  <-- Current position
- */
-
-static stat_t _get_arc_radius()
-{
-	float x;
-	float y;
-	float h_x2_div_d;
-
-	// Calculate the change in position along each selected axis
-	x = gm.target[gm.plane_axis_0]-gm.position[gm.plane_axis_0];
-	y = gm.target[gm.plane_axis_1]-gm.position[gm.plane_axis_1];
-
-	gm.arc_offset[0] = 0;	// reset the offsets
-	gm.arc_offset[1] = 0;
-	gm.arc_offset[2] = 0;
-
-	// == -(h * 2 / d)
-	h_x2_div_d = -sqrt(4 * square(gm.arc_radius) - (square(x) - square(y))) / hypot(x,y);
-
-	// If r is smaller than d the arc is now traversing the complex plane beyond
-	// the reach of any real CNC, and thus - for practical reasons - we will 
-	// terminate promptly
-	if(isnan(h_x2_div_d) == true) { return (STAT_FLOATING_POINT_ERROR);}
-
-	// Invert the sign of h_x2_div_d if circle is counter clockwise (see header notes)
-	if (gm.motion_mode == MOTION_MODE_CCW_ARC) { h_x2_div_d = -h_x2_div_d;}
-
-	// Negative R is g-code-alese for "I want a circle with more than 180 degrees
-	// of travel" (go figure!), even though it is advised against ever generating
-	// such circles in a single line of g-code. By inverting the sign of 
-	// h_x2_div_d the center of the circles is placed on the opposite side of 
-	// the line of travel and thus we get the unadvisably long arcs as prescribed.
-	if (gm.arc_radius < 0) { h_x2_div_d = -h_x2_div_d; }
-
-	// Complete the operation by calculating the actual center of the arc
-	gm.arc_offset[gm.plane_axis_0] = (x-(y*h_x2_div_d))/2;
-	gm.arc_offset[gm.plane_axis_1] = (y+(x*h_x2_div_d))/2;
-	return (STAT_OK);
-} 
-    
-/*
- * _get_arc_time ()
- *
- *	This is a naiive rate-limiting function. The arc drawing time is computed 
- *	not to exceed the time taken in the slowest dimension - in the arc plane
- *	or in linear travel. Maximum feed rates are compared in each dimension,
- *	but the comparison assumes that the arc will have at least one segment
- *	where the unit vector is 1 in that dimension. This is not true for any
- *	arbitrary arc, with the result that the time returned may be less than 
- *	optimal.
- *
- *	Room for improvement: At least take the hypotenuse of the planar movement 
- *	and the linear travel into account, but how many people actually use helixes?
- */
-
-static float _get_arc_time (const float linear_travel, 	// in mm
-							 const float angular_travel, 	// in radians
-							 const float radius)			// in mm
-{
-	float tmp;
-	float move_time=0;	// picks through the times and retains the slowest
-	float planar_travel = fabs(angular_travel * radius);// travel in arc plane
-
-	if (gm.inverse_feed_rate_mode == true) {
-		move_time = gm.inverse_feed_rate;
-	} else {
-		move_time = sqrt(square(planar_travel) + square(linear_travel)) / gm.feed_rate;
-	}
-	if ((tmp = planar_travel/cfg.a[gm.plane_axis_0].feedrate_max) > move_time) {
-		move_time = tmp;
-	}
-	if ((tmp = planar_travel/cfg.a[gm.plane_axis_1].feedrate_max) > move_time) {
-		move_time = tmp;
-	}
-	if ((tmp = fabs(linear_travel/cfg.a[gm.plane_axis_2].feedrate_max)) > move_time) {
-		move_time = tmp;
-	}
-	return (move_time);
-}
-
-/* 
- * _get_theta(float x, float y)
- *
- *	Find the angle in radians of deviance from the positive y axis. 
- *	negative angles to the left of y-axis, positive to the right.
- */
-
-static float _get_theta(const float x, const float y)
-{
-	float theta = atan(x/fabs(y));
-
-	if (y>0) {
-		return (theta);
-	} else {
-		if (theta>0) {
-			return ( M_PI-theta);
-    	} else {
-			return (-M_PI-theta);
-		}
-	}
-}
-
-//##########################################
-//############## UNIT TESTS ################
-//##########################################
-
-#ifdef __UNIT_TESTS
-#ifdef __UNIT_TEST_PLANNER
-
-void mp_plan_arc_unit_tests()
-{
-//	_mp_test_buffers();
-}
-
-#endif
-#endif
+/*
+ * plan_arc.c - arc planning and motion execution
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ * Portions copyright (c) 2009 Simen Svale Skogsrud
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>				// precursor for xio.h
+#include <avr/pgmspace.h>		// precursor for xio.h
+
+#include "xio/xio.h"			// support trap and debug statements
+#include "tinyg.h"
+#include "config.h"
+#include "controller.h"			// only needed for line number
+#include "canonical_machine.h"
+#include "util.h"
+#include "plan_arc.h"
+#include "planner.h"
+#include "kinematics.h"
+
+/*
+ * Local functions
+ */
+static stat_t _compute_center_arc(void);
+static stat_t _compute_spline(const float p, const float q);
+static stat_t _get_arc_radius(void);
+static float _get_arc_time (const float linear_travel, const float angular_travel, const float radius);
+static float _get_spline_time(const float length);
+static float _get_theta(const float x, const float y);
+
+/*****************************************************************************
+ * ar_arc() - setup an arc move for runtime
+ *
+ *	Computes the circular geometry and the entry / exit path tangents for the
+ *	arc and leaves it pending for ar_arc_callback() to queue as a single
+ *	native arc move (see mp_arc() in plan_line.c). The circle is interpolated
+ *	at the exec stage - no chord segmentation is performed here.
+ *
+ *  Parts of this routine were originally sourced from the grbl project.
+ */
+stat_t ar_arc( const float target[], 
+				const float i, const float j, const float k, 
+				const float radius, 		// radius of the circle in mm
+				const float angular_travel,// radians along arc (+CW, -CCW)
+				const float linear_travel, 
+				const uint8_t axis_1, 		// circle plane in tool space
+				const uint8_t axis_2,  		// circle plane in tool space
+				const uint8_t axis_linear,	// linear travel if helical motion
+				const float minutes,		// time to complete the move
+				const float work_offset[],	// offset from work coordinate system
+				const float min_time)		// minimum time for arc for replanning purposes
+{
+	if (ar.run_state != MOVE_STATE_OFF) {
+		return (STAT_INTERNAL_ERROR);			// (not supposed to fail)
+	}
+	ar.linenum = cm_get_model_linenum();	// get gcode model line number as debugging convenience
+
+	// "move_length" is the total mm of travel of the helix (or just arc)
+	ar.length = hypot(angular_travel * radius, fabs(linear_travel));	
+	if (ar.length < cfg.arc_segment_len) {	// too short to draw
+		return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
+	}
+
+	// load the move struct for an arc
+	cm_get_model_canonical_position_vector(ar.position);// set initial arc position
+
+//	copy_axis_vector(ar.endpoint, target);
+	ar.endpoint[axis_1] = target[0];					// save the arc endpoint
+	ar.endpoint[axis_2] = target[1];
+	ar.endpoint[axis_linear] = target[2];
+
+	copy_axis_vector(ar.work_offset, work_offset);		// propagate the work offset
+	ar.time = minutes;
+	ar.min_time = min_time;
+	ar.radius = radius;
+	ar.axis_1 = axis_1;
+	ar.axis_2 = axis_2;
+	ar.axis_linear = axis_linear;
+
+	// Circular geometry for the native arc move (see mp_arc). The IJ offset
+	// vector points from the starting position to the center, so all the trig
+	// terms reduce to ratios of geometry already in hand - arc setup makes no
+	// sin/cos/atan calls at all
+	ar.center_1 = ar.position[axis_1] + i;
+	ar.center_2 = ar.position[axis_2] + j;
+	ar.theta_per_mm = angular_travel / ar.length;
+
+	// Entry and exit path tangents - used for the junction velocities at both
+	// ends of the arc. Theta is measured from the positive Y axis, so the
+	// radius vector at angle theta is (sin, cos) * R and the travel direction
+	// along the circle is (cos, -sin) for positive (CW) angular travel
+	float planar_fraction = fabs(angular_travel) * radius / ar.length;	// < 1 for a helix
+	float direction = (angular_travel < 0) ? -1 : 1;
+	float recip_R = direction * planar_fraction / radius;
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		ar.entry_unit[axis] = 0;
+		ar.exit_unit[axis] = 0;
+	}
+	ar.entry_unit[axis_1] = -j * recip_R;		//  cos(theta_start) == -j/R
+	ar.entry_unit[axis_2] =  i * recip_R;		// -sin(theta_start) ==  i/R
+	ar.entry_unit[axis_linear] = linear_travel / ar.length;
+	ar.exit_unit[axis_1] =  (ar.endpoint[axis_2] - ar.center_2) * recip_R;	//  cos(theta_end)
+	ar.exit_unit[axis_2] = -(ar.endpoint[axis_1] - ar.center_1) * recip_R;	// -sin(theta_end)
+	ar.exit_unit[axis_linear] = ar.entry_unit[axis_linear];
+
+	ar.curve_type = CURVE_TYPE_ARC;
+	ar.run_state = MOVE_STATE_RUN;
+	(void)ar_arc_callback();			// queue inline if a buffer is free (see callback notes)
+	return (STAT_OK);
+}
+
+/*
+ * ar_spline() - setup a cubic spline move for runtime
+ *
+ *	The spline analog of ar_arc(): takes the polynomial coefficients, length
+ *	and tightest curvature radius computed by _compute_spline(), derives the
+ *	entry and exit path tangents from the polynomial derivative, and leaves
+ *	the curve pending for ar_arc_callback() to queue as a single native
+ *	spline move (see mp_spline() in plan_line.c). The polynomial is
+ *	interpolated at the exec stage - no chord segmentation is performed.
+ */
+stat_t ar_spline(const float target[],
+				const float poly_1[],		// polynomial in the first plane axis - [p,c,b,a]
+				const float poly_2[],		// polynomial in the second plane axis
+				const uint8_t axis_1, 		// curve plane in tool space
+				const uint8_t axis_2,
+				const float length,			// path length of the curve in mm
+				const float radius_min,		// tightest curvature radius on the curve
+				const float minutes,		// time to complete the move
+				const float work_offset[],	// offset from work coordinate system
+				const float min_time)		// minimum time for replanning purposes
+{
+	if (ar.run_state != MOVE_STATE_OFF) {
+		return (STAT_INTERNAL_ERROR);			// (not supposed to fail)
+	}
+	ar.linenum = cm_get_model_linenum();	// get gcode model line number as debugging convenience
+
+	ar.length = length;
+	if (ar.length < cfg.arc_segment_len) {	// too short to draw
+		return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
+	}
+
+	// load the move struct for a spline
+	cm_get_model_canonical_position_vector(ar.position);// set initial position
+	copy_axis_vector(ar.endpoint, target);				// save the curve endpoint
+	copy_axis_vector(ar.work_offset, work_offset);		// propagate the work offset
+	ar.time = minutes;
+	ar.min_time = min_time;
+	ar.radius = radius_min;
+	ar.axis_1 = axis_1;
+	ar.axis_2 = axis_2;
+	for (uint8_t i=0; i<4; i++) {
+		ar.poly_1[i] = poly_1[i];
+		ar.poly_2[i] = poly_2[i];
+	}
+
+	// Entry and exit path tangents from the polynomial derivative
+	// B'(t) = c + 2bt + 3at^2. A coincident control point makes the endpoint
+	// derivative vanish, so back off the parameter a bit until it doesn't
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		ar.entry_unit[axis] = 0;
+		ar.exit_unit[axis] = 0;
+	}
+	for (float t=0; t < 0.2; t += 0.05) {
+		float d_1 = poly_1[1] + t * ((2 * poly_1[2]) + (t * 3 * poly_1[3]));
+		float d_2 = poly_2[1] + t * ((2 * poly_2[2]) + (t * 3 * poly_2[3]));
+		float mag = hypot(d_1, d_2);
+		if (mag > EPSILON) {
+			ar.entry_unit[axis_1] = d_1 / mag;
+			ar.entry_unit[axis_2] = d_2 / mag;
+			break;
+		}
+	}
+	for (float t=1; t > 0.8; t -= 0.05) {
+		float d_1 = poly_1[1] + t * ((2 * poly_1[2]) + (t * 3 * poly_1[3]));
+		float d_2 = poly_2[1] + t * ((2 * poly_2[2]) + (t * 3 * poly_2[3]));
+		float mag = hypot(d_1, d_2);
+		if (mag > EPSILON) {
+			ar.exit_unit[axis_1] = d_1 / mag;
+			ar.exit_unit[axis_2] = d_2 / mag;
+			break;
+		}
+	}
+
+	ar.curve_type = CURVE_TYPE_SPLINE;
+	ar.run_state = MOVE_STATE_RUN;
+	(void)ar_arc_callback();			// queue inline if a buffer is free (see callback notes)
+	return (STAT_OK);
+}
+
+/*
+ * ar_arc_callback() - queue an arc
+ *
+ *	ar_arc_callback() is structured as a continuation called by mp_move_dispatcher.
+ *	It queues the pending arc as a single native arc move (see mp_arc()) once
+ *	a planner buffer and an arc geometry slot are available, so one planner
+ *	buffer carries the entire G2/G3 and queue depth goes to lookahead instead
+ *	of chord storage. The buffer headroom check mirrors the one the controller
+ *	applies before accepting a new input line.
+ *
+ *	ar_arc() and ar_spline() also call this directly once the curve is loaded,
+ *	so in the common case (buffers free) the arc is queued in the same
+ *	controller pass that parsed it. Without the inline call a pending arc
+ *	stalls the dispatcher for a full sweep before being queued, which shows
+ *	up as a per-block gap on arc-chained profiles. If buffers are tight the
+ *	inline attempt returns EAGAIN and the continuation picks it up as before.
+ */
+
+stat_t ar_arc_callback() 
+{
+	if (ar.run_state == MOVE_STATE_OFF) { return (STAT_NOOP);}
+	if ((mp_get_planner_buffers_available() <= PLANNER_BUFFER_HEADROOM) ||
+		(mp_get_arc_slots_available() == 0)) {
+		tg.waiting_for_buffer = true;		// let the controller sleep until the executor frees one
+		return (STAT_EAGAIN);
+	}
+	(void)mp_flush_coalesced_line();		// release any pending micro-move ahead of the curve
+	if (ar.curve_type == CURVE_TYPE_SPLINE) {
+		(void)mp_spline(ar.endpoint, ar.time, ar.work_offset, ar.min_time, ar.length,
+					 ar.entry_unit, ar.exit_unit, ar.poly_1, ar.poly_2,
+					 ar.radius, ar.axis_1, ar.axis_2);
+	} else {
+		(void)mp_arc(ar.endpoint, ar.time, ar.work_offset, ar.min_time, ar.length,
+					 ar.entry_unit, ar.exit_unit, ar.center_1, ar.center_2,
+					 ar.theta_per_mm, ar.radius, ar.axis_1, ar.axis_2);
+	}
+	ar.run_state = MOVE_STATE_OFF;
+	return (STAT_OK);
+}
+
+/*
+ * ar_abort_arc() - stop an arc.
+ *
+ *	OK to call if no arc is running
+ */
+
+void ar_abort_arc() 
+{
+	ar.run_state = MOVE_STATE_OFF;
+}
+
+/*****************************************************************************
+ * Canonical Machining arc functions (arc prep for planning and runtime)
+ * cm_arc_feed() 		 - entry point for arc prep
+ * _compute_center_arc() - compute arc from I and J (arc center point)
+ * _get_arc_radius() 	 - compute arc center (offset) from radius.
+ * _get_arc_time()		 - compute time to complete arc at current feed rate
+ */
+stat_t cm_arc_feed(float target[], float flags[],	// arc endpoints
+				   float i, float j, float k, 		// offsets
+				   float radius, 					// non-zero sets radius mode
+				   uint8_t motion_mode)				// defined motion mode
+{
+	uint8_t status = STAT_OK;
+
+	// copy parameters into the current state
+	gm.motion_mode = motion_mode;
+
+	// trap zero feed rate condition
+	if ((gm.inverse_feed_rate_mode == false) && (gm.feed_rate == 0)) {
+		return (STAT_GCODE_FEEDRATE_ERROR);
+	}
+
+	// Trap conditions where no arc movement will occur, 
+	// but the system is still in arc motion mode - this is not an error.
+	// This can happen when a F word or M word is by itself.
+	// (The tests below are organized for execution efficiency)
+	if ((i==0) && (j==0) && (radius==0) && (k==0)) {
+		float flag_sum = flags[AXIS_X] + flags[AXIS_Y] + flags[AXIS_Z];
+#if (AXES >= 4)
+		flag_sum += flags[AXIS_A];
+#endif
+#if (AXES >= 6)
+		flag_sum += flags[AXIS_B] + flags[AXIS_C];
+#endif
+		if (flag_sum == 0) {
+			return (STAT_OK);
+		}
+	}
+	// set parameters
+	cm_set_target(target,flags);
+	cm_set_arc_offset(i,j,k);
+	cm_set_arc_radius(radius);
+
+	// A non-zero radius is a radius arc. Compute the IJK offset coordinates.
+	// These will override any IJK offsets provided in the call
+	if (radius > EPSILON) {
+		if ((_get_arc_radius() != STAT_OK)) {
+			return (status);					// error return
+		}
+	}
+
+	// Starting from idle is handled by the startup fill gate in mp_exec_move()
+
+	// cover any unexpired spindle spin-up before cutting (see canonical_machine.c)
+	status = cm_spindle_ramp_wait();
+	if (status != STAT_OK) { return (status); }
+
+	// execute the move
+	status = _compute_center_arc();
+	cm_set_gcode_model_endpoint_position(status);
+	return (status);
+}
+
+/*
+ * cm_spline_feed()	   - entry point for cubic spline prep (G5)
+ * _compute_spline()   - compute the Bezier polynomial, path length and curvature
+ * _get_spline_time()  - compute time to complete spline at current feed rate
+ *
+ *	G5 commands a planar cubic Bezier in the active plane. I and J give the
+ *	offset from the current position to the first control point; P and Q give
+ *	the offset from the endpoint to the second control point. All four words
+ *	are required - the incremental form that mirrors the previous block's
+ *	control point is not supported.
+ */
+stat_t cm_spline_feed(float target[], float flags[],	// spline endpoint
+					  float i, float j,					// first control point offset
+					  float p, float q)					// second control point offset
+{
+	uint8_t status = STAT_OK;
+
+	// copy parameters into the current state
+	gm.motion_mode = MOTION_MODE_CUBIC_SPLINE;
+
+	// trap zero feed rate condition
+	if ((gm.inverse_feed_rate_mode == false) && (gm.feed_rate == 0)) {
+		return (STAT_GCODE_FEEDRATE_ERROR);
+	}
+
+	// set parameters
+	cm_set_target(target, flags);
+	cm_set_arc_offset(i,j,0);				// first control point offset (converted to mm)
+	p *= gm.units_scale;		// cached units multiplier - see cm_set_units_mode()
+	q *= gm.units_scale;
+
+	// cover any unexpired spindle spin-up before cutting (see canonical_machine.c)
+	status = cm_spindle_ramp_wait();
+	if (status != STAT_OK) { return (status); }
+
+	// execute the move
+	status = _compute_spline(p, q);
+	cm_set_gcode_model_endpoint_position(status);
+	return (status);
+}
+
+#define SPLINE_LENGTH_STEPS 16		// chord steps for the path length integration
+
+static stat_t _compute_spline(const float p, const float q)
+{
+	uint8_t axis_1 = gm.plane_axis_0;
+	uint8_t axis_2 = gm.plane_axis_1;
+
+	// Control points: start, start + IJ, endpoint + PQ, endpoint.
+	// Collapsed to polynomial form B(t) = p0 + t*(c + t*(b + t*a))
+	float p0_1 = gm.position[axis_1];
+	float p0_2 = gm.position[axis_2];
+	float p3_1 = gm.target[axis_1];
+	float p3_2 = gm.target[axis_2];
+	float p1_1 = p0_1 + gm.arc_offset[axis_1];
+	float p1_2 = p0_2 + gm.arc_offset[axis_2];
+	float p2_1 = p3_1 + p;
+	float p2_2 = p3_2 + q;
+
+	float poly_1[4], poly_2[4];
+	poly_1[0] = p0_1;
+	poly_1[1] = 3 * (p1_1 - p0_1);							// c
+	poly_1[2] = 3 * (p2_1 - (2 * p1_1) + p0_1);				// b
+	poly_1[3] = p3_1 - (3 * p2_1) + (3 * p1_1) - p0_1;		// a
+	poly_2[0] = p0_2;
+	poly_2[1] = 3 * (p1_2 - p0_2);
+	poly_2[2] = 3 * (p2_2 - (2 * p1_2) + p0_2);
+	poly_2[3] = p3_2 - (3 * p2_2) + (3 * p1_2) - p0_2;
+
+	// Integrate the path length as chords and find the tightest curvature
+	// on the way past:  kappa(t) = |x'y'' - y'x''| / (x'^2 + y'^2)^(3/2).
+	// The curvature radius caps cruise velocity exactly as an arc radius
+	// does (see mp_spline)
+	float length = 0;
+	float kappa_max = 0;
+	float prev_1 = p0_1;
+	float prev_2 = p0_2;
+	for (uint8_t step=0; step <= SPLINE_LENGTH_STEPS; step++) {
+		float t = (float)step / SPLINE_LENGTH_STEPS;
+		if (step > 0) {
+			float b_1 = poly_1[0] + t * (poly_1[1] + t * (poly_1[2] + (t * poly_1[3])));
+			float b_2 = poly_2[0] + t * (poly_2[1] + t * (poly_2[2] + (t * poly_2[3])));
+			length += hypot(b_1 - prev_1, b_2 - prev_2);
+			prev_1 = b_1;
+			prev_2 = b_2;
+		}
+		float d_1 = poly_1[1] + t * ((2 * poly_1[2]) + (t * 3 * poly_1[3]));
+		float d_2 = poly_2[1] + t * ((2 * poly_2[2]) + (t * 3 * poly_2[3]));
+		float dd_1 = (2 * poly_1[2]) + (6 * poly_1[3] * t);
+		float dd_2 = (2 * poly_2[2]) + (6 * poly_2[3] * t);
+		float speed_sq = square(d_1) + square(d_2);
+		if (speed_sq < EPSILON) { continue;}	// stationary point - no curvature to measure
+		float kappa = fabs((d_1 * dd_2) - (d_2 * dd_1)) / (speed_sq * sqrt(speed_sq));
+		if (kappa > kappa_max) { kappa_max = kappa;}
+	}
+	float radius_min = (kappa_max > EPSILON) ? (1 / kappa_max) : 1000000;
+
+	float move_time = _get_spline_time(length);
+
+	return (ar_spline(gm.target, poly_1, poly_2, axis_1, axis_2, length,
+					  radius_min, move_time, gm.work_offset, gm.min_time));
+}
+
+
+/*
+ * _cm_compute_center_arc() - compute arc from I and J (arc center point)
+ *
+ *	The theta calculation sets up an clockwise or counterclockwise arc from 
+ *	the current position to the target position around the center designated 
+ *	by the offset vector. All theta-values measured in radians of deviance 
+ *	from the positive y-axis. 
+ *
+ *                      | <- theta == 0
+ *                    * * *
+ *                  *       *
+ *                *           *
+ *                *     O ----T   <- theta_end (e.g. 90 degrees: theta_end == PI/2)
+ *                *   /
+ *                  C   <- theta_start (e.g. -145 degrees: theta_start == -PI*(3/4))
+ */
+
+static stat_t _compute_center_arc()
+{
+	float angular_travel;
+
+	// Find the radius
+	float radius_tmp = hypot(gm.arc_offset[gm.plane_axis_0], gm.arc_offset[gm.plane_axis_1]);
+
+	// Full-circle fast path: when the endpoint coincides with the current
+	// position in the arc plane the angular travel is exactly one turn and
+	// no angles need to be computed at all (ar_arc() derives its trig terms
+	// from the offset and endpoint geometry). Spiral pocketing emits
+	// thousands of these, including full circles with a Z word (helical
+	// plunges), which take the same path.
+	if ((radius_tmp > EPSILON) &&
+		(fabs(gm.target[gm.plane_axis_0] - gm.position[gm.plane_axis_0]) < EPSILON) &&
+		(fabs(gm.target[gm.plane_axis_1] - gm.position[gm.plane_axis_1]) < EPSILON)) {
+		angular_travel = (gm.motion_mode == MOTION_MODE_CCW_ARC) ? -(2*M_PI) : (2*M_PI);
+
+	} else {
+		// calculate the theta (angle) of the current point (see header notes)
+		float theta_start = _get_theta(-gm.arc_offset[gm.plane_axis_0], -gm.arc_offset[gm.plane_axis_1]);
+		if(isnan(theta_start) == true) { return(STAT_ARC_SPECIFICATION_ERROR);}
+
+		// calculate the theta (angle) of the target point
+		float theta_end = _get_theta(
+			gm.target[gm.plane_axis_0] - gm.arc_offset[gm.plane_axis_0] - gm.position[gm.plane_axis_0], 
+	 		gm.target[gm.plane_axis_1] - gm.arc_offset[gm.plane_axis_1] - gm.position[gm.plane_axis_1]);
+		if(isnan(theta_end) == true) { return (STAT_ARC_SPECIFICATION_ERROR); }
+
+		// ensure that the difference is positive so we have clockwise travel
+		if (theta_end < theta_start) { theta_end += 2*M_PI; }
+
+		// compute angular travel and invert if gcode wants a counterclockwise arc
+		// if angular travel is zero interpret it as a full circle
+		angular_travel = theta_end - theta_start;
+		if (angular_travel == 0) {
+			if (gm.motion_mode == MOTION_MODE_CCW_ARC) { 
+				angular_travel -= 2*M_PI;
+			} else {
+				angular_travel = 2*M_PI;
+			}
+		} else {
+			if (gm.motion_mode == MOTION_MODE_CCW_ARC) { 
+				angular_travel -= 2*M_PI;
+			}
+		}
+	}
+
+	// Calculate travel in the depth axis of the helix,
+	// and compute the time it should take to perform the move
+	float linear_travel = gm.target[gm.plane_axis_2] - gm.position[gm.plane_axis_2];
+	float move_time = _get_arc_time(linear_travel, angular_travel, radius_tmp);
+
+	// Trace the arc
+	set_vector(gm.target[gm.plane_axis_0], gm.target[gm.plane_axis_1], gm.target[gm.plane_axis_2],
+#if (AXES >= 6)
+			   gm.target[AXIS_A], gm.target[AXIS_B], gm.target[AXIS_C]);
+#elif (AXES >= 4)
+			   gm.target[AXIS_A], 0, 0);	// set_vector() drops the missing axes
+#else
+			   0, 0, 0);					// set_vector() drops the missing axes
+#endif
+
+	return(ar_arc(vector,
+				  gm.arc_offset[gm.plane_axis_0],
+				  gm.arc_offset[gm.plane_axis_1],
+				  gm.arc_offset[gm.plane_axis_2],
+				  radius_tmp, angular_travel, linear_travel, 
+				  gm.plane_axis_0, gm.plane_axis_1, gm.plane_axis_2, 
+				  move_time, gm.work_offset, gm.min_time));
+}
+
+/* 
+ * _get_arc_radius() - compute arc center (offset) from radius. 
+ *
+ *  We need to calculate the center of the circle that has the designated 
+ *	radius and passes through both the current position and the target position
+ *		  
+ *	This method calculates the following set of equations where:
+ *	`  [x,y] is the vector from current to target position, 
+ *		d == magnitude of that vector, 
+ *		h == hypotenuse of the triangle formed by the radius of the circle, 
+ *			 the distance to the center of the travel vector. 
+ *		  
+ *	A vector perpendicular to the travel vector [-y,x] is scaled to the length
+ *	of h [-y/d*h, x/d*h] and added to the center of the travel vector [x/2,y/2]
+ *	to form the new point [i,j] at [x/2-y/d*h, y/2+x/d*h] which will be the 
+ *	center of our arc.
+ *        
+ *		d^2 == x^2 + y^2
+ *		h^2 == r^2 - (d/2)^2
+ *		i == x/2 - y/d*h
+ *		j == y/2 + x/d*h
+ *                                        O <- [i,j]
+ *                                     -  |
+ *                           r      -     |
+ *                               -        |
+ *                            -           | h
+ *                         -              |
+ *           [0,0] ->  C -----------------+--------------- T  <- [x,y]
+ *                     | <------ d/2 ---->|
+ *                  
+ *		C - Current position
+ *		T - Target position
+ *		O - center of circle that pass through both C and T
+ *		d - distance from C to T
+ *		r - designated radius
+ *		h - distance from center of CT to O
+ *  
+ *	Expanding the equations:
+ *		d -> sqrt(x^2 + y^2)
+ *		h -> sqrt(4 * r^2 - x^2 - y^2)/2
+ *		i -> (x - (y * sqrt(4 * r^2 - x^2 - y^2)) / sqrt(x^2 + y^2)) / 2 
+ *		j -> (y + (x * sqrt(4 * r^2 - x^2 - y^2)) / sqrt(x^2 + y^2)) / 2
+ * 
+ *	Which can be written:  
+ *		i -> (x - (y * sqrt(4 * r^2 - x^2 - y^2))/sqrt(x^2 + y^2))/2
+ *		j -> (y + (x * sqrt(4 * r^2 - x^2 - y^2))/sqrt(x^2 + y^2))/2
+ *  
+ *	Which we for size and speed reasons optimize to:
+ *		h_x2_div_d = sqrt(4 * r^2 - x^2 - y^2)/sqrt(x^2 + y^2)
+ *		i = (x - (y * h_x2_div_d))/2
+ *		j = (y + (x * h_x2_div_d))/2
+ *
+ * ----Computing clockwise vs counter-clockwise motion ----
+ *
+ *	The counter clockwise circle lies to the left of the target direction. 
+ *	When offset is positive, the left hand circle will be generated - 
+ *	when it is negative the right hand circle is generated.
+ *
+ *                                   T  <-- Target position
+ *  
+ *                                   ^ 
+ *      Clockwise circles with       |     Clockwise circles with
+ *		this center will have        |     this center will have
+ *      > 180 deg of angular travel  |     < 180 deg of angular travel, 
+ *                        \          |      which is a good thing!
+ *                         \         |         /
+ *  center of arc when  ->  x <----- | -----> x <- center of arc when 
+ *  h_x2_div_d is positive           |             h_x2_div_d is negative
+ *                                   |
+ *                                   C  <-- Current position
+ */
+
+static stat_t _get_arc_radius()
+{
+	float x;
+	float y;
+	float h_x2_div_d;
+
+	// Calculate the change in position along each selected axis
+	x = gm.target[gm.plane_axis_0]-gm.position[gm.plane_axis_0];
+	y = gm.target[gm.plane_axis_1]-gm.position[gm.plane_axis_1];
+
+	gm.arc_offset[0] = 0;	// reset the offsets
+	gm.arc_offset[1] = 0;
+	gm.arc_offset[2] = 0;
+
+	// == -(h * 2 / d)
+	h_x2_div_d = -sqrt(4 * square(gm.arc_radius) - (square(x) - square(y))) / hypot(x,y);
+
+	// If r is smaller than d the arc is now traversing the complex plane beyond
+	// the reach of any real CNC, and thus - for practical reasons - we will 
+	// terminate promptly
+	if(isnan(h_x2_div_d) == true) { return (STAT_FLOATING_POINT_ERROR);}
+
+	// Invert the sign of h_x2_div_d if circle is counter clockwise (see header notes)
+	if (gm.motion_mode == MOTION_MODE_CCW_ARC) { h_x2_div_d = -h_x2_div_d;}
+
+	// Negative R is g-code-alese for "I want a circle with more than 180 degrees
+	// of travel" (go figure!), even though it is advised against ever generating
+	// such circles in a single line of g-code. By inverting the sign of 
+	// h_x2_div_d the center of the circles is placed on the opposite side of 
+	// the line of travel and thus we get the unadvisably long arcs as prescribed.
+	if (gm.arc_radius < 0) { h_x2_div_d = -h_x2_div_d; }
+
+	// Complete the operation by calculating the actual center of the arc
+	gm.arc_offset[gm.plane_axis_0] = (x-(y*h_x2_div_d))/2;
+	gm.arc_offset[gm.plane_axis_1] = (y+(x*h_x2_div_d))/2;
+	return (STAT_OK);
+} 
+    
+/*
+ * _get_arc_time ()
+ *
+ *	This is a naiive rate-limiting function. The arc drawing time is computed 
+ *	not to exceed the time taken in the slowest dimension - in the arc plane
+ *	or in linear travel. Maximum feed rates are compared in each dimension,
+ *	but the comparison assumes that the arc will have at least one segment
+ *	where the unit vector is 1 in that dimension. This is not true for any
+ *	arbitrary arc, with the result that the time returned may be less than 
+ *	optimal.
+ *
+ *	Room for improvement: At least take the hypotenuse of the planar movement 
+ *	and the linear travel into account, but how many people actually use helixes?
+ */
+
+static float _get_arc_time (const float linear_travel, 	// in mm
+							 const float angular_travel, 	// in radians
+							 const float radius)			// in mm
+{
+	float tmp;
+	float move_time=0;	// picks through the times and retains the slowest
+	float planar_travel = fabs(angular_travel * radius);// travel in arc plane
+
+	if (gm.inverse_feed_rate_mode == true) {
+		move_time = gm.inverse_feed_rate;
+	} else {
+		move_time = sqrt(square(planar_travel) + square(linear_travel)) / gm.feed_rate;
+	}
+	if ((tmp = planar_travel/cfg.a[gm.plane_axis_0].feedrate_max) > move_time) {
+		move_time = tmp;
+	}
+	if ((tmp = planar_travel/cfg.a[gm.plane_axis_1].feedrate_max) > move_time) {
+		move_time = tmp;
+	}
+	if ((tmp = fabs(linear_travel/cfg.a[gm.plane_axis_2].feedrate_max)) > move_time) {
+		move_time = tmp;
+	}
+	return (move_time);
+}
+
+static float _get_spline_time(const float length)
+{
+	float tmp;
+	float move_time = 0;
+
+	if (gm.inverse_feed_rate_mode == true) {
+		move_time = gm.inverse_feed_rate;
+	} else {
+		move_time = length / gm.feed_rate;
+	}
+	// nearly all the path length can land on either plane axis, so cap with both
+	if ((tmp = length/cfg.a[gm.plane_axis_0].feedrate_max) > move_time) { move_time = tmp;}
+	if ((tmp = length/cfg.a[gm.plane_axis_1].feedrate_max) > move_time) { move_time = tmp;}
+	return (move_time);
+}
+
+/*
+ * _get_theta(float x, float y)
+ *
+ *	Find the angle in radians of deviance from the positive y axis.
+ *	negative angles to the left of y-axis, positive to the right.
+ *
+ *	Computed as a polynomial approximation rather than through libm atan(),
+ *	which costs several hundred microseconds per call on the Xmega and runs
+ *	twice per arc setup. The octant is reduced so the polynomial argument
+ *	stays in [0,1], where the Abramowitz & Stegun 4.4.49 fit is good to
+ *	about 1e-5 radian - a path error of microns at any radius this machine
+ *	class can swing, and the arc endpoint is corrected exactly regardless
+ *	(see _compute_center_arc / ar_arc).
+ *
+ *	Returns NAN when x and y are both zero - callers test isnan() to reject
+ *	malformed arc specifications, matching the old atan(0/0) behavior.
+ */
+
+static float _atan_poly(const float r)		// atan(r) for r in [0,1]
+{
+	float r2 = r*r;
+	return (r * (0.9998660 + r2*(-0.3302995 + r2*(0.1801410 + r2*(-0.0851330 + r2*0.0208351)))));
+}
+
+static float _get_theta(const float x, const float y)
+{
+	float ax = fabs(x);
+	float ay = fabs(y);
+	float theta;
+
+	if (ax > ay) {								// reduce to the first octant
+		theta = (M_PI/2) - _atan_poly(ay/ax);
+	} else {
+		if (ay == 0) { return (NAN);}			// x and y both zero - bad arc spec
+		theta = _atan_poly(ax/ay);
+	}
+	if (y < 0) { theta = M_PI - theta;}			// reflect the quadrants back out
+	if (x < 0) { theta = -theta;}
+	return (theta);
+}
+
+//##########################################
+//############## UNIT TESTS ################
+//##########################################
+
+#ifdef __UNIT_TESTS
+#ifdef __UNIT_TEST_PLANNER
+
+void mp_plan_arc_unit_tests()
+{
+//	_mp_test_buffers();
+}
+
+#endif
+#endif
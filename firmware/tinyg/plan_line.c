@@ -5,28 +5,29 @@
  * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
  * Copyright (c) 2012 - 2013 Rob Giseburt
  *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
 #include <math.h>
+#include <string.h>				// for junction cache memcmp/memcpy
 #include <avr/pgmspace.h>		// precursor for xio.h
 
 #include "tinyg.h"
@@ -36,8 +37,11 @@
 #include "plan_line.h"
 #include "planner.h"
 #include "kinematics.h"
+#include "q16.h"				// fixed point math for the segment loop
 #include "stepper.h"
 #include "report.h"
+#include "blackbox.h"			// per-segment flight recorder tap
+#include "test.h"
 #include "util.h"
 //#include "xio/xio.h"			// uncomment for debugging
 
@@ -48,7 +52,7 @@ static float _get_target_length(const float Vi, const float Vt, const mpBuf_t *b
 static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *bf);
 //static float _get_intersection_distance(const float Vi_squared, const float Vt_squared, const float L, const mpBuf_t *bf);
 static float _get_junction_vmax(const float a_unit[], const float b_unit[]);
-static void _reset_replannable_list(void);
+static void _plan_hold_list(uint8_t *mr_flag);
 
 // execute routines (NB: These are all called from the LO interrupt)
 static stat_t _exec_aline(mpBuf_t *bf);
@@ -56,6 +60,7 @@ static stat_t _exec_aline_head(void);
 static stat_t _exec_aline_body(void);
 static stat_t _exec_aline_tail(void);
 static stat_t _exec_aline_segment(uint8_t correction_flag);
+static void _shaper_advance(const float target[], const float duration, float shaped[]);
 static void _init_forward_diffs(float t0, float t2);
 static float _compute_next_segment_velocity(void);
 
@@ -74,7 +79,20 @@ uint8_t mp_isbusy()
 	return (false);
 }
 
-/*
+/* Runtime snapshot - double buffered runtime state for status reporting
+ *
+ *	Status reports read runtime position and velocity from the mainline while
+ *	the MED interrupt level mutates them, so direct mr.* reads can tear in
+ *	the middle of a float and mix values from adjacent segments in a single
+ *	report. Instead the segment runner (and any mainline code that
+ *	legitimately writes runtime state) publishes a complete snapshot into
+ *	one of two buffers and flips a one byte index, which is atomic on the
+ *	AVR. A published buffer is not rewritten until two publishes later - at
+ *	least two segment times - so a report that starts reading it always
+ *	finishes on consistent values. Work positions are computed once at
+ *	publish time instead of once per getter call.
+ *
+ * mp_publish_runtime_snapshot() 	- publish mr state for the getters below
  * mp_get_runtime_motion_mode() 	- returns motion mode of currently executing command
  * mp_get_runtime_linenum()	 		- returns currently executing line number
  * mp_get_runtime_velocity() 		- returns current velocity (aggregate)
@@ -84,30 +102,245 @@ uint8_t mp_isbusy()
  * mp_set_runtime_work_offset()
  * mp_zero_segment_velocity() 		- correct velocity in last segment for reporting purposes
  */
-
-uint8_t mp_get_runtime_motion_mode(void) { return (mr.motion_mode);}
-float mp_get_runtime_linenum(void) { return (mr.linenum);}
-float mp_get_runtime_velocity(void) { return (mr.segment_velocity);}
+
+typedef struct mpRuntimeSnap {
+	uint32_t linenum;			// runtime line number
+	uint8_t motion_mode;		// runtime motion mode
+	float velocity;				// aggregate segment velocity
+	float position[AXES];		// machine position (always mm)
+	float work_position[AXES];	// machine position less work offset
+	float work_offset[AXES];	// work offset in effect at publish time
+} mpRuntimeSnap_t;
+
+static mpRuntimeSnap_t sn_pool[2];
+static volatile uint8_t sn_idx;	// published buffer - the other one is writable
+
+void mp_publish_runtime_snapshot()
+{
+	mpRuntimeSnap_t *sn = &sn_pool[sn_idx ^ 1];
+	sn->linenum = mr.linenum;
+	sn->motion_mode = mr.motion_mode;
+	sn->velocity = mr.segment_velocity;
+	for (uint8_t i=0; i<AXES; i++) {
+		sn->position[i] = mr.position[i];
+		sn->work_offset[i] = mr.work_offset[i];
+		sn->work_position[i] = mr.position[i] - mr.work_offset[i];
+	}
+	sn_idx ^= 1;				// single byte write publishes the buffer
+}
+
+uint8_t mp_get_runtime_motion_mode(void) { return (sn_pool[sn_idx].motion_mode);}
+uint32_t mp_get_runtime_linenum(void) { return (sn_pool[sn_idx].linenum);}
+float mp_get_runtime_velocity(void) { return (sn_pool[sn_idx].velocity);}
 
 float mp_get_runtime_machine_position(uint8_t axis) { 
-	return (mr.position[axis]);
+	return (sn_pool[sn_idx].position[axis]);
 }
 
 float mp_get_runtime_work_position(uint8_t axis) { 
-	return (mr.position[axis] - mr.work_offset[axis]);
+	return (sn_pool[sn_idx].work_position[axis]);
+}
+
+/*
+ * mp_get_runtime_segment_position() - back-compute a position within the running segment
+ *
+ *	'fraction' is how much of the DDA segment now in the steppers had completed
+ *	at the moment of interest (see st_get_dda_fraction()). mr.position leads
+ *	the steppers by the segments queued in the prep/load pipeline, so this
+ *	walks back one whole segment plus the un-run remainder of the current one.
+ *	The residual error is bounded by one segment's travel at segment_velocity,
+ *	which is what makes fast homing searches viable (see cycle_homing.c).
+ *	ISR-callable; a segment-boundary race shifts the estimate by at most one
+ *	segment, which is inside the stated error bound.
+ */
+float mp_get_runtime_segment_position(uint8_t axis, float fraction)
+{
+	float segment_travel = mr.unit[axis] * mr.segment_velocity * mr.segment_move_time;
+	return (mr.position[axis] - (segment_travel * (2 - fraction)));
 }
 
-float mp_get_runtime_work_offset(uint8_t axis) { 
-	return (mr.work_offset[axis]);
+float mp_get_runtime_work_offset(uint8_t axis) {
+	return (sn_pool[sn_idx].work_offset[axis]);
 }
 
 void mp_set_runtime_work_offset(float offset[]) { 
 	copy_axis_vector(mr.work_offset, offset);
+	mp_publish_runtime_snapshot();
 }
 
-void mp_zero_segment_velocity() 
+void mp_zero_segment_velocity()
 {
 	mr.segment_velocity = 0;
+	mp_publish_runtime_snapshot();
+}
+
+/*
+ * mp_tune_segment_usec()  - adapt the segment time to measured exec headroom
+ * mp_get_segment_usec()   - return the current segment time
+ * mp_reset_segment_usec() - restart adaptation from the configured nominal
+ *
+ *	$ms sets the nominal segment time; the 5ms default is a fleet-wide worst
+ *	case for the exec stage - exec plus prep of one segment must finish
+ *	inside one segment time or the steppers starve. In __ISR_PROFILE builds
+ *	the once-per-second occupancy rollup feeds the worst measured exec pass
+ *	back here: while the worst pass clears the deadline with room to spare
+ *	the segment time creeps down toward MIN_SEGMENT_USEC (more interpolation
+ *	points, smoother motion), and when it encroaches on the deadline the
+ *	segment time backs off quickly. Each machine settles at its own
+ *	sustainable value instead of the compile-time guess. Builds without the
+ *	instrumentation never call the tuner and run the configured nominal.
+ *	Thresholds and rates are in planner.h (see SEGMENT_TUNE_...).
+ */
+
+static float sg_segment_usec = NOM_SEGMENT_USEC;	// mp_init() resets this from $ms
+
+void mp_tune_segment_usec(float exec_usec)
+{
+	if (exec_usec <= 0) { return;}				// no segments ran in the last second
+	if (exec_usec > (sg_segment_usec * SEGMENT_TUNE_HI)) {
+		sg_segment_usec *= SEGMENT_TUNE_GROW;
+		if (sg_segment_usec > SEGMENT_TUNE_MAX_USEC) { sg_segment_usec = SEGMENT_TUNE_MAX_USEC;}
+	} else if (exec_usec < (sg_segment_usec * SEGMENT_TUNE_LO)) {
+		sg_segment_usec *= SEGMENT_TUNE_SHRINK;
+		if (sg_segment_usec < MIN_SEGMENT_USEC) { sg_segment_usec = MIN_SEGMENT_USEC;}
+	}
+}
+
+float mp_get_segment_usec(void) { return (sg_segment_usec);}
+void mp_reset_segment_usec(void) { sg_segment_usec = cfg.estd_segment_usec;}
+
+/*
+ * mp_update_soft_limits() - precompute the soft limit bounds from the config
+ *
+ *	Soft limits are checked against every block in mp_aline(), so the enable
+ *	flag, the homing state and the travel settings are folded into a pair of
+ *	cached machine-coordinate bounds here instead of being re-derived per
+ *	block - the per-block cost is just the compares. Checking in machine
+ *	coordinates means coordinate system and G92 offsets never invalidate
+ *	the cache; it only needs refreshing when the settings change (see
+ *	_set_tl() and friends in config.c) or an axis homes. An axis is left
+ *	unchecked (infinite bounds) until it has homed - machine coordinates
+ *	mean nothing before then, and homing's own off-the-switch moves must
+ *	not be rejected. An axis with travel_min >= travel_max is never
+ *	checked, which is how the rotary axes ship.
+ */
+
+static float sl_min[AXES];				// cached machine coordinate bounds
+static float sl_max[AXES];
+
+void mp_update_soft_limits(void)
+{
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		if ((cfg.soft_limit_enable == true) && (cm.homed[axis] == true) &&
+			(cfg.a[axis].travel_min < cfg.a[axis].travel_max)) {
+			sl_min[axis] = cfg.a[axis].travel_min;
+			sl_max[axis] = cfg.a[axis].travel_max;
+		} else {
+			sl_min[axis] = -INFINITY;
+			sl_max[axis] = INFINITY;
+		}
+	}
+}
+
+/**************************************************************************
+ * mp_coalescing_aline()	  - accumulate collinear micro-moves ahead of mp_aline()
+ * mp_flush_coalesced_line()  - release any accumulated move to the planner
+ * mp_discard_coalesced_line() - drop any accumulated move (queue flush)
+ *
+ *	CAM output of faceted curves can be full of 0.02mm lines that are below
+ *	the minimum line length ($ml) - each one would flood the planner with a block paying full
+ *	trapezoid cost, or simply error out. This stage accumulates consecutive
+ *	segments that are (a) shorter than the minimum line length and (b) collinear with
+ *	the accumulated direction within COALESCE_COS_TOLERANCE into a single
+ *	mp_aline() call. The pending move is released when a long or non-collinear
+ *	segment arrives, or when anything else enters the planner queue - 
+ *	mp_dwell() and mp_queue_command() flush so execution order is preserved, 
+ *	and cm_straight_traverse() flushes ahead of rapids. mp_flush_planner() 
+ *	discards the pending move along with the rest of the queue.
+ *
+ *	Only the feed path (cm_straight_feed) routes through here. Arc segments 
+ *	are generated at MM_PER_ARC_SEGMENT and pass straight through untouched.
+ *
+ *	If a flushed move is still below MIN_LENGTH_MOVE it is silently dropped.
+ *	This is safe: planning always runs from mm.position to an absolute target,
+ *	so the dropped distance is folded into the next real move.
+ */
+
+static struct mpCoalesceSingleton {		// accumulator for sub-minimum feed moves
+	uint8_t pending;					// true if a deferred move is held here
+	float target[AXES];					// accumulated endpoint
+	float unit[AXES];					// direction of first deferred segment
+	float work_offset[AXES];			// offset captured with the first segment
+	float minutes;						// accumulated move time
+	float min_time;						// accumulated minimum move time
+} mc;
+
+stat_t mp_coalescing_aline(const float target[], const float minutes, const float work_offset[], const float min_time)
+{
+	uint8_t i;
+	float unit[AXES] = {0};
+	float *base = (mc.pending == true) ? mc.target : mm.position;
+	float length = get_axis_vector_length_fast(target, base);
+
+	if (length >= cfg.min_segment_len) {		// a real line - pass it through
+		ritorno(mp_flush_coalesced_line());
+		return (mp_aline(target, minutes, work_offset, min_time));
+	}
+	if (length > EPSILON) {						// degenerate segments keep prior direction
+		for (i=0; i<AXES; i++) { unit[i] = (target[i] - base[i]) / length; }
+		if (mc.pending == true) {
+			float costheta = 0;
+			for (i=0; i<AXES; i++) { costheta += unit[i] * mc.unit[i]; }
+			if (costheta < COALESCE_COS_TOLERANCE) {	// direction broke - release & restart
+				ritorno(mp_flush_coalesced_line());
+			}
+		}
+	}
+	if (mc.pending == true) {					// extend the pending move
+		copy_axis_vector(mc.target, target);
+		mc.minutes += minutes;
+		mc.min_time += min_time;
+	} else {									// start a new pending move
+		copy_axis_vector(mc.target, target);
+		copy_axis_vector(mc.unit, unit);
+		copy_axis_vector(mc.work_offset, work_offset);
+		mc.minutes = minutes;
+		mc.min_time = min_time;
+		mc.pending = true;
+	}
+	return (STAT_OK);
+}
+
+stat_t mp_flush_coalesced_line()
+{
+	if (mc.pending == false) { return (STAT_OK);}
+	mc.pending = false;
+	stat_t status = mp_aline(mc.target, mc.minutes, mc.work_offset, mc.min_time);
+	if (status == STAT_MINIMUM_LENGTH_MOVE_ERROR) { return (STAT_OK);}	// see notes above
+	return (status);
+}
+
+void mp_discard_coalesced_line()
+{
+	mc.pending = false;
+}
+
+/*
+ * mp_sync_output() - post an output command to ride on the next queued move
+ *
+ *	Records an M62/M63 output change to be latched into the next aline or arc
+ *	queued. The command travels in the bf buffer and is applied by the stepper
+ *	loader at the exact start of the move's first segment - see
+ *	st_prep_sync_output() in stepper.c for the encoding and timing notes.
+ *	Any held coalesced micro-move is flushed first so the output binds to the
+ *	move that follows the M code, not to one queued before it.
+ */
+
+void mp_sync_output(uint8_t output_num, uint8_t on)
+{
+	(void)mp_flush_coalesced_line();
+	mm.sync_output = SYNC_OUTPUT_ARMED_bm | (on ? SYNC_OUTPUT_STATE_bm : 0) |
+					 ((0x10 >> output_num) & SYNC_OUTPUT_MASK_bm);
 }
 
 /**************************************************************************
@@ -138,52 +371,70 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
 	float junction_velocity;
 
 	// trap error conditions
-	float length = get_axis_vector_length(target, mm.position);
+	float length = get_axis_vector_length_fast(target, mm.position);
 	if (length < MIN_LENGTH_MOVE) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);}
+
+	// trap soft limit violations (bounds are cached by mp_update_soft_limits())
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		if ((target[axis] < sl_min[axis]) || (target[axis] > sl_max[axis])) {
+			return (STAT_MAX_TRAVEL_EXCEEDED);
+		}
+	}
 //	if (minutes < MIN_TIME_MOVE) { return (STAT_MINIMUM_TIME_MOVE_ERROR);}	// remove this line
 
 	// get a cleared buffer and setup move variables
 	if ((bf = mp_get_write_buffer()) == NULL) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
 
 	bf->bf_func = _exec_aline;					// register the callback to the exec function
-	bf->linenum = cm_get_model_linenum();		// block being planned
+	bf->linenum = cm_get_model_linenum();		// block being planned
 	bf->motion_mode = cm_get_model_motion_mode();
 	bf->time = minutes;
 	bf->min_time = min_time;
 	bf->length = length;
 	copy_axis_vector(bf->target, target); 		// set target for runtime
-	copy_axis_vector(bf->work_offset, work_offset);// propagate offset
-
-	// Set unit vector and jerk terms - this is all done together for efficiency 
+	bf->offset_index = mp_intern_work_offset(work_offset);	// propagate offset (interned)
+	bf->sync_output = mm.sync_output;			// carry any pending M62/M63 output command
+	mm.sync_output = SYNC_OUTPUT_NONE;
+
+	// Set unit vector and jerk terms - this is all done together for efficiency
+	// Rapids use their own per-axis jerk limit ($xjr) - G0 doesn't cut, so the
+	// machine frame rather than surface finish bounds it (see settings.h)
+	uint8_t rapid = (bf->motion_mode == MOTION_MODE_STRAIGHT_TRAVERSE);
+#define AXIS_JERK(ax) ((rapid == true) ? cfg.a[ax].jerk_rapid : cfg.a[ax].jerk_max)
 	float jerk_squared = 0;
 	float diff = target[AXIS_X] - mm.position[AXIS_X];
-	if (fp_NOT_ZERO(diff)) { 
+	if (fp_NOT_ZERO(diff)) {
 		bf->unit[AXIS_X] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_X] * cfg.a[AXIS_X].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_X] * AXIS_JERK(AXIS_X));
 	}
-	if (fp_NOT_ZERO(diff = target[AXIS_Y] - mm.position[AXIS_Y])) { 
+	if (fp_NOT_ZERO(diff = target[AXIS_Y] - mm.position[AXIS_Y])) {
 		bf->unit[AXIS_Y] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_Y] * cfg.a[AXIS_Y].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_Y] * AXIS_JERK(AXIS_Y));
 	}
-	if (fp_NOT_ZERO(diff = target[AXIS_Z] - mm.position[AXIS_Z])) { 
+	if (fp_NOT_ZERO(diff = target[AXIS_Z] - mm.position[AXIS_Z])) {
 		bf->unit[AXIS_Z] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_Z] * cfg.a[AXIS_Z].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_Z] * AXIS_JERK(AXIS_Z));
 	}
-	if (fp_NOT_ZERO(diff = target[AXIS_A] - mm.position[AXIS_A])) { 
+#if (AXES >= 4)
+	if (fp_NOT_ZERO(diff = target[AXIS_A] - mm.position[AXIS_A])) {
 		bf->unit[AXIS_A] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_A] * cfg.a[AXIS_A].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_A] * AXIS_JERK(AXIS_A));
 	}
-	if (fp_NOT_ZERO(diff = target[AXIS_B] - mm.position[AXIS_B])) { 
+#endif
+#if (AXES >= 6)
+	if (fp_NOT_ZERO(diff = target[AXIS_B] - mm.position[AXIS_B])) {
 		bf->unit[AXIS_B] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_B] * cfg.a[AXIS_B].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_B] * AXIS_JERK(AXIS_B));
 	}
-	if (fp_NOT_ZERO(diff = target[AXIS_C] - mm.position[AXIS_C])) { 
+	if (fp_NOT_ZERO(diff = target[AXIS_C] - mm.position[AXIS_C])) {
 		bf->unit[AXIS_C] = diff / length;
-		jerk_squared += square(bf->unit[AXIS_C] * cfg.a[AXIS_C].jerk_max);
+		jerk_squared += square(bf->unit[AXIS_C] * AXIS_JERK(AXIS_C));
 	}
+#endif
+#undef AXIS_JERK
 	bf->jerk = sqrt(jerk_squared);
 
-	if (fabs(bf->jerk - mm.prev_jerk) < JERK_MATCH_PRECISION) {	// can we re-use jerk terms?
+	if (fabs(bf->jerk - mm.prev_jerk) < cfg.jerk_match_precision) {	// can we re-use jerk terms? ($jmp)
 		bf->cbrt_jerk = mm.prev_cbrt_jerk;
 		bf->recip_jerk = mm.prev_recip_jerk;
 	} else {
@@ -199,8 +450,9 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
 		bf->replannable = true;
 		exact_stop = 12345678;					// an arbitrarily large floating point number
 	}
-	bf->cruise_vmax = bf->length / bf->time;	// target velocity requested
+	bf->cruise_vmax = (bf->length / bf->time) * mm.override_factor;	// target velocity requested
 	junction_velocity = _get_junction_vmax(bf->pv->unit, bf->unit);
+	bf->junction_vmax = junction_velocity;		// saved for feed override rescaling
 	bf->entry_vmax = min3(bf->cruise_vmax, junction_velocity, exact_stop);
 	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
 	bf->exit_vmax = min3(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax), exact_stop);
@@ -209,7 +461,218 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
 	uint8_t mr_flag = false;
 	_plan_block_list(bf, &mr_flag);				// replan block list and commit current block
 	copy_axis_vector(mm.position, bf->target);	// update planning position
+	mm.ms_in_queue += bf->time * 60000;			// the move's contribution to queue time
 	mp_queue_write_buffer(MOVE_TYPE_ALINE);
+	if (bm.running == true) { bm.blocks++;}		// benchmark accounting
+	else if (dry.running == false) { jst.blocks++;}	// job statistics accounting (see planner.c)
+	return (STAT_OK);
+}
+
+/*
+ * mp_arc() - plan a native arc move with acceleration / deceleration
+ *
+ *	Plans a G2/G3 arc (or helix) into a single planner buffer instead of a
+ *	chain of chord lines. The trapezoid math operates on path length and
+ *	velocity and is agnostic to the path's shape, so the planning machinery
+ *	is shared with mp_aline() unchanged. The circular geometry is carried in
+ *	a small side pool (see PLANNER_ARC_POOL_SIZE) and the circle is
+ *	interpolated at the exec stage (see _exec_aline_segment()), so the
+ *	planner queue depth goes entirely to lookahead instead of chord storage.
+ *
+ *	The entry junction is computed from the arc's entry tangent, and bf->unit
+ *	carries the exit tangent so the junction with the following move is also
+ *	computed from the true path direction. Cruise velocity is additionally
+ *	capped at the centripetal limit sqrt(R * Ja) - the same cornering model
+ *	_get_junction_vmax() applies to its virtual deviation circle.
+ *
+ *	The caller is expected to check mp_get_arc_slots_available() and planner
+ *	buffer availability before calling (see ar_arc_callback()).
+ */
+
+stat_t mp_arc(const float target[], const float minutes, const float work_offset[],
+			  const float min_time, const float length,
+			  const float entry_unit[], const float exit_unit[],
+			  const float center_1, const float center_2, const float theta_per_mm,
+			  const float radius, const uint8_t axis_1, const uint8_t axis_2)
+{
+	mpBuf_t *bf; 						// current move pointer
+	float exact_stop = 0;
+	float junction_velocity;
+
+	if (length < MIN_LENGTH_MOVE) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);}
+
+	uint8_t i;							// allocate an arc geometry slot
+	for (i=0; i < PLANNER_ARC_POOL_SIZE; i++) {
+		if (mb.arc_refs[i] == 0) { break;}
+	}
+	if (i == PLANNER_ARC_POOL_SIZE) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
+	if ((bf = mp_get_write_buffer()) == NULL) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
+
+	mb.arc[i].curve_type = CURVE_TYPE_ARC;
+	mb.arc[i].center_1 = center_1;
+	mb.arc[i].center_2 = center_2;
+	mb.arc[i].theta_per_mm = theta_per_mm;
+	mb.arc[i].radius = radius;
+	mb.arc[i].axis_1 = axis_1;
+	mb.arc[i].axis_2 = axis_2;
+	mb.arc_refs[i]++;
+
+	bf->bf_func = _exec_aline;					// arcs share the aline exec machinery
+	bf->arc_index = i;
+	bf->linenum = cm_get_model_linenum();		// block being planned
+	bf->motion_mode = cm_get_model_motion_mode();
+	bf->time = minutes;
+	bf->min_time = min_time;
+	bf->length = length;
+	copy_axis_vector(bf->target, target); 		// set target for runtime
+	copy_axis_vector(bf->unit, exit_unit);		// exit tangent (see header notes)
+	bf->offset_index = mp_intern_work_offset(work_offset);	// propagate offset (interned)
+	bf->sync_output = mm.sync_output;			// carry any pending M62/M63 output command
+	mm.sync_output = SYNC_OUTPUT_NONE;
+
+	// Set the jerk term. The plane unit components rotate through the arc so
+	// the full jerk term of the more conservative plane axis is applied, plus
+	// the helical contribution (which is constant through the move)
+	float jerk_squared = square(min(cfg.a[axis_1].jerk_max, cfg.a[axis_2].jerk_max));
+	for (uint8_t axis=0; axis<AXES; axis++) {
+		if ((axis != axis_1) && (axis != axis_2) && (fp_NOT_ZERO(exit_unit[axis]))) {
+			jerk_squared += square(exit_unit[axis] * cfg.a[axis].jerk_max);
+		}
+	}
+	bf->jerk = sqrt(jerk_squared);
+
+	if (fabs(bf->jerk - mm.prev_jerk) < cfg.jerk_match_precision) {	// can we re-use jerk terms? ($jmp)
+		bf->cbrt_jerk = mm.prev_cbrt_jerk;
+		bf->recip_jerk = mm.prev_recip_jerk;
+	} else {
+		bf->cbrt_jerk = cbrt(bf->jerk);
+		bf->recip_jerk = 1/bf->jerk;			
+		mm.prev_jerk = bf->jerk;
+		mm.prev_cbrt_jerk = bf->cbrt_jerk;
+		mm.prev_recip_jerk = bf->recip_jerk;
+	}
+
+	// finish up the current block variables
+	if (cm_get_model_path_control() != PATH_EXACT_STOP) { // exact stop cases already zeroed
+		bf->replannable = true;
+		exact_stop = 12345678;					// an arbitrarily large floating point number
+	}
+	bf->cruise_vmax = (bf->length / bf->time) * mm.override_factor;	// target velocity requested
+	bf->cruise_vmax = min(bf->cruise_vmax, sqrt(radius * cfg.junction_acceleration)); // centripetal limit
+	junction_velocity = _get_junction_vmax(bf->pv->unit, entry_unit);
+	bf->junction_vmax = junction_velocity;		// saved for feed override rescaling
+	bf->entry_vmax = min3(bf->cruise_vmax, junction_velocity, exact_stop);
+	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
+	bf->exit_vmax = min3(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax), exact_stop);
+	bf->braking_velocity = bf->delta_vmax;
+
+	uint8_t mr_flag = false;
+	_plan_block_list(bf, &mr_flag);				// replan block list and commit current block
+	copy_axis_vector(mm.position, bf->target);	// update planning position
+	mm.ms_in_queue += bf->time * 60000;			// the move's contribution to queue time
+	mp_queue_write_buffer(MOVE_TYPE_ARC);
+	if (bm.running == true) { bm.blocks++;}		// benchmark accounting
+	else if (dry.running == false) { jst.blocks++;}	// job statistics accounting (see planner.c)
+	return (STAT_OK);
+}
+
+/*
+ * mp_spline() - plan a native cubic spline move with acceleration / deceleration
+ *
+ *	Plans a G5 cubic spline into a single planner buffer the same way mp_arc()
+ *	plans an arc: the trapezoid math sees only path length and velocity, the
+ *	polynomial coefficients go into a geometry slot, and the curve is
+ *	evaluated at the exec stage (see _exec_aline_segment()). Splines share
+ *	the arc geometry pool and queue as MOVE_TYPE_ARC, so feedhold splitting,
+ *	slot refcounting and feed override replanning all apply unchanged - the
+ *	slot's curve_type selects the evaluator at load time.
+ *
+ *	radius_min is the tightest curvature radius found on the curve by the
+ *	caller, and caps cruise velocity at the centripetal limit sqrt(R * Ja)
+ *	exactly as an arc's radius does. The caller is expected to check
+ *	mp_get_arc_slots_available() and planner buffer availability before
+ *	calling (see ar_arc_callback()).
+ */
+
+stat_t mp_spline(const float target[], const float minutes, const float work_offset[],
+				 const float min_time, const float length,
+				 const float entry_unit[], const float exit_unit[],
+				 const float poly_1[], const float poly_2[],
+				 const float radius_min, const uint8_t axis_1, const uint8_t axis_2)
+{
+	mpBuf_t *bf; 						// current move pointer
+	float exact_stop = 0;
+	float junction_velocity;
+
+	if (length < MIN_LENGTH_MOVE) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);}
+
+	uint8_t i;							// allocate a geometry slot (shared with arcs)
+	for (i=0; i < PLANNER_ARC_POOL_SIZE; i++) {
+		if (mb.arc_refs[i] == 0) { break;}
+	}
+	if (i == PLANNER_ARC_POOL_SIZE) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
+	if ((bf = mp_get_write_buffer()) == NULL) { return (STAT_BUFFER_FULL_FATAL);} // never supposed to fail
+
+	mb.arc[i].curve_type = CURVE_TYPE_SPLINE;
+	for (uint8_t j=0; j<4; j++) {
+		mb.arc[i].poly_1[j] = poly_1[j];
+		mb.arc[i].poly_2[j] = poly_2[j];
+	}
+	mb.arc[i].radius = radius_min;
+	mb.arc[i].axis_1 = axis_1;
+	mb.arc[i].axis_2 = axis_2;
+	mb.arc[i].t_resume = 0;
+	mb.arc_refs[i]++;
+
+	bf->bf_func = _exec_aline;					// splines share the aline exec machinery
+	bf->arc_index = i;
+	bf->linenum = cm_get_model_linenum();		// block being planned
+	bf->motion_mode = cm_get_model_motion_mode();
+	bf->time = minutes;
+	bf->min_time = min_time;
+	bf->length = length;
+	copy_axis_vector(bf->target, target); 		// set target for runtime
+	copy_axis_vector(bf->unit, exit_unit);		// exit tangent (see mp_arc header notes)
+	bf->offset_index = mp_intern_work_offset(work_offset);	// propagate offset (interned)
+	bf->sync_output = mm.sync_output;			// carry any pending M62/M63 output command
+	mm.sync_output = SYNC_OUTPUT_NONE;
+
+	// Set the jerk term. The plane unit components rotate through the curve
+	// so the full jerk term of the more conservative plane axis is applied
+	bf->jerk = min(cfg.a[axis_1].jerk_max, cfg.a[axis_2].jerk_max);
+
+	if (fabs(bf->jerk - mm.prev_jerk) < cfg.jerk_match_precision) {	// can we re-use jerk terms? ($jmp)
+		bf->cbrt_jerk = mm.prev_cbrt_jerk;
+		bf->recip_jerk = mm.prev_recip_jerk;
+	} else {
+		bf->cbrt_jerk = cbrt(bf->jerk);
+		bf->recip_jerk = 1/bf->jerk;
+		mm.prev_jerk = bf->jerk;
+		mm.prev_cbrt_jerk = bf->cbrt_jerk;
+		mm.prev_recip_jerk = bf->recip_jerk;
+	}
+
+	// finish up the current block variables
+	if (cm_get_model_path_control() != PATH_EXACT_STOP) { // exact stop cases already zeroed
+		bf->replannable = true;
+		exact_stop = 12345678;					// an arbitrarily large floating point number
+	}
+	bf->cruise_vmax = (bf->length / bf->time) * mm.override_factor;	// target velocity requested
+	bf->cruise_vmax = min(bf->cruise_vmax, sqrt(radius_min * cfg.junction_acceleration)); // centripetal limit
+	junction_velocity = _get_junction_vmax(bf->pv->unit, entry_unit);
+	bf->junction_vmax = junction_velocity;		// saved for feed override rescaling
+	bf->entry_vmax = min3(bf->cruise_vmax, junction_velocity, exact_stop);
+	bf->delta_vmax = _get_target_velocity(0, bf->length, bf);
+	bf->exit_vmax = min3(bf->cruise_vmax, (bf->entry_vmax + bf->delta_vmax), exact_stop);
+	bf->braking_velocity = bf->delta_vmax;
+
+	uint8_t mr_flag = false;
+	_plan_block_list(bf, &mr_flag);				// replan block list and commit current block
+	copy_axis_vector(mm.position, bf->target);	// update planning position
+	mm.ms_in_queue += bf->time * 60000;			// the move's contribution to queue time
+	mp_queue_write_buffer(MOVE_TYPE_ARC);
+	if (bm.running == true) { bm.blocks++;}		// benchmark accounting
+	else if (dry.running == false) { jst.blocks++;}	// job statistics accounting (see planner.c)
 	return (STAT_OK);
 }
 
@@ -219,7 +682,6 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
  * _get_target_length()
  * _get_target_velocity()
  * _get_junction_vmax()
- * _reset_replannable_list()
  */
 
 /* _plan_block_list() - plans the entire block list
@@ -270,36 +732,50 @@ stat_t mp_aline(const float target[], const float minutes, const float work_offs
  *		backwards pass and prune the replan list to include only the the latest 
  *		blocks that require planning
  *
- *		In normal operation the first block (currently running block) is not 
- *		replanned, but may be for feedholds and feed overrides. In these cases 
- *		the prep routines modify the contents of the mr buffer and re-shuffle 
+ *		In normal operation the first block (currently running block) is not
+ *		replanned, but may be for feedholds and feed overrides. In these cases
+ *		the prep routines modify the contents of the mr buffer and re-shuffle
  *		the block list, re-enlisting the current bf buffer with new parameters.
- *		These routines also set all blocks in the list to be replannable so the 
- *		list can be recomputed regardless of exact stops and previous replanning 
- *		optimizations.
+ *		Feedholds only change blocks at the head of the queue, so they do not
+ *		come through here - see _plan_hold_list(), which runs a forward-only
+ *		pass from the run buffer and leaves the rest of the plan untouched.
  */
 static void _plan_block_list(mpBuf_t *bf, uint8_t *mr_flag)
 {
 	mpBuf_t *bp = bf;
 
 	// Backward planning pass. Find beginning of the list and update the braking velocities.
-	// At the end *bp points to the first buffer before the list.
+	// At the end *bp points to the first buffer before the list. The pass terminates early
+	// once a braking velocity recomputes to its previous value - the inputs to all earlier
+	// blocks are then unchanged, so the remainder of the chain is already correctly planned.
 	while ((bp = mp_get_prev_buffer(bp)) != bf) {
 		if (bp->replannable == false) { break; }
-		bp->braking_velocity = min(bp->nx->entry_vmax, bp->nx->braking_velocity) + bp->delta_vmax;
+		float braking_velocity = min(bp->nx->entry_vmax, bp->nx->braking_velocity) + bp->delta_vmax;
+		if (braking_velocity == bp->braking_velocity) { break; }	// converged (see above)
+		bp->braking_velocity = braking_velocity;
 	}
 
-	// forward planning pass - recomputes trapezoids in the list.
+	// forward planning pass - recomputes trapezoids in the list. Blocks whose entry and
+	// exit velocities come out unchanged keep their current trapezoid (the regeneration
+	// is by far the most expensive part of the pass).
 	while ((bp = mp_get_next_buffer(bp)) != bf) {
+		float entry_velocity;
 		if ((bp->pv == bf) || (*mr_flag == true))  {
-			bp->entry_velocity = bp->entry_vmax;		// first block in the list
+			entry_velocity = bp->entry_vmax;			// first block in the list
 			*mr_flag = false;
 		} else {
-			bp->entry_velocity = bp->pv->exit_velocity;	// other blocks in the list
+			entry_velocity = bp->pv->exit_velocity;		// other blocks in the list
+		}
+		float exit_velocity = min4(bp->exit_vmax, bp->nx->braking_velocity, bp->nx->entry_vmax,
+								  (entry_velocity + bp->delta_vmax));
+
+		if ((entry_velocity == bp->entry_velocity) && (exit_velocity == bp->exit_velocity) &&
+			(bp->cruise_velocity == bp->cruise_vmax)) {
+			continue;									// trapezoid is still current
 		}
+		bp->entry_velocity = entry_velocity;
 		bp->cruise_velocity = bp->cruise_vmax;
-		bp->exit_velocity = min4(bp->exit_vmax, bp->nx->braking_velocity, bp->nx->entry_vmax,
-								(bp->entry_velocity + bp->delta_vmax));
+		bp->exit_velocity = exit_velocity;
 		_calculate_trapezoid(bp);
 
 		// test for optimally planned trapezoids - only need to check various exit conditions
@@ -315,19 +791,6 @@ static void _plan_block_list(mpBuf_t *bf, uint8_t *mr_flag)
 	_calculate_trapezoid(bp);
 }
 
-/*
- *	_reset_replannable_list() - resets all blocks in the planning list to be replannable
- */	
-static void _reset_replannable_list()
-{
-	mpBuf_t *bf = mp_get_first_buffer();
-	if (bf == NULL) { return;}
-	mpBuf_t *bp = bf;
-	do {
-		bp->replannable = true;
-	} while (((bp = mp_get_next_buffer(bp)) != bf) && (bp->move_state != MOVE_STATE_OFF));
-}
-
 /*
  * _calculate_trapezoid() - calculate trapezoid parameters
  *
@@ -385,7 +848,7 @@ static void _reset_replannable_list()
  *
  *	  Rate-Limited cases - Ve and Vx can be satisfied but Vt cannot
  *	  	HT	(Ve=Vx)<Vt	symmetric case. Split the length and compute Vt.
- *	  	HT'	(Ve!=Vx)<Vt	asymmetric case. Find H and T by successive approximation.
+ *	  	HT'	(Ve!=Vx)<Vt	asymmetric case. Solve cruise velocity by Newton's method.
  *		HBT'			Lb < min body length - treated as an HT case
  *		H'				Lb < min body length - reduce J to fit H to length
  *		T'				Lb < min body length - reduce J to fit T to length
@@ -416,7 +879,7 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 	bf->tail_length = 0;
 
 	// Combined short cases:
-	//	- H and T requested-fit cases (exact fit cases, to within TRAPEZOID_LENGTH_FIT_TOLERANCE)
+	//	- H and T requested-fit cases (exact fit cases, to within the $tlf tolerance)
 	//	- H" and T" degraded-fit cases
 	//	- H' and T' requested-fit cases where the body residual is less than MIN_BODY_LENGTH
 	//	- no-fit case
@@ -424,7 +887,7 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 	float minimum_length = _get_target_length(bf->entry_velocity, bf->exit_velocity, bf);
 	if (bf->length <= (minimum_length + MIN_BODY_LENGTH)) {	// Head & tail cases
 		if (bf->entry_velocity > bf->exit_velocity)	{		// Tail cases
-			if (bf->length < (minimum_length - TRAPEZOID_LENGTH_FIT_TOLERANCE)) { 	// T" (degraded case)
+			if (bf->length < (minimum_length - cfg.trap_fit_tolerance)) { 	// T" (degraded case)
 				bf->entry_velocity = _get_target_velocity(bf->exit_velocity, bf->length, bf);
 			}
 			bf->cruise_velocity = bf->entry_velocity;
@@ -438,7 +901,7 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 			return;
 		}
 		if (bf->entry_velocity < bf->exit_velocity)	{		// Head cases
-			if (bf->length < (minimum_length - TRAPEZOID_LENGTH_FIT_TOLERANCE)) { 	// H" (degraded case)
+			if (bf->length < (minimum_length - cfg.trap_fit_tolerance)) { 	// H" (degraded case)
 				bf->exit_velocity = _get_target_velocity(bf->entry_velocity, bf->length, bf);
 			}
 			bf->cruise_velocity = bf->exit_velocity;
@@ -462,30 +925,36 @@ static void _calculate_trapezoid(mpBuf_t *bf)
 	if (bf->length < (bf->head_length + bf->tail_length)) { // it's rate limited
 
 		// Rate-limited HT case (symmetric case)
-		if (fabs(bf->entry_velocity - bf->exit_velocity) < TRAPEZOID_VELOCITY_TOLERANCE) {
+		if (fabs(bf->entry_velocity - bf->exit_velocity) < max(cfg.trap_velocity_tol, bf->entry_velocity/100)) {
 			bf->head_length = bf->length/2;
 			bf->tail_length = bf->head_length;
 			bf->cruise_velocity = min(bf->cruise_vmax, _get_target_velocity(bf->entry_velocity, bf->head_length, bf));
 			return;
 		}
 
-		// Rate-limited HT' case (asymmetric) - this is relatively expensive but it's not called very often
-		float computed_velocity = bf->cruise_vmax;
-		uint8_t i=0;
-		do {
-			bf->cruise_velocity = computed_velocity;	// initialize from previous iteration 
-			bf->head_length = _get_target_length(bf->entry_velocity, bf->cruise_velocity, bf);
-			bf->tail_length = _get_target_length(bf->exit_velocity, bf->cruise_velocity, bf);
-			if (bf->head_length > bf->tail_length) {
-				bf->head_length = (bf->head_length / (bf->head_length + bf->tail_length)) * bf->length;
-				computed_velocity = _get_target_velocity(bf->entry_velocity, bf->head_length, bf);
-			} else {
-				bf->tail_length = (bf->tail_length / (bf->head_length + bf->tail_length)) * bf->length;
-				computed_velocity = _get_target_velocity(bf->exit_velocity, bf->tail_length, bf);
-			}
-			if (++i > TRAPEZOID_ITERATION_MAX) { fprintf_P(stderr,PSTR("_calculate_trapezoid() failed to converge"));}
-		} while ((fabs(bf->cruise_velocity - computed_velocity) / computed_velocity) > TRAPEZOID_ITERATION_ERROR_PERCENT);
-		bf->cruise_velocity = computed_velocity;
+		// Rate-limited HT' case (asymmetric) - solve the cruise velocity directly.
+		// The head/tail constraint Lh(Ve,Vc) + Lt(Vx,Vc) = L combined with the
+		// length equation (see _get_target_length) gives:
+		//
+		//	  f(Vc)  = (Vc-Ve)^(3/2) + (Vc-Vx)^(3/2) - L*sqrt(Jm) = 0
+		//	  f'(Vc) = 1.5 * (sqrt(Vc-Ve) + sqrt(Vc-Vx))
+		//
+		// f is convex and monotonic in Vc so Newton's method converges 
+		// quadratically. Two fixed steps from the symmetric seed land well 
+		// inside the tolerance the old successive-approximation loop used, 
+		// so there is no convergence test and generation is constant-time.
+		float Ve = bf->entry_velocity;
+		float Vx = bf->exit_velocity;
+		float L_sqrt_J = bf->length * sqrt(bf->jerk);
+		float Vc = _get_target_velocity(min(Ve,Vx), bf->length/2, bf);	// symmetric seed
+		if (Vc < max(Ve,Vx)) { Vc = max(Ve,Vx);}		// keep the radicals real
+		for (uint8_t i=0; i<2; i++) {
+			float sqrt_h = sqrt(Vc - Ve);
+			float sqrt_t = sqrt(Vc - Vx);
+			float f = (sqrt_h*sqrt_h*sqrt_h) + (sqrt_t*sqrt_t*sqrt_t) - L_sqrt_J;
+			Vc = Vc - (f / (1.5 * (sqrt_h + sqrt_t)));
+		}
+		bf->cruise_velocity = min(Vc, bf->cruise_vmax);
 		bf->head_length = _get_target_length(bf->entry_velocity, bf->cruise_velocity, bf);
 		bf->tail_length = bf->length - bf->head_length;
 		if (bf->head_length < MIN_HEAD_LENGTH) {
@@ -567,18 +1036,79 @@ static void _calculate_trapezoid(mpBuf_t *bf)
  *	 d)	Vt = (sqrt(L)*(L/sqrt(1/Jm))^(1/6)+(1/Jm)^(1/4)*Vi)/(1/Jm)^(1/4)
  *	 e)	Vt = L^(2/3) * Jm^(1/3) + Vi
  *
+ *	The L^(2/3) term is computed by _pow_two_thirds() (below) instead of pow()
+ *	as this function is called repeatedly in the backplanning inner loop.
+ *
  *  FYI: Here's an expression that returns the jerk for a given deltaV and L:
  * 	return(cube(deltaV / (pow(L, 0.66666666))));
+ *
+ *	_get_target_length() results are memoized in mm.length_cache - see
+ *	"Target length cache" in planner.h for the policy.
  */
 
 static float _get_target_length(const float Vi, const float Vt, const mpBuf_t *bf)
 {
-	return (fabs(Vi-Vt) * sqrt(fabs(Vi-Vt) * bf->recip_jerk));
+	// order the pair (the equation is symmetric) and look for a cached result.
+	// Head and tail lengths of the same block then share one entry.
+	float vlo = min(Vi, Vt);
+	float vhi = max(Vi, Vt);
+	union { float f; uint8_t b[4]; } vu;
+	vu.f = vlo + vhi;						// mix both velocities into the hash
+	uint8_t hash = vu.b[1] + (vu.b[2] * 7) + vu.b[3];
+	mpLengthCacheEntry_t *lc = &mm.length_cache[hash & (TARGET_LENGTH_CACHE_SIZE-1)];
+	if ((lc->valid == true) && (lc->vlo == vlo) && (lc->vhi == vhi) &&
+		(lc->recip_jerk == bf->recip_jerk)) {
+		return (lc->length);
+	}
+	lc->vlo = vlo;
+	lc->vhi = vhi;
+	lc->recip_jerk = bf->recip_jerk;
+	lc->length = (vhi-vlo) * sqrt((vhi-vlo) * bf->recip_jerk);
+	lc->valid = true;
+	return (lc->length);
+}
+
+/*
+ * _pow_two_thirds() - fast x^(2/3) for the velocity equation
+ *
+ *	pow() goes through log()/exp() in avr-libc and dominates backplanning time.
+ *	This decomposes x into mantissa and exponent (frexp), interpolates the
+ *	mantissa term m^(2/3) from a 17 entry table, and reassembles the exponent
+ *	term as 2^(2e/3) = 4^q * 2^(2r/3) where e = 3q + r, 0 <= r < 3. Worst-case
+ *	interpolation error is ~0.01%, far inside the planner velocity tolerances.
+ *
+ *	The tables are constant: the jerk term enters equation e) through the
+ *	cached cbrt_jerk, so nothing here needs rebuilding when jerk settings change.
+ */
+
+static const float _pow23_mantissa[] PROGMEM = {	// m^(2/3) for m = 0.5 to 1.0 in 1/32 steps
+	0.62996052, 0.65594279, 0.68142022, 0.70642991,
+	0.73100443, 0.75517258, 0.77895996, 0.80238950,
+	0.82548181, 0.84825551, 0.87072747, 0.89291309,
+	0.91482643, 0.93648037, 0.95788679, 0.97905662,
+	1.00000000
+};
+static const float _pow23_exponent[] PROGMEM = {	// 2^(2r/3) for r = 0,1,2
+	1.00000000, 1.58740105, 2.51984210
+};
+
+static float _pow_two_thirds(const float x)
+{
+	if (x <= 0) { return (0);}
+	int e;
+	float m = frexp(x, &e);					// x = m * 2^e, m in [0.5, 1.0)
+	float t = (m - 0.5) * 32;
+	uint8_t i = (uint8_t)t;
+	float y0 = pgm_read_float(&_pow23_mantissa[i]);
+	float y1 = pgm_read_float(&_pow23_mantissa[i+1]);
+	int8_t r = e % 3;
+	if (r < 0) { r += 3;}					// normalize remainder for negative exponents
+	return (ldexp((y0 + (y1-y0) * (t-i)) * pgm_read_float(&_pow23_exponent[r]), 2*((e-r)/3)));
 }
 
 static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *bf)
 {
-	return (pow(L, 0.66666666) * bf->cbrt_jerk + Vi);
+	return (_pow_two_thirds(L) * bf->cbrt_jerk + Vi);
 }
 
 /*	
@@ -678,6 +1208,30 @@ static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *
  *	How to compute the radius using brute-force trig:
  *		float theta = acos(costheta);
  *		float radius = delta * sin(theta/2)/(1-sin(theta/2));
+ *
+ *	Results are memoized in mm.junction_cache, direct-mapped and keyed on the
+ *	quantized unit vector pair (see planner.h). Raster jobs repeat the same few
+ *	junction geometries for thousands of blocks, so nearly every call after the
+ *	first scanline is a hit that costs the quantization loop and a compare -
+ *	no delta fusion and no sqrt. Quantizing to 1/127ths limits the angular
+ *	aliasing to about half a degree, which is well below the geometry errors
+ *	already accepted by the 0.99 costheta cutoffs. Cached velocities embed the
+ *	junction deviation, junction acceleration and junction model settings -
+ *	and the G64 P blend tolerance when one is in effect - so the setters for
+ *	any of those values flush the cache (see mp_flush_junction_cache()).
+ *
+ *	The $jmo setting selects an alternate centripetal model (see planner.h).
+ *	It is the same corner-circle geometry worked from the direction-change
+ *	vector d = b_unit - a_unit, whose magnitude is 2*sin(phi/2) for a
+ *	direction change of phi. That removes the dot product and half-angle
+ *	identity, and for shallow crossings (under ~8 degrees, which the
+ *	deviation model's 0.99 cutoff lumps in with straight lines) the radius
+ *	linearizes to 8*delta/|d|^2 - so gentle direction changes get a real,
+ *	large junction velocity instead of either the 10 m/min flat pass or the
+ *	full slowdown, and the uncached cost is one divide plus the final sqrt.
+ *	The composite delta is fused from the per-axis junction deviations
+ *	weighted by each axis' share of the direction change, so an axis that
+ *	isn't turning doesn't drag the corner radius down.
  */
 /*  This version function extends Chamnit's algorithm by computing a value for delta that 
  *	takes the contributions of the individual axes in the move into account. It allows 
@@ -696,32 +1250,198 @@ static float _get_target_velocity(const float Vi, const float L, const mpBuf_t *
  */
 static float _get_junction_vmax(const float a_unit[], const float b_unit[])
 {
-	float costheta = - (a_unit[AXIS_X] * b_unit[AXIS_X]) - (a_unit[AXIS_Y] * b_unit[AXIS_Y]) 
-					  - (a_unit[AXIS_Z] * b_unit[AXIS_Z]) - (a_unit[AXIS_A] * b_unit[AXIS_A]) 
-					  - (a_unit[AXIS_B] * b_unit[AXIS_B]) - (a_unit[AXIS_C] * b_unit[AXIS_C]);
-
-	if (costheta < -0.99) { return (10000000); } 		// straight line cases
-	if (costheta > 0.99)  { return (0); } 				// reversal cases
-
-	// Fuse the junction deviations into a vector sum
-	float a_delta = square(a_unit[AXIS_X] * cfg.a[AXIS_X].junction_dev);
-	a_delta += square(a_unit[AXIS_Y] * cfg.a[AXIS_Y].junction_dev);
-	a_delta += square(a_unit[AXIS_Z] * cfg.a[AXIS_Z].junction_dev);
-	a_delta += square(a_unit[AXIS_A] * cfg.a[AXIS_A].junction_dev);
-	a_delta += square(a_unit[AXIS_B] * cfg.a[AXIS_B].junction_dev);
-	a_delta += square(a_unit[AXIS_C] * cfg.a[AXIS_C].junction_dev);
-
-	float b_delta = square(b_unit[AXIS_X] * cfg.a[AXIS_X].junction_dev);
-	b_delta += square(b_unit[AXIS_Y] * cfg.a[AXIS_Y].junction_dev);
-	b_delta += square(b_unit[AXIS_Z] * cfg.a[AXIS_Z].junction_dev);
-	b_delta += square(b_unit[AXIS_A] * cfg.a[AXIS_A].junction_dev);
-	b_delta += square(b_unit[AXIS_B] * cfg.a[AXIS_B].junction_dev);
-	b_delta += square(b_unit[AXIS_C] * cfg.a[AXIS_C].junction_dev);
-
-	float delta = (sqrt(a_delta) + sqrt(b_delta))/2;
-	float sintheta_over2 = sqrt((1 - costheta)/2);
-	float radius = delta * sintheta_over2 / (1-sintheta_over2);
-	return(sqrt(radius * cfg.junction_acceleration));
+	// quantize the unit vector pair and look for a cached result
+	int8_t key[2*AXES];
+	uint8_t i, hash = 0;
+	for (i=0; i<AXES; i++) {
+		key[i] = (int8_t)(a_unit[i] * JUNCTION_CACHE_QUANTA);
+		key[AXES+i] = (int8_t)(b_unit[i] * JUNCTION_CACHE_QUANTA);
+		hash = (hash * 7) + (uint8_t)key[i] + (uint8_t)key[AXES+i];
+	}
+	mpJunctionCacheEntry_t *jc = &mm.junction_cache[hash & (JUNCTION_CACHE_SIZE-1)];
+	if ((jc->valid == true) && (memcmp(jc->key, key, sizeof(key)) == 0)) {
+		return (jc->vmax);
+	}
+
+	float vmax;
+	if (cfg.junction_model == JUNCTION_MODEL_CENTRIPETAL) {	// $jmo=1
+		// The direction-change vector d = b_unit - a_unit has magnitude
+		// 2*sin(phi/2), phi being the direction change, which yields the
+		// corner radius without the dot product or half-angle identity.
+		// Shallow crossings (the common case on contour-parallel passes)
+		// use the small-angle radius 1-cos(phi/2) ~= |d|^2/8 and need no
+		// trig at all - one divide and the final sqrt.
+		float d_sq = 0;
+		for (i=0; i<AXES; i++) { d_sq += square(b_unit[i] - a_unit[i]);}
+
+		if (d_sq < 0.000001) { vmax = 10000000; }		// straight line cases
+		else if (d_sq > 3.96) { vmax = 0; } 			// reversal cases
+		else {
+			float delta;
+			float tolerance = cm_get_model_path_blend_tolerance();
+			if (tolerance > EPSILON) {		// G64 Pn - blend within the commanded path tolerance
+				delta = tolerance;
+			} else {						// fuse the junction deviations, weighted by how much
+				float d_wt = 0;				// each axis contributes to the direction change
+				float d_sum = 0;
+				for (i=0; i<AXES; i++) {
+					float d = fabs(b_unit[i] - a_unit[i]);
+					d_wt += d;
+					d_sum += d * cfg.a[i].junction_dev;
+				}
+				delta = d_sum / d_wt;		// d_wt > 0 - the straight cases exited above
+			}
+			if (d_sq < 0.02) {				// shallow crossing - under ~8 degrees
+				vmax = min(10000000, fast_sqrt((8 * delta * cfg.junction_acceleration) / d_sq));
+			} else {
+				float coshalf = fast_sqrt(1 - d_sq*0.25);	// cos(phi/2) = sin(theta/2)
+				float radius = delta * coshalf / (1-coshalf);
+				vmax = fast_sqrt(radius * cfg.junction_acceleration);
+			}
+		}
+	} else {	// JUNCTION_MODEL_DEVIATION
+		float costheta = - (a_unit[AXIS_X] * b_unit[AXIS_X]) - (a_unit[AXIS_Y] * b_unit[AXIS_Y])
+						  - (a_unit[AXIS_Z] * b_unit[AXIS_Z]);
+#if (AXES >= 4)
+		costheta -= (a_unit[AXIS_A] * b_unit[AXIS_A]);
+#endif
+#if (AXES >= 6)
+		costheta -= (a_unit[AXIS_B] * b_unit[AXIS_B]) + (a_unit[AXIS_C] * b_unit[AXIS_C]);
+#endif
+
+		if (costheta < -0.99) { vmax = 10000000; } 		// straight line cases
+		else if (costheta > 0.99)  { vmax = 0; } 		// reversal cases
+		else {
+			float delta;
+			float tolerance = cm_get_model_path_blend_tolerance();
+			if (tolerance > EPSILON) {		// G64 Pn - blend within the commanded path tolerance
+				delta = tolerance;
+			} else {						// fuse the junction deviations into a vector sum
+				float a_delta = square(a_unit[AXIS_X] * cfg.a[AXIS_X].junction_dev);
+				a_delta += square(a_unit[AXIS_Y] * cfg.a[AXIS_Y].junction_dev);
+				a_delta += square(a_unit[AXIS_Z] * cfg.a[AXIS_Z].junction_dev);
+#if (AXES >= 4)
+				a_delta += square(a_unit[AXIS_A] * cfg.a[AXIS_A].junction_dev);
+#endif
+#if (AXES >= 6)
+				a_delta += square(a_unit[AXIS_B] * cfg.a[AXIS_B].junction_dev);
+				a_delta += square(a_unit[AXIS_C] * cfg.a[AXIS_C].junction_dev);
+#endif
+
+				float b_delta = square(b_unit[AXIS_X] * cfg.a[AXIS_X].junction_dev);
+				b_delta += square(b_unit[AXIS_Y] * cfg.a[AXIS_Y].junction_dev);
+				b_delta += square(b_unit[AXIS_Z] * cfg.a[AXIS_Z].junction_dev);
+#if (AXES >= 4)
+				b_delta += square(b_unit[AXIS_A] * cfg.a[AXIS_A].junction_dev);
+#endif
+#if (AXES >= 6)
+				b_delta += square(b_unit[AXIS_B] * cfg.a[AXIS_B].junction_dev);
+				b_delta += square(b_unit[AXIS_C] * cfg.a[AXIS_C].junction_dev);
+#endif
+
+				delta = (fast_sqrt(a_delta) + fast_sqrt(b_delta))/2;
+			}
+			float sintheta_over2 = fast_sqrt((1 - costheta)/2);
+			float radius = delta * sintheta_over2 / (1-sintheta_over2);
+			vmax = fast_sqrt(radius * cfg.junction_acceleration);
+		}
+	}
+	memcpy(jc->key, key, sizeof(key));					// cache the result (overwrite on collision)
+	jc->vmax = vmax;
+	jc->valid = true;
+	return(vmax);
+}
+
+/*
+ * mp_flush_junction_cache() - invalidate cached junction velocities
+ *
+ *	Called by the config setters for junction deviation ($xjd), junction
+ *	acceleration ($ja) and junction model ($jmo), and by cm_set_path_control()
+ *	when the G64 P blend tolerance changes - all of which are baked into the
+ *	cached velocities.
+ */
+void mp_flush_junction_cache()
+{
+	memset(mm.junction_cache, 0, sizeof(mm.junction_cache));
+}
+
+/*
+ * mp_feed_rate_override() - override feed rates in the planner queue (M50.1)
+ *
+ *	Supports real-time override knobs generating events at 10-50 Hz. The work
+ *	per event is bounded: the replannable region of the queue (at most
+ *	PLANNER_BUFFER_POOL_SIZE blocks) is rescaled in one pass and replanned once
+ *	through the same _plan_block_list() machinery mp_aline() uses - blocks
+ *	whose velocities don't actually change fall out of the trapezoid
+ *	regeneration early.
+ *
+ *	Queued blocks: cruise_vmax is scaled by the ratio of the new factor to the
+ *	factor currently baked into the queue (new blocks pick the factor up in
+ *	mp_aline()). Entry and exit vmaxes are re-derived using the saved
+ *	junction_vmax, so cornering limits are never exceeded when overriding
+ *	upward. Committed blocks (replannable == false) are left alone, keeping the
+ *	replan velocity-continuous with the running move's planned exit.
+ *
+ *	Running block: if a cruise (body) section is executing its velocity is
+ *	scaled directly and the remaining segment count is recomputed from the
+ *	distance left. The change is clamped per-event to FEED_OVERRIDE_RAMP and
+ *	to the velocity the remaining tail can shed at the move's jerk, so repeated
+ *	pendant events converge on the target without losing steps. Head and tail
+ *	sections always complete at their planned (jerk limited) profiles.
+ */
+
+stat_t mp_feed_rate_override(uint8_t flag, float parameter)
+{
+	float factor = (flag == false) ? 1 : parameter;
+	factor = max(factor, FEED_OVERRIDE_MIN_FACTOR);
+	factor = min(factor, FEED_OVERRIDE_MAX_FACTOR);
+	if (fabs(factor - mm.override_factor) < EPSILON) { return (STAT_NOOP);}
+	float ratio = factor / mm.override_factor;
+	mm.override_factor = factor;
+
+	// rescale the replannable region of the queue and replan it once
+	mpBuf_t *bp = mp_get_first_buffer();
+	if (bp != NULL) {
+		mpBuf_t *last = mp_get_last_buffer();
+		uint8_t replan = false;
+		while (true) {
+			if (((bp->move_type == MOVE_TYPE_ALINE) || (bp->move_type == MOVE_TYPE_ARC)) &&
+				(bp->replannable == true)) {
+				bp->cruise_vmax *= ratio;
+				if (bp->move_type == MOVE_TYPE_ARC) {	// re-apply the centripetal limit
+					bp->cruise_vmax = min(bp->cruise_vmax, sqrt(mb.arc[bp->arc_index].radius * cfg.junction_acceleration));
+				}
+				bp->entry_vmax = min(bp->cruise_vmax, bp->junction_vmax);
+				bp->exit_vmax = min(bp->cruise_vmax, (bp->entry_vmax + bp->delta_vmax));
+				bp->braking_velocity = bp->delta_vmax;
+				replan = true;
+			}
+			if (bp == last) { break;}
+			bp = mp_get_next_buffer(bp);
+		}
+		if (replan == true) {
+			uint8_t mr_flag = false;
+			_plan_block_list(last, &mr_flag);
+		}
+	}
+
+	// scale the running move if it's in its cruise section
+	if ((mr.move_state == MOVE_STATE_BODY) && (mr.section_state == MOVE_STATE_RUN) && 
+		(mr.segment_count > 1)) {
+		float scale = min(max(ratio, (1 - FEED_OVERRIDE_RAMP)), (1 + FEED_OVERRIDE_RAMP));
+		float cruise = mr.cruise_velocity * scale;
+		if (mr.tail_length > EPSILON) {			// what can the tail shed at this jerk?
+			cruise = min(cruise, (mr.exit_velocity + (_pow_two_thirds(mr.tail_length) * cbrt(mr.jerk))));
+		} else {
+			cruise = min(cruise, mr.cruise_velocity);	// no tail - don't speed up
+		}
+		float remaining = mr.segment_count * mr.segment_velocity * mr.segment_move_time;
+		mr.cruise_velocity = cruise;
+		mr.segment_velocity = cruise;
+		mr.segment_count = (uint32_t)ceil(remaining / (cruise * mr.segment_move_time));
+		if (mr.segment_count == 0) { mr.segment_count = 1;}
+	}
+	return (STAT_OK);
 }
 
 /*************************************************************************
@@ -770,22 +1490,47 @@ static float _get_junction_vmax(const float a_unit[], const float b_unit[])
  *	 - bp (by itself) just refers to the current buffer being adjusted / replanned
  *
  *	Details: Planning re-uses bp+0 as an "extra" buffer. Normally bp+0 is returned 
- *		to the buffer pool as it is redundant once mr is loaded. Use the extra 
- *		buffer to split the move in two where the hold decelerates to zero. Use 
- *		one buffer to go to zero, the other to replan up from zero. All buffers past
- *		that point are unaffected other than that they need to be replanned for velocity.  
+ *		to the buffer pool as it is redundant once mr is loaded. The extra buffer
+ *		is spliced out of the head of the queue and re-linked at the point where 
+ *		the hold decelerates to zero, splitting that move in two: one buffer to
+ *		go to zero, the other to replan up from zero (see mp_splice_run_buffer()).
+ *		Only the split buffer is ever copied, so hold planning no longer stalls
+ *		the main loop shifting the whole queue down.
+ *
+ *		Replanning is also confined to the head of the queue. A hold changes
+ *		nothing about the moves past the split point except the entry velocity
+ *		chain - braking velocities are computed backwards from the end of the
+ *		queue and are untouched - so _plan_hold_list() runs a single forward
+ *		pass from the run buffer and stops as soon as the velocities reconverge
+ *		with the pre-hold plan. Everything past that point keeps its plan, and
+ *		a resume (mp_end_hold()) just restarts the steppers - no replanning at
+ *		all - so pause / inspect / resume is effectively instant. When
+ *		__LOOP_PROFILE is enabled both paths are timed and reported in the
+ *		"lp" group (lphp = hold planning uSec, lphr = resume uSec).
  *
  *	Note: There are multiple opportunities for more efficient organization of 
  *		  code in this module, but the code is so complicated I just left it
  *		  organized for clarity and hoped for the best from compiler optimization. 
  */
 
+// time the hold planning and resume paths on the loop profiler's timebase
+#ifdef __LOOP_PROFILE
+static uint16_t hold_timer_start;		// TIMER_LOOP count at path entry
+#define HOLD_PROFILE_START() (hold_timer_start = TIMER_LOOP.CNT)
+#define HOLD_PROFILE_END(field) (loop_rpt.field = \
+		(float)(uint16_t)(TIMER_LOOP.CNT - hold_timer_start) * LOOP_USEC_PER_TICK)
+#else
+#define HOLD_PROFILE_START()
+#define HOLD_PROFILE_END(field)
+#endif
+
 stat_t mp_plan_hold_callback()
 {
 	if (cm.hold_state != FEEDHOLD_PLAN) { return (STAT_NOOP);}	// not planning a feedhold
 
 	mpBuf_t *bp; 					// working buffer pointer
 	if ((bp = mp_get_run_buffer()) == NULL) { return (STAT_NOOP);}	// Oops! nothing's running
+	HOLD_PROFILE_START();
 
 	uint8_t mr_flag = true;		// used to tell replan to account for mr buffer Vx
 	float mr_available_length; // available length left in mr buffer for deceleration
@@ -793,7 +1538,15 @@ stat_t mp_plan_hold_callback()
 	float braking_length;		// distance required to brake to zero from braking_velocity
 
 	// examine and process mr buffer
-	mr_available_length = get_axis_vector_length(mr.endpoint, mr.position);
+	if (mr.move_is_arc == true) {
+		// the endpoint chord understates what's left of an arc (it's zero for
+		// a full circle) - use the accumulated path distance instead, so a
+		// mid-arc hold decelerates along the circle and resumes in place
+		mr_available_length = mr.length - mr.arc_length_run;
+		if (mr_available_length < 0) { mr_available_length = 0;}
+	} else {
+		mr_available_length = get_axis_vector_length(mr.endpoint, mr.position);	// exact - the decel must fit
+	}
 
 /*	mr_available_length = 
 		(sqrt(square(mr.endpoint[AXIS_X] - mr.position[AXIS_X]) +
@@ -829,10 +1582,11 @@ stat_t mp_plan_hold_callback()
 		bp->delta_vmax = _get_target_velocity(0, bp->length, bp);
 		bp->entry_vmax = 0;						// set bp+0 as hold point
 		bp->move_state = MOVE_STATE_NEW;		// tell _exec to re-use the bf buffer
+		bp->sync_output = SYNC_OUTPUT_NONE;		// any output already fired at the move start
 
-		_reset_replannable_list();				// make it replan all the blocks
-		_plan_block_list(mp_get_last_buffer(), &mr_flag);
+		_plan_hold_list(&mr_flag);				// replan the head of the queue
 		cm.hold_state = FEEDHOLD_DECEL;			// set state to decelerate and exit
+		HOLD_PROFILE_END(hold_plan);
 		return (STAT_OK);
 	}
 
@@ -846,11 +1600,13 @@ stat_t mp_plan_hold_callback()
 	mr.exit_velocity = braking_velocity - _get_target_velocity(0, mr_available_length, bp);	
 
 	// Find the point where deceleration reaches zero. This could span multiple buffers.
+	// The queued buffers are examined in place - no copying - and bp+0 (made
+	// redundant when its move was loaded into mr) is spliced in at the split
+	// point afterwards. See mp_splice_run_buffer() in planner.c.
 	braking_velocity = mr.exit_velocity;		// adjust braking velocity downward
-	bp->move_state = MOVE_STATE_NEW;			// tell _exec to re-use buffer
+	bp = mp_get_next_buffer(bp);				// start at the first queued block
 	for (uint8_t i=0; i<PLANNER_BUFFER_POOL_SIZE; i++) {// a safety to avoid wraparound
-		mp_copy_buffer(bp, bp->nx);				// copy bp+1 into bp+0 (and onward...)
-		if (bp->move_type != MOVE_TYPE_ALINE) {	// skip any non-move buffers
+		if ((bp->move_type != MOVE_TYPE_ALINE) && (bp->move_type != MOVE_TYPE_ARC)) {	// skip any non-move buffers
 			bp = mp_get_next_buffer(bp);		// point to next buffer
 			continue;
 		}
@@ -865,20 +1621,23 @@ stat_t mp_plan_hold_callback()
 		}
 		break;
 	}
-	// Deceleration now fits in the current bp buffer
-	// Plan the first buffer of the pair as the decel, the second as the accel
+	// Deceleration now fits in the current bp buffer. Splice the spare buffer in 
+	// after it and plan bp as the decel, the spare as the accel remainder.
+	mpBuf_t *spare = mp_splice_run_buffer(bp);	// also advances the run buffer to bp+1
+	mp_copy_buffer(spare, bp);					// the single copy made by hold planning
+	spare->sync_output = SYNC_OUTPUT_NONE;		// the output (if any) fires with bp, not the copy
+
 	bp->length = braking_length;
 	bp->exit_vmax = 0;
 
-	bp = mp_get_next_buffer(bp);				// point to the acceleration buffer
-	bp->entry_vmax = 0;
-	bp->length -= braking_length;				// the buffers were identical (and hence their lengths)
-	bp->delta_vmax = _get_target_velocity(0, bp->length, bp);
-	bp->exit_vmax = bp->delta_vmax;
+	spare->entry_vmax = 0;
+	spare->length -= braking_length;			// the buffers were identical (and hence their lengths)
+	spare->delta_vmax = _get_target_velocity(0, spare->length, spare);
+	spare->exit_vmax = spare->delta_vmax;
 
-	_reset_replannable_list();					// make it replan all the blocks
-	_plan_block_list(mp_get_last_buffer(), &mr_flag);
+	_plan_hold_list(&mr_flag);					// replan the head of the queue
 	cm.hold_state = FEEDHOLD_DECEL;				// set state to decelerate and exit
+	HOLD_PROFILE_END(hold_plan);
 	return (STAT_OK);
 }
 
@@ -888,12 +1647,70 @@ static float _compute_next_segment_velocity()
 	return (mr.segment_velocity + mr.forward_diff_1);
 }
 
+/*
+ * _plan_hold_list() - forward replan of the queue head for a feedhold
+ *
+ *	A hold only changes blocks at the head of the queue (the hold point and
+ *	the restart from zero). The braking velocities of everything downstream
+ *	are computed backwards from the end of the queue and are unaffected, so
+ *	the backward pass of _plan_block_list() has nothing to do. This runs just
+ *	the forward pass from the run buffer and returns as soon as a block's
+ *	velocities come out unchanged - from there on the pre-hold plan is still
+ *	optimal and is kept as-is. In practice this converges within a few blocks
+ *	of the hold point regardless of queue depth.
+ */
+static void _plan_hold_list(uint8_t *mr_flag)
+{
+	mpBuf_t *bp = mp_get_first_buffer();
+	if (bp == NULL) { return;}						// Oops! nothing's running
+	mpBuf_t *bf = mp_get_last_buffer();
+
+	while (bp != bf) {
+		float entry_velocity;
+		if (*mr_flag == true) {
+			entry_velocity = bp->entry_vmax;		// first block - entry was set by hold planning
+			*mr_flag = false;
+		} else {
+			entry_velocity = bp->pv->exit_velocity;	// other blocks in the list
+		}
+		float exit_velocity = min4(bp->exit_vmax, bp->nx->braking_velocity, bp->nx->entry_vmax,
+								  (entry_velocity + bp->delta_vmax));
+
+		if ((entry_velocity == bp->entry_velocity) && (exit_velocity == bp->exit_velocity) &&
+			(bp->cruise_velocity == bp->cruise_vmax)) {
+			return;									// reconverged - keep the pre-hold plan from here on
+		}
+		bp->entry_velocity = entry_velocity;
+		bp->cruise_velocity = bp->cruise_vmax;
+		bp->exit_velocity = exit_velocity;
+		_calculate_trapezoid(bp);
+
+		// maintain the optimally-planned markers for subsequent queue planning
+		if ((bp->exit_velocity == bp->exit_vmax) || (bp->exit_velocity == bp->nx->entry_vmax) ||
+		   ((bp->pv->replannable == false) && (bp->exit_velocity == bp->entry_velocity + bp->delta_vmax))) {
+			bp->replannable = false;
+		} else {
+			bp->replannable = true;
+		}
+		bp = mp_get_next_buffer(bp);
+	}
+	// finish up the last block move
+	bp->entry_velocity = bp->pv->exit_velocity;
+	bp->cruise_velocity = bp->cruise_vmax;
+	bp->exit_velocity = 0;
+	_calculate_trapezoid(bp);
+}
+
 /*
  * mp_end_hold() - end a feedhold
+ *
+ *	The restart plan was already computed when the hold was planned, so ending
+ *	a hold is just a matter of restarting the steppers on the run buffer.
  */
 stat_t mp_end_hold()
 {
-	if (cm.hold_state == FEEDHOLD_END_HOLD) { 
+	if (cm.hold_state == FEEDHOLD_END_HOLD) {
+		HOLD_PROFILE_START();
 		cm.hold_state = FEEDHOLD_OFF;
 		mpBuf_t *bf;
 		if ((bf = mp_get_run_buffer()) == NULL) {	// NULL means nothing's running
@@ -902,6 +1719,7 @@ stat_t mp_end_hold()
 		}
 		cm.motion_state = MOTION_RUN;
 		st_request_exec_move();					// restart the steppers
+		HOLD_PROFILE_END(hold_resume);
 	}
 	return (STAT_OK);
 }
@@ -1006,6 +1824,7 @@ static stat_t _exec_aline(mpBuf_t *bf)
 		mr.section_state = MOVE_STATE_NEW;
 		mr.linenum = bf->linenum;
 		mr.motion_mode = bf->motion_mode;
+		mr.sync_output = bf->sync_output;		// M62/M63 output riding on this move (if any)
 		mr.jerk = bf->jerk;
 		mr.head_length = bf->head_length;
 		mr.body_length = bf->body_length;
@@ -1015,7 +1834,37 @@ static stat_t _exec_aline(mpBuf_t *bf)
 		mr.exit_velocity = bf->exit_velocity;
 		copy_axis_vector(mr.unit, bf->unit);
 		copy_axis_vector(mr.endpoint, bf->target);	// save the final target of the move
-		copy_axis_vector(mr.work_offset, bf->work_offset);// propagate offset
+		copy_axis_vector(mr.work_offset, mb.offset[bf->offset_index]);// propagate offset
+		if (bf->move_type == MOVE_TYPE_ARC) {		// load curved geometry for exec interpolation
+			mr.move_is_arc = true;
+			mr.length = bf->length;					// total curve length - see mp_plan_hold_callback()
+			mr.arc_length_run = 0;
+			mr.arc_index = bf->arc_index;			// saved for spline t_resume writeback on hold
+			mr.arc_axis_1 = mb.arc[bf->arc_index].axis_1;
+			mr.arc_axis_2 = mb.arc[bf->arc_index].axis_2;
+			if (mb.arc[bf->arc_index].curve_type == CURVE_TYPE_SPLINE) {
+				mr.move_is_spline = true;
+				for (uint8_t i=0; i<4; i++) {
+					mr.sp_poly_1[i] = mb.arc[bf->arc_index].poly_1[i];
+					mr.sp_poly_2[i] = mb.arc[bf->arc_index].poly_2[i];
+				}
+				mr.sp_t = mb.arc[bf->arc_index].t_resume;	// 0, or the hold point on re-entry
+			} else {
+				mr.move_is_spline = false;
+				mr.arc_center_1 = mb.arc[bf->arc_index].center_1;
+				mr.arc_center_2 = mb.arc[bf->arc_index].center_2;
+				mr.arc_theta_per_mm = mb.arc[bf->arc_index].theta_per_mm;
+				mr.arc_radius_1 = mr.position[mr.arc_axis_1] - mr.arc_center_1;	// radius vector from wherever we
+				mr.arc_radius_2 = mr.position[mr.arc_axis_2] - mr.arc_center_2;	// are (correct for hold re-entry)
+			}
+		} else {
+			mr.move_is_arc = false;
+			mr.move_is_spline = false;
+			for (uint8_t i=0; i<AXES; i++) {		// Q16.16 state for the segment loop
+				mr.q_unit[i] = q16_from_float(bf->unit[i]);
+				mr.q_position[i] = q16_from_float(mr.position[i]);
+			}
+		}
 	}
 	// NB: from this point on the contents of the bf buffer do not affect execution
 
@@ -1033,6 +1882,9 @@ static stat_t _exec_aline(mpBuf_t *bf)
 
 	// Look for the end of the decel to go into HOLD state
 	if ((cm.hold_state == FEEDHOLD_DECEL) && (status == STAT_OK)) {
+		if (mr.move_is_spline == true) {		// the remainder buffer shares this geometry slot,
+			mb.arc[mr.arc_index].t_resume = mr.sp_t;	// so resume the curve where it stopped
+		}
 		cm.hold_state = FEEDHOLD_HOLD;
 		cm.motion_state = MOTION_HOLD;
 		rpt_request_status_report(SR_IMMEDIATE_REQUEST);
@@ -1092,6 +1944,13 @@ static void _init_forward_diffs(float t0, float t2)
 	mr.forward_diff_1 = AH_squared;
 	mr.forward_diff_2 = 2*AH_squared;
 	mr.segment_velocity = t0;
+
+	// Per-segment *distance* (velocity x the constant segment time) follows the
+	// same quadratic, so it forward-differences in fixed point with no multiply
+	// in the segment loop. Guarded (Q8.24) - see the range notes in q16.c
+	mr.q_travel = q16_guarded(t0 * mr.segment_move_time);
+	mr.q_travel_diff_1 = q16_guarded(AH_squared * mr.segment_move_time);
+	mr.q_travel_diff_2 = 2 * mr.q_travel_diff_1;
 }
 
 /*
@@ -1106,7 +1965,7 @@ static stat_t _exec_aline_head()
 		}
 		mr.midpoint_velocity = (mr.entry_velocity + mr.cruise_velocity) / 2;
 		mr.move_time = mr.head_length / mr.midpoint_velocity;	// time for entire accel region
-		mr.segments = ceil(uSec(mr.move_time) / (2 * cfg.estd_segment_usec)); // # of segments in *each half*
+		mr.segments = ceil(uSec(mr.move_time) / (2 * sg_segment_usec)); // # of segments in *each half*
 		mr.segment_move_time = mr.move_time / (2 * mr.segments);
 		mr.segment_count = (uint32_t)mr.segments;
 		if ((mr.microseconds = uSec(mr.segment_move_time)) < MIN_SEGMENT_USEC) {
@@ -1116,7 +1975,8 @@ static stat_t _exec_aline_head()
 		mr.section_state = MOVE_STATE_RUN1;
 	}
 	if (mr.section_state == MOVE_STATE_RUN1) {	// concave part of accel curve (period 1)
-		mr.segment_velocity += mr.forward_diff_1;
+		mr.segment_velocity += mr.forward_diff_1;	// (floats kept for hold planning)
+		mr.q_travel += mr.q_travel_diff_1;
 		if (_exec_aline_segment(false) == STAT_COMPLETE) { // set up for second half
 			mr.segment_count = (uint32_t)mr.segments;
 			mr.section_state = MOVE_STATE_RUN2;
@@ -1124,14 +1984,18 @@ static stat_t _exec_aline_head()
 			// Here's a trick: The second half of the S starts at the end of the first,
 			//  And the only thing that changes is the sign of mr.forward_diff_2
 			mr.forward_diff_2 = -mr.forward_diff_2;
+			mr.q_travel_diff_2 = -mr.q_travel_diff_2;
 		} else {
 			mr.forward_diff_1 += mr.forward_diff_2;
+			mr.q_travel_diff_1 += mr.q_travel_diff_2;
 		}
 		return(STAT_EAGAIN);
 	}
 	if (mr.section_state == MOVE_STATE_RUN2) {	// convex part of accel curve (period 2)
 		mr.segment_velocity += mr.forward_diff_1;
 		mr.forward_diff_1 += mr.forward_diff_2;
+		mr.q_travel += mr.q_travel_diff_1;
+		mr.q_travel_diff_1 += mr.q_travel_diff_2;
 		if (_exec_aline_segment(false) == STAT_COMPLETE) {
 			if ((fp_ZERO(mr.body_length)) && (fp_ZERO(mr.tail_length))) { return(STAT_OK);}	// end the move
 			mr.move_state = MOVE_STATE_BODY;
@@ -1144,8 +2008,15 @@ static stat_t _exec_aline_head()
 /*
  * _exec_aline_body()
  *
- *	The body is broken into little segments even though it is a straight line so that 
- *	feedholds can happen in the middle of a line with a minimum of latency
+ *	The body is constant velocity, so unlike the head and tail nothing changes
+ *	from segment to segment and there is no reason to pay exec/prep/load
+ *	overhead every 5ms. Straight-line bodies are run in long segments -
+ *	BODY_SEGMENT_USEC bounds the DDA tick range and the feedhold planning
+ *	latency (holds plan at segment boundaries - see mp_plan_hold_callback()),
+ *	and the substep clamp keeps the fastest motor's segment substeps inside
+ *	an int32 (see st_prep_line_substeps()). Arc bodies stay at the estd
+ *	segment size - they interpolate the circle at segment rate, so long
+ *	segments would cut chords.
  */
 static stat_t _exec_aline_body()
 {
@@ -1155,9 +2026,23 @@ static stat_t _exec_aline_body()
 			return(_exec_aline_tail());			// skip ahead to tail periods
 		}
 		mr.move_time = mr.body_length / mr.cruise_velocity;
-		mr.segments = ceil(uSec(mr.move_time) / cfg.estd_segment_usec);
+		float segment_usec = sg_segment_usec;
+		if (mr.move_is_arc == false) {
+			segment_usec = BODY_SEGMENT_USEC;
+			float substeps_per_unit = cfg.m[MOTOR_1].substeps_per_unit;
+			for (uint8_t i=MOTOR_2; i<MOTORS; i++) {	// fastest-geared motor binds the clamp
+				if (cfg.m[i].substeps_per_unit > substeps_per_unit) {
+					substeps_per_unit = cfg.m[i].substeps_per_unit;
+				}
+			}
+			float travel_usec = uSec(BODY_SEGMENT_MAX_SUBSTEPS / (substeps_per_unit * mr.cruise_velocity));
+			if (travel_usec < segment_usec) { segment_usec = travel_usec;}
+			if (segment_usec < sg_segment_usec) { segment_usec = sg_segment_usec;}
+		}
+		mr.segments = ceil(uSec(mr.move_time) / segment_usec);
 		mr.segment_move_time = mr.move_time / mr.segments;
 		mr.segment_velocity = mr.cruise_velocity;
+		mr.q_travel = q16_guarded(mr.cruise_velocity * mr.segment_move_time);
 		mr.segment_count = (uint32_t)mr.segments;
 		if ((mr.microseconds = uSec(mr.segment_move_time)) < MIN_SEGMENT_USEC) {
 			return(STAT_GCODE_BLOCK_SKIPPED);		// exit without advancing position
@@ -1184,7 +2069,7 @@ static stat_t _exec_aline_tail()
 		if (fp_ZERO(mr.tail_length)) { return(STAT_OK);}		// end the move
 		mr.midpoint_velocity = (mr.cruise_velocity + mr.exit_velocity) / 2;
 		mr.move_time = mr.tail_length / mr.midpoint_velocity;
-		mr.segments = ceil(uSec(mr.move_time) / (2 * cfg.estd_segment_usec));// # of segments in *each half*
+		mr.segments = ceil(uSec(mr.move_time) / (2 * sg_segment_usec));// # of segments in *each half*
 		mr.segment_move_time = mr.move_time / (2 * mr.segments);// time to advance for each segment
 		mr.segment_count = (uint32_t)mr.segments;
 		if ((mr.microseconds = uSec(mr.segment_move_time)) < MIN_SEGMENT_USEC) {
@@ -1194,7 +2079,8 @@ static stat_t _exec_aline_tail()
 		mr.section_state = MOVE_STATE_RUN1;
 	}
 	if (mr.section_state == MOVE_STATE_RUN1) {				// convex part (period 4)
-		mr.segment_velocity += mr.forward_diff_1;
+		mr.segment_velocity += mr.forward_diff_1;			// (floats kept for hold planning)
+		mr.q_travel += mr.q_travel_diff_1;
 		if (_exec_aline_segment(false) == STAT_COMPLETE) { 	  	// set up for second half
 			mr.segment_count = (uint32_t)mr.segments;
 			mr.section_state = MOVE_STATE_RUN2;
@@ -1202,57 +2088,230 @@ static stat_t _exec_aline_tail()
 			// Here's a trick: The second half of the S starts at the end of the first,
 			//  And the only thing that changes is the sign of mr.forward_diff_2
 			mr.forward_diff_2 = -mr.forward_diff_2;
+			mr.q_travel_diff_2 = -mr.q_travel_diff_2;
 		} else {
 			mr.forward_diff_1 += mr.forward_diff_2;
+			mr.q_travel_diff_1 += mr.q_travel_diff_2;
 		}
 		return(STAT_EAGAIN);
 	}
 	if (mr.section_state == MOVE_STATE_RUN2) {				// concave part (period 5)
 		mr.segment_velocity += mr.forward_diff_1;
 		mr.forward_diff_1 += mr.forward_diff_2;
+		mr.q_travel += mr.q_travel_diff_1;
+		mr.q_travel_diff_1 += mr.q_travel_diff_2;
 		if (_exec_aline_segment(true) == STAT_COMPLETE) { return (STAT_OK);}	// end the move
 	}
 	return(STAT_EAGAIN);
 }
 
+/* Input shaper ($zvf / $zvz)
+ *
+ *	ZV (two-impulse) input shaping stage between the segment runner and the
+ *	kinematics. Each segment target is convolved with the shaper kernel:
+ *
+ *		shaped(t) = A1*target(t) + A2*target(t - Td)
+ *
+ *	where Td is half the damped resonance period and A1/A2 are set by the
+ *	damping ratio. A command stream shaped this way puts (nearly) zero energy
+ *	into the resonance at the shaper frequency, so jerk and acceleration can
+ *	be raised well past where an unshaped gantry starts ringing. The delayed
+ *	term is read from a small ring of recent targets and interpolated, since
+ *	segment times vary; cost per segment is the ring walk (bounded by
+ *	SHAPER_RING_SIZE) plus one multiply-add per axis, which fits the exec
+ *	stage's fixed cadence.
+ *
+ *	The planner and runtime bookkeeping (mr.position, status reports, hold
+ *	planning) all stay on the unshaped trajectory - only the step stream fed
+ *	to the kinematics is shaped, tracked in sh.position so travel is always
+ *	differenced between shaped positions and step errors do not accumulate.
+ *	When the queue empties the shaped stream still lags the input by Td, so
+ *	mp_exec_shaper_drain() is run from mp_exec_move()'s idle path to feed
+ *	the delay line synthetic constant segments until it settles, landing
+ *	exactly on the commanded endpoint. Homing and probe cycles bypass the
+ *	shaper - a delayed response would shift switch strike positions.
+ *
+ * mp_config_input_shaper() - (re)compute the kernel from the config settings
+ * mp_exec_shaper_drain()   - settle the delay line after the queue empties
+ * _shaper_advance()		- push a target sample and convolve
+ */
+typedef struct shSample {
+	float duration;					// segment time from previous sample to this one (minutes)
+	float target[AXES];				// unshaped target at the end of the segment
+} shSample_t;
+
+static struct shShaperSingleton {
+	uint8_t armed;					// kernel is configured and shaping is on
+	uint8_t active;					// delay line is live (seeded and not yet drained)
+	float A1;						// first impulse amplitude  (A1 + A2 = 1)
+	float A2;						// second impulse amplitude
+	float delay;					// second impulse delay Td in minutes
+	float drain_time;				// constant-input time fed while draining (minutes)
+	uint8_t head;					// newest sample in the ring
+	uint8_t count;					// valid samples in the ring
+	shSample_t ring[SHAPER_RING_SIZE];
+	float input[AXES];				// last unshaped target pushed (drain holds this)
+	float position[AXES];			// last shaped position sent to the kinematics
+} sh;
+
+void mp_config_input_shaper()
+{
+	if (cfg.shaper_frequency < SHAPER_FREQUENCY_MIN) {	// $zvf=0 (or junk) turns shaping off
+		sh.armed = false;
+		sh.active = false;
+		return;
+	}
+	float zeta = cfg.shaper_damping;
+	float k = exp(-zeta * M_PI / fast_sqrt(1 - square(zeta)));
+	sh.A1 = 1 / (1+k);
+	sh.A2 = k / (1+k);
+	sh.delay = 1 / (2 * cfg.shaper_frequency * fast_sqrt(1 - square(zeta)) * 60);	// half damped period, minutes
+	sh.armed = true;
+	sh.active = false;				// re-seed the delay line on the next shaped segment
+}
+
+static void _shaper_advance(const float target[], const float duration, float shaped[])
+{
+	uint8_t i, n;
+
+	sh.head = (sh.head + 1) & (SHAPER_RING_SIZE-1);		// push the sample
+	if (sh.count < SHAPER_RING_SIZE) { sh.count++;}
+	sh.ring[sh.head].duration = duration;
+	copy_axis_vector(sh.ring[sh.head].target, target);
+	copy_axis_vector(sh.input, target);
+
+	// walk back to the pair of samples straddling the impulse delay
+	uint8_t k = sh.head;
+	float age = 0;					// age of the newer sample of the pair
+	float frac = 0;					// 0 = newer sample, 1 = older sample
+	const float *newer = sh.ring[k].target;
+	const float *older = newer;
+	for (n=1; n<sh.count; n++) {
+		float d = sh.ring[k].duration;
+		k = (k + SHAPER_RING_SIZE-1) & (SHAPER_RING_SIZE-1);
+		older = sh.ring[k].target;
+		if ((age + d) >= sh.delay) {
+			frac = (d < EPSILON) ? 1 : (sh.delay - age) / d;
+			break;
+		}
+		age += d;
+		newer = older;
+	}
+	if (n == sh.count) { older = newer; frac = 0;}		// short history - hold the oldest sample
+
+	for (i=0; i<AXES; i++) {
+		float delayed = newer[i] + ((older[i] - newer[i]) * frac);
+		shaped[i] = (sh.A1 * target[i]) + (sh.A2 * delayed);
+	}
+}
+
+stat_t mp_exec_shaper_drain()
+{
+	float travel[AXES];
+	float shaped[AXES];
+	int32_t steps_X_substeps[MOTORS];
+	uint8_t i;
+
+	if (sh.active == false) { return (STAT_NOOP);}
+	sh.drain_time += NOM_SEGMENT_TIME;
+	if (sh.drain_time >= sh.delay) {	// the delay line has settled - land exactly on the input
+		copy_axis_vector(shaped, sh.input);
+		sh.active = false;
+	} else {
+		_shaper_advance(sh.input, NOM_SEGMENT_TIME, shaped);
+	}
+	for (i=0; i<AXES; i++) { travel[i] = shaped[i] - sh.position[i];}
+	copy_axis_vector(sh.position, shaped);
+	ik_kinematics_substeps(travel, steps_X_substeps);
+	(void)st_prep_line_substeps(steps_X_substeps, (uint32_t)uSec(NOM_SEGMENT_TIME));
+	return (STAT_OK);
+}
+
 /*
  * _exec_aline_segment() - segment runner helper
  */
 static stat_t _exec_aline_segment(uint8_t correction_flag)
 {
 	float travel[AXES];
-	float steps[MOTORS];
+	int32_t travel_q[AXES];
+	int32_t steps_X_substeps[MOTORS];
+	uint8_t q16_segment = false;
 
 	// Multiply computed length by the unit vector to get the contribution for
 	// each axis. Set the target in absolute coords and compute relative steps.
 
-	if ((correction_flag == true) && (mr.segment_count == 1) && 
+	if ((correction_flag == true) && (mr.segment_count == 1) &&
 		(cm.motion_state == MOTION_RUN) && (cm.cycle_state == CYCLE_MACHINING)) {
 		mr.target[AXIS_X] = mr.endpoint[AXIS_X];	// rounding error correction for last segment
 		mr.target[AXIS_Y] = mr.endpoint[AXIS_Y];
 		mr.target[AXIS_Z] = mr.endpoint[AXIS_Z];
+#if (AXES >= 4)
 		mr.target[AXIS_A] = mr.endpoint[AXIS_A];
+#endif
+#if (AXES >= 6)
 		mr.target[AXIS_B] = mr.endpoint[AXIS_B];
 		mr.target[AXIS_C] = mr.endpoint[AXIS_C];
-	} else {
+#endif
+	} else if (mr.move_is_arc == true) {
 		float intermediate = mr.segment_velocity * mr.segment_move_time;
+		mr.arc_length_run += intermediate;			// path distance run - see mp_plan_hold_callback()
 		mr.target[AXIS_X] = mr.position[AXIS_X] + (mr.unit[AXIS_X] * intermediate);
 		mr.target[AXIS_Y] = mr.position[AXIS_Y] + (mr.unit[AXIS_Y] * intermediate);
 		mr.target[AXIS_Z] = mr.position[AXIS_Z] + (mr.unit[AXIS_Z] * intermediate);
+#if (AXES >= 4)
 		mr.target[AXIS_A] = mr.position[AXIS_A] + (mr.unit[AXIS_A] * intermediate);
+#endif
+#if (AXES >= 6)
 		mr.target[AXIS_B] = mr.position[AXIS_B] + (mr.unit[AXIS_B] * intermediate);
 		mr.target[AXIS_C] = mr.position[AXIS_C] + (mr.unit[AXIS_C] * intermediate);
+#endif
+		if (mr.move_is_spline == true) {
+			// plane axes follow the polynomial. Advance the parameter by path
+			// distance over the parametric speed |B'(t)| - segments are short
+			// enough that the speed is effectively constant across one
+			float t = mr.sp_t;
+			float speed_1 = mr.sp_poly_1[1] + t * ((2 * mr.sp_poly_1[2]) + (t * 3 * mr.sp_poly_1[3]));
+			float speed_2 = mr.sp_poly_2[1] + t * ((2 * mr.sp_poly_2[2]) + (t * 3 * mr.sp_poly_2[3]));
+			float speed = fast_sqrt(square(speed_1) + square(speed_2));	// mm of path per unit t
+			if (speed > EPSILON) { t += intermediate / speed;}
+			if (t > 1) { t = 1;}					// the endpoint correction absorbs the residual
+			mr.sp_t = t;
+			mr.target[mr.arc_axis_1] = mr.sp_poly_1[0] + t * (mr.sp_poly_1[1] + t * (mr.sp_poly_1[2] + (t * mr.sp_poly_1[3])));
+			mr.target[mr.arc_axis_2] = mr.sp_poly_2[0] + t * (mr.sp_poly_2[1] + t * (mr.sp_poly_2[2] + (t * mr.sp_poly_2[3])));
+		} else {
+			// plane axes follow the circle, not the unit vector
+			float dtheta = intermediate * mr.arc_theta_per_mm;
+			float sin_d = dtheta;						// small angle rotation - the residual
+			float cos_d = 1 - (dtheta * dtheta * 0.5);	// error is absorbed by the endpoint correction
+			float radius_1 = (mr.arc_radius_1 * cos_d) + (mr.arc_radius_2 * sin_d);
+			mr.arc_radius_2 = (mr.arc_radius_2 * cos_d) - (mr.arc_radius_1 * sin_d);
+			mr.arc_radius_1 = radius_1;
+			mr.target[mr.arc_axis_1] = mr.arc_center_1 + mr.arc_radius_1;
+			mr.target[mr.arc_axis_2] = mr.arc_center_2 + mr.arc_radius_2;
+		}
+	} else {
+		// Linear moves run the segment math in Q16.16 (see q16.c). Travel is
+		// unit * segment distance, which was forward-differenced to an add by
+		// the section helpers (mr.q_travel). The position accumulates the same
+		// quantized travel the steppers receive so errors do not accumulate;
+		// the float target is maintained for status reports and hold planning.
+		q16_t travel_mm = (q16_t)(mr.q_travel >> Q16_GUARD);
+		for (uint8_t i=0; i<AXES; i++) {
+			if (mr.q_unit[i] == 0) {				// axis does not participate in this move
+				travel_q[i] = 0;
+				mr.target[i] = mr.position[i];
+				continue;
+			}
+			travel_q[i] = q16_mul(mr.q_unit[i], travel_mm);
+			mr.q_position[i] += travel_q[i];
+			mr.target[i] = q16_to_float(mr.q_position[i]);
+		}
+		q16_segment = true;
 	}
-	travel[AXIS_X] = mr.target[AXIS_X] - mr.position[AXIS_X];
-	travel[AXIS_Y] = mr.target[AXIS_Y] - mr.position[AXIS_Y];
-	travel[AXIS_Z] = mr.target[AXIS_Z] - mr.position[AXIS_Z];
-	travel[AXIS_A] = mr.target[AXIS_A] - mr.position[AXIS_A];
-	travel[AXIS_B] = mr.target[AXIS_B] - mr.position[AXIS_B];
-	travel[AXIS_C] = mr.target[AXIS_C] - mr.position[AXIS_C];
-
-/* The above is a re-arranged and loop unrolled version of this:
+
+/* The Q16.16 linear path and the unrolled float paths above replace this:
 	for (uint8_t i=0; i < AXES; i++) {	// don't do the error correction if you are going into a hold
-		if ((correction_flag == true) && (mr.segment_count == 1) && 
+		if ((correction_flag == true) && (mr.segment_count == 1) &&
 			(cm.motion_state == MOTION_RUN) && (cm.cycle_state == CYCLE_STARTED)) {
 			mr.target[i] = mr.endpoint[i];	// rounding error correction for last segment
 		} else {
@@ -1262,9 +2321,68 @@ static stat_t _exec_aline_segment(uint8_t correction_flag)
 	}
 */
 	// prep the segment for the steppers and adjust the variables for the next iteration
-	ik_kinematics(travel, steps, mr.microseconds);
-	if (st_prep_line(steps, mr.microseconds) == STAT_OK) {
-		copy_axis_vector(mr.position, mr.target); 	// update runtime position	
+	if (bm.running == true) { 						// benchmark accounting
+		bm.segments++;
+		if (mr.move_state == MOVE_STATE_HEAD) { bm.head_segments++;}
+		else if (mr.move_state == MOVE_STATE_BODY) { bm.body_segments++;}
+		else { bm.tail_segments++;}
+	} else if (dry.running == false) {				// job statistics accounting (see planner.c)
+		jst.segments++;
+		if (mr.motion_mode == MOTION_MODE_STRAIGHT_TRAVERSE) {
+			jst.rapid_time += mr.segment_move_time * 60;	// segment_move_time is in minutes
+		} else {
+			jst.cutting_time += mr.segment_move_time * 60;
+		}
+		if (mr.segment_velocity > jst.velocity_max) { jst.velocity_max = mr.segment_velocity;}
+		for (uint8_t i=0; i<AXES; i++) {			// mr.position updates to mr.target below
+			jst.distance[i] += fabs(mr.target[i] - mr.position[i]);
+		}
+	}
+	if ((sh.armed == true) && (cm.cycle_state != CYCLE_HOMING) && (cm.cycle_state != CYCLE_PROBE)) {
+		float shaped[AXES];
+		if (sh.active == false) {					// (re)start the delay line from rest
+			sh.active = true;
+			sh.head = 0;
+			sh.count = 1;
+			sh.ring[0].duration = 0;
+			copy_axis_vector(sh.ring[0].target, mr.position);
+			copy_axis_vector(sh.position, mr.position);
+		}
+		sh.drain_time = 0;
+		_shaper_advance(mr.target, mr.segment_move_time, shaped);
+		travel[AXIS_X] = shaped[AXIS_X] - sh.position[AXIS_X];
+		travel[AXIS_Y] = shaped[AXIS_Y] - sh.position[AXIS_Y];
+		travel[AXIS_Z] = shaped[AXIS_Z] - sh.position[AXIS_Z];
+#if (AXES >= 4)
+		travel[AXIS_A] = shaped[AXIS_A] - sh.position[AXIS_A];
+#endif
+#if (AXES >= 6)
+		travel[AXIS_B] = shaped[AXIS_B] - sh.position[AXIS_B];
+		travel[AXIS_C] = shaped[AXIS_C] - sh.position[AXIS_C];
+#endif
+		copy_axis_vector(sh.position, shaped);
+		ik_kinematics_substeps(travel, steps_X_substeps);
+	} else if (q16_segment == true) {
+		ik_kinematics_substeps_q16(travel_q, steps_X_substeps);
+	} else {
+		travel[AXIS_X] = mr.target[AXIS_X] - mr.position[AXIS_X];
+		travel[AXIS_Y] = mr.target[AXIS_Y] - mr.position[AXIS_Y];
+		travel[AXIS_Z] = mr.target[AXIS_Z] - mr.position[AXIS_Z];
+#if (AXES >= 4)
+		travel[AXIS_A] = mr.target[AXIS_A] - mr.position[AXIS_A];
+#endif
+#if (AXES >= 6)
+		travel[AXIS_B] = mr.target[AXIS_B] - mr.position[AXIS_B];
+		travel[AXIS_C] = mr.target[AXIS_C] - mr.position[AXIS_C];
+#endif
+		ik_kinematics_substeps(travel, steps_X_substeps);
+	}
+	if (st_prep_line_substeps(steps_X_substeps, (uint32_t)mr.microseconds) == STAT_OK) {
+		if (mr.sync_output != SYNC_OUTPUT_NONE) {	// one-shot: attach the output command
+			st_prep_sync_output(mr.sync_output);	//  to the move's first segment
+			mr.sync_output = SYNC_OUTPUT_NONE;
+		}
+		copy_axis_vector(mr.position, mr.target); 	// update runtime position
 /*  TRY THIS
 		mr.position[AXIS_X] = mr.target[AXIS_X];
 		mr.position[AXIS_Y] = mr.target[AXIS_Y];
@@ -1274,6 +2392,9 @@ static stat_t _exec_aline_segment(uint8_t correction_flag)
 		mr.position[AXIS_C] = mr.target[AXIS_C];	
 */	
 	}
+	mp_publish_runtime_snapshot();	// expose this segment's state to status reports
+	rpt_watch_sample();				// $watch oscilloscope tap - one store when armed
+	bbx_log_segment();				// flight recorder tap - one record copy when armed
 	if (--mr.segment_count == 0) {
 		return (STAT_COMPLETE);	// this section has run all its segments
 	}
@@ -1485,9 +2606,13 @@ static void _make_unit_vector(float unit[], float x, float y, float z, float a,
 	unit[AXIS_X] = x/length;
 	unit[AXIS_Y] = y/length;
 	unit[AXIS_Z] = z/length;
+#if (AXES >= 4)
 	unit[AXIS_A] = a/length;
+#endif
+#if (AXES >= 6)
 	unit[AXIS_B] = b/length;
 	unit[AXIS_C] = c/length;
+#endif
 }
 
 static void _test_get_junction_vmax()
@@ -3,27 +3,27 @@
  * Part of TinyG project
  *
  * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- * Copyright (c) 2012 - 2013 Rob Giseburt
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * Copyright (c) 2012 - 2013 Rob Giseburt
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 /* --- Planner Notes ----
  *
@@ -67,7 +67,11 @@
 #include "spindle.h"
 #include "stepper.h"
 #include "report.h"
+#include "test.h"				// benchmark / dry run flags gate the job stats
 #include "util.h"
+#include <avr/interrupt.h>		// needed for tg_set_event
+#include "controller.h"			// for the buffer-freed wake event
+#include "xmega/xmega_rtc.h"	// startup fill gate timing
 //#include "xio/xio.h"			// uncomment for debugging
 
 /*
@@ -75,13 +79,44 @@
  */
 #define _bump(a) ((a<PLANNER_BUFFER_POOL_SIZE-1)?(a+1):0) // buffer incr & wrap
 #define spindle_speed time		// local alias for spindle_speed to the time variable
-#define int_val move_code		// local alias for uint8_t to the move_code
-#define dbl_val time			// local alias for float to the time variable
+#define int_val move_code		// local alias for uint8_t to the move_code
+#define dbl_val time			// local alias for float to the time variable
 
 // execution routines (NB: These are all called from the LO interrupt)
-static stat_t _exec_dwell(mpBuf_t *bf);
+static stat_t _exec_dwell(mpBuf_t *bf);
 static stat_t _exec_command(mpBuf_t *bf);
 
+/* Command ring (see mp_queue_command). Entries are produced at mainline and
+ * consumed at the exec (LO interrupt) level; the put and get indexes are
+ * single bytes so the ring needs no interrupt masking. The counters order
+ * commands against moves: a command runs once every buffer committed before
+ * it has completed.
+ */
+#define CMD_QUEUE_LEN 16
+#define _cq_bump(a) ((a<CMD_QUEUE_LEN-1)?(a+1):0)	// command ring incr & wrap
+
+typedef struct mpCmd {				// one queued command
+	cm_exec cm_func;				// callback to canonical machine execution function
+	uint8_t val_int;
+	float val_dbl;
+	uint32_t after;					// runs once this many buffers have completed
+} mpCmd_t;
+
+static struct mpCommandQueue {
+	uint8_t put;					// next slot to write (mainline only)
+	uint8_t get;					// next slot to run (exec level only)
+	uint32_t moves_queued;			// buffers committed via mp_queue_write_buffer()
+	uint32_t moves_completed;		// buffers released via mp_free_run_buffer()
+	mpCmd_t cmd[CMD_QUEUE_LEN];
+} cq;
+
+// startup fill gate state (see mp_exec_move and PLANNER_STARTUP_FILL_MS)
+static uint8_t su_holding;			// a startup hold is in progress
+static uint8_t su_release;			// end-of-stream seen - start without waiting for fill
+static uint32_t su_deadline;		// RTC tick bound on the hold
+
+void mp_release_startup_hold() { su_release = true;}
+
 #ifdef __DEBUG
 static uint8_t _get_buffer_index(mpBuf_t *bf); 
 static void _dump_plan_buffer(mpBuf_t *bf);
@@ -93,30 +128,37 @@ static void _dump_plan_buffer(mpBuf_t *bf);
 
 void mp_init()
 {
-// You can assume all memory has been zeroed by a hard reset. If not, use this code:
+// You can assume all memory has been zeroed by a hard reset. If not, use this code:
 //	memset(&mr, 0, sizeof(mr));	// clear all values, pointers and status
-//	memset(&mm, 0, sizeof(mm));	// clear all values, pointers and status
-
-	mr.magic_start = MAGICNUM;
-	mr.magic_end = MAGICNUM;
-	ar.magic_start = MAGICNUM;
-	ar.magic_end = MAGICNUM;
+//	memset(&mm, 0, sizeof(mm));	// clear all values, pointers and status
+
+	mm.override_factor = 1;		// feed override is unity until commanded otherwise
+	mr.magic_start = MAGICNUM;
+	mr.magic_end = MAGICNUM;
+	ar.magic_start = MAGICNUM;
+	ar.magic_end = MAGICNUM;
 	mp_init_buffers();
+	mp_publish_runtime_snapshot();	// seed the reporting snapshot from zeroed state
+	mp_update_soft_limits();	// no-op bounds until axes are homed - see plan_line.c
+	mp_reset_segment_usec();	// start segment time adaptation from $ms
 }
 
 /* 
  * mp_flush_planner() - flush all moves in the planner and all arcs
  *
- *	Does not affect the move currently running in mr.
- *	Does not affect mm or gm model positions
+ *	Does not affect the move currently running in mr.
+ *	Does not affect mm or gm model positions
  *	This function is designed to be called during a hold to reset the planner
  *	This function should not generally be called; call cm_flush_planner() instead
  */
 void mp_flush_planner()
 {
 	ar_abort_arc();
-	mp_init_buffers();
-	cm.motion_state = MOTION_STOP;
+	mp_discard_coalesced_line();
+	mp_init_buffers();
+	memset(&cq, 0, sizeof(cq));		// flush pending commands with the moves
+	mm.ms_in_queue = 0;
+	cm.motion_state = MOTION_STOP;
 //	copy_axis_vector(mm.position, mr.position);
 }
 
@@ -154,11 +196,12 @@ void mp_set_axes_position(const float position[])
 	copy_axis_vector(mm.position, position);
 	copy_axis_vector(mr.position, position);
 }
-
+
 void mp_set_axis_position(uint8_t axis, const float position)
 {
 	mm.position[axis] = position;
 	mr.position[axis] = position;
+	mp_publish_runtime_snapshot();
 }
 
 /*************************************************************************/
@@ -172,97 +215,169 @@ stat_t mp_exec_move()
 {
 	mpBuf_t *bf;
 
-	if ((bf = mp_get_run_buffer()) == NULL) return (STAT_NOOP);	// NULL means nothing's running
-
-	// Manage cycle and motion state transitions. 
-	// Cycle auto-start for lines only. 
-	if (bf->move_type == MOVE_TYPE_ALINE) {
+	// run any queued commands that have come due (see mp_queue_command)
+	while ((cq.get != cq.put) && (cq.cmd[cq.get].after <= cq.moves_completed)) {
+		cq.cmd[cq.get].cm_func(cq.cmd[cq.get].val_int, cq.cmd[cq.get].val_dbl);
+		cq.get = _cq_bump(cq.get);
+	}
+
+	if ((bf = mp_get_run_buffer()) == NULL) {	// NULL means nothing's running
+		if (cm.cycle_state == CYCLE_MACHINING) { rpt_queue_starved();}	// job is active but queue is empty
+		return (mp_exec_shaper_drain());		// settle the input shaper delay line, or NOOP
+	}
+
+	// Startup fill gate - when motion is about to start from rest, hold the
+	// first move until the queue carries enough planned time that the first
+	// block does not plan down to zero (see PLANNER_STARTUP_FILL_MS). A
+	// pending sync command marks end of stream and releases the hold, as
+	// does a full pool or the age backstop. Homing, probing and jogging
+	// cycles pace their own moves and are never held.
+	if (((bf->move_type == MOVE_TYPE_ALINE) || (bf->move_type == MOVE_TYPE_ARC)) &&
+		(mr.move_state == MOVE_STATE_OFF) && (st_isbusy() == false) &&
+		((cm.cycle_state == CYCLE_OFF) || (cm.cycle_state == CYCLE_MACHINING))) {
+		if (su_holding == false) {
+			su_holding = true;
+			su_deadline = rtc.clock_ticks + PLANNER_STARTUP_HOLD_TICKS;
+		}
+		if ((su_release == false) &&
+			(mm.ms_in_queue < PLANNER_STARTUP_FILL_MS) &&
+			(cq.get == cq.put) &&						// no sync command is waiting behind the moves
+			(mb.buffers_available != 0) &&				// a full pool cannot fill any further
+			(rtc.clock_ticks < su_deadline)) {
+			return (STAT_NOOP);							// keep filling
+		}
+	}
+	su_holding = false;									// motion is starting (or already running)
+	su_release = false;
+
+	// Manage cycle and motion state transitions. 
+	// Cycle auto-start for lines and arcs only. 
+	if ((bf->move_type == MOVE_TYPE_ALINE) || (bf->move_type == MOVE_TYPE_ARC)) {
 		if (cm.cycle_state == CYCLE_OFF) cm_cycle_start();
-		if (cm.motion_state == MOTION_STOP) cm.motion_state = MOTION_RUN;
-	}
-
+		if (cm.motion_state == MOTION_STOP) cm.motion_state = MOTION_RUN;
+	}
+
 	// run the move callback in the planner buffer
-	if (bf->bf_func != NULL) {
-		return (bf->bf_func(bf));
-	}
+	if (bf->bf_func != NULL) {
+		return (bf->bf_func(bf));
+	}
 	return (STAT_INTERNAL_ERROR);		// never supposed to get here
 }
 
 /************************************************************************************
- * mp_queue_command() - queue a synchronous Mcode, program control, or other command
- *
- *	How this works:
+ * mp_queue_command() - queue a synchronous Mcode, program control, or other command
+ *
+ *	How this works:
  *	  - The command is called by the Gcode interpreter (cm_<command>, e.g. an M code)
- *	  - cm_ function calls mp_queue_command which puts it in the planning queue.
- *		This involves setting some parameters and registering a callback to the 
- *		execution function in the canonical machine
- *	  - the planning queue gets to the function and calls _exec_command()
- *	  - ...which passes the saved parameters to the callback function
- *	  - To finish up _exec_command() needs to run a null pre and free the planner buffer
+ *	  - cm_ function calls mp_queue_command which records the callback and args in
+ *		the command ring, tagged with the number of planner buffers committed so far
+ *	  - the exec stage drains the ring at the top of mp_exec_move(): a command runs
+ *		once that many buffers have completed - i.e. after every move queued before
+ *		it has finished, and before the next move starts
+ *
+ *	Commands used to be queued through full planner buffers, which burned a slot
+ *	of the lookahead pool per Mcode - a command-dense program ("M3 S12000 G1 X10"
+ *	is two commands plus a move) shrank the effective lookahead exactly when it
+ *	was needed. The ring entries are a few bytes each and leave the whole pool
+ *	for plannable moves. If the ring is ever full the command falls back to the
+ *	old buffer path, which keeps ordering (the buffer bumps the commit count, so
+ *	later ring entries queue behind it) and degrades instead of dropping.
  *
  *	Doing it this way instead of synchronizing on queue empty simplifies the
- *	handling of feedholds, feed overrides, buffer flushes, and thread blocking,
+ *	handling of feedholds, feed overrides, buffer flushes, and thread blocking,
  *	and makes keeping the queue full much easier - therefore avoiding Q starvation
  */
-
+
 void mp_queue_command(void(*cm_exec)(uint8_t, float), uint8_t int_val, float float_val)
 {
 	mpBuf_t *bf;
-
+
+	(void)mp_flush_coalesced_line();	// commands must queue behind any held feed move
+
+	uint8_t next = _cq_bump(cq.put);
+	if (next != cq.get) {				// ring has room - the normal path
+		cq.cmd[cq.put].cm_func = cm_exec;
+		cq.cmd[cq.put].val_int = int_val;
+		cq.cmd[cq.put].val_dbl = float_val;
+		cq.cmd[cq.put].after = cq.moves_queued;
+		cq.put = next;					// single byte write commits the entry
+		st_request_exec_move();			// wake the exec in case the queue is idle
+		return;
+	}
+	// ring full - fall back to queueing through a planner buffer
 	// this error is not reported as buffer availability was checked upstream in the controller
-	if ((bf = mp_get_write_buffer()) == NULL) return;
+	if ((bf = mp_get_write_buffer()) == NULL) return;
 
-	bf->move_type = MOVE_TYPE_COMMAND;
-	bf->bf_func = _exec_command;		// callback to planner queue exec function
-	bf->cm_func = cm_exec;				// callback to canonical machine exec function
+	bf->move_type = MOVE_TYPE_COMMAND;
+	bf->bf_func = _exec_command;		// callback to planner queue exec function
+	bf->cm_func = cm_exec;				// callback to canonical machine exec function
 	bf->int_val = int_val;
-	bf->dbl_val = float_val;
-	mp_queue_write_buffer(MOVE_TYPE_COMMAND);
+	bf->dbl_val = float_val;
+	mp_queue_write_buffer(MOVE_TYPE_COMMAND);
 	return;
 }
 
 static stat_t _exec_command(mpBuf_t *bf)
-{
-	bf->cm_func(bf->int_val, bf->dbl_val);
-	st_prep_null();			// Must call a null prep to keep the loader happy. 
+{
+	bf->cm_func(bf->int_val, bf->dbl_val);
+	st_prep_null();			// Must call a null prep to keep the loader happy. 
 	mp_free_run_buffer();
-	return (STAT_OK);
+	return (STAT_OK);
 }
 
 /*************************************************************************
- * mp_dwell() 	 - queue a dwell
- * _exec_dwell() - dwell continuation
+ * mp_dwell() 		  - queue a dwell
+ * mp_spindle_dwell() - queue a dwell that releases at measured spindle speed
+ * _exec_dwell() 	  - dwell continuation
  *
  * Dwells are performed by passing a dwell move to the stepper drivers.
- * When the stepper driver sees a dwell it times the swell on a separate 
+ * When the stepper driver sees a dwell it times the swell on a separate
  * timer than the stepper pulse timer.
+ *
+ * A spindle dwell carries DWELL_CODE_SPINDLE_SYNC so the stepper countdown
+ * can end it early when the tach reports the spindle at speed (see
+ * st_dwell_rtc_callback). Its programmed time is the worst-case ceiling.
  */
 
-stat_t mp_dwell(float seconds) 
+static stat_t _queue_dwell(float seconds, uint8_t dwell_code)
 {
-	mpBuf_t *bf; 
+	mpBuf_t *bf;
+
+	ritorno(mp_flush_coalesced_line());			// dwell behind any held feed move
 
 	if ((bf = mp_get_write_buffer()) == NULL) {	// get write buffer or fail
 		return (STAT_BUFFER_FULL_FATAL);		// (not supposed to fail)
 	}
 	bf->bf_func = _exec_dwell;					// register callback to dwell start
-	bf->time = seconds;						  	// in seconds, not minutes
-	bf->move_state = MOVE_STATE_NEW;
-	mp_queue_write_buffer(MOVE_TYPE_DWELL); 
+	bf->move_code = dwell_code;
+	bf->time = seconds;						  	// in seconds, not minutes
+	bf->move_state = MOVE_STATE_NEW;
+	mm.ms_in_queue += seconds * 1000;			// the dwell's contribution to queue time
+	mp_queue_write_buffer(MOVE_TYPE_DWELL);
 	return (STAT_OK);
 }
-
+
+stat_t mp_dwell(float seconds)
+{
+	return (_queue_dwell(seconds, DWELL_CODE_PLAIN));
+}
+
+stat_t mp_spindle_dwell(float seconds)
+{
+	return (_queue_dwell(seconds, DWELL_CODE_SPINDLE_SYNC));
+}
+
 void mp_end_dwell()								// all's well that ends dwell
 {
-	mp_free_run_buffer();						// Note: this is called from an interrupt
-}
+	mp_free_run_buffer();						// Note: this is called from an interrupt
+}
 
 static stat_t _exec_dwell(mpBuf_t *bf)
 {
-	if (bf->move_state == MOVE_STATE_NEW) {
-		st_prep_dwell((uint32_t)(bf->time * 1000000));// convert seconds to uSec
-		bf->move_state = MOVE_STATE_RUN;
-	}
+	if (bf->move_state == MOVE_STATE_NEW) {
+		st_prep_dwell((uint32_t)(bf->time * 1000000), bf->move_code);// convert seconds to uSec
+		bf->move_state = MOVE_STATE_RUN;
+	}
 	return (STAT_OK);
 }
 
@@ -317,14 +432,23 @@ static stat_t _exec_dwell(mpBuf_t *bf)
 
 uint8_t mp_get_planner_buffers_available(void) { return (mb.buffers_available);}
 
+uint8_t mp_get_arc_slots_available(void)	// # of free arc geometry slots (see PLANNER_ARC_POOL_SIZE)
+{
+	uint8_t available = 0;
+	for (uint8_t i=0; i < PLANNER_ARC_POOL_SIZE; i++) {
+		if (mb.arc_refs[i] == 0) { available++;}
+	}
+	return (available);
+}
+
 void mp_init_buffers(void)
 {
 	mpBuf_t *pv;
 	uint8_t i;
-
+
 	memset(&mb, 0, sizeof(mb));		// clear all values, pointers and status
-	mb.magic_start = MAGICNUM;
-	mb.magic_end = MAGICNUM;
+	mb.magic_start = MAGICNUM;
+	mb.magic_end = MAGICNUM;
 
 	mb.w = &mb.bf[0];				// init write and read buffer pointers
 	mb.q = &mb.bf[0];
@@ -368,8 +492,9 @@ void mp_queue_write_buffer(const uint8_t move_type)
 	mb.q->move_state = MOVE_STATE_NEW;
 	mb.q->buffer_state = MP_BUFFER_QUEUED;
 	mb.q = mb.q->nx;							// advance the queued buffer pointer
+	cq.moves_queued++;							// commands queued after this buffer wait for it
 	st_request_exec_move();						// request a move exec if not busy
-	rpt_request_queue_report(+1);				// add to the "added buffers" count
+	rpt_request_queue_report(+1);				// add to the "added buffers" count
 }
 
 mpBuf_t * mp_get_run_buffer() 
@@ -388,15 +513,123 @@ mpBuf_t * mp_get_run_buffer()
 
 void mp_free_run_buffer()						// EMPTY current run buf & adv to next
 {
+	if ((mb.r->move_type == MOVE_TYPE_ALINE) || (mb.r->move_type == MOVE_TYPE_ARC)) {
+		mm.ms_in_queue -= mb.r->time * 60000;	// bf->time is in minutes for moves...
+		mm.ms_executed += mb.r->time * 60000;	// job progress accounting (see mp_set_job_time_total)
+	} else if (mb.r->move_type == MOVE_TYPE_DWELL) {
+		mm.ms_in_queue -= mb.r->time * 1000;	// ...and in seconds for dwells
+		mm.ms_executed += mb.r->time * 1000;
+	}
+	if (mm.ms_in_queue < 0) mm.ms_in_queue = 0;	// guard against accumulated float drift
 	mp_clear_buffer(mb.r);						// clear it out (& reset replannable)
 //	mb.r->buffer_state = MP_BUFFER_EMPTY;		// redundant after the clear, above
 	mb.r = mb.r->nx;							 // advance to next run buffer
 	if (mb.r->buffer_state == MP_BUFFER_QUEUED) {// only if queued...
 		mb.r->buffer_state = MP_BUFFER_PENDING;  // pend next buffer
 	}
-	if (mb.w == mb.r) cm_cycle_end();			// end the cycle if the queue empties
-	mb.buffers_available++;
-	rpt_request_queue_report(-1);				// add to the "removed buffers" count
+	if (mb.w == mb.r) {							// end the cycle if the queue empties
+		mm.ms_in_queue = 0;						// empty queue re-zeroes queue time exactly
+		cm_cycle_end();
+	}
+	mb.buffers_available++;
+	cq.moves_completed++;						// commands waiting on this buffer are now due
+	tg_set_event(EVENT_BUFFER_bm);				// wake the controller if it's blocked on headroom
+	rpt_request_queue_report(-1);				// add to the "removed buffers" count
+}
+
+/*
+ * Job progress accounting
+ *
+ * mp_set_job_time_total()		 - set the planned job time and restart the job clock
+ * mp_reset_job_clock()			 - zero the executed-time accumulator (program end)
+ * mp_get_job_percent_complete() - percent of the planned job time executed
+ * mp_get_job_time_remaining()	 - planned job seconds left to run
+ *
+ *	mm.ms_executed accumulates the same per-buffer time contributions that
+ *	mp_free_run_buffer() retires from mm.ms_in_queue, extending the queue
+ *	time accounting to whole-job scope at no cost beyond one add per block.
+ *	The job total comes from a $dry estimate (see test.c) or is set directly
+ *	by the host with $jt, either of which restarts the job clock. The clock
+ *	also restarts at program end (M2/M30) so the same total can be reused
+ *	for a repeat run. With no total set percent reads 0 and remaining reads
+ *	the (zero) total. $prog and $eta are SR-selectable, so displays can
+ *	subscribe to progress in status reports instead of polling line numbers
+ *	and re-estimating host side.
+ */
+void mp_set_job_time_total(const float seconds)
+{
+	mm.job_time_total = seconds;
+	mm.ms_executed = 0;
+}
+
+void mp_reset_job_clock()
+{
+	mm.ms_executed = 0;
+}
+
+float mp_get_job_percent_complete()
+{
+	if (mm.job_time_total < EPSILON) { return (0);}
+	float percent = mm.ms_executed / (mm.job_time_total * 10);	// (ms/1000) / seconds * 100
+	if (percent > 100) { percent = 100;}
+	return (percent);
+}
+
+float mp_get_job_time_remaining()
+{
+	float remaining = mm.job_time_total - (mm.ms_executed / 1000);
+	if (remaining < 0) { remaining = 0;}
+	return (remaining);
+}
+
+/*
+ * Job statistics accounting
+ *
+ * mp_reset_job_stats()			 - zero the accumulators
+ * mp_request_job_stats_report() - queue the end-of-job report (program end)
+ * mp_job_stats_callback()		 - print the report from the main loop
+ *
+ *	The jst accumulators extend the job clock with throughput data: travel
+ *	per axis, cutting vs rapid time, block / segment counts and the highest
+ *	segment velocity sustained, all updated in O(1) per segment from values
+ *	_exec_aline_segment() already holds (see the hooks in plan_line.c), so
+ *	utilization comes from the machine itself instead of host-side log
+ *	parsing that misses on-board motion ($test, jobr, jogging, homing).
+ *	The group is readable any time as $jst, and M2/M30 queues a one-line
+ *	JSON report, after which the accumulators zero so each report covers
+ *	one job. Feedholds accumulate into the same job; benchmark and dry run
+ *	passes are excluded - they report their own numbers (see test.c).
+ *	The report prints from the controller loop, not from the exec call
+ *	chain the program-end command runs in.
+ */
+void mp_reset_job_stats()
+{
+	memset(&jst, 0, sizeof(jst));
+}
+
+void mp_request_job_stats_report()
+{
+	if ((bm.running == true) || (dry.running == true)) { return;}
+	if (jst.segments == 0) { return;}			// nothing ran - nothing to report
+	jst.report_requested = true;
+}
+
+stat_t mp_job_stats_callback()
+{
+	if (jst.report_requested == false) { return (STAT_NOOP);}
+	jst.report_requested = false;
+
+	char axes[] = {"xyzabc"};
+	fprintf_P(stderr, PSTR("{\"jst\":{"));
+	for (uint8_t i=0; i<AXES; i++) {
+		fprintf_P(stderr, PSTR("\"%c\":%1.3f,"), axes[i], (double)jst.distance[i]);
+	}
+	fprintf_P(stderr, PSTR("\"ct\":%1.1f,\"rt\":%1.1f,\"vm\":%1.1f,\"bl\":%lu,\"sg\":%lu}}\n"),
+		(double)jst.cutting_time, (double)jst.rapid_time, (double)jst.velocity_max,
+		(unsigned long)jst.blocks, (unsigned long)jst.segments);
+
+	mp_reset_job_stats();						// each report covers one job
+	return (STAT_OK);
 }
 
 mpBuf_t * mp_get_first_buffer(void)
@@ -423,19 +656,85 @@ mpBuf_t * mp_get_last_buffer(void)
 //mpBuf_t * mp_get_prev_buffer(const mpBuf_t *bf) { return (bf->pv);}
 //mpBuf_t * mp_get_next_buffer(const mpBuf_t *bf) { return (bf->nx);}
 
+/*
+ * mp_intern_work_offset() - intern a work offset set, returns its index
+ *
+ *	See PLANNER_OFFSET_POOL_SIZE in planner.h for the scheme. The returned
+ *	index carries one reference which is released when the buffer is cleared.
+ */
+uint8_t mp_intern_work_offset(const float offset[])
+{
+	uint8_t i = mb.offset_current;
+
+	if (memcmp(mb.offset[i], offset, sizeof(mb.offset[i])) != 0) {
+		for (i=0; i < PLANNER_OFFSET_POOL_SIZE; i++) {
+			if (mb.offset_refs[i] == 0) { break;}
+		}
+		if (i == PLANNER_OFFSET_POOL_SIZE) { i = mb.offset_current;} // overwrite in place (see planner.h)
+		copy_axis_vector(mb.offset[i], offset);
+		mb.offset_current = i;
+	}
+	mb.offset_refs[i]++;
+	return (i);
+}
+
 void mp_clear_buffer(mpBuf_t *bf) 
 {
 	mpBuf_t *nx = bf->nx;			// save pointers
 	mpBuf_t *pv = bf->pv;
+	if ((bf->move_type == MOVE_TYPE_ALINE) || (bf->move_type == MOVE_TYPE_ARC)) {
+		if (mb.offset_refs[bf->offset_index] > 0) { mb.offset_refs[bf->offset_index]--;}	// release the interned work offset
+	}
+	if (bf->move_type == MOVE_TYPE_ARC) {		// release the arc geometry slot
+		if (mb.arc_refs[bf->arc_index] > 0) { mb.arc_refs[bf->arc_index]--;}
+	}
 	memset(bf, 0, sizeof(mpBuf_t));
 	bf->nx = nx;					// restore pointers
 	bf->pv = pv;
 }
 
+/*
+ * mp_splice_run_buffer() - relocate the run buffer to follow bp (zero-copy hold split)
+ *
+ *	Used by hold planning (Case 2). The run buffer is redundant once its move
+ *	has been loaded into mr, so instead of copying every queued buffer down one
+ *	slot to free a slot at the split point, unlink the run buffer from the head
+ *	of the queue and re-link it immediately after bp. The ring is only ever
+ *	traversed through the pv/nx links and the r/w/q pointers, so relocating one
+ *	slot is safe. The queue then starts at the first actually-queued block.
+ *	Returns the relocated (spare) buffer; its contents are stale - the caller
+ *	is expected to mp_copy_buffer() into it.
+ *
+ *	Must not be called while the exec interrupt can touch the queue (it is 
+ *	called from hold planning, which runs while exec is paused in FEEDHOLD_PLAN).
+ */
+mpBuf_t * mp_splice_run_buffer(mpBuf_t *bp)
+{
+	mpBuf_t *spare = mb.r;
+	mb.r = spare->nx;				// queue now starts at the first queued block
+	spare->pv->nx = spare->nx;		// unlink the spare from the head of the queue
+	spare->nx->pv = spare->pv;
+	spare->nx = bp->nx;				// re-link the spare directly after bp
+	spare->pv = bp;
+	bp->nx->pv = spare;
+	bp->nx = spare;
+	return (spare);
+}
+
 void mp_copy_buffer(mpBuf_t *bf, const mpBuf_t *bp)
 {
 	mpBuf_t *nx = bf->nx;			// save pointers
 	mpBuf_t *pv = bf->pv;
+	if ((bp->move_type == MOVE_TYPE_ALINE) || (bp->move_type == MOVE_TYPE_ARC)) {	// copy adds an offset reference
+		mb.offset_refs[bp->offset_index]++;
+		if (bp->move_type == MOVE_TYPE_ARC) { mb.arc_refs[bp->arc_index]++;}		// and an arc geometry reference
+	}
+	if ((bf->move_type == MOVE_TYPE_ALINE) || (bf->move_type == MOVE_TYPE_ARC)) {	// and drops those being overwritten
+		if (mb.offset_refs[bf->offset_index] > 0) { mb.offset_refs[bf->offset_index]--;}
+		if (bf->move_type == MOVE_TYPE_ARC) {
+			if (mb.arc_refs[bf->arc_index] > 0) { mb.arc_refs[bf->arc_index]--;}
+		}
+	}
  	memcpy(bf, bp, sizeof(mpBuf_t));
 	bf->nx = nx;					// restore pointers
 	bf->pv = pv;
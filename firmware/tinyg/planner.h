@@ -1,122 +1,217 @@
-/*
- * planner.h - cartesian trajectory planning and motion execution
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#ifndef planner_h
-#define planner_h 
-
-enum moveType {				// bf->move_type values 
-	MOVE_TYPE_NULL = 0,		// null move - does a no-op
-	MOVE_TYPE_ALINE,		// acceleration planned line
-	MOVE_TYPE_DWELL,		// delay with no movement
-	MOVE_TYPE_COMMAND,		// general command
-	MOVE_TYPE_TOOL,			// T command
-	MOVE_TYPE_SPINDLE_SPEED,// S command
-	MOVE_TYPE_STOP,			// program stop
-	MOVE_TYPE_END			// program end
-};
-
-enum moveState {
-	MOVE_STATE_OFF = 0,		// move inactive (MUST BE ZERO)
-	MOVE_STATE_NEW,			// general value if you need an initialization
-	MOVE_STATE_RUN,			// general run state (for non-acceleration moves) 
-	MOVE_STATE_RUN2,		// used for sub-states
-	MOVE_STATE_HEAD,		// aline() acceleration portions
-	MOVE_STATE_BODY,		// aline() cruise portions
-	MOVE_STATE_TAIL,		// aline() deceleration portions
-	MOVE_STATE_SKIP,		// mark a skipped block
-	MOVE_STATE_END			// move is marked as done (used by dwells)
-};
-#define MOVE_STATE_RUN1 MOVE_STATE_RUN // a convenience
-
-/*** Most of these factors are the result of a lot of tweaking. Change with caution.***/
-
-/* The following must apply:
- *	  MM_PER_ARC_SEGMENT >= MIN_LINE_LENGTH >= MIN_SEGMENT_LENGTH 
- */
-#define ARC_SEGMENT_LENGTH 		((float)0.1)		// Arc segment size (mm).(0.03)
-#define MIN_LINE_LENGTH 		((float)0.08)		// Smallest line the system can plan (mm) (0.02)
-#define MIN_SEGMENT_LENGTH 		((float)0.05)		// Smallest accel/decel segment (mm). Set to produce ~10 ms segments (0.01)
-#define MIN_LENGTH_MOVE 		((float)0.001)		// millimeters
-
-#define JERK_MATCH_PRECISION 1000	// precision to which jerk must match to be considered effectively the same
-
-/* ESTD_SEGMENT_USEC	 Microseconds per planning segment
- *	Should be experimentally adjusted if the MIN_SEGMENT_LENGTH is changed
- */
-#define NOM_SEGMENT_USEC 		((float)5000)		// nominal segment time
-#define MIN_SEGMENT_USEC 		((float)2500)		// minimum segment time
-#define MIN_ARC_SEGMENT_USEC	((float)10000)		// minimum arc segment time
-
-//derived from above
-#define NOM_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
-#define MIN_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
-#define MIN_ARC_SEGMENT_TIME 	(MIN_ARC_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
-#define MIN_TIME_MOVE  			MIN_SEGMENT_USEC	// minimum time a move can be is one segment
-
-/* PLANNER_STARTUP_DELAY_SECONDS
- *	Used to introduce a short dwell before planning an idle machine.
- *  If you don;t do this the first block will always plan to zero as it will
- *	start executing before the next block arrives from the serial port.
- *	This cuases the machine to stutter once on startup.
- */
-#define PLANNER_STARTUP_DELAY_SECONDS 0.05	// in seconds
-
-/* PLANNER_BUFFER_POOL_SIZE
- *	Should be at least the number of buffers requires to support optimal 
- *	planning in the case of very short lines or arc segments. 
- *	Suggest 12 min. Limit is 255
- */
-#define PLANNER_BUFFER_POOL_SIZE 28
-#define PLANNER_BUFFER_HEADROOM 4			// buffers to reserve in planner before processing new input line
-
-/* Some parameters for _generate_trapezoid()
- * TRAPEZOID_ITERATION_MAX	 			Max iterations for convergence in the HT asymmetric case.
- * TRAPEZOID_ITERATION_ERROR_PERCENT	Error percentage for iteration convergence. As percent - 0.01 = 1%
- * TRAPEZOID_LENGTH_FIT_TOLERANCE		Tolerance for "exact fit" for H and T cases
- * TRAPEZOID_VELOCITY_TOLERANCE			Adaptive velocity tolerance term
- */
-#define TRAPEZOID_ITERATION_MAX 10
-#define TRAPEZOID_ITERATION_ERROR_PERCENT 0.10
-#define TRAPEZOID_LENGTH_FIT_TOLERANCE (0.0001)	// allowable mm of error in planning phase
-#define TRAPEZOID_VELOCITY_TOLERANCE (max(2,bf->entry_velocity/100))
-
-/*
- *	Macros and typedefs
- */
-
-//#define MP_LINE(t,m,o,n) ((cfg.enable_acceleration == TRUE) ? mp_aline(t,m,o,n) : mp_line(t,m))
-#define MP_LINE(t,m,o,n) (mp_aline(t,m,o,n))	// non-planned lines are disabled
-
+/*
+ * planner.h - cartesian trajectory planning and motion execution
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef planner_h
+#define planner_h 
+
+enum moveType {				// bf->move_type values 
+	MOVE_TYPE_NULL = 0,		// null move - does a no-op
+	MOVE_TYPE_ALINE,		// acceleration planned line
+	MOVE_TYPE_ARC,			// acceleration planned arc (circular interpolation at exec)
+	MOVE_TYPE_DWELL,		// delay with no movement
+	MOVE_TYPE_COMMAND,		// general command
+	MOVE_TYPE_TOOL,			// T command
+	MOVE_TYPE_SPINDLE_SPEED,// S command
+	MOVE_TYPE_STOP,			// program stop
+	MOVE_TYPE_END			// program end
+};
+
+enum moveState {
+	MOVE_STATE_OFF = 0,		// move inactive (MUST BE ZERO)
+	MOVE_STATE_NEW,			// general value if you need an initialization
+	MOVE_STATE_RUN,			// general run state (for non-acceleration moves) 
+	MOVE_STATE_RUN2,		// used for sub-states
+	MOVE_STATE_HEAD,		// aline() acceleration portions
+	MOVE_STATE_BODY,		// aline() cruise portions
+	MOVE_STATE_TAIL,		// aline() deceleration portions
+	MOVE_STATE_SKIP,		// mark a skipped block
+	MOVE_STATE_END			// move is marked as done (used by dwells)
+};
+#define MOVE_STATE_RUN1 MOVE_STATE_RUN // a convenience
+
+/*** Most of these factors are the result of a lot of tweaking. Change with caution.***/
+
+/* The following must apply:
+ *	  MM_PER_ARC_SEGMENT >= MIN_LINE_LENGTH >= MIN_SEGMENT_LENGTH 
+ */
+#define ARC_SEGMENT_LENGTH 		((float)0.1)		// Arc segment size (mm).(0.03)
+#define MIN_LINE_LENGTH 		((float)0.08)		// Smallest line the system can plan (mm) (0.02)
+#define COALESCE_COS_TOLERANCE	((float)0.9998)		// collinearity limit for coalescing micro-moves (~1 degree)
+
+#define FEED_OVERRIDE_MIN_FACTOR ((float)0.05)		// lowest feed rate override (5%)
+#define FEED_OVERRIDE_MAX_FACTOR ((float)2.00)		// highest feed rate override (200%)
+#define FEED_OVERRIDE_RAMP		 ((float)0.10)		// max velocity change applied to the running move per override event
+#define MIN_SEGMENT_LENGTH 		((float)0.05)		// Smallest accel/decel segment (mm). Set to produce ~10 ms segments (0.01)
+#define MIN_LENGTH_MOVE 		((float)0.001)		// millimeters
+
+#define JERK_MATCH_PRECISION 1000	// default for $jmp - precision to which jerk must match to be considered effectively the same
+
+/* Junction velocity cache
+ *	Raster and grid-style jobs repeat the same handful of junction geometries
+ *	thousands of times. Computed junction vmax values are kept in a small
+ *	direct-mapped cache keyed on the quantized unit vector pair so repeated
+ *	geometry skips the delta fusion and sqrt math (see _get_junction_vmax()).
+ *	The cache holds final velocities so it must be flushed when the junction
+ *	deviation or junction acceleration settings change (see config.c setters).
+ */
+#define JUNCTION_CACHE_SIZE 8		// direct-mapped cache entries - must be a power of 2
+#define JUNCTION_CACHE_QUANTA 127	// unit vector components are quantized to 1/127ths
+
+/* Junction velocity models ($jmo)
+ *	DEVIATION is Chamnit's cosine / junction-deviation algorithm and remains
+ *	the default. CENTRIPETAL computes the effective corner radius directly
+ *	from the direction-change vector (b_unit - a_unit), which avoids the
+ *	half-angle trig chain and linearizes the radius for shallow crossings so
+ *	contour-parallel passes are not slowed by corners they can take at speed.
+ *	See _get_junction_vmax() in plan_line.c.
+ */
+#define JUNCTION_MODEL_DEVIATION 0
+#define JUNCTION_MODEL_CENTRIPETAL 1
+
+/* Input shaper ($zvf / $zvz)
+ *	Optional ZV (two-impulse) input shaping stage between segment execution
+ *	and the kinematics. Segment targets are convolved with the shaper kernel
+ *	using a small delay line of recent targets, which cancels excitation of
+ *	the machine resonance at the shaper frequency so jerk and acceleration
+ *	can be raised on resonant gantries. The ring must span the impulse delay
+ *	(half the damped resonance period) at the minimum segment cadence, which
+ *	sets the lowest shapeable frequency. See _exec_aline_segment() and
+ *	mp_config_input_shaper() in plan_line.c.
+ */
+#define SHAPER_RING_SIZE 16			// delay line depth - must be a power of 2
+#define SHAPER_FREQUENCY_MIN ((float)13)	// Hz - keeps the delay inside the ring at min segment time
+#define SHAPER_FREQUENCY_MAX ((float)250)	// Hz - above this the delay is under one segment anyway
+
+/* Target length cache
+ *	Backplanning calls _get_target_length() for every buffer in the replan
+ *	chain, and repetitive toolpaths present the same (Vi, Vt, jerk) triple
+ *	over and over. Solutions are memoized in a small direct-mapped cache in
+ *	the same manner as the junction velocity cache above. Entries are keyed
+ *	on the exact velocity pair and the block's reciprocal jerk, so a jerk
+ *	settings change simply stops matching - no explicit flush is needed.
+ */
+#define TARGET_LENGTH_CACHE_SIZE 8	// direct-mapped cache entries - must be a power of 2
+
+/* ESTD_SEGMENT_USEC	 Microseconds per planning segment
+ *	Should be experimentally adjusted if the MIN_SEGMENT_LENGTH is changed
+ */
+#define NOM_SEGMENT_USEC 		((float)5000)		// nominal segment time
+#define MIN_SEGMENT_USEC 		((float)2500)		// minimum segment time
+#define MIN_ARC_SEGMENT_USEC	((float)10000)		// minimum arc segment time
+#define BODY_SEGMENT_USEC		((float)50000)		// max cruise segment time (see _exec_aline_body)
+#define BODY_SEGMENT_MAX_SUBSTEPS ((float)1000000000) // int32 headroom for one motor's segment substeps
+
+/* Adaptive segment time (see mp_tune_segment_usec in plan_line.c)
+ * Active in __ISR_PROFILE builds only - others run the configured nominal
+ */
+#define SEGMENT_TUNE_HI			((float)0.5)		// back off when worst exec pass exceeds this fraction
+#define SEGMENT_TUNE_LO			((float)0.2)		// creep down when worst exec pass is below this fraction
+#define SEGMENT_TUNE_GROW		((float)1.5)		// backoff multiplier (fast escape from the deadline)
+#define SEGMENT_TUNE_SHRINK		((float)0.95)		// creep multiplier (slow approach to smoothness)
+#define SEGMENT_TUNE_MAX_USEC	((float)10000)		// adaptive ceiling; MIN_SEGMENT_USEC is the floor
+
+//derived from above
+#define NOM_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
+#define MIN_SEGMENT_TIME 		(MIN_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
+#define MIN_ARC_SEGMENT_TIME 	(MIN_ARC_SEGMENT_USEC / MICROSECONDS_PER_MINUTE)
+#define MIN_TIME_MOVE  			MIN_SEGMENT_USEC	// minimum time a move can be is one segment
+
+/* PLANNER_STARTUP_FILL_MS / PLANNER_STARTUP_HOLD_TICKS
+ *	Starting an idle machine on the first block means it always plans down
+ *	to zero - the move executes before the next block arrives from the
+ *	serial port, and the machine stutters once on startup. Instead of the
+ *	old fixed startup dwell, the exec stage holds the first move until the
+ *	queue carries PLANNER_STARTUP_FILL_MS of planned time, or a queued sync
+ *	command (M2 etc) or end-of-stream releases it early, or the hold ages
+ *	out after PLANNER_STARTUP_HOLD_TICKS (slow hosts). See mp_exec_move().
+ */
+#define PLANNER_STARTUP_FILL_MS		((float)50)	// planned queue time that starts motion
+#define PLANNER_STARTUP_HOLD_TICKS	5			// max hold in 10ms RTC ticks
+
+/* PLANNER_BUFFER_POOL_SIZE
+ *	Should be at least the number of buffers requires to support optimal 
+ *	planning in the case of very short lines or arc segments. 
+ *	Suggest 12 min. Limit is 255
+ */
+#ifdef __JSON_ONLY
+#define PLANNER_BUFFER_POOL_SIZE 64			// headless builds spend reclaimed RAM on queue depth
+#else
+#define PLANNER_BUFFER_POOL_SIZE 48
+#endif
+#define PLANNER_BUFFER_HEADROOM 8			// buffers to reserve in planner before processing new input line
+											// also caps the blocks a '|' separated line may carry (see gcode_parser.c)
+
+/* PLANNER_OFFSET_POOL_SIZE
+ *	Work offsets are carried for reporting only and rarely change between
+ *	blocks, so they are interned: each distinct offset set is stored once in
+ *	mb.offset[] and buffers carry a one byte index. This takes 23 bytes out
+ *	of every mpBuf_t, which is what affords the deeper buffer pool above.
+ *	The pool is refcounted; if a job changes offsets so often that all sets
+ *	are live at once (pathological - needs a G10/G92 between most blocks)
+ *	the current set is overwritten in place, which can garble position
+ *	*reports* for queued moves but never affects motion.
+ */
+#define PLANNER_OFFSET_POOL_SIZE 8
+
+/* PLANNER_ARC_POOL_SIZE
+ *	Native arc moves (MOVE_TYPE_ARC) occupy one planner buffer each; the
+ *	circular geometry is kept in this side pool and referenced by a one byte
+ *	index so mpBuf_t stays small. Slots are refcounted - a feedhold can split
+ *	an arc into two buffers sharing one geometry. ar_arc_callback() waits for
+ *	a free slot before queueing an arc, so the pool size bounds how many arcs
+ *	can be in the queue at once, i.e. lookahead depth across consecutive
+ *	G2/G3 blocks.
+ */
+#define PLANNER_ARC_POOL_SIZE 4
+
+/* Some parameters for _generate_trapezoid()
+ * TRAPEZOID_LENGTH_FIT_TOLERANCE		Tolerance for "exact fit" for H and T cases ($tlf)
+ * TRAPEZOID_VELOCITY_TOLERANCE			Velocity tolerance floor ($tvt); the adaptive
+ *										term is entry_velocity/100 (see plan_line.c)
+ *
+ *	These ship as the defaults for runtime settings so tuning doesn't cost
+ *	a flash-and-reboot cycle - see the hidden planner group in config.c.
+ */
+#define TRAPEZOID_LENGTH_FIT_TOLERANCE ((float)0.0001)	// allowable mm of error in planning phase
+#define TRAPEZOID_VELOCITY_TOLERANCE ((float)2)			// velocity tolerance floor in mm/min
+
+/*
+ *	Macros and typedefs
+ */
+
+//#define MP_LINE(t,m,o,n) ((cfg.enable_acceleration == TRUE) ? mp_aline(t,m,o,n) : mp_line(t,m))
+#define MP_LINE(t,m,o,n) (mp_aline(t,m,o,n))	// non-planned lines are disabled
+
 typedef void (*cm_exec)(uint8_t, float);	// callback to canonical_machine execution function
-
-/*
- *	Planner structures
- */
-
+
+/*
+ *	Planner structures
+ */
+
 // All the enums that equal zero must be zero. Don't change this
 
 enum mpBufferState {			// bf->buffer_state values 
@@ -127,24 +222,45 @@ enum mpBufferState {			// bf->buffer_state values
 	MP_BUFFER_RUNNING			// current running buffer
 };
 
+enum cvCurveType {				// what a geometry slot describes
+	CURVE_TYPE_ARC = 0,			// circular arc or helix (G2/G3)
+	CURVE_TYPE_SPLINE			// planar cubic spline (G5)
+};
+
+typedef struct mpArcGeometry {	// curved geometry for native arc and spline moves (see PLANNER_ARC_POOL_SIZE)
+	uint8_t curve_type;			// see cvCurveType
+	float center_1;				// arc center in the first plane axis
+	float center_2;				// arc center in the second plane axis
+	float theta_per_mm;			// signed arc angle per mm of path
+	float radius;				// radius of the circle in mm (splines: tightest curvature radius)
+	uint8_t axis_1;				// curve plane axis
+	uint8_t axis_2;				// curve plane axis
+	float poly_1[4];			// spline polynomial in axis_1: p + t*(c + t*(b + t*a)) as [p,c,b,a]
+	float poly_2[4];			// spline polynomial in axis_2
+	float t_resume;				// spline parameter to restart at - 0 for a fresh spline,
+								// written back at feedhold completion (see _exec_aline)
+} mpArcGeom_t;
+
 typedef struct mpBuffer {		// See Planning Velocity Notes for variable usage
 	struct mpBuffer *pv;		// static pointer to previous buffer
 	struct mpBuffer *nx;		// static pointer to next buffer
-	stat_t (*bf_func)(struct mpBuffer *bf); // callback to buffer exec function - passes *bf, returns stat_t
-	cm_exec cm_func;			// callback to canonical machine execution function
-	uint32_t linenum;			// runtime line number; or line index if not numbered
+	stat_t (*bf_func)(struct mpBuffer *bf); // callback to buffer exec function - passes *bf, returns stat_t
+	cm_exec cm_func;			// callback to canonical machine execution function
+	uint32_t linenum;			// runtime line number; or line index if not numbered
 	uint8_t motion_mode;		// runtime motion mode for status reporting
+	uint8_t offset_index;		// work offset set in mb.offset[] (for reporting only)
+	uint8_t arc_index;			// arc geometry slot in mb.arc[] (MOVE_TYPE_ARC only)
 	uint8_t buffer_state;		// used to manage queueing/dequeueing
 	uint8_t move_type;			// used to dispatch to run routine
-	uint8_t move_code;			// byte that can be used by used exec functions
+	uint8_t move_code;			// byte that can be used by used exec functions
 	uint8_t move_state;			// move state machine sequence
 	uint8_t replannable;		// TRUE if move can be replanned
+	uint8_t sync_output;		// output command riding on this move (see stepper.h)
 
 	float target[AXES];			// target position in floating point
 	float unit[AXES];			// unit vector for axis scaling & planning
-	float work_offset[AXES];	// offset from the work coordinate system (for reporting only)
 
-	float time;					// line, helix or dwell time in minutes
+	float time;					// line, helix or dwell time in minutes
 	float min_time;				// minimum time for the move - for rate override replanning
 	float head_length;
 	float body_length;
@@ -159,50 +275,77 @@ typedef struct mpBuffer {		// See Planning Velocity Notes for variable usage
 	float cruise_vmax;			// max cruise velocity requested for move
 	float exit_vmax;			// max exit velocity possible (redundant)
 	float delta_vmax;			// max velocity difference for this move
+	float junction_vmax;		// junction velocity limit (saved for feed override rescaling)
 	float braking_velocity;		// current value for braking velocity
-
+
 	float jerk;					// maximum linear jerk term for this move
 	float recip_jerk;			// 1/Jm used for planning (compute-once)
-	float cbrt_jerk;			// cube root of Jm used for planning (compute-once)
+	float cbrt_jerk;			// cube root of Jm used for planning (compute-once)
 } mpBuf_t;
 
 typedef struct mpBufferPool {	// ring buffer for sub-moves
-	uint16_t magic_start;		// magic number to test memory integity	
+	uint16_t magic_start;		// magic number to test memory integity	
 	uint8_t buffers_available;	// running count of available buffers
 	mpBuf_t *w;					// get_write_buffer pointer
 	mpBuf_t *q;					// queue_write_buffer pointer
 	mpBuf_t *r;					// get/end_run_buffer pointer
+	float offset[PLANNER_OFFSET_POOL_SIZE][AXES]; // interned work offset sets
+	uint8_t offset_refs[PLANNER_OFFSET_POOL_SIZE];// buffers referencing each offset set
+	uint8_t offset_current;		// offset set written most recently
+	mpArcGeom_t arc[PLANNER_ARC_POOL_SIZE];	// geometry for queued native arc moves
+	uint8_t arc_refs[PLANNER_ARC_POOL_SIZE];// buffers referencing each arc geometry
 	mpBuf_t bf[PLANNER_BUFFER_POOL_SIZE];// buffer storage
-	uint16_t magic_end;
+	uint16_t magic_end;
 } mpBufferPool_t;
 
+typedef struct mpJunctionCacheEntry {	// see "Junction velocity cache" notes above
+	int8_t key[2*AXES];			// quantized a_unit : b_unit pair
+	float vmax;					// junction velocity computed for this pair
+	uint8_t valid;
+} mpJunctionCacheEntry_t;
+
+typedef struct mpLengthCacheEntry {	// see "Target length cache" notes above
+	float vlo;					// velocity pair key, ordered vlo <= vhi
+	float vhi;					//  (the length equation is symmetric in Vi/Vt)
+	float recip_jerk;			// jerk key - also covers per-block jerk differences
+	float length;				// length computed for this triple
+	uint8_t valid;
+} mpLengthCacheEntry_t;
+
 typedef struct mpMoveMasterSingleton {	// common variables for planning (move master)
 	float position[AXES];		// final move position for planning purposes
-	float ms_in_queue;			// total ms of movement & dwell in planner queue
+	float ms_in_queue;			// total ms of movement & dwell in planner queue
+	float ms_executed;			// ms of the current job completed (job progress - see config.c)
+	float job_time_total;		// planned job time in seconds - set by $jt or a $dry estimate
 	float prev_jerk;			// jerk values cached from previous move
 	float prev_recip_jerk;
 	float prev_cbrt_jerk;
+	float override_factor;		// feed rate override factor currently baked into the queue
+	uint8_t sync_output;		// pending M62/M63 output - latched into the next queued move
+	mpJunctionCacheEntry_t junction_cache[JUNCTION_CACHE_SIZE];
+	mpLengthCacheEntry_t length_cache[TARGET_LENGTH_CACHE_SIZE];
 #ifdef __UNIT_TEST_PLANNER
 	float test_case;
 	float test_velocity;
 	float a_unit[AXES];
 	float b_unit[AXES];
 #endif
-} mpMoveMasterSingleton_t;
-
+} mpMoveMasterSingleton_t;
+
 typedef struct mpMoveRuntimeSingleton {	// persistent runtime variables
 //	uint8_t (*run_move)(struct mpMoveRuntimeSingleton *m); // currently running move - left in for reference
-	uint16_t magic_start;		// magic number to test memory integity	
-	uint32_t linenum;			// runtime line/block number of BF being executed
+	uint16_t magic_start;		// magic number to test memory integity	
+	uint32_t linenum;			// runtime line/block number of BF being executed
 	uint8_t motion_mode;		// runtime motion mode for status reports
 	uint8_t move_state;			// state of the overall move
 	uint8_t section_state;		// state within a move section
+	uint8_t sync_output;		// output command to attach to the first segment prepped
 
 	float endpoint[AXES];		// final target for bf (used to correct rounding errors)
 	float position[AXES];		// current move position
 	float target[AXES];			// target move position
 	float unit[AXES];			// unit vector for axis scaling & planning
-	float work_offset[AXES];	// offset from the work coordinate system (for reporting only)
+	float work_offset[AXES];	// offset from the work coordinate system (for reporting only)
 
 	float head_length;			// copies of bf variables of same name
 	float body_length;
@@ -224,41 +367,109 @@ typedef struct mpMoveRuntimeSingleton {	// persistent runtime variables
 	float segment_velocity;		// computed velocity for aline segment
 	float forward_diff_1;      // forward difference level 1 (Acceleration)
 	float forward_diff_2;      // forward difference level 2 (Jerk - constant)
-	uint16_t magic_end;
+
+	int32_t q_unit[AXES];		// unit vector in Q16.16 (linear moves - see q16.c)
+	int32_t q_position[AXES];	// runtime position in Q16.16 mm (linear moves)
+	int32_t q_travel;			// distance the current segment advances (Q16.16 mm)
+	int32_t q_travel_diff_1;	// Q16.16 forward differences of segment distance -
+	int32_t q_travel_diff_2;	//  mirror forward_diff_1/2 scaled by segment time
+
+	uint8_t move_is_arc;		// true while running a MOVE_TYPE_ARC buffer (arc or spline)
+	uint8_t move_is_spline;		// true if the running curve is a cubic spline
+	uint8_t arc_index;			// geometry slot of the running curve (for t_resume writeback)
+	uint8_t arc_axis_1;			// curve plane axes copied from the geometry slot
+	uint8_t arc_axis_2;
+	float arc_center_1;			// arc center in the plane axes
+	float arc_center_2;
+	float arc_radius_1;			// radius vector from center to current position
+	float arc_radius_2;
+	float arc_theta_per_mm;		// signed arc angle per mm of path
+	float arc_length_run;		// curve mm already executed (for mid-curve hold planning)
+	float sp_poly_1[4];			// spline polynomials copied from the geometry slot
+	float sp_poly_2[4];
+	float sp_t;					// spline parameter at the current position (0..1)
+	uint16_t magic_end;
 } mpMoveRuntimeSingleton_t;
-
 
-// Allocate global scope structs
+typedef struct mpJobStats {		// job statistics accounting (see notes in planner.c)
+	uint8_t report_requested;	// program end seen - report on the next controller pass
+	uint32_t blocks;			// motion blocks queued through the mp_aline() family
+	uint32_t segments;			// segments run through _exec_aline_segment()
+	float distance[AXES];		// total travel per axis in mm (or degrees)
+	float cutting_time;			// seconds spent in feeds (G1/G2/G3 and cycles)
+	float rapid_time;			// seconds spent in traverses (G0)
+	float velocity_max;			// highest segment velocity sustained, in mm/min
+} mpJobStats_t;
+
+// Allocate global scope structs
 mpBufferPool_t mb;				// move buffer queue
 mpMoveMasterSingleton_t mm;		// context for line planning
-mpMoveRuntimeSingleton_t mr;	// context for line runtime
-
-/*
- * Global Scope Functions
- */
-
-void mp_init(void);
+mpMoveRuntimeSingleton_t mr;	// context for line runtime
+mpJobStats_t jst;				// job statistics accumulators
+
+/*
+ * Global Scope Functions
+ */
+
+void mp_init(void);
 void mp_init_buffers(void);
-
-void mp_flush_planner(void);
-float *mp_get_plan_position(float position[]);
-void mp_set_plan_position(const float position[]);
-void mp_set_axes_position(const float position[]);
-void mp_set_axis_position(uint8_t axis, const float position);
-
-stat_t mp_exec_move(void);
+
+void mp_flush_planner(void);
+float *mp_get_plan_position(float position[]);
+void mp_set_plan_position(const float position[]);
+void mp_set_axes_position(const float position[]);
+void mp_set_axis_position(uint8_t axis, const float position);
+
+stat_t mp_exec_move(void);
 void mp_queue_command(void(*cm_exec)(uint8_t, float), uint8_t int_val, float float_val);
-stat_t mp_dwell(const float seconds);
-void mp_end_dwell(void);
-stat_t mp_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
-stat_t mp_plan_hold_callback(void);
-stat_t mp_end_hold(void);
-stat_t mp_feed_rate_override(uint8_t flag, float parameter);
-
-// planner buffer handlers
-uint8_t mp_get_planner_buffers_available(void);
+stat_t mp_dwell(const float seconds);
+stat_t mp_spindle_dwell(const float seconds);	// releases early at measured spindle speed
+void mp_end_dwell(void);
+stat_t mp_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
+void mp_update_soft_limits(void);
+void mp_release_startup_hold(void);
+void mp_tune_segment_usec(float exec_usec);
+float mp_get_segment_usec(void);
+void mp_reset_segment_usec(void);
+stat_t mp_arc(const float target[], const float minutes, const float work_offset[],
+			  const float min_time, const float length,
+			  const float entry_unit[], const float exit_unit[],
+			  const float center_1, const float center_2, const float theta_per_mm,
+			  const float radius, const uint8_t axis_1, const uint8_t axis_2);
+stat_t mp_spline(const float target[], const float minutes, const float work_offset[],
+				 const float min_time, const float length,
+				 const float entry_unit[], const float exit_unit[],
+				 const float poly_1[], const float poly_2[],
+				 const float radius_min, const uint8_t axis_1, const uint8_t axis_2);
+stat_t mp_coalescing_aline(const float target[], const float minutes, const float work_offset[], const float min_time);
+stat_t mp_flush_coalesced_line(void);
+void mp_sync_output(uint8_t output_num, uint8_t on);
+void mp_discard_coalesced_line(void);
+stat_t mp_plan_hold_callback(void);
+stat_t mp_end_hold(void);
+stat_t mp_feed_rate_override(uint8_t flag, float parameter);
+
+// job progress accounting (see notes at mp_set_job_time_total)
+void mp_set_job_time_total(const float seconds);
+void mp_reset_job_clock(void);
+float mp_get_job_percent_complete(void);
+float mp_get_job_time_remaining(void);
+
+// job statistics accounting (see notes at mp_request_job_stats_report)
+void mp_reset_job_stats(void);
+void mp_request_job_stats_report(void);
+stat_t mp_job_stats_callback(void);
+
+// planner buffer handlers
+uint8_t mp_get_planner_buffers_available(void);
+uint8_t mp_get_arc_slots_available(void);
 void mp_clear_buffer(mpBuf_t *bf); 
 void mp_copy_buffer(mpBuf_t *bf, const mpBuf_t *bp);
+mpBuf_t * mp_splice_run_buffer(mpBuf_t *bp);
+uint8_t mp_intern_work_offset(const float offset[]);
+void mp_flush_junction_cache(void);
+void mp_config_input_shaper(void);
+stat_t mp_exec_shaper_drain(void);
 void mp_queue_write_buffer(const uint8_t move_type);
 void mp_free_run_buffer(void);
 mpBuf_t * mp_get_write_buffer(void); 
@@ -267,35 +478,37 @@ mpBuf_t * mp_get_first_buffer(void);
 mpBuf_t * mp_get_last_buffer(void);
 #define mp_get_prev_buffer(b) ((mpBuf_t *)(b->pv))
 #define mp_get_next_buffer(b) ((mpBuf_t *)(b->nx))
-
-// plan_line.c functions
-uint8_t mp_isbusy(void);
-uint8_t mp_get_runtime_motion_mode(void);
-float mp_get_runtime_linenum(void);
-float mp_get_runtime_velocity(void);
-float mp_get_runtime_work_position(uint8_t axis);
-float mp_get_runtime_machine_position(uint8_t axis);
-float mp_get_runtime_work_offset(uint8_t axis);
-float mp_get_runtime_work_scaling(uint8_t axis);
-void mp_set_runtime_work_offset(float offset[]); 
-void mp_zero_segment_velocity(void);
-
-#ifdef __DEBUG
-void mp_dump_running_plan_buffer(void);
-void mp_dump_plan_buffer_by_index(uint8_t index);
-void mp_dump_runtime_state(void);
-#endif
-
-/*** Unit tests ***/
-
-//#define __UNIT_TEST_PLANNER	// uncomment to compile in planner unit tests
-#ifdef __UNIT_TEST_PLANNER
-void mp_unit_tests(void);
-void mp_plan_arc_unit_tests(void);
-#define	PLANNER_UNITS mp_unit_tests();
-#else
-#define	PLANNER_UNITS
-#endif // end __UNIT_TEST_PLANNER
-
-#endif
-
+
+// plan_line.c functions
+uint8_t mp_isbusy(void);
+void mp_publish_runtime_snapshot(void);
+uint8_t mp_get_runtime_motion_mode(void);
+uint32_t mp_get_runtime_linenum(void);
+float mp_get_runtime_velocity(void);
+float mp_get_runtime_work_position(uint8_t axis);
+float mp_get_runtime_machine_position(uint8_t axis);
+float mp_get_runtime_segment_position(uint8_t axis, float fraction);
+float mp_get_runtime_work_offset(uint8_t axis);
+float mp_get_runtime_work_scaling(uint8_t axis);
+void mp_set_runtime_work_offset(float offset[]); 
+void mp_zero_segment_velocity(void);
+
+#ifdef __DEBUG
+void mp_dump_running_plan_buffer(void);
+void mp_dump_plan_buffer_by_index(uint8_t index);
+void mp_dump_runtime_state(void);
+#endif
+
+/*** Unit tests ***/
+
+//#define __UNIT_TEST_PLANNER	// uncomment to compile in planner unit tests
+#ifdef __UNIT_TEST_PLANNER
+void mp_unit_tests(void);
+void mp_plan_arc_unit_tests(void);
+#define	PLANNER_UNITS mp_unit_tests();
+#else
+#define	PLANNER_UNITS
+#endif // end __UNIT_TEST_PLANNER
+
+#endif
+
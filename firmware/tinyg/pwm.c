@@ -1,219 +1,436 @@
-/*
- * pwm.c - pulse width modulation drivers
- * Part of TinyG project
- *
- * Copyright (c) 2012 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#include <stdlib.h>
-#include <string.h>				// needed for memset
-#include <avr/interrupt.h>
-#include <avr/io.h>
-
-#include "tinyg.h"
-#include "system.h"
-#include "pwm.h"
-#include "gpio.h"
-
-/***** PWM defines, structures and memory allocation *****
- *
- * Three are two PWM channels - 
- */
-
-// defines common to all PWM channels
-//#define PWM_TIMER_TYPE	TC1_struct	// PWM uses TC1's
-#define PWM_TIMER_t	TC1_t				// PWM uses TC1's
-#define PWM_TIMER_DISABLE 0				// turn timer off (clock = 0 Hz)
-#define PWM_MAX_FREQ (F_CPU/256)		// max frequency with 8-bits duty cycle precision
-#define PWM_MIN_FREQ (F_CPU/64/65536)	// min frequency with supported prescaling
-
-// channel specific defines
-/* CLKSEL is used to configure default PWM clock operating ranges
- * These can be changed by pwm_freq() depending on the PWM frequency selected
- *
- * The useful ranges (assuming a 32 Mhz system clock) are:
- *	 TC_CLKSEL_DIV1_gc  - good for about 500 Hz to 125 Khz practical upper limit
- *   TC_CLKSEL_DIV2_gc  - good for about 250 Hz to  62 KHz
- *	 TC_CLKSEL_DIV4_gc  - good for about 125 Hz to  31 KHz
- *	 TC_CLKSEL_DIV8_gc  - good for about  62 Hz to  16 KHz
- *	 TC_CLKSEL_DIV64_gc - good for about   8 Hz to   2 Khz
- */
-#define PWM1_CTRLA_CLKSEL	TC_CLKSEL_DIV1_gc	// starting clock select value
-#define PWM1_CTRLB 			(3 | TC0_CCBEN_bm)	// single slope PWM enabled on channel B
-#define PWM1_ISR_vect 		TCD1_CCB_vect		// must match timer assignments in system.h
-#define PWM1_INTCTRLB		0					// timer interrupt level (0=off, 1=lo, 2=med, 3=hi)
-
-#define PWM2_CTRLA_CLKSEL 	TC_CLKSEL_DIV1_gc
-#define PWM2_CTRLB 			3					// single slope PWM enabled, no output channel
-//#define PWM2_CTRLB 		(3 | TC0_CCBEN_bm)	// single slope PWM enabled on channel B
-#define PWM2_ISR_vect		TCE1_CCB_vect		// must match timer assignments in system.h
-#define PWM2_INTCTRLB		0					// timer interrupt level (0=off, 1=lo, 2=med, 3=hi)
-
-typedef struct pwmStruct { 			// one per PWM channel
-	uint8_t ctrla;					// byte needed to active CTRLA (it's dynamic - rest are static)
-	TC1_t *timer;					// assumes TC1 flavor timers used for PWM channels
-} pwmStruct_t;
-static pwmStruct_t pwm[PWMS];		// array of PWMs (usually 2, see system.h)
-
-/***** PWM code *****/
-/* 
- * pwm_init() - initialize pwm channels
- *
- *	Notes: 
- *	  - Whatever level interrupts you use must be enabled in main()
- *	  - init assumes PWM1 output bit (D5) has been set to output previously (stepper.c)
- *	  - See system.h for timer and port assignments
- *    - Don't do this: memset(&TIMER_PWM1, 0, sizeof(PWM_TIMER_t)); // zero out the timer registers
- */
-void pwm_init()
-{
-	gpio_set_bit_off(SPINDLE_PWM);
-
-	// setup PWM channel 1
-	memset(&pwm[PWM_1], 0, sizeof(pwmStruct_t));		// clear parent structure 
-	pwm[PWM_1].timer = &TIMER_PWM1;						// bind timer struct to PWM struct array
-	pwm[PWM_1].ctrla = PWM1_CTRLA_CLKSEL;				// initialize starting clock operating range
-	pwm[PWM_1].timer->CTRLB = PWM1_CTRLB;
-	pwm[PWM_1].timer->INTCTRLB = PWM1_INTCTRLB;			// set interrupt level	
-
-	// setup PWM channel 2
-	memset(&pwm[PWM_2], 0, sizeof(pwmStruct_t));		// clear all values, pointers and status
-	pwm[PWM_2].timer = &TIMER_PWM2;
-	pwm[PWM_2].ctrla = PWM2_CTRLA_CLKSEL;
-	pwm[PWM_2].timer->CTRLB = PWM2_CTRLB;
-	pwm[PWM_2].timer->INTCTRLB = PWM2_INTCTRLB;
-}
-
-/*
- * ISRs for PWM timers
- */
-
-ISR(PWM1_ISR_vect) 
-{
-	return;
-}
-
-ISR(PWM2_ISR_vect) 
-{
-	return;
-}
-
-/* 
- * pwm_set_freq() - set PWM channel frequency
- *
- *	channel	- PWM channel
- *	freq	- PWM frequency in Khz as a float
- *
- *	Assumes 32MHz clock.
- *	Doesn't turn time on until duty cycle is set
- */
-
-stat_t pwm_set_freq(uint8_t chan, float freq)
-{
-	if (chan > PWMS) { return (STAT_NO_SUCH_DEVICE);}
-	if (freq > PWM_MAX_FREQ) { return (STAT_INPUT_VALUE_TOO_LARGE);}
-	if (freq < PWM_MIN_FREQ) { return (STAT_INPUT_VALUE_TOO_SMALL);}
-
-	// set the period and the prescaler
-	float prescale = F_CPU/65536/freq;	// optimal non-integer prescaler value
-	if (prescale <= 1) { 
-		pwm[chan].timer->PER = F_CPU/freq;
-		pwm[chan].timer->CTRLA = TC_CLKSEL_DIV1_gc;
-	} else if (prescale <= 2) { 
-		pwm[chan].timer->PER = F_CPU/2/freq;
-		pwm[chan].timer->CTRLA = TC_CLKSEL_DIV2_gc;
-	} else if (prescale <= 4) { 
-		pwm[chan].timer->PER = F_CPU/4/freq;
-		pwm[chan].timer->CTRLA = TC_CLKSEL_DIV4_gc;
-	} else if (prescale <= 8) { 
-		pwm[chan].timer->PER = F_CPU/8/freq;
-		pwm[chan].timer->CTRLA = TC_CLKSEL_DIV8_gc;
-	} else { 
-		pwm[chan].timer->PER = F_CPU/64/freq;
-		pwm[chan].timer->CTRLA = TC_CLKSEL_DIV64_gc;
-	}
-	return (STAT_OK);
-}
-
-/* 
- * pwm_set_duty() - set PWM channel duty cycle 
- *
- *	channel	- PWM channel
- *	duty	- PWM duty cycle from 0% to 100%
- *
- *	Setting duty cycle to 0 disables the PWM channel with output low
- *	Setting duty cycle to 100 disables the PWM channel with output high
- *	Setting duty cycle between 0 and 100 enables PWM channel
- *
- *	The frequency must have been set previously
- */
-
-stat_t pwm_set_duty(uint8_t chan, float duty)
-{
-    if (duty < 0.0) { return (STAT_INPUT_VALUE_TOO_SMALL);}
-    if (duty > 1.0) { return (STAT_INPUT_VALUE_TOO_LARGE);}
-    
-	// Ffrq = Fper/(2N(CCA+1))
-	// Fpwm = Fper/((N(PER+1))
-	
-    float period_scalar = pwm[chan].timer->PER;
-	pwm[chan].timer->CCB = (uint16_t)(period_scalar * duty) + 1;
-	return (STAT_OK);
-}
-
-//###########################################################################
-//##### UNIT TESTS ##########################################################
-//###########################################################################
-
-#ifdef __UNIT_TESTS
-#ifdef __UNIT_TEST_PWM
-
-void pwm_unit_tests()
-{
-	pwm_init();
-
-	pwm_set_freq(PWM_1,500);
-	pwm_set_duty(PWM_1,100);
-	pwm_set_duty(PWM_1,75);
-	pwm_set_duty(PWM_1,51);
-	pwm_set_duty(PWM_1,10);
-	pwm_set_duty(PWM_1,0);
-
-	pwm_set_freq(PWM_1,5000);
-	pwm_set_duty(PWM_1,100);
-	pwm_set_duty(PWM_1,75);
-	pwm_set_duty(PWM_1,51);
-	pwm_set_duty(PWM_1,10);
-	pwm_set_duty(PWM_1,0);
-
-	pwm_set_freq(PWM_1,100);
-	pwm_set_duty(PWM_1,100);
-	pwm_set_duty(PWM_1,75);
-	pwm_set_duty(PWM_1,51);
-	pwm_set_duty(PWM_1,10);
-	pwm_set_duty(PWM_1,0);
-
-}
-
-#endif // __UNIT_TEST_PWM
-#endif
+/*
+ * pwm.c - pulse width modulation drivers
+ * Part of TinyG project
+ *
+ * Copyright (c) 2012 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>				// needed for memset
+#include <math.h>				// needed for sqrt (PPI mode)
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "tinyg.h"
+#include "util.h"				// for EPSILON
+#include "config.h"				// for motor steps and PPI settings
+#include "settings.h"
+#include "system.h"
+#include "pwm.h"
+#include "gpio.h"
+
+/***** PWM defines, structures and memory allocation *****
+ *
+ * Three are two PWM channels - 
+ */
+
+// defines common to all PWM channels
+//#define PWM_TIMER_TYPE	TC1_struct	// PWM uses TC1's
+#define PWM_TIMER_t	TC1_t				// PWM uses TC1's
+#define PWM_TIMER_DISABLE 0				// turn timer off (clock = 0 Hz)
+#define PWM_MAX_FREQ (F_CPU/256)		// max frequency with 8-bits duty cycle precision
+#define PWM_MIN_FREQ (F_CPU/64/65536)	// min frequency with supported prescaling
+
+// channel specific defines
+/* CLKSEL is used to configure default PWM clock operating ranges
+ * These can be changed by pwm_freq() depending on the PWM frequency selected
+ *
+ * The useful ranges (assuming a 32 Mhz system clock) are:
+ *	 TC_CLKSEL_DIV1_gc  - good for about 500 Hz to 125 Khz practical upper limit
+ *   TC_CLKSEL_DIV2_gc  - good for about 250 Hz to  62 KHz
+ *	 TC_CLKSEL_DIV4_gc  - good for about 125 Hz to  31 KHz
+ *	 TC_CLKSEL_DIV8_gc  - good for about  62 Hz to  16 KHz
+ *	 TC_CLKSEL_DIV64_gc - good for about   8 Hz to   2 Khz
+ */
+#define PWM1_CTRLA_CLKSEL	TC_CLKSEL_DIV1_gc	// starting clock select value
+#define PWM1_CTRLB 			(3 | TC0_CCBEN_bm)	// single slope PWM enabled on channel B
+#define PWM1_ISR_vect 		TCD1_CCB_vect		// must match timer assignments in system.h
+#define PWM1_INTCTRLB		0					// timer interrupt level (0=off, 1=lo, 2=med, 3=hi)
+
+#define PWM2_CTRLA_CLKSEL 	TC_CLKSEL_DIV1_gc
+#define PWM2_CTRLB 			3					// single slope PWM enabled, no output channel
+//#define PWM2_CTRLB 		(3 | TC0_CCBEN_bm)	// single slope PWM enabled on channel B
+#define PWM2_ISR_vect		TCE1_CCB_vect		// must match timer assignments in system.h
+#define PWM2_INTCTRLB		0					// timer interrupt level (0=off, 1=lo, 2=med, 3=hi)
+
+typedef struct pwmStruct { 			// one per PWM channel
+	uint8_t ctrla;					// byte needed to active CTRLA (it's dynamic - rest are static)
+	uint16_t period;				// cached PER value - the timer's PER lags buffered writes
+	TC1_t *timer;					// assumes TC1 flavor timers used for PWM channels
+} pwmStruct_t;
+static pwmStruct_t pwm[PWMS];		// array of PWMs (usually 2, see system.h)
+
+/***** PWM code *****/
+/* 
+ * pwm_init() - initialize pwm channels
+ *
+ *	Notes: 
+ *	  - Whatever level interrupts you use must be enabled in main()
+ *	  - init assumes PWM1 output bit (D5) has been set to output previously (stepper.c)
+ *	  - See system.h for timer and port assignments
+ *    - Don't do this: memset(&TIMER_PWM1, 0, sizeof(PWM_TIMER_t)); // zero out the timer registers
+ */
+void pwm_init()
+{
+	gpio_set_bit_off(SPINDLE_PWM);
+
+	// setup PWM channel 1
+	memset(&pwm[PWM_1], 0, sizeof(pwmStruct_t));		// clear parent structure 
+	pwm[PWM_1].timer = &TIMER_PWM1;						// bind timer struct to PWM struct array
+	pwm[PWM_1].ctrla = PWM1_CTRLA_CLKSEL;				// initialize starting clock operating range
+	pwm[PWM_1].timer->CTRLB = PWM1_CTRLB;
+	pwm[PWM_1].timer->INTCTRLB = PWM1_INTCTRLB;			// set interrupt level	
+
+	// setup PWM channel 2
+	memset(&pwm[PWM_2], 0, sizeof(pwmStruct_t));		// clear all values, pointers and status
+	pwm[PWM_2].timer = &TIMER_PWM2;
+	pwm[PWM_2].ctrla = PWM2_CTRLA_CLKSEL;
+	pwm[PWM_2].timer->CTRLB = PWM2_CTRLB;
+	pwm[PWM_2].timer->INTCTRLB = PWM2_INTCTRLB;
+}
+
+/*
+ * ISRs for PWM timers
+ */
+
+ISR(PWM1_ISR_vect) 
+{
+	return;
+}
+
+ISR(PWM2_ISR_vect) 
+{
+	return;
+}
+
+/* 
+ * pwm_set_freq() - set PWM channel frequency
+ *
+ *	channel	- PWM channel
+ *	freq	- PWM frequency in Khz as a float
+ *
+ *	Assumes 32MHz clock.
+ *	Doesn't turn time on until duty cycle is set
+ *
+ *	Frequency changes that stay within the current clock range are written
+ *	through the buffered period register (PERBUF) and latch cleanly at the
+ *	next period boundary. Changing ranges rewrites the prescaler, which is
+ *	not buffered and can distort one cycle - do it with the output off if
+ *	that matters.
+ */
+
+stat_t pwm_set_freq(uint8_t chan, float freq)
+{
+	if (chan > PWMS) { return (STAT_NO_SUCH_DEVICE);}
+	if (freq > PWM_MAX_FREQ) { return (STAT_INPUT_VALUE_TOO_LARGE);}
+	if (freq < PWM_MIN_FREQ) { return (STAT_INPUT_VALUE_TOO_SMALL);}
+
+	// set the period and the prescaler
+	float prescale = F_CPU/65536/freq;	// optimal non-integer prescaler value
+	uint16_t per;
+	uint8_t clksel;
+	if (prescale <= 1) {
+		per = F_CPU/freq;
+		clksel = TC_CLKSEL_DIV1_gc;
+	} else if (prescale <= 2) {
+		per = F_CPU/2/freq;
+		clksel = TC_CLKSEL_DIV2_gc;
+	} else if (prescale <= 4) {
+		per = F_CPU/4/freq;
+		clksel = TC_CLKSEL_DIV4_gc;
+	} else if (prescale <= 8) {
+		per = F_CPU/8/freq;
+		clksel = TC_CLKSEL_DIV8_gc;
+	} else {
+		per = F_CPU/64/freq;
+		clksel = TC_CLKSEL_DIV64_gc;
+	}
+	pwm[chan].period = per;
+	if (pwm[chan].timer->CTRLA == clksel) {
+		pwm[chan].timer->PERBUF = per;			// buffered - latches at the period boundary
+	} else {
+		pwm[chan].timer->PER = per;				// prescaler changes can't be buffered (see notes)
+		pwm[chan].timer->CTRLA = clksel;
+	}
+	return (STAT_OK);
+}
+
+/* 
+ * pwm_set_duty() - set PWM channel duty cycle 
+ *
+ *	channel	- PWM channel
+ *	duty	- PWM duty cycle from 0% to 100%
+ *
+ *	Setting duty cycle to 0 disables the PWM channel with output low
+ *	Setting duty cycle to 100 disables the PWM channel with output high
+ *	Setting duty cycle between 0 and 100 enables PWM channel
+ *
+ *	The frequency must have been set previously
+ *
+ *	Duty updates go through the buffered compare register (CCBBUF) and latch
+ *	at the period boundary, so a change never produces a runt or stretched
+ *	pulse mid-cycle. Raster streaming depends on this (see below) - power
+ *	can change every segment with clean output.
+ */
+
+stat_t pwm_set_duty(uint8_t chan, float duty)
+{
+    if (duty < 0.0) { return (STAT_INPUT_VALUE_TOO_SMALL);}
+    if (duty > 1.0) { return (STAT_INPUT_VALUE_TOO_LARGE);}
+
+	// Ffrq = Fper/(2N(CCA+1))
+	// Fpwm = Fper/((N(PER+1))
+
+    float period_scalar = pwm[chan].period;		// cached - timer's PER lags a buffered write
+	pwm[chan].timer->CCBBUF = (uint16_t)(period_scalar * duty) + 1;
+	return (STAT_OK);
+}
+
+/***** Raster mode *****
+ *
+ *	Raster mode streams laser power in lockstep with motion. Grayscale
+ *	intensity samples (0 - 255) are queued into a small ring by a feeder -
+ *	the binary input protocol (see binary_parser.c), which works the same
+ *	whether records arrive over the serial link or from a job on the flash
+ *	device - and the stepper loader consumes one sample at the start of
+ *	every aline segment (see _load_move), writing the PWM channel 1 buffered
+ *	compare register directly - the new power latches at the next PWM period
+ *	boundary with no runt pulse. Power changes land on every 2.5 - 5 ms
+ *	segment boundary with deterministic timing and no planner buffer or main
+ *	loop scheduling involved, versus ~100 changes/sec best case through the
+ *	queued command path.
+ *
+ *	If the ring runs dry the laser holds the last commanded power, so the
+ *	feeder should stay ahead using pwm_raster_space(). Entering and leaving
+ *	raster mode go through the queued command path so the mode change
+ *	synchronizes with motion (see cm_raster_mode in spindle.c). The feeder
+ *	resets the ring when a new region starts - while the mode is still off -
+ *	so samples can queue ahead of the region's first move and stale samples
+ *	from a previous region are discarded (see pwm_raster_reset).
+ *
+ *	Concurrency: the feeder (main loop) only writes head, the loader (HI
+ *	ISR) only writes tail, and both are single bytes - no locking needed.
+ */
+
+typedef struct pwmRaster {
+	uint8_t enabled;				// TRUE = loader consumes samples
+	volatile uint8_t head;			// next slot to write (feeder - main loop)
+	volatile uint8_t tail;			// next slot to read (loader - HI ISR)
+	uint8_t buf[PWM_RASTER_BUFFER_SIZE];	// intensity samples
+} pwmRaster_t;
+static pwmRaster_t raster;
+
+void pwm_raster_reset()				// discard any leftover samples
+{
+	raster.head = 0;				// called by the feeder when a new raster
+	raster.tail = 0;				//  region starts, before its samples queue.
+}									//  Do not call while the mode is enabled.
+
+void pwm_raster_enable()
+{
+	raster.enabled = true;
+}
+
+void pwm_raster_disable()
+{
+	raster.enabled = false;			// caller restores the PWM duty cycle
+}
+
+uint8_t pwm_raster_space()			// samples that can be queued right now
+{
+	return (PWM_RASTER_BUFFER_SIZE - 1 - (uint8_t)(raster.head - raster.tail));
+}
+
+void pwm_raster_queue(uint8_t intensity)
+{
+	raster.buf[raster.head & PWM_RASTER_BUFFER_MASK] = intensity;
+	raster.head++;					// indices free-run and are masked on access
+}
+
+/*
+ * pwm_raster_load_segment() - consume one sample into the PWM compare register
+ *
+ *	Called by the stepper loader (HI ISR) as it starts each aline segment.
+ *	Costs one test and returns when raster mode is off.
+ */
+
+void pwm_raster_load_segment()
+{
+	if (raster.enabled == false) { return;}
+	if (raster.head == raster.tail) { return;}	// ring is dry - hold last power
+	uint8_t intensity = raster.buf[raster.tail & PWM_RASTER_BUFFER_MASK];
+	raster.tail++;
+	PWM_TIMER_t *timer = pwm[PWM_1].timer;		// same compare math as pwm_set_duty
+	timer->CCBBUF = (uint16_t)(((uint32_t)pwm[PWM_1].period * intensity) >> 8) + 1;
+}
+
+/***** PPI mode *****
+ *
+ *	PPI (pulses-per-inch) mode fires fixed-energy laser pulses at a spacing
+ *	locked to actual XY motion, replacing host-side pulse scheduling whose
+ *	serial latency caps vector cutting speed. The pulse itself is pure
+ *	hardware: PWM channel 1 runs single-slope with the compare register set
+ *	to a fixed width ($p1pus), so pulse energy is constant and no CPU is
+ *	spent per pulse. The pulse PERIOD is what follows the motion: the prep
+ *	stage computes the path length of the designated motor pair (PPI_MOTOR_A
+ *	/ PPI_MOTOR_B, normally X and Y) for each stepper segment from the same
+ *	substep counts the DDA will execute, converts the configured density
+ *	($p1ppi, pulses per mm) into a timer period, and the stepper loader
+ *	latches it through the buffered period register at the segment boundary
+ *	(same clean-handoff property raster mode relies on). The staged period
+ *	rides in the segment's prep ring slot (see stPrepSingleton_t), so exec
+ *	running ahead of the loader cannot skew the pulse rate. Segments are
+ *	the velocity quanta of the whole motion system (2.5 - 5 ms), so spacing
+ *	tracks the executed path exactly as well as the steppers do.
+ *
+ *	Segments where the pair doesn't move stage a zero period, and the loader
+ *	starvation / dwell paths call pwm_ppi_idle(), both of which park the
+ *	duty at 0 - the beam never pulses while motion is stopped. If the
+ *	commanded spacing is shorter than the pulse width the pulses merge and
+ *	the beam goes continuous, which is the correct energy-density limit.
+ *
+ *	The mode engages with M3/M4 when $p1ppi is nonzero and releases the
+ *	channel on M5 (see _exec_spindle_control in spindle.c). Spindle speed
+ *	mapping does not apply while engaged - energy per pulse is the width.
+ *
+ *	Clocking: DIV64 gives 2 us ticks - width resolution 2 us, spacing range
+ *	up to ~131 ms per pulse before the rate floor clamps.
+ */
+
+#define PPI_CLKSEL		TC_CLKSEL_DIV64_gc	// 0.5 MHz pulse clock
+#define PPI_TICK_USEC	2					// microseconds per pulse clock tick
+
+typedef struct pwmPPI {
+	uint8_t enabled;				// TRUE = PPI mode owns PWM channel 1
+	uint16_t pulse_ticks;			// fixed pulse width in pulse clock ticks
+} pwmPPI_t;
+static pwmPPI_t ppi;
+
+void pwm_ppi_enable()
+{
+	uint16_t ticks = (uint16_t)(cfg.p.ppi_pulse_usec / PPI_TICK_USEC);
+	if (ticks == 0) { ticks = 1;}				// floor at one tick (2 us)
+	ppi.pulse_ticks = ticks;
+
+	PWM_TIMER_t *timer = pwm[PWM_1].timer;
+	timer->CCB = 0;								// park the output low
+	timer->CCBBUF = 0;
+	timer->PER = 0xFFFF;
+	timer->CTRLA = PPI_CLKSEL;
+	ppi.enabled = true;
+}
+
+void pwm_ppi_disable()
+{
+	ppi.enabled = false;
+	pwm_set_freq(PWM_1, cfg.p.frequency);		// caller restores the duty cycle
+}
+
+/*
+ * pwm_ppi_prep_segment() - compute the pulse period for a prepped segment
+ *
+ *	Called from st_prep_line_substeps() (exec context - float math is fine
+ *	here, unlike the loader). Substep counts arrive scaled by DDA_SUBSTEPS,
+ *	which substeps_per_unit already includes. Returns the period to carry
+ *	in the segment's prep ring slot - 0 means no pulses. Exec preps up to
+ *	PREP_BUFFERS-1 segments ahead of the loader, so the period must travel
+ *	with its segment rather than sit in a single staging variable.
+ */
+
+uint16_t pwm_ppi_prep_segment(int32_t steps_X_substeps[], uint32_t microseconds)
+{
+	if (ppi.enabled == false) { return (0);}
+	float da = (float)steps_X_substeps[PPI_MOTOR_A] / cfg.m[PPI_MOTOR_A].substeps_per_unit;
+	float db = (float)steps_X_substeps[PPI_MOTOR_B] / cfg.m[PPI_MOTOR_B].substeps_per_unit;
+	float pulses = sqrt(da*da + db*db) * cfg.p.ppi;	// pulses owed over this segment
+	if (pulses < EPSILON) { return (0);}			// pair is not moving - no pulses
+	float period = ((float)microseconds / PPI_TICK_USEC) / pulses;
+	if (period > 65535) { period = 65535;}			// rate floor - ~131 ms spacing
+	uint16_t per = (uint16_t)period;
+	if (per <= ppi.pulse_ticks) { per = ppi.pulse_ticks + 1;}	// pulses merge - beam goes CW
+	return (per);
+}
+
+/*
+ * pwm_ppi_load_segment() - latch a segment's pulse rate at the segment boundary
+ * pwm_ppi_idle() - park the pulse output while motion is stopped
+ *
+ *	Both called by the stepper loader (HI ISR). The period comes from the
+ *	prep ring slot being loaded. Writes go through the buffered registers
+ *	and latch at the period boundary - no runt pulses.
+ */
+
+void pwm_ppi_load_segment(uint16_t period)
+{
+	if (ppi.enabled == false) { return;}
+	PWM_TIMER_t *timer = pwm[PWM_1].timer;
+	if (period == 0) {
+		timer->CCBBUF = 0;					// hold the beam off this segment
+		return;
+	}
+	timer->PERBUF = period;
+	timer->CCBBUF = ppi.pulse_ticks;
+}
+
+void pwm_ppi_idle()
+{
+	if (ppi.enabled == false) { return;}
+	pwm[PWM_1].timer->CCBBUF = 0;
+}
+
+//###########################################################################
+//##### UNIT TESTS ##########################################################
+//###########################################################################
+
+#ifdef __UNIT_TESTS
+#ifdef __UNIT_TEST_PWM
+
+void pwm_unit_tests()
+{
+	pwm_init();
+
+	pwm_set_freq(PWM_1,500);
+	pwm_set_duty(PWM_1,100);
+	pwm_set_duty(PWM_1,75);
+	pwm_set_duty(PWM_1,51);
+	pwm_set_duty(PWM_1,10);
+	pwm_set_duty(PWM_1,0);
+
+	pwm_set_freq(PWM_1,5000);
+	pwm_set_duty(PWM_1,100);
+	pwm_set_duty(PWM_1,75);
+	pwm_set_duty(PWM_1,51);
+	pwm_set_duty(PWM_1,10);
+	pwm_set_duty(PWM_1,0);
+
+	pwm_set_freq(PWM_1,100);
+	pwm_set_duty(PWM_1,100);
+	pwm_set_duty(PWM_1,75);
+	pwm_set_duty(PWM_1,51);
+	pwm_set_duty(PWM_1,10);
+	pwm_set_duty(PWM_1,0);
+
+}
+
+#endif // __UNIT_TEST_PWM
+#endif
@@ -1,44 +1,60 @@
-/*
- * pwm.h - pulse width modulation drivers
- * Part of TinyG project
- *
- * Copyright (c) 2012 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#ifndef pwm_h
-#define pwm_h
-
-void pwm_init(void);
-stat_t pwm_set_freq(uint8_t channel, float freq);
-stat_t pwm_set_duty(uint8_t channel, float duty);
-
-
-//#define __UNIT_TEST_PWM		// uncomment to enable PWM unit tests
-#ifdef __UNIT_TEST_PWM
-void pwm_unit_tests(void);
-#define	PWM_UNITS pwm_unit_tests();
-#else
-#define	PWM_UNITS
-#endif
-
-#endif
+/*
+ * pwm.h - pulse width modulation drivers
+ * Part of TinyG project
+ *
+ * Copyright (c) 2012 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef pwm_h
+#define pwm_h
+
+#define PWM_RASTER_BUFFER_SIZE 128		// intensity sample ring - must be a power of 2
+#define PWM_RASTER_BUFFER_MASK (PWM_RASTER_BUFFER_SIZE-1)
+
+void pwm_init(void);
+stat_t pwm_set_freq(uint8_t channel, float freq);
+stat_t pwm_set_duty(uint8_t channel, float duty);
+
+void pwm_raster_reset(void);	// see raster mode notes in pwm.c
+void pwm_raster_enable(void);
+void pwm_raster_disable(void);
+uint8_t pwm_raster_space(void);
+void pwm_raster_queue(uint8_t intensity);
+void pwm_raster_load_segment(void);
+
+void pwm_ppi_enable(void);		// see PPI mode notes in pwm.c
+void pwm_ppi_disable(void);
+uint16_t pwm_ppi_prep_segment(int32_t steps_X_substeps[], uint32_t microseconds);
+void pwm_ppi_load_segment(uint16_t period);
+void pwm_ppi_idle(void);
+
+
+//#define __UNIT_TEST_PWM		// uncomment to enable PWM unit tests
+#ifdef __UNIT_TEST_PWM
+void pwm_unit_tests(void);
+#define	PWM_UNITS pwm_unit_tests();
+#else
+#define	PWM_UNITS
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * q16.c - Q16.16 fixed point math for the planner hot path
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Why fixed point
+ *
+ *	The xmega has no FPU so every float operation goes through avr-libc
+ *	software routines (~100+ cycles for a multiply). The segment generation
+ *	path runs once per ~5 ms segment from the LO interrupt and is multiply
+ *	dominated, so it sets the feed rate at which the planner can keep up.
+ *	Where the operand ranges are bounded the same math runs 2-3x faster in
+ *	Q16.16: a multiply is one 32x32 hardware-assisted integer multiply and
+ *	a shift, and adds are plain integer adds.
+ *
+ * Range analysis (one LSB = 1/65536 = ~1.5e-5, max value = +/-32767.99998)
+ *
+ *	  quantity               magnitude         fit
+ *	  ---------------------- ----------------- ---------------------------
+ *	  position, travel (mm)  < ~1000 mm        good - resolution 0.015 um,
+ *	                                           better than float above 512 mm
+ *	  unit vector            -1.0 .. 1.0       good
+ *	  segment travel (mm)    < ~10 mm          good (~20 significant bits)
+ *	  velocity (mm/min)      < ~32000          fits, but NOT converted -
+ *	                                           see planner notes below
+ *	  segment time (min)     ~5e-5             does NOT fit (2-3 bits) -
+ *	                                           never represent time in Q16.16
+ *	  substeps_per_unit      up to ~3e7        does NOT fit - handled as a
+ *	                                           plain int32 via q16_mul_int()
+ *
+ *	The planner consequently forward-differences the per-segment *distance*
+ *	(velocity x constant segment time, still a quadratic in the segment
+ *	index) rather than converting velocities and times separately - see
+ *	_init_forward_diffs() in plan_line.c.
+ *
+ *	Products use 64 bit intermediates so q16_mul() cannot overflow
+ *	internally; the caller is responsible for the result fitting Q16.16
+ *	(guaranteed by the ranges above). q16_div() and q16_sqrt() are here
+ *	for completeness of the module - the segment path itself is mul/add
+ *	only. q16_sqrt() is exact bit-by-bit (no iteration count to tune).
+ */
+
+#include <stdint.h>
+
+#include "tinyg.h"
+#include "q16.h"
+
+/*
+ * q16_from_float() - runtime float conversion (use the Q16() macro for constants)
+ */
+
+q16_t q16_from_float(float f)
+{
+	return ((q16_t)(f * 65536.0));
+}
+
+/*
+ * q16_mul() - Q16.16 x Q16.16 -> Q16.16
+ */
+
+q16_t q16_mul(q16_t a, q16_t b)
+{
+	return ((q16_t)(((int64_t)a * b) >> 16));
+}
+
+/*
+ * q16_mul_int() - Q16.16 x int32 -> int32 (for substeps_per_unit scale factors)
+ */
+
+int32_t q16_mul_int(q16_t a, int32_t b)
+{
+	return ((int32_t)(((int64_t)a * b) >> 16));
+}
+
+/*
+ * q16_div() - Q16.16 / Q16.16 -> Q16.16. Divide by zero returns saturated max.
+ */
+
+q16_t q16_div(q16_t num, q16_t denom)
+{
+	if (denom == 0) { return ((num < 0) ? INT32_MIN : INT32_MAX);}
+	return ((q16_t)(((int64_t)num << 16) / denom));
+}
+
+/*
+ * q16_sqrt() - Q16.16 square root (bit-by-bit method, exact to one LSB)
+ *
+ *	Shifts the radicand up 16 bits so the integer root comes out in Q16.16.
+ *	Negative inputs return zero.
+ */
+
+q16_t q16_sqrt(q16_t x)
+{
+	if (x <= 0) { return (0);}
+	uint64_t n = (uint64_t)x << 16;			// Q32.32 radicand
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 46;		// highest power of 4 <= any radicand
+
+	while (bit > n) { bit >>= 2;}
+	while (bit != 0) {
+		if (n >= root + bit) {
+			n -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return ((q16_t)root);
+}
@@ -0,0 +1,47 @@
+/*
+ * q16.h - Q16.16 fixed point math for the planner hot path
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef q16_h
+#define q16_h
+
+typedef int32_t q16_t;				// signed Q16.16 fixed point
+
+#define Q16_ONE ((q16_t)0x00010000)
+#define Q16(f) ((q16_t)((f) * 65536.0))					// for compile-time constants only
+#define q16_to_float(q) ((float)(q) * (1.0/65536.0))	// one int-to-float + one multiply
+
+#define Q16_GUARD 8				// guard bits for forward-difference accumulators (Q8.24) -
+								//  near-LSB difference terms must not quantize to zero
+#define q16_guarded(f) ((int32_t)((f) * (65536.0 * (1L << Q16_GUARD))))
+
+q16_t q16_from_float(float f);
+q16_t q16_mul(q16_t a, q16_t b);
+q16_t q16_div(q16_t num, q16_t denom);
+q16_t q16_sqrt(q16_t x);
+int32_t q16_mul_int(q16_t a, int32_t b);
+
+#endif
@@ -1,521 +1,1081 @@
-/*
- * report.c - TinyG status report and other reporting functions.
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S Hart, Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <math.h>
-#include <avr/pgmspace.h>
-
-#include "tinyg.h"
-#include "util.h"
-#include "config.h"
-#include "json_parser.h"
-#include "controller.h"
-#include "planner.h"
-#include "gcode_parser.h"
-#include "canonical_machine.h"
-#include "report.h"
-#include "settings.h"
-#include "xio/xio.h"
-#include "xmega/xmega_rtc.h"
-
-/**** Status and Exception Messages **************************************************
- * rpt_get_status_message() - return the status message
- * rpt_exception() - send an exception report (JSON formatted)
- *
- * These strings must align with the status codes in tinyg.h
- * The number of elements in the indexing array must match the # of strings
- * Reference for putting display strings and string arrays in program memory:
- * http://www.cs.mun.ca/~paul/cs4723/material/atmel/avr-libc-user-manual-1.6.5/pgmspace.html
- */
-static const char msg_sc00[] PROGMEM = "OK";
-static const char msg_sc01[] PROGMEM = "Error";
-static const char msg_sc02[] PROGMEM = "Eagain";
-static const char msg_sc03[] PROGMEM = "Noop";
-static const char msg_sc04[] PROGMEM = "Complete";
-static const char msg_sc05[] PROGMEM = "Terminated";
-static const char msg_sc06[] PROGMEM = "Hard reset";
-static const char msg_sc07[] PROGMEM = "End of line";
-static const char msg_sc08[] PROGMEM = "End of file";
-static const char msg_sc09[] PROGMEM = "File not open";
-static const char msg_sc10[] PROGMEM = "Max file size exceeded";
-static const char msg_sc11[] PROGMEM = "No such device";
-static const char msg_sc12[] PROGMEM = "Buffer empty";
-static const char msg_sc13[] PROGMEM = "Buffer full";
-static const char msg_sc14[] PROGMEM = "Buffer full - fatal";
-static const char msg_sc15[] PROGMEM = "Initializing";
-static const char msg_sc16[] PROGMEM = "Entering boot loader";
-static const char msg_sc17[] PROGMEM = "17";
-static const char msg_sc18[] PROGMEM = "18";
-static const char msg_sc19[] PROGMEM = "19";
-
-static const char msg_sc20[] PROGMEM = "Internal error";
-static const char msg_sc21[] PROGMEM = "Internal range error";
-static const char msg_sc22[] PROGMEM = "Floating point error";
-static const char msg_sc23[] PROGMEM = "Divide by zero";
-static const char msg_sc24[] PROGMEM = "Invalid Address";
-static const char msg_sc25[] PROGMEM = "Read-only address";
-static const char msg_sc26[] PROGMEM = "Initialization failure";
-static const char msg_sc27[] PROGMEM = "System alarmed";
-static const char msg_sc28[] PROGMEM = "Memory fault or corruption";
-static const char msg_sc29[] PROGMEM = "29";
-static const char msg_sc30[] PROGMEM = "30";
-static const char msg_sc31[] PROGMEM = "31";
-static const char msg_sc32[] PROGMEM = "32";
-static const char msg_sc33[] PROGMEM = "33";
-static const char msg_sc34[] PROGMEM = "34";
-static const char msg_sc35[] PROGMEM = "35";
-static const char msg_sc36[] PROGMEM = "36";
-static const char msg_sc37[] PROGMEM = "37";
-static const char msg_sc38[] PROGMEM = "38";
-static const char msg_sc39[] PROGMEM = "39";
-
-static const char msg_sc40[] PROGMEM = "Unrecognized command";
-static const char msg_sc41[] PROGMEM = "Expected command letter";
-static const char msg_sc42[] PROGMEM = "Bad number format";
-static const char msg_sc43[] PROGMEM = "Input exceeds max length";
-static const char msg_sc44[] PROGMEM = "Input value too small";
-static const char msg_sc45[] PROGMEM = "Input value too large";
-static const char msg_sc46[] PROGMEM = "Input value range error";
-static const char msg_sc47[] PROGMEM = "Input value unsupported";
-static const char msg_sc48[] PROGMEM = "JSON syntax error";
-static const char msg_sc49[] PROGMEM = "JSON input has too many pairs";
-static const char msg_sc50[] PROGMEM = "JSON output too long";
-static const char msg_sc51[] PROGMEM = "Out of buffer space";
-static const char msg_sc52[] PROGMEM = "Config not taken during machining cycle";
-static const char msg_sc53[] PROGMEM = "53";
-static const char msg_sc54[] PROGMEM = "54";
-static const char msg_sc55[] PROGMEM = "55";
-static const char msg_sc56[] PROGMEM = "56";
-static const char msg_sc57[] PROGMEM = "57";
-static const char msg_sc58[] PROGMEM = "58";
-static const char msg_sc59[] PROGMEM = "59";
-
-static const char msg_sc60[] PROGMEM = "Move less than minimum length";
-static const char msg_sc61[] PROGMEM = "Move less than minimum time";
-static const char msg_sc62[] PROGMEM = "Gcode block skipped";
-static const char msg_sc63[] PROGMEM = "Gcode input error";
-static const char msg_sc64[] PROGMEM = "Gcode feedrate error";
-static const char msg_sc65[] PROGMEM = "Gcode axis word missing";
-static const char msg_sc66[] PROGMEM = "Gcode modal group violation";
-static const char msg_sc67[] PROGMEM = "Homing cycle failed";
-static const char msg_sc68[] PROGMEM = "Max travel exceeded";
-static const char msg_sc69[] PROGMEM = "Max spindle speed exceeded";
-static const char msg_sc70[] PROGMEM = "Arc specification error";
-
-PGM_P const msgStatusMessage[] PROGMEM = {
-	msg_sc00, msg_sc01, msg_sc02, msg_sc03, msg_sc04, msg_sc05, msg_sc06, msg_sc07, msg_sc08, msg_sc09,
-	msg_sc10, msg_sc11, msg_sc12, msg_sc13, msg_sc14, msg_sc15, msg_sc16, msg_sc17, msg_sc18, msg_sc19,
-	msg_sc20, msg_sc21, msg_sc22, msg_sc23, msg_sc24, msg_sc25, msg_sc26, msg_sc27, msg_sc28, msg_sc29,
-	msg_sc30, msg_sc31, msg_sc32, msg_sc33, msg_sc34, msg_sc35, msg_sc36, msg_sc37, msg_sc38, msg_sc39,
-	msg_sc40, msg_sc41, msg_sc42, msg_sc43, msg_sc44, msg_sc45, msg_sc46, msg_sc47, msg_sc48, msg_sc49,
-	msg_sc50, msg_sc51, msg_sc52, msg_sc53, msg_sc54, msg_sc55, msg_sc56, msg_sc57, msg_sc58, msg_sc59,
-	msg_sc60, msg_sc61, msg_sc62, msg_sc63, msg_sc64, msg_sc65, msg_sc66, msg_sc67, msg_sc68, msg_sc69,
-	msg_sc70
-};
-
-char *rpt_get_status_message(uint8_t status, char *msg) 
-{
-	strncpy_P(msg,(PGM_P)pgm_read_word(&msgStatusMessage[status]), STATUS_MESSAGE_LEN);
-	return (msg);
-}
-
-void rpt_exception(uint8_t status, int16_t value)
-{
-	char msg[STATUS_MESSAGE_LEN];
-	printf_P(PSTR("{\"er\":{\"fb\":%0.2f,\"st\":%d,\"msg\":\"%s\",\"val\":%d}}\n"), 
-		TINYG_FIRMWARE_BUILD, status, rpt_get_status_message(status, msg), value);
-}
-
-/**** Application Messages *********************************************************
- * rpt_print_message() 				   - print a character string passed as argument
- * rpt_print_initializing_message()	   - initializing configs from hard-coded profile
- * rpt_print_loading_configs_message() - loading configs from EEPROM
- * rpt_print_system_ready_message()    - system ready message
- *
- *	These messages are always in JSON format to allow UIs to sync
- */
-/*
-void rpt_print_message(char *msg)
-{
-	cmd_add_string("msg", msg);
-	cmd_print_list(STAT_OK, TEXT_INLINE_VALUES, JSON_RESPONSE_FORMAT);
-}
-*/
-
-void _startup_helper(uint8_t status, const char *msg)
-{
-#ifndef __SUPPRESS_STARTUP_MESSAGES
-	cmd_reset_list();
-	cmd_add_object("fb");
-	cmd_add_object("fv");
-	cmd_add_object("hv");
-	cmd_add_object("id");
-	cmd_add_string_P("msg", msg);
-	js_print_json_response(status);
-#endif
-}
-
-void rpt_print_initializing_message(void)
-{
-	_startup_helper(STAT_INITIALIZING, PSTR(INIT_MESSAGE));
-}
-
-void rpt_print_loading_configs_message(void)
-{
-	_startup_helper(STAT_INITIALIZING, PSTR("Loading configs from EEPROM"));
-}
-
-void rpt_print_system_ready_message(void)
-{
-	_startup_helper(STAT_OK, PSTR("SYSTEM READY"));
-	if (cfg.comm_mode == TEXT_MODE) { tg_text_response(STAT_OK, "");}// prompt
-}
-
-/*****************************************************************************
- * Status Reports
- *
- *	Status report behaviors
- *
- *	Configuration:
- *
- *		Status reports are configurable only from JSON. SRs are configured
- *		by sending a status report SET object, e.g:
- *
- *		  {"sr":{"line":true,"posx":true,"posy":true....."motm":true,"stat":true}}
- *
- *	Status report formats: The following formats exist for status reports:
- *
- *	  -	JSON format: Returns a JSON object as above, but with the values filled in. 
- *		In JSON form all values are returned as numeric values or enumerations. 
- *		E.g. "posx" is returned as 124.523 and "unit" is returned as 0 for 
- *		inches (G20) and 1 for mm (G21).
- *
- *	  - CSV format: Returns a single line of comma separated token:value pairs.
- *		Values are returned as numeric values or English text.
- *		E.g. "posx" is still returned as 124.523 but "unit" is returned as 
- *		"inch" for inches (G20) and "mm" for mm (G21).
- *
- *	  - Multi-line format: Returns a multi-line report where each value occupies 
- *		one line. Each line contains explanatory English text. Enumerated values are
- *		returned as English text as per CSV form.
- *	
- *	Status report invocation: Status reports can be invoked in the following ways:
- *
- *	  - Ad-hoc request in JSON mode. Issue {"sr":""} (or equivalent). Returns a 
- *		JSON format report (wrapped in a response header, of course).
- *
- *	  - Automatic status reports in JSON mode. Returns JSON format reports 
- *		according to "si" setting.
- *
- *	  - Ad-hoc request in text mode. Triggered by sending ?<cr>. Returns status 
- *		report in multi-line format. Additionally, a line starting with ? will put 
- *		the system into text mode.
- *
- *	  - Automatic status reports in text mode return CSV format according to si setting
- *
- *	  - grbl compatibility forms are not yet supported.
- */
-
-/* 
- * rpt_init_status_report()
- *
- *	Call this function to completely re-initialze the status report
- *	Sets SR list to hard-coded defaults and re-initializes sr values in NVM
- */
-void rpt_init_status_report()
-{
-	cmdObj_t *cmd = cmd_reset_list();	// used for status report persistence locations
-	char sr_defaults[CMD_STATUS_REPORT_LEN][CMD_TOKEN_LEN+1] = { SR_DEFAULTS };	// see settings.h
-	cm.status_report_counter = (cfg.status_report_interval / RTC_MILLISECONDS);	// RTC fires every 10 ms
-
-	cmd->index = cmd_get_index("","se00");				// set first SR persistence index
-	for (uint8_t i=0; i < CMD_STATUS_REPORT_LEN ; i++) {
-		if (sr_defaults[i][0] == NUL) break;			// quit on first blank array entry
-		cfg.status_report_value[i] = -1234567;			// pre-load values with an unlikely number
-		cmd->value = cmd_get_index("", sr_defaults[i]);	// load the index for the SR element
-		cmd_set(cmd);
-		cmd_persist(cmd);								// conditionally persist - automatic by cmd_persis()
-		cmd->index++;									// increment SR NVM index
-	}
-}
-
-/* 
- * rpt_set_status_report() - interpret an sr setup string and return current report
- */
-stat_t rpt_set_status_report(cmdObj_t *cmd)
-{
-	uint8_t elements = 0;
-	index_t status_report_list[CMD_STATUS_REPORT_LEN];
-	memset(status_report_list, 0, sizeof(status_report_list));
-	index_t sr_start = cmd_get_index("","se00");		// set first SR persistence index
-
-	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
-		if (((cmd = cmd->nx) == NULL) || (cmd->objtype == TYPE_EMPTY)) { break;}
-		if ((cmd->objtype == TYPE_BOOL) && (cmd->value == true)) {
-			status_report_list[i] = cmd->index;
-			cmd->value = cmd->index;					// persist the index as the value
-			cmd->index = sr_start + i;					// index of the SR persistence location
-			cmd_persist(cmd);
-			elements++;
-		} else {
-			return (STAT_INPUT_VALUE_UNSUPPORTED);
-		}
-	}
-	if (elements == 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
-	memcpy(cfg.status_report_list, status_report_list, sizeof(status_report_list));
-	rpt_populate_unfiltered_status_report();			// return current values
-	return (STAT_OK);
-}
-
-/* 
- * rpt_run_text_status_report()	- generate a text mode status report in multiline format
- * rpt_request_status_report()	- request a status report to run after minimum interval
- * rpt_force_status_report()	- request a status report to run at the next main loop opporunity
- * rpt_status_report_rtc_callback()	- real-time clock downcount for minimum reporting interval
- * rpt_status_report_callback()	- main loop callback to send a report if one is ready
- *
- *	Status reports can be request from a number of sources including:
- *	  - direct request from command line in the form of ? or {"sr:""}
- *	  - timed requests during machining cycle
- *	  - filtered request after each Gcode block
- *
- *	Status reports are generally returned with minimal delay (from the controller callback), 
- *	but will not be provided more frequently than the status report interval
- */
-void rpt_run_text_status_report()
-{
-	rpt_populate_unfiltered_status_report();
-	cmd_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
-}
-
-void rpt_request_status_report(uint8_t request_type)
-{
-	cm.status_report_request = request_type;
-}
-
-void rpt_status_report_rtc_callback() 		// called by 10ms real-time clock
-{
-	if (--cm.status_report_counter == 0) {
-		cm.status_report_request = SR_IMMEDIATE_REQUEST;	// promote to immediate request
-		cm.status_report_counter = (cfg.status_report_interval / RTC_MILLISECONDS);	// reset minimum interval
-	}
-}
-
-stat_t rpt_status_report_callback() 		// called by controller dispatcher
-{
-	if ((cfg.status_report_verbosity == SR_OFF) || 
-		(cm.status_report_request != SR_IMMEDIATE_REQUEST)) {
-		return (STAT_NOOP);
-	}
-	if (cfg.status_report_verbosity == SR_FILTERED) {
-		if (rpt_populate_filtered_status_report() == true) {
-			cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
-		}
-	} else {
-		rpt_populate_unfiltered_status_report();
-		cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
-	}
-//	cm.status_report_counter = (cfg.status_report_interval / RTC_PERIOD);	// reset minimum interval
-	cm.status_report_request = SR_NO_REQUEST;
-	return (STAT_OK);
-}
-
-/*
- * rpt_populate_unfiltered_status_report() - populate cmdObj body with status values
- *
- *	Designed to be run as a response; i.e. have a "r" header and a footer.
- */
-
-void rpt_populate_unfiltered_status_report()
-{
-	char tmp[CMD_TOKEN_LEN+1];
-	cmdObj_t *cmd = cmd_reset_list();		// sets *cmd to the start of the body
-	cmd->objtype = TYPE_PARENT; 			// setup the parent object
-	strcpy(cmd->token, "sr");
-//	sprintf_P(cmd->token, PSTR("sr"));		// alternate form of above: less RAM, more FLASH & cycles
-	cmd->index = cmd_get_index("","sr");	// set the index - may be needed by calling function
-	cmd = cmd->nx;							// no need to check for NULL as list has just been reset
-
-	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
-		if ((cmd->index = cfg.status_report_list[i]) == 0) { break;}
-		cmd_get_cmdObj(cmd);
-		strcpy(tmp, cmd->group);			// concatenate groups and tokens
-		strcat(tmp, cmd->token);
-		strcpy(cmd->token, tmp);
-		if ((cmd = cmd->nx) == NULL) return; // should never be NULL unless SR length exceeds available buffer array 
-	}
-}
-
-/*
- * rpt_populate_filtered_status_report() - populate cmdObj body with status values
- *
- *	Designed to be displayed as a JSON object; i;e; no footer or header
- *	Returns 'true' if the report has new data, 'false' if there is nothing to report.
- *
- *	NOTE: Unlike rpt_populate_unfiltered_status_report(), this function does NOT set 
- *	the SR index, which is a relatively expensive operation. In current use this 
- *	doesn't matter, but if the caller assumes its set it may lead to a side-effect (bug)
- *
- *	NOTE: Room for improvement - look up the SR index initially and cache it, use the 
- *		  cached value for all remaining reports.
- */
-uint8_t rpt_populate_filtered_status_report()
-{
-	uint8_t has_data = false;
-	char tmp[CMD_TOKEN_LEN+1];
-	cmdObj_t *cmd = cmd_reset_list();		// sets cmd to the start of the body
-
-	cmd->objtype = TYPE_PARENT; 			// setup the parent object
-	strcpy(cmd->token, "sr");
-//	sprintf_P(cmd->token, PSTR("sr"));		// alternate form of above: less RAM, more FLASH & cycles
-//	cmd->index = cmd_get_index("","sr");	// OMITTED - set the index - may be needed by calling function
-	cmd = cmd->nx;							// no need to check for NULL as list has just been reset
-
-	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
-		if ((cmd->index = cfg.status_report_list[i]) == 0) { break;}
-
-		cmd_get_cmdObj(cmd);
-		if (cfg.status_report_value[i] == cmd->value) {	// float == comparison runs the risk of overreporting. So be it
-			cmd->objtype = TYPE_EMPTY;
-			continue;
-		} else {
-			strcpy(tmp, cmd->group);		// flatten out groups
-			strcat(tmp, cmd->token);
-			strcpy(cmd->token, tmp);
-			cfg.status_report_value[i] = cmd->value;
-			if ((cmd = cmd->nx) == NULL) return (false); // should never be NULL unless SR length exceeds available buffer array
-			has_data = true;
-		}
-	}
-//	cmd->pv->nx = NULL;						// back up one and terminate the body
-	return (has_data);
-}
-
-/*****************************************************************************
- * Queue Reports
- * rpt_request_queue_report()	- request a queue report with current values
- * rpt_queue_report_callback()	- run the queue report w/stored values
- */
-
-struct qrIndexes {				// static data for queue reports
-	uint8_t request;			// set to true to request a report
-	uint8_t buffers_available;	// stored value used by callback
-	uint8_t prev_available;		// used to filter reports
-	uint8_t buffers_added;		// buffers added since last report
-	uint8_t buffers_removed;	// buffers removed since last report
-};
-static struct qrIndexes qr;
-
-void rpt_clear_queue_report()
-{
-	qr.request = false;
-	qr.buffers_added = 0;
-	qr.buffers_removed = 0;
-}
-
-void rpt_request_queue_report(int8_t buffers)
-//void rpt_request_queue_report()
-{
-	if (cfg.queue_report_verbosity == QR_OFF) return;
-
-	qr.buffers_available = mp_get_planner_buffers_available();
-
-	if (buffers > 0) {
-		qr.buffers_added += buffers;
-	} else {
-		qr.buffers_removed -= buffers;
-	}
-
-	// perform filtration for QR_FILTERED reports
-	if (cfg.queue_report_verbosity == QR_FILTERED) {
-		if (qr.buffers_available == qr.prev_available) {
-			return;
-		}
-		if ((qr.buffers_available > cfg.queue_report_lo_water) && 	// e.g. > 2 buffers available
-			(qr.buffers_available < cfg.queue_report_hi_water)) {	// e.g. < 20 buffers available
-			return;
-		}
-	}
-	qr.prev_available = qr.buffers_available;
-	qr.request = true;
-}
-
-uint8_t rpt_queue_report_callback()
-{
-	if (qr.request == false) { return (STAT_NOOP);}
-	qr.request = false;
-
-	if (cfg.comm_mode == TEXT_MODE) {
-		if (cfg.queue_report_verbosity == QR_VERBOSE) {
-			fprintf(stderr, "qr:%d\n", qr.buffers_available);
-		} else  if (cfg.queue_report_verbosity == QR_TRIPLE) {
-			fprintf(stderr, "qr:%d,added:%d,removed:%d\n", qr.buffers_available, qr.buffers_added,qr.buffers_removed);
-		}
-	} else {
-		if (cfg.queue_report_verbosity == QR_VERBOSE) {
-			fprintf(stderr, "{\"qr\":%d}\n", qr.buffers_available);
-		} else  if (cfg.queue_report_verbosity == QR_TRIPLE) {
-			fprintf(stderr, "{\"qr\":[%d,%d,%d]}\n", qr.buffers_available, qr.buffers_added,qr.buffers_removed);
-			rpt_clear_queue_report();
-		}
-	}
-	return (STAT_OK);
-
-/*
-	// get a clean cmd object
-//	cmdObj_t *cmd = cmd_reset_list();		// normally you do a list reset but the following is more time efficient
-	cmdObj_t *cmd = cmd_body;
-	cmd_reset_obj(cmd);
-	cmd->nx = NULL;							// terminate the list
-
-	// make a qr object and print it
-	sprintf_P(cmd->token, PSTR("qr"));
-	cmd->value = qr.buffers_available;
-	cmd->objtype = TYPE_INTEGER;
-	cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
-	return (STAT_OK);
-*/
-}
-
-/****************************************************************************
- ***** Report Unit Tests ****************************************************
- ****************************************************************************/
-
-#ifdef __UNIT_TESTS
-#ifdef __UNIT_TEST_REPORT
-
-void sr_unit_tests(void)
-{
-	sr_init();
-	tg.communications_mode = STAT_JSON_MODE;
-	sr_run_status_report();
-}
-
-#endif
-#endif
+/*
+ * report.c - TinyG status report and other reporting functions.
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S Hart, Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "json_parser.h"
+#include "controller.h"
+#include "planner.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "report.h"
+#include "settings.h"
+#include "stepper.h"			// isr_rpt is a watch window source
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"
+
+static void _send_binary_status_report(void);
+static void _populate_status_report(uint8_t periodic);
+static stat_t _run_status_report_pass(void);
+static uint8_t _append_queue_report_to_list(void);
+
+/**** Status and Exception Messages **************************************************
+ * rpt_get_status_message() - return the status message
+ * rpt_exception() - send an exception report (JSON formatted)
+ *
+ * These strings must align with the status codes in tinyg.h
+ * The number of elements in the indexing array must match the # of strings
+ * Reference for putting display strings and string arrays in program memory:
+ * http://www.cs.mun.ca/~paul/cs4723/material/atmel/avr-libc-user-manual-1.6.5/pgmspace.html
+ */
+static const char msg_sc00[] PROGMEM = "OK";
+static const char msg_sc01[] PROGMEM = "Error";
+static const char msg_sc02[] PROGMEM = "Eagain";
+static const char msg_sc03[] PROGMEM = "Noop";
+static const char msg_sc04[] PROGMEM = "Complete";
+static const char msg_sc05[] PROGMEM = "Terminated";
+static const char msg_sc06[] PROGMEM = "Hard reset";
+static const char msg_sc07[] PROGMEM = "End of line";
+static const char msg_sc08[] PROGMEM = "End of file";
+static const char msg_sc09[] PROGMEM = "File not open";
+static const char msg_sc10[] PROGMEM = "Max file size exceeded";
+static const char msg_sc11[] PROGMEM = "No such device";
+static const char msg_sc12[] PROGMEM = "Buffer empty";
+static const char msg_sc13[] PROGMEM = "Buffer full";
+static const char msg_sc14[] PROGMEM = "Buffer full - fatal";
+static const char msg_sc15[] PROGMEM = "Initializing";
+static const char msg_sc16[] PROGMEM = "Entering boot loader";
+static const char msg_sc17[] PROGMEM = "17";
+static const char msg_sc18[] PROGMEM = "18";
+static const char msg_sc19[] PROGMEM = "19";
+
+static const char msg_sc20[] PROGMEM = "Internal error";
+static const char msg_sc21[] PROGMEM = "Internal range error";
+static const char msg_sc22[] PROGMEM = "Floating point error";
+static const char msg_sc23[] PROGMEM = "Divide by zero";
+static const char msg_sc24[] PROGMEM = "Invalid Address";
+static const char msg_sc25[] PROGMEM = "Read-only address";
+static const char msg_sc26[] PROGMEM = "Initialization failure";
+static const char msg_sc27[] PROGMEM = "System alarmed";
+static const char msg_sc28[] PROGMEM = "Memory fault or corruption";
+static const char msg_sc29[] PROGMEM = "Network segment stream lost sync";
+static const char msg_sc30[] PROGMEM = "30";
+static const char msg_sc31[] PROGMEM = "31";
+static const char msg_sc32[] PROGMEM = "32";
+static const char msg_sc33[] PROGMEM = "33";
+static const char msg_sc34[] PROGMEM = "34";
+static const char msg_sc35[] PROGMEM = "35";
+static const char msg_sc36[] PROGMEM = "36";
+static const char msg_sc37[] PROGMEM = "37";
+static const char msg_sc38[] PROGMEM = "38";
+static const char msg_sc39[] PROGMEM = "39";
+
+static const char msg_sc40[] PROGMEM = "Unrecognized command";
+static const char msg_sc41[] PROGMEM = "Expected command letter";
+static const char msg_sc42[] PROGMEM = "Bad number format";
+static const char msg_sc43[] PROGMEM = "Input exceeds max length";
+static const char msg_sc44[] PROGMEM = "Input value too small";
+static const char msg_sc45[] PROGMEM = "Input value too large";
+static const char msg_sc46[] PROGMEM = "Input value range error";
+static const char msg_sc47[] PROGMEM = "Input value unsupported";
+static const char msg_sc48[] PROGMEM = "JSON syntax error";
+static const char msg_sc49[] PROGMEM = "JSON input has too many pairs";
+static const char msg_sc50[] PROGMEM = "JSON output too long";
+static const char msg_sc51[] PROGMEM = "Out of buffer space";
+static const char msg_sc52[] PROGMEM = "Config not taken during machining cycle";
+static const char msg_sc53[] PROGMEM = "Checksum failed";
+static const char msg_sc54[] PROGMEM = "54";
+static const char msg_sc55[] PROGMEM = "55";
+static const char msg_sc56[] PROGMEM = "56";
+static const char msg_sc57[] PROGMEM = "57";
+static const char msg_sc58[] PROGMEM = "58";
+static const char msg_sc59[] PROGMEM = "59";
+
+static const char msg_sc60[] PROGMEM = "Move less than minimum length";
+static const char msg_sc61[] PROGMEM = "Move less than minimum time";
+static const char msg_sc62[] PROGMEM = "Gcode block skipped";
+static const char msg_sc63[] PROGMEM = "Gcode input error";
+static const char msg_sc64[] PROGMEM = "Gcode feedrate error";
+static const char msg_sc65[] PROGMEM = "Gcode axis word missing";
+static const char msg_sc66[] PROGMEM = "Gcode modal group violation";
+static const char msg_sc67[] PROGMEM = "Homing cycle failed";
+static const char msg_sc68[] PROGMEM = "Max travel exceeded";
+static const char msg_sc69[] PROGMEM = "Max spindle speed exceeded";
+static const char msg_sc70[] PROGMEM = "Arc specification error";
+static const char msg_sc71[] PROGMEM = "Step loss detected";
+
+PGM_P const msgStatusMessage[] PROGMEM = {
+	msg_sc00, msg_sc01, msg_sc02, msg_sc03, msg_sc04, msg_sc05, msg_sc06, msg_sc07, msg_sc08, msg_sc09,
+	msg_sc10, msg_sc11, msg_sc12, msg_sc13, msg_sc14, msg_sc15, msg_sc16, msg_sc17, msg_sc18, msg_sc19,
+	msg_sc20, msg_sc21, msg_sc22, msg_sc23, msg_sc24, msg_sc25, msg_sc26, msg_sc27, msg_sc28, msg_sc29,
+	msg_sc30, msg_sc31, msg_sc32, msg_sc33, msg_sc34, msg_sc35, msg_sc36, msg_sc37, msg_sc38, msg_sc39,
+	msg_sc40, msg_sc41, msg_sc42, msg_sc43, msg_sc44, msg_sc45, msg_sc46, msg_sc47, msg_sc48, msg_sc49,
+	msg_sc50, msg_sc51, msg_sc52, msg_sc53, msg_sc54, msg_sc55, msg_sc56, msg_sc57, msg_sc58, msg_sc59,
+	msg_sc60, msg_sc61, msg_sc62, msg_sc63, msg_sc64, msg_sc65, msg_sc66, msg_sc67, msg_sc68, msg_sc69,
+	msg_sc70, msg_sc71
+};
+
+char *rpt_get_status_message(uint8_t status, char *msg) 
+{
+	strncpy_P(msg,(PGM_P)pgm_read_word(&msgStatusMessage[status]), STATUS_MESSAGE_LEN);
+	return (msg);
+}
+
+/* Exception rate limiting
+ *
+ *	A flaky input can raise the same exception fast enough to saturate TX and
+ *	starve gcode acks, so identical exceptions are limited to ER_LIMIT_PER_SEC
+ *	within a 1 second window and the overflow is counted instead of sent. The
+ *	count rides out as a "sup" (suppressed) field on the next report that does
+ *	make it out, so nothing is lost silently. A different status always opens
+ *	a fresh window - distinct exceptions are never suppressed by each other.
+ */
+#define ER_LIMIT_PER_SEC 4				// max identical exceptions per 1-second window
+
+static uint8_t er_status;				// status the current window is counting
+static uint8_t er_count;				// exceptions sent in the current window
+static uint16_t er_suppressed;			// exceptions dropped since the last sent report
+static uint32_t er_window_end;			// RTC tick when the current window expires
+
+void rpt_exception(uint8_t status, int16_t value)
+{
+	char msg[STATUS_MESSAGE_LEN];
+	char er[STATUS_MESSAGE_LEN + 80];		// holds the message plus the fixed part of the format
+
+	if ((status == er_status) && (rtc.clock_ticks < er_window_end)) {
+		if (er_count >= ER_LIMIT_PER_SEC) {	// over the limit - drop it and count the drop
+			if (er_suppressed < 65535) { er_suppressed++;}
+			return;
+		}
+	} else {								// new status or expired window - start a fresh one
+		er_status = status;
+		er_count = 0;
+		er_window_end = rtc.clock_ticks + (1000 / RTC_MILLISECONDS);
+	}
+	er_count++;
+
+	if (er_suppressed == 0) {
+		sprintf_P(er, PSTR("{\"er\":{\"fb\":%0.2f,\"st\":%d,\"msg\":\"%s\",\"val\":%d}}\n"),
+			TINYG_FIRMWARE_BUILD, status, rpt_get_status_message(status, msg), value);
+	} else {
+		sprintf_P(er, PSTR("{\"er\":{\"fb\":%0.2f,\"st\":%d,\"msg\":\"%s\",\"val\":%d,\"sup\":%u}}\n"),
+			TINYG_FIRMWARE_BUILD, status, rpt_get_status_message(status, msg), value, er_suppressed);
+		er_suppressed = 0;
+	}
+	xio_write_stream_pri(stdout, er, strlen(er));	// priority write - don't wait behind queued traffic
+}
+
+/**** Application Messages *********************************************************
+ * rpt_print_message() 				   - print a character string passed as argument
+ * rpt_print_initializing_message()	   - initializing configs from hard-coded profile
+ * rpt_print_system_ready_message()    - system ready message
+ *
+ *	These messages are always in JSON format to allow UIs to sync
+ */
+/*
+void rpt_print_message(char *msg)
+{
+	cmd_add_string("msg", msg);
+	cmd_print_list(STAT_OK, TEXT_INLINE_VALUES, JSON_RESPONSE_FORMAT);
+}
+*/
+
+void _startup_helper(uint8_t status, const char *msg)
+{
+#ifndef __SUPPRESS_STARTUP_MESSAGES
+	cmd_reset_list();
+	cmd_add_object("fb");
+	cmd_add_object("fv");
+	cmd_add_object("hv");
+	cmd_add_object("id");
+	cmd_add_string_P("msg", msg);
+	js_print_json_response(status);
+#endif
+}
+
+void rpt_print_initializing_message(void)
+{
+	_startup_helper(STAT_INITIALIZING, PSTR(INIT_MESSAGE));
+}
+
+void rpt_print_system_ready_message(void)
+{
+	_startup_helper(STAT_OK, PSTR("SYSTEM READY"));
+	if (cfg.comm_mode == TEXT_MODE) { tg_text_response(STAT_OK, "");}// prompt
+}
+
+/*
+ * rpt_request_system_ready_message() - queue the ready banner for the controller loop
+ * rpt_system_ready_callback()		  - print the banner from the background loop
+ *
+ *	The ready banner is deferred to the first controller pass instead of being
+ *	printed from main() so serial input is accepted as soon as interrupts come
+ *	up - hosts that power-cycle the board (e.g. tool changers) can start
+ *	sending before the banner has been serialized. The callback is dispatched
+ *	ahead of the command dispatcher so the banner still precedes any command
+ *	responses.
+ */
+static uint8_t system_ready_pending = false;
+
+void rpt_request_system_ready_message(void)
+{
+	system_ready_pending = true;
+}
+
+stat_t rpt_system_ready_callback(void)
+{
+	if (system_ready_pending == false) { return (STAT_NOOP);}
+	system_ready_pending = false;
+	rpt_print_system_ready_message();
+	return (STAT_OK);
+}
+
+/*****************************************************************************
+ * Status Reports
+ *
+ *	Status report behaviors
+ *
+ *	Configuration:
+ *
+ *		Status reports are configurable only from JSON. SRs are configured
+ *		by sending a status report SET object, e.g:
+ *
+ *		  {"sr":{"line":true,"posx":true,"posy":true....."motm":true,"stat":true}}
+ *
+ *	Status report formats: The following formats exist for status reports:
+ *
+ *	  -	JSON format: Returns a JSON object as above, but with the values filled in. 
+ *		In JSON form all values are returned as numeric values or enumerations. 
+ *		E.g. "posx" is returned as 124.523 and "unit" is returned as 0 for 
+ *		inches (G20) and 1 for mm (G21).
+ *
+ *	  - CSV format: Returns a single line of comma separated token:value pairs.
+ *		Values are returned as numeric values or English text.
+ *		E.g. "posx" is still returned as 124.523 but "unit" is returned as 
+ *		"inch" for inches (G20) and "mm" for mm (G21).
+ *
+ *	  - Multi-line format: Returns a multi-line report where each value occupies 
+ *		one line. Each line contains explanatory English text. Enumerated values are
+ *		returned as English text as per CSV form.
+ *	
+ *	Status report invocation: Status reports can be invoked in the following ways:
+ *
+ *	  - Ad-hoc request in JSON mode. Issue {"sr":""} (or equivalent). Returns a 
+ *		JSON format report (wrapped in a response header, of course).
+ *
+ *	  - Automatic status reports in JSON mode. Returns JSON format reports 
+ *		according to "si" setting.
+ *
+ *	  - Ad-hoc request in text mode. Triggered by sending ?<cr>. Returns status 
+ *		report in multi-line format. Additionally, a line starting with ? will put 
+ *		the system into text mode.
+ *
+ *	  - Automatic status reports in text mode return CSV format according to si setting
+ *
+ *	  - grbl compatibility forms are not yet supported.
+ */
+
+/*
+ * Status report descriptor cache
+ *
+ *	The population paths used to call cmd_get_cmdObj() for every field of
+ *	every report, re-reading the same cfgArray metadata out of PROGMEM
+ *	(token and group strcpy_P, flags, getter pointer) 10-20 times per 50ms
+ *	report. The metadata only changes when the SR list changes, so it is
+ *	resolved once into sr_desc[] whenever the list is set and the periodic
+ *	reports do only the value reads and serialization.
+ */
+typedef struct srDescriptor {
+	index_t index;					// cfgArray index; 0 = end of list
+	fptrCmd get;					// resolved value getter
+	uint8_t slow;					// true for slow rate class fields (see below)
+	uint8_t source;					// dirty source bitmask; 0 = always checked (see below)
+	char token[CMD_TOKEN_LEN+1];	// flattened group+token
+} srDescriptor_t;
+
+static srDescriptor_t sr_desc[CMD_STATUS_REPORT_LEN];
+static index_t sr_parent_index;		// index of the "sr" parent object
+
+/* Status report rate classes
+ *
+ *	Position and velocity want every report interval, but the Gcode mode
+ *	fields (units, coordinate system, distance mode...) change a few times
+ *	per job. Fields on the slow list ride along on every SR_SLOW_EVERY_N'th
+ *	report only, which cuts steady-state report bandwidth and serialization
+ *	time without costing DRO responsiveness. In filtered and binary modes the
+ *	fields are still change-gated, so a mode change is reported exactly once -
+ *	just up to N-1 intervals late. The class is resolved from the token when
+ *	the SR list is set, so it costs nothing per report.
+ */
+#define SR_SLOW_EVERY_N 10			// slow-class fields go out on every Nth report
+
+static uint8_t sr_slow_phase;		// rolls 0..N-1; slow fields go out on phase 0
+
+static const char sr_slow_tokens[][CMD_TOKEN_LEN+1] PROGMEM = {
+	"unit","coor","momo","plan","path","dist","frmo",""
+};
+
+static uint8_t _is_slow_field(const char *token)
+{
+	for (uint8_t i=0; pgm_read_byte(&sr_slow_tokens[i][0]) != NUL; i++) {
+		if (strcmp_P(token, sr_slow_tokens[i]) == 0) { return (true);}
+	}
+	return (false);
+}
+
+/* Status report dirty sources
+ *
+ *	The filtered and binary reports used to discover changes by reading and
+ *	comparing every configured field each interval - O(fields) getter calls
+ *	and float compares even when nothing moved. The publish points now mark
+ *	their source class dirty when they touch reportable state - st_prep_line()
+ *	for everything the runtime moves, the gcode parser settings chain and the
+ *	machine state transitions for the model - and the report passes skip any
+ *	class that hasn't been touched since the last pass. Fields that don't
+ *	classify (e.g. "stat", which changes from both paths) fall into the
+ *	always-checked class so an unlisted source can't silence a field, and the
+ *	per-field value compare still gates what actually gets serialized.
+ */
+static uint8_t sr_dirty;			// dirty source bits pending a report pass
+static uint8_t sr_always_fields;	// count of fields in the always-checked class
+
+static const char sr_runtime_tokens[][CMD_TOKEN_LEN+1] PROGMEM = {
+	"line","lind","vel","posx","posy","posz","posa","posb","posc",
+	"mpox","mpoy","mpoz","mpoa","mpob","mpoc",""
+};
+static const char sr_model_tokens[][CMD_TOKEN_LEN+1] PROGMEM = {
+	"feed","unit","coor","momo","plan","path","dist","frmo",""
+};
+
+static uint8_t _get_source(const char *token)
+{
+	for (uint8_t i=0; pgm_read_byte(&sr_runtime_tokens[i][0]) != NUL; i++) {
+		if (strcmp_P(token, sr_runtime_tokens[i]) == 0) { return (SR_DIRTY_RUNTIME_bm);}
+	}
+	for (uint8_t i=0; pgm_read_byte(&sr_model_tokens[i][0]) != NUL; i++) {
+		if (strcmp_P(token, sr_model_tokens[i]) == 0) { return (SR_DIRTY_MODEL_bm);}
+	}
+	return (0);						// unclassified - always checked
+}
+
+void rpt_mark_sr_dirty(uint8_t sources)
+{
+	sr_dirty |= sources;
+}
+
+static void _retire_sr_dirty(void)
+{
+	// Model state rides the slow phase, so its bit stays armed until a
+	// phase 0 pass has actually run the slow-class fields
+	sr_dirty &= ~SR_DIRTY_RUNTIME_bm;
+	if (sr_slow_phase == 0) { sr_dirty &= ~SR_DIRTY_MODEL_bm;}
+}
+
+static void _resolve_status_report(void)
+{
+	cmdObj_t cmd;
+	memset(&cmd, 0, sizeof(cmd));	// NULL pv keeps cmd_reset_obj() at depth 0
+	sr_parent_index = cmd_get_index("","sr");
+	sr_always_fields = 0;
+
+	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
+		srDescriptor_t *d = &sr_desc[i];
+		if ((d->index = cfg.status_report_list[i]) == 0) { break;}
+		cmd.index = d->index;
+		cmd_get_cmdObj(&cmd);		// resolves group stripping the usual way
+		d->slow = _is_slow_field(cmd.token);
+		strcpy(d->token, cmd.group);// flatten group+token once
+		strcat(d->token, cmd.token);
+		if ((d->source = _get_source(d->token)) == 0) { sr_always_fields++;}
+		d->get = cmd_get_getter(d->index);
+	}
+	sr_dirty = (SR_DIRTY_RUNTIME_bm | SR_DIRTY_MODEL_bm);	// report everything once on a fresh list
+}
+
+/*
+ * rpt_init_status_report()
+ *
+ *	Call this function to completely re-initialze the status report
+ *	Sets SR list to hard-coded defaults and re-initializes sr values in NVM
+ */
+void rpt_init_status_report()
+{
+	cmdObj_t *cmd = cmd_reset_list();	// used for status report persistence locations
+	char sr_defaults[CMD_STATUS_REPORT_LEN][CMD_TOKEN_LEN+1] = { SR_DEFAULTS };	// see settings.h
+	cm.status_report_counter = (cfg.status_report_interval / RTC_MILLISECONDS);	// RTC fires every 10 ms
+
+	cmd->index = cmd_get_index("","se00");				// set first SR persistence index
+	for (uint8_t i=0; i < CMD_STATUS_REPORT_LEN ; i++) {
+		if (sr_defaults[i][0] == NUL) break;			// quit on first blank array entry
+		cfg.status_report_value[i] = -1234567;			// pre-load values with an unlikely number
+		cmd->value = cmd_get_index("", sr_defaults[i]);	// load the index for the SR element
+		cmd_set(cmd);
+		cmd_persist(cmd);								// conditionally persist - automatic by cmd_persis()
+		cmd->index++;									// increment SR NVM index
+	}
+	_resolve_status_report();
+}
+
+/* 
+ * rpt_set_status_report() - interpret an sr setup string and return current report
+ */
+stat_t rpt_set_status_report(cmdObj_t *cmd)
+{
+	uint8_t elements = 0;
+	index_t status_report_list[CMD_STATUS_REPORT_LEN];
+	memset(status_report_list, 0, sizeof(status_report_list));
+	index_t sr_start = cmd_get_index("","se00");		// set first SR persistence index
+
+	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
+		if (((cmd = cmd->nx) == NULL) || (cmd->objtype == TYPE_EMPTY)) { break;}
+		if ((cmd->objtype == TYPE_BOOL) && (cmd->value == true)) {
+			status_report_list[i] = cmd->index;
+			cmd->value = cmd->index;					// persist the index as the value
+			cmd->index = sr_start + i;					// index of the SR persistence location
+			cmd_persist(cmd);
+			elements++;
+		} else {
+			return (STAT_INPUT_VALUE_UNSUPPORTED);
+		}
+	}
+	if (elements == 0) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	memcpy(cfg.status_report_list, status_report_list, sizeof(status_report_list));
+	_resolve_status_report();
+	rpt_populate_unfiltered_status_report();			// return current values
+	return (STAT_OK);
+}
+
+/* 
+ * rpt_run_text_status_report()	- generate a text mode status report in multiline format
+ * rpt_request_status_report()	- request a status report to run after minimum interval
+ * rpt_force_status_report()	- request a status report to run at the next main loop opporunity
+ * rpt_status_report_rtc_callback()	- real-time clock downcount for minimum reporting interval
+ * rpt_status_report_callback()	- main loop callback to send a report if one is ready
+ *
+ *	Status reports can be request from a number of sources including:
+ *	  - direct request from command line in the form of ? or {"sr:""}
+ *	  - timed requests during machining cycle
+ *	  - filtered request after each Gcode block
+ *
+ *	Status reports are generally returned with minimal delay (from the controller callback), 
+ *	but will not be provided more frequently than the status report interval
+ */
+void rpt_run_text_status_report()
+{
+	rpt_populate_unfiltered_status_report();
+	cmd_print_list(STAT_OK, TEXT_MULTILINE_FORMATTED, JSON_RESPONSE_FORMAT);
+}
+
+void rpt_request_status_report(uint8_t request_type)
+{
+	cm.status_report_request = request_type;
+}
+
+void rpt_status_report_rtc_callback() 		// called by 10ms real-time clock
+{
+	if (--cm.status_report_counter == 0) {
+		cm.status_report_request = SR_IMMEDIATE_REQUEST;	// promote to immediate request
+		cm.status_report_counter = (cfg.status_report_interval / RTC_MILLISECONDS);	// reset minimum interval
+	}
+}
+
+static uint8_t sr_tx_backed_up;				// one tx drop counted per backed-up episode
+
+stat_t rpt_status_report_callback() 		// called by controller dispatcher
+{
+	if ((cfg.status_report_verbosity == SR_OFF) ||
+		(cm.status_report_request != SR_IMMEDIATE_REQUEST)) {
+		return (STAT_NOOP);
+	}
+	// Verbose JSON reports serialize a bounded number of fields per pass
+	// into a dedicated buffer and only need TX at hand-off, so they skip
+	// the backed-up test below (see _run_status_report_pass())
+	if ((cfg.status_report_verbosity == SR_VERBOSE) && (cfg.comm_mode != TEXT_MODE)) {
+		return (_run_status_report_pass());
+	}
+	// Automatic reports are discardable - if the previous report is still
+	// queued (slow or flow-controlled host) hold this one back rather than
+	// sleeping in the priority write and stalling motion-critical dispatch.
+	// The request stays pending so a fresh report goes out once TX drains.
+	if (xio_tx_pri_empty_usb() == false) {
+		if (sr_tx_backed_up == false) {
+			us[XIO_DEV_USB].io_tx_drops++;	// read via the "io" group ($iotd)
+			sr_tx_backed_up = true;
+		}
+		return (STAT_NOOP);
+	}
+	sr_tx_backed_up = false;
+	if (cfg.status_report_verbosity == SR_BINARY) {
+		_send_binary_status_report();
+	} else if (cfg.status_report_verbosity == SR_FILTERED) {
+		if (rpt_populate_filtered_status_report() == true) {
+			_append_queue_report_to_list();		// fold a pending queue report into this frame
+			cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
+		}
+	} else {									// interactive text mode keeps the one-pass path
+		_populate_status_report(true);			// periodic - slow class fields every Nth report
+		_append_queue_report_to_list();			// fold a pending queue report into this frame
+		cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
+	}
+	if (++sr_slow_phase >= SR_SLOW_EVERY_N) { sr_slow_phase = 0;}
+//	cm.status_report_counter = (cfg.status_report_interval / RTC_PERIOD);	// reset minimum interval
+	cm.status_report_request = SR_NO_REQUEST;
+	return (STAT_OK);
+}
+
+/*
+ * _send_binary_status_report() - emit a delta-encoded binary status report
+ *
+ *	Binary status reports are opt-in via $sv=3 (SR_BINARY) and replace the
+ *	automatic JSON reports only - ad-hoc {"sr":""} requests and text mode
+ *	reports are unaffected. A frame is:
+ *
+ *	  SOH (0x01)	opens the frame; not included in the checksum
+ *	  records		one per reported field: 1 ID byte + 4 raw float bytes
+ *	  0xFF			ends the records (field IDs cannot reach 0xFF)
+ *	  checksum		XOR of all bytes between the SOH and the checksum
+ *
+ *	The field ID is the field's position in the status report list, so the
+ *	host knows the ID-to-token mapping from its own {"sr":{...}} setup command
+ *	(or the SR_DEFAULTS order if it never sent one). Floats are the raw
+ *	IEEE 754 bits in AVR (little endian) byte order. Fields are filtered the
+ *	same way as SR_FILTERED and an all-unchanged report sends nothing at all.
+ *	At ~5 bytes per field with no float formatting this is several times
+ *	cheaper than the JSON form to produce and to transmit.
+ */
+static void _binary_out(uint8_t c, char **str, uint8_t *checksum)
+{
+	*checksum ^= c;
+	*(*str)++ = c;
+}
+
+static void _send_binary_status_report()
+{
+	if ((sr_dirty == 0) && (sr_always_fields == 0)) {
+		return;								// no publish point has fired since the last pass
+	}
+	uint8_t in_frame = false;
+	uint8_t checksum = 0;
+	char *str = tg.out_buf;					// frame is built here, then sent as one priority write
+	cmdObj_t cmd;
+	memset(&cmd, 0, sizeof(cmd));			// NULL pv keeps cmd_reset_obj() at depth 0
+
+	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
+		srDescriptor_t *d = &sr_desc[i];
+		if ((cmd.index = d->index) == 0) { break;}
+		if ((d->slow == true) && (sr_slow_phase != 0)) { continue;}	// off-phase slow class field
+		if ((d->source != 0) && ((sr_dirty & d->source) == 0)) { continue;}	// clean source class
+		d->get(&cmd);						// binary reports only need the value
+		if (cfg.status_report_value[i] == cmd.value) { continue;}	// same filter as SR_FILTERED
+		cfg.status_report_value[i] = cmd.value;
+		if (in_frame == false) {			// open the frame on the first changed field
+			*str++ = 0x01;					// SOH is not included in the checksum
+			in_frame = true;
+		}
+		_binary_out(i, &str, &checksum);	// field ID is the position in the SR list
+		uint8_t *value = (uint8_t *)&cmd.value;
+		for (uint8_t j=0; j<sizeof(float); j++) {
+			_binary_out(value[j], &str, &checksum);
+		}
+	}
+	if (in_frame == true) {
+		_binary_out(0xFF, &str, &checksum);	// end-of-records marker
+		*str++ = checksum;					// checksum is not included in the checksum
+		xio_write_stream_pri(stderr, tg.out_buf, str - tg.out_buf);
+#ifdef __SPI_STATUS_REPORTS
+		xio_write_spi_frame(XIO_DEV_SPI1, tg.out_buf, str - tg.out_buf);	// feed the pendant display
+#endif
+	}
+	_retire_sr_dirty();
+}
+
+/**** Watch window ($watch) **************************************************
+ *
+ *	Tuning jerk and junction settings means inferring planner behavior from
+ *	the motion - status reports are too slow and too coarse to see one
+ *	variable breathe. $watch=n streams a single internal variable at segment
+ *	rate (a few hundred Hz at the default segment time) as compact binary
+ *	frames, an oscilloscope view of the planner:
+ *
+ *	  0 = off (ships off)
+ *	  1 = runtime segment velocity (mm/min)
+ *	  2 = planner buffers in use
+ *	  3 = ms of motion queued in the planner
+ *	  4 = DDA ISR occupancy in uSec (requires __ISR_PROFILE)
+ *
+ *	The tap is a single store from the segment exec into a small ring (see
+ *	_exec_aline_segment() in plan_line.c) so the loop being measured is not
+ *	perturbed; the mainline drains the ring through the same priority TX
+ *	path as the binary status reports, deferring whenever the priority
+ *	buffer has traffic. A frame is:
+ *
+ *	  0x02			opens the frame (binary SRs open with 0x01)
+ *	  count			samples in this frame; bit 7 set = ring overran, samples lost
+ *	  samples		count x 4 raw float bytes in AVR (little endian) byte order
+ *	  checksum		XOR of all bytes between the 0x02 and the checksum
+ *
+ *	At 4 bytes per sample a 200Hz stream is under 1% of a 115.2k channel.
+ *	The ring absorbs a controller pass blocked on other TX; if it still
+ *	overruns, samples are dropped (never blocking the exec) and the next
+ *	frame carries the overrun flag so the host can mind the gap.
+ */
+#define WATCH_SOURCE_MAX 4			// highest valid $watch value
+#define WATCH_RING_SIZE 16			// samples buffered between drains - power of 2
+#define WATCH_SOH 0x02				// opens a watch frame
+
+static float watch_ring[WATCH_RING_SIZE];
+static volatile uint8_t watch_head;	// written by the segment exec
+static uint8_t watch_tail;			// read by rpt_watch_callback()
+static uint8_t watch_overrun;		// samples were dropped since the last frame
+
+/*
+ * rpt_set_watch() - $watch=n - select the streamed variable (0 disables)
+ */
+stat_t rpt_set_watch(cmdObj_t *cmd)
+{
+	if (cmd->value > WATCH_SOURCE_MAX) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+#ifndef __ISR_PROFILE
+	if (cmd->value > 3) { return (STAT_INPUT_VALUE_UNSUPPORTED);}	// no profiler compiled in
+#endif
+	cfg.watch_select = (uint8_t)cmd->value;
+	watch_tail = watch_head;			// discard samples from the previous source
+	watch_overrun = false;
+	return (STAT_OK);
+}
+
+/*
+ * rpt_watch_sample() - capture one sample; called from the segment exec
+ *
+ *	Runs at MED interrupt level right after the runtime snapshot publish,
+ *	so the getters read this segment's freshly published values.
+ */
+void rpt_watch_sample()
+{
+	float value;
+
+	switch (cfg.watch_select) {
+		case 0: return;
+		case 1: { value = mp_get_runtime_velocity(); break;}
+		case 2: { value = PLANNER_BUFFER_POOL_SIZE - mp_get_planner_buffers_available(); break;}
+		case 3: { value = mm.ms_in_queue; break;}
+#ifdef __ISR_PROFILE
+		default: { value = isr_rpt.dda_avg; break;}
+#else
+		default: return;
+#endif
+	}
+	uint8_t next = (watch_head + 1) & (WATCH_RING_SIZE-1);
+	if (next == watch_tail) { 			// ring full - drop, never stall the exec
+		watch_overrun = true;
+		return;
+	}
+	watch_ring[watch_head] = value;
+	watch_head = next;
+}
+
+/*
+ * rpt_watch_callback() - drain buffered samples as one binary frame
+ */
+stat_t rpt_watch_callback()
+{
+	if (cfg.watch_select == 0) { return (STAT_NOOP);}
+	if (watch_head == watch_tail) { return (STAT_NOOP);}	// nothing sampled
+	if (xio_tx_pri_empty_usb() == false) { return (STAT_NOOP);}	// let other traffic drain
+
+	uint8_t checksum = 0;
+	uint8_t count = 0;
+	char *str = tg.out_buf;
+	char *count_byte;
+
+	*str++ = WATCH_SOH;					// SOH is not included in the checksum
+	count_byte = str++;					// count is back-patched below
+	while (watch_tail != watch_head) {
+		uint8_t *value = (uint8_t *)&watch_ring[watch_tail];
+		for (uint8_t j=0; j<sizeof(float); j++) {
+			_binary_out(value[j], &str, &checksum);
+		}
+		watch_tail = (watch_tail + 1) & (WATCH_RING_SIZE-1);
+		count++;
+	}
+	if (watch_overrun == true) {
+		watch_overrun = false;
+		count |= 0x80;					// tell the host there is a gap before this frame
+	}
+	*count_byte = count;
+	checksum ^= count;
+	*str++ = checksum;
+	xio_write_stream_pri(stderr, tg.out_buf, str - tg.out_buf);
+	return (STAT_OK);
+}
+
+/*
+ * rpt_populate_unfiltered_status_report() - populate cmdObj body with status values
+ * _populate_status_report() - worker; periodic reports skip off-phase slow fields
+ *
+ *	Designed to be run as a response; i.e. have a "r" header and a footer.
+ *	Ad-hoc requests ({"sr":""}, ?, the sr setup response) always populate the
+ *	full list; only the periodic reports apply the rate classes.
+ */
+
+static void _populate_status_report(uint8_t periodic)
+{
+	cmdObj_t *cmd = cmd_reset_list();		// sets *cmd to the start of the body
+	cmd->objtype = TYPE_PARENT; 			// setup the parent object
+	strcpy(cmd->token, "sr");
+	cmd->index = sr_parent_index;			// set the index - may be needed by calling function
+	cmd = cmd->nx;							// no need to check for NULL as list has just been reset
+
+	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
+		srDescriptor_t *d = &sr_desc[i];
+		if ((cmd->index = d->index) == 0) { break;}
+		if ((periodic == true) && (d->slow == true) && (sr_slow_phase != 0)) { continue;}
+		d->get(cmd);						// populate value, objtype and precision
+		strcpy(cmd->token, d->token);		// pre-flattened group+token
+		if ((cmd = cmd->nx) == NULL) return; // should never be NULL unless SR length exceeds available buffer array
+	}
+}
+
+void rpt_populate_unfiltered_status_report()
+{
+	_populate_status_report(false);
+}
+
+/*
+ * rpt_populate_filtered_status_report() - populate cmdObj body with status values
+ *
+ *	Designed to be displayed as a JSON object; i;e; no footer or header
+ *	Returns 'true' if the report has new data, 'false' if there is nothing to report.
+ */
+uint8_t rpt_populate_filtered_status_report()
+{
+	if ((sr_dirty == 0) && (sr_always_fields == 0)) {
+		return (false);						// no publish point has fired since the last pass
+	}
+	uint8_t has_data = false;
+	cmdObj_t *cmd = cmd_reset_list();		// sets cmd to the start of the body
+
+	cmd->objtype = TYPE_PARENT; 			// setup the parent object
+	strcpy(cmd->token, "sr");
+	cmd->index = sr_parent_index;			// cached - no lookup cost anymore
+	cmd = cmd->nx;							// no need to check for NULL as list has just been reset
+
+	for (uint8_t i=0; i<CMD_STATUS_REPORT_LEN; i++) {
+		srDescriptor_t *d = &sr_desc[i];
+		if ((cmd->index = d->index) == 0) { break;}
+		if ((d->slow == true) && (sr_slow_phase != 0)) {	// off-phase slow class field
+			cmd->objtype = TYPE_EMPTY;
+			continue;
+		}
+		if ((d->source != 0) && ((sr_dirty & d->source) == 0)) {	// clean source class
+			cmd->objtype = TYPE_EMPTY;
+			continue;
+		}
+		d->get(cmd);						// populate value, objtype and precision
+		if (cfg.status_report_value[i] == cmd->value) {	// float == comparison runs the risk of overreporting. So be it
+			cmd->objtype = TYPE_EMPTY;
+			continue;
+		} else {
+			strcpy(cmd->token, d->token);	// pre-flattened group+token
+			cfg.status_report_value[i] = cmd->value;
+			if ((cmd = cmd->nx) == NULL) return (false); // should never be NULL unless SR length exceeds available buffer array
+			has_data = true;
+		}
+	}
+	_retire_sr_dirty();
+	return (has_data);
+}
+
+/*****************************************************************************
+ * Queue Reports
+ * rpt_request_queue_report()	- request a queue report with current values
+ * rpt_queue_report_callback()	- run the queue report w/stored values
+ */
+
+#define QR_HEARTBEAT_SECONDS 2	// max QR_FILTERED silence while buffers are moving
+
+enum qrBand {					// which side of the watermarks the queue is on
+	QR_BAND_LO = 0,				// at or below the low water mark - host should throttle
+	QR_BAND_MID,				// between the marks - no report needed
+	QR_BAND_HI					// at or above the high water mark - host should send
+};
+
+struct qrIndexes {				// static data for queue reports
+	uint8_t request;			// set to true to request a report
+	uint8_t buffers_available;	// stored value used by callback
+	uint8_t prev_available;		// used to filter reports
+	uint8_t prev_band;			// watermark band of the last emitted report (QR_FILTERED)
+	uint32_t next_heartbeat;	// RTC tick deadline for the next forced report (QR_FILTERED)
+	uint8_t buffers_added;		// buffers added since last report
+	uint8_t buffers_removed;	// buffers removed since last report
+	uint16_t starvation_count;	// exec calls that found an empty queue while a job was active
+	uint8_t lo_water_mark;		// fewest buffers available since cycle start
+};
+static struct qrIndexes qr;
+
+void rpt_clear_queue_report()
+{
+	qr.request = false;
+	qr.buffers_added = 0;
+	qr.buffers_removed = 0;
+}
+
+/*
+ * rpt_reset_queue_metrics() - zero per-job streaming metrics (called at cycle start)
+ * rpt_queue_starved() 		 - count a starvation event (called from the exec interrupt)
+ *
+ *	The starvation count and low-water mark accumulate over a job so streaming
+ *	headroom can be quantified and host buffering tuned. Starvation is counted 
+ *	when mp_exec_move() comes up empty while a machining cycle is active.
+ */
+void rpt_reset_queue_metrics()
+{
+	qr.starvation_count = 0;
+	qr.lo_water_mark = mp_get_planner_buffers_available();
+}
+
+void rpt_queue_starved()
+{
+	qr.starvation_count++;
+}
+
+uint16_t rpt_get_starvation_count() { return (qr.starvation_count);}
+uint8_t rpt_get_lo_water_mark() { return (qr.lo_water_mark);}
+
+void rpt_request_queue_report(int8_t buffers)
+//void rpt_request_queue_report()
+{
+	if (cfg.queue_report_verbosity == QR_OFF) return;
+
+	qr.buffers_available = mp_get_planner_buffers_available();
+	if (qr.buffers_available < qr.lo_water_mark) { qr.lo_water_mark = qr.buffers_available;}
+
+	if (buffers > 0) {
+		qr.buffers_added += buffers;
+	} else {
+		qr.buffers_removed -= buffers;
+	}
+
+	// QR_FILTERED reports are edge triggered: one report when the queue
+	// crosses a watermark ($qrl/$qrh), not one per buffer while it sits
+	// beyond it. A heartbeat forces a report when buffers are still moving
+	// but no crossing has occurred, so hosts can detect a lost report.
+	if (cfg.queue_report_verbosity == QR_FILTERED) {
+		uint8_t band = QR_BAND_MID;
+		if (qr.buffers_available <= cfg.queue_report_lo_water) {		// e.g. <= 2 buffers available
+			band = QR_BAND_LO;
+		} else if (qr.buffers_available >= cfg.queue_report_hi_water) {	// e.g. >= 20 buffers available
+			band = QR_BAND_HI;
+		}
+		if ((band == qr.prev_band) && (rtc.clock_ticks < qr.next_heartbeat)) {
+			return;
+		}
+		qr.prev_band = band;
+		qr.next_heartbeat = rtc.clock_ticks + (QR_HEARTBEAT_SECONDS * (1000 / RTC_MILLISECONDS));
+	}
+	qr.prev_available = qr.buffers_available;
+	qr.request = true;
+}
+
+/*
+ * _run_status_report_pass() - resumable serializer for verbose JSON reports
+ *
+ *	A full verbose report used to populate the cmd body and serialize the
+ *	whole frame in one controller pass, and that pass showed up as a
+ *	periodic spike in segment supply jitter at the SR interval. This path
+ *	spreads the work: each pass fetches and serializes at most
+ *	SR_FIELDS_PER_PASS fields into a dedicated buffer (so tg.out_buf stays
+ *	free for whatever else the pass dispatches) and returns STAT_EAGAIN,
+ *	which restarts the controller loop and lets the motion-critical
+ *	dispatches run between chunks. When the last field is in, a pending
+ *	queue report is folded in as a sibling (same one-frame rule as
+ *	_append_queue_report_to_list()) and the finished frame goes to the
+ *	priority TX path - held, not dropped, if TX is still busy.
+ *
+ *	Values can move between passes so a frame is not a point-in-time
+ *	snapshot, but fields within one pass are coherent and the SR fields
+ *	are each self-consistent (the runtime snapshot getters do their own
+ *	double buffering), which is the same guarantee the one-pass serializer
+ *	gave against the moving runtime.
+ */
+#define SR_FIELDS_PER_PASS 4		// bounds serialization work per controller pass
+#define SR_OUT_BUF_MARGIN 72		// worst single field - a 6 axis position vector
+
+static char sr_out_buf[OUTPUT_BUFFER_LEN];	// dedicated frame buffer - survives across passes
+static char *sr_out_p;				// write position in sr_out_buf
+static int8_t sr_run_field = -1;	// next sr_desc element to serialize; -1 = no frame open
+static uint8_t sr_need_comma;
+
+static stat_t _run_status_report_pass()
+{
+	uint8_t fields = 0;
+	cmdObj_t cmd;
+
+	if (sr_run_field < 0) {						// open a new report frame
+		sr_out_p = sr_out_buf + sprintf(sr_out_buf, "{\"sr\":{");
+		sr_run_field = 0;
+		sr_need_comma = false;
+	}
+	while (fields < SR_FIELDS_PER_PASS) {
+		srDescriptor_t *d = &sr_desc[sr_run_field];
+		if ((sr_run_field >= CMD_STATUS_REPORT_LEN) || (d->index == 0) ||
+			(sr_out_p >= sr_out_buf + sizeof(sr_out_buf) - SR_OUT_BUF_MARGIN)) {
+			// frame is complete (or full) - close it and hand it to TX
+			if (xio_tx_pri_empty_usb() == false) {
+				return (STAT_NOOP);				// hold the finished frame until TX drains
+			}
+			*sr_out_p++ = '}';					// close the sr child object
+			if ((qr.request == true) && (cfg.queue_report_verbosity == QR_VERBOSE)) {
+				sr_out_p += sprintf(sr_out_p, ",\"qr\":%d", qr.buffers_available);
+				qr.request = false;				// the queue report rides in this frame
+			}
+			sr_out_p += sprintf(sr_out_p, "}\n");
+			xio_write_stream_pri(stderr, sr_out_buf, sr_out_p - sr_out_buf);
+			sr_run_field = -1;
+			if (++sr_slow_phase >= SR_SLOW_EVERY_N) { sr_slow_phase = 0;}
+			cm.status_report_request = SR_NO_REQUEST;
+			return (STAT_OK);
+		}
+		sr_run_field++;
+		if ((d->slow == true) && (sr_slow_phase != 0)) { continue;}	// off-phase slow class field
+		memset(&cmd, 0, sizeof(cmd));			// scratch object - no body list involved
+		cmd.index = d->index;
+		d->get(&cmd);							// populate value, objtype and precision
+		if (sr_need_comma == true) { *sr_out_p++ = ',';}
+		sr_need_comma = true;
+		sr_out_p += sprintf(sr_out_p, "\"%s\":", d->token);
+		sr_out_p = js_serialize_value(&cmd, sr_out_p);
+		fields++;
+	}
+	return (STAT_EAGAIN);						// more fields remain - resume next pass
+}
+
+/*
+ * _append_queue_report_to_list() - fold a pending queue report into an SR frame
+ *
+ *	During streaming a status report and a queue report are often pending in
+ *	the same controller pass, and each frame pays its own header, footer and
+ *	checksum on the TX path. When the status report is about to print and a
+ *	QR_VERBOSE queue report is pending, the qr value is appended to the cmd
+ *	list as a sibling of the "sr" object - one frame, e.g.
+ *	{"sr":{...},"qr":28} - and the separate queue report is consumed.
+ *	QR_TRIPLE reports carry an array value the cmd list can't express, so
+ *	they keep their own frame. Returns true if the qr was folded in.
+ */
+static uint8_t _append_queue_report_to_list()
+{
+	if ((qr.request == false) || (cfg.queue_report_verbosity != QR_VERBOSE)) { return (false);}
+
+	cmdObj_t *cmd = cmd_body;					// the "sr" parent object
+	while ((cmd->nx != NULL) && (cmd->nx->objtype != TYPE_EMPTY)) { cmd = cmd->nx;}
+	if (cmd->nx == NULL) { return (false);}		// no free object to append to
+	cmd = cmd->nx;
+	cmd->objtype = TYPE_INTEGER;
+	cmd->value = qr.buffers_available;
+	cmd->depth = cmd_body->depth;				// sibling of "sr", not a child
+	strcpy(cmd->token, "qr");
+	qr.request = false;							// the queue report rides in this frame
+	return (true);
+}
+
+uint8_t rpt_queue_report_callback()
+{
+	if (qr.request == false) { return (STAT_NOOP);}
+
+	// The status report callback runs ahead of this one and folds a pending
+	// queue report into its own frame (see _append_queue_report_to_list());
+	// hold off here when a status report is imminent so it gets the chance
+	if ((cfg.queue_report_verbosity == QR_VERBOSE) &&
+		(cm.status_report_request == SR_IMMEDIATE_REQUEST) &&
+		((cfg.status_report_verbosity == SR_FILTERED) || (cfg.status_report_verbosity == SR_VERBOSE))) {
+		return (STAT_NOOP);
+	}
+	// Queue reports are discardable too - hold back rather than sleeping in
+	// the priority write (see the same test in rpt_status_report_callback())
+	if (xio_tx_pri_empty_usb() == false) { return (STAT_NOOP);}
+	qr.request = false;
+
+	tg.out_buf[0] = NUL;
+	if (cfg.comm_mode == TEXT_MODE) {
+		if (cfg.queue_report_verbosity == QR_VERBOSE) {
+			sprintf(tg.out_buf, "qr:%d\n", qr.buffers_available);
+		} else  if (cfg.queue_report_verbosity == QR_TRIPLE) {
+			sprintf(tg.out_buf, "qr:%d,added:%d,removed:%d,starved:%d,lowater:%d\n", qr.buffers_available,
+				qr.buffers_added,qr.buffers_removed, qr.starvation_count, qr.lo_water_mark);
+		}
+	} else {
+		if (cfg.queue_report_verbosity == QR_VERBOSE) {
+			sprintf(tg.out_buf, "{\"qr\":%d}\n", qr.buffers_available);
+		} else  if (cfg.queue_report_verbosity == QR_TRIPLE) {
+			sprintf(tg.out_buf, "{\"qr\":[%d,%d,%d,%d,%d]}\n", qr.buffers_available,
+				qr.buffers_added,qr.buffers_removed, qr.starvation_count, qr.lo_water_mark);
+			rpt_clear_queue_report();
+		}
+	}
+	if (tg.out_buf[0] != NUL) {				// priority write - queue reports pace the sender
+		xio_write_stream_pri(stderr, tg.out_buf, strlen(tg.out_buf));
+	}
+	return (STAT_OK);
+
+/*
+	// get a clean cmd object
+//	cmdObj_t *cmd = cmd_reset_list();		// normally you do a list reset but the following is more time efficient
+	cmdObj_t *cmd = cmd_body;
+	cmd_reset_obj(cmd);
+	cmd->nx = NULL;							// terminate the list
+
+	// make a qr object and print it
+	sprintf_P(cmd->token, PSTR("qr"));
+	cmd->value = qr.buffers_available;
+	cmd->objtype = TYPE_INTEGER;
+	cmd_print_list(STAT_OK, TEXT_INLINE_PAIRS, JSON_OBJECT_FORMAT);
+	return (STAT_OK);
+*/
+}
+
+/****************************************************************************
+ ***** Report Unit Tests ****************************************************
+ ****************************************************************************/
+
+#ifdef __UNIT_TESTS
+#ifdef __UNIT_TEST_REPORT
+
+void sr_unit_tests(void)
+{
+	sr_init();
+	tg.communications_mode = STAT_JSON_MODE;
+	sr_run_status_report();
+}
+
+#endif
+#endif
@@ -28,6 +28,7 @@
 #include <avr/io.h>
 #include <math.h>
 #include "tinyg.h"
+#include "util.h"
 #include "gpio.h"
 #include "gcode_parser.h"
 #include "canonical_machine.h"
@@ -36,9 +37,18 @@
 #include "system.h"
 #include "config.h"
 #include "pwm.h"
+#include "xmega/xmega_rtc.h"	// load control timing
 
 static void _exec_spindle_control(uint8_t spindle_mode, float f);
 static void _exec_spindle_speed(uint8_t i, float speed);
+static void _exec_raster_mode(uint8_t on, float f);
+#ifdef __SPINDLE_LOAD_CONTROL
+static void _load_init(void);
+#endif
+#ifdef __SPINDLE_TACH
+static void _tach_init(void);
+static void _tach_set_threshold(void);
+#endif
 
 /* 
  * sp_init()
@@ -50,6 +60,13 @@ void sp_init()
     
     pwm_set_freq(PWM_1, cfg.p.frequency);
     pwm_set_duty(PWM_1, cfg.p.phase_off);
+
+#ifdef __SPINDLE_LOAD_CONTROL
+	_load_init();
+#endif
+#ifdef __SPINDLE_TACH
+	_tach_init();
+#endif
 }
 
 /*
@@ -90,6 +107,11 @@ float cm_get_spindle_pwm( uint8_t spindle_mode )
 
 stat_t cm_spindle_control(uint8_t spindle_mode)
 {
+	if ((spindle_mode == SPINDLE_CW) || (spindle_mode == SPINDLE_CCW)) {
+		cm_begin_spindle_ramp();		// model the VFD spin-up - see canonical_machine.c
+	} else {
+		cm.spindle_ramp_ms = 0;			// M5 - nothing to wait for
+	}
 	mp_queue_command(_exec_spindle_control, spindle_mode, 0);
 	return(STAT_OK);
 }
@@ -97,6 +119,9 @@ stat_t cm_spindle_control(uint8_t spindle_mode)
 static void _exec_spindle_control(uint8_t spindle_mode, float f)
 {
 	cm_set_spindle_mode(spindle_mode);
+#ifdef __SPINDLE_TACH
+	_tach_set_threshold();
+#endif
  	if (spindle_mode == SPINDLE_CW) {
 		gpio_set_bit_on(SPINDLE_BIT);
 		gpio_set_bit_off(SPINDLE_DIR);
@@ -108,6 +133,15 @@ static void _exec_spindle_control(uint8_t spindle_mode, float f)
 	}
     
     // PWM spindle control
+	if (cfg.p.ppi > 0) {				// PPI laser mode owns the channel (see pwm.c)
+		if ((spindle_mode == SPINDLE_CW) || (spindle_mode == SPINDLE_CCW)) {
+			pwm_ppi_enable();
+		} else {
+			pwm_ppi_disable();			// restores the base frequency
+			pwm_set_duty(PWM_1, cm_get_spindle_pwm(spindle_mode));
+		}
+		return;
+	}
     pwm_set_duty(PWM_1, cm_get_spindle_pwm(spindle_mode) );
 }
 
@@ -133,7 +167,208 @@ void cm_exec_spindle_speed(float speed)
 static void _exec_spindle_speed(uint8_t i, float speed)
 {
 	cm_set_spindle_speed_parameter(speed);
-	pwm_set_duty(PWM_1, cm_get_spindle_pwm(gm.spindle_mode) ); // update spindle speed if we're running
+	if (cfg.p.ppi == 0) {				// in PPI mode energy per pulse is the width, not S
+		pwm_set_duty(PWM_1, cm_get_spindle_pwm(gm.spindle_mode) ); // update spindle speed if we're running
+	}
+#ifdef __SPINDLE_TACH
+	_tach_set_threshold();
+#endif
+}
+
+/*
+ * cm_raster_mode() - queue raster mode entry/exit to the planner buffer
+ * _exec_raster_mode() - execute the mode change (called from planner)
+ *
+ *	Raster mode hands the PWM channel to the per-segment intensity stream
+ *	(see raster mode notes in pwm.c). Entry and exit are queued like the
+ *	other spindle commands so they synchronize with motion - exit restores
+ *	the PWM to the modeled spindle state.
+ */
+
+stat_t cm_raster_mode(uint8_t on)
+{
+	mp_queue_command(_exec_raster_mode, on, 0);
+	return (STAT_OK);
+}
+
+static void _exec_raster_mode(uint8_t on, float f)
+{
+	if (on == true) {
+		pwm_raster_enable();
+	} else {
+		pwm_raster_disable();
+		pwm_set_duty(PWM_1, cm_get_spindle_pwm(gm.spindle_mode));
+	}
 }
 
+/**** Load-adaptive feed override ********************************************
+ *
+ *	Conservative feeds exist because the worst-case cut dictates the whole
+ *	program. With a current sensor on the spindle supply wired to ADCA
+ *	channel 0 (PA0) the controller can read the actual cut load and trim
+ *	the real-time feed override to hold it at a setpoint - the machine
+ *	runs at the feed the material permits, not the feed the worst pass of
+ *	the program permits.
+ *
+ *	sp_load_callback() runs from the controller loop. Completed ADC
+ *	conversions are folded into a single-pole filter every pass (and the
+ *	next conversion started - the callback never waits on the ADC). Every
+ *	SP_LOAD_PERIOD_TICKS the filtered load drives one bounded integral
+ *	step on the override factor:
+ *
+ *		factor += $slg * ($slt - load) * dt
+ *
+ *	which goes to mp_feed_rate_override() - the same queue-replan path the
+ *	M50.1 pendant events use, and well within its 10-50 Hz event budget.
+ *	The factor is clamped to the planner's override limits, so a stalled
+ *	sensor can neither stop the machine nor run it away; the per-event
+ *	ramp in the planner bounds how fast the running move can change.
+ *
+ *	Control only engages while a machining cycle is running with the
+ *	spindle on and feed override enabled (M48); otherwise the factor
+ *	tracks the programmed override so control re-engages bumplessly.
+ *	$slt=0 disables the whole loop. The filtered load is published in
+ *	$sll (as a fraction of sensor full scale) for commissioning.
+ */
+#ifdef __SPINDLE_LOAD_CONTROL
+
+#define SP_LOAD_PERIOD_TICKS (50 / RTC_MILLISECONDS)	// control period (20 Hz)
+#define SP_LOAD_FILTER ((float)0.2)		// filter weight given to each new sample
+#define SP_LOAD_FULL_SCALE 4095			// 12 bit unsigned conversions
+
+static struct spLoadSingleton {
+	uint8_t sampling;					// a conversion is in flight
+	float load;							// filtered load (0-1 of sensor full scale)
+	float factor;						// override factor currently commanded
+	uint32_t next_event;				// RTC tick deadline for the next control step
+} sld;
+
+static void _load_init(void)
+{
+	ADCA.CTRLB = ADC_RESOLUTION_12BIT_gc;
+	ADCA.REFCTRL = ADC_REFSEL_VCC_gc;					// Vcc/1.6 reference
+	ADCA.PRESCALER = ADC_PRESCALER_DIV128_gc;
+	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_SINGLEENDED_gc;
+	ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN0_gc;			// sensor input on PA0
+	ADCA.CTRLA = ADC_ENABLE_bm;
+	sld.factor = 1;
+}
+
+stat_t sp_load_callback(void)
+{
+	if (cfg.spindle_load_target < EPSILON) { return (STAT_NOOP);}	// $slt=0 - disabled
+
+	// fold a completed conversion into the filter and start the next one
+	if (sld.sampling == false) {
+		ADCA.CH0.CTRL |= ADC_CH_START_bm;
+		sld.sampling = true;
+		return (STAT_NOOP);
+	}
+	if ((ADCA.CH0.INTFLAGS & ADC_CH_CHIF_bm) == 0) { return (STAT_NOOP);}
+	ADCA.CH0.INTFLAGS = ADC_CH_CHIF_bm;					// written 1 to clear
+	float sample = (float)ADCA.CH0.RES / SP_LOAD_FULL_SCALE;
+	sld.load += SP_LOAD_FILTER * (sample - sld.load);
+	cfg.spindle_load_level = sld.load;					// published as $sll
+	sld.sampling = false;
+
+	if (rtc.clock_ticks < sld.next_event) { return (STAT_NOOP);}
+	sld.next_event = rtc.clock_ticks + SP_LOAD_PERIOD_TICKS;
+
+	if ((cm.machine_state != MACHINE_CYCLE) || (cm.cycle_state != CYCLE_MACHINING) ||
+		(gm.spindle_mode == SPINDLE_OFF) || (gm.feed_rate_override_enable == false)) {
+		sld.factor = gm.feed_rate_override_factor;		// track the knob - re-engage bumplessly
+		return (STAT_NOOP);
+	}
+	float dt = (float)SP_LOAD_PERIOD_TICKS * RTC_MILLISECONDS / 1000;
+	sld.factor += cfg.spindle_load_gain * (cfg.spindle_load_target - sld.load) * dt;
+	sld.factor = max(sld.factor, FEED_OVERRIDE_MIN_FACTOR);
+	sld.factor = min(sld.factor, FEED_OVERRIDE_MAX_FACTOR);
+	return (mp_feed_rate_override(true, sld.factor));
+}
+
+#else
+
+stat_t sp_load_callback(void) { return (STAT_NOOP);}
+
+#endif // __SPINDLE_LOAD_CONTROL
+
+/**** Tachometer at-speed detection ******************************************
+ *
+ *	The modeled VFD spin-up (see cm_spindle_ramp_wait) always waits out the
+ *	worst-case $p1sut. With a one pulse/rev tach on PA2 the spin-up balance
+ *	dwell instead ends the moment the spindle measures at speed - the
+ *	modeled time becomes the ceiling, not the wait.
+ *
+ *	The pulse is routed through event channel 1 to TIMER_TACH in frequency
+ *	capture mode, so the hardware restarts the counter and latches the
+ *	period in CCA on every rev - zero per-pulse CPU cost. At DIV256 the
+ *	capture resolves 115 rpm to well past any spindle's redline with <1%
+ *	error at 24,000 rpm. RPM is period-reciprocal: rpm = ticks/min / CCA.
+ *
+ *	sp_spindle_at_speed() runs in the dwell countdown at RTC interrupt
+ *	level (see st_dwell_rtc_callback), so the at-speed test is an integer
+ *	compare against a threshold period pre-computed when the M3/M4 or S
+ *	executes: at-speed means period <= ticks/min / (fraction x S). A
+ *	counter overflow means no pulse for a full wrap (stalled or below the
+ *	measurable floor) and reads as not-at-speed, so a broken tach degrades
+ *	to the full modeled dwell rather than an early release.
+ *
+ *	TIMER_TACH shares TIMER_5 - enable only one TIMER_5 feature at a time
+ *	(see system.h).
+ */
+#ifdef __SPINDLE_TACH
+
+#define SP_TACH_TICKS_PER_MIN (((float)F_CPU / 256) * 60)	// capture clock is DIV256
+#define SP_TACH_AT_SPEED_FRACTION ((float)0.95)	// fraction of S counted as at-speed
+
+static struct spTachSingleton {
+	volatile uint16_t period;		// last captured rev period in capture ticks
+	volatile uint16_t threshold;	// at-speed period ceiling - 0 disables the release
+} tach;
+
+static void _tach_init(void)
+{
+	PORTA.DIRCLR = (1<<2);								// tach pulse input on PA2
+	PORTA.PIN2CTRL = PORT_ISC_RISING_gc;
+	EVSYS.CH1MUX = EVSYS_CHMUX_PORTA_PIN2_gc;
+	EVSYS.CH1CTRL = EVSYS_DIGFILT_2SAMPLES_gc;
+	TIMER_TACH.CTRLB = TC1_CCAEN_bm;
+	TIMER_TACH.CTRLD = (TC_EVACT_FRQ_gc | TC_EVSEL_CH1_gc);
+	TIMER_TACH.PER = 0xFFFF;
+	TIMER_TACH.CTRLA = TC_CLKSEL_DIV256_gc;
+}
+
+static void _tach_set_threshold(void)	// runs at planner exec level with the M3/M4 or S
+{
+	if (((gm.spindle_mode == SPINDLE_CW) || (gm.spindle_mode == SPINDLE_CCW)) &&
+		(gm.spindle_speed > EPSILON)) {
+		float period = SP_TACH_TICKS_PER_MIN / (SP_TACH_AT_SPEED_FRACTION * gm.spindle_speed);
+		tach.threshold = (uint16_t)min(period, 65535);
+	} else {
+		tach.threshold = 0;								// M5 or S0 - never at-speed
+	}
+}
+
+uint8_t sp_spindle_at_speed(void)		// runs at RTC interrupt level - integer math only
+{
+	if ((TIMER_TACH.INTFLAGS & TC1_OVFIF_bm) != 0) {	// no pulse for a full counter wrap
+		TIMER_TACH.INTFLAGS = (TC1_OVFIF_bm | TC1_CCAIF_bm);	// written 1 to clear
+		tach.period = 0xFFFF;
+		return (false);
+	}
+	if ((TIMER_TACH.INTFLAGS & TC1_CCAIF_bm) != 0) {
+		tach.period = TIMER_TACH.CCA;					// reading CCA clears CCAIF
+	}
+	if (tach.threshold == 0) { return (false);}
+	return (tach.period <= tach.threshold);
+}
+
+float sp_tach_rpm(void)					// measured spindle speed for diagnostics
+{
+	if (tach.period == 0) { return (0);}
+	return (SP_TACH_TICKS_PER_MIN / tach.period);
+}
+
+#endif // __SPINDLE_TACH
+
 
@@ -1,9 +1,9 @@
-/*
- * spindle.h - spindle driver
- * Part of TinyG project
+/*
+ * spindle.h - spindle driver
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2012 Alden S. Hart Jr.
  *
- * Copyright (c) 2010 - 2012 Alden S. Hart Jr.
- *
  * This file ("the software") is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License, version 2 as published by the
  * Free Software Foundation. You should have received a copy of the GNU General Public
@@ -23,10 +23,10 @@
  * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
  * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#ifndef spindle_h
-#define spindle_h 
+ */
+
+#ifndef spindle_h
+#define spindle_h 
 
 /*
  * Global Scope Functions
@@ -37,5 +37,11 @@ stat_t cm_spindle_control(uint8_t spindle_mode);
 void cm_exec_spindle_control(uint8_t spindle_mode);
 stat_t cm_set_spindle_speed(float speed);
 void cm_exec_spindle_speed(float speed);
-
-#endif
+stat_t cm_raster_mode(uint8_t on);
+stat_t sp_load_callback(void);		// spindle current sensing trims the feed override
+#ifdef __SPINDLE_TACH
+uint8_t sp_spindle_at_speed(void);	// measured rpm has reached the at-speed threshold
+float sp_tach_rpm(void);			// measured spindle speed for diagnostics
+#endif
+
+#endif
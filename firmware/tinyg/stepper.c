@@ -1,705 +1,1424 @@
-/*
- * stepper.c - stepper motor controls
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* 	This module provides the low-level stepper drivers and some related
- * 	functions. It dequeues lines queued by the motor_queue routines.
- * 	This is some of the most heavily optimized code in the project.
- *
- *	Note that if you want to use this for something other than TinyG
- *	you may need to stretch the step pulses. They run about 1 uSec 
- *	which is fine for the TI DRV8811/DRV8818 chips in TinyG but may 
- *	not suffice for other stepper driver hardware.
- */
-
-/**** Line planning and execution ****
- *
- *	Move planning, execution and pulse generation takes place at 3 levels:
- *
- *	Move planning occurs in the main-loop. The canonical machine calls the
- *	planner to generate lines, arcs, dwells and synchronous stop/starts.
- *	The planner module generates blocks (bf's) that hold parameters for 
- *	lines and the other move types. The blocks are backplanned to join 
- *	lines, and to take dwells and stops into account. ("plan" stage).
- *
- *	Arc movement is planned above the above the line planner. The arc 
- *	planner generates short lines that are passed to the line planner.
- *
- *	Move execution and load prep takes place at the LOW interrupt level. 
- *	Move execution generates the next acceleration, cruise, or deceleration
- *	segment for planned lines, or just transfers parameters needed for 
- *	dwells and stops. This layer also prepares moves for loading by 
- *	pre-calculating the values needed by the DDA, and converting the 
- *	executed move into parameters that can be directly loaded into the 
- *	steppers ("exec" and "prep" stages).
- *
- *	Pulse train generation takes place at the HI interrupt level. 
- *	The stepper DDA fires timer interrupts that generate the stepper pulses. 
- *	This level also transfers new stepper parameters once each pulse train
- *	("segment") is complete ("load" and "run" stages). 
- */
-/* 	What happens when the pulse generator is done with the current pulse train 
- *	(segment) is a multi-stage "pull" queue that looks like this:
- *
- *	As long as the steppers are running the sequence of events is:
- *	  - The stepper interrupt (HI) runs the DDA to generate a pulse train
- *	  	  for the current move. This runs for the length of the pulse train
- *		  currently executing - the "segment", usually 5ms worth of pulses
- *
- *	  - When the current segment is finished the stepper interrupt LOADs the next 
- *		  segment from the prep buffer, reloads the timers, and starts the 
- *		  next segment. At the end of the load the stepper interrupt routine
- *		  requests an "exec" of the next move in order to prepare for the 
- *		  next load operation. It does this by calling the exec using a 
- *		  software interrupt (actually a timer, since that's all we've got).
- *
- *	  - As a result of the above, the EXEC handler fires at the LO interrupt 
- *		  level. It computes the next accel/decel segment for the current move 
- *		  (i.e. the move in the planner's runtime buffer) by calling back to 
- *		  the exec routine in planner.c. Or it gets and runs the next buffer 
- *		  in the planning queue - depending on the move_type and state. 
- *
- *	  - Once the segment has been computed the exec handler finshes up by running 
- *		  the PREP routine in stepper.c. This computes the DDA values and gets 
- *		  the segment into the prep buffer - and ready for the next LOAD operation.
- *
- *	  - The main loop runs in background to receive gcode blocks, parse them,
- *		  and send them to the planner in order to keep the planner queue 
- *		  full so that when the planner's runtime buffer completes the next move
- *		  (a gcode block or perhaps an arc segment) is ready to run.
- *
- *	If the steppers are not running the above is similar, except that the exec
- * 	is invoked from the main loop by the software interrupt, and the stepper 
- *	load is invoked from the exec by another software interrupt.
- */
-/*	Control flow can be a bit confusing. This is a typical sequence for planning 
- *	executing, and running an acceleration planned line:
- *
- *	 1  planner.mp_aline() is called, which populates a planning buffer (bf) 
- *		and back-plans any pre-existing buffers.
- *
- *	 2  When a new buffer is added _mp_queue_write_buffer() tries to invoke
- *	    execution of the move by calling stepper.st_request_exec_move(). 
- *
- *	 3a If the steppers are running this request is ignored.
- *	 3b If the steppers are not running this will set a timer to cause an 
- *		EXEC "software interrupt" that will ultimately call st_exec_move().
- *
- *   4  At this point a call to _exec_move() is made, either by the 
- *		software interrupt from 3b, or once the steppers finish running 
- *		the current segment and have loaded the next segment. In either 
- *		case the call is initated via the EXEC software interrupt which 
- *		causes _exec_move() to run at the MEDium interupt level.
- *		 
- *	 5	_exec_move() calls back to planner.mp_exec_move() which generates 
- *		the next segment using the mr singleton.
- *
- *	 6	When this operation is complete mp_exec_move() calls the appropriate
- *		PREP routine in stepper.c to derive the stepper parameters that will 
- *		be needed to run the move - in this example st_prep_line().
- *
- *	 7	st_prep_line() generates the timer and DDA values and stages these into 
- *		the prep structure (sp) - ready for loading into the stepper runtime struct
- *
- *	 8	stepper.st_prep_line() returns back to planner.mp_exec_move(), which 
- *		frees the planning buffer (bf) back to the planner buffer pool if the 
- *		move is complete. This is done by calling _mp_request_finalize_run_buffer()
- *
- *	 9	At this point the MED interrupt is complete, but the planning buffer has 
- *		not actually been returned to the pool yet. The buffer will be returned
- *		by the main-loop prior to testing for an available write buffer in order
- *		to receive the next Gcode block. This handoff prevents possible data 
- *		conflicts between the interrupt and main loop.
- *
- *	10	The final step in the sequence is _load_move() requesting the next 
- *		segment to be executed and prepared by calling st_request_exec() 
- *		- control goes back to step 4.
- *
- *	Note: For this to work you have to be really careful about what structures
- *	are modified at what level, and use volatiles where necessary.
- */
-/* Partial steps and phase angle compensation
- *
- *	The DDA accepts partial steps as input. Fractional steps are managed by the 
- *	sub-step value as explained elsewhere. The fraction initially loaded into 
- *	the DDA and the remainder left at the end of a move (the "residual") can
- *	be thought of as a phase angle value for the DDA accumulation. Each 360
- *	degrees of phase angle results in a step being generated. 
- */
-
-#include <stdlib.h>
-#include <string.h>				// needed for memset in st_init()
-#include <math.h>				// isinfinite()
-#include <stdio.h>				// precursor for xio.h
-#include <avr/pgmspace.h>		// precursor for xio.h
-#include <avr/interrupt.h>
-#include <avr/io.h>
-
-#include "tinyg.h"
-#include "util.h"
-#include "system.h"
-#include "config.h"
-#include "stepper.h" 	
-#include "planner.h"
-#include "xmega/xmega_rtc.h"
-
-static void _exec_move(void);
-static void _load_move(void);
-static void _request_load_move(void);
-
-/*
- * Stepper structures
- *
- *	There are 4 sets of structures involved in this operation;
- *
- *	data structure:						static to:		runs at:
- *	  mpBuffer planning buffers (bf)	  planner.c		  main loop
- *	  mrRuntimeSingleton (mr)			  planner.c		  MED ISR
- *	  stPrepSingleton (sp)				  stepper.c		  MED ISR
- *	  stRunSingleton (st)				  stepper.c		  HI ISR
- *  
- *	Care has been taken to isolate actions on these structures to the 
- *	execution level in which they run and to use the minimum number of 
- *	volatiles in these structures. This allows the compiler to optimize
- *	the stepper inner-loops better.
- */
-
-// Runtime structs. Used exclusively by step generation ISR (HI)
-typedef struct stRunMotor { 		// one per controlled motor
-	int32_t phase_increment;		// total steps in axis times substeps factor
-	int32_t phase_accumulator;		// DDA phase angle accumulator for axis
-	uint8_t polarity;				// 0=normal polarity, 1=reverse motor polarity
-} stRunMotor_t;
-
-typedef struct stRunSingleton {		// Stepper static values and axis parameters
-	uint16_t magic_start;			// magic number to test memory integity	
-	int32_t dda_ticks_downcount;	// tick down-counter (unscaled)
-	int32_t dda_ticks_X_substeps;	// ticks multiplied by scaling factor
-	stRunMotor_t m[MOTORS];			// runtime motor structures
-} stRunSingleton_t;
-
-// Prep-time structs. Used by exec/prep ISR (MED) and read-only during load 
-// Must be careful about volatiles in this one
-
-enum prepBufferState {
-	PREP_BUFFER_OWNED_BY_LOADER = 0,// staging buffer is ready for load
-	PREP_BUFFER_OWNED_BY_EXEC		// staging buffer is being loaded
-};
-
-typedef struct stPrepMotor {
- 	uint32_t phase_increment; 		// total steps in axis times substep factor
-	int8_t dir;						// b0 = direction
-} stPrepMotor_t;
-
-typedef struct stPrepSingleton {
-	uint16_t magic_start;			// magic number to test memory integity	
-	uint8_t move_type;				// move type
-	uint8_t prep_state;				// set TRUE to load, false to skip
-	volatile uint8_t exec_state;	// move execution state 
-	volatile uint8_t reset_flag;	// TRUE if accumulator should be reset
-	uint32_t prev_ticks;			// tick count from previous move
-	uint16_t dda_period;			// DDA or dwell clock period setting
-	uint32_t dda_ticks;				// DDA or dwell ticks for the move
-	uint32_t dda_ticks_X_substeps;	// DDA ticks scaled by substep factor
-//	float segment_velocity;			// +++++ record segment velocity for diagnostics
-	stPrepMotor_t m[MOTORS];		// per-motor structs
-} stPrepSingleton_t;
-
-// Allocate static structures
-static stRunSingleton_t st;
-static struct stPrepSingleton sps;
-
-uint16_t st_get_st_magic() { return (st.magic_start);}
-uint16_t st_get_sps_magic() { return (sps.magic_start);}
-
-/* 
- * st_init() - initialize stepper motor subsystem 
- *
- *	Notes:
- *	  - This init requires sys_init() to be run beforehand
- *		This init is a precursor for gpio_init()
- * 	  - microsteps are setup during cfg_init()
- *	  - motor polarity is setup during cfg_init()
- *	  - high level interrupts must be enabled in main() once all inits are complete
- */
-
-void st_init()
-{
-//	You can assume all values are zeroed. If not, use this:
-//	memset(&st, 0, sizeof(st));	// clear all values, pointers and status
-
-	st.magic_start = MAGICNUM;
-	sps.magic_start = MAGICNUM;
-
-	// Configure virtual ports
-	PORTCFG.VPCTRLA = PORTCFG_VP0MAP_PORT_MOTOR_1_gc | PORTCFG_VP1MAP_PORT_MOTOR_2_gc;
-	PORTCFG.VPCTRLB = PORTCFG_VP2MAP_PORT_MOTOR_3_gc | PORTCFG_VP3MAP_PORT_MOTOR_4_gc;
-
-	// setup ports
-	for (uint8_t i=0; i<MOTORS; i++) {
-		device.st_port[i]->DIR = MOTOR_PORT_DIR_gm;  // sets outputs for motors & GPIO1, and GPIO2 inputs
-		device.st_port[i]->OUT = MOTOR_ENABLE_BIT_bm;// zero port bits AND disable motor
-	}
-	// setup DDA timer
-	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
-	TIMER_DDA.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
-	TIMER_DDA.INTCTRLA = TIMER_DDA_INTLVL;		// interrupt mode
-
-	// setup DWELL timer
-	TIMER_DWELL.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
-	TIMER_DWELL.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
-	TIMER_DWELL.INTCTRLA = TIMER_DWELL_INTLVL;	// interrupt mode
-
-	// setup software interrupt load timer
-	TIMER_LOAD.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
-	TIMER_LOAD.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
-	TIMER_LOAD.INTCTRLA = TIMER_LOAD_INTLVL;	// interrupt mode
-	TIMER_LOAD.PER = SWI_PERIOD;				// set period
-
-	// setup software interrupt exec timer
-	TIMER_EXEC.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
-	TIMER_EXEC.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
-	TIMER_EXEC.INTCTRLA = TIMER_EXEC_INTLVL;	// interrupt mode
-	TIMER_EXEC.PER = SWI_PERIOD;				// set period
-
-	sps.exec_state = PREP_BUFFER_OWNED_BY_EXEC;
-}
-
-/* 
- * st_enable_motor()  - enable a motor
- * st_enable_motors() - enable all motors with $pm set to 0
- * st_disable_motor() - disable a motor
- * st_disable_motors()- disable all motors
- * st_start_disable_motors_timeout()
- * st_disable_motors_rtc_callback()
- * st_kill_motors()   - stop the steppers. Requires re-init to recover
- */
-void st_enable_motor(const uint8_t motor)
-{
-	if (motor == MOTOR_1) { PORT_MOTOR_1_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_2) { PORT_MOTOR_2_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_3) { PORT_MOTOR_3_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_4) { PORT_MOTOR_4_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
-}
-
-void st_enable_motors()
-{
-	if (cfg.m[MOTOR_1].power_mode == 0) { st_enable_motor(MOTOR_1);}
-	if (cfg.m[MOTOR_2].power_mode == 0) { st_enable_motor(MOTOR_2);}
-	if (cfg.m[MOTOR_3].power_mode == 0) { st_enable_motor(MOTOR_3);}
-	if (cfg.m[MOTOR_4].power_mode == 0) { st_enable_motor(MOTOR_4);}
-	st_start_disable_motors_timer();
-}
-
-void st_disable_motor(const uint8_t motor)
-{
-	if (motor == MOTOR_1) { PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_2) { PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_3) { PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
-	if (motor == MOTOR_4) { PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
-}
-
-void st_disable_motors()
-{
-	st_disable_motor(MOTOR_1);
-	st_disable_motor(MOTOR_2);
-	st_disable_motor(MOTOR_3);
-	st_disable_motor(MOTOR_4);
-}
-
-void st_start_disable_motors_timer()	// reset timeout interval
-{
-	cfg.motor_disable_timer = cfg.motor_disable_timeout * (1000 / RTC_MILLISECONDS);
-}
-
-void st_disable_motors_rtc_callback() 		// called by 10ms real-time clock
-{
-	if (--cfg.motor_disable_timer == 0) { st_disable_motors(); }
-}
-
-void st_kill_motors()
-{
-	for (uint8_t i=0; i<MOTORS; i++) {
-		device.st_port[i]->DIR = MOTOR_PORT_DIR_gm;  // sets outputs for motors & GPIO1, and GPIO2 inputs
-		device.st_port[i]->OUT = MOTOR_ENABLE_BIT_bm;// zero port bits AND disable motor
-	}
-	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;			// turn timer off
-}
-
-/*
- * ISRs
- * ISR - DDA timer interrupt routine - service ticks from DDA timer
- *
- *	The step bit pulse width is ~1 uSec, which is OK for the TI DRV8811's.
- *	If you need to stretch the pulse I recommend moving the port OUTCLRs
- *	to the end of the routine. If you need more time than that use a 
- *	pulse OFF timer like grbl does so as not to spend any more time in 
- *	the ISR, which would limit the upper range of the DDA frequency.
- *
- *	Uses direct struct addresses and literal values for hardware devices -
- *	it's faster than using indexed timer and port accesses. I checked.
- *	Even when -0s or -03 is used.
- */
-
-ISR(TIMER_DDA_ISR_vect)
-{
-	if ((st.m[MOTOR_1].phase_accumulator += st.m[MOTOR_1].phase_increment) > 0) {
-		PORT_MOTOR_1_VPORT.OUT |= STEP_BIT_bm;	// turn step bit on
- 		st.m[MOTOR_1].phase_accumulator -= st.dda_ticks_X_substeps;
-		PORT_MOTOR_1_VPORT.OUT &= ~STEP_BIT_bm;	// turn step bit off in ~1 uSec
-	}
-	if ((st.m[MOTOR_2].phase_accumulator += st.m[MOTOR_2].phase_increment) > 0) {
-		PORT_MOTOR_2_VPORT.OUT |= STEP_BIT_bm;
- 		st.m[MOTOR_2].phase_accumulator -= st.dda_ticks_X_substeps;
-		PORT_MOTOR_2_VPORT.OUT &= ~STEP_BIT_bm;
-	}
-	if ((st.m[MOTOR_3].phase_accumulator += st.m[MOTOR_3].phase_increment) > 0) {
-		PORT_MOTOR_3_VPORT.OUT |= STEP_BIT_bm;
- 		st.m[MOTOR_3].phase_accumulator -= st.dda_ticks_X_substeps;
-		PORT_MOTOR_3_VPORT.OUT &= ~STEP_BIT_bm;
-	}
-	if ((st.m[MOTOR_4].phase_accumulator += st.m[MOTOR_4].phase_increment) > 0) {
-		PORT_MOTOR_4_VPORT.OUT |= STEP_BIT_bm;
- 		st.m[MOTOR_4].phase_accumulator -= st.dda_ticks_X_substeps;
-		PORT_MOTOR_4_VPORT.OUT &= ~STEP_BIT_bm;
-	}
-	if (--st.dda_ticks_downcount == 0) {		// end move
- 		TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;	// disable DDA timer
-		st_start_disable_motors_timer();
-		// power-down motors if this feature is enabled
-		if (cfg.m[MOTOR_1].power_mode == true) PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; // set to 0 to disable
-		if (cfg.m[MOTOR_2].power_mode == true) PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		if (cfg.m[MOTOR_3].power_mode == true) PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		if (cfg.m[MOTOR_4].power_mode == true) PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
-		_load_move();							// load the next move
-	}
-}
-
-ISR(TIMER_DWELL_ISR_vect) {						// DWELL timer interupt
-	if (--st.dda_ticks_downcount == 0) {
- 		TIMER_DWELL.CTRLA = STEP_TIMER_DISABLE;	// disable DWELL timer
-		mp_end_dwell();							// free the planner buffer
-		_load_move();
-	}
-}
-
-ISR(TIMER_LOAD_ISR_vect) {						// load steppers SW interrupt
- 	TIMER_LOAD.CTRLA = STEP_TIMER_DISABLE;		// disable SW interrupt timer
-	_load_move();
-}
-
-ISR(TIMER_EXEC_ISR_vect) {						// exec move SW interrupt
- 	TIMER_EXEC.CTRLA = STEP_TIMER_DISABLE;		// disable SW interrupt timer
-	_exec_move();								// NULL state
-}
-
-/* Software interrupts to fire the above
- * st_test_exec_state()	   - return TRUE if exec/prep can run
- * _request_load_move()    - SW interrupt to request to load a move
- *	st_request_exec_move() - SW interrupt to request to execute a move
- * _exec_move() 		   - Run a move from the planner and prepare it for loading
- *
- *	_exec_move() can only be called be called from an ISR at a level lower
- *	than DDA, Only use st_request_exec_move() to call it.
- */
-
-uint8_t st_test_exec_state()
-{
-	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
-		return (true);
-	}
-	return (false);
-}
-
-void st_request_exec_move()
-{
-	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {	// bother interrupting
-		TIMER_EXEC.PER = SWI_PERIOD;
-		TIMER_EXEC.CTRLA = STEP_TIMER_ENABLE;			// trigger a LO interrupt
-	}
-}
-
-static void _exec_move()
-{
-   	if (sps.exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
-//		if (mp_exec_move(state) != STAT_NOOP) {
-		if (mp_exec_move() != STAT_NOOP) {
-			sps.exec_state = PREP_BUFFER_OWNED_BY_LOADER; // flip it back
-			_request_load_move();
-		}
-	}
-}
-
-static void _request_load_move()
-{
-	if (st.dda_ticks_downcount == 0) {				// bother interrupting
-		TIMER_LOAD.PER = SWI_PERIOD;
-		TIMER_LOAD.CTRLA = STEP_TIMER_ENABLE;			// trigger a HI interrupt
-	} 	// else don't bother to interrupt. You'll just trigger an 
-		// interrupt and find out the load routine is not ready for you
-}
-
-/*
- * _load_move() - Dequeue move and load into stepper struct
- *
- *	This routine can only be called be called from an ISR at the same or 
- *	higher level as the DDA or dwell ISR. A software interrupt has been 
- *	provided to allow a non-ISR to request a load (see st_request_load_move())
- */
-
-void _load_move()
-{
-	if (st.dda_ticks_downcount != 0) return;					// exit if it's still busy
-	if (sps.exec_state != PREP_BUFFER_OWNED_BY_LOADER) return;	// if there are no more moves
-
-	// handle aline loads first (most common case)  NB: there are no more lines, only alines
-	if (sps.move_type == MOVE_TYPE_ALINE) {
-		st.dda_ticks_downcount = sps.dda_ticks;
-		st.dda_ticks_X_substeps = sps.dda_ticks_X_substeps;
-		TIMER_DDA.PER = sps.dda_period;
- 
-		// This section is somewhat optimized for execution speed 
-		// All axes must set steps and compensate for out-of-range pulse phasing. 
-		// If axis has 0 steps the direction setting can be omitted
-		// If axis has 0 steps enabling motors is req'd to support power mode = 1
-
-		st.m[MOTOR_1].phase_increment = sps.m[MOTOR_1].phase_increment;			// set steps
-		if (sps.reset_flag == true) {				// compensate for pulse phasing
-			st.m[MOTOR_1].phase_accumulator = -(st.dda_ticks_downcount);
-		}
-		if (st.m[MOTOR_1].phase_increment != 0) {
-			// For ideal optimizations, only set or clear a bit at a time.
-			if (sps.m[MOTOR_1].dir == 0) {
-				PORT_MOTOR_1_VPORT.OUT &= ~DIRECTION_BIT_bm;// CW motion (bit cleared)
-			} else {
-				PORT_MOTOR_1_VPORT.OUT |= DIRECTION_BIT_bm;	// CCW motion
-			}
-			PORT_MOTOR_1_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;	// enable motor
-		}
-		st.m[MOTOR_2].phase_increment = sps.m[MOTOR_2].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_2].phase_accumulator = -(st.dda_ticks_downcount);
-		}
-		if (st.m[MOTOR_2].phase_increment != 0) {
-			if (sps.m[MOTOR_2].dir == 0) {
-				PORT_MOTOR_2_VPORT.OUT &= ~DIRECTION_BIT_bm;
-			} else {
-				PORT_MOTOR_2_VPORT.OUT |= DIRECTION_BIT_bm;
-			}
-			PORT_MOTOR_2_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
-		}
-		st.m[MOTOR_3].phase_increment = sps.m[MOTOR_3].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_3].phase_accumulator = -(st.dda_ticks_downcount);
-		}
-		if (st.m[MOTOR_3].phase_increment != 0) {
-			if (sps.m[MOTOR_3].dir == 0) {
-				PORT_MOTOR_3_VPORT.OUT &= ~DIRECTION_BIT_bm;
-			} else {
-				PORT_MOTOR_3_VPORT.OUT |= DIRECTION_BIT_bm;
-			}
-			PORT_MOTOR_3_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
-		}
-		st.m[MOTOR_4].phase_increment = sps.m[MOTOR_4].phase_increment;
-		if (sps.reset_flag == true) {
-			st.m[MOTOR_4].phase_accumulator = (st.dda_ticks_downcount);
-		}
-		if (st.m[MOTOR_4].phase_increment != 0) {
-			if (sps.m[MOTOR_4].dir == 0) {
-				PORT_MOTOR_4_VPORT.OUT &= ~DIRECTION_BIT_bm;
-			} else {
-				PORT_MOTOR_4_VPORT.OUT |= DIRECTION_BIT_bm;
-			}
-			PORT_MOTOR_4_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
-		}
-		TIMER_DDA.CTRLA = STEP_TIMER_ENABLE;				// enable the DDA timer
-
-	// handle dwells
-	} else if (sps.move_type == MOVE_TYPE_DWELL) {
-		if (sps.prep_state == true) {
-			st.dda_ticks_downcount = sps.dda_ticks;
-			TIMER_DWELL.PER = sps.dda_period;					// load dwell timer period
- 			TIMER_DWELL.CTRLA = STEP_TIMER_ENABLE;				// enable the dwell timer
-		}
-	}
-
-	// all other cases drop to here (e.g. Null moves after Mcodes skip to here) 
-	sps.exec_state = PREP_BUFFER_OWNED_BY_EXEC;				// flip it back
-	sps.prep_state = false;
-	st_request_exec_move();									// exec and prep next move
-}
-
-/*
- * st_prep_line() - Prepare the next move for the loader
- *
- *	This function does the math on the next pulse segment and gets it ready for 
- *	the loader. It deals with all the DDA optimizations and timer setups so that
- *	loading can be performed as rapidly as possible. It works in joint space 
- *	(motors) and it works in steps, not length units. All args are provided as 
- *	floats and converted to their appropriate integer types for the loader. 
- *
- * Args:
- *	steps[] are signed relative motion in steps (can be non-integer values)
- *	Microseconds - how many microseconds the segment should run 
- */
-
-stat_t st_prep_line(float steps[], float microseconds)
-{
-	uint8_t i;
-	float f_dda = F_DDA;		// starting point for adjustment
-	float dda_substeps = DDA_SUBSTEPS;
-
-	// *** defensive programming ***
-	// trap conditions that would prevent queueing the line
-	if (sps.exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_INTERNAL_ERROR);
-	} else if (isfinite(microseconds) == false) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
-	} else if (microseconds < EPSILON) { return (STAT_MINIMUM_TIME_MOVE_ERROR);
-	}
-	sps.reset_flag = false;		// initialize accumulator reset flag for this move.
-
-	// setup motor parameters
-	for (i=0; i<MOTORS; i++) {
-		sps.m[i].dir = ((steps[i] < 0) ? 1 : 0) ^ cfg.m[i].polarity;
-		sps.m[i].phase_increment = (uint32_t)fabs(steps[i] * dda_substeps);
-	}
-	sps.dda_period = _f_to_period(f_dda);
-	sps.dda_ticks = (uint32_t)((microseconds/1000000) * f_dda);
-	sps.dda_ticks_X_substeps = sps.dda_ticks * dda_substeps;	// see FOOTNOTE
-
-	// anti-stall measure in case change in velocity between segments is too great 
-	if ((sps.dda_ticks * ACCUMULATOR_RESET_FACTOR) < sps.prev_ticks) {  // NB: uint32_t math
-		sps.reset_flag = true;
-	}
-	sps.prev_ticks = sps.dda_ticks;
-	sps.move_type = MOVE_TYPE_ALINE;
-	sps.prep_state = true;
-	return (STAT_OK);
-}
-// FOOTNOTE: This expression was previously computed as below but floating 
-// point rounding errors caused subtle and nasty accumulated position errors:
-//	sp.dda_ticks_X_substeps = (uint32_t)((microseconds/1000000) * f_dda * dda_substeps);
-
-/* 
- * st_prep_null() - Keeps the loader happy. Otherwise performs no action
- *
- *	Used by M codes, tool and spindle changes
- */
-
-void st_prep_null()
-{
-	sps.move_type = MOVE_TYPE_NULL;
-	sps.prep_state = true;
-}
-
-/* 
- * st_prep_dwell() 	 - Add a dwell to the move buffer
- */
-
-void st_prep_dwell(float microseconds)
-{
-	sps.move_type = MOVE_TYPE_DWELL;
-	sps.prep_state = true;
-	sps.dda_period = _f_to_period(F_DWELL);
-	sps.dda_ticks = (uint32_t)((microseconds/1000000) * F_DWELL);
-}
-
-/*
- * st_isbusy() - return TRUE if motors are running or a dwell is running
- */
-inline uint8_t st_isbusy()
-{
-	if (st.dda_ticks_downcount == 0) {
-		return (false);
-	} 
-	return (true);
-}
-
-/* 
- * st_set_polarity() - setter needed by the config system
- */
-
-void st_set_polarity(const uint8_t motor, const uint8_t polarity)
-{
-	st.m[motor].polarity = polarity;
-}
-
-/* 
- * st_set_microsteps() - set microsteps in hardware
- *
- *	For now the microstep_mode is the same as the microsteps (1,2,4,8)
- *	This may change if microstep morphing is implemented.
- */
-
-void st_set_microsteps(const uint8_t motor, const uint8_t microstep_mode)
-{
-	if (microstep_mode == 8) {
-		device.st_port[motor]->OUTSET = MICROSTEP_BIT_0_bm;
-		device.st_port[motor]->OUTSET = MICROSTEP_BIT_1_bm;
-	} else if (microstep_mode == 4) {
-		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_0_bm;
-		device.st_port[motor]->OUTSET = MICROSTEP_BIT_1_bm;
-	} else if (microstep_mode == 2) {
-		device.st_port[motor]->OUTSET = MICROSTEP_BIT_0_bm;
-		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_1_bm;
-	} else if (microstep_mode == 1) {
-		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_0_bm;
-		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_1_bm;
-	}
-}
-
-
-/**** DEBUG routines ****/
-/*
- * st_dump_stepper_state()
- */
-
-#ifdef __DEBUG
-
-static const char sts_sing[] PROGMEM = "stSingleton dda_ticks (remaining):%d\n";
-static const char sts_timr[] PROGMEM = "  timer %s  enabled:%d  period:%d\n";
-static const char sts_motr[] PROGMEM = "  motor[%d] pol:%d  steps:%d  counter:%d\n";
-
-void st_dump_stepper_state()
-{
-	uint8_t i;
-
-	fprintf_P(stderr, (PGM_P)sts_sing, st.dda_ticks_downcount);
-
-	fprintf_P(stderr, (PGM_P)sts_timr, "dda", TIMER_DDA.CTRLA, TIMER_DDA.PER);
-	fprintf_P(stderr, (PGM_P)sts_timr, "dwl", TIMER_DWELL.CTRLA, TIMER_DWELL.PER);
-	fprintf_P(stderr, (PGM_P)sts_timr, "load", TIMER_LOAD.CTRLA, TIMER_LOAD.PER);
-	fprintf_P(stderr, (PGM_P)sts_timr, "exec", TIMER_EXEC.CTRLA, TIMER_EXEC.PER);
-
-	for (i=0; i<MOTORS; i++) {
-		fprintf_P(stderr, (PGM_P)sts_motr, i, 
-			st.m[i].polarity,
-			st.m[i].phase_increment,
-			st.m[i].phase_accumulator);
-	}
-}
-
-// dump_set_f_dda(*f_dda, *dda_substeps, major_axis_steps, microseconds, f_dda_base);
-
-#endif
+/*
+ * stepper.c - stepper motor controls
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* 	This module provides the low-level stepper drivers and some related
+ * 	functions. It dequeues lines queued by the motor_queue routines.
+ * 	This is some of the most heavily optimized code in the project.
+ *
+ *	Note that if you want to use this for something other than TinyG
+ *	you may need to stretch the step pulses. They run about 1 uSec 
+ *	which is fine for the TI DRV8811/DRV8818 chips in TinyG but may 
+ *	not suffice for other stepper driver hardware.
+ */
+
+/**** Line planning and execution ****
+ *
+ *	Move planning, execution and pulse generation takes place at 3 levels:
+ *
+ *	Move planning occurs in the main-loop. The canonical machine calls the
+ *	planner to generate lines, arcs, dwells and synchronous stop/starts.
+ *	The planner module generates blocks (bf's) that hold parameters for 
+ *	lines and the other move types. The blocks are backplanned to join 
+ *	lines, and to take dwells and stops into account. ("plan" stage).
+ *
+ *	Arc movement is planned above the above the line planner. The arc 
+ *	planner generates short lines that are passed to the line planner.
+ *
+ *	Move execution and load prep takes place at the LOW interrupt level. 
+ *	Move execution generates the next acceleration, cruise, or deceleration
+ *	segment for planned lines, or just transfers parameters needed for 
+ *	dwells and stops. This layer also prepares moves for loading by 
+ *	pre-calculating the values needed by the DDA, and converting the 
+ *	executed move into parameters that can be directly loaded into the 
+ *	steppers ("exec" and "prep" stages).
+ *
+ *	Pulse train generation takes place at the HI interrupt level. 
+ *	The stepper DDA fires timer interrupts that generate the stepper pulses. 
+ *	This level also transfers new stepper parameters once each pulse train
+ *	("segment") is complete ("load" and "run" stages). 
+ */
+/* 	What happens when the pulse generator is done with the current pulse train 
+ *	(segment) is a multi-stage "pull" queue that looks like this:
+ *
+ *	As long as the steppers are running the sequence of events is:
+ *	  - The stepper interrupt (HI) runs the DDA to generate a pulse train
+ *	  	  for the current move. This runs for the length of the pulse train
+ *		  currently executing - the "segment", usually 5ms worth of pulses
+ *
+ *	  - When the current segment is finished the stepper interrupt LOADs the next 
+ *		  segment from the prep buffer, reloads the timers, and starts the 
+ *		  next segment. At the end of the load the stepper interrupt routine
+ *		  requests an "exec" of the next move in order to prepare for the 
+ *		  next load operation. It does this by calling the exec using a 
+ *		  software interrupt (actually a timer, since that's all we've got).
+ *
+ *	  - As a result of the above, the EXEC handler fires at the LO interrupt 
+ *		  level. It computes the next accel/decel segment for the current move 
+ *		  (i.e. the move in the planner's runtime buffer) by calling back to 
+ *		  the exec routine in planner.c. Or it gets and runs the next buffer 
+ *		  in the planning queue - depending on the move_type and state. 
+ *
+ *	  - Once the segment has been computed the exec handler finshes up by running 
+ *		  the PREP routine in stepper.c. This computes the DDA values and gets 
+ *		  the segment into the prep buffer - and ready for the next LOAD operation.
+ *
+ *	  - The main loop runs in background to receive gcode blocks, parse them,
+ *		  and send them to the planner in order to keep the planner queue 
+ *		  full so that when the planner's runtime buffer completes the next move
+ *		  (a gcode block or perhaps an arc segment) is ready to run.
+ *
+ *	If the steppers are not running the above is similar, except that the exec
+ * 	is invoked from the main loop by the software interrupt, and the stepper 
+ *	load is invoked from the exec by another software interrupt.
+ */
+/*	Control flow can be a bit confusing. This is a typical sequence for planning 
+ *	executing, and running an acceleration planned line:
+ *
+ *	 1  planner.mp_aline() is called, which populates a planning buffer (bf) 
+ *		and back-plans any pre-existing buffers.
+ *
+ *	 2  When a new buffer is added _mp_queue_write_buffer() tries to invoke
+ *	    execution of the move by calling stepper.st_request_exec_move(). 
+ *
+ *	 3a If the steppers are running this request is ignored.
+ *	 3b If the steppers are not running this will set a timer to cause an 
+ *		EXEC "software interrupt" that will ultimately call st_exec_move().
+ *
+ *   4  At this point a call to _exec_move() is made, either by the 
+ *		software interrupt from 3b, or once the steppers finish running 
+ *		the current segment and have loaded the next segment. In either 
+ *		case the call is initated via the EXEC software interrupt which 
+ *		causes _exec_move() to run at the MEDium interupt level.
+ *		 
+ *	 5	_exec_move() calls back to planner.mp_exec_move() which generates 
+ *		the next segment using the mr singleton.
+ *
+ *	 6	When this operation is complete mp_exec_move() calls the appropriate
+ *		PREP routine in stepper.c to derive the stepper parameters that will 
+ *		be needed to run the move - in this example st_prep_line().
+ *
+ *	 7	st_prep_line() generates the timer and DDA values and stages these into 
+ *		the prep structure (sp) - ready for loading into the stepper runtime struct
+ *
+ *	 8	stepper.st_prep_line() returns back to planner.mp_exec_move(), which 
+ *		frees the planning buffer (bf) back to the planner buffer pool if the 
+ *		move is complete. This is done by calling _mp_request_finalize_run_buffer()
+ *
+ *	 9	At this point the MED interrupt is complete, but the planning buffer has 
+ *		not actually been returned to the pool yet. The buffer will be returned
+ *		by the main-loop prior to testing for an available write buffer in order
+ *		to receive the next Gcode block. This handoff prevents possible data 
+ *		conflicts between the interrupt and main loop.
+ *
+ *	10	The final step in the sequence is _load_move() requesting the next 
+ *		segment to be executed and prepared by calling st_request_exec() 
+ *		- control goes back to step 4.
+ *
+ *	Note: For this to work you have to be really careful about what structures
+ *	are modified at what level, and use volatiles where necessary.
+ */
+/* Partial steps and phase angle compensation
+ *
+ *	The DDA accepts partial steps as input. Fractional steps are managed by the 
+ *	sub-step value as explained elsewhere. The fraction initially loaded into 
+ *	the DDA and the remainder left at the end of a move (the "residual") can
+ *	be thought of as a phase angle value for the DDA accumulation. Each 360
+ *	degrees of phase angle results in a step being generated. 
+ */
+
+#include <stdlib.h>
+#include <string.h>				// needed for memset in st_init()
+#include <math.h>				// isinfinite()
+#include <stdio.h>				// precursor for xio.h
+#include <avr/pgmspace.h>		// precursor for xio.h
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "tinyg.h"
+#include "util.h"
+#include "system.h"
+#include "config.h"
+#include "settings.h"			// machine profile may set MOTORS_IN_USE
+#include "stepper.h"
+#include "test.h"
+#include "planner.h"
+#include "report.h"				// for the status report dirty marks
+#include "gpio.h"				// for the synchronized outputs
+#include "pwm.h"				// for raster mode intensity streaming
+#include "spindle.h"			// for the tach at-speed dwell release
+#include "controller.h"			// for tg.network_mode
+#include "network.h"			// RS485 segment streaming (multi-board sync)
+#include "xmega/xmega_rtc.h"
+
+static void _exec_move(void);
+static void _load_move(void);
+static void _request_load_move(void);
+static void _broadcast_prep_segment(void);
+
+static struct stSyncSingleton {		// sync line state - see notes at ISR(NET_SYNC_ISR_vect)
+	volatile uint8_t start_armed;		// start the DDA on the next sync edge
+	volatile uint8_t offset_fresh;		// an unconsumed drift sample is present
+	volatile uint32_t boundary_offset;	// dda ticks still owed at the master's boundary
+} nss;
+#ifdef __STEP_DMA
+static void _init_dma_engine(void);
+static void _render_dma_patterns(void);
+static void _load_dma_segment(void);
+#endif
+
+/* ISR profiling bins and sampling macros. The bins accumulate occupancy in
+ * TIMER_PROFILE ticks at interrupt level; the once-per-second rollup lives
+ * in the ISR profiling region near the end of this file.
+ */
+#ifdef __ISR_PROFILE
+typedef struct stProfileBin {			// one accumulation bin (ticks of TIMER_PROFILE)
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+	uint16_t count;
+} stProfileBin_t;
+
+static stProfileBin_t pf_dda;			// DDA ISR occupancy
+static stProfileBin_t pf_load;			// _load_move() occupancy
+static stProfileBin_t pf_exec;			// exec SW interrupt occupancy (exec + prep of one segment)
+
+static void _isr_profile_sample(stProfileBin_t *bin, uint16_t elapsed)
+{
+	if ((elapsed < bin->min) || (bin->count == 0)) { bin->min = elapsed;}
+	if (elapsed > bin->max) { bin->max = elapsed;}
+	bin->sum += elapsed;
+	bin->count++;
+}
+#define ISR_PROFILE_START() uint16_t profile_entry = TIMER_PROFILE.CNT
+#define ISR_PROFILE_END(bin) _isr_profile_sample(&bin, (uint16_t)(TIMER_PROFILE.CNT - profile_entry))
+#else
+#define ISR_PROFILE_START()
+#define ISR_PROFILE_END(bin)
+#endif // __ISR_PROFILE
+
+/*
+ * Stepper structures
+ *
+ *	There are 4 sets of structures involved in this operation;
+ *
+ *	data structure:						static to:		runs at:
+ *	  mpBuffer planning buffers (bf)	  planner.c		  main loop
+ *	  mrRuntimeSingleton (mr)			  planner.c		  MED ISR
+ *	  stPrepSingleton (sp)				  stepper.c		  MED ISR
+ *	  stRunSingleton (st)				  stepper.c		  HI ISR
+ *  
+ *	Care has been taken to isolate actions on these structures to the 
+ *	execution level in which they run and to use the minimum number of 
+ *	volatiles in these structures. This allows the compiler to optimize
+ *	the stepper inner-loops better.
+ */
+
+// Runtime structs. Used exclusively by step generation ISR (HI)
+typedef struct stRunMotor { 		// one per controlled motor
+	int32_t phase_increment;		// total steps in axis times substeps factor
+	int32_t phase_accumulator;		// DDA phase angle accumulator for axis
+	uint8_t polarity;				// 0=normal polarity, 1=reverse motor polarity
+} stRunMotor_t;
+
+/* DDA tick chunking
+ *
+ *	The downcounter is decremented and tested every DDA tick, so its width
+ *	is ISR budget - a 4-byte decrement-and-test costs ~10 cycles per tick
+ *	on this 8-bit CPU. A nominal segment fits easily in 16 bits, but a
+ *	single-segment move at a very slow feed can run for seconds, so long
+ *	loads are split into 16-bit chunks at load time: the ISR runs a 16-bit
+ *	counter and refills it from dda_ticks_remaining in the (rare) chunk-end
+ *	branch. The phase accumulators are untouched by the chunking - only the
+ *	tick bookkeeping is split.
+ */
+#define DDA_CHUNK_TICKS 0xFFFF		// ticks per downcounter chunk
+
+typedef struct stRunSingleton {		// Stepper static values and axis parameters
+	uint16_t magic_start;			// magic number to test memory integity
+	uint16_t dda_ticks_downcount;	// tick down-counter for the active chunk (unscaled)
+	int32_t dda_ticks_remaining;	// ticks beyond the active chunk (long moves only)
+	int32_t dda_ticks_total;		// ticks the loaded segment started with
+	int32_t dda_ticks_X_substeps;	// ticks multiplied by scaling factor
+	volatile int32_t dwell_ticks_downcount;	// dwell down-counter (RTC ticks)
+	volatile uint8_t dwell_spindle_sync;	// loaded dwell releases at measured spindle speed
+	stRunMotor_t m[MOTORS];			// runtime motor structures
+} stRunSingleton_t;
+
+// Prep-time structs. Used by exec/prep ISR (MED) and read-only during load
+// Must be careful about volatiles in this one
+
+enum prepBufferState {
+	PREP_BUFFER_OWNED_BY_LOADER = 0,// staging buffer is ready for load
+	PREP_BUFFER_OWNED_BY_EXEC		// staging buffer is being loaded
+};
+
+/* Prep buffer ring
+ *	The prep stage is a small ring of buffers between the exec (MED) and
+ *	load (HI) stages. Exec preps into the write slot (spw) and the loader
+ *	consumes the read slot (spr). Running the prep stage ahead of the
+ *	loader by a few segments absorbs exec-time jitter (e.g. trapezoid
+ *	tail math) that would otherwise starve the loader and stutter the
+ *	steppers at high segment rates. Ownership is carried per-slot in
+ *	exec_state so no other locking is needed - exec only ever touches a
+ *	slot it owns, as does the loader.
+ *
+ *	The DMA pulse engine build keeps the ring at 2 slots (double buffered)
+ *	as each slot also carries rendered pulse patterns - see pattern sizing.
+ */
+#ifdef __STEP_DMA
+#define PREP_BUFFERS 2				// prep ring depth (double buffer)
+#else
+#define PREP_BUFFERS 4				// prep ring depth
+#endif
+
+typedef struct stPrepMotor {
+ 	uint32_t phase_increment; 		// total steps in axis times substep factor
+	int8_t dir;						// b0 = direction
+	uint8_t microstep_mode;			// mode pins for this segment - 0 leaves the pins alone
+} stPrepMotor_t;
+
+typedef struct stPrepSingleton {
+	uint16_t magic_start;			// magic number to test memory integity
+	uint8_t move_type;				// move type
+	uint8_t prep_state;				// set TRUE to load, false to skip
+	volatile uint8_t exec_state;	// move execution state
+	volatile uint8_t correction_flag;	// TRUE if accumulators need rescaling
+	float accumulator_correction;	// factor for phase-continuous handoff
+	uint16_t dda_period;			// DDA or dwell clock period setting
+	uint32_t dda_ticks;				// DDA or dwell ticks for the move
+	uint32_t dda_ticks_X_substeps;	// DDA ticks scaled by substep factor
+	uint8_t dwell_code;				// dwell flavor - DWELL_CODE_PLAIN or DWELL_CODE_SPINDLE_SYNC
+	uint8_t sync_output;			// output command applied at segment start (see st_prep_sync_output)
+	uint16_t ppi_period;			// PPI pulse period for this segment - 0 = no pulses (see pwm.c)
+//	float segment_velocity;			// +++++ record segment velocity for diagnostics
+	stPrepMotor_t m[MOTORS];		// per-motor structs
+} stPrepSingleton_t;
+
+// Allocate static structures
+static stRunSingleton_t st;
+static stPrepSingleton_t sp[PREP_BUFFERS];	// prep buffer ring
+static stPrepSingleton_t *spw;		// slot being prepped by exec (MED)
+static stPrepSingleton_t *spr;		// slot to be consumed by loader (HI)
+static uint32_t sp_prev_ticks_X_substeps;	// accumulator range of previously prepped move
+static uint8_t sp_prev_direction[MOTORS];	// last commanded direction - 0xFF until a motor has moved
+static uint8_t sp_morph_shift[MOTORS];		// microstep morph downshift - 0 is the configured resolution
+static uint32_t sp_morph_residual[MOTORS];	// substeps truncated by the downshift, carried forward
+static uint32_t sp_scale_residual[MOTORS];	// substeps truncated by a substep downshift, carried forward
+static uint8_t st_microstep_mode[MOTORS];	// mode currently on the pins (written by st_set_microsteps)
+
+#define _advance_prep_buffer(b) (((b) == &sp[PREP_BUFFERS-1]) ? &sp[0] : (b)+1)
+
+uint16_t st_get_st_magic() { return (st.magic_start);}
+uint16_t st_get_sps_magic() { return (sp[0].magic_start);}
+
+/* 
+ * st_init() - initialize stepper motor subsystem 
+ *
+ *	Notes:
+ *	  - This init requires sys_init() to be run beforehand
+ *		This init is a precursor for gpio_init()
+ * 	  - microsteps are setup during cfg_init()
+ *	  - motor polarity is setup during cfg_init()
+ *	  - high level interrupts must be enabled in main() once all inits are complete
+ */
+
+void st_init()
+{
+//	You can assume all values are zeroed. If not, use this:
+//	memset(&st, 0, sizeof(st));	// clear all values, pointers and status
+
+	st.magic_start = MAGICNUM;
+	for (uint8_t i=0; i<PREP_BUFFERS; i++) {
+		sp[i].magic_start = MAGICNUM;
+		sp[i].exec_state = PREP_BUFFER_OWNED_BY_EXEC;
+	}
+	memset(sp_prev_direction, 0xFF, sizeof(sp_prev_direction));	// no backlash takeup on a motor's first move
+	spw = &sp[0];
+	spr = &sp[0];
+
+	// Configure virtual ports
+	PORTCFG.VPCTRLA = PORTCFG_VP0MAP_PORT_MOTOR_1_gc | PORTCFG_VP1MAP_PORT_MOTOR_2_gc;
+	PORTCFG.VPCTRLB = PORTCFG_VP2MAP_PORT_MOTOR_3_gc | PORTCFG_VP3MAP_PORT_MOTOR_4_gc;
+
+	// setup ports
+	for (uint8_t i=0; i<MOTORS; i++) {
+		device.st_port[i]->DIR = MOTOR_PORT_DIR_gm;  // sets outputs for motors & GPIO1, and GPIO2 inputs
+		device.st_port[i]->OUT = MOTOR_ENABLE_BIT_bm;// zero port bits AND disable motor
+	}
+	// setup DDA timer
+	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
+	TIMER_DDA.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
+	TIMER_DDA.INTCTRLA = TIMER_DDA_INTLVL;		// interrupt mode
+
+	// setup DWELL timer
+	// setup software interrupt load timer
+	TIMER_LOAD.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
+	TIMER_LOAD.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
+	TIMER_LOAD.INTCTRLA = TIMER_LOAD_INTLVL;	// interrupt mode
+	TIMER_LOAD.PER = SWI_PERIOD;				// set period
+
+	// setup software interrupt exec timer
+	TIMER_EXEC.CTRLA = STEP_TIMER_DISABLE;		// turn timer off
+	TIMER_EXEC.CTRLB = STEP_TIMER_WGMODE;		// waveform mode
+	TIMER_EXEC.INTCTRLA = TIMER_EXEC_INTLVL;	// interrupt mode
+	TIMER_EXEC.PER = SWI_PERIOD;				// set period
+
+#ifdef __STEP_DMA
+	_init_dma_engine();							// takes over from the DDA overflow interrupt
+#endif
+#ifdef __ISR_PROFILE
+	TIMER_PROFILE.CTRLA = STEP_TIMER_ENABLE;	// free-running profile timebase (div1)
+	TIMER_PROFILE.CTRLB = STEP_TIMER_WGMODE;	// normal mode, no interrupts
+	TIMER_PROFILE.PER = 0xFFFF;
+#endif
+#ifdef __STEP_PULSE_TIMER
+	TIMER_PULSE.CTRLA = STEP_TIMER_DISABLE;		// started by the DDA ISR on demand
+	TIMER_PULSE.CTRLB = STEP_TIMER_WGMODE;		// count to TOP and interrupt
+	TIMER_PULSE.PER = STEP_PULSE_USEC * (uint16_t)(F_CPU/1000000);
+	TIMER_PULSE.INTCTRLA = TIMER_OVFINTLVL_HI;	// same level as the DDA
+#endif
+}
+
+/* 
+ * st_enable_motor()  - enable a motor
+ * st_enable_motors() - enable all motors with $pm set to 0
+ * st_disable_motor() - disable a motor
+ * st_disable_motors()- disable all motors
+ * st_start_disable_motors_timeout()
+ * st_disable_motors_rtc_callback()
+ * st_kill_motors()   - stop the steppers. Requires re-init to recover
+ */
+void st_enable_motor(const uint8_t motor)
+{
+	if (bm.running == true) { return;}	// benchmarks run with the drivers disabled
+	if (motor == MOTOR_1) { PORT_MOTOR_1_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_2) { PORT_MOTOR_2_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_3) { PORT_MOTOR_3_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_4) { PORT_MOTOR_4_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm; }
+	cfg.m[motor].power_timer = cfg.m[motor].power_timeout * (1000 / RTC_MILLISECONDS);
+}
+
+void st_enable_motors()
+{
+	if (cfg.m[MOTOR_1].power_mode == 0) { st_enable_motor(MOTOR_1);}
+	if (cfg.m[MOTOR_2].power_mode == 0) { st_enable_motor(MOTOR_2);}
+	if (cfg.m[MOTOR_3].power_mode == 0) { st_enable_motor(MOTOR_3);}
+	if (cfg.m[MOTOR_4].power_mode == 0) { st_enable_motor(MOTOR_4);}
+	st_start_disable_motors_timer();
+}
+
+void st_disable_motor(const uint8_t motor)
+{
+	if (motor == MOTOR_1) { PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_2) { PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_3) { PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
+	if (motor == MOTOR_4) { PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; }
+}
+
+void st_disable_motors()
+{
+	st_disable_motor(MOTOR_1);
+	st_disable_motor(MOTOR_2);
+	st_disable_motor(MOTOR_3);
+	st_disable_motor(MOTOR_4);
+}
+
+void st_start_disable_motors_timer()	// reset per-motor timeout intervals
+{
+	for (uint8_t i=0; i<MOTORS; i++) {
+		cfg.m[i].power_timer = cfg.m[i].power_timeout * (1000 / RTC_MILLISECONDS);
+	}
+}
+
+void st_disable_motors_rtc_callback() 		// called by 10ms real-time clock
+{
+	for (uint8_t i=0; i<MOTORS; i++) {
+		if (cfg.m[i].power_timer == 0) { continue;}		// already idled
+		if (--cfg.m[i].power_timer == 0) { st_disable_motor(i);}
+	}
+}
+
+void st_kill_motors()
+{
+	for (uint8_t i=0; i<MOTORS; i++) {
+		device.st_port[i]->DIR = MOTOR_PORT_DIR_gm;  // sets outputs for motors & GPIO1, and GPIO2 inputs
+		device.st_port[i]->OUT = MOTOR_ENABLE_BIT_bm;// zero port bits AND disable motor
+	}
+	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;			// turn timer off
+}
+
+/*
+ * ISRs
+ * ISR - DDA timer interrupt routine - service ticks from DDA timer
+ *
+ *	The step bit pulse width is ~1 uSec, which is OK for the TI DRV8811's.
+ *	If you need to stretch the pulse I recommend moving the port OUTCLRs
+ *	to the end of the routine. If you need more time than that enable
+ *	__STEP_PULSE_TIMER, which leaves the step bits raised and clears them
+ *	from a one-shot pulse-off timer (like grbl does) so no extra time is
+ *	spent in this ISR, which would limit the upper range of the DDA
+ *	frequency. STEP_PULSE_USEC sets the width (see stepper.h).
+ *
+ *	Uses direct struct addresses and literal values for hardware devices -
+ *	it's faster than using indexed timer and port accesses. I checked.
+ *	Even when -0s or -03 is used.
+ */
+
+#ifndef __STEP_DMA
+ISR(TIMER_DDA_ISR_vect)
+{
+	ISR_PROFILE_START();
+	if ((st.m[MOTOR_1].phase_accumulator += st.m[MOTOR_1].phase_increment) > 0) {
+		PORT_MOTOR_1_VPORT.OUT |= STEP_BIT_bm;	// turn step bit on
+ 		st.m[MOTOR_1].phase_accumulator -= st.dda_ticks_X_substeps;
+#ifndef __STEP_PULSE_TIMER
+		PORT_MOTOR_1_VPORT.OUT &= ~STEP_BIT_bm;	// turn step bit off in ~1 uSec
+#endif
+	}
+	if ((st.m[MOTOR_2].phase_accumulator += st.m[MOTOR_2].phase_increment) > 0) {
+		PORT_MOTOR_2_VPORT.OUT |= STEP_BIT_bm;
+ 		st.m[MOTOR_2].phase_accumulator -= st.dda_ticks_X_substeps;
+#ifndef __STEP_PULSE_TIMER
+		PORT_MOTOR_2_VPORT.OUT &= ~STEP_BIT_bm;
+#endif
+	}
+#if (MOTORS_IN_USE >= 3)
+	if ((st.m[MOTOR_3].phase_accumulator += st.m[MOTOR_3].phase_increment) > 0) {
+		PORT_MOTOR_3_VPORT.OUT |= STEP_BIT_bm;
+ 		st.m[MOTOR_3].phase_accumulator -= st.dda_ticks_X_substeps;
+#ifndef __STEP_PULSE_TIMER
+		PORT_MOTOR_3_VPORT.OUT &= ~STEP_BIT_bm;
+#endif
+	}
+#endif
+#if (MOTORS_IN_USE >= 4)
+	if ((st.m[MOTOR_4].phase_accumulator += st.m[MOTOR_4].phase_increment) > 0) {
+		PORT_MOTOR_4_VPORT.OUT |= STEP_BIT_bm;
+ 		st.m[MOTOR_4].phase_accumulator -= st.dda_ticks_X_substeps;
+#ifndef __STEP_PULSE_TIMER
+		PORT_MOTOR_4_VPORT.OUT &= ~STEP_BIT_bm;
+#endif
+	}
+#endif
+#ifdef __STEP_PULSE_TIMER
+	TIMER_PULSE.CNT = 0;						// (re)start the pulse-off timer. Any step
+	TIMER_PULSE.CTRLA = STEP_TIMER_ENABLE;		// bits raised above stay up STEP_PULSE_USEC
+#endif
+	if (--st.dda_ticks_downcount == 0) {		// end of the 16-bit chunk
+		if (st.dda_ticks_remaining != 0) {		// long move - refill the downcounter
+			if (st.dda_ticks_remaining > DDA_CHUNK_TICKS) {
+				st.dda_ticks_downcount = DDA_CHUNK_TICKS;
+				st.dda_ticks_remaining -= DDA_CHUNK_TICKS;
+			} else {
+				st.dda_ticks_downcount = st.dda_ticks_remaining;
+				st.dda_ticks_remaining = 0;
+			}
+			ISR_PROFILE_END(pf_dda);
+			return;
+		}
+		// end move
+ 		TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;	// disable DDA timer
+		st_start_disable_motors_timer();
+		// power-down motors if this feature is enabled
+		if (cfg.m[MOTOR_1].power_mode == true) PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm; // set to 0 to disable
+		if (cfg.m[MOTOR_2].power_mode == true) PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+		if (cfg.m[MOTOR_3].power_mode == true) PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+		if (cfg.m[MOTOR_4].power_mode == true) PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+		_load_move();							// load the next move
+	}
+	ISR_PROFILE_END(pf_dda);
+}
+
+#ifdef __STEP_PULSE_TIMER
+ISR(TIMER_PULSE_ISR_vect)						// pulse-off one-shot
+{
+	TIMER_PULSE.CTRLA = STEP_TIMER_DISABLE;
+	PORT_MOTOR_1_VPORT.OUT &= ~STEP_BIT_bm;		// clearing an already-low bit is harmless
+	PORT_MOTOR_2_VPORT.OUT &= ~STEP_BIT_bm;
+#if (MOTORS_IN_USE >= 3)
+	PORT_MOTOR_3_VPORT.OUT &= ~STEP_BIT_bm;
+#endif
+#if (MOTORS_IN_USE >= 4)
+	PORT_MOTOR_4_VPORT.OUT &= ~STEP_BIT_bm;
+#endif
+}
+#endif // __STEP_PULSE_TIMER
+#endif // __STEP_DMA
+
+/**** DMA pulse engine ****
+ *
+ *	The DMA pulse engine replaces the DDA overflow interrupt with pattern
+ *	playback through the XMEGA DMA controller. The prep stage runs the same
+ *	Bresenham DDA as the interrupt engine, but runs it once per segment at
+ *	the MED level and records the resulting step-bit edges into per-motor
+ *	pattern buffers. Each motor gets a DMA channel that writes one pattern
+ *	byte to its port OUTTGL register per DDA timer overflow (routed through
+ *	event system channel 0). The DDA timer runs with its interrupt disabled
+ *	so the HI level cost per step train is reduced to the single segment-end
+ *	DMA transaction-complete interrupt.
+ *
+ *	Since OUTTGL is used a step line raised on one tick is dropped by the
+ *	next tick's pattern byte, so pulses are one DDA period wide and the max
+ *	per-motor step rate is F_DDA/2 (F_DDA is doubled for this build to
+ *	compensate - see stepper.h). Back-to-back step ticks merge into one
+ *	stretched pulse; the doubled F_DDA keeps this from occurring below
+ *	50 Khz motor step rates.
+ */
+#ifdef __STEP_DMA
+
+typedef struct stDMASingleton {	// pattern storage - one set per prep ring slot
+	uint8_t pattern[PREP_BUFFERS][MOTORS][DMA_PATTERN_TICKS_MAX]; // OUTTGL patterns rendered by prep
+	uint16_t pattern_ticks[PREP_BUFFERS];	// ticks rendered for each slot
+} stDMASingleton_t;
+static stDMASingleton_t dmas;
+
+static void _init_dma_channel(DMA_CH_t *ch, uint8_t trigsrc, PORT_t *port)
+{
+	ch->ADDRCTRL = DMA_CH_SRCRELOAD_TRANSACTION_gc | DMA_CH_SRCDIR_INC_gc |
+				   DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
+	ch->TRIGSRC = trigsrc;
+	ch->TRFCNT = 0;
+	ch->DESTADDR0 = ((uint16_t)&port->OUTTGL) & 0xFF;
+	ch->DESTADDR1 = ((uint16_t)&port->OUTTGL >> 8) & 0xFF;
+	ch->DESTADDR2 = 0;
+}
+
+static void _set_dma_source(DMA_CH_t *ch, const uint8_t *pattern, uint16_t ticks)
+{
+	ch->SRCADDR0 = ((uint16_t)pattern) & 0xFF;
+	ch->SRCADDR1 = ((uint16_t)pattern >> 8) & 0xFF;
+	ch->SRCADDR2 = 0;
+	ch->TRFCNT = ticks;
+	ch->CTRLA |= DMA_CH_ENABLE_bm;
+}
+
+static void _init_dma_engine()
+{
+	EVSYS.CH0MUX = EVSYS_CHMUX_TCC0_OVF_gc;			// DDA timer overflow paces the DMA
+	DMA.CTRL = DMA_ENABLE_bm | DMA_DBUFMODE_DISABLED_gc;
+	_init_dma_channel(&DMA.DMA_CH_MOTOR_1, DMA_CH_TRIGSRC_EVSYS_CH0_gc, &PORT_MOTOR_1);
+	_init_dma_channel(&DMA.DMA_CH_MOTOR_2, DMA_CH_TRIGSRC_EVSYS_CH0_gc, &PORT_MOTOR_2);
+	_init_dma_channel(&DMA.DMA_CH_MOTOR_3, DMA_CH_TRIGSRC_EVSYS_CH0_gc, &PORT_MOTOR_3);
+	_init_dma_channel(&DMA.DMA_CH_MOTOR_4, DMA_CH_TRIGSRC_EVSYS_CH0_gc, &PORT_MOTOR_4);
+	DMA.DMA_CH_MOTOR_1.CTRLB = DMA_CH_TRNINTLVL_HI_gc;	// channel 0 is the segment-end master
+	TIMER_DDA.INTCTRLA = 0;							// DDA overflow interrupt is not used
+}
+
+/*
+ * _render_dma_patterns() - run the segment DDA at prep time
+ *
+ *	Runs the same phase accumulator math as the interrupt engine, once per
+ *	motor over the whole segment, and records the resulting OUTTGL edges.
+ *	Called from st_prep_line() after the sps struct is populated. Segments
+ *	are clamped to the pattern buffer length; the clamp shortens the segment
+ *	time proportionally so motion remains correct (the exec stage simply
+ *	generates more segments).
+ */
+static void _render_dma_patterns()
+{
+	uint8_t w = (uint8_t)(spw - sp);				// prep ring slot being written
+
+	if (spw->dda_ticks > DMA_PATTERN_TICKS_MAX) {	// clamp to the pattern buffers
+		spw->dda_ticks = DMA_PATTERN_TICKS_MAX;
+	}
+	dmas.pattern_ticks[w] = spw->dda_ticks;
+
+	for (uint8_t i=0; i<MOTORS_IN_USE; i++) {
+		int32_t accumulator = -(int32_t)spw->dda_ticks;	// same reset as the interrupt engine
+		uint8_t level = 0;							// current state of the step line
+		uint8_t *pattern = dmas.pattern[w][i];
+
+		for (uint16_t t=0; t < dmas.pattern_ticks[w]; t++) {
+			uint8_t toggle = level;					// drop the line if the previous tick raised it
+			if ((accumulator += (int32_t)spw->m[i].phase_increment) > 0) {
+				accumulator -= (int32_t)spw->dda_ticks_X_substeps;
+				toggle ^= STEP_BIT_bm;				// raise (or merge) a step edge
+			}
+			level ^= toggle;
+			pattern[t] = toggle;
+		}
+	}
+}
+
+/*
+ * _load_dma_segment() - arm the DMA channels and start the pattern playback
+ *
+ *	Called from _load_move() in place of enabling the DDA overflow interrupt.
+ *	Runs at the HI level so the channels are armed atomically w.r.t. the
+ *	event stream.
+ */
+static void _load_dma_segment()
+{
+	uint8_t r = (uint8_t)(spr - sp);				// prep ring slot being consumed
+	uint16_t ticks = dmas.pattern_ticks[r];
+
+	_set_dma_source(&DMA.DMA_CH_MOTOR_1, dmas.pattern[r][MOTOR_1], ticks);
+	_set_dma_source(&DMA.DMA_CH_MOTOR_2, dmas.pattern[r][MOTOR_2], ticks);
+	_set_dma_source(&DMA.DMA_CH_MOTOR_3, dmas.pattern[r][MOTOR_3], ticks);
+	_set_dma_source(&DMA.DMA_CH_MOTOR_4, dmas.pattern[r][MOTOR_4], ticks);
+	TIMER_DDA.CTRLA = STEP_TIMER_ENABLE;			// start the event stream
+}
+
+ISR(DMA_ISR_vect)									// segment-end interrupt
+{
+	DMA.DMA_CH_MOTOR_1.CTRLB |= DMA_CH_TRNIF_bm;	// clear the interrupt flag
+ 	TIMER_DDA.CTRLA = STEP_TIMER_DISABLE;			// stop the event stream
+	st.dda_ticks_downcount = 0;						// mark the segment complete
+	st.dda_ticks_remaining = 0;
+	st_start_disable_motors_timer();
+	// power-down motors if this feature is enabled
+	if (cfg.m[MOTOR_1].power_mode == true) PORT_MOTOR_1_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	if (cfg.m[MOTOR_2].power_mode == true) PORT_MOTOR_2_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	if (cfg.m[MOTOR_3].power_mode == true) PORT_MOTOR_3_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	if (cfg.m[MOTOR_4].power_mode == true) PORT_MOTOR_4_VPORT.OUT |= MOTOR_ENABLE_BIT_bm;
+	_load_move();									// load the next move
+}
+#endif // __STEP_DMA
+
+/*
+ * st_dwell_rtc_callback() - dwell countdown, called by the 10ms real-time clock
+ *
+ *	Dwells used to run on TIMER_DWELL and occupy dda_ticks_downcount, which
+ *	kept the loader busy for the duration and cost a 10 Khz interrupt train
+ *	that did nothing but count. Running the countdown on the RTC frees the
+ *	load pipeline so the exec/prep stages pre-stage the next aline during
+ *	the dwell, and motion resumes on the tick the dwell expires.
+ *
+ *	Spindle-sync dwells (spin-up balance dwells queued by the canonical
+ *	machine - see cm_spindle_ramp_wait) also expire on the tick the tach
+ *	reports the spindle at speed, so the programmed time is only the
+ *	worst-case ceiling. The at-speed test is an integer compare against a
+ *	pre-computed capture threshold (see sp_spindle_at_speed in spindle.c).
+ */
+void st_dwell_rtc_callback() 					// called by 10ms real-time clock
+{
+	if (st.dwell_ticks_downcount == 0) { return;}
+#ifdef __SPINDLE_TACH
+	if ((st.dwell_spindle_sync == true) && (sp_spindle_at_speed() == true)) {
+		st.dwell_ticks_downcount = 1;			// release on this tick
+	}
+#endif
+	if (--st.dwell_ticks_downcount == 0) {
+		if (tg.network_mode != NETWORK_SLAVE) {	// a slave has no planner buffer to free
+			mp_end_dwell();						// free the planner buffer
+		}
+		_request_load_move();					// load the pre-staged aline
+	}
+}
+
+ISR(TIMER_LOAD_ISR_vect) {						// load steppers SW interrupt
+ 	TIMER_LOAD.CTRLA = STEP_TIMER_DISABLE;		// disable SW interrupt timer
+	_load_move();
+}
+
+ISR(TIMER_EXEC_ISR_vect) {						// exec move SW interrupt
+ 	TIMER_EXEC.CTRLA = STEP_TIMER_DISABLE;		// disable SW interrupt timer
+	ISR_PROFILE_START();
+	_exec_move();								// NULL state
+	ISR_PROFILE_END(pf_exec);
+}
+
+/* Software interrupts to fire the above
+ * st_test_exec_state()	   - return TRUE if exec/prep can run
+ * _request_load_move()    - SW interrupt to request to load a move
+ *	st_request_exec_move() - SW interrupt to request to execute a move
+ * _exec_move() 		   - Run a move from the planner and prepare it for loading
+ *
+ *	_exec_move() can only be called be called from an ISR at a level lower
+ *	than DDA, Only use st_request_exec_move() to call it.
+ */
+
+uint8_t st_test_exec_state()
+{
+	if (spw->exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
+		return (true);
+	}
+	return (false);
+}
+
+void st_request_exec_move()
+{
+	if (spw->exec_state == PREP_BUFFER_OWNED_BY_EXEC) {	// bother interrupting
+		TIMER_EXEC.PER = SWI_PERIOD;
+		TIMER_EXEC.CTRLA = STEP_TIMER_ENABLE;			// trigger a LO interrupt
+	}
+}
+
+static void _exec_move()
+{
+   	if (spw->exec_state == PREP_BUFFER_OWNED_BY_EXEC) {
+//		if (mp_exec_move(state) != STAT_NOOP) {
+		if (mp_exec_move() != STAT_NOOP) {
+			spw->exec_state = PREP_BUFFER_OWNED_BY_LOADER; // hand the slot to the loader
+			spw = _advance_prep_buffer(spw);
+			_request_load_move();
+			st_request_exec_move();		// run ahead if the next slot is free
+		}
+	}
+}
+
+static void _request_load_move()
+{
+	if (st.dda_ticks_downcount == 0) {				// bother interrupting
+		if (tg.network_mode != NETWORK_STANDALONE) {
+			nss.start_armed = true;					// start on the shared sync edge instead
+			if (tg.network_mode == NETWORK_MASTER) { net_request_sync_pulse();}
+			return;
+		}
+		TIMER_LOAD.PER = SWI_PERIOD;
+		TIMER_LOAD.CTRLA = STEP_TIMER_ENABLE;			// trigger a HI interrupt
+	} 	// else don't bother to interrupt. You'll just trigger an 
+		// interrupt and find out the load routine is not ready for you
+}
+
+/*
+ * _load_move() - Dequeue move and load into stepper struct
+ *
+ *	This routine can only be called be called from an ISR at the same or 
+ *	higher level as the DDA or dwell ISR. A software interrupt has been 
+ *	provided to allow a non-ISR to request a load (see st_request_load_move())
+ */
+
+void _load_move()
+{
+	if (st.dda_ticks_downcount != 0) return;					// exit if it's still busy
+	if (st.dwell_ticks_downcount != 0) return;					// hold the next move until a dwell expires
+	if (spr->exec_state != PREP_BUFFER_OWNED_BY_LOADER) {		// if there are no more moves
+		pwm_ppi_idle();							// motion has stopped - stop PPI pulsing
+		return;
+	}
+
+	// dry run - consume the move at maximum rate. The planned time was
+	// accumulated at prep time and no timer or motor port is touched
+	if (dry.running == true) {
+		if (spr->move_type == MOVE_TYPE_DWELL) { mp_end_dwell();}	// free the dwell's planner buffer
+		spr->exec_state = PREP_BUFFER_OWNED_BY_EXEC;
+		spr->prep_state = false;
+		spr = _advance_prep_buffer(spr);
+		st_request_exec_move();
+		return;
+	}
+	ISR_PROFILE_START();
+
+	// handle aline loads first (most common case)  NB: there are no more lines, only alines
+	if (spr->move_type == MOVE_TYPE_ALINE) {
+		if (spr->dda_ticks > DDA_CHUNK_TICKS) {	// split long loads into 16-bit chunks
+			st.dda_ticks_downcount = DDA_CHUNK_TICKS;
+			st.dda_ticks_remaining = spr->dda_ticks - DDA_CHUNK_TICKS;
+		} else {
+			st.dda_ticks_downcount = spr->dda_ticks;
+			st.dda_ticks_remaining = 0;
+		}
+		st.dda_ticks_total = spr->dda_ticks;
+		st.dda_ticks_X_substeps = spr->dda_ticks_X_substeps;
+		TIMER_DDA.PER = spr->dda_period;
+ 
+		// This section is somewhat optimized for execution speed 
+		// All axes must set steps and compensate for out-of-range pulse phasing. 
+		// If axis has 0 steps the direction setting can be omitted
+		// If axis has 0 steps enabling motors is req'd to support power mode = 1
+
+		st.m[MOTOR_1].phase_increment = spr->m[MOTOR_1].phase_increment;			// set steps
+		if (spr->correction_flag == true) {		// carry sub-step phase across the boundary
+			st.m[MOTOR_1].phase_accumulator = (int32_t)(st.m[MOTOR_1].phase_accumulator * spr->accumulator_correction);
+		}
+		if (st.m[MOTOR_1].phase_increment != 0) {
+			st_set_microsteps(MOTOR_1, spr->m[MOTOR_1].microstep_mode);	// microstep morphing
+			// For ideal optimizations, only set or clear a bit at a time.
+			if (spr->m[MOTOR_1].dir == 0) {
+				PORT_MOTOR_1_VPORT.OUT &= ~DIRECTION_BIT_bm;// CW motion (bit cleared)
+			} else {
+				PORT_MOTOR_1_VPORT.OUT |= DIRECTION_BIT_bm;	// CCW motion
+			}
+			PORT_MOTOR_1_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;	// enable motor
+		}
+		st.m[MOTOR_2].phase_increment = spr->m[MOTOR_2].phase_increment;
+		if (spr->correction_flag == true) {
+			st.m[MOTOR_2].phase_accumulator = (int32_t)(st.m[MOTOR_2].phase_accumulator * spr->accumulator_correction);
+		}
+		if (st.m[MOTOR_2].phase_increment != 0) {
+			st_set_microsteps(MOTOR_2, spr->m[MOTOR_2].microstep_mode);
+			if (spr->m[MOTOR_2].dir == 0) {
+				PORT_MOTOR_2_VPORT.OUT &= ~DIRECTION_BIT_bm;
+			} else {
+				PORT_MOTOR_2_VPORT.OUT |= DIRECTION_BIT_bm;
+			}
+			PORT_MOTOR_2_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
+		}
+#if (MOTORS_IN_USE >= 3)
+		st.m[MOTOR_3].phase_increment = spr->m[MOTOR_3].phase_increment;
+		if (spr->correction_flag == true) {
+			st.m[MOTOR_3].phase_accumulator = (int32_t)(st.m[MOTOR_3].phase_accumulator * spr->accumulator_correction);
+		}
+		if (st.m[MOTOR_3].phase_increment != 0) {
+			st_set_microsteps(MOTOR_3, spr->m[MOTOR_3].microstep_mode);
+			if (spr->m[MOTOR_3].dir == 0) {
+				PORT_MOTOR_3_VPORT.OUT &= ~DIRECTION_BIT_bm;
+			} else {
+				PORT_MOTOR_3_VPORT.OUT |= DIRECTION_BIT_bm;
+			}
+			PORT_MOTOR_3_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
+		}
+#endif
+#if (MOTORS_IN_USE >= 4)
+		st.m[MOTOR_4].phase_increment = spr->m[MOTOR_4].phase_increment;
+		if (spr->correction_flag == true) {
+			st.m[MOTOR_4].phase_accumulator = (int32_t)(st.m[MOTOR_4].phase_accumulator * spr->accumulator_correction);
+		}
+		if (st.m[MOTOR_4].phase_increment != 0) {
+			st_set_microsteps(MOTOR_4, spr->m[MOTOR_4].microstep_mode);
+			if (spr->m[MOTOR_4].dir == 0) {
+				PORT_MOTOR_4_VPORT.OUT &= ~DIRECTION_BIT_bm;
+			} else {
+				PORT_MOTOR_4_VPORT.OUT |= DIRECTION_BIT_bm;
+			}
+			PORT_MOTOR_4_VPORT.OUT &= ~MOTOR_ENABLE_BIT_bm;
+		}
+#endif // MOTORS_IN_USE
+
+		// raster mode - step the laser power in lockstep with the segment
+		pwm_raster_load_segment();
+
+		// PPI mode - latch this segment's pulse rate (see pwm.c)
+		pwm_ppi_load_segment(spr->ppi_period);
+
+		// synchronized output - switch the output at the exact segment boundary.
+		// OUTSET/OUTCLR writes are atomic so no locking is needed (see gpio.c)
+		if (spr->sync_output & SYNC_OUTPUT_ARMED_bm) {
+			if (spr->sync_output & SYNC_OUTPUT_STATE_bm) {
+				gpio_set_bit_on(spr->sync_output & SYNC_OUTPUT_MASK_bm);
+			} else {
+				gpio_set_bit_off(spr->sync_output & SYNC_OUTPUT_MASK_bm);
+			}
+		}
+		// master marks every segment boundary on the sync line so running
+		// slaves can measure drift (see sync line notes below)
+		if (tg.network_mode == NETWORK_MASTER) {
+			NET_SYNC_PORT.OUTTGL = NET_SYNC_BIT_bm;
+		}
+#ifdef __STEP_DMA
+		_load_dma_segment();								// arm channels & start playback
+#else
+		TIMER_DDA.CTRLA = STEP_TIMER_ENABLE;				// enable the DDA timer
+#endif
+
+	// handle dwells - counted down on the RTC (see st_dwell_rtc_callback)
+	} else if (spr->move_type == MOVE_TYPE_DWELL) {
+		pwm_ppi_idle();									// no PPI pulses across a dwell
+		if (spr->prep_state == true) {
+			st.dwell_ticks_downcount = spr->dda_ticks;
+			// broadcast dwells stay fixed-time - slaves can't observe the tach
+			st.dwell_spindle_sync = ((spr->dwell_code == DWELL_CODE_SPINDLE_SYNC) &&
+									 (tg.network_mode != NETWORK_MASTER));
+		}
+	}
+
+	// all other cases drop to here (e.g. Null moves after Mcodes skip to here) 
+	spr->exec_state = PREP_BUFFER_OWNED_BY_EXEC;				// return the slot to exec
+	spr->prep_state = false;
+	spr = _advance_prep_buffer(spr);
+	ISR_PROFILE_END(pf_load);
+	st_request_exec_move();									// exec and prep next move
+}
+
+/*
+ * st_prep_line() - Prepare the next move for the loader
+ *
+ *	This function does the math on the next pulse segment and gets it ready for 
+ *	the loader. It deals with all the DDA optimizations and timer setups so that
+ *	loading can be performed as rapidly as possible. It works in joint space 
+ *	(motors) and it works in steps, not length units. All args are provided as 
+ *	floats and converted to their appropriate integer types for the loader. 
+ *
+ * Args:
+ *	steps[] are signed relative motion in steps (can be non-integer values)
+ *	Microseconds - how many microseconds the segment should run 
+ */
+
+stat_t st_prep_line(float steps[], float microseconds)
+{
+	uint8_t i;
+	int32_t steps_X_substeps[MOTORS];
+
+	// *** defensive programming ***
+	// trap float conditions the substeps path cannot see
+	if (isfinite(microseconds) == false) { return (STAT_MINIMUM_LENGTH_MOVE_ERROR);
+	} else if (microseconds < EPSILON) { return (STAT_MINIMUM_TIME_MOVE_ERROR);
+	}
+	rpt_mark_sr_dirty(SR_DIRTY_RUNTIME_bm);	// a segment is moving position and velocity
+	for (i=0; i<MOTORS; i++) {
+		steps_X_substeps[i] = (int32_t)(steps[i] * DDA_SUBSTEPS);
+	}
+	return (st_prep_line_substeps(steps_X_substeps, (uint32_t)microseconds));
+}
+
+/*
+ * st_prep_line_substeps() - fixed-point prep for the loader
+ *
+ *	Integer-only version of the prep math. Steps arrive already scaled by
+ *	DDA_SUBSTEPS (see ik_kinematics_substeps) so the software floating point
+ *	multiplies and fabs() calls are gone from the prep stage entirely. The
+ *	DDA period is selected per segment by the adaptive clock logic and the
+ *	tick count reduces to integer divides. This is the path used by _exec_aline_segment(); the
+ *	float st_prep_line() remains as a wrapper for callers that still work
+ *	in float steps.
+ */
+
+stat_t st_prep_line_substeps(int32_t steps_X_substeps[], uint32_t microseconds)
+{
+	uint8_t i;
+	uint32_t ticks;					// segment ticks at the full F_DDA clock
+	uint32_t max_substeps = 0;		// fastest motor in the segment
+	uint16_t divisor = 1;			// adaptive DDA clock divisor (power of 2)
+
+	// *** defensive programming ***
+	// trap conditions that would prevent queueing the line
+	if (spw->exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_INTERNAL_ERROR);
+	} else if (microseconds == 0) { return (STAT_MINIMUM_TIME_MOVE_ERROR);
+	}
+	spw->correction_flag = false;	// initialize accumulator correction flag for this move.
+	spw->sync_output = SYNC_OUTPUT_NONE;	// most segments carry no output command
+	if (dry.running == true) { tst_dry_run_add_time(microseconds);}	// dry run time accounting
+	ticks = microseconds / DDA_USEC_PER_TICK;
+
+	// setup motor parameters - integer math from here down
+	for (i=0; i<MOTORS; i++) {
+		uint8_t direction = 0;
+		if (steps_X_substeps[i] < 0) {
+			direction = 1;
+			spw->m[i].phase_increment = (uint32_t)(-steps_X_substeps[i]);
+		} else {
+			spw->m[i].phase_increment = (uint32_t)steps_X_substeps[i];
+		}
+		spw->m[i].dir = direction ^ cfg.m[i].polarity;
+
+		// backlash compensation - a reversing motor spends extra steps taking
+		// up the lash before the load moves, so inject them into the first
+		// segment of the reversal. The extra substeps ride in this segment's
+		// phase_increment budget (the divisor math below sees them), costing
+		// no planner buffers and no additional moves. Zero-step segments
+		// don't count as a reversal
+		if ((spw->m[i].phase_increment != 0) && (direction != sp_prev_direction[i])) {
+			if (sp_prev_direction[i] != 0xFF) {		// no takeup on the first move
+				spw->m[i].phase_increment += cfg.m[i].backlash_substeps;
+			}
+			sp_prev_direction[i] = direction;
+			sp_morph_residual[i] = 0;				// a carried residual belongs to the old direction
+			sp_scale_residual[i] = 0;
+		}
+
+		// microstep morphing - coarsen the mode-pin resolution for segments
+		// whose emitted step rate would overrun the DDA, and return to the
+		// configured resolution as the rate falls (thresholds in stepper.h)
+		spw->m[i].microstep_mode = 0;				// 0 = leave the mode pins alone
+		if ((tg.network_mode == NETWORK_STANDALONE) && (spw->m[i].phase_increment != 0)) {
+			uint8_t shift = sp_morph_shift[i];
+			while (((cfg.m[i].microsteps >> (shift+1)) != 0) &&
+				   ((spw->m[i].phase_increment >> shift) >
+					(ticks * (DDA_SUBSTEPS / MICROSTEP_MORPH_OVERSAMPLE)))) {
+				shift++;							// rate overruns the DDA - coarsen
+			}
+			while ((shift != 0) &&
+				   ((spw->m[i].phase_increment >> (shift-1)) <=
+					(ticks * (DDA_SUBSTEPS / (MICROSTEP_MORPH_OVERSAMPLE * MICROSTEP_MORPH_HYSTERESIS))))) {
+				shift--;							// rate has fallen well clear - refine
+			}
+			if (shift != 0) {	// scale the steps; carry truncated substeps into the next segment
+				uint32_t substeps = spw->m[i].phase_increment + sp_morph_residual[i];
+				spw->m[i].phase_increment = substeps >> shift;
+				sp_morph_residual[i] = substeps - (spw->m[i].phase_increment << shift);
+			} else {
+				spw->m[i].phase_increment += sp_morph_residual[i];
+				sp_morph_residual[i] = 0;
+			}
+			spw->m[i].microstep_mode = cfg.m[i].microsteps >> shift;
+			sp_morph_shift[i] = shift;
+		}
+		if (spw->m[i].phase_increment > max_substeps) {
+			max_substeps = spw->m[i].phase_increment;
+		}
+	}
+
+	// adaptive DDA clock - downshift the interrupt rate for slow segments.
+	// Each halving must leave DDA_OVERSAMPLE ticks per whole step on the 
+	// fastest motor and DDA_TICKS_MIN ticks in the segment (see stepper.h)
+	while ((divisor < DDA_DIVISOR_MAX) &&
+		   ((ticks / (divisor << 1)) >= DDA_TICKS_MIN) &&
+		   (((ticks / (divisor << 1)) * (DDA_SUBSTEPS / DDA_OVERSAMPLE)) >= max_substeps)) {
+		divisor <<= 1;
+	}
+	spw->dda_period = DDA_PERIOD * divisor;
+	spw->dda_ticks = ticks / divisor;
+
+	// adaptive substep scaling - re-scale the substep factor per segment by a
+	// power of two chosen from the tick count: up while the accumulator range
+	// (dda_ticks X substeps) and the motor increments keep headroom, down if
+	// the range term would overflow int32 on a very long slow segment
+	// (thresholds and rationale in stepper.h)
+	uint32_t scale = DDA_SUBSTEPS;
+	uint8_t up = 0;
+	uint8_t down = 0;
+	while ((down < DDA_SUBSTEP_SHIFT_MAX) &&
+		   (spw->dda_ticks > (DDA_SUBSTEP_HEADROOM / scale))) {
+		scale >>= 1;
+		down++;
+	}
+	while ((down == 0) && (up < DDA_SUBSTEP_SHIFT_MAX) &&
+		   (spw->dda_ticks <= (DDA_SUBSTEP_HEADROOM / (scale << 1))) &&
+		   (max_substeps < (DDA_SUBSTEP_HEADROOM >> 1))) {
+		scale <<= 1;
+		max_substeps <<= 1;
+		up++;
+	}
+	spw->dda_ticks_X_substeps = spw->dda_ticks * scale;			// see FOOTNOTE
+	for (i=0; i<MOTORS; i++) {	// re-denominate the motor increments to match
+		if (spw->m[i].phase_increment == 0) { continue;}	// hold residuals for a stepping segment
+		uint32_t substeps = spw->m[i].phase_increment + sp_scale_residual[i];
+		if (down == 0) {		// a carried residual is base-unit - the shift re-denominates it too
+			spw->m[i].phase_increment = substeps << up;
+			sp_scale_residual[i] = 0;
+		} else {				// carry truncated substeps into the next segment
+			spw->m[i].phase_increment = substeps >> down;
+			sp_scale_residual[i] = substeps - (spw->m[i].phase_increment << down);
+		}
+	}
+
+	// phase-continuous handoff - compute the accumulator rescale factor here
+	// (MED level) so the loader only pays one multiply per motor (see stepper.h)
+	if ((sp_prev_ticks_X_substeps != 0) &&
+		(sp_prev_ticks_X_substeps != spw->dda_ticks_X_substeps)) {
+		spw->accumulator_correction = (float)spw->dda_ticks_X_substeps / sp_prev_ticks_X_substeps;
+		spw->correction_flag = true;
+	}
+	sp_prev_ticks_X_substeps = spw->dda_ticks_X_substeps;
+#ifdef __STEP_DMA
+	_render_dma_patterns();		// run the segment DDA now - may clamp spw->dda_ticks
+#endif
+	if (tg.network_mode == NETWORK_MASTER) { _broadcast_prep_segment();}
+	spw->ppi_period = pwm_ppi_prep_segment(steps_X_substeps, microseconds);	// PPI pulse rate rides with the segment (see pwm.c)
+	spw->move_type = MOVE_TYPE_ALINE;
+	spw->prep_state = true;
+	return (STAT_OK);
+}
+
+/*
+ * _broadcast_prep_segment()   - master: put the staged segment on the wire
+ * st_load_segment_remote()    - slave: stage a received segment for the loader
+ * st_load_dwell_remote()      - slave: stage a received dwell
+ *
+ *	The multi-board wire payload (netSegment_t, network.h) carries the raw
+ *	direction - the master's polarity is backed out on send and each slave
+ *	applies its own, so per-board polarity settings keep working. Slaves
+ *	recompute the accumulator correction locally from their own previous
+ *	segment, which is the same math the master ran, and do the loader
+ *	handoff themselves since no exec stage runs on a slave.
+ */
+static void _broadcast_prep_segment()
+{
+	netSegment_t seg;
+
+	seg.dda_period = spw->dda_period;
+	seg.dda_ticks = spw->dda_ticks;
+	seg.dda_ticks_X_substeps = spw->dda_ticks_X_substeps;
+	for (uint8_t i=0; i<MOTORS; i++) {
+		seg.m[i].phase_increment = spw->m[i].phase_increment;
+		seg.m[i].dir = spw->m[i].dir ^ cfg.m[i].polarity;	// back out local polarity
+	}
+	net_broadcast_segment(&seg);
+}
+
+stat_t st_load_segment_remote(struct netSegment *seg)
+{
+	if (spw->exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_EAGAIN);}
+	spw->correction_flag = false;
+	spw->sync_output = SYNC_OUTPUT_NONE;
+	spw->ppi_period = 0;				// PPI pulsing is not carried on the wire
+	spw->dda_period = seg->dda_period;
+	spw->dda_ticks = seg->dda_ticks;
+	spw->dda_ticks_X_substeps = seg->dda_ticks_X_substeps;
+	for (uint8_t i=0; i<MOTORS; i++) {
+		spw->m[i].phase_increment = seg->m[i].phase_increment;
+		spw->m[i].dir = seg->m[i].dir ^ cfg.m[i].polarity;
+		spw->m[i].microstep_mode = 0;	// no morphing on the wire - leave the pins alone
+	}
+	if (nss.offset_fresh == true) {		// drift trim - see sync line notes below
+		nss.offset_fresh = false;
+		uint32_t late = nss.boundary_offset;
+		if ((late > 0) && (late <= NET_SYNC_TRIM_TICKS) && (spw->dda_ticks > 1)) {
+			spw->dda_ticks -= 1;		// running late - shorten a segment by one tick
+		} else if ((late > 0) && (seg->dda_ticks > late) &&
+				  ((seg->dda_ticks - late) <= NET_SYNC_TRIM_TICKS)) {
+			spw->dda_ticks += 1;		// running early - stretch a segment by one tick
+		}
+	}
+	if ((sp_prev_ticks_X_substeps != 0) &&
+		(sp_prev_ticks_X_substeps != spw->dda_ticks_X_substeps)) {
+		spw->accumulator_correction = (float)spw->dda_ticks_X_substeps / sp_prev_ticks_X_substeps;
+		spw->correction_flag = true;
+	}
+	sp_prev_ticks_X_substeps = spw->dda_ticks_X_substeps;
+#ifdef __STEP_DMA
+	_render_dma_patterns();
+#endif
+	spw->move_type = MOVE_TYPE_ALINE;
+	spw->prep_state = true;
+	spw->exec_state = PREP_BUFFER_OWNED_BY_LOADER;	// loader handoff (no exec stage here)
+	spw = _advance_prep_buffer(spw);
+	_request_load_move();
+	return (STAT_OK);
+}
+
+stat_t st_load_dwell_remote(uint32_t ticks)
+{
+	if (spw->exec_state != PREP_BUFFER_OWNED_BY_EXEC) { return (STAT_EAGAIN);}
+	spw->move_type = MOVE_TYPE_DWELL;
+	spw->prep_state = true;
+	spw->dda_ticks = ticks;
+	spw->exec_state = PREP_BUFFER_OWNED_BY_LOADER;
+	spw = _advance_prep_buffer(spw);
+	_request_load_move();
+	return (STAT_OK);
+}
+
+/*
+ * Sync line - clock-synchronized DDA start and drift trim (multi-board)
+ *
+ *	The sync line (NET_SYNC_PORT/BIT, network.h) is wired board-to-board.
+ *	The master toggles it at every segment load, so each edge marks a
+ *	master segment boundary. Two uses:
+ *
+ *	1. Start alignment. When motion starts from idle the loader does not
+ *	   start the DDA directly - it arms nss.start_armed and waits for an
+ *	   edge (the master requests one via net_request_sync_pulse() once
+ *	   its broadcast frames have drained - see network.c). The edge ISR
+ *	   runs _load_move() on every board, so DDA timers start within ISR
+ *	   latency of each other - about a microsecond, under one DDA tick.
+ *
+ *	2. Drift trim (slaves). While running, each edge samples how many DDA
+ *	   ticks the slave still owes on its current segment. A perfectly
+ *	   aligned slave reads 0 (or a full segment, right after its own
+ *	   reload). A small residue means crystal drift - the next remote
+ *	   segment is trimmed by one tick in the catch-up direction, bounded
+ *	   by NET_SYNC_TRIM_TICKS so a bad sample can't distort motion. The
+ *	   un-issued phase carries in the accumulator, so position is exact -
+ *	   only timing shifts, which is the point.
+ */
+ISR(NET_SYNC_ISR_vect)
+{
+	NET_SYNC_PORT.INTFLAGS = PORT_INT0IF_bm;
+	if (nss.start_armed == true) {
+		nss.start_armed = false;
+		_load_move();					// aligned DDA start on all boards
+		return;
+	}
+	if (tg.network_mode == NETWORK_SLAVE) {
+		nss.boundary_offset = (int32_t)st.dda_ticks_downcount + st.dda_ticks_remaining;
+		nss.offset_fresh = true;
+	}
+}
+// FOOTNOTE: This expression was previously computed as below but floating
+// point rounding errors caused subtle and nasty accumulated position errors:
+//	sp.dda_ticks_X_substeps = (uint32_t)((microseconds/1000000) * f_dda * dda_substeps);
+
+/*
+ * st_prep_sync_output() - attach an output command to the segment just prepped
+ *
+ *	Called by the exec level after st_prep_line_substeps() has prepped the
+ *	first segment of a move carrying an M62/M63 command. The loader switches
+ *	the output just before it starts the segment clock, so actuation lands on
+ *	the exact segment boundary with no main loop polling involved.
+ */
+
+void st_prep_sync_output(uint8_t sync)
+{
+	spw->sync_output = sync;
+}
+
+/*
+ * st_prep_null() - Keeps the loader happy. Otherwise performs no action
+ *
+ *	Used by M codes, tool and spindle changes
+ */
+
+void st_prep_null()
+{
+	spw->move_type = MOVE_TYPE_NULL;
+	spw->prep_state = true;
+}
+
+/* 
+ * st_prep_dwell() 	 - Add a dwell to the move buffer
+ */
+
+void st_prep_dwell(float microseconds, uint8_t dwell_code)
+{
+	if (dry.running == true) { tst_dry_run_add_time((uint32_t)microseconds);}	// dry run time accounting
+	spw->move_type = MOVE_TYPE_DWELL;
+	spw->prep_state = true;
+	spw->dwell_code = dwell_code;
+	spw->dda_ticks = (uint32_t)(microseconds / (RTC_MILLISECONDS * 1000));	// RTC ticks
+	if (spw->dda_ticks == 0) { spw->dda_ticks = 1;}	// dwells quantize to 10ms, minimum one tick
+	if (tg.network_mode == NETWORK_MASTER) { net_broadcast_dwell(spw->dda_ticks);}
+}
+
+/*
+ * st_isbusy() - return TRUE if motors are running or a dwell is running
+ */
+inline uint8_t st_isbusy()
+{
+	if ((st.dda_ticks_downcount == 0) && (st.dwell_ticks_downcount == 0)) {
+		return (false);
+	} 
+	return (true);
+}
+
+/*
+ * st_get_dda_fraction() - fraction of the loaded segment the DDA has run
+ *
+ *	ISR-callable. The DDA downcounter is the finest-grained timestamp this
+ *	hardware has left (all the timers are allocated), so switch edge capture
+ *	dates an edge by how far the downcounter has run into the segment. The
+ *	segment's starting tick count is carried in the run struct (it can no
+ *	longer be recovered from dda_ticks_X_substeps since the substep scale
+ *	is per-segment). Returns 1 if no segment is running.
+ */
+float st_get_dda_fraction()
+{
+	if ((st.dda_ticks_total == 0) || (st.dda_ticks_downcount == 0)) { return (1);}
+	int32_t ticks_left = (int32_t)st.dda_ticks_downcount + st.dda_ticks_remaining;
+	return (1 - ((float)ticks_left / (float)st.dda_ticks_total));
+}
+
+/*
+ * st_set_polarity() - setter needed by the config system
+ */
+
+void st_set_polarity(const uint8_t motor, const uint8_t polarity)
+{
+	st.m[motor].polarity = polarity;
+}
+
+/*
+ * st_set_microsteps() - set microsteps in hardware
+ *
+ *	The microstep_mode is the same as the microsteps (1,2,4,8). With
+ *	microstep morphing the loader calls this at segment boundaries (HI
+ *	level), so the mode on the pins is remembered and redundant writes
+ *	are skipped. A mode of 0 leaves the pins alone (idle motors, and
+ *	segments received over the wire, carry no morph decision).
+ */
+
+void st_set_microsteps(const uint8_t motor, const uint8_t microstep_mode)
+{
+	if (microstep_mode == 0) { return;}
+	if (microstep_mode == st_microstep_mode[motor]) { return;}
+	st_microstep_mode[motor] = microstep_mode;
+	if (microstep_mode == 8) {
+		device.st_port[motor]->OUTSET = MICROSTEP_BIT_0_bm;
+		device.st_port[motor]->OUTSET = MICROSTEP_BIT_1_bm;
+	} else if (microstep_mode == 4) {
+		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_0_bm;
+		device.st_port[motor]->OUTSET = MICROSTEP_BIT_1_bm;
+	} else if (microstep_mode == 2) {
+		device.st_port[motor]->OUTSET = MICROSTEP_BIT_0_bm;
+		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_1_bm;
+	} else if (microstep_mode == 1) {
+		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_0_bm;
+		device.st_port[motor]->OUTCLR = MICROSTEP_BIT_1_bm;
+	}
+}
+
+
+/**** ISR profiling ****
+ *
+ *	See stepper.h for an overview. The accumulation bins are written at the
+ *	HI interrupt level and rolled up into the isr_rpt floats once per second
+ *	by the RTC callback (LO level). The bins are reset at each rollup so the
+ *	"isr" group always reports the previous whole second.
+ */
+
+#ifdef __ISR_PROFILE
+
+static uint8_t pf_rtc_ticks;		// RTC ticks toward the 1 second rollup
+
+static void _isr_profile_rollup(stProfileBin_t *bin, float *min, float *max, float *avg)
+{
+	if (bin->count == 0) {
+		*min = 0; *max = 0; *avg = 0;
+	} else {
+		*min = (float)bin->min / PROFILE_TICKS_PER_USEC;
+		*max = (float)bin->max / PROFILE_TICKS_PER_USEC;
+		*avg = ((float)bin->sum / bin->count) / PROFILE_TICKS_PER_USEC;
+	}
+	bin->min = 0; bin->max = 0; bin->sum = 0; bin->count = 0;
+}
+
+void st_isr_profile_rtc_callback()	// called by 10ms real-time clock
+{
+	if (++pf_rtc_ticks < (1000 / RTC_MILLISECONDS)) { return;}
+	pf_rtc_ticks = 0;
+	_isr_profile_rollup(&pf_dda, &isr_rpt.dda_min, &isr_rpt.dda_max, &isr_rpt.dda_avg);
+	_isr_profile_rollup(&pf_load, &isr_rpt.load_min, &isr_rpt.load_max, &isr_rpt.load_avg);
+	_isr_profile_rollup(&pf_exec, &isr_rpt.exec_min, &isr_rpt.exec_max, &isr_rpt.exec_avg);
+	mp_tune_segment_usec(isr_rpt.exec_max);		// adapt the segment time (see plan_line.c)
+	isr_rpt.seg_usec = mp_get_segment_usec();
+}
+#endif // __ISR_PROFILE
+
+
+/**** DEBUG routines ****/
+/*
+ * st_dump_stepper_state()
+ */
+
+#ifdef __DEBUG
+
+static const char sts_sing[] PROGMEM = "stSingleton dda_ticks (remaining):%d\n";
+static const char sts_timr[] PROGMEM = "  timer %s  enabled:%d  period:%d\n";
+static const char sts_motr[] PROGMEM = "  motor[%d] pol:%d  steps:%d  counter:%d\n";
+
+void st_dump_stepper_state()
+{
+	uint8_t i;
+
+	fprintf_P(stderr, (PGM_P)sts_sing, (int32_t)st.dda_ticks_downcount + st.dda_ticks_remaining);
+
+	fprintf_P(stderr, (PGM_P)sts_timr, "dda", TIMER_DDA.CTRLA, TIMER_DDA.PER);
+	fprintf_P(stderr, (PGM_P)sts_timr, "dwl", TIMER_DWELL.CTRLA, TIMER_DWELL.PER);
+	fprintf_P(stderr, (PGM_P)sts_timr, "load", TIMER_LOAD.CTRLA, TIMER_LOAD.PER);
+	fprintf_P(stderr, (PGM_P)sts_timr, "exec", TIMER_EXEC.CTRLA, TIMER_EXEC.PER);
+
+	for (i=0; i<MOTORS; i++) {
+		fprintf_P(stderr, (PGM_P)sts_motr, i, 
+			st.m[i].polarity,
+			st.m[i].phase_increment,
+			st.m[i].phase_accumulator);
+	}
+}
+
+// dump_set_f_dda(*f_dda, *dda_substeps, major_axis_steps, microseconds, f_dda_base);
+
+#endif
@@ -1,179 +1,353 @@
-/* stepper.h - stepper motor interface
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* 
- *	Coordinated motion (line drawing) is performed using a classic 
- *	Bresenham DDA as per reprap and grbl. A number of additional steps 
- *	are taken to optimize interpolation and pulse train accuracy.
- *
- *	- The DDA accepts and processes fractional motor steps. Steps are 
- *	  passed to the move queue as floats, and do not need to be integer
- *	  values. The DDA implements fractional steps and interpolation by 
- *	  extending the counter range downward using the DDA_SUBSTEPS setting. 
- *
- *	- The DDA is not used as a 'ramp' for acceleration management. Accel
- *	  is computed as 3rd order (controlled jerk) equations that generate 
- *	  accel/decel segments to the DDA in much the same way arc drawing
- *	  is approximated. The DDA runs at a constant rate for each segment,
- *	  up to a maximum of 50 Khz step rate.
- *
- *	- The DDA rate for a segment is set to an integer multiple of the 
- *	  step freqency of the fastest motor (major axis). This amount of 
- *	  overclocking is controlled by the DDA_OVERCLOCK value, typically 16x.
- *	  A minimum DDA rate is enforced that prevents overflowing the 16 bit 
- *	  DDA timer PERIOD value. The DDA timer always runs at 32 Mhz: the 
- *	  prescaler is not used. Various methods are used to keep the numbers 
- *	  in range for long lines. See _st_set_f_dda() for details.
- *
- *	- Pulse phasing is preserved between segments if possible. This makes
- *	  for smoother motion, particularly at very low speeds and short 
- *	  segment lengths (avoids pulse jitter). Phase continuity is achieved 
- *	  by simply not resetting the DDA counters across segments. In some 
- *	  cases the differences between timer values across segments are too 
- *	  large for this to work, and you risk motor stalls due to pulse 
- *	  starvation. These cases are detected and the counters are reset 
- *	  to prevent stalling.
- *
- *  - Pulse phasing is also helped by minimizing the time spent loading 
- *	  the next move segment. To this end as much as possible about that 
- *	  move is pre-computed during move execution. Also, all moves are 
- *	  loaded from the interrupt level, avoiding the need for mutual 
- *	  exclusion locking or volatiles (which slow things down).
- */
-
-#ifndef stepper_h
-#define stepper_h
-
-void st_init(void);				// initialize stepper subsystem
-
-void st_enable_motor(const uint8_t motor);
-void st_enable_motors(void);
-void st_disable_motor(const uint8_t motor);
-void st_disable_motors(void);
-void st_start_disable_motors_timer(void);
-void st_disable_motors_rtc_callback(void);
-void st_kill_motors(void);		// stop all motors (stop the steppers)
-
-uint8_t st_isbusy(void);		// return TRUE is any axis is running (F=idle)
-void st_set_polarity(const uint8_t motor, const uint8_t polarity);
-void st_set_microsteps(const uint8_t motor, const uint8_t microstep_mode);
-void st_set_power_mode(const uint8_t motor, const uint8_t power_mode);
-
-uint8_t st_test_prep_state(void);
-void st_request_exec_move(void);
-void st_prep_null(void);
-void st_prep_dwell(float microseconds);
-stat_t st_prep_line(float steps[], float microseconds);
-
-uint16_t st_get_st_magic(void);
-uint16_t st_get_sps_magic(void);
-
-#ifdef __DEBUG
-void st_dump_stepper_state(void);
-#endif
-
-// handy macro
-#define _f_to_period(f) (uint16_t)((float)F_CPU / (float)f)
-
-/*
- * Stepper configs and constants
- */
-
-/* DDA substepping
- * 	DDA_SUBSTEPS sets the amount of fractional precision for substepping.
- *	Substepping is kind of like microsteps done in software to make
- *	interpolation more accurate.
- *
- *	Set to 1 to disable, but don't do this or you will lose a lot of accuracy.
- */
-//#define DDA_SUBSTEPS 1000000		// 100,000 accumulates substeps to 6 decimal places
-#define DDA_SUBSTEPS 100000		// 100,000 accumulates substeps to 6 decimal places
-
-/* DDA overclocking
- * 	Overclocking multiplies the step rate of the fastest axis (major axis) 
- *	by an integer value up to the DDA_OVERCLOCK value. This makes the 
- *	interpolation of the non-major axes more accurate than simply setting
- *	the DDA to the speed of the major axis; and allows the DDA to run at 
- *	less than the max frequency when possible.
- *
- *	Set to 0 to disable.
- *
- *	NOTE: TinyG doesn't use tunable overclocking any more. It just overclocks
- *	at the fastest sustainable step rate which is about 50 Khz for the xmega.
- *	This minimizes the aliasing on minor axes at minimal impact to the major 
- *	axis. The DDA overclock setting and associated code are left in for historical
- *	purposes and in case we ever want to go back to pure overclocking.
- *
- *	Setting this value to 0 has the effect of telling the optimizer to take out
- *	entire code regions that are not called if this value is zero. So they are 
- *	left in for historical purposes and not commented out. These regions are noted.
- */
-//#define DDA_OVERCLOCK 16		// doesn't have to be a binary multiple
-#define DDA_OVERCLOCK 0			// Permanently disabled. See above NOTE
-
-/* Accumulator resets
- * 	You want to reset the DDA accumulators if the new ticks value is way less 
- *	than previous value, but otherwise you should leave the accumulators alone.
- *	Preserving the accumulator value from the previous segment aligns pulse 
- *	phasing between segments. However, if the new accumulator is going to be 
- *	much less than the old one you must reset it or risk motor stalls.
- */
-#define ACCUMULATOR_RESET_FACTOR 2	// amount counter range can safely change
-
-/* DDA minimum operating frequency
- *	This is the minumum value the DDA time can run with a fixed 32 Mhz 
- *	clock. Anything lower will overflow the 16 bit PERIOD register.
- */
-//#define F_DDA_MIN (float)489	// hz
-#define F_DDA_MIN (float)500	// hz - is 489 Hz with some margin
-
-/* Timer settings for stepper module. See system.h for timer assignments
- */
-#define F_DDA 		(float)50000	// DDA frequency in hz.
-#define F_DWELL		(float)10000	// Dwell count frequency in hz.
-#define SWI_PERIOD 	100				// cycles you have to shut off SW interrupt
-#define TIMER_PERIOD_MIN (20)		// used to trap bad timer loads
-
-// Timer setups
-#define STEP_TIMER_TYPE		TC0_struct // stepper subsubstem uses all the TC0's
-#define STEP_TIMER_DISABLE 	0		// turn timer off (clock = 0 Hz)
-#define STEP_TIMER_ENABLE	1		// turn timer clock on (F_CPU = 32 Mhz)
-#define STEP_TIMER_WGMODE	0		// normal mode (count to TOP and rollover)
-
-#define TIMER_DDA_ISR_vect	TCC0_OVF_vect	// must agree with assignment in system.h
-#define TIMER_DWELL_ISR_vect TCD0_OVF_vect	// must agree with assignment in system.h
-#define TIMER_LOAD_ISR_vect	TCE0_OVF_vect	// must agree with assignment in system.h
-#define TIMER_EXEC_ISR_vect	TCF0_OVF_vect	// must agree with assignment in system.h
-
-#define TIMER_OVFINTLVL_HI	3		// timer interrupt level (3=hi)
-#define	TIMER_OVFINTLVL_MED 2;		// timer interrupt level (2=med)
-#define	TIMER_OVFINTLVL_LO  1;		// timer interrupt level (1=lo)
-
-#define TIMER_DDA_INTLVL 	TIMER_OVFINTLVL_HI
-#define TIMER_DWELL_INTLVL	TIMER_OVFINTLVL_HI
-#define TIMER_LOAD_INTLVL	TIMER_OVFINTLVL_HI
-#define TIMER_EXEC_INTLVL	TIMER_OVFINTLVL_LO
-
-#endif
+/* stepper.h - stepper motor interface
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* 
+ *	Coordinated motion (line drawing) is performed using a classic 
+ *	Bresenham DDA as per reprap and grbl. A number of additional steps 
+ *	are taken to optimize interpolation and pulse train accuracy.
+ *
+ *	- The DDA accepts and processes fractional motor steps. Steps are 
+ *	  passed to the move queue as floats, and do not need to be integer
+ *	  values. The DDA implements fractional steps and interpolation by 
+ *	  extending the counter range downward using the DDA_SUBSTEPS setting. 
+ *
+ *	- The DDA is not used as a 'ramp' for acceleration management. Accel
+ *	  is computed as 3rd order (controlled jerk) equations that generate 
+ *	  accel/decel segments to the DDA in much the same way arc drawing
+ *	  is approximated. The DDA runs at a constant rate for each segment,
+ *	  up to a maximum of 50 Khz step rate.
+ *
+ *	- The DDA rate for a segment is set to an integer multiple of the 
+ *	  step freqency of the fastest motor (major axis). This amount of 
+ *	  overclocking is controlled by the DDA_OVERCLOCK value, typically 16x.
+ *	  A minimum DDA rate is enforced that prevents overflowing the 16 bit 
+ *	  DDA timer PERIOD value. The DDA timer always runs at 32 Mhz: the 
+ *	  prescaler is not used. Various methods are used to keep the numbers 
+ *	  in range for long lines. See _st_set_f_dda() for details.
+ *
+ *	- Pulse phasing is preserved between segments if possible. This makes
+ *	  for smoother motion, particularly at very low speeds and short 
+ *	  segment lengths (avoids pulse jitter). Phase continuity is achieved 
+ *	  by simply not resetting the DDA counters across segments. In some 
+ *	  cases the differences between timer values across segments are too 
+ *	  large for this to work, and you risk motor stalls due to pulse 
+ *	  starvation. These cases are detected and the counters are reset 
+ *	  to prevent stalling.
+ *
+ *  - Pulse phasing is also helped by minimizing the time spent loading 
+ *	  the next move segment. To this end as much as possible about that 
+ *	  move is pre-computed during move execution. Also, all moves are 
+ *	  loaded from the interrupt level, avoiding the need for mutual 
+ *	  exclusion locking or volatiles (which slow things down).
+ */
+
+#ifndef stepper_h
+#define stepper_h
+
+/* Synchronized outputs
+ *	An output command can ride along with a move and is applied by the loader
+ *	at the exact start of the move's first segment (see _load_move). The
+ *	command is packed in one byte so it travels from the M62/M63 block through
+ *	the planner buffer and the prep slot without any further bookkeeping.
+ */
+#define SYNC_OUTPUT_NONE		0
+#define SYNC_OUTPUT_ARMED_bm	(1<<7)	// an output command is present
+#define SYNC_OUTPUT_STATE_bm	(1<<6)	// turn the output on (off if clear)
+#define SYNC_OUTPUT_MASK_bm		0x0F	// output select mask (see gpio_set_bit_on)
+
+// Dwell codes - passed from the planner through st_prep_dwell()
+#define DWELL_CODE_PLAIN		0		// ordinary timed dwell
+#define DWELL_CODE_SPINDLE_SYNC	1		// releases early when the spindle tach reports at-speed
+
+void st_init(void);				// initialize stepper subsystem
+
+void st_enable_motor(const uint8_t motor);
+void st_enable_motors(void);
+void st_disable_motor(const uint8_t motor);
+void st_disable_motors(void);
+void st_start_disable_motors_timer(void);
+void st_disable_motors_rtc_callback(void);
+void st_dwell_rtc_callback(void);
+void st_kill_motors(void);		// stop all motors (stop the steppers)
+
+uint8_t st_isbusy(void);		// return TRUE is any axis is running (F=idle)
+float st_get_dda_fraction(void);// fraction of the loaded segment the DDA has run
+void st_set_polarity(const uint8_t motor, const uint8_t polarity);
+void st_set_microsteps(const uint8_t motor, const uint8_t microstep_mode);
+void st_set_power_mode(const uint8_t motor, const uint8_t power_mode);
+
+uint8_t st_test_prep_state(void);
+void st_request_exec_move(void);
+void st_prep_null(void);
+void st_prep_dwell(float microseconds, uint8_t dwell_code);
+stat_t st_prep_line(float steps[], float microseconds);
+stat_t st_prep_line_substeps(int32_t steps_X_substeps[], uint32_t microseconds);
+
+struct netSegment;					// RS485 multi-board wire payload - see network.h
+stat_t st_load_segment_remote(struct netSegment *seg);
+stat_t st_load_dwell_remote(uint32_t ticks);
+void st_prep_sync_output(uint8_t sync);
+
+uint16_t st_get_st_magic(void);
+uint16_t st_get_sps_magic(void);
+
+#ifdef __ISR_PROFILE
+void st_isr_profile_rtc_callback(void);
+
+typedef struct isrProfileReport {	// once-per-second rollup, all values in uSec
+	float dda_min;					// shortest DDA ISR pass
+	float dda_max;					// longest DDA ISR pass
+	float dda_avg;					// average DDA ISR pass
+	float load_min;					// shortest _load_move() pass
+	float load_max;					// longest _load_move() pass
+	float load_avg;					// average _load_move() pass
+	float exec_min;					// shortest exec SW interrupt pass
+	float exec_max;					// longest exec SW interrupt pass - drives segment time adaptation
+	float exec_avg;					// average exec SW interrupt pass
+	float seg_usec;					// current adaptive segment time (see mp_tune_segment_usec)
+} isrProfileReport_t;
+isrProfileReport_t isr_rpt;			// read by the "isr" cmdObj group (config.c)
+#endif
+
+#ifdef __DEBUG
+void st_dump_stepper_state(void);
+#endif
+
+// handy macro
+#define _f_to_period(f) (uint16_t)((float)F_CPU / (float)f)
+
+/*
+ * Stepper configs and constants
+ */
+
+/* DDA substepping
+ * 	DDA_SUBSTEPS sets the amount of fractional precision for substepping.
+ *	Substepping is kind of like microsteps done in software to make
+ *	interpolation more accurate.
+ *
+ *	Set to 1 to disable, but don't do this or you will lose a lot of accuracy.
+ */
+//#define DDA_SUBSTEPS 1000000		// 100,000 accumulates substeps to 6 decimal places
+#define DDA_SUBSTEPS 100000		// 100,000 accumulates substeps to 6 decimal places
+
+/* DDA overclocking
+ * 	Overclocking multiplies the step rate of the fastest axis (major axis) 
+ *	by an integer value up to the DDA_OVERCLOCK value. This makes the 
+ *	interpolation of the non-major axes more accurate than simply setting
+ *	the DDA to the speed of the major axis; and allows the DDA to run at 
+ *	less than the max frequency when possible.
+ *
+ *	Set to 0 to disable.
+ *
+ *	NOTE: TinyG doesn't use tunable overclocking any more. It just overclocks
+ *	at the fastest sustainable step rate which is about 50 Khz for the xmega.
+ *	This minimizes the aliasing on minor axes at minimal impact to the major 
+ *	axis. The DDA overclock setting and associated code are left in for historical
+ *	purposes and in case we ever want to go back to pure overclocking.
+ *
+ *	Setting this value to 0 has the effect of telling the optimizer to take out
+ *	entire code regions that are not called if this value is zero. So they are 
+ *	left in for historical purposes and not commented out. These regions are noted.
+ */
+//#define DDA_OVERCLOCK 16		// doesn't have to be a binary multiple
+#define DDA_OVERCLOCK 0			// Permanently disabled. See above NOTE
+
+/* Accumulator handoff
+ * 	The DDA accumulators are denominated in the segment's ticks_X_substeps
+ *	range, so when that range changes between segments the carried value
+ *	means a different phase angle. The old code zeroed the accumulators when
+ *	the range shrank sharply (ACCUMULATOR_RESET_FACTOR), which threw away
+ *	sub-step position and caused micro-velocity ripple at segment boundaries.
+ *	The prep routine now computes a rescale factor (new range / old range)
+ *	and the loader multiplies it into each accumulator, preserving the phase
+ *	angle exactly. The factor is computed at MED level so the loader only
+ *	pays one float multiply per motor, and only when the range changed.
+ */
+
+/* DDA minimum operating frequency
+ *	This is the minumum value the DDA time can run with a fixed 32 Mhz 
+ *	clock. Anything lower will overflow the 16 bit PERIOD register.
+ */
+//#define F_DDA_MIN (float)489	// hz
+#define F_DDA_MIN (float)500	// hz - is 489 Hz with some margin
+
+/* ISR profiling
+ *	The profiler samples a free-running timer (TIMER_PROFILE, div1 off F_CPU)
+ *	at entry and exit of the DDA ISR and the loader and accumulates min/max/
+ *	avg occupancy. The accumulation bins are rolled up into isr_rpt once per
+ *	second by the RTC callback. Only compiled in __ISR_PROFILE builds - the
+ *	sampling costs a handful of cycles per ISR pass.
+ */
+#ifdef __ISR_PROFILE
+#define TIMER_PROFILE		TIMER_5		// free running profile timebase (TCC1)
+#define PROFILE_TICKS_PER_USEC (F_CPU/1000000)	// 32 ticks per uSec
+#endif
+
+/* Step pulse stretching
+ *	Some external drivers need 2-5 uSec step pulses instead of the ~1 uSec
+ *	produced by the back-to-back OUT writes in the DDA ISR. The step bits
+ *	are not on timer waveform output pins, so the compare channels cannot
+ *	stretch them in hardware directly. Instead __STEP_PULSE_TIMER leaves
+ *	the step bits raised and clears them from a one-shot pulse-off timer
+ *	interrupt, so the DDA ISR body stays short regardless of the width.
+ *	Uses TIMER_5 (TCC1) and is therefore mutually exclusive with the
+ *	__ISR_PROFILE instrumentation.
+ */
+#ifdef __STEP_PULSE_TIMER
+#ifdef __ISR_PROFILE
+#error __STEP_PULSE_TIMER and __ISR_PROFILE both use TIMER_5 - enable only one
+#endif
+#define TIMER_PULSE			TIMER_5			// pulse-off one-shot timer (TCC1)
+#define TIMER_PULSE_ISR_vect TCC1_OVF_vect	// must agree with assignment in system.h
+#ifndef STEP_PULSE_USEC
+#define STEP_PULSE_USEC		3				// step pulse width; override in machine profile
+#endif
+#endif // __STEP_PULSE_TIMER
+
+/* Timer settings for stepper module. See system.h for timer assignments
+ */
+#define F_DDA 		(float)50000	// DDA frequency in hz.
+// Dwells are counted down on the 10ms RTC (see st_dwell_rtc_callback)
+
+/* Fixed-point prep path constants
+ *	The substeps prep path (st_prep_line_substeps) runs in pure integer math.
+ *	These are compile-time reductions of the float expressions used by the
+ *	legacy float path. DDA_USEC_PER_TICK must divide evenly into F_DDA or
+ *	segment times will drift - true for 50 Khz (20 uSec) and 100 Khz (10 uSec).
+ */
+#define DDA_PERIOD 			_f_to_period(F_DDA)			// timer period at full clock
+#define DDA_USEC_PER_TICK	((uint32_t)(1000000/F_DDA))	// uSec per DDA tick at full clock
+
+/* Adaptive DDA clock
+ *	The DDA used to run at F_DDA regardless of segment speed, so a slow
+ *	Z plunge paid the same interrupt load as a 3 axis rapid. The prep routine
+ *	now downshifts the DDA clock by a power-of-2 divisor chosen so that the
+ *	fastest motor still gets at least DDA_OVERSAMPLE ticks per whole step
+ *	and the segment retains at least DDA_TICKS_MIN ticks of timing
+ *	resolution. The substep accumulator math is unaffected - only the tick
+ *	rate changes - so position accuracy is preserved. DDA_DIVISOR_MAX must
+ *	keep the downshifted frequency above F_DDA_MIN or the 16 bit PERIOD
+ *	register overflows.
+ */
+#define DDA_DIVISOR_MAX		64		// max downshift; 50 Khz / 64 = 781 hz > F_DDA_MIN
+#define DDA_OVERSAMPLE		4		// min DDA ticks per whole step when downshifted
+#define DDA_TICKS_MIN		16		// min DDA ticks per segment when downshifted
+
+/* Adaptive substep scaling
+ *	DDA_SUBSTEPS is a fixed global scale, which made the int32 accumulator
+ *	range a compromise: a short fast segment uses a sliver of the dynamic
+ *	range while a very long slow segment can overflow the range term
+ *	(dda_ticks X substeps). The prep stage now re-scales the substep factor
+ *	per segment by a power of two chosen from dda_ticks - up while the range
+ *	and the motor increments keep DDA_SUBSTEP_HEADROOM (finer fractional-step
+ *	resolution at every speed), down if the range term would overflow. The
+ *	accumulator correction above carries phase exactly across range changes,
+ *	and substeps truncated by a downshift are carried into the next segment,
+ *	so no positional granularity accumulates.
+ */
+#define DDA_SUBSTEP_HEADROOM 0x40000000	// accumulator terms stay below 2^30
+#define DDA_SUBSTEP_SHIFT_MAX 5			// 100,000 holds five factors of two
+
+/* Microstep morphing
+ *	Microstep resolution is re-selected per segment from the commanded step
+ *	rate. Segments run at the configured ($mi) resolution until the rate
+ *	would leave fewer than MICROSTEP_MORPH_OVERSAMPLE DDA ticks per emitted
+ *	step, then the prep stage halves the resolution (and the emitted step
+ *	count) until it fits - so an 8x machine keeps 8x smoothness at cutting
+ *	speeds and still reaches rapid rates that previously required a
+ *	permanently coarse $mi setting. The loader rewrites the mode pins at
+ *	the segment boundary. Substeps truncated by the downshift are carried
+ *	into the next segment so commanded position is exact. The driver
+ *	re-syncs to the coarser current table at a transition, which can shift
+ *	phase by a fraction of a full step - MICROSTEP_MORPH_HYSTERESIS keeps
+ *	transitions from chattering around a threshold rate. Morphing is
+ *	disabled in networked modes as the wire format carries no mode field.
+ */
+#define MICROSTEP_MORPH_OVERSAMPLE	2	// min DDA ticks per emitted step before coarsening
+#define MICROSTEP_MORPH_HYSTERESIS	2	// rate must clear the ceiling by this factor to refine
+
+/* Motor count specialization
+ *	The DDA ISR and the loader are hand-unrolled for all MOTORS. Machines
+ *	that populate fewer motors (e.g. 2-motor laser gantries) can set
+ *	MOTORS_IN_USE to 2 or 3 in their machine profile (see settings.h) to
+ *	compile out the accumulator math and port writes for the unpopulated
+ *	motors, roughly halving the per-tick cost of a 2 motor build. All
+ *	structures remain sized for MOTORS so the config system is unaffected.
+ */
+#ifndef MOTORS_IN_USE
+#define MOTORS_IN_USE MOTORS	// set from the machine profile - defaults to all motors
+#endif
+#if (MOTORS_IN_USE < 2) || (MOTORS_IN_USE > MOTORS)
+#error MOTORS_IN_USE must be 2, 3 or 4
+#endif
+#define SWI_PERIOD 	100				// cycles you have to shut off SW interrupt
+#define TIMER_PERIOD_MIN (20)		// used to trap bad timer loads
+
+// Timer setups
+#define STEP_TIMER_TYPE		TC0_struct // stepper subsubstem uses all the TC0's
+#define STEP_TIMER_DISABLE 	0		// turn timer off (clock = 0 Hz)
+#define STEP_TIMER_ENABLE	1		// turn timer clock on (F_CPU = 32 Mhz)
+#define STEP_TIMER_WGMODE	0		// normal mode (count to TOP and rollover)
+
+#define TIMER_DDA_ISR_vect	TCC0_OVF_vect	// must agree with assignment in system.h
+#define TIMER_LOAD_ISR_vect	TCE0_OVF_vect	// must agree with assignment in system.h
+#define TIMER_EXEC_ISR_vect	TCF0_OVF_vect	// must agree with assignment in system.h
+
+#define TIMER_OVFINTLVL_HI	3		// timer interrupt level (3=hi)
+#define	TIMER_OVFINTLVL_MED 2;		// timer interrupt level (2=med)
+#define	TIMER_OVFINTLVL_LO  1;		// timer interrupt level (1=lo)
+
+#define TIMER_DDA_INTLVL 	TIMER_OVFINTLVL_HI
+#define TIMER_LOAD_INTLVL	TIMER_OVFINTLVL_HI
+#define TIMER_EXEC_INTLVL	TIMER_OVFINTLVL_LO
+
+/* DMA pulse engine settings (used by the __STEP_DMA build only)
+ *	The prep stage renders the step bits for an entire segment into per-motor
+ *	pattern buffers. The buffers are played out to the motor port OUTTGL
+ *	registers by the DMA controller, paced by DDA timer overflow events
+ *	routed through the event system. The CPU cost per step train drops to
+ *	the segment-end DMA interrupt only, which raises the usable F_DDA
+ *	ceiling well past the ISR-based 50 Khz limit.
+ *
+ *	Because OUTTGL is used the step line is high for one full DDA tick
+ *	(toggled on by one pattern byte, off by the next). This stretches the
+ *	step pulse but halves the max per-motor step rate to F_DDA/2, which is
+ *	why F_DDA is doubled for this build.
+ *
+ *	DMA_PATTERN_TICKS_MAX caps segment length in DDA ticks. Segments longer
+ *	than the cap are clamped by the prep stage (the segment time adapts).
+ */
+#ifdef __STEP_DMA
+#undef F_DDA
+#define F_DDA 		(float)100000	// doubled - OUTTGL halves per-motor step rate
+#define DMA_PATTERN_TICKS_MAX 512	// pattern buffer length (bytes per motor)
+#define DMA_CH_MOTOR_1		CH0		// DMA channel assignments, one per motor port
+#define DMA_CH_MOTOR_2		CH1
+#define DMA_CH_MOTOR_3		CH2
+#define DMA_CH_MOTOR_4		CH3
+#define DMA_ISR_vect		DMA_CH0_vect // segment-end interrupt (channel 0 is master)
+#endif
+
+#endif
@@ -75,6 +75,46 @@ void sys_port_bindings(float hw_version)
 	}
 }
 
+/*
+ * sys_stack_paint()	- paint the unused RAM between the statics and the stack
+ * sys_mem_free()		- bytes of RAM never touched since the paint
+ * sys_stack_peak()		- deepest the stack has ever reached, in bytes
+ *
+ *	Supports the $mem diagnostic (see config.c). Painting fills the region
+ *	between the end of static data/bss and the stack pointer with a known
+ *	byte at init; the low-water mark is then found by scanning up from the
+ *	bottom for the first byte the stack (or an ISR frame) has overwritten.
+ *	The gap between the statics and the low-water mark is the real margin
+ *	available for growing the planner queue or the xio rings - measured,
+ *	not guessed, and inclusive of worst-case ISR nesting seen so far.
+ *
+ *	Nothing in this codebase uses malloc(), so the heap break never moves
+ *	off of _end and the whole gap belongs to the stack.
+ *
+ *	sys_stack_paint() must be called from main() before anything that
+ *	builds deep stack frames, and leaves a margin below the current stack
+ *	pointer so it can't damage the frame it is running in.
+ */
+#define STACK_PAINT_BYTE 0xA5
+extern char _end;						// linker symbol: first byte past static data + bss
+
+void sys_stack_paint()
+{
+	char *p = &_end;
+	char *top = (char *)SP - 32;		// stay clear of the active frame
+	while (p < top) { *p++ = STACK_PAINT_BYTE; }
+}
+
+static char *_stack_low_water(void)
+{
+	char *p = &_end;
+	while ((p < (char *)RAMEND) && (*p == STACK_PAINT_BYTE)) { p++; }
+	return (p);
+}
+
+uint16_t sys_mem_free() { return ((uint16_t)(_stack_low_water() - &_end));}
+uint16_t sys_stack_peak() { return ((uint16_t)((char *)RAMEND - _stack_low_water() + 1));}
+
 uint8_t sys_read_calibration_byte(uint8_t index)
 { 
 	NVM_CMD = NVM_CMD_READ_CALIB_ROW_gc; 	// Load NVM Command register to read the calibration row
@@ -42,16 +42,33 @@
 void sys_init(void);					// master hardware init
 void sys_port_bindings(float hw_version);
 void sys_get_id(char *id);
+void sys_stack_paint(void);				// paint free RAM for the $mem diagnostic
+uint16_t sys_mem_free(void);			// RAM never touched since the paint
+uint16_t sys_stack_peak(void);			// peak stack depth in bytes
 
 #define SYS_ID_LEN 12					// length of system ID string from sys_get_id()
 
-/* CPU clock */	
+/* CPU clock
+ *
+ *	All three clock profiles below yield the same validated 32 MHz system
+ *	clock - everything timing-critical derives from F_CPU and needs no
+ *	per-profile rescaling:
+ *
+ *	  - DDA, dwell, load and exec timer periods: _f_to_period(F_CPU) in stepper.h
+ *	  - USART baud BSEL/BSCALE table: computed for 32 MHz in xio_usart.h
+ *	  - RTC: runs off the 32.768 kHz oscillator domain, independent of CLKcpu
+ *
+ *	The internal profile DFLL-calibrates the 32 MHz RC oscillator against
+ *	the 32.768 kHz oscillator (see xmega_init.c) so crystal-less boards
+ *	hold the accuracy the baud table assumes. Don't change F_CPU without
+ *	revisiting all of the above.
+ */
 
 #undef F_CPU							// set for delays
 #define F_CPU 32000000UL				// should always precede <avr/delay.h>
 
 // Clock Crystal Config. Pick one:
-//#define __CLOCK_INTERNAL_32MHZ TRUE	// use internal oscillator
+//#define __CLOCK_INTERNAL_32MHZ TRUE	// internal oscillator w/DFLL calibration
 //#define __CLOCK_EXTERNAL_8MHZ	TRUE	// uses PLL to provide 32 MHz system clock
 #define __CLOCK_EXTERNAL_16MHZ TRUE		// uses PLL to provide 32 MHz system clock
 
@@ -144,7 +161,9 @@ enum cfgPortBits {			// motor control port bit positions
 #define TIMER_DWELL	 		TCD0		// Dwell timer	(see stepper.h)
 #define TIMER_LOAD			TCE0		// Loader timer	(see stepper.h)
 #define TIMER_EXEC			TCF0		// Exec timer	(see stepper.h)
-#define TIMER_5				TCC1		// unallocated timer
+#define TIMER_5				TCC1		// shared by the TIMER_5 features below - enable only one
+#define TIMER_QDEC			TIMER_5		// quadrature decode counter (see gpio.c)
+#define TIMER_TACH			TIMER_5		// spindle tach period capture (see spindle.c)
 #define TIMER_PWM1			TCD1		// PWM timer #1 (see pwm.c)
 #define TIMER_PWM2			TCE1		// PWM timer #2	(see pwm.c)
 
@@ -1,519 +1,818 @@
-/*
- * test.c - tinyg test sets
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* See the wiki for additional information about tests:
- *	 http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
- */
-
-#include <stdio.h>				// precursor for xio.h
-#include <avr/pgmspace.h>		// precursor for xio.h
-#include "tinyg.h"				// #1 unfortunately, there are some dependencies
-#include "util.h"				// #2
-#include "config.h"				// #3
-#include "controller.h"
-#include "planner.h"
-#include "test.h"
-#include "xio/xio.h"
-
-// regression test files
-#include "tests/test_001_smoke.h" 			// basic functionality
-#include "tests/test_002_homing.h"			// G28.1 homing cycles
-#include "tests/test_003_squares.h"			// square moves
-#include "tests/test_004_arcs.h"			// arc moves
-#include "tests/test_005_dwell.h"			// dwells embedded in move sequences
-#include "tests/test_006_feedhold.h"		// feedhold - requires manual ! and ~ entry
-#include "tests/test_007_Mcodes.h"			// M codes synchronized w/moves (planner queue)
-#include "tests/test_008_json.h"			// JSON parser and IO
-#include "tests/test_009_inverse_time.h"	// inverse time mode
-#include "tests/test_010_rotary.h"			// ABC axes
-#include "tests/test_011_small_moves.h"		// small move test
-#include "tests/test_012_slow_moves.h"		// slow move test
-#include "tests/test_013_coordinate_offsets.h"	// what it says
-#include "tests/test_014_microsteps.h"		// test all microstep settings
-#include "tests/test_050_mudflap.h"			// mudflap test - entire drawing
-#include "tests/test_051_braid.h"			// braid test - partial drawing
-
-/*
- * tg_test() - system tests from FLASH invoked by $test=n command
- *
- * 	By convention the character array containing the test must have the same 
- *	name as the file name.
- */
-uint8_t tg_test(cmdObj_t *cmd)
-{
-	switch ((uint8_t)cmd->value) {
-		case 0: { return (STAT_OK);}
-		case 1: { xio_open(XIO_DEV_PGM, PGMFILE(&test_smoke),PGM_FLAGS); break;}
-		case 2: { xio_open(XIO_DEV_PGM, PGMFILE(&test_homing),PGM_FLAGS); break;}
-		case 3: { xio_open(XIO_DEV_PGM, PGMFILE(&test_squares),PGM_FLAGS); break;}
-		case 4: { xio_open(XIO_DEV_PGM, PGMFILE(&test_arcs),PGM_FLAGS); break;}
-		case 5: { xio_open(XIO_DEV_PGM, PGMFILE(&test_dwell),PGM_FLAGS); break;}
-		case 6: { xio_open(XIO_DEV_PGM, PGMFILE(&test_feedhold),PGM_FLAGS); break;}
-		case 7: { xio_open(XIO_DEV_PGM, PGMFILE(&test_Mcodes),PGM_FLAGS); break;}
-		case 8: { xio_open(XIO_DEV_PGM, PGMFILE(&test_json),PGM_FLAGS); break;}
-		case 9: { xio_open(XIO_DEV_PGM, PGMFILE(&test_inverse_time),PGM_FLAGS); break;}
-		case 10: { xio_open(XIO_DEV_PGM, PGMFILE(&test_rotary),PGM_FLAGS); break;}
-		case 11: { xio_open(XIO_DEV_PGM, PGMFILE(&test_small_moves),PGM_FLAGS); break;}
-		case 12: { xio_open(XIO_DEV_PGM, PGMFILE(&test_slow_moves),PGM_FLAGS); break;}
-		case 13: { xio_open(XIO_DEV_PGM, PGMFILE(&test_coordinate_offsets),PGM_FLAGS); break;}
-		case 14: { xio_open(XIO_DEV_PGM, PGMFILE(&test_microsteps),PGM_FLAGS); break;}
-		case 50: { xio_open(XIO_DEV_PGM, PGMFILE(&test_mudflap),PGM_FLAGS); break;}
-		case 51: { xio_open(XIO_DEV_PGM, PGMFILE(&test_braid),PGM_FLAGS); break;}
-		default: {
-			fprintf_P(stderr,PSTR("Test #%d not found\n"),(uint8_t)cmd->value);
-			return (STAT_ERROR);
-		}
-	}
-	tg_set_primary_source(XIO_DEV_PGM);
-	return (STAT_OK);
-}
-
-/*
- * tg_canned_startup() - run a string on startup
- *
- *	Pre-load the USB RX (input) buffer with some test strings that will be called 
- *	on startup. Be mindful of the char limit on the read buffer (RX_BUFFER_SIZE).
- *	It's best to create a test file for really complicated things.
- */
-void tg_canned_startup()	// uncomment in tinyg.h if you want to run this
-{
-#ifdef __CANNED_STARTUP
-
-// avrdude -p x192a3 -c avr109 -b 115200 -P COM19
-// avrdude -e -p atxmega192a3 -c avrispmkii -P usb -U boot:w:xboot-boot.hex
-
-//	xio_queue_RX_string_usb("g28.2 x0\n");			// homing test
-
-//	xio_queue_RX_string_usb("{\"gc\":\"N78 (Row 2 Copy 9-1)\"}\n");
-
-//	xio_queue_RX_string_usb("g1 f100 x100\n");		// Feedhold/queue flush test
-//	xio_queue_RX_string_usb("!\n");
-//	xio_queue_RX_string_usb("@\n");
-//	xio_queue_RX_string_usb("~\n");
-
-/*
-	xio_queue_RX_string_usb("g1 f1800 x0.0005\n");	// Small move test for G61.1
-	xio_queue_RX_string_usb("g20\n");
-	xio_queue_RX_string_usb("m2\n");
-*/
-//	xio_queue_RX_string_usb("$xam=1\n");
-//	xio_queue_RX_string_usb("$1po=1\n");
-//	xio_queue_RX_string_usb("$g54x=20.00\n");
-//	xio_queue_RX_string_usb("$x\n");				// display a group
-//	xio_queue_RX_string_usb("{\"xam\":1}\n");
-
-/*  DWELL TESTS
-G0 X1 Y1
-M8
-G4 P2 (WAIT FOR CYLINDER - DOWN)
-M9
-G4 P2 (WAIT FOR CYLINDER - UP)
-M30 (END OF CODE)
-*/
-
-//	xio_queue_RX_string_usb("$me\n");
-//	xio_queue_RX_string_usb("G0 X0.01 Y0.01\n");
-//	xio_queue_RX_string_usb("M8 G4 P0.001\n");
-//	xio_queue_RX_string_usb("G1 X10 Y10 F1000\n");
-//	xio_queue_RX_string_usb("M8 G4 P2\n");
-//	xio_queue_RX_string_usb("X0 Y0\n");
-//	xio_queue_RX_string_usb("G4 P2\n");
-//	xio_queue_RX_string_usb("M9\n");
-//	xio_queue_RX_string_usb("M30\n");
-
-
-//	xio_queue_RX_string_usb("$net\n");
-
-//	xio_queue_RX_string_usb("{\"sr\":{\"vel\":true,\"mpox\":true,\"mpoy\":true}}\n");
-
-//	xio_queue_RX_string_usb("M3 S1000\n");
-//	xio_queue_RX_string_usb("$test=4\n");
-//	xio_queue_RX_string_usb("g20\n");
-//	xio_queue_RX_string_usb("{\"xvm\":100}\n");
-//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
-
-//	xio_queue_RX_string_usb("$qf\n");
-//	xio_queue_RX_string_usb("$defau=1\n");
-//	xio_queue_RX_string_usb("$id\n");
-//	xio_queue_RX_string_usb("{\n");
-//	xio_queue_RX_string_usb("G3 X28.949238578680202 Y33.51776649746193 I2.1091370558375635 J-2.1091370558375635 F1524\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0x1.2y1.3\"}\n");
-
-//	xio_queue_RX_string_usb("g0x2\n");			// G0 smoke test
-//	xio_queue_RX_string_usb("{\"gc\":\"g2\"}\n");// G0 smoke test in JSON
-
-	// text parser test cases
-//	xio_queue_RX_string_usb("?\n");				// text mode status report
-//	xio_queue_RX_string_usb("$$\n");			// show all request
-//	xio_queue_RX_string_usb("$ec=1\n");			// turn CR expansion on
-//	xio_queue_RX_string_usb("$qr\n");			// invoke QR report
-//	xio_queue_RX_string_usb("$ej=1\n");			// enable JSON mode
-//	xio_queue_RX_string_usb("$n\n");			// ubergroup request
-//	xio_queue_RX_string_usb("$xvm=16,000\n");	// comma skipping
-//	xio_queue_RX_string_usb("$a\n");			// match a group
-//	xio_queue_RX_string_usb("$xabcdefghij\n");	// overrun
-//	xio_queue_RX_string_usb("$x=1\n");			// trying to set a group
-
-//	xio_queue_RX_string_usb("$hv=6\n");				// set to text mode
-//	xio_queue_RX_string_usb("$hv=7\n");				// set to text mode
-//	xio_queue_RX_string_usb("N100 (MSG*** message test with line number and gcode command ***)\n");
-//	xio_queue_RX_string_usb("(MSG*** message test with no line number or gcode command ***)\n");
-//	xio_queue_RX_string_usb("N100\n");			// just the line number
-//	xio_queue_RX_string_usb("N100 g0 x1\n");	// line number and command
-//	xio_queue_RX_string_usb("N100 g0x1 (MSG*** message test with gcode command and line number ***)\n");
-
-//	xio_queue_RX_string_usb("$test=2\n");
-//	xio_queue_RX_string_usb("$$\n");
-//	xio_queue_RX_string_usb("m3\n");
-//	xio_queue_RX_string_usb("$sys\n");
-//	xio_queue_RX_string_usb("$xvm\n");
-//	xio_queue_RX_string_usb("$xasasas=42\n");// bad command
-//	xio_queue_RX_string_usb("$test=51\n");	// run braid fragment to test short-line handling
-
-//	xio_queue_RX_string_usb("{\"sr\":{\"vel\":true,\"posa\":true,\"posx\":true,\"gc\":true,\"feed\":true,\"posy\":true,\"line\":true,\"stat\":true,\"posz\":true}}\n");
-//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"ej\":1}\n");
-//	xio_queue_RX_string_usb("{\"z\":{\"sn\":1}}\n");
-//	xio_queue_RX_string_usb("{\"zsn\":1}\n");
-//	xio_queue_RX_string_usb("{\"hom\":\"\"}\n");
-
-//	xio_queue_RX_string_usb("{\"rx\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"x\":20}\n");
-//	xio_queue_RX_string_usb("{\"1\":{\"po\":\"\"}}\n");
-//	xio_queue_RX_string_usb("{\"c\":\"\"}\n");
-
-//	xio_queue_RX_string_usb("{\"sr\":{\"posx\":true}}\n");
-//	xio_queue_RX_string_usb("{\"baud\":6}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"n20g0x1y1.1\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0x20y30z40\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0x30\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0x40\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0x0\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g20\"}\n");
-//	xio_queue_RX_string_usb("{\"qr\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");
-//	xio_queue_RX_string_usb("{\"mpo\":\"\"}\n");
-
-//	xio_queue_RX_string_usb("g92a0\n");
-//	xio_queue_RX_string_usb("g0a3\n");			// should be a=3. Instead it's a=1
-
-//	xio_queue_RX_string_usb("t3\n");			// change tool
-
-//	xio_queue_RX_string_usb("$h\n");
-//	xio_queue_RX_string_usb("$m\n");
-//	xio_queue_RX_string_usb("$$\n");
-//	xio_queue_RX_string_usb("?\n");
-//	xio_queue_RX_string_usb("$sr\n");
-//	xio_queue_RX_string_usb("$x\n");
-//	xio_queue_RX_string_usb("\n");
-
-//	xio_queue_RX_string_usb("g00xqwrsdfs\n");
-//	xio_queue_RX_string_usb("g0x1000\n");
-
-//	xio_queue_RX_string_usb("g00g17g21g40g49g80g90\n");
-//	xio_queue_RX_string_usb("g2x0y0i1f2000\n");
-//	xio_queue_RX_string_usb("f3000\n");
-//	xio_queue_RX_string_usb("g80\n");
-
-/*
-	xio_queue_RX_string_usb("N0000 G91\n");
-	xio_queue_RX_string_usb("N0010 M6 T1\n");
-	xio_queue_RX_string_usb("N0020 G00 Z2.0000\n");
-	xio_queue_RX_string_usb("N0030 M03\n");
-	xio_queue_RX_string_usb("N0040 G00 X21.5000 Y13.0000\n");
-	xio_queue_RX_string_usb("N0050 G00 Z0.5000\n");
-	xio_queue_RX_string_usb("N0060 G01 Z-0.5000 F100 S1000\n");
-	xio_queue_RX_string_usb("N0070 G02 I20.0000 J13.0000 F100.0\n");
-*/
-
-//	xio_queue_RX_string_usb("$aam=3\n");
-//	xio_queue_RX_string_usb("$\n");
-//	xio_queue_RX_string_usb("$4tr=720\n");
-//	xio_queue_RX_string_usb("g0 a360\n");
-//	xio_queue_RX_string_usb("m3\n");
-//	xio_queue_RX_string_usb("g0 x10\n");
-
-/* Run test file */
-//	xio_queue_RX_string_usb("$test=12\n");		// run test file
-
-/* Other command sequences */
-//	xio_queue_RX_string_usb("H\n");				// show help file
-//	xio_queue_RX_string_usb("\n\n");			// 2 null lines
-//	xio_queue_RX_string_usb("%\n");				// opening percent character
-//	xio_queue_RX_string_usb("$\n");				// display general group
-//	xio_queue_RX_string_usb("?\n");				// report
-//	Test signals - Note: requires test chars to be enabled
-//	xio_queue_RX_string_usb("^\n");				// reset 
-//	xio_queue_RX_string_usb("!\n");				// feedhold
-//	xio_queue_RX_string_usb("~\n");				// cycle start
-
-/* Configs and controls */
-//	xio_queue_RX_string_usb("$\n");				// print general group
-//	xio_queue_RX_string_usb("$x\n");			// print x axis
-//	xio_queue_RX_string_usb("$1\n");			// print motor #1 group
-//	xio_queue_RX_string_usb("$m\n");			// print all motor groups 
-//	xio_queue_RX_string_usb("$n\n");			// print all axis groups
-//	xio_queue_RX_string_usb("$o\n");			// print offset groups
-//	xio_queue_RX_string_usb("$$\n");			// print everything
-//	xio_queue_RX_string_usb("$xam\n");			// print x axis mode
-//	xio_queue_RX_string_usb("$sys\n");			// print system settings
-//	xio_queue_RX_string_usb("$unit\n");
-//	xio_queue_RX_string_usb("$sr\n");
-
-//	xio_queue_RX_string_usb("$xfr=1000\n");
-//	xio_queue_RX_string_usb("$2mi=4\n");
-//	xio_queue_RX_string_usb("$xjm 1000000\n");
-//	xio_queue_RX_string_usb("$xvm\n");			// config with no data
-//	xio_queue_RX_string_usb("$ja\n");			// config with no data
-//	xio_queue_RX_string_usb("$aam = 3\n");		// set A to radius mode
-//	xio_queue_RX_string_usb("$aam 10\n");		// set A to SLAVE_XYZ mode
-//	xio_queue_RX_string_usb("(MSGtest message in comment)\n");
-
-/* G0's */
-//	xio_queue_RX_string_usb("g0 x0.2\n");		// shortest drawable line
-//	xio_queue_RX_string_usb("g0 x0\n");
-//	xio_queue_RX_string_usb("g0 x2\n");
-//	xio_queue_RX_string_usb("g0 x3\n");
-//	xio_queue_RX_string_usb("g0 y3\n");
-//	xio_queue_RX_string_usb("g0 x3 y4 z5.5\n");
-//	xio_queue_RX_string_usb("g0 x10 y10 z10 a10\n");
-//	xio_queue_RX_string_usb("g0 x2000 y3000 z4000 a5000\n");
-
-/* G1's */
-//	xio_queue_RX_string_usb("g1 f300 x100\n");
-//	xio_queue_RX_string_usb("g1 f10 x100\n");
-//	xio_queue_RX_string_usb("g1 f450 x10 y13\n");
-//	xio_queue_RX_string_usb("g1 f450 x10 y13\n");
-//	xio_queue_RX_string_usb("g1 f0 x10\n");
-
-/* G2/G3's */
-//	xio_queue_RX_string_usb("g3 f500 x100 y100 z25 i50 j50\n");
-//	xio_queue_RX_string_usb("g2 x0 y0 i30 j30 f2000\n");
-//	xio_queue_RX_string_usb("g2 f2000 x50 y50 z2 i25 j25\n");
-//	xio_queue_RX_string_usb("g2 f300 x10 y10 i8 j8\n");
-//	xio_queue_RX_string_usb("g2 f300 x10 y10 i5 j5\n");
-//	xio_queue_RX_string_usb("g2 f300 x3 y3 i1.5 j1.5\n");
-//	xio_queue_RX_string_usb("g2 f300 i10 j10\n");				// G2 pocket arc
-//	xio_queue_RX_string_usb("f400\n");							// set feed rate while in arc motion mode
-//	xio_queue_RX_string_usb("g3 f300 i10 j10\n");				// G3 pocket arc
-
-/* G4 tests (dwells) */
-//	xio_queue_RX_string_usb("g0 x20 y23 z10\n");
-//	xio_queue_RX_string_usb("g4 p0.1\n");
-//	xio_queue_RX_string_usb("g0 x10 y10 z-10\n");
-
-/* G10 coordinate offsets */
-//	xio_queue_RX_string_usb("g10 L2 p2 x10 y11 z12\n");
-
-/* G20 / G21 units */
-//	xio_queue_RX_string_usb("g20\n");
-//	xio_queue_RX_string_usb("g21\n");
-
-/* G28 and G30 homing tests */
-//	xio_queue_RX_string_usb("g28.2x0\n");
-//	xio_queue_RX_string_usb("g28.1\n");			// G28.1 OK
-//	xio_queue_RX_string_usb("g28.1x10y10\n");	// G28.1 specification error
-//	xio_queue_RX_string_usb("g28.2x0y0z0\n");
-//	xio_queue_RX_string_usb("g28.2y0\n");
-//	xio_queue_RX_string_usb("g28.2x0y0z0a0\n");
-//	xio_queue_RX_string_usb("g28.2 z0\n");
-//	xio_queue_RX_string_usb("g30x0y0z0\n");
-//	xio_queue_RX_string_usb("g30x42\n");
-
-/* G48-G51 override tests */
-//	xio_queue_RX_string_usb("m50 P1\n");		// enable feed override
-
-/* G53 tests */
-//	xio_queue_RX_string_usb("g56\n");			// assumes G55 is different than machine coords
-//	xio_queue_RX_string_usb("g0 x0 y0\n");		// move to zero in G55
-//	xio_queue_RX_string_usb("g53 g0 x0 y0\n");	// should move off G55 zero back to machine zero
-
-/* G54-G59 tests */
-//	xio_queue_RX_string_usb("g54\n");
-//	xio_queue_RX_string_usb("g55\n");
-//	xio_queue_RX_string_usb("g10 p2 l2 x10 y10 z-10\n");
-
-/* G92 tests */
-//	xio_queue_RX_string_usb("g92 x20 y20\n");	// apply offsets
-//	xio_queue_RX_string_usb("g0 x0 y0\n");		// should move diagonally to SouthWest
-//	xio_queue_RX_string_usb("g92.1\n");			// cancel offsets
-//	xio_queue_RX_string_usb("g0 x0 y0\n");		// should move NW back to original coordinates
-//	xio_queue_RX_string_usb("g92.2\n");
-//	xio_queue_RX_string_usb("g92.3\n");
-
-/* Other Gcode tests */
-//	xio_queue_RX_string_usb("g20\n");			// inch mode
-//	xio_queue_RX_string_usb("g21\n");			// mm mode
-//	xio_queue_RX_string_usb("g18\n");			// plane select
-//	xio_queue_RX_string_usb("g10 l2 p4 x20 y20 z-10\n"); // test G10
-
-/* M code tests */
-//	xio_queue_RX_string_usb("m3\n");			// spindle CW
-//	xio_queue_RX_string_usb("m4\n");			// spindle CCW
-//	xio_queue_RX_string_usb("m5\n");			// spindle off
-//	xio_queue_RX_string_usb("m7\n");			// mist coolant on
-//	xio_queue_RX_string_usb("m8\n");			// flood coolant on
-//	xio_queue_RX_string_usb("m9\n");			// all coolant off
-
-/* Feedhold tests */
-// Consider dropping PLANNER_BUFFER_POOL_SIZE down to something like 4 for these tests
-//	xio_queue_RX_string_usb("g0 x3 y4 z5.5\n");
-//	xio_queue_RX_string_usb("g0 x1 y1 z1\n");
-
-//	xio_queue_RX_string_usb("g0 x0.1\n");
-//	xio_queue_RX_string_usb("g0 x0.2\n");
-//	xio_queue_RX_string_usb("g0 x0.3\n");
-//	xio_queue_RX_string_usb("g0 x0.4\n");
-//	xio_queue_RX_string_usb("g0 x0.5\n");
-//	xio_queue_RX_string_usb("@\n");		// issue feedhold - uncomment __ENABLE_DEBUG_CHARS
-//	xio_queue_RX_string_usb("#\n");		// end feedhold - uncomment __ENABLE_DEBUG_CHARS
-
-//	xio_queue_RX_string_usb("!");				// issue feedhold
-//	xio_queue_RX_string_usb("~");				// end feedhold
-//	xio_queue_RX_string_usb("g0 x0 y0 z0\n");
-//	xio_queue_RX_string_usb("g0 x50\n");
-//	xio_queue_RX_string_usb("g0 y5\n");
-//	See 331.19 or earlier for some more lengthy feedhold tests
-
-/* JSON TEST CASES */
-// If you want to run multi-line cases you need to set RX buffer to 1024 in xio_usart.h
-
-// JSON parser tests		  // set a group
-//	xio_queue_RX_string_usb("{\"x\":{\"am\":2,\"vm\":601.000,\"fr\":1201.000,\"tm\":476.000,\"jm\":20000001.000,\"jd\":0.051,\"sn\":2,\"sv\":-502.000,\"lv\":101.000,\"lb\":2.001,\"zb\":1.001}}\n");
-//	xio_queue_RX_string_usb("{\"x\":\"\"}\n"); // retrieve a group
-
-//	xio_queue_RX_string_usb("{\"gc\":\"g0 x3 y4 z5.5 (comment line)\"}\n");
-//	xio_queue_RX_string_usb("{\"xfr\":1200}\n");
-//	xio_queue_RX_string_usb("{\"xfr\":1200, \"yfr\":1201, \"zfr\":600}\n");
-//	xio_queue_RX_string_usb("{\"err_1\":36000}\n");
-//	xio_queue_RX_string_usb("{\"1sa\":3.6.000}\n");
-//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");				// invoke a status report
-//	xio_queue_RX_string_usb("{\"sr\":{\"line\":true,\"posx\":true,\"posy\":true}}\n");	// set status report
-//	xio_queue_RX_string_usb("{\"sr\":{\"line\":null,\"posx\":null,\"posy\":null}}\n");	// set status report
-//	xio_queue_RX_string_usb("{\"x\":{\"am\":2,\"vm\":601.000,\"fr\":1201.000,\"tm\":476.000,\"jm\":20000001.000,\"jd\":0.051,\"sm\":2,\"sv\":-502.000,\"lv\":101.000,\"lb\":2.001,\"zb\":1.001}}\n");
-
-//	xio_queue_RX_string_usb("{\"x\":\"\"}\n");				// x axis group display
-//	xio_queue_RX_string_usb("{\"c\":\"\"}\n");				// c axis group display
-//	xio_queue_RX_string_usb("{\"1\":\"\"}\n");				// motor 1 group display
-//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");			// system group display
-//	xio_queue_RX_string_usb("{\"x\":null}\n");				// group display
-//	xio_queue_RX_string_usb("{\"x\":{\"am\":1,\"fr\":800.000,\"vm\":800.000,\"tm\":100.000,\"jm\":100000000.000,\"jd\":0.050,\"sm\":1,\"sv\":800.000,\"lv\":100.000,\"zo\":3.000,\"abs\":0.000,\"pos\":0.000}}\n");
-//	xio_queue_RX_string_usb("{\"sys\":{\"fv\":0.930,\"fb\":330.390,\"si\":250,\"gpl\":0,\"gun\":1,\"gco\":1,\"gpa\":2,\"gdi\":0,\"ea\":1,\"ja\":200000.000,\"ml\":0.080,\"ma\":0.100,\"mt\":10000.000,\"ic\":0,\"il\":0,\"ec\":0,\"ee\":1,\"ex\":1}}\n");
-
-//	xio_queue_RX_string_usb("{\"  xfr  \":null}\n");		// JSON string normalization tests
-//	xio_queue_RX_string_usb("{\"gcode\":\"G1 x100 (Title Case Comment)   \"}\n");
-//	xio_queue_RX_string_usb("{\"sr\":{\"ln\":true,\"vl\":true,\"ms\":true}}\n");  // set status report
-//	xio_queue_RX_string_usb("{\"sr\":{\"line\":true,\"posx\":true,\"stat\":true}}\n"); // set status report
-//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");				// get status report
-//	xio_queue_RX_string_usb("g0 x10\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g0 x2\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"g1 f243.543 x22.3456 y32.2134 z-0.127645\"}\n");
-
-//	xio_queue_RX_string_usb("{\"gc\":\"n10000 g0 x20\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"n100000 g0 x0\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"n1000000 g0 x20\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"n10000000 g0 x0\"}\n");
-//	xio_queue_RX_string_usb("{\"gc\":\"n100000000 g0 x20\"}\n");
-
-/*
-	xio_queue_RX_string_usb("{\"gc\":\"N1 T1M6\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N2 G17\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N3 G21 (mm)\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N4 (S8000)\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N5 (M3)\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N6 G92X0.327Y-33.521Z-1.000\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N7 G0Z4.000\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N8 F300.0\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N9 G1X0.327Y-33.521\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N10 G1Z-1.000\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N11 X0.654Y-33.526\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N12 X0.980Y-33.534\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N13 X1.304Y-33.546\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N14 X1.626Y-33.562\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N15 X1.946Y-33.580\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N16 X2.262Y-33.602\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N17 X2.574Y-33.628\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N18 X2.882Y-33.656\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N19 X3.185Y-33.688\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N20 X3.483Y-33.724\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N21 X3.775Y-33.762\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N22 X4.060Y-33.805\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N23 X4.339Y-33.850\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N24 X4.610Y-33.898\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N25 X4.874Y-33.950\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N26 X5.130Y-34.005\"}\n");
-	xio_queue_RX_string_usb("{\"gc\":\"N27 X5.376Y-34.064\"}\n");
-*/
-#endif
-}
-
-/***** Debug Functions ******/
-#ifdef __DEBUG
-
-/* Note: these dump routines pack a lot of characters into the USART TX buffer
- * and can kill the running instance. I'll have to figure out how to prevent that,
- * but in the mean time if you might want to use them you should go into xio_usart.h 
- * and temporarily change to the following settings:
- * 
- *	//#define BUFFER_T uint8_t		// faster, but limits buffer to 255 char max
- *	#define BUFFER_T uint16_t		// slower, but larger buffers
- *
- *	// USART ISR TX buffer size
- *	//#define TX_BUFFER_SIZE (BUFFER_T)64
- *	//#define TX_BUFFER_SIZE (BUFFER_T)128
- *	//#define TX_BUFFER_SIZE (BUFFER_T)255
- *	//#define TX_BUFFER_SIZE (BUFFER_T)256	// uint16_t buffer type is required
- *	//#define TX_BUFFER_SIZE (BUFFER_T)1024
- *	#define TX_BUFFER_SIZE (BUFFER_T)2048
- */
-
-void dump_everything()
-{
-//	tg_dump_controller_state();
-	mp_dump_running_plan_buffer();	
-	mp_dump_runtime_state();
-	st_dump_stepper_state();
-
-	for (uint8_t i=0; i<PLANNER_BUFFER_POOL_SIZE; i++) {
-		mp_dump_plan_buffer_by_index(i);
-	}
-}
-
-void roll_over_and_die()
-{
-	tg_system_reset();
-	tg_application_reset();
-}
-
-void print_scalar(const char *label, float value)
-{
-	fprintf_P(stderr,PSTR("%S %8.4f\n"),label,value); 
-}
-
-void print_vector(const char *label, float vector[], uint8_t count)
-{
-	fprintf_P(stderr,PSTR("%S"),label); 
-	for (uint8_t i=0; i<count; i++) {
-		fprintf_P(stderr,PSTR("  %5.4f"),vector[i]);
-	} 	
-	fprintf_P(stderr,PSTR("\n"));
-}
-
-#endif	// __DEBUG
+/*
+ * test.c - tinyg test sets
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* See the wiki for additional information about tests:
+ *	 http://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Developer-Info
+ */
+
+#include <stdio.h>				// precursor for xio.h
+#include <avr/pgmspace.h>		// precursor for xio.h
+#include "tinyg.h"				// #1 unfortunately, there are some dependencies
+#include "util.h"				// #2
+#include "config.h"				// #3
+#include "controller.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "stepper.h"
+#include "report.h"				// queue starvation metrics
+#include "test.h"
+#include "xio/xio.h"
+#include "xmega/xmega_rtc.h"
+#include "xmega/xmega_eeprom.h"	// benchmark baseline storage
+
+// regression test files
+#include "tests/test_001_smoke.h" 			// basic functionality
+#include "tests/test_002_homing.h"			// G28.1 homing cycles
+#include "tests/test_003_squares.h"			// square moves
+#include "tests/test_004_arcs.h"			// arc moves
+#include "tests/test_005_dwell.h"			// dwells embedded in move sequences
+#include "tests/test_006_feedhold.h"		// feedhold - requires manual ! and ~ entry
+#include "tests/test_007_Mcodes.h"			// M codes synchronized w/moves (planner queue)
+#include "tests/test_008_json.h"			// JSON parser and IO
+#include "tests/test_009_inverse_time.h"	// inverse time mode
+#include "tests/test_010_rotary.h"			// ABC axes
+#include "tests/test_011_small_moves.h"		// small move test
+#include "tests/test_012_slow_moves.h"		// slow move test
+#include "tests/test_013_coordinate_offsets.h"	// what it says
+#include "tests/test_014_microsteps.h"		// test all microstep settings
+#include "tests/test_050_mudflap.h"			// mudflap test - entire drawing
+#include "tests/test_051_braid.h"			// braid test - partial drawing
+
+tstBenchmark_t bm;				// planner throughput benchmark state
+tstDryRun_t dry;				// dry run job time estimation state
+
+/*
+ * tg_test() - system tests from FLASH invoked by $test=n command
+ *
+ * 	By convention the character array containing the test must have the same 
+ *	name as the file name.
+ *
+ *	Values >= TEST_BENCHMARK_OFFSET run test (n - TEST_BENCHMARK_OFFSET) as a
+ *	planner throughput benchmark; values >= TEST_BASELINE_OFFSET additionally
+ *	store the result as the EEPROM baseline for that test - see notes in test.h.
+ */
+uint8_t tg_test(cmdObj_t *cmd)
+{
+	uint8_t test = (uint8_t)cmd->value;
+	uint8_t benchmark = false;
+	uint8_t store_baseline = false;
+
+	if (test >= TEST_BASELINE_OFFSET) {
+		test -= TEST_BASELINE_OFFSET;
+		benchmark = true;
+		store_baseline = true;
+	} else if (test >= TEST_BENCHMARK_OFFSET) {
+		test -= TEST_BENCHMARK_OFFSET;
+		benchmark = true;
+	}
+	switch (test) {
+		case 0: { return (STAT_OK);}
+		case 1: { xio_open(XIO_DEV_PGM, PGMFILE(&test_smoke),PGM_FLAGS); break;}
+		case 2: { xio_open(XIO_DEV_PGM, PGMFILE(&test_homing),PGM_FLAGS); break;}
+		case 3: { xio_open(XIO_DEV_PGM, PGMFILE(&test_squares),PGM_FLAGS); break;}
+		case 4: { xio_open(XIO_DEV_PGM, PGMFILE(&test_arcs),PGM_FLAGS); break;}
+		case 5: { xio_open(XIO_DEV_PGM, PGMFILE(&test_dwell),PGM_FLAGS); break;}
+		case 6: { xio_open(XIO_DEV_PGM, PGMFILE(&test_feedhold),PGM_FLAGS); break;}
+		case 7: { xio_open(XIO_DEV_PGM, PGMFILE(&test_Mcodes),PGM_FLAGS); break;}
+		case 8: { xio_open(XIO_DEV_PGM, PGMFILE(&test_json),PGM_FLAGS); break;}
+		case 9: { xio_open(XIO_DEV_PGM, PGMFILE(&test_inverse_time),PGM_FLAGS); break;}
+		case 10: { xio_open(XIO_DEV_PGM, PGMFILE(&test_rotary),PGM_FLAGS); break;}
+		case 11: { xio_open(XIO_DEV_PGM, PGMFILE(&test_small_moves),PGM_FLAGS); break;}
+		case 12: { xio_open(XIO_DEV_PGM, PGMFILE(&test_slow_moves),PGM_FLAGS); break;}
+		case 13: { xio_open(XIO_DEV_PGM, PGMFILE(&test_coordinate_offsets),PGM_FLAGS); break;}
+		case 14: { xio_open(XIO_DEV_PGM, PGMFILE(&test_microsteps),PGM_FLAGS); break;}
+		case 50: { xio_open(XIO_DEV_PGM, PGMFILE(&test_mudflap),PGM_FLAGS); break;}
+		case 51: { xio_open(XIO_DEV_PGM, PGMFILE(&test_braid),PGM_FLAGS); break;}
+		default: {
+			fprintf_P(stderr,PSTR("Test #%d not found\n"),(uint8_t)cmd->value);
+			return (STAT_ERROR);
+		}
+	}
+	if (benchmark == true) {
+		st_disable_motors();				// suppress motion - drivers ignore step pulses
+		bm.test = test;
+		bm.blocks = 0;
+		bm.segments = 0;
+		bm.head_segments = 0;
+		bm.body_segments = 0;
+		bm.tail_segments = 0;
+		bm.isr_max = 0;
+		bm.store_baseline = store_baseline;
+		bm.start_ticks = rtc.clock_ticks;
+		bm.running = true;					// also holds st_enable_motor() off
+	}
+	tg_set_primary_source(XIO_DEV_PGM);
+	return (STAT_OK);
+}
+
+/*
+ * _baseline_read()  - fetch the stored baseline for a test. Returns slot # or -1
+ * _baseline_write() - store a baseline, reusing the test's slot if it has one
+ *
+ *	Slots are scanned linearly - there are only TEST_BASELINE_SLOTS of them.
+ *	A test with no slot takes the first erased (or non-magic) slot; if all
+ *	slots are taken slot 0 is sacrificed.
+ */
+static int8_t _baseline_read(uint8_t test, tstBaseline_t *base)
+{
+	for (uint8_t slot=0; slot < TEST_BASELINE_SLOTS; slot++) {
+		EEPROM_ReadBytes(TEST_BASELINE_ADDR + (slot * sizeof(tstBaseline_t)),
+						 (int8_t *)base, sizeof(tstBaseline_t));
+		if ((base->magic == TEST_BASELINE_MAGIC) && (base->test == test)) { return (slot);}
+	}
+	return (-1);
+}
+
+static void _baseline_write(tstBaseline_t *base)
+{
+	tstBaseline_t scratch;
+	int8_t slot = _baseline_read(base->test, &scratch);
+	if (slot < 0) {
+		for (slot=0; slot < (TEST_BASELINE_SLOTS-1); slot++) {
+			EEPROM_ReadBytes(TEST_BASELINE_ADDR + (slot * sizeof(tstBaseline_t)),
+							 (int8_t *)&scratch, sizeof(tstBaseline_t));
+			if (scratch.magic != TEST_BASELINE_MAGIC) break;
+		}
+	}
+	EEPROM_WriteBytes(TEST_BASELINE_ADDR + (slot * sizeof(tstBaseline_t)),
+					  (int8_t *)base, sizeof(tstBaseline_t));
+}
+
+/*
+ * tst_benchmark_callback() - finish a benchmark pass and print the results
+ *
+ *	Called from the controller main loop. Reports once the test file has
+ *	reached program end (or stop) with at least one block planned; a test
+ *	file with no moves will leave the benchmark armed until the next one runs.
+ *
+ *	While the pass is in flight the 1-second ISR profile rollups are folded
+ *	into bm.isr_max so the report carries the worst DDA ISR pass of the whole
+ *	run, not just the final second. Requires __ISR_PROFILE; reads 0 otherwise.
+ *
+ *	The result object also breaks the segment count down by planner phase
+ *	(head/body/tail) and carries the queue starvation count and planner queue
+ *	low water mark from the run - a test that spends its time in heads and
+ *	tails or starves the exec queue is planner-bound, not step-rate bound.
+ *
+ *	If a baseline is stored for the test (see $test=2xx in test.h) the result
+ *	object carries the baseline numbers and "regress":1 when throughput fell
+ *	or ISR occupancy rose by more than TEST_BASELINE_TOLERANCE.
+ */
+stat_t tst_benchmark_callback()
+{
+	if (bm.running == false) { return (STAT_NOOP);}
+	if (bm.blocks == 0) { return (STAT_NOOP);}
+#ifdef __ISR_PROFILE
+	bm.isr_max = max(bm.isr_max, isr_rpt.dda_max);
+#endif
+	if ((cm.machine_state != MACHINE_PROGRAM_END) &&
+		(cm.machine_state != MACHINE_PROGRAM_STOP)) { return (STAT_NOOP);}
+
+	bm.running = false;
+	uint32_t ms = (rtc.clock_ticks - bm.start_ticks) * RTC_MILLISECONDS;
+	if (ms == 0) { ms = 1;}
+	float bps = (bm.blocks * 1000.0) / ms;
+	float sps = (bm.segments * 1000.0) / ms;
+	uint16_t starved = rpt_get_starvation_count();
+	uint8_t lo_water = rpt_get_lo_water_mark();
+
+	if (bm.store_baseline == true) {
+		tstBaseline_t base = { TEST_BASELINE_MAGIC, bm.test, bps, sps, bm.isr_max };
+		_baseline_write(&base);
+		fprintf_P(stderr, PSTR("{\"bench\":{\"test\":%d,\"ms\":%lu,\"blocks\":%lu,\"bps\":%1.1f,\"segs\":%lu,\"sps\":%1.1f,\"hseg\":%lu,\"bseg\":%lu,\"tseg\":%lu,\"starv\":%d,\"lowat\":%d,\"isr_max\":%1.1f,\"baseline\":\"stored\"}}\n"),
+			bm.test, ms, bm.blocks, (double)bps, bm.segments, (double)sps,
+			bm.head_segments, bm.body_segments, bm.tail_segments, starved, lo_water, (double)bm.isr_max);
+		return (STAT_OK);
+	}
+	tstBaseline_t base;
+	if (_baseline_read(bm.test, &base) >= 0) {
+		uint8_t regress = ((bps < (base.bps * (1 - TEST_BASELINE_TOLERANCE))) ||
+						   (sps < (base.sps * (1 - TEST_BASELINE_TOLERANCE))) ||
+						   ((base.isr_max > 0) &&
+							(bm.isr_max > (base.isr_max * (1 + TEST_BASELINE_TOLERANCE)))));
+		fprintf_P(stderr, PSTR("{\"bench\":{\"test\":%d,\"ms\":%lu,\"blocks\":%lu,\"bps\":%1.1f,\"segs\":%lu,\"sps\":%1.1f,\"hseg\":%lu,\"bseg\":%lu,\"tseg\":%lu,\"starv\":%d,\"lowat\":%d,\"isr_max\":%1.1f,\"base_bps\":%1.1f,\"base_sps\":%1.1f,\"regress\":%d}}\n"),
+			bm.test, ms, bm.blocks, (double)bps, bm.segments, (double)sps,
+			bm.head_segments, bm.body_segments, bm.tail_segments, starved, lo_water,
+			(double)bm.isr_max, (double)base.bps, (double)base.sps, regress);
+		return (STAT_OK);
+	}
+	fprintf_P(stderr, PSTR("{\"bench\":{\"test\":%d,\"ms\":%lu,\"blocks\":%lu,\"bps\":%1.1f,\"segs\":%lu,\"sps\":%1.1f,\"hseg\":%lu,\"bseg\":%lu,\"tseg\":%lu,\"starv\":%d,\"lowat\":%d}}\n"),
+		bm.test, ms, bm.blocks, (double)bps, bm.segments, (double)sps,
+		bm.head_segments, bm.body_segments, bm.tail_segments, starved, lo_water);
+	return (STAT_OK);
+}
+
+/*
+ * tst_dry_run()          - arm or cancel dry run mode ($dry=1 / $dry=0)
+ * tst_dry_run_add_time() - accumulate planned segment time (called from prep)
+ * tst_dry_run_callback() - report the planned job time and disarm
+ *
+ *	While dry run is armed the loader consumes prep segments at maximum rate
+ *	without touching the DDA timer (see _load_move() in stepper.c), and the
+ *	prep stage reports each segment's duration here. Arming requires an idle
+ *	machine, and the motor drivers are disabled for the duration so a
+ *	stray enable can't leave a motor energized while nothing is moving.
+ *	Time accumulates in integer microseconds with rollover into whole
+ *	seconds, so a multi-hour job doesn't lose precision to a float.
+ *
+ *	The callback reports from the controller main loop once the job reaches
+ *	program end (or stop) with at least one segment consumed, then disarms -
+ *	each estimate is a one-shot; re-arm for the next job.
+ */
+uint8_t tst_dry_run(cmdObj_t *cmd)
+{
+	if ((uint8_t)cmd->value == false) {
+		dry.running = false;
+		return (STAT_OK);
+	}
+	if (cm.machine_state == MACHINE_CYCLE) { return (STAT_CONFIG_NOT_TAKEN);}
+	st_disable_motors();
+	dry.us = 0;
+	dry.seconds = 0;
+	dry.segments = 0;
+	dry.running = true;
+	return (STAT_OK);
+}
+
+void tst_dry_run_add_time(uint32_t microseconds)
+{
+	dry.us += microseconds;
+	while (dry.us >= 1000000) {
+		dry.us -= 1000000;
+		dry.seconds++;
+	}
+	dry.segments++;
+}
+
+stat_t tst_dry_run_callback()
+{
+	if (dry.running == false) { return (STAT_NOOP);}
+	if (dry.segments == 0) { return (STAT_NOOP);}
+	if ((cm.machine_state != MACHINE_PROGRAM_END) &&
+		(cm.machine_state != MACHINE_PROGRAM_STOP)) { return (STAT_NOOP);}
+
+	dry.running = false;
+	float planned = (float)dry.seconds + ((float)dry.us / 1000000);
+	mp_set_job_time_total(planned);		// seed job progress ($prog/$eta) for the real run
+	fprintf_P(stderr, PSTR("{\"dry\":{\"segs\":%lu,\"s\":%1.3f}}\n"),
+		dry.segments, (double)planned);
+	return (STAT_OK);
+}
+
+/*
+ * tst_loopback() - timed serial loopback / throughput test invoked by $lbt=n
+ * _lbt_drain()   - discard and count everything in a device's RX ring
+ *
+ *	Transmits LBT_TEST_BYTES of patterned printable data on the selected
+ *	USART and counts what comes back, timed on the RTC:
+ *
+ *	  $lbt=0	USB - expects the host (or a loopback plug) to echo the pattern
+ *	  $lbt=1	RS485 - as above, but note the channel is half duplex so a
+ *				host echo will collide with the transmission; use $lbt=11
+ *	  $lbt=1n	device n, self-loopback: each chunk is also injected into the
+ *				device's own RX ring via xio_queue_RX_string_usart(), which
+ *				times the RX path with no host participation at all
+ *
+ *	The test runs to completion inside the command - under half a second at
+ *	115200 baud - and the machine must be idle. The channel is consumed while
+ *	it runs: received bytes are counted and discarded, including anything the
+ *	host types. The pattern cycles '0'..'z' so no byte can be mistaken for a
+ *	feedhold or reset signal by the RX ISRs. The result object carries the
+ *	byte counts, RX overruns, elapsed RTC ticks and the computed RX rate.
+ */
+static uint32_t _lbt_drain(xioDev_t *d, xioUsart_t *dx)
+{
+	BUFFER_CRITICAL_ENTER();					// mainline side of the shared RX indexes
+	buffer_t head = dx->rx_buf_head;
+	buffer_t tail = dx->rx_buf_tail;
+	dx->rx_buf_tail = head;						// discard everything received so far
+	dx->rx_buf_count = 0;
+	dx->rx_buf_lines = 0;
+	BUFFER_CRITICAL_EXIT();
+	d->x_flow(d);								// release flow control on the freed space
+	if (head >= tail) { return (head - tail);}
+	return (RX_BUFFER_SIZE - (tail - head));
+}
+
+uint8_t tst_loopback(cmdObj_t *cmd)
+{
+	uint8_t devnum = (uint8_t)cmd->value;
+	uint8_t internal = false;
+	char chunk[LBT_CHUNK_SIZE+1];
+
+	if (devnum >= LBT_INTERNAL_OFFSET) {
+		devnum -= LBT_INTERNAL_OFFSET;
+		internal = true;
+	}
+	if (devnum >= XIO_DEV_USART_COUNT) { return (STAT_INPUT_VALUE_UNSUPPORTED);}
+	if (cm.machine_state == MACHINE_CYCLE) { return (STAT_CONFIG_NOT_TAKEN);}
+
+	uint8_t dev = XIO_DEV_USART_OFFSET + devnum;
+	xioDev_t *d = &ds[dev];
+	xioUsart_t *dx = d->x;
+
+	// Release a line parked in this device's RX ring by the zero-copy reader
+	// (the command line that invoked the test, if it arrived on this device).
+	// The tail must be advanced past it before the drains below run.
+	if (dx->rx_line_pending == true) {
+		buffer_t freed = dx->rx_buf_scan_len;
+		BUFFER_CRITICAL_ENTER();
+		dx->rx_buf_tail = dx->rx_buf_scan;
+		if (dx->rx_buf_count >= freed) { dx->rx_buf_count -= freed;} else { dx->rx_buf_count = 0;}
+		BUFFER_CRITICAL_EXIT();
+		dx->rx_line_pending = false;
+		dx->rx_buf_scan_len = 0;
+	}
+	_lbt_drain(d, dx);							// start from an empty RX ring
+	uint32_t tx_count = 0;
+	uint32_t rx_count = 0;
+	uint32_t overruns = dx->io_rx_overruns;
+	uint32_t start_ticks = rtc.clock_ticks;
+
+	while (tx_count < LBT_TEST_BYTES) {
+		uint8_t len = 0;
+		while ((len < LBT_CHUNK_SIZE) && ((tx_count + len) < LBT_TEST_BYTES)) {
+			chunk[len] = '0' + ((tx_count + len) % 75);	// cycles '0'..'z'
+			len++;
+		}
+		chunk[len] = NUL;
+		for (uint8_t i=0; i<len; i++) {
+			while (xio_putc(dev, chunk[i]) != XIO_OK);	// spin until the TX ISR frees space
+		}
+		tx_count += len;
+		if (internal == true) {
+			xio_queue_RX_string_usart(dev, chunk);
+		}
+		rx_count += _lbt_drain(d, dx);			// count & discard - also keeps the ring clear
+	}
+	while ((xio_get_tx_bufcount_usart(dx) != 0) &&			// wait out the TX ISR
+		   ((rtc.clock_ticks - start_ticks) < LBT_TIMEOUT_TICKS));
+
+	// collect the echo tail: done once the line is quiet for LBT_SETTLE_TICKS
+	uint32_t quiet_start = rtc.clock_ticks;
+	while ((rtc.clock_ticks - quiet_start) < LBT_SETTLE_TICKS) {
+		if ((rtc.clock_ticks - start_ticks) > LBT_TIMEOUT_TICKS) { break;}
+		uint32_t drained = _lbt_drain(d, dx);
+		if (drained != 0) {
+			rx_count += drained;
+			quiet_start = rtc.clock_ticks;
+		}
+	}
+	uint32_t ticks = rtc.clock_ticks - start_ticks;
+	uint32_t ms = ticks * RTC_MILLISECONDS;
+	if (ms == 0) { ms = 1;}
+	overruns = dx->io_rx_overruns - overruns;
+	fprintf_P(stderr, PSTR("{\"lbt\":{\"dev\":%d,\"tx\":%lu,\"rx\":%lu,\"drops\":%lu,\"ticks\":%lu,\"ms\":%lu,\"rxcps\":%1.1f}}\n"),
+		devnum, tx_count, rx_count, overruns, ticks, ms, (double)((rx_count * 1000.0) / ms));
+	return (STAT_OK);
+}
+
+/*
+ * tg_canned_startup() - run a string on startup
+ *
+ *	Pre-load the USB RX (input) buffer with some test strings that will be called 
+ *	on startup. Be mindful of the char limit on the read buffer (RX_BUFFER_SIZE).
+ *	It's best to create a test file for really complicated things.
+ */
+void tg_canned_startup()	// uncomment in tinyg.h if you want to run this
+{
+#ifdef __CANNED_STARTUP
+
+// avrdude -p x192a3 -c avr109 -b 115200 -P COM19
+// avrdude -e -p atxmega192a3 -c avrispmkii -P usb -U boot:w:xboot-boot.hex
+
+//	xio_queue_RX_string_usb("g28.2 x0\n");			// homing test
+
+//	xio_queue_RX_string_usb("{\"gc\":\"N78 (Row 2 Copy 9-1)\"}\n");
+
+//	xio_queue_RX_string_usb("g1 f100 x100\n");		// Feedhold/queue flush test
+//	xio_queue_RX_string_usb("!\n");
+//	xio_queue_RX_string_usb("@\n");
+//	xio_queue_RX_string_usb("~\n");
+
+/*
+	xio_queue_RX_string_usb("g1 f1800 x0.0005\n");	// Small move test for G61.1
+	xio_queue_RX_string_usb("g20\n");
+	xio_queue_RX_string_usb("m2\n");
+*/
+//	xio_queue_RX_string_usb("$xam=1\n");
+//	xio_queue_RX_string_usb("$1po=1\n");
+//	xio_queue_RX_string_usb("$g54x=20.00\n");
+//	xio_queue_RX_string_usb("$x\n");				// display a group
+//	xio_queue_RX_string_usb("{\"xam\":1}\n");
+
+/*  DWELL TESTS
+G0 X1 Y1
+M8
+G4 P2 (WAIT FOR CYLINDER - DOWN)
+M9
+G4 P2 (WAIT FOR CYLINDER - UP)
+M30 (END OF CODE)
+*/
+
+//	xio_queue_RX_string_usb("$me\n");
+//	xio_queue_RX_string_usb("G0 X0.01 Y0.01\n");
+//	xio_queue_RX_string_usb("M8 G4 P0.001\n");
+//	xio_queue_RX_string_usb("G1 X10 Y10 F1000\n");
+//	xio_queue_RX_string_usb("M8 G4 P2\n");
+//	xio_queue_RX_string_usb("X0 Y0\n");
+//	xio_queue_RX_string_usb("G4 P2\n");
+//	xio_queue_RX_string_usb("M9\n");
+//	xio_queue_RX_string_usb("M30\n");
+
+
+//	xio_queue_RX_string_usb("$net\n");
+
+//	xio_queue_RX_string_usb("{\"sr\":{\"vel\":true,\"mpox\":true,\"mpoy\":true}}\n");
+
+//	xio_queue_RX_string_usb("M3 S1000\n");
+//	xio_queue_RX_string_usb("$test=4\n");
+//	xio_queue_RX_string_usb("g20\n");
+//	xio_queue_RX_string_usb("{\"xvm\":100}\n");
+//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
+
+//	xio_queue_RX_string_usb("$qf\n");
+//	xio_queue_RX_string_usb("$defau=1\n");
+//	xio_queue_RX_string_usb("$id\n");
+//	xio_queue_RX_string_usb("{\n");
+//	xio_queue_RX_string_usb("G3 X28.949238578680202 Y33.51776649746193 I2.1091370558375635 J-2.1091370558375635 F1524\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0x1.2y1.3\"}\n");
+
+//	xio_queue_RX_string_usb("g0x2\n");			// G0 smoke test
+//	xio_queue_RX_string_usb("{\"gc\":\"g2\"}\n");// G0 smoke test in JSON
+
+	// text parser test cases
+//	xio_queue_RX_string_usb("?\n");				// text mode status report
+//	xio_queue_RX_string_usb("$$\n");			// show all request
+//	xio_queue_RX_string_usb("$ec=1\n");			// turn CR expansion on
+//	xio_queue_RX_string_usb("$qr\n");			// invoke QR report
+//	xio_queue_RX_string_usb("$ej=1\n");			// enable JSON mode
+//	xio_queue_RX_string_usb("$n\n");			// ubergroup request
+//	xio_queue_RX_string_usb("$xvm=16,000\n");	// comma skipping
+//	xio_queue_RX_string_usb("$a\n");			// match a group
+//	xio_queue_RX_string_usb("$xabcdefghij\n");	// overrun
+//	xio_queue_RX_string_usb("$x=1\n");			// trying to set a group
+
+//	xio_queue_RX_string_usb("$hv=6\n");				// set to text mode
+//	xio_queue_RX_string_usb("$hv=7\n");				// set to text mode
+//	xio_queue_RX_string_usb("N100 (MSG*** message test with line number and gcode command ***)\n");
+//	xio_queue_RX_string_usb("(MSG*** message test with no line number or gcode command ***)\n");
+//	xio_queue_RX_string_usb("N100\n");			// just the line number
+//	xio_queue_RX_string_usb("N100 g0 x1\n");	// line number and command
+//	xio_queue_RX_string_usb("N100 g0x1 (MSG*** message test with gcode command and line number ***)\n");
+
+//	xio_queue_RX_string_usb("$test=2\n");
+//	xio_queue_RX_string_usb("$$\n");
+//	xio_queue_RX_string_usb("m3\n");
+//	xio_queue_RX_string_usb("$sys\n");
+//	xio_queue_RX_string_usb("$xvm\n");
+//	xio_queue_RX_string_usb("$xasasas=42\n");// bad command
+//	xio_queue_RX_string_usb("$test=51\n");	// run braid fragment to test short-line handling
+
+//	xio_queue_RX_string_usb("{\"sr\":{\"vel\":true,\"posa\":true,\"posx\":true,\"gc\":true,\"feed\":true,\"posy\":true,\"line\":true,\"stat\":true,\"posz\":true}}\n");
+//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"ej\":1}\n");
+//	xio_queue_RX_string_usb("{\"z\":{\"sn\":1}}\n");
+//	xio_queue_RX_string_usb("{\"zsn\":1}\n");
+//	xio_queue_RX_string_usb("{\"hom\":\"\"}\n");
+
+//	xio_queue_RX_string_usb("{\"rx\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"x\":20}\n");
+//	xio_queue_RX_string_usb("{\"1\":{\"po\":\"\"}}\n");
+//	xio_queue_RX_string_usb("{\"c\":\"\"}\n");
+
+//	xio_queue_RX_string_usb("{\"sr\":{\"posx\":true}}\n");
+//	xio_queue_RX_string_usb("{\"baud\":6}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"n20g0x1y1.1\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0x20y30z40\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0x30\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0x40\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0x0\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g20\"}\n");
+//	xio_queue_RX_string_usb("{\"qr\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");
+//	xio_queue_RX_string_usb("{\"mpo\":\"\"}\n");
+
+//	xio_queue_RX_string_usb("g92a0\n");
+//	xio_queue_RX_string_usb("g0a3\n");			// should be a=3. Instead it's a=1
+
+//	xio_queue_RX_string_usb("t3\n");			// change tool
+
+//	xio_queue_RX_string_usb("$h\n");
+//	xio_queue_RX_string_usb("$m\n");
+//	xio_queue_RX_string_usb("$$\n");
+//	xio_queue_RX_string_usb("?\n");
+//	xio_queue_RX_string_usb("$sr\n");
+//	xio_queue_RX_string_usb("$x\n");
+//	xio_queue_RX_string_usb("\n");
+
+//	xio_queue_RX_string_usb("g00xqwrsdfs\n");
+//	xio_queue_RX_string_usb("g0x1000\n");
+
+//	xio_queue_RX_string_usb("g00g17g21g40g49g80g90\n");
+//	xio_queue_RX_string_usb("g2x0y0i1f2000\n");
+//	xio_queue_RX_string_usb("f3000\n");
+//	xio_queue_RX_string_usb("g80\n");
+
+/*
+	xio_queue_RX_string_usb("N0000 G91\n");
+	xio_queue_RX_string_usb("N0010 M6 T1\n");
+	xio_queue_RX_string_usb("N0020 G00 Z2.0000\n");
+	xio_queue_RX_string_usb("N0030 M03\n");
+	xio_queue_RX_string_usb("N0040 G00 X21.5000 Y13.0000\n");
+	xio_queue_RX_string_usb("N0050 G00 Z0.5000\n");
+	xio_queue_RX_string_usb("N0060 G01 Z-0.5000 F100 S1000\n");
+	xio_queue_RX_string_usb("N0070 G02 I20.0000 J13.0000 F100.0\n");
+*/
+
+//	xio_queue_RX_string_usb("$aam=3\n");
+//	xio_queue_RX_string_usb("$\n");
+//	xio_queue_RX_string_usb("$4tr=720\n");
+//	xio_queue_RX_string_usb("g0 a360\n");
+//	xio_queue_RX_string_usb("m3\n");
+//	xio_queue_RX_string_usb("g0 x10\n");
+
+/* Run test file */
+//	xio_queue_RX_string_usb("$test=12\n");		// run test file
+
+/* Other command sequences */
+//	xio_queue_RX_string_usb("H\n");				// show help file
+//	xio_queue_RX_string_usb("\n\n");			// 2 null lines
+//	xio_queue_RX_string_usb("%\n");				// opening percent character
+//	xio_queue_RX_string_usb("$\n");				// display general group
+//	xio_queue_RX_string_usb("?\n");				// report
+//	Test signals - Note: requires test chars to be enabled
+//	xio_queue_RX_string_usb("^\n");				// reset 
+//	xio_queue_RX_string_usb("!\n");				// feedhold
+//	xio_queue_RX_string_usb("~\n");				// cycle start
+
+/* Configs and controls */
+//	xio_queue_RX_string_usb("$\n");				// print general group
+//	xio_queue_RX_string_usb("$x\n");			// print x axis
+//	xio_queue_RX_string_usb("$1\n");			// print motor #1 group
+//	xio_queue_RX_string_usb("$m\n");			// print all motor groups 
+//	xio_queue_RX_string_usb("$n\n");			// print all axis groups
+//	xio_queue_RX_string_usb("$o\n");			// print offset groups
+//	xio_queue_RX_string_usb("$$\n");			// print everything
+//	xio_queue_RX_string_usb("$xam\n");			// print x axis mode
+//	xio_queue_RX_string_usb("$sys\n");			// print system settings
+//	xio_queue_RX_string_usb("$unit\n");
+//	xio_queue_RX_string_usb("$sr\n");
+
+//	xio_queue_RX_string_usb("$xfr=1000\n");
+//	xio_queue_RX_string_usb("$2mi=4\n");
+//	xio_queue_RX_string_usb("$xjm 1000000\n");
+//	xio_queue_RX_string_usb("$xvm\n");			// config with no data
+//	xio_queue_RX_string_usb("$ja\n");			// config with no data
+//	xio_queue_RX_string_usb("$aam = 3\n");		// set A to radius mode
+//	xio_queue_RX_string_usb("$aam 10\n");		// set A to SLAVE_XYZ mode
+//	xio_queue_RX_string_usb("(MSGtest message in comment)\n");
+
+/* G0's */
+//	xio_queue_RX_string_usb("g0 x0.2\n");		// shortest drawable line
+//	xio_queue_RX_string_usb("g0 x0\n");
+//	xio_queue_RX_string_usb("g0 x2\n");
+//	xio_queue_RX_string_usb("g0 x3\n");
+//	xio_queue_RX_string_usb("g0 y3\n");
+//	xio_queue_RX_string_usb("g0 x3 y4 z5.5\n");
+//	xio_queue_RX_string_usb("g0 x10 y10 z10 a10\n");
+//	xio_queue_RX_string_usb("g0 x2000 y3000 z4000 a5000\n");
+
+/* G1's */
+//	xio_queue_RX_string_usb("g1 f300 x100\n");
+//	xio_queue_RX_string_usb("g1 f10 x100\n");
+//	xio_queue_RX_string_usb("g1 f450 x10 y13\n");
+//	xio_queue_RX_string_usb("g1 f450 x10 y13\n");
+//	xio_queue_RX_string_usb("g1 f0 x10\n");
+
+/* G2/G3's */
+//	xio_queue_RX_string_usb("g3 f500 x100 y100 z25 i50 j50\n");
+//	xio_queue_RX_string_usb("g2 x0 y0 i30 j30 f2000\n");
+//	xio_queue_RX_string_usb("g2 f2000 x50 y50 z2 i25 j25\n");
+//	xio_queue_RX_string_usb("g2 f300 x10 y10 i8 j8\n");
+//	xio_queue_RX_string_usb("g2 f300 x10 y10 i5 j5\n");
+//	xio_queue_RX_string_usb("g2 f300 x3 y3 i1.5 j1.5\n");
+//	xio_queue_RX_string_usb("g2 f300 i10 j10\n");				// G2 pocket arc
+//	xio_queue_RX_string_usb("f400\n");							// set feed rate while in arc motion mode
+//	xio_queue_RX_string_usb("g3 f300 i10 j10\n");				// G3 pocket arc
+
+/* G4 tests (dwells) */
+//	xio_queue_RX_string_usb("g0 x20 y23 z10\n");
+//	xio_queue_RX_string_usb("g4 p0.1\n");
+//	xio_queue_RX_string_usb("g0 x10 y10 z-10\n");
+
+/* G10 coordinate offsets */
+//	xio_queue_RX_string_usb("g10 L2 p2 x10 y11 z12\n");
+
+/* G20 / G21 units */
+//	xio_queue_RX_string_usb("g20\n");
+//	xio_queue_RX_string_usb("g21\n");
+
+/* G28 and G30 homing tests */
+//	xio_queue_RX_string_usb("g28.2x0\n");
+//	xio_queue_RX_string_usb("g28.1\n");			// G28.1 OK
+//	xio_queue_RX_string_usb("g28.1x10y10\n");	// G28.1 specification error
+//	xio_queue_RX_string_usb("g28.2x0y0z0\n");
+//	xio_queue_RX_string_usb("g28.2y0\n");
+//	xio_queue_RX_string_usb("g28.2x0y0z0a0\n");
+//	xio_queue_RX_string_usb("g28.2 z0\n");
+//	xio_queue_RX_string_usb("g30x0y0z0\n");
+//	xio_queue_RX_string_usb("g30x42\n");
+
+/* G48-G51 override tests */
+//	xio_queue_RX_string_usb("m50 P1\n");		// enable feed override
+
+/* G53 tests */
+//	xio_queue_RX_string_usb("g56\n");			// assumes G55 is different than machine coords
+//	xio_queue_RX_string_usb("g0 x0 y0\n");		// move to zero in G55
+//	xio_queue_RX_string_usb("g53 g0 x0 y0\n");	// should move off G55 zero back to machine zero
+
+/* G54-G59 tests */
+//	xio_queue_RX_string_usb("g54\n");
+//	xio_queue_RX_string_usb("g55\n");
+//	xio_queue_RX_string_usb("g10 p2 l2 x10 y10 z-10\n");
+
+/* G92 tests */
+//	xio_queue_RX_string_usb("g92 x20 y20\n");	// apply offsets
+//	xio_queue_RX_string_usb("g0 x0 y0\n");		// should move diagonally to SouthWest
+//	xio_queue_RX_string_usb("g92.1\n");			// cancel offsets
+//	xio_queue_RX_string_usb("g0 x0 y0\n");		// should move NW back to original coordinates
+//	xio_queue_RX_string_usb("g92.2\n");
+//	xio_queue_RX_string_usb("g92.3\n");
+
+/* Other Gcode tests */
+//	xio_queue_RX_string_usb("g20\n");			// inch mode
+//	xio_queue_RX_string_usb("g21\n");			// mm mode
+//	xio_queue_RX_string_usb("g18\n");			// plane select
+//	xio_queue_RX_string_usb("g10 l2 p4 x20 y20 z-10\n"); // test G10
+
+/* M code tests */
+//	xio_queue_RX_string_usb("m3\n");			// spindle CW
+//	xio_queue_RX_string_usb("m4\n");			// spindle CCW
+//	xio_queue_RX_string_usb("m5\n");			// spindle off
+//	xio_queue_RX_string_usb("m7\n");			// mist coolant on
+//	xio_queue_RX_string_usb("m8\n");			// flood coolant on
+//	xio_queue_RX_string_usb("m9\n");			// all coolant off
+
+/* Feedhold tests */
+// Consider dropping PLANNER_BUFFER_POOL_SIZE down to something like 4 for these tests
+//	xio_queue_RX_string_usb("g0 x3 y4 z5.5\n");
+//	xio_queue_RX_string_usb("g0 x1 y1 z1\n");
+
+//	xio_queue_RX_string_usb("g0 x0.1\n");
+//	xio_queue_RX_string_usb("g0 x0.2\n");
+//	xio_queue_RX_string_usb("g0 x0.3\n");
+//	xio_queue_RX_string_usb("g0 x0.4\n");
+//	xio_queue_RX_string_usb("g0 x0.5\n");
+//	xio_queue_RX_string_usb("@\n");		// issue feedhold - uncomment __ENABLE_DEBUG_CHARS
+//	xio_queue_RX_string_usb("#\n");		// end feedhold - uncomment __ENABLE_DEBUG_CHARS
+
+//	xio_queue_RX_string_usb("!");				// issue feedhold
+//	xio_queue_RX_string_usb("~");				// end feedhold
+//	xio_queue_RX_string_usb("g0 x0 y0 z0\n");
+//	xio_queue_RX_string_usb("g0 x50\n");
+//	xio_queue_RX_string_usb("g0 y5\n");
+//	See 331.19 or earlier for some more lengthy feedhold tests
+
+/* JSON TEST CASES */
+// If you want to run multi-line cases you need to set RX buffer to 1024 in xio_usart.h
+
+// JSON parser tests		  // set a group
+//	xio_queue_RX_string_usb("{\"x\":{\"am\":2,\"vm\":601.000,\"fr\":1201.000,\"tm\":476.000,\"jm\":20000001.000,\"jd\":0.051,\"sn\":2,\"sv\":-502.000,\"lv\":101.000,\"lb\":2.001,\"zb\":1.001}}\n");
+//	xio_queue_RX_string_usb("{\"x\":\"\"}\n"); // retrieve a group
+
+//	xio_queue_RX_string_usb("{\"gc\":\"g0 x3 y4 z5.5 (comment line)\"}\n");
+//	xio_queue_RX_string_usb("{\"xfr\":1200}\n");
+//	xio_queue_RX_string_usb("{\"xfr\":1200, \"yfr\":1201, \"zfr\":600}\n");
+//	xio_queue_RX_string_usb("{\"err_1\":36000}\n");
+//	xio_queue_RX_string_usb("{\"1sa\":3.6.000}\n");
+//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");				// invoke a status report
+//	xio_queue_RX_string_usb("{\"sr\":{\"line\":true,\"posx\":true,\"posy\":true}}\n");	// set status report
+//	xio_queue_RX_string_usb("{\"sr\":{\"line\":null,\"posx\":null,\"posy\":null}}\n");	// set status report
+//	xio_queue_RX_string_usb("{\"x\":{\"am\":2,\"vm\":601.000,\"fr\":1201.000,\"tm\":476.000,\"jm\":20000001.000,\"jd\":0.051,\"sm\":2,\"sv\":-502.000,\"lv\":101.000,\"lb\":2.001,\"zb\":1.001}}\n");
+
+//	xio_queue_RX_string_usb("{\"x\":\"\"}\n");				// x axis group display
+//	xio_queue_RX_string_usb("{\"c\":\"\"}\n");				// c axis group display
+//	xio_queue_RX_string_usb("{\"1\":\"\"}\n");				// motor 1 group display
+//	xio_queue_RX_string_usb("{\"sys\":\"\"}\n");			// system group display
+//	xio_queue_RX_string_usb("{\"x\":null}\n");				// group display
+//	xio_queue_RX_string_usb("{\"x\":{\"am\":1,\"fr\":800.000,\"vm\":800.000,\"tm\":100.000,\"jm\":100000000.000,\"jd\":0.050,\"sm\":1,\"sv\":800.000,\"lv\":100.000,\"zo\":3.000,\"abs\":0.000,\"pos\":0.000}}\n");
+//	xio_queue_RX_string_usb("{\"sys\":{\"fv\":0.930,\"fb\":330.390,\"si\":250,\"gpl\":0,\"gun\":1,\"gco\":1,\"gpa\":2,\"gdi\":0,\"ea\":1,\"ja\":200000.000,\"ml\":0.080,\"ma\":0.100,\"mt\":10000.000,\"ic\":0,\"il\":0,\"ec\":0,\"ee\":1,\"ex\":1}}\n");
+
+//	xio_queue_RX_string_usb("{\"  xfr  \":null}\n");		// JSON string normalization tests
+//	xio_queue_RX_string_usb("{\"gcode\":\"G1 x100 (Title Case Comment)   \"}\n");
+//	xio_queue_RX_string_usb("{\"sr\":{\"ln\":true,\"vl\":true,\"ms\":true}}\n");  // set status report
+//	xio_queue_RX_string_usb("{\"sr\":{\"line\":true,\"posx\":true,\"stat\":true}}\n"); // set status report
+//	xio_queue_RX_string_usb("{\"sr\":\"\"}\n");				// get status report
+//	xio_queue_RX_string_usb("g0 x10\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g0 x2\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"g1 f243.543 x22.3456 y32.2134 z-0.127645\"}\n");
+
+//	xio_queue_RX_string_usb("{\"gc\":\"n10000 g0 x20\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"n100000 g0 x0\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"n1000000 g0 x20\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"n10000000 g0 x0\"}\n");
+//	xio_queue_RX_string_usb("{\"gc\":\"n100000000 g0 x20\"}\n");
+
+/*
+	xio_queue_RX_string_usb("{\"gc\":\"N1 T1M6\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N2 G17\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N3 G21 (mm)\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N4 (S8000)\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N5 (M3)\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N6 G92X0.327Y-33.521Z-1.000\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N7 G0Z4.000\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N8 F300.0\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N9 G1X0.327Y-33.521\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N10 G1Z-1.000\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N11 X0.654Y-33.526\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N12 X0.980Y-33.534\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N13 X1.304Y-33.546\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N14 X1.626Y-33.562\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N15 X1.946Y-33.580\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N16 X2.262Y-33.602\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N17 X2.574Y-33.628\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N18 X2.882Y-33.656\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N19 X3.185Y-33.688\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N20 X3.483Y-33.724\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N21 X3.775Y-33.762\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N22 X4.060Y-33.805\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N23 X4.339Y-33.850\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N24 X4.610Y-33.898\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N25 X4.874Y-33.950\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N26 X5.130Y-34.005\"}\n");
+	xio_queue_RX_string_usb("{\"gc\":\"N27 X5.376Y-34.064\"}\n");
+*/
+#endif
+}
+
+/***** Debug Functions ******/
+#ifdef __DEBUG
+
+/* Note: these dump routines pack a lot of characters into the USART TX buffer
+ * and can kill the running instance. I'll have to figure out how to prevent that,
+ * but in the mean time if you might want to use them you should go into xio_usart.h 
+ * and temporarily change to the following settings:
+ * 
+ *	//#define BUFFER_T uint8_t		// faster, but limits buffer to 255 char max
+ *	#define BUFFER_T uint16_t		// slower, but larger buffers
+ *
+ *	// USART ISR TX buffer size
+ *	//#define TX_BUFFER_SIZE (BUFFER_T)64
+ *	//#define TX_BUFFER_SIZE (BUFFER_T)128
+ *	//#define TX_BUFFER_SIZE (BUFFER_T)255
+ *	//#define TX_BUFFER_SIZE (BUFFER_T)256	// uint16_t buffer type is required
+ *	//#define TX_BUFFER_SIZE (BUFFER_T)1024
+ *	#define TX_BUFFER_SIZE (BUFFER_T)2048
+ */
+
+void dump_everything()
+{
+//	tg_dump_controller_state();
+	mp_dump_running_plan_buffer();	
+	mp_dump_runtime_state();
+	st_dump_stepper_state();
+
+	for (uint8_t i=0; i<PLANNER_BUFFER_POOL_SIZE; i++) {
+		mp_dump_plan_buffer_by_index(i);
+	}
+}
+
+void roll_over_and_die()
+{
+	tg_system_reset();
+	tg_application_reset();
+}
+
+void print_scalar(const char *label, float value)
+{
+	fprintf_P(stderr,PSTR("%S %8.4f\n"),label,value); 
+}
+
+void print_vector(const char *label, float vector[], uint8_t count)
+{
+	fprintf_P(stderr,PSTR("%S"),label); 
+	for (uint8_t i=0; i<count; i++) {
+		fprintf_P(stderr,PSTR("  %5.4f"),vector[i]);
+	} 	
+	fprintf_P(stderr,PSTR("\n"));
+}
+
+#endif	// __DEBUG
@@ -1,147 +1,238 @@
-/*
- * test.h - tinyg test sets
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-#ifndef test_h
-#define test_h
-
-//#include <stdio.h>					// needed for FILE def'n
-
-uint8_t tg_test(cmdObj_t *cmd);
-void tg_canned_startup(void);
-
-/***** DEBUG support ******
- *
- *	DEBUGs are print statements you probably only want enabled during 
- *	debugging, and then probably only for one section of code or another.
- *
- *	DEBUG logging is enabled if __DEBUG is defined.
- *	__DEBUG enables a set of arbitrary __dbXXXXXX defines that control 
- *	various debug regions, e.g. __dbCONFIG to enable debugging in config.c.
- *	Each __dbXXXXXX pairs with a dbXXXXXX global variable used as a flag.
- *	Each dbXXXXXX is initialized to TRUE or FALSE at startup in main.c.
- *	dbXXXXXX is used as a condition to enable or disable logging.
- *	No varargs, so you must use the one with the right number of variables.
- *	A closing semicolon is not required but is recommended for style.
- *
- *	DEBUG usage examples:
- *		DEBUG0(dbCONFIG, PSTR("String with no variables"));
- *		DEBUG1(dbCONFIG, PSTR("String with one variable: %f"), float_var);
- *		DEBUG2(dbCONFIG, PSTR("String with two variables: %4.2f, %d"), float_var, int_var);
- *
- *	DEBUG print statements are coded so they occupy no program space if 
- *	they are not enabled. If you also use __dbXXXX defines to enable debug
- *	code these will - of course - be in the code regardless.
- *
- *	There are also a variety of module-specific diagnostic print statements 
- *	that are enabled or not depending on whether __DEBUG is defined
- */
- 
-#ifdef __DEBUG
-void dump_everything(void);
-void roll_over_and_die(void);
-void print_scalar(const char *label, float value);
-void print_vector(const char *label, float vector[], uint8_t length);
-
-// global allocation of debug control variables
-	uint8_t dbECHO_GCODE_BLOCK;
-	uint8_t dbALINE_CALLED;
-	uint8_t dbSHOW_QUEUED_LINE;
-	uint8_t dbSHOW_LIMIT_SWITCH;
-	uint8_t dbSHOW_CONFIG_STATE;
-	uint8_t dbCONFIG_DEBUG_ENABLED;
-	uint8_t dbSHOW_LOAD_MOVE;
-
-#define DEBUG0(dbXXXXXX,msg) { if (dbXXXXXX == TRUE) { \
-								fprintf_P(stderr,PSTR("DEBUG: ")); \
-								fprintf_P(stderr,msg); \
-								fprintf_P(stderr,PSTR("\n"));}}
-
-#define DEBUG1(dbXXXXXX,msg,a) { if (dbXXXXXX == TRUE) { \
-								fprintf_P(stderr,PSTR("DEBUG: ")); \
-								fprintf_P(stderr,msg,a); \
-								fprintf_P(stderr,PSTR("\n"));}}
-
-#define DEBUG2(dbXXXXXX,msg,a,b) { if (dbXXXXXX == TRUE) { \
-								fprintf_P(stderr,PSTR("DEBUG: ")); \
-								fprintf_P(stderr,msg,a,b); \
-								fprintf_P(stderr,PSTR("\n"));}}
-
-#define DEBUG3(dbXXXXXX,msg,a,b,c) { if (dbXXXXXX == TRUE) { \
-								fprintf_P(stderr,PSTR("DEBUG: ")); \
-								fprintf_P(stderr,msg,a,b,c); \
-								fprintf_P(stderr,PSTR("\n"));}}
-#else
-#define DEBUG0(dbXXXXXX,msg)
-#define DEBUG1(dbXXXXXX,msg,a)
-#define DEBUG2(dbXXXXXX,msg,a,b)
-#define DEBUG3(dbXXXXXX,msg,a,b,c)
-#endif	// __DEBUG
-
-/***** Runtime Segment Data Logger Stuff *****
- *
- * This is independent of __DEBUG and does not need __DEBUG defined
- */
-#ifdef __SEGMENT_LOGGER
-#define SEGMENT_LOGGER_MAX 256
-
-// segment logger structure and index
-struct mpSegmentLog {
-	uint8_t move_state;
-	uint32_t linenum;
-	uint32_t segments;
-	float velocity;
-	float microseconds;
-//	float position_x;
-//	float target_x;
-//	float step_x;
-//	float move_time;
-//	float accel_time;
-};
-struct mpSegmentLog sl[SEGMENT_LOGGER_MAX];
-uint16_t sl_index;
-
-// function prototype and calling macro
-void segment_logger(uint8_t move_state, 
-					uint32_t linenum,
-					uint32_t segments, 
-					uint32_t segment_count, 
-					float velocity,
-					float microseconds
-//					float position_x, 
-//					float target_x,
-//					float step_x, 
-//					float move_time,
-//					float accel_time
-					);
-
-#define SEGMENT_LOGGER segment_logger(bf->move_state, \
-									  mr.linenum, mr.segments, mr.segment_count, \
-									  mr.segment_velocity, \
-									  mr.microseconds);
-/*
-									  mr.microseconds, \
-									  mr.position[X], \
-									  mr.target[X], \
-									  steps[X], \
-									  mr.segment_move_time, \
-									  mr.segment_accel_time);
-*/
-#else
-#define SEGMENT_LOGGER
-#endif	// __SEGMENT_LOGGER
-#endif	// test_h
+/*
+ * test.h - tinyg test sets
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef test_h
+#define test_h
+
+//#include <stdio.h>					// needed for FILE def'n
+
+uint8_t tg_test(cmdObj_t *cmd);
+uint8_t tst_loopback(cmdObj_t *cmd);
+uint8_t tst_dry_run(cmdObj_t *cmd);
+void tg_canned_startup(void);
+stat_t tst_benchmark_callback(void);
+stat_t tst_dry_run_callback(void);
+void tst_dry_run_add_time(uint32_t microseconds);
+
+/***** Planner throughput benchmark ******
+ *
+ *	$test=1xx runs canned test xx as a planner benchmark: motor drivers are 
+ *	held disabled so nothing moves, blocks through mp_aline() and segments
+ *	through _exec_aline_segment() are counted (broken down by head/body/tail
+ *	phase), and a JSON result object with blocks/sec, segments/sec, the phase
+ *	breakdown and the queue starvation metrics (timed on the RTC) is printed
+ *	when the test file reaches program end. See tst_benchmark_callback().
+ */
+#define TEST_BENCHMARK_OFFSET 100	// $test values >= this run as benchmarks
+
+typedef struct tstBenchmark {
+	uint8_t running;				// true while a benchmark pass is in flight
+	uint8_t store_baseline;			// true if the pass should be stored as the new baseline
+	uint8_t test;					// canned test number being benchmarked
+	uint32_t start_ticks;			// rtc.clock_ticks at benchmark start
+	uint32_t blocks;				// blocks queued through mp_aline()
+	uint32_t segments;				// segments run through _exec_aline_segment()
+	uint32_t head_segments;			// segments spent in acceleration (MOVE_STATE_HEAD)
+	uint32_t body_segments;			// segments spent at cruise (MOVE_STATE_BODY)
+	uint32_t tail_segments;			// segments spent in deceleration (MOVE_STATE_TAIL)
+	float isr_max;					// longest DDA ISR pass seen during the run, in uSec
+} tstBenchmark_t;
+extern tstBenchmark_t bm;
+
+/***** Benchmark baseline regression guard ******
+ *
+ *	$test=2xx runs benchmark xx and stores the result in EEPROM as the
+ *	reference for that test. Subsequent $test=1xx runs compare against the
+ *	stored baseline and flag the JSON result with "regress":true if the
+ *	fresh numbers fall outside TEST_BASELINE_TOLERANCE. This lets a board
+ *	report that a firmware update made it slower without a host-side
+ *	database of what "normal" looks like for that board.
+ *
+ *	Baseline slots live at the top of EEPROM; config NVM grows up from
+ *	NVM_BASE_ADDR (config.h) so the two won't meet until the config array
+ *	nearly fills the part. Erased EEPROM reads 0xff, so a magic byte marks
+ *	a slot as valid. Baselines survive $defa and firmware updates; re-run
+ *	$test=2xx after changing machine settings that affect throughput.
+ */
+#define TEST_BASELINE_OFFSET 200	// $test values >= this store a new baseline
+#define TEST_BASELINE_MAGIC 0xB5	// marks an EEPROM slot as holding a baseline
+#define TEST_BASELINE_SLOTS 8		// number of tests that can hold baselines
+#define TEST_BASELINE_TOLERANCE 0.05 // fractional slowdown that counts as a regression
+#define TEST_BASELINE_ADDR (0x0800 - (TEST_BASELINE_SLOTS * sizeof(tstBaseline_t)))
+
+typedef struct tstBaseline {		// one EEPROM slot
+	uint8_t magic;					// TEST_BASELINE_MAGIC when the slot is valid
+	uint8_t test;					// canned test number the numbers belong to
+	float bps;						// baseline blocks per second
+	float sps;						// baseline segments per second
+	float isr_max;					// baseline longest DDA ISR pass in uSec (0 if profiling was off)
+} tstBaseline_t;
+
+/***** Dry run job time estimation ******
+ *
+ *	$dry=1 arms dry run mode: the full parse/plan/exec pipeline runs, but the
+ *	loader consumes segments at maximum rate without ever touching the DDA
+ *	timer, while the exact planned time is accumulated from the segment
+ *	durations. A job streamed (or run from $test) while armed "runs" in a
+ *	small fraction of real time on the machine that will actually cut it,
+ *	and a JSON result with the planned job time is printed at program end,
+ *	when the mode disarms itself. $dry=0 cancels an armed mode. See
+ *	tst_dry_run() and the dry run hooks in stepper.c.
+ */
+typedef struct tstDryRun {
+	uint8_t running;				// true while dry run mode is armed
+	uint32_t us;					// planned time - microsecond residue
+	uint32_t seconds;				// planned time - whole seconds
+	uint32_t segments;				// segments consumed
+} tstDryRun_t;
+extern tstDryRun_t dry;
+
+/***** Serial loopback / throughput test ******
+ *
+ *	$lbt=n transmits a pattern on USART device n and counts what comes back,
+ *	timed on the RTC, so baud rate / flow control / driver changes can be
+ *	validated on production hardware without an instrumented host.
+ *	See tst_loopback() in test.c for the value encoding and caveats.
+ */
+#define LBT_INTERNAL_OFFSET 10		// $lbt values >= this run the self-loopback variant
+#define LBT_TEST_BYTES 2048			// patterned bytes transmitted per pass
+#define LBT_CHUNK_SIZE 32			// TX / injection / RX drain granularity
+#define LBT_SETTLE_TICKS (100 / RTC_MILLISECONDS)	// quiet time that ends the RX phase
+#define LBT_TIMEOUT_TICKS (2000 / RTC_MILLISECONDS)	// hard cap on the whole pass
+
+/***** DEBUG support ******
+ *
+ *	DEBUGs are print statements you probably only want enabled during 
+ *	debugging, and then probably only for one section of code or another.
+ *
+ *	DEBUG logging is enabled if __DEBUG is defined.
+ *	__DEBUG enables a set of arbitrary __dbXXXXXX defines that control 
+ *	various debug regions, e.g. __dbCONFIG to enable debugging in config.c.
+ *	Each __dbXXXXXX pairs with a dbXXXXXX global variable used as a flag.
+ *	Each dbXXXXXX is initialized to TRUE or FALSE at startup in main.c.
+ *	dbXXXXXX is used as a condition to enable or disable logging.
+ *	No varargs, so you must use the one with the right number of variables.
+ *	A closing semicolon is not required but is recommended for style.
+ *
+ *	DEBUG usage examples:
+ *		DEBUG0(dbCONFIG, PSTR("String with no variables"));
+ *		DEBUG1(dbCONFIG, PSTR("String with one variable: %f"), float_var);
+ *		DEBUG2(dbCONFIG, PSTR("String with two variables: %4.2f, %d"), float_var, int_var);
+ *
+ *	DEBUG print statements are coded so they occupy no program space if 
+ *	they are not enabled. If you also use __dbXXXX defines to enable debug
+ *	code these will - of course - be in the code regardless.
+ *
+ *	There are also a variety of module-specific diagnostic print statements 
+ *	that are enabled or not depending on whether __DEBUG is defined
+ */
+ 
+#ifdef __DEBUG
+void dump_everything(void);
+void roll_over_and_die(void);
+void print_scalar(const char *label, float value);
+void print_vector(const char *label, float vector[], uint8_t length);
+
+// global allocation of debug control variables
+	uint8_t dbECHO_GCODE_BLOCK;
+	uint8_t dbALINE_CALLED;
+	uint8_t dbSHOW_QUEUED_LINE;
+	uint8_t dbSHOW_LIMIT_SWITCH;
+	uint8_t dbSHOW_CONFIG_STATE;
+	uint8_t dbCONFIG_DEBUG_ENABLED;
+	uint8_t dbSHOW_LOAD_MOVE;
+
+#define DEBUG0(dbXXXXXX,msg) { if (dbXXXXXX == TRUE) { \
+								fprintf_P(stderr,PSTR("DEBUG: ")); \
+								fprintf_P(stderr,msg); \
+								fprintf_P(stderr,PSTR("\n"));}}
+
+#define DEBUG1(dbXXXXXX,msg,a) { if (dbXXXXXX == TRUE) { \
+								fprintf_P(stderr,PSTR("DEBUG: ")); \
+								fprintf_P(stderr,msg,a); \
+								fprintf_P(stderr,PSTR("\n"));}}
+
+#define DEBUG2(dbXXXXXX,msg,a,b) { if (dbXXXXXX == TRUE) { \
+								fprintf_P(stderr,PSTR("DEBUG: ")); \
+								fprintf_P(stderr,msg,a,b); \
+								fprintf_P(stderr,PSTR("\n"));}}
+
+#define DEBUG3(dbXXXXXX,msg,a,b,c) { if (dbXXXXXX == TRUE) { \
+								fprintf_P(stderr,PSTR("DEBUG: ")); \
+								fprintf_P(stderr,msg,a,b,c); \
+								fprintf_P(stderr,PSTR("\n"));}}
+#else
+#define DEBUG0(dbXXXXXX,msg)
+#define DEBUG1(dbXXXXXX,msg,a)
+#define DEBUG2(dbXXXXXX,msg,a,b)
+#define DEBUG3(dbXXXXXX,msg,a,b,c)
+#endif	// __DEBUG
+
+/***** Runtime Segment Data Logger Stuff *****
+ *
+ * This is independent of __DEBUG and does not need __DEBUG defined
+ */
+#ifdef __SEGMENT_LOGGER
+#define SEGMENT_LOGGER_MAX 256
+
+// segment logger structure and index
+struct mpSegmentLog {
+	uint8_t move_state;
+	uint32_t linenum;
+	uint32_t segments;
+	float velocity;
+	float microseconds;
+//	float position_x;
+//	float target_x;
+//	float step_x;
+//	float move_time;
+//	float accel_time;
+};
+struct mpSegmentLog sl[SEGMENT_LOGGER_MAX];
+uint16_t sl_index;
+
+// function prototype and calling macro
+void segment_logger(uint8_t move_state, 
+					uint32_t linenum,
+					uint32_t segments, 
+					uint32_t segment_count, 
+					float velocity,
+					float microseconds
+//					float position_x, 
+//					float target_x,
+//					float step_x, 
+//					float move_time,
+//					float accel_time
+					);
+
+#define SEGMENT_LOGGER segment_logger(bf->move_state, \
+									  mr.linenum, mr.segments, mr.segment_count, \
+									  mr.segment_velocity, \
+									  mr.microseconds);
+/*
+									  mr.microseconds, \
+									  mr.position[X], \
+									  mr.target[X], \
+									  steps[X], \
+									  mr.segment_move_time, \
+									  mr.segment_accel_time);
+*/
+#else
+#define SEGMENT_LOGGER
+#endif	// __SEGMENT_LOGGER
+#endif	// test_h
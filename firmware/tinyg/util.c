@@ -1,230 +1,401 @@
-/*
- * util.c - a random assortment of useful functions
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* util.c/.h contains a dog's breakfast of supporting functions that are 
- * not specific to tinyg: including:
- *
- *	  - math and min/max utilities and extensions 
- *	  - vector manipulation utilities
- *	  - support for debugging routines
- */  
-#include <ctype.h>
-#include <stdio.h>				// precursor for xio.h
-#include <stdlib.h>
-#include <stdbool.h>
-#include <math.h>
-#include <string.h>
-#include <avr/pgmspace.h>		// precursor for xio.h
-
-#include "tinyg.h"
-#include "util.h"
-#include "config.h"
-#include "controller.h"
-#include "canonical_machine.h"
-#include "planner.h"
-#include "stepper.h"
-#include "report.h"
-
-/**** Vector functions ****
- * copy_vector()			- copy vector of arbitrary length
- * copy_axis_vector()		- copy an axis vector
- * set_unit_vector()		- populate a unit vector by pos. & target
- * get_axis_vector_length()	- return the length of an axis vector
- * set_vector()				- load values into vector form
- * set_vector_by_axis()		- load a single value into a zero vector
- */
-
-void copy_vector(float dst[], const float src[], uint8_t length) 
-{
-	for (uint8_t i=0; i<length; i++) {
-		dst[i] = src[i];
-	}
-}
-
-void copy_axis_vector(float dst[], const float src[]) 
-{
-	memcpy(dst, src, sizeof(float)*AXES);
-}
-
-uint8_t vector_equal(const float a[], const float b[]) 
-{
-	if ((fp_EQ(a[AXIS_X], b[AXIS_X])) &&
-	 	(fp_EQ(a[AXIS_Y], b[AXIS_Y])) &&
-	 	(fp_EQ(a[AXIS_Z], b[AXIS_Z])) &&
-	 	(fp_EQ(a[AXIS_A], b[AXIS_A])) &&
-	 	(fp_EQ(a[AXIS_B], b[AXIS_B])) &&
-	 	(fp_EQ(a[AXIS_C], b[AXIS_C]))) {
-		return (true);
-	}
-	return (false);
-}
-
-float get_axis_vector_length(const float a[], const float b[]) 
-{
-	return (sqrt(square(a[AXIS_X] - b[AXIS_X]) +
-				 square(a[AXIS_Y] - b[AXIS_Y]) +
-				 square(a[AXIS_Z] - b[AXIS_Z]) +
-				 square(a[AXIS_A] - b[AXIS_A]) +
-				 square(a[AXIS_B] - b[AXIS_B]) +
-				 square(a[AXIS_C] - b[AXIS_C])));
-}
-
-float *set_vector(float x, float y, float z, float a, float b, float c)
-{
-	vector[AXIS_X] = x;
-	vector[AXIS_Y] = y;
-	vector[AXIS_Z] = z;
-	vector[AXIS_A] = a;
-	vector[AXIS_B] = b;
-	vector[AXIS_C] = c;
-	return (vector);
-}
-
-float *set_vector_by_axis(float value, uint8_t axis)
-{
-	clear_vector(vector);
-	switch (axis) {
-		case (AXIS_X): vector[AXIS_X] = value; break;
-		case (AXIS_Y): vector[AXIS_Y] = value; break;
-		case (AXIS_Z): vector[AXIS_Z] = value; break;
-		case (AXIS_A): vector[AXIS_A] = value; break;
-		case (AXIS_B): vector[AXIS_B] = value; break;
-		case (AXIS_C): vector[AXIS_C] = value;
-	}
-	return (vector);
-}
-
-/**** Math and other general purpose functions ****/
-
-/* Slightly faster (*) multi-value min and max functions
- * 	min3() - return minimum of 3 numbers
- * 	min4() - return minimum of 4 numbers
- * 	max3() - return maximum of 3 numbers
- * 	max4() - return maximum of 4 numbers
- *
- * Implementation tip: Order the min and max values from most to least likely in the calling args
- *
- * (*) Macro min4 is about 20uSec, inline function version is closer to 10 uSec
- * 	#define min3(a,b,c) (min(min(a,b),c))
- *	#define min4(a,b,c,d) (min(min(a,b),min(c,d)))
- *	#define max3(a,b,c) (max(max(a,b),c))
- *	#define max4(a,b,c,d) (max(max(a,b),max(c,d)))
- */
-
-inline float min3(float x1, float x2, float x3)
-{
-	float min = x1;
-	if (x2 < min) { min = x2;} 
-	if (x3 < min) { return (x3);} 
-	return (min);
-}
-
-inline float min4(float x1, float x2, float x3, float x4)
-{
-	float min = x1;
-	if (x2 < min) { min = x2;} 
-	if (x3 < min) { min = x3;} 
-	if (x4 < min) { return (x4);}
-	return (min);
-}
-
-inline float max3(float x1, float x2, float x3)
-{
-	float max = x1;
-	if (x2 > max) { max = x2;} 
-	if (x3 > max) { return (x3);} 
-	return (max);
-}
-
-inline float max4(float x1, float x2, float x3, float x4)
-{
-	float max = x1;
-	if (x2 > max) { max = x2;} 
-	if (x3 > max) { max = x3;} 
-	if (x4 > max) { return (x4);}
-	return (max);
-}
-
-/*
- * isnumber() - isdigit that also accepts plus, minus, and decimal point
- */
-
-uint8_t isnumber(char c)
-{
-	if (c == '.') { return (true); }
-	if (c == '-') { return (true); }
-	if (c == '+') { return (true); }
-	return (isdigit(c));
-}
-
-/* 
- * read_float() - read a float from a normalized char array
- *
- *	buf			normalized char array (line)
- *	i			char array index must point to start of number
- *	float_ptr	pointer to float to write value into
- *
- *	The line is normalized when it is all caps, has no white space,
- *	no non-alphnumeric characters, and no newline or CR.
- */
-
-uint8_t read_float(char *buf, uint8_t *i, float *float_ptr) 
-{
-	char *start = buf + *i;
-	char *end;
-  
-	*float_ptr = strtod(start, &end);
-	if(end == start) { 
-		return(false); 
-	}
-	*i = (uint8_t)(end - buf);
-	return(true);
-}
-
-/* 
- * compute_checksum() - calculate the checksum for a string
- * 
- *	Stops calculation on null termination or length value if non-zero.
- *
- * 	This is based on the the Java hashCode function. 
- *	See http://en.wikipedia.org/wiki/Java_hashCode()
- */
-#define HASHMASK 9999
-
-uint16_t compute_checksum(char const *string, const uint16_t length) 
-{
-	uint32_t h = 0;
-	uint16_t len = strlen(string);
-
-	if (length != 0) {
-		len = min(len, length);
-	}
-    for (uint16_t i=0; i<len; i++) {
-		h = 31 * h + string[i];
-    }
-    return (h % HASHMASK);
-}
-
+/*
+ * util.c - a random assortment of useful functions
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* util.c/.h contains a dog's breakfast of supporting functions that are 
+ * not specific to tinyg: including:
+ *
+ *	  - math and min/max utilities and extensions 
+ *	  - vector manipulation utilities
+ *	  - support for debugging routines
+ */  
+#include <ctype.h>
+#include <stdio.h>				// precursor for xio.h
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <string.h>
+#include <avr/pgmspace.h>		// precursor for xio.h
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "controller.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "stepper.h"
+#include "report.h"
+
+/**** Vector functions ****
+ * copy_vector()			- copy vector of arbitrary length
+ * copy_axis_vector()		- copy an axis vector
+ * set_unit_vector()		- populate a unit vector by pos. & target
+ * get_axis_vector_length()	- return the length of an axis vector
+ * get_axis_vector_length_fast() - as above w/approximate sqrt (planner hot path)
+ * set_vector()				- load values into vector form
+ * set_vector_by_axis()		- load a single value into a zero vector
+ */
+
+void copy_vector(float dst[], const float src[], uint8_t length) 
+{
+	for (uint8_t i=0; i<length; i++) {
+		dst[i] = src[i];
+	}
+}
+
+void copy_axis_vector(float dst[], const float src[]) 
+{
+	memcpy(dst, src, sizeof(float)*AXES);
+}
+
+uint8_t vector_equal(const float a[], const float b[]) 
+{
+	if (
+#if (AXES >= 4)
+	 	(fp_EQ(a[AXIS_A], b[AXIS_A])) &&
+#endif
+#if (AXES >= 6)
+	 	(fp_EQ(a[AXIS_B], b[AXIS_B])) &&
+	 	(fp_EQ(a[AXIS_C], b[AXIS_C])) &&
+#endif
+		(fp_EQ(a[AXIS_X], b[AXIS_X])) &&
+	 	(fp_EQ(a[AXIS_Y], b[AXIS_Y])) &&
+	 	(fp_EQ(a[AXIS_Z], b[AXIS_Z]))) {
+		return (true);
+	}
+	return (false);
+}
+
+float get_axis_vector_length(const float a[], const float b[])
+{
+	return (sqrt(
+#if (AXES >= 4)
+				 square(a[AXIS_A] - b[AXIS_A]) +
+#endif
+#if (AXES >= 6)
+				 square(a[AXIS_B] - b[AXIS_B]) +
+				 square(a[AXIS_C] - b[AXIS_C]) +
+#endif
+				 square(a[AXIS_X] - b[AXIS_X]) +
+				 square(a[AXIS_Y] - b[AXIS_Y]) +
+				 square(a[AXIS_Z] - b[AXIS_Z])));
+}
+
+/*
+ * fast_recip_sqrt() - approximate 1/sqrt(x): bit-level seed + one Newton step
+ * fast_sqrt()       - approximate sqrt(x) built on fast_recip_sqrt()
+ * get_axis_vector_length_fast() - get_axis_vector_length() using fast_sqrt()
+ *
+ *	Software sqrt() on the xmega costs on the order of 500 cycles. The
+ *	magic-constant seed (Lomont's 0x5f3759df) refined by a single
+ *	Newton-Raphson iteration is accurate to ~0.18% worst case across the
+ *	normalized float range - plenty for planner quantities (move lengths,
+ *	junction velocities) that only steer the velocity profile and never
+ *	position an axis. This is the fast side of the accuracy switch: paths
+ *	that report or must be exact (status reports, probe capture, feedhold
+ *	length fitting) keep using the exact functions above.
+ *
+ *	fast_sqrt(0) degenerates gracefully to 0 (0 times a large finite seed).
+ */
+
+float fast_recip_sqrt(float x)
+{
+	union { float f; uint32_t i; } pun;
+	pun.f = x;
+	pun.i = 0x5f3759df - (pun.i >> 1);					// the bit-level seed
+	return (pun.f * (1.5 - (0.5 * x * pun.f * pun.f)));	// one Newton-Raphson iteration
+}
+
+float fast_sqrt(float x)
+{
+	return (x * fast_recip_sqrt(x));		// x/sqrt(x) == sqrt(x)
+}
+
+float get_axis_vector_length_fast(const float a[], const float b[])
+{
+	return (fast_sqrt(
+#if (AXES >= 4)
+					  square(a[AXIS_A] - b[AXIS_A]) +
+#endif
+#if (AXES >= 6)
+					  square(a[AXIS_B] - b[AXIS_B]) +
+					  square(a[AXIS_C] - b[AXIS_C]) +
+#endif
+					  square(a[AXIS_X] - b[AXIS_X]) +
+					  square(a[AXIS_Y] - b[AXIS_Y]) +
+					  square(a[AXIS_Z] - b[AXIS_Z])));
+}
+
+float *set_vector(float x, float y, float z, float a, float b, float c)
+{
+	vector[AXIS_X] = x;
+	vector[AXIS_Y] = y;
+	vector[AXIS_Z] = z;
+#if (AXES >= 4)
+	vector[AXIS_A] = a;
+#endif
+#if (AXES >= 6)
+	vector[AXIS_B] = b;
+	vector[AXIS_C] = c;
+#endif
+	return (vector);
+}
+
+float *set_vector_by_axis(float value, uint8_t axis)
+{
+	clear_vector(vector);
+	switch (axis) {
+		case (AXIS_X): vector[AXIS_X] = value; break;
+		case (AXIS_Y): vector[AXIS_Y] = value; break;
+		case (AXIS_Z): vector[AXIS_Z] = value; break;
+#if (AXES >= 4)
+		case (AXIS_A): vector[AXIS_A] = value; break;
+#endif
+#if (AXES >= 6)
+		case (AXIS_B): vector[AXIS_B] = value; break;
+		case (AXIS_C): vector[AXIS_C] = value;
+#endif
+	}
+	return (vector);
+}
+
+/**** Math and other general purpose functions ****/
+
+/* Slightly faster (*) multi-value min and max functions
+ * 	min3() - return minimum of 3 numbers
+ * 	min4() - return minimum of 4 numbers
+ * 	max3() - return maximum of 3 numbers
+ * 	max4() - return maximum of 4 numbers
+ *
+ * Implementation tip: Order the min and max values from most to least likely in the calling args
+ *
+ * (*) Macro min4 is about 20uSec, inline function version is closer to 10 uSec
+ * 	#define min3(a,b,c) (min(min(a,b),c))
+ *	#define min4(a,b,c,d) (min(min(a,b),min(c,d)))
+ *	#define max3(a,b,c) (max(max(a,b),c))
+ *	#define max4(a,b,c,d) (max(max(a,b),max(c,d)))
+ */
+
+inline float min3(float x1, float x2, float x3)
+{
+	float min = x1;
+	if (x2 < min) { min = x2;} 
+	if (x3 < min) { return (x3);} 
+	return (min);
+}
+
+inline float min4(float x1, float x2, float x3, float x4)
+{
+	float min = x1;
+	if (x2 < min) { min = x2;} 
+	if (x3 < min) { min = x3;} 
+	if (x4 < min) { return (x4);}
+	return (min);
+}
+
+inline float max3(float x1, float x2, float x3)
+{
+	float max = x1;
+	if (x2 > max) { max = x2;} 
+	if (x3 > max) { return (x3);} 
+	return (max);
+}
+
+inline float max4(float x1, float x2, float x3, float x4)
+{
+	float max = x1;
+	if (x2 > max) { max = x2;} 
+	if (x3 > max) { max = x3;} 
+	if (x4 > max) { return (x4);}
+	return (max);
+}
+
+/*
+ * isnumber() - isdigit that also accepts plus, minus, and decimal point
+ */
+
+uint8_t isnumber(char c)
+{
+	if (c == '.') { return (true); }
+	if (c == '-') { return (true); }
+	if (c == '+') { return (true); }
+	return (isdigit(c));
+}
+
+/* 
+ * read_float() - read a float from a normalized char array
+ *
+ *	pstr		pointer to a pointer into the normalized char array; must point
+ *				to the start of the number and is advanced past it on success
+ *	float_ptr	pointer to float to write value into
+ *
+ *	The line is normalized when it is all caps, has no white space,
+ *	no non-alphnumeric characters, and no newline or CR.
+ *
+ *	This is a fixed-format scanner: [+-] digits [. digits] - the decimal
+ *	notation gcode actually uses. It runs in a fraction of the time of
+ *	avr-libc strtod(), which supports exponents, hex floats, inf/nan and
+ *	locale handling that never appear in a gcode block. The mantissa is
+ *	accumulated in a uint32 and scaled by a negative power of ten from a
+ *	table; digits beyond the 9th are consumed but ignored (single precision
+ *	floats only carry ~7 significant digits anyway), except that excess
+ *	integer digits still scale the magnitude.
+ */
+
+static const float _neg_powers_of_10[] PROGMEM = {
+	1, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001, 0.00000001 };
+
+uint8_t read_float(char **pstr, float *float_ptr) 
+{
+	char *str = *pstr;
+	uint32_t mantissa = 0;
+	uint8_t digits = 0;
+	int8_t fraction_digits = 0;
+	uint8_t negative = false;
+
+	if (*str == '-') { negative = true; str++; } 
+	else if (*str == '+') { str++; }
+
+	while (isdigit(*str)) {				// integer part
+		if (digits < 9) {
+			mantissa = (mantissa * 10) + (*str - '0');
+			digits++;
+		} else {
+			fraction_digits--;			// excess integer digit - scale up by ten
+		}
+		str++;
+	}
+	if (*str == '.') {
+		str++;
+		while (isdigit(*str)) {			// fractional part
+			if (digits < 9) {
+				mantissa = (mantissa * 10) + (*str - '0');
+				digits++;
+				fraction_digits++;
+			}
+			str++;
+		}
+	}
+	if (digits == 0) { return(false); }	// no digits at all
+
+	float value = (float)mantissa;
+	if (fraction_digits > 0) {
+		value *= pgm_read_float(&_neg_powers_of_10[fraction_digits]);
+	} else {
+		while (fraction_digits < 0) { value *= 10; fraction_digits++;}	// excess integer digits
+	}
+	*float_ptr = (negative == true) ? -value : value;
+	*pstr = str;
+	return(true);
+}
+
+/*
+ * fntoa() - write a float as decimal ASCII at a fixed precision
+ *
+ *	str			buffer to write into; must hold 13 chars plus terminator
+ *	n			value to write
+ *	precision	fractional digits, 0 to 5 (clamped)
+ *
+ *	Output-side counterpart to read_float(), and built for the same reason:
+ *	the value is scaled and rounded into a uint32 and both halves are emitted
+ *	with integer math, which runs about 10x faster than avr-libc printf float
+ *	formatting and doesn't need the printf_flt library linked. Values too
+ *	large for the fixed point intermediate (never the machine's working
+ *	ranges) fall back to sprintf. Returns the number of characters written.
+ */
+
+static const uint32_t _powers_of_10[] PROGMEM = {
+	1, 10, 100, 1000, 10000, 100000 };
+
+uint8_t fntoa(char *str, float n, uint8_t precision)
+{
+	char tmp[10];
+	char *p = str;
+	uint8_t i = 0;
+
+	if (precision > 5) { precision = 5;}
+	if (isnan(n)) { strcpy(str, "nan"); return (3);}
+	if (isinf(n)) { strcpy(str, "inf"); return (3);}
+	if (n < 0) { *p++ = '-'; n = -n;}
+
+	uint32_t scale = pgm_read_dword(&_powers_of_10[precision]);
+	if (n >= (4294967295.0 / scale)) {				// won't fit the fixed point intermediate
+		return (sprintf(str, "%0.*f", precision, (double)n));
+	}
+	uint32_t fixed = (uint32_t)(((double)n * scale) + 0.5);	// scaled and rounded (half away from zero)
+	uint32_t ipart = fixed / scale;
+	uint32_t fpart = fixed - (ipart * scale);
+
+	do { tmp[i++] = '0' + (ipart % 10); ipart /= 10;} while (ipart != 0);
+	while (i != 0) { *p++ = tmp[--i];}				// integer digits were generated reversed
+	if (precision != 0) {
+		*p++ = '.';
+		p += precision;
+		char *q = p;
+		for (i = precision; i != 0; i--) { *(--q) = '0' + (fpart % 10); fpart /= 10;}
+	}
+	*p = 0;
+	return (p - str);
+}
+
+/*
+ * compute_checksum()  - calculate the checksum for a string
+ * finalize_checksum() - reduce an accumulated hash to checksum form
+ *
+ *	Stops calculation on null termination or length value if non-zero.
+ *
+ * 	This is based on the the Java hashCode function.
+ *	See http://en.wikipedia.org/wiki/Java_hashCode()
+ *
+ *	Callers that produce output in pieces (e.g. the streaming JSON
+ *	serializer) can accumulate h = 31*h + char themselves and call
+ *	finalize_checksum() - it yields the same value compute_checksum()
+ *	would return for the whole string.
+ *
+ *	The algorithm is wire protocol - hosts at the other end compute it -
+ *	so it cannot be swapped for the hardware CRC. See xmega_crc.c for
+ *	in-memory integrity checking, which has no such constraint.
+ */
+#define HASHMASK 9999
+
+uint16_t compute_checksum(char const *string, const uint16_t length)
+{
+	uint32_t h = 0;
+	uint16_t len = strlen(string);
+
+	if (length != 0) {
+		len = min(len, length);
+	}
+    for (uint16_t i=0; i<len; i++) {
+		h = 31 * h + string[i];
+    }
+    return (finalize_checksum(h));
+}
+
+uint16_t finalize_checksum(uint32_t h)
+{
+	return (h % HASHMASK);
+}
+
@@ -1,116 +1,121 @@
-/*
- * util.h - a random assortment of useful functions
- * Part of TinyG project
- *
- * Copyright (c) 2011 - 2012 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * As a special exception, you may use this file as part of a software library without
- * restriction. Specifically, if other files instantiate templates or use macros or
- * inline functions from this file, or you compile this file and link it with  other
- * files to produce an executable, this file does not by itself cause the resulting
- * executable to be covered by the GNU General Public License. This exception does not
- * however invalidate any other reasons why the executable file might be covered by the
- * GNU General Public License.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-/* util.c/.h contains a dog's breakfast of supporting functions that are 
- * not specific to tinyg: including:
- *
- *	  - math and min/max utilities and extensions 
- *	  - vector manipulation utilities
- *	  - support for debugging routines
- */  
-
-#ifndef util_h
-#define util_h
-
-/****** Global Scope Variables and Functions ******/
-
-float vector[AXES];				// vector of axes for passing to subroutines
-
-float min3(float x1, float x2, float x3);
-float min4(float x1, float x2, float x3, float x4);
-float max3(float x1, float x2, float x3);
-float max4(float x1, float x2, float x3, float x4);
-uint8_t isnumber(char c);
-uint8_t read_float(char *buf, uint8_t *i, float *float_ptr);
-uint16_t compute_checksum(char const *string, const uint16_t length);
-
-void copy_vector(float dst[], const float src[], uint8_t length);
-void copy_axis_vector(float dst[], const float src[]);
-uint8_t vector_equal(const float a[], const float b[]) ;
-float get_axis_vector_length(const float a[], const float b[]);
-float *set_vector(float x, float y, float z, float a, float b, float c);
-float *set_vector_by_axis(float value, uint8_t axis);
-#define clear_vector(a) memset(a,0,sizeof(a))
-
-/***** Math Support *****/
-
-// side-effect safe forms of min and max
-#ifndef max
-#define max(a,b) \
-   ({ __typeof__ (a) termA = (a); \
-      __typeof__ (b) termB = (b); \
-	  termA>termB ? termA:termB; })
-#endif
-
-#ifndef min
-#define min(a,b) \
-   ({ __typeof__ (a) termA = (a); \
-      __typeof__ (b) termB = (b); \
-      termA<termB ? termA:termB; })
-#endif
-
-#ifndef avg
-#define avg(a,b) ((a+b)/2)
-#endif
-
-#ifndef EPSILON
-#define EPSILON 	0.00001					// rounding error for floats
-//#define EPSILON 	0.000001				// rounding error for floats
-#endif
-
-#ifndef fp_EQ
-#define fp_EQ(a,b) (fabs(a-b) < EPSILON)	// requires math.h to be included in each file used
-#endif
-#ifndef fp_NE
-#define fp_NE(a,b) (fabs(a-b) > EPSILON)	// requires math.h to be included in each file used
-#endif
-#ifndef fp_ZERO
-#define fp_ZERO(a) (fabs(a) < EPSILON)		// requires math.h to be included in each file used
-#endif
-#ifndef fp_NOT_ZERO
-#define fp_NOT_ZERO(a) (fabs(a) > EPSILON)	// requires math.h to be included in each file used
-#endif
-#ifndef fp_FALSE
-#define fp_FALSE(a) (a < EPSILON)			// float is interpreted as FALSE (equals zero)
-#endif
-#ifndef fp_TRUE
-#define fp_TRUE(a) (a > EPSILON)			// float is interpreted as TRUE (not equal to zero)
-#endif
-
-// Constants
-#define MAX_LONG (2147483647)
-#define MAX_ULONG (4294967295)
-#define MM_PER_INCH (25.4)
-#define INCH_PER_MM (1/25.4)
-#define MICROSECONDS_PER_MINUTE ((float)60000000)
-#define uSec(a) ((float)(a * MICROSECONDS_PER_MINUTE))
-
-#define RADIAN (57.2957795)
-//		M_PI is pi as defined in math.h
-//		M_SQRT2 is radical2 as defined in math.h
-#define M_SQRT3 (1.73205080756888)
-
-#endif	// util_h
+/*
+ * util.h - a random assortment of useful functions
+ * Part of TinyG project
+ *
+ * Copyright (c) 2011 - 2012 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, you may use this file as part of a software library without
+ * restriction. Specifically, if other files instantiate templates or use macros or
+ * inline functions from this file, or you compile this file and link it with  other
+ * files to produce an executable, this file does not by itself cause the resulting
+ * executable to be covered by the GNU General Public License. This exception does not
+ * however invalidate any other reasons why the executable file might be covered by the
+ * GNU General Public License.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* util.c/.h contains a dog's breakfast of supporting functions that are 
+ * not specific to tinyg: including:
+ *
+ *	  - math and min/max utilities and extensions 
+ *	  - vector manipulation utilities
+ *	  - support for debugging routines
+ */  
+
+#ifndef util_h
+#define util_h
+
+/****** Global Scope Variables and Functions ******/
+
+float vector[AXES];				// vector of axes for passing to subroutines
+
+float min3(float x1, float x2, float x3);
+float min4(float x1, float x2, float x3, float x4);
+float max3(float x1, float x2, float x3);
+float max4(float x1, float x2, float x3, float x4);
+uint8_t isnumber(char c);
+uint8_t read_float(char **pstr, float *float_ptr);
+uint8_t fntoa(char *str, float n, uint8_t precision);
+uint16_t compute_checksum(char const *string, const uint16_t length);
+uint16_t finalize_checksum(uint32_t h);
+
+void copy_vector(float dst[], const float src[], uint8_t length);
+void copy_axis_vector(float dst[], const float src[]);
+uint8_t vector_equal(const float a[], const float b[]) ;
+float get_axis_vector_length(const float a[], const float b[]);
+float get_axis_vector_length_fast(const float a[], const float b[]);
+float fast_recip_sqrt(float x);
+float fast_sqrt(float x);
+float *set_vector(float x, float y, float z, float a, float b, float c);
+float *set_vector_by_axis(float value, uint8_t axis);
+#define clear_vector(a) memset(a,0,sizeof(a))
+
+/***** Math Support *****/
+
+// side-effect safe forms of min and max
+#ifndef max
+#define max(a,b) \
+   ({ __typeof__ (a) termA = (a); \
+      __typeof__ (b) termB = (b); \
+	  termA>termB ? termA:termB; })
+#endif
+
+#ifndef min
+#define min(a,b) \
+   ({ __typeof__ (a) termA = (a); \
+      __typeof__ (b) termB = (b); \
+      termA<termB ? termA:termB; })
+#endif
+
+#ifndef avg
+#define avg(a,b) ((a+b)/2)
+#endif
+
+#ifndef EPSILON
+#define EPSILON 	0.00001					// rounding error for floats
+//#define EPSILON 	0.000001				// rounding error for floats
+#endif
+
+#ifndef fp_EQ
+#define fp_EQ(a,b) (fabs(a-b) < EPSILON)	// requires math.h to be included in each file used
+#endif
+#ifndef fp_NE
+#define fp_NE(a,b) (fabs(a-b) > EPSILON)	// requires math.h to be included in each file used
+#endif
+#ifndef fp_ZERO
+#define fp_ZERO(a) (fabs(a) < EPSILON)		// requires math.h to be included in each file used
+#endif
+#ifndef fp_NOT_ZERO
+#define fp_NOT_ZERO(a) (fabs(a) > EPSILON)	// requires math.h to be included in each file used
+#endif
+#ifndef fp_FALSE
+#define fp_FALSE(a) (a < EPSILON)			// float is interpreted as FALSE (equals zero)
+#endif
+#ifndef fp_TRUE
+#define fp_TRUE(a) (a > EPSILON)			// float is interpreted as TRUE (not equal to zero)
+#endif
+
+// Constants
+#define MAX_LONG (2147483647)
+#define MAX_ULONG (4294967295)
+#define MM_PER_INCH (25.4)
+#define INCH_PER_MM (1/25.4)
+#define MICROSECONDS_PER_MINUTE ((float)60000000)
+#define uSec(a) ((float)(a * MICROSECONDS_PER_MINUTE))
+
+#define RADIAN (57.2957795)
+//		M_PI is pi as defined in math.h
+//		M_SQRT2 is radical2 as defined in math.h
+#define M_SQRT3 (1.73205080756888)
+
+#endif	// util_h
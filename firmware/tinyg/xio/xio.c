@@ -168,11 +168,28 @@ FILE *xio_open(uint8_t dev, const char *addr, flags_t flags)
 	return (ds[dev].x_open(dev, addr, flags));
 }
 
-int xio_gets(const uint8_t dev, char *buf, const int size) 
+int xio_gets(const uint8_t dev, char *buf, const int size)
 {
 	return (ds[dev].x_gets(&ds[dev], buf, size));
 }
 
+/*
+ * xio_gets_line() - get a line as a pointer+buffer (zero-copy where possible)
+ *
+ *	USART devices deliver the line in place from the RX ring (see
+ *	xio_gets_line_usart()); other devices fall back to the copying reader
+ *	with *linep pointed at the caller's buffer. Callers treat both the same.
+ */
+int xio_gets_line(const uint8_t dev, char **linep, char *buf, const int size)
+{
+	xioDev_t *d = &ds[dev];
+	if (d->x_gets == xio_gets_usart) {
+		return (xio_gets_line_usart(d, linep, buf, size));
+	}
+	*linep = buf;
+	return (d->x_gets(d, buf, size));
+}
+
 int xio_getc(const uint8_t dev) 
 { 
 	return (ds[dev].x_getc(&ds[dev].file)); 
@@ -180,7 +197,55 @@ int xio_getc(const uint8_t dev)
 
 int xio_putc(const uint8_t dev, const char c)
 {
-	return (ds[dev].x_putc(c, &ds[dev].file)); 
+	return (ds[dev].x_putc(c, &ds[dev].file));
+}
+
+/*
+ * xio_write() - block write a string to a device
+ * xio_write_stream() - block write to a device given its stdio stream
+ *
+ *	The USB device gets the bulk path, which memcpy's the string into the TX
+ *	ring and kicks the transmitter once (see xio_write_usb()); other devices
+ *	fall back to a putc() loop. The stream variant exists so callers holding a
+ *	FILE* (e.g. stderr) don't need to know which device it's bound to.
+ */
+int xio_write(const uint8_t dev, const char *buf, const int size)
+{
+	if (dev == XIO_DEV_USB) {
+		return (xio_write_usb(buf, size));
+	}
+	xioDev_t *d = &ds[dev];
+	for (int i=0; i<size; i++) {
+		d->x_putc(buf[i], &d->file);
+	}
+	return (XIO_OK);
+}
+
+int xio_write_stream(FILE *stream, const char *buf, const int size)
+{
+	xioDev_t *d = (xioDev_t *)stream->udata;	// streams are bound to their device structs
+	return (xio_write(d->dev, buf, size));
+}
+
+/*
+ * xio_write_pri() - block write a report ahead of queued traffic
+ * xio_write_stream_pri() - priority write to a device given its stdio stream
+ *
+ *	The USB device routes through the priority TX ring (see xio_write_usb_pri());
+ *	other devices have no priority path and fall back to the ordinary write.
+ */
+int xio_write_pri(const uint8_t dev, const char *buf, const int size)
+{
+	if (dev == XIO_DEV_USB) {
+		return (xio_write_usb_pri(buf, size));
+	}
+	return (xio_write(dev, buf, size));
+}
+
+int xio_write_stream_pri(FILE *stream, const char *buf, const int size)
+{
+	xioDev_t *d = (xioDev_t *)stream->udata;
+	return (xio_write_pri(d->dev, buf, size));
 }
 
 /*
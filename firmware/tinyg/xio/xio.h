@@ -49,6 +49,7 @@ enum xioDevNum_t {		// TYPE:	DEVICE:
 //	XIO_DEV_SPI3,		// SPI		SPI channel #3
 //	XIO_DEV_SPI4,		// SPI		SPI channel #4
 	XIO_DEV_PGM,		// FILE		Program memory file  (read only)
+	XIO_DEV_FLASH,		// FILE		External SPI flash file (read only)
 //	XIO_DEV_SD,			// FILE		SD card (not implemented)
 	XIO_DEV_COUNT		// total device count (must be last entry)
 };
@@ -60,7 +61,7 @@ enum xioDevNum_t {		// TYPE:	DEVICE:
 #define XIO_DEV_SPI_COUNT 		2 				// # of SPI devices
 #define XIO_DEV_SPI_OFFSET		XIO_DEV_USART_COUNT	// offset for computing indicies
 
-#define XIO_DEV_FILE_COUNT		1				// # of FILE devices
+#define XIO_DEV_FILE_COUNT		2				// # of FILE devices
 #define XIO_DEV_FILE_OFFSET		(XIO_DEV_USART_COUNT + XIO_DEV_SPI_COUNT) // index into FILES
 
 /******************************************************************************
@@ -142,9 +143,11 @@ extern struct controllerSingleton tg;	// needed by init() for default source
  *	Function Prototypes and Macros
  *************************************************************************/
 
-// Advance RX or TX head or tail. Buffers count down, so advance is a decrement.
+// Advance RX or TX head or tail. Rings fill upwards so advance is an
+// increment; location 0 is never used (it marks the wrap). Upward fill keeps
+// queued data contiguous in memory for the zero-copy and bulk-write paths.
 // The zero condition is the wrap that sets the index back to the top.
-#define advance_buffer(buf,len) { if ((--(buf)) == 0) buf = len-1;}
+#define advance_buffer(buf,len) { if ((++(buf)) > len-1) buf = 1;}
 
 // public functions (virtual class) 
 void xio_init(void);
@@ -152,8 +155,13 @@ void xio_reset_working_flags(xioDev_t *d);
 FILE *xio_open(const uint8_t dev, const char *addr, const flags_t flags);
 int xio_ctrl(const uint8_t dev, const flags_t flags);
 int xio_gets(const uint8_t dev, char *buf, const int size);
+int xio_gets_line(const uint8_t dev, char **linep, char *buf, const int size);
 int xio_getc(const uint8_t dev);
 int xio_putc(const uint8_t dev, const char c);
+int xio_write(const uint8_t dev, const char *buf, const int size);
+int xio_write_stream(FILE *stream, const char *buf, const int size);
+int xio_write_pri(const uint8_t dev, const char *buf, const int size);
+int xio_write_stream_pri(FILE *stream, const char *buf, const int size);
 int xio_set_baud(const uint8_t dev, const uint8_t baud_rate);
 
 // generic functions (private, but at virtual level)
@@ -251,6 +259,8 @@ enum xioSignals {
 #define CHAR_FEEDHOLD (char)'!'
 #define CHAR_CYCLE_START (char)'~'
 #define CHAR_QUEUE_FLUSH (char)'%'
+#define CHAR_JOB_ABORT ETX			// ^c - fast job abort (see cm_job_abort)
+#define CHAR_STATUS_REPORT ENQ		// ^e - request an immediate status report
 //#define CHAR_BOOTLOADER ESC
 
 /* XIO return codes
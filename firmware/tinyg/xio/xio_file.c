@@ -21,7 +21,7 @@
 
 #include <stdio.h>				// precursor for xio.h
 #include <stdbool.h>			// true and false
-#include <string.h>				// for memset
+#include <string.h>				// for memset
 #include <avr/pgmspace.h>		// precursor for xio.h
 #include "xio.h"				// includes for all devices are in here
 
@@ -46,6 +46,14 @@ static struct cfgFILE const cfgFile[] PROGMEM = {
 	xio_getc_pgm,				// stdio getc function
 	xio_putc_pgm,				// stdio putc function
 	xio_fc_null,				// flow control callback
+},
+{	// FLASH config (see xio_flash.c)
+	xio_open_flash,				// open function
+	xio_ctrl_generic, 			// ctrl function
+	xio_gets_flash,				// get string function
+	xio_getc_flash,				// stdio getc function
+	xio_putc_pgm,				// stdio putc function (read-only device - always errors)
+	xio_fc_null,				// flow control callback
 }
 };
 /******************************************************************************
@@ -1,11 +1,11 @@
-/*
+/*
  * xio_file.h	- device driver for file-type devices
  *   			- works with avr-gcc stdio library
  *
  * Part of TinyG project
  *
- * Copyright (c) 2011 - 2013 Alden S. Hart Jr.
- *
+ * Copyright (c) 2011 - 2013 Alden S. Hart Jr.
+ *
  * This file ("the software") is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License, version 2 as published by the
  * Free Software Foundation. You should have received a copy of the GNU General Public
@@ -52,9 +52,9 @@
 		return;
 	}
 */
-
-#ifndef xio_file_h
-#define xio_file_h
+
+#ifndef xio_file_h
+#define xio_file_h
 
 #define PGMFILE (const PROGMEM char *)		// extends pgmspace.h
 
@@ -88,6 +88,13 @@ int xio_gets_pgm(xioDev_t *d, char *buf, const int size);			// read string from
 int xio_getc_pgm(FILE *stream);									// get a character from PROGMEM
 int xio_putc_pgm(const char c, FILE *stream);					// always returns ERROR
 
-// SD Card functions
+// SPI flash functions (see xio_flash.c)
+
+#define FLASH_FLAGS (XIO_BLOCK | XIO_CRLF | XIO_LINEMODE)
+
+FILE *xio_open_flash(const uint8_t dev, const char *addr, const flags_t flags);
+int xio_gets_flash(xioDev_t *d, char *buf, const int size);		// read string from SPI flash
+int xio_getc_flash(FILE *stream);								// get a character from SPI flash
+uint8_t xio_flash_prefetch_callback(void);						// main loop page prefetcher
 
-#endif
+#endif
@@ -0,0 +1,188 @@
+/*
+ *  xio_flash.c	- device driver for external SPI flash "files"
+ * 				- works with avr-gcc stdio library
+ *
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* ---- Flash job storage ----
+ *
+ *	Gcode jobs stored in an external SPI NOR flash are exposed through the same
+ *	device abstraction as PROGMEM files: open the device at a flash byte offset,
+ *	set it as the input source, and EOF hands control back to the default source
+ *	(see _dispatch() in controller.c). Jobs are plain text terminated by a NUL
+ *	or an erased (0xFF) byte. Running a job locally takes the serial link out of
+ *	the performance equation entirely - long jobs become planner-bound.
+ *
+ *	Reads are double buffered: the parser always reads from a RAM page while
+ *	the main-loop prefetch callback refills the spent page from the flash, so
+ *	the parser almost never waits on the (bit-banged) bus. If the prefetcher
+ *	falls behind the page is fetched in line - slower, but correct.
+ *
+ *	The flash shares the bit-banged SPI port and is addressed with the SPI2
+ *	slave select (see xio_read_spi_flash() in xio_spi.c), so a board fitted
+ *	with the flash gives up the SPI2 character-protocol slave position.
+ */
+
+#include <stdio.h>						// precursor for xio.h
+#include <stdbool.h>					// true and false
+#include <string.h>						// for memset
+#include <avr/pgmspace.h>				// precursor for xio.h
+#include "xio.h"						// includes for all devices are in here
+#include "../tinyg.h"					// needed for status codes
+
+// Fast accessors (cheating)
+#define FLASH ds[XIO_DEV_FLASH]			// device struct accessor
+#define FLASHf fs[XIO_DEV_FLASH - XIO_DEV_FILE_OFFSET]	// file extended struct accessor
+
+#define FLASH_SPI_DEV XIO_DEV_SPI2		// SPI device whose select line addresses the flash
+#define FLASH_PAGE_SIZE 128				// prefetch page size (one flash read burst)
+#define FLASH_ADDR_MAX (uint32_t)0x200000	// 2 Mbytes - set to the fitted part
+
+static char flash_page[2][FLASH_PAGE_SIZE];	// double buffered prefetch pages
+static uint8_t flash_page_len[2];		// filled length of each page (0 = empty)
+static uint8_t flash_page_active;		// page the parser is reading from
+static uint8_t flash_page_index;		// read index into the active page
+static uint8_t flash_open_flag;			// a job is open - keep the prefetcher running
+
+static void _fetch_flash_page(uint8_t page);
+
+/*
+ *	xio_open_flash() - open the flash device to a job's flash byte offset
+ *
+ *	As with the PGM device this is only the moral equivalent of a UNIX open().
+ *	Jobs are stored on 256 byte boundaries and addr carries the job's 256 byte
+ *	page number - a 16 bit pointer can't span the whole part in byte units.
+ *	Primes both prefetch pages so the first reads come from RAM.
+ */
+FILE *xio_open_flash(const uint8_t dev, const char *addr, const flags_t flags)
+{
+	xioDev_t *d = &ds[dev];
+	d->x = &fs[dev - XIO_DEV_FILE_OFFSET];			// bind extended struct to device
+	xioFile_t *dx = (xioFile_t *)d->x;
+
+	memset (dx, 0, sizeof(xioFile_t));				// clear all values
+	xio_reset_working_flags(d);
+	xio_ctrl_generic(d, flags);						// setup control flags
+	dx->rd_offset = ((uint32_t)addr) << 8;			// jobs are addressed by 256 byte page number
+	dx->max_offset = FLASH_ADDR_MAX;
+
+	flash_page_len[0] = 0;							// reset the prefetcher
+	flash_page_len[1] = 0;
+	flash_page_active = 0;
+	flash_page_index = 0;
+	flash_open_flag = true;
+	_fetch_flash_page(0);							// prime both pages
+	_fetch_flash_page(1);
+	return (&d->file);								// return pointer to the FILE stream
+}
+
+/*
+ *	xio_flash_prefetch_callback() - main loop callback to refill spent pages
+ *
+ *	Fetches at most one page per pass to bound the time taken from the loop
+ *	(a page is one select-to-deselect burst on the bit-banged bus).
+ */
+uint8_t xio_flash_prefetch_callback(void)
+{
+	if (flash_open_flag == false) { return (STAT_NOOP);}
+	if (flash_page_len[0] == 0) { _fetch_flash_page(0); return (STAT_OK);}
+	if (flash_page_len[1] == 0) { _fetch_flash_page(1); return (STAT_OK);}
+	return (STAT_NOOP);
+}
+
+static void _fetch_flash_page(uint8_t page)
+{
+	xioFile_t *dx = (xioFile_t *)FLASH.x;
+	uint16_t len = FLASH_PAGE_SIZE;
+
+	if (dx->rd_offset >= dx->max_offset) { return;}	// ran off the end of the part
+	if ((dx->rd_offset + len) > dx->max_offset) {
+		len = dx->max_offset - dx->rd_offset;
+	}
+	xio_read_spi_flash(FLASH_SPI_DEV, dx->rd_offset, flash_page[page], len);
+	dx->rd_offset += len;
+	flash_page_len[page] = len;
+}
+
+/*
+ *	xio_gets_flash() - main loop task for the flash device
+ *
+ *	Non-blocking, run-to-completion return a line from the flash.
+ *	Note: LINEMODE flag is ignored. It's ALWAYS LINEMODE here.
+ */
+int xio_gets_flash(xioDev_t *d, char *buf, const int size)
+{
+	if ((flash_open_flag == false) && (d->flag_eof == false)) {
+		return (XIO_FILE_NOT_OPEN);					// no job is open
+	}
+	d->signal = XIO_SIG_OK;							// initialize signal
+	if (fgets(buf, size, &FLASH.file) == NULL) {
+		flash_open_flag = false;
+		clearerr(&FLASH.file);
+		return (XIO_EOF);
+	}
+	return (XIO_OK);
+}
+
+/*
+ *  xio_getc_flash() - read a character from the flash device
+ *
+ *	Serves characters from the active prefetch page and flips to the other
+ *	page when it's spent. EOF and LINEMODE behaviors match xio_getc_pgm(),
+ *	with an erased (0xFF) byte treated the same as a NUL terminator.
+ */
+int xio_getc_flash(FILE *stream)
+{
+	char c;
+
+	if (FLASH.flag_eof ) {
+		FLASH.signal = XIO_SIG_EOF;
+		return (_FDEV_EOF);
+	}
+	if (flash_page_len[flash_page_active] == 0) {	// prefetch miss (or end of part)
+		_fetch_flash_page(flash_page_active);		// fetch in line - slower but correct
+	}
+	if (flash_page_len[flash_page_active] == 0) {	// nothing left in the part
+		c = NUL;
+	} else {
+		c = flash_page[flash_page_active][flash_page_index];
+		if (++flash_page_index >= flash_page_len[flash_page_active]) {	// page is spent
+			flash_page_len[flash_page_active] = 0;	// release it to the prefetcher
+			flash_page_active ^= 1;					// flip to the (prefetched) other page
+			flash_page_index = 0;
+		}
+	}
+	if ((c == NUL) || (c == (char)0xFF)) {			// NUL or erased flash ends the job
+		FLASH.flag_eof = true;
+		flash_open_flag = false;					// stop the prefetcher
+	}
+
+	// processing is simple if not in LINEMODE
+	if (FLASH.flag_linemode == false) {
+		if (FLASH.flag_echo) putchar(c);			// conditional echo
+		return (c);
+	}
+
+	// now do the LINEMODE stuff
+	if ((c == NUL) || (c == (char)0xFF)) {			// perform newline substitutions
+		c = '\n';
+	} else if (c == '\r') {
+		c = '\n';
+	}
+	if (FLASH.flag_echo) putchar(c);				// conditional echo
+	return (c);
+}
@@ -20,13 +20,14 @@
  */
 #include <stdio.h>						// precursor for xio.h
 #include <stdbool.h>					// true and false
-#include <string.h>						// for memset
+#include <string.h>						// for memset
 #include <avr/pgmspace.h>				// precursor for xio.h
 #include <avr/interrupt.h>
 #include <avr/sleep.h>					// needed for blocking character writes
 
 #include "xio.h"						// includes for all devices are in here
 #include "../xmega/xmega_interrupts.h"
+#include "../xmega/xmega_rtc.h"			// needed to clock the flow-off'd time
 
 #include "../tinyg.h"					// needed for AXES definition
 #include "../gpio.h"					// needed for XON/XOFF LED indicator
@@ -150,6 +151,10 @@ FILE *xio_open_usart(const uint8_t dev, const char *addr, const flags_t flags)
 	dx->port->INTCTRL = USB_CTS_INTLVL;		// see xio_usart.h for setting
 	dx->port->USB_CTS_INTMSK = USB_CTS_bm;
 
+#ifdef __USB_TX_DMA
+	if (dev == XIO_DEV_USB) { xio_usb_init_tx_dma(); }	// TX runs off the DMA controller
+#endif
+
 	return (&d->file);		// return FILE reference
 
 	// here's a bag for the RS485 device
@@ -174,17 +179,20 @@ void xio_set_baud_usart(xioUsart_t *dx, const uint8_t baud)
  * xio_get_tx_bufcount_usart() - returns number of chars in TX buffer
  * xio_get_rx_bufcount_usart() - returns number of chars in RX buffer
  *
- *	Reminder: tx/rx queues fill from top to bottom, w/0 being the wrap location
+ *	Reminder: both queues fill from bottom to top (so queued data is contiguous
+ *	in memory for the zero-copy and bulk-write paths); 0 is never used
  */
 
 void xio_xoff_usart(xioUsart_t *dx)
 {
 	if (dx->fc_state_rx == FC_IN_XON) {
 		dx->fc_state_rx = FC_IN_XOFF;
+		dx->io_fc_events++;						// I/O statistics - see "io" group
+		dx->io_fc_start = rtc.clock_ticks;
 
 		// If using XON/XOFF flow control
 		if (cfg.enable_flow_control == FLOW_CONTROL_XON) {
-			dx->fc_char_rx = XOFF; 
+			dx->fc_char_rx = XOFF;
 			dx->usart->CTRLA = CTRLA_RXON_TXON;		// force a TX interrupt
 		}
 
@@ -200,6 +208,7 @@ void xio_xon_usart(xioUsart_t *dx)
 {
 	if (dx->fc_state_rx == FC_IN_XOFF) {
 		dx->fc_state_rx = FC_IN_XON;
+		dx->io_fc_ticks += rtc.clock_ticks - dx->io_fc_start;
 
 		// If using XON/XOFF flow control
 		if (cfg.enable_flow_control == FLOW_CONTROL_XON) {
@@ -218,27 +227,51 @@ void xio_xon_usart(xioUsart_t *dx)
 void xio_fc_usart(xioDev_t *d)		// callback from the usart handlers
 {
 	xioUsart_t *dx = d->x;
-	if (xio_get_rx_bufcount_usart(dx) < XOFF_RX_LO_WATER_MARK) {
+	buffer_t lo_water, hi_water;
+
+	if (cfg.enable_flow_control == FLOW_CONTROL_RTS) {
+		lo_water = (buffer_t)RTS_RX_LO_WATER_MARK;
+		hi_water = (buffer_t)RTS_RX_HI_WATER_MARK;
+	} else {
+		lo_water = (buffer_t)XOFF_RX_LO_WATER_MARK;
+		hi_water = (buffer_t)XOFF_RX_HI_WATER_MARK;
+	}
+	BUFFER_CRITICAL_ENTER();
+	buffer_t lines = dx->rx_buf_lines;
+	BUFFER_CRITICAL_EXIT();
+	buffer_t bufcount = xio_get_rx_bufcount_usart(dx);
+
+	// flow-on below the byte low water mark, or as soon as the queued line
+	// count drains - provided the byte backstop says there's room
+	if ((bufcount < lo_water) ||
+	   ((lines < RX_LO_WATER_LINES) && (bufcount < hi_water))) {
 		xio_xon_usart(dx);
 	}
 }
 
 buffer_t xio_get_tx_bufcount_usart(const xioUsart_t *dx)
 {
-	if (dx->tx_buf_head <= dx->tx_buf_tail) {
-		return (dx->tx_buf_tail - dx->tx_buf_head);
+	BUFFER_CRITICAL_ENTER();			// callable from either side - snapshot both indexes
+	buffer_t head = dx->tx_buf_head;
+	buffer_t tail = dx->tx_buf_tail;
+	BUFFER_CRITICAL_EXIT();
+	if (head >= tail) {
+		return (head - tail);
 	} else {
-		return (TX_BUFFER_SIZE - (dx->tx_buf_head - dx->tx_buf_tail));
+		return (TX_BUFFER_SIZE - (tail - head));
 	}
 }
 
 buffer_t xio_get_rx_bufcount_usart(const xioUsart_t *dx)
 {
-//	return (dx->rx_buf_count);
-	if (dx->rx_buf_head <= dx->rx_buf_tail) {
-		return (dx->rx_buf_tail - dx->rx_buf_head);
+	BUFFER_CRITICAL_ENTER();			// callable from either side - snapshot both indexes
+	buffer_t head = dx->rx_buf_head;
+	buffer_t tail = dx->rx_buf_tail;
+	BUFFER_CRITICAL_EXIT();
+	if (head >= tail) {					// RX ring fills upwards
+		return (head - tail);
 	} else {
-		return (RX_BUFFER_SIZE - (dx->rx_buf_head - dx->rx_buf_tail));
+		return (RX_BUFFER_SIZE - (tail - head));
 	}
 }
 
@@ -283,15 +316,21 @@ static int _gets_helper(xioDev_t *d, xioUsart_t *dx)
 {
 	char c = NUL;
 
+	BUFFER_CRITICAL_ENTER();					// mainline side of the shared RX indexes
 	if (dx->rx_buf_head == dx->rx_buf_tail) {	// RX ISR buffer empty
-		dx->rx_buf_count = 0;					// reset count for good measure
+		dx->rx_buf_count = 0;					// reset counts for good measure
+		dx->rx_buf_lines = 0;
+		BUFFER_CRITICAL_EXIT();
 		return(XIO_BUFFER_EMPTY);				// stop reading
 	}
 	advance_buffer(dx->rx_buf_tail, RX_BUFFER_SIZE);
 	dx->rx_buf_count--;
-	d->x_flow(d);								// run flow control
-//	c = dx->rx_buf[dx->rx_buf_tail];			// get char from RX Q
 	c = (dx->rx_buf[dx->rx_buf_tail] & 0x007F);	// get char from RX Q & mask MSB
+	if (((c == CR) || (c == LF)) && (dx->rx_buf_lines != 0)) {
+		dx->rx_buf_lines--;						// a complete line has been consumed
+	}
+	BUFFER_CRITICAL_EXIT();
+	d->x_flow(d);								// run flow control
 	if (d->flag_echo) d->x_putc(c, stdout);		// conditional echo regardless of character
 
 	if (d->len >= d->size) {					// handle buffer overruns
@@ -309,6 +348,94 @@ static int _gets_helper(xioDev_t *d, xioUsart_t *dx)
 	return (XIO_EAGAIN);
 }
 
+/*
+ *	xio_gets_line_usart() - zero-copy line reader for USART devices
+ *
+ *	Scans the RX ring in place for a complete line and returns a pointer to
+ *	it instead of copying it out a character at a time. The RX ring fills
+ *	upwards so a completed line is contiguous in memory unless it straddles
+ *	the ring wrap, in which case it is reassembled into the caller's buffer
+ *	(the uncommon case - with a 1K ring roughly one line in forty wraps).
+ *
+ *	The returned line stays parked in the ring - the tail is not advanced
+ *	past it until the next call - so the caller owns it until then and the
+ *	parsers may normalize it in place. Do not mix this reader with
+ *	xio_gets() or getc() on the same device.
+ *
+ *	Returns XIO_OK with *linep set to the NUL terminated line,
+ *	XIO_EAGAIN if no complete line is in the ring yet, or
+ *	XIO_BUFFER_FULL if a line exceeds size chars (delivered truncated,
+ *	matching xio_gets_usart() overrun behavior)
+ */
+int xio_gets_line_usart(xioDev_t *d, char **linep, char *buf, const int size)
+{
+	xioUsart_t *dx = d->x;
+	char c = NUL;
+	uint8_t overflow = false;
+
+	if (dx->rx_line_pending == true) {			// release the previously delivered line
+		buffer_t freed = dx->rx_buf_scan_len;
+		BUFFER_CRITICAL_ENTER();
+		dx->rx_buf_tail = dx->rx_buf_scan;		// frees the line and its terminator
+		if (dx->rx_buf_count >= freed) { dx->rx_buf_count -= freed;} else { dx->rx_buf_count = 0;}
+		BUFFER_CRITICAL_EXIT();
+		dx->rx_line_pending = false;
+		dx->rx_buf_scan_len = 0;
+		d->x_flow(d);							// run flow control on the freed space
+	}
+
+	BUFFER_CRITICAL_ENTER();					// mainline side of the ISR-owned head
+	buffer_t head = dx->rx_buf_head;
+	buffer_t lines = dx->rx_buf_lines;			// completed lines assembled by the RX ISR
+	BUFFER_CRITICAL_EXIT();
+
+	// The RX ISR counts terminators as they arrive, so until it flags a
+	// completed line there is nothing worth scanning - unless an overlong
+	// line filled the caller's buffer, which is delivered truncated below.
+	if ((lines == 0) && (xio_get_rx_bufcount_usart(dx) < (buffer_t)size)) {
+		return (XIO_EAGAIN);
+	}
+	buffer_t scan = (dx->rx_buf_scan_len == 0) ? dx->rx_buf_tail : dx->rx_buf_scan;
+
+	while (true) {
+		if (scan == head) {						// scanned all that's been received
+			dx->rx_buf_scan = scan;
+			return (XIO_EAGAIN);
+		}
+		advance_buffer(scan, RX_BUFFER_SIZE);
+		dx->rx_buf_scan_len++;
+		c = (dx->rx_buf[scan] &= 0x7F);			// mask MSB in place
+		if (d->flag_echo) d->x_putc(c, stdout);	// conditional echo
+		if ((c == CR) || (c == LF)) { break;}	// got a complete line
+		if (dx->rx_buf_scan_len >= (buffer_t)size) {
+			overflow = true;					// line overrun - deliver it truncated
+			break;
+		}
+	}
+	dx->rx_buf_scan = scan;
+	dx->rx_buf[scan] = NUL;						// terminate over the CR/LF (or truncate)
+	dx->rx_line_pending = true;
+	if (overflow == false) {
+		BUFFER_CRITICAL_ENTER();				// the line is no longer queued
+		if (dx->rx_buf_lines != 0) { dx->rx_buf_lines--;}
+		BUFFER_CRITICAL_EXIT();
+	}
+
+	buffer_t start = dx->rx_buf_tail;			// first char of the line
+	advance_buffer(start, RX_BUFFER_SIZE);
+
+	if (start <= scan) {						// contiguous - hand back the ring view
+		*linep = (char *)&dx->rx_buf[start];
+	} else {									// line straddles the wrap - reassemble
+		uint16_t len1 = RX_BUFFER_SIZE - start;	// chars from start to the top of the ring
+		memcpy(buf, (char *)&dx->rx_buf[start], len1);
+		strcpy(buf + len1, (char *)&dx->rx_buf[1]);	// remainder including the NUL
+		*linep = buf;
+	}
+	d->signal = XIO_SIG_EOL;
+	return (overflow ? XIO_BUFFER_FULL : XIO_OK);
+}
+
 /*
  *  xio_getc_usart() - generic char reader for USART devices
  *
@@ -342,8 +469,15 @@ int xio_getc_usart(FILE *stream)
 	xioUsart_t *dx = d->x;
 	char c;
 
-	while (dx->rx_buf_head == dx->rx_buf_tail) {	// RX ISR buffer empty
-		dx->rx_buf_count = 0;						// reset count for good measure
+	while (true) {									// wait for a character
+		BUFFER_CRITICAL_ENTER();					// mainline side of the shared RX indexes
+		if (dx->rx_buf_head != dx->rx_buf_tail) {
+			BUFFER_CRITICAL_EXIT();
+			break;
+		}
+		dx->rx_buf_count = 0;						// reset counts for good measure
+		dx->rx_buf_lines = 0;
+		BUFFER_CRITICAL_EXIT();
 		if (d->flag_block) {
 			sleep_mode();
 		} else {
@@ -351,10 +485,15 @@ int xio_getc_usart(FILE *stream)
 			return(_FDEV_ERR);
 		}
 	}
+	BUFFER_CRITICAL_ENTER();
 	advance_buffer(dx->rx_buf_tail, RX_BUFFER_SIZE);
 	dx->rx_buf_count--;
-	d->x_flow(d);									// flow control callback
 	c = (dx->rx_buf[dx->rx_buf_tail] & 0x007F);		// get char from RX buf & mask MSB
+	if (((c == CR) || (c == LF)) && (dx->rx_buf_lines != 0)) {
+		dx->rx_buf_lines--;							// a complete line has been consumed
+	}
+	BUFFER_CRITICAL_EXIT();
+	d->x_flow(d);									// flow control callback
 
 	// Triage the input character for handling. This code does not handle deletes
 	if (d->flag_echo) d->x_putc(c, stdout);			// conditional echo regardless of character
@@ -406,12 +545,13 @@ void xio_queue_RX_char_usart(const uint8_t dev, const char c)
 	if (dx->rx_buf_head != dx->rx_buf_tail) {	// write char unless buffer full
 		dx->rx_buf[dx->rx_buf_head] = c;		// FAKE INPUT DATA
 		dx->rx_buf_count++;
+		if ((c == CR) || (c == LF)) { dx->rx_buf_lines++;}
 		return;
 	}
-	// buffer-full handling
-	if ((++dx->rx_buf_head) > RX_BUFFER_SIZE-1) { // reset the head
-		dx->rx_buf_count = RX_BUFFER_SIZE-1;
-		dx->rx_buf_head = 1;
+	// buffer-full handling - toss the char
+	if ((--dx->rx_buf_head) == 0) {				// reset the head (undo the advance)
+		dx->rx_buf_head = RX_BUFFER_SIZE-1;
 	}
+	dx->rx_buf_count = RX_BUFFER_SIZE-1;
 }
 
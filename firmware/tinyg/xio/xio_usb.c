@@ -1,225 +1,600 @@
-/*
- * xio_usb.c - FTDI USB device driver for xmega family
- * 			 - works with avr-gcc stdio library
- *
- * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
- * This file ("the software") is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License, version 2 as published by the
- * Free Software Foundation. You should have received a copy of the GNU General Public
- * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
- *
- * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
- * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
- * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
- * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-#include <stdio.h>						// precursor for xio.h
-#include <stdbool.h>					// true and false
-#include <avr/pgmspace.h>				// precursor for xio.h
-#include <avr/interrupt.h>
-#include <avr/sleep.h>					// needed for blocking TX
-
-#include "xio.h"						// includes for all devices are in here
-#include "../xmega/xmega_interrupts.h"
-
-// application specific stuff that's littered into the USB handler
-#include "../tinyg.h"
-#include "../config.h"
-#include "../network.h"
-#include "../controller.h"
-#include "../canonical_machine.h"		// trapped characters communicate directly with the canonical machine
-
-// Fast accessors
-#define USB ds[XIO_DEV_USB]
-#define USBu us[XIO_DEV_USB - XIO_DEV_USART_OFFSET]
-
-/*
- * xio_putc_usb() 
- * USB_TX_ISR - USB transmitter interrupt (TX) used by xio_usb_putc()
- *
- * 	These are co-routines that work in tandem.
- * 	xio_putc_usb() is a more efficient form derived from xio_putc_usart()
- * 
- *	The TX interrupt dilemma: TX interrupts occur when the USART DATA register is 
- *	empty (and the ISR must disable interrupts when nothing's left to read, or they 
- *	keep firing). If the TX buffer is completely empty (TXCIF is set) then enabling
- *	interrupts does no good. The USART won't interrupt and the TX circular buffer 
- *	never empties. So the routine that puts chars in the TX buffer must always force
- *	an interrupt.
- */
-
-int xio_putc_usb(const char c, FILE *stream)
-{
-	buffer_t next_tx_buf_head = USBu.tx_buf_head-1;		// set next head while leaving current one alone
-	if (next_tx_buf_head == 0)
-		next_tx_buf_head = TX_BUFFER_SIZE-1; 			// detect wrap and adjust; -1 avoids off-by-one
-	while (next_tx_buf_head == USBu.tx_buf_tail) 
-		sleep_mode(); 									// sleep until there is space in the buffer
-	USBu.usart->CTRLA = CTRLA_RXON_TXOFF;				// disable TX interrupt (mutex region)
-	USBu.tx_buf_head = next_tx_buf_head;				// accept next buffer head
-	USBu.tx_buf[USBu.tx_buf_head] = c;					// write char to buffer
-
-	// expand <LF> to <LF><CR> if $ec is set
-	if ((c == '\n') && (USB.flag_crlf)) {
-		USBu.usart->CTRLA = CTRLA_RXON_TXON;			// force interrupt to send the queued <CR>
-		buffer_t next_tx_buf_head = USBu.tx_buf_head-1;
-		if (next_tx_buf_head == 0) next_tx_buf_head = TX_BUFFER_SIZE-1;
-		while (next_tx_buf_head == USBu.tx_buf_tail) sleep_mode();
-		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;			// MUTEX region
-		USBu.tx_buf_head = next_tx_buf_head;
-		USBu.tx_buf[USBu.tx_buf_head] = CR;
-	}
-	// finish up
-	USBu.usart->CTRLA = CTRLA_RXON_TXON;			// force interrupt to send char(s) - doesn't work if you just |= it
-	return (XIO_OK);
-}
-
-ISR(USB_TX_ISR_vect) //ISR(USARTC0_DRE_vect)		// USARTC0 data register empty
-{
-	// If the CTS pin (FTDI's RTS) is HIGH, then we cannot send anything, so exit
-//	if ((USBu.port->IN & USB_CTS_bm)) {
-	if ((cfg.enable_flow_control == FLOW_CONTROL_RTS) && (USBu.port->IN & USB_CTS_bm)) {
-		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;		// force another TX interrupt
-		return;
-	}
-
-	// Send an RX-side XON or XOFF character if queued
-	if (USBu.fc_char_rx != NUL) {					// an XON/ of XOFF needs to be sent
-		USBu.usart->DATA = USBu.fc_char_rx;			// send the XON/XOFF char and exit
-		USBu.fc_char_rx = NUL;
-		return;
-	}
-
-	// Halt transmission while in TX-side XOFF
-	if (USBu.fc_state_tx == FC_IN_XOFF) {
-		return;
-	}
-
-	// Otherwise process normal TX transmission
-	if (USBu.tx_buf_head != USBu.tx_buf_tail) {		// buffer has data
-		advance_buffer(USBu.tx_buf_tail, TX_BUFFER_SIZE);
-		USBu.usart->DATA = USBu.tx_buf[USBu.tx_buf_tail];
-	} else {
-		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;		// force another interrupt
-	}
-} 
-
-/*
- * Pin Change (edge-detect) interrupt for CTS pin.
- */
-
-ISR(USB_CTS_ISR_vect)	
-{
-	USBu.usart->CTRLA = CTRLA_RXON_TXON;		// force another interrupt
-}
-
-/* 
- * USB_RX_ISR - USB receiver interrupt (RX)
- *
- * RX buffer states can be one of:
- *	- buffer has space	(CTS should be asserted)
- *	- buffer is full 	(CTS should be not_asserted)
- *	- buffer becomes full with this character (write char and assert CTS)
- *
- * Signals:
- *	- Signals are captured at the ISR level and either dispatched or flag-set
- *	- As RX ISR is a critical code region signal handling is stupid and fast
- *	- signal characters are not put in the RX buffer
- *
- * Flow Control:
- *	- Flow control is not implemented. Need to work RTS line.
- *	- Flow control should cut off at high water mark, re-enable at low water mark
- *	- High water mark should have about 4 - 8 bytes left in buffer (~95% full) 
- *	- Low water mark about 50% full
- *
- *  See https://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Module-Details#Notes_on_Circular_Buffers
- *  for a discussion of how the circular buffers work
- */
-
-ISR(USB_RX_ISR_vect)	//ISR(USARTC0_RXC_vect)	// serial port C0 RX int 
-{
-	char c = USBu.usart->DATA;					// can only read DATA once
-
-	if (tg.network_mode == NETWORK_MASTER) {	// forward character if you are a master
-		net_forward(c);
-	}
-	// trap async commands - do not insert character into RX queue
-	if (c == CHAR_RESET) {	 					// trap Kill signal
-		tg_request_reset();
-		return;
-	}
-	if (c == CHAR_FEEDHOLD) {					// trap feedhold signal
-		cm_request_feedhold();
-		return;
-	}
-	if (c == CHAR_QUEUE_FLUSH) {				// trap queue flush signal
-		cm_request_queue_flush();
-		return;
-	}
-	if (c == CHAR_CYCLE_START) {				// trap cycle start signal
-		cm_request_cycle_start();
-		return;
-	}
-	if (USB.flag_xoff) {
-		if (c == XOFF) {						// trap incoming XON/XOFF signals
-			USBu.fc_state_tx = FC_IN_XOFF;
-			return;
-		}
-		if (c == XON) {
-			USBu.fc_state_tx = FC_IN_XON;
-			USBu.usart->CTRLA = CTRLA_RXON_TXOFF;// force a TX interrupt
-			return;
-		}
-	}
-
-	// filter out CRs and LFs if they are to be ignored
-	if ((c == CR) && (USB.flag_ignorecr)) return;
-	if ((c == LF) && (USB.flag_ignorelf)) return;
-
-	// normal character path
-	advance_buffer(USBu.rx_buf_head, RX_BUFFER_SIZE);
-	if (USBu.rx_buf_head != USBu.rx_buf_tail) {	// buffer is not full
-		USBu.rx_buf[USBu.rx_buf_head] = c;		// write char unless full
-		USBu.rx_buf_count++;
-		if ((USB.flag_xoff) && (xio_get_rx_bufcount_usart(&USBu) > XOFF_RX_HI_WATER_MARK)) {
-			xio_xoff_usart(&USBu);
-		}
-	} else { 											// buffer-full - toss the incoming character
-		if ((++USBu.rx_buf_head) > RX_BUFFER_SIZE-1) {	// reset the head
-			USBu.rx_buf_count = RX_BUFFER_SIZE-1;		// reset count for good measure
-			USBu.rx_buf_head = 1;
-		}
-	}
-}
-
-/*
- * xio_get_usb_rx_free() - returns free space in the USB RX buffer
- *
- *	Remember: The queues fill from top to bottom, w/0 being the wrap location
- */
-buffer_t xio_get_usb_rx_free(void)
-{
-	return (RX_BUFFER_SIZE - xio_get_rx_bufcount_usart(&USBu));
-}
-
-/*
- * xio_reset_usb_rx_buffers() - clears the USB RX buffer
- */
-void xio_reset_usb_rx_buffers(void)
-{
-	// reset xio_gets() buffer
-	USB.len = 0;
-	USB.flag_in_line = false;
-
-	// reset interrupt circular buffer
-	USBu.rx_buf_head = 1;		// can't use location 0 in circular buffer
-	USBu.rx_buf_tail = 1;
-	USBu.tx_buf_head = 1;
-	USBu.tx_buf_tail = 1;
-}
+/*
+ * xio_usb.c - FTDI USB device driver for xmega family
+ * 			 - works with avr-gcc stdio library
+ *
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>						// precursor for xio.h
+#include <stdbool.h>					// true and false
+#include <string.h>						// for memcpy in the bulk write path
+#include <avr/pgmspace.h>				// precursor for xio.h
+#include <avr/interrupt.h>
+#include <avr/sleep.h>					// needed for blocking TX
+
+#include "xio.h"						// includes for all devices are in here
+#include "../xmega/xmega_interrupts.h"
+
+// application specific stuff that's littered into the USB handler
+#include "../tinyg.h"
+#include "../config.h"
+#include "../network.h"
+#include "../controller.h"
+#include "../canonical_machine.h"		// trapped characters communicate directly with the canonical machine
+#include "../report.h"					// trapped status query requests an immediate report
+
+// Fast accessors
+#define USB ds[XIO_DEV_USB]
+#define USBu us[XIO_DEV_USB - XIO_DEV_USART_OFFSET]
+
+static buffer_t _get_tx_buf_tail(void)		// atomic read of the ISR-owned TX tail
+{
+	BUFFER_CRITICAL_ENTER();
+	buffer_t tail = USBu.tx_buf_tail;
+	BUFFER_CRITICAL_EXIT();
+	return (tail);
+}
+
+/**** Priority transmitter ****
+ *
+ *	Status reports, queue reports and exception messages share the TX ring with
+ *	command echoes and responses, so a large queued dump used to delay the report
+ *	the operator's DRO depends on. Reports now go through a small second ring
+ *	(xio_write_usb_pri()) that the transmitter drains preferentially - but only
+ *	at message boundaries, so a report jumps ahead of queued lines without
+ *	splicing itself into the middle of one. A boundary is a transmitted LF, or
+ *	an empty normal ring (writers are single threaded, so an empty ring means
+ *	the last queued message went out whole). Once the transmitter commits to the
+ *	priority ring it drains it to empty before returning to normal traffic.
+ */
+static volatile char tx_pri_buf[TX_PRI_BUFFER_SIZE];
+static volatile buffer_t tx_pri_buf_head = 1;	// ring conventions match the main TX ring
+static volatile buffer_t tx_pri_buf_tail = 1;
+static volatile uint8_t tx_pri_active = false;	// transmitter is committed to the priority ring
+static volatile char tx_last_char = LF;			// last char sent from the normal ring
+
+static uint8_t _tx_pri_eligible(void)			// call only with interrupts disabled
+{
+	if (tx_pri_buf_head == tx_pri_buf_tail) { return (false);}	// nothing queued
+	if (tx_pri_active == true) { return (true);}				// drain to empty once committed
+	if (tx_last_char == LF) { return (true);}					// sent stream is at a line boundary
+	if (USBu.tx_buf_head == USBu.tx_buf_tail) { return (true);}	// normal ring empty - also a boundary
+	return (false);
+}
+
+static buffer_t _get_tx_pri_buf_tail(void)		// atomic read of the ISR-owned priority tail
+{
+	BUFFER_CRITICAL_ENTER();
+	buffer_t tail = tx_pri_buf_tail;
+	BUFFER_CRITICAL_EXIT();
+	return (tail);
+}
+
+/*
+ * xio_tx_pri_empty_usb() - true if the priority TX ring has fully drained
+ *
+ *	Report generators use this to drop a discardable report instead of
+ *	sleeping in xio_write_usb_pri() when the host is not keeping up
+ *	(see rpt_status_report_callback() in report.c).
+ */
+uint8_t xio_tx_pri_empty_usb(void)
+{
+	return (tx_pri_buf_head == _get_tx_pri_buf_tail());
+}
+
+/**** DMA transmitter ****
+ *
+ *	The __USB_TX_DMA build replaces the one-interrupt-per-character DRE
+ *	transmitter with a DMA channel triggered by the USART data register empty
+ *	flag. The channel walks the existing TX circular buffer (which fills and
+ *	drains upwards - hence SRCDIR_INC) and interrupts once per chunk instead
+ *	of once per character, cutting the TX interrupt load from ~11K/sec to a
+ *	few hundred at a sustained 115.2K baud.
+ *
+ *	The receiver is deliberately left on the per-character RX interrupt. The
+ *	RX ISR traps the !, ~, % and kill characters and the XON/XOFF bytes inline,
+ *	and that immediate response is a hard requirement - a DMA'ed receiver would
+ *	sit on a feedhold until some buffer watermark tripped.
+ *
+ *	Flow control runs at chunk granularity: XOFF (ours or the host's) and a
+ *	de-asserted CTS line stop transmission at the next chunk boundary, not the
+ *	next character. USB_TX_DMA_CHUNK_MAX bounds that skid to ~2.8 ms at 115.2K,
+ *	well inside what the FTDI and host-side buffering absorb. RX-side XON/XOFF
+ *	characters are injected between chunks by the (otherwise idle) DRE ISR.
+ *
+ *	The channel assignment collides with the step pulse engine, which claims
+ *	all four channels, so the two experiments cannot be combined.
+ */
+#ifdef __USB_TX_DMA
+#ifdef __STEP_DMA
+#error __USB_TX_DMA cannot be combined with __STEP_DMA (no free DMA channel)
+#endif
+
+#define USB_TX_DMA_CH			DMA.CH3
+#define USB_TX_DMA_ISR_vect		DMA_CH3_vect
+#define USB_TX_DMA_CHUNK_MAX	32			// bounds the flow control response skid
+
+static buffer_t tx_dma_chunk;				// length of the chunk in flight
+static uint8_t tx_dma_pri;					// chunk in flight is from the priority ring
+
+/*
+ * xio_usb_init_tx_dma() - set up the TX DMA channel
+ *	Called from xio_open_usart(). One byte moves per DRE trigger (single shot);
+ *	the transaction-complete interrupt runs at the old DRE interrupt level.
+ */
+void xio_usb_init_tx_dma(void)
+{
+	DMA.CTRL = DMA_ENABLE_bm | DMA_DBUFMODE_DISABLED_gc;
+	USB_TX_DMA_CH.CTRLA = DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;
+	USB_TX_DMA_CH.CTRLB = DMA_CH_TRNINTLVL_LO_gc;
+	USB_TX_DMA_CH.ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_INC_gc |
+							 DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
+	USB_TX_DMA_CH.TRIGSRC = DMA_CH_TRIGSRC_USARTC0_DRE_gc;
+	USB_TX_DMA_CH.DESTADDR0 = ((uint16_t)&USB_USART.DATA) & 0xFF;
+	USB_TX_DMA_CH.DESTADDR1 = ((uint16_t)&USB_USART.DATA >> 8) & 0xFF;
+	USB_TX_DMA_CH.DESTADDR2 = 0;
+}
+
+/*
+ * _usb_tx_dma_kick() - arm the next TX chunk if one should be sent
+ *
+ *	Computes the contiguous run from the tail up towards the head (the ring
+ *	wrap is just another chunk boundary) and starts the channel on it. Callers
+ *	must be atomic w.r.t. the ISRs that also kick (the completion, RX and CTS
+ *	ISRs call this at interrupt level; xio_putc_usb() wraps it in cli/sei).
+ */
+static void _usb_tx_dma_kick(void)
+{
+	if (USB_TX_DMA_CH.CTRLA & DMA_CH_ENABLE_bm) { return;}	// chunk already in flight
+	if (USBu.fc_char_rx != NUL) { return;}					// let the DRE ISR inject XON/XOFF first
+	if (USBu.fc_state_tx == FC_IN_XOFF) { return;}			// host told us to shut up
+	if ((cfg.enable_flow_control == FLOW_CONTROL_RTS) && (USBu.port->IN & USB_CTS_bm)) {
+		return;												// CTS edge interrupt will re-kick
+	}
+	volatile char *ring;					// select the ring to send from
+	buffer_t ring_size, head, tail;
+	if (_tx_pri_eligible() == true) {
+		tx_pri_active = true;
+		tx_dma_pri = true;
+		ring = tx_pri_buf; ring_size = TX_PRI_BUFFER_SIZE;
+		head = tx_pri_buf_head; tail = tx_pri_buf_tail;
+	} else if (USBu.tx_buf_head != USBu.tx_buf_tail) {
+		tx_dma_pri = false;
+		ring = USBu.tx_buf; ring_size = TX_BUFFER_SIZE;
+		head = USBu.tx_buf_head; tail = USBu.tx_buf_tail;
+	} else {
+		return;								// nothing to send
+	}
+	if (tail == ring_size-1) { tail = 0;}	// wrap: next char out is at the bottom of the ring
+	buffer_t chunk;
+	if (head > tail) {
+		chunk = head - tail;				// contiguous run up to the head
+	} else {
+		chunk = (ring_size-1) - tail;		// run up to the top slot (slot 0 is unused)
+	}
+	if (chunk > USB_TX_DMA_CHUNK_MAX) { chunk = USB_TX_DMA_CHUNK_MAX;}
+	tx_dma_chunk = chunk;
+
+	uint16_t src = (uint16_t)&ring[tail+1];
+	USB_TX_DMA_CH.SRCADDR0 = src & 0xFF;
+	USB_TX_DMA_CH.SRCADDR1 = (src >> 8) & 0xFF;
+	USB_TX_DMA_CH.SRCADDR2 = 0;
+	USB_TX_DMA_CH.TRFCNT = chunk;
+	USB_TX_DMA_CH.CTRLA |= DMA_CH_ENABLE_bm;
+}
+
+ISR(USB_TX_DMA_ISR_vect)					// chunk complete - retire it and re-arm
+{
+	USB_TX_DMA_CH.CTRLB |= DMA_CH_TRNIF_bm;	// clear the transaction complete flag
+	USBu.io_tx_bytes += tx_dma_chunk;		// I/O statistics - see "io" group
+	if (tx_dma_pri == true) {
+		buffer_t tail = tx_pri_buf_tail;
+		if (tail == TX_PRI_BUFFER_SIZE-1) { tail = 0;}
+		tx_pri_buf_tail = tail + tx_dma_chunk;	// chunk never runs past the top slot, so this can't overflow
+		if (tx_pri_buf_head == tx_pri_buf_tail) { tx_pri_active = false;}
+	} else {
+		buffer_t tail = USBu.tx_buf_tail;
+		if (tail == TX_BUFFER_SIZE-1) { tail = 0;}
+		USBu.tx_buf_tail = tail + tx_dma_chunk;
+		tx_last_char = USBu.tx_buf[USBu.tx_buf_tail];	// tail indexes the last char sent
+	}
+	_usb_tx_dma_kick();
+}
+#endif // __USB_TX_DMA
+
+/*
+ * xio_putc_usb() 
+ * USB_TX_ISR - USB transmitter interrupt (TX) used by xio_usb_putc()
+ *
+ * 	These are co-routines that work in tandem.
+ * 	xio_putc_usb() is a more efficient form derived from xio_putc_usart()
+ * 
+ *	The TX interrupt dilemma: TX interrupts occur when the USART DATA register is 
+ *	empty (and the ISR must disable interrupts when nothing's left to read, or they 
+ *	keep firing). If the TX buffer is completely empty (TXCIF is set) then enabling
+ *	interrupts does no good. The USART won't interrupt and the TX circular buffer 
+ *	never empties. So the routine that puts chars in the TX buffer must always force
+ *	an interrupt.
+ */
+#ifndef __USB_TX_DMA
+
+int xio_putc_usb(const char c, FILE *stream)
+{
+	buffer_t next_tx_buf_head = USBu.tx_buf_head+1;		// set next head while leaving current one alone
+	if (next_tx_buf_head > TX_BUFFER_SIZE-1)
+		next_tx_buf_head = 1; 							// detect wrap and adjust; slot 0 is never used
+	while (next_tx_buf_head == _get_tx_buf_tail())
+		sleep_mode(); 									// sleep until there is space in the buffer
+	USBu.usart->CTRLA = CTRLA_RXON_TXOFF;				// disable TX interrupt (mutex region)
+	USBu.tx_buf_head = next_tx_buf_head;				// accept next buffer head
+	USBu.tx_buf[USBu.tx_buf_head] = c;					// write char to buffer
+
+	// expand <LF> to <LF><CR> if $ec is set
+	if ((c == '\n') && (USB.flag_crlf)) {
+		USBu.usart->CTRLA = CTRLA_RXON_TXON;			// force interrupt to send the queued <CR>
+		buffer_t next_tx_buf_head = USBu.tx_buf_head+1;
+		if (next_tx_buf_head > TX_BUFFER_SIZE-1) next_tx_buf_head = 1;
+		while (next_tx_buf_head == _get_tx_buf_tail()) sleep_mode();
+		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;			// MUTEX region
+		USBu.tx_buf_head = next_tx_buf_head;
+		USBu.tx_buf[USBu.tx_buf_head] = CR;
+	}
+	// finish up
+	USBu.usart->CTRLA = CTRLA_RXON_TXON;			// force interrupt to send char(s) - doesn't work if you just |= it
+	return (XIO_OK);
+}
+
+ISR(USB_TX_ISR_vect) //ISR(USARTC0_DRE_vect)		// USARTC0 data register empty
+{
+	// If the CTS pin (FTDI's RTS) is HIGH, then we cannot send anything, so exit
+//	if ((USBu.port->IN & USB_CTS_bm)) {
+	if ((cfg.enable_flow_control == FLOW_CONTROL_RTS) && (USBu.port->IN & USB_CTS_bm)) {
+		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;		// force another TX interrupt
+		return;
+	}
+
+	// Send an RX-side XON or XOFF character if queued
+	if (USBu.fc_char_rx != NUL) {					// an XON/ of XOFF needs to be sent
+		USBu.usart->DATA = USBu.fc_char_rx;			// send the XON/XOFF char and exit
+		USBu.fc_char_rx = NUL;
+		return;
+	}
+
+	// Halt transmission while in TX-side XOFF
+	if (USBu.fc_state_tx == FC_IN_XOFF) {
+		return;
+	}
+
+	// Drain the priority ring first - see the priority transmitter notes above
+	if (_tx_pri_eligible() == true) {
+		tx_pri_active = true;
+		advance_buffer(tx_pri_buf_tail, TX_PRI_BUFFER_SIZE);
+		USBu.usart->DATA = tx_pri_buf[tx_pri_buf_tail];
+		USBu.io_tx_bytes++;							// I/O statistics - see "io" group
+		if (tx_pri_buf_head == tx_pri_buf_tail) { tx_pri_active = false;}
+		return;
+	}
+
+	// Otherwise process normal TX transmission
+	if (USBu.tx_buf_head != USBu.tx_buf_tail) {		// buffer has data
+		advance_buffer(USBu.tx_buf_tail, TX_BUFFER_SIZE);
+		USBu.usart->DATA = USBu.tx_buf[USBu.tx_buf_tail];
+		tx_last_char = USBu.tx_buf[USBu.tx_buf_tail];
+		USBu.io_tx_bytes++;							// I/O statistics - see "io" group
+	} else {
+		USBu.usart->CTRLA = CTRLA_RXON_TXOFF;		// force another interrupt
+	}
+}
+
+#else // __USB_TX_DMA versions of the above
+
+int xio_putc_usb(const char c, FILE *stream)
+{
+	buffer_t next_tx_buf_head = USBu.tx_buf_head+1;		// set next head while leaving current one alone
+	if (next_tx_buf_head > TX_BUFFER_SIZE-1)
+		next_tx_buf_head = 1; 							// detect wrap and adjust; slot 0 is never used
+	while (next_tx_buf_head == _get_tx_buf_tail())
+		sleep_mode(); 									// sleep until there is space in the buffer
+	USBu.tx_buf[next_tx_buf_head] = c;					// write char before publishing the new head
+	BUFFER_CRITICAL_ENTER();							// 16 bit head publish must be atomic
+	USBu.tx_buf_head = next_tx_buf_head;
+	BUFFER_CRITICAL_EXIT();
+
+	// expand <LF> to <LF><CR> if $ec is set
+	if ((c == '\n') && (USB.flag_crlf)) {
+		next_tx_buf_head = USBu.tx_buf_head+1;
+		if (next_tx_buf_head > TX_BUFFER_SIZE-1) next_tx_buf_head = 1;
+		while (next_tx_buf_head == _get_tx_buf_tail()) sleep_mode();
+		USBu.tx_buf[next_tx_buf_head] = CR;
+		BUFFER_CRITICAL_ENTER();
+		USBu.tx_buf_head = next_tx_buf_head;
+		BUFFER_CRITICAL_EXIT();
+	}
+	cli();											// arm atomically w.r.t. the ISRs that also kick
+	_usb_tx_dma_kick();
+	sei();
+	return (XIO_OK);
+}
+
+/*
+ *	In the DMA build the DRE interrupt is normally masked. It's enabled only to
+ *	inject an RX-side XON/XOFF (see xio_xon/xoff_usart()), and backs off until
+ *	the chunk in flight completes so it never races the channel for DATA.
+ */
+ISR(USB_TX_ISR_vect)
+{
+	if (USB_TX_DMA_CH.CTRLA & DMA_CH_ENABLE_bm) { return;}	// retry at the next char boundary
+	if (USBu.fc_char_rx != NUL) {
+		USBu.usart->DATA = USBu.fc_char_rx;
+		USBu.fc_char_rx = NUL;
+	}
+	USBu.usart->CTRLA = CTRLA_RXON_TXOFF;		// re-mask - the DMA channel does normal TX
+	_usb_tx_dma_kick();
+}
+#endif // __USB_TX_DMA
+
+/*
+ * xio_write_usb() - block write into the USB TX buffer
+ *
+ *	Copies the string into the TX ring in at most two memcpy's (one if it
+ *	doesn't straddle the ring wrap), publishes the new head once, and kicks
+ *	the transmitter once - instead of a putc() / head-publish / interrupt-kick
+ *	cycle per character. Blocks (sleeps) if the string exceeds the free space;
+ *	the TX ISR (or DMA completion) wakes us as the buffer drains.
+ *
+ *	Note: this path does not perform <LF> to <CR><LF> expansion ($ec). It's
+ *	used for JSON output, which doesn't want it; callers that need expansion
+ *	should use the stdio/putc path.
+ */
+int xio_write_usb(const char *buf, const int size)
+{
+	const char *p = buf;
+	int remaining = size;
+
+	while (remaining > 0) {
+		buffer_t space = (TX_BUFFER_SIZE-2) - xio_get_tx_bufcount_usart(&USBu);
+		if (space == 0) { sleep_mode(); continue;}	// TX ISR / DMA completion wakes us
+		buffer_t chunk = (space < (buffer_t)remaining) ? space : (buffer_t)remaining;
+		remaining -= chunk;
+
+		buffer_t head = USBu.tx_buf_head;			// local head - published once, below
+		while (chunk > 0) {
+			buffer_t start = head + 1;				// first slot to fill
+			if (start > TX_BUFFER_SIZE-1) { start = 1;}	// wrap; slot 0 is never used
+			buffer_t run = TX_BUFFER_SIZE - start;	// contiguous run to the ring top
+			if (run > chunk) { run = chunk;}
+			memcpy((char *)&USBu.tx_buf[start], p, run);
+			p += run;
+			chunk -= run;
+			head = start + run - 1;
+		}
+		BUFFER_CRITICAL_ENTER();					// 16 bit head publish must be atomic
+		USBu.tx_buf_head = head;
+		BUFFER_CRITICAL_EXIT();
+#ifdef __USB_TX_DMA
+		cli();										// arm atomically w.r.t. the ISRs that also kick
+		_usb_tx_dma_kick();
+		sei();
+#else
+		USBu.usart->CTRLA = CTRLA_RXON_TXON;		// force interrupt to start transmission
+#endif
+	}
+	return (XIO_OK);
+}
+
+/*
+ * xio_write_usb_pri() - block write into the priority TX ring
+ *
+ *	Same two-segment copy as xio_write_usb(), but into the priority ring the
+ *	transmitter drains preferentially (see the priority transmitter notes).
+ *	Intended for bounded-size reports; blocks (sleeps) if a report exceeds the
+ *	free space, which the transmitter drains at full wire speed.
+ */
+int xio_write_usb_pri(const char *buf, const int size)
+{
+	const char *p = buf;
+	int remaining = size;
+
+	while (remaining > 0) {
+		buffer_t head = tx_pri_buf_head;			// head is mainline-owned
+		buffer_t tail = _get_tx_pri_buf_tail();
+		buffer_t count = (head >= tail) ? (head - tail) : (TX_PRI_BUFFER_SIZE - (tail - head));
+		buffer_t space = (TX_PRI_BUFFER_SIZE-2) - count;
+		if (space == 0) { sleep_mode(); continue;}	// TX ISR / DMA completion wakes us
+		buffer_t chunk = (space < (buffer_t)remaining) ? space : (buffer_t)remaining;
+		remaining -= chunk;
+
+		while (chunk > 0) {
+			buffer_t start = head + 1;				// first slot to fill
+			if (start > TX_PRI_BUFFER_SIZE-1) { start = 1;}	// wrap; slot 0 is never used
+			buffer_t run = TX_PRI_BUFFER_SIZE - start;	// contiguous run to the ring top
+			if (run > chunk) { run = chunk;}
+			memcpy((char *)&tx_pri_buf[start], p, run);
+			p += run;
+			chunk -= run;
+			head = start + run - 1;
+		}
+		BUFFER_CRITICAL_ENTER();					// 16 bit head publish must be atomic
+		tx_pri_buf_head = head;
+		BUFFER_CRITICAL_EXIT();
+#ifdef __USB_TX_DMA
+		cli();										// arm atomically w.r.t. the ISRs that also kick
+		_usb_tx_dma_kick();
+		sei();
+#else
+		USBu.usart->CTRLA = CTRLA_RXON_TXON;		// force interrupt to start transmission
+#endif
+	}
+	return (XIO_OK);
+}
+
+/*
+ * Pin Change (edge-detect) interrupt for CTS pin.
+ */
+
+ISR(USB_CTS_ISR_vect)
+{
+#ifdef __USB_TX_DMA
+	_usb_tx_dma_kick();							// resume transmission if CTS re-asserted
+#else
+	USBu.usart->CTRLA = CTRLA_RXON_TXON;		// force another interrupt
+#endif
+}
+
+/* 
+ * USB_RX_ISR - USB receiver interrupt (RX)
+ *
+ * RX buffer states can be one of:
+ *	- buffer has space	(CTS should be asserted)
+ *	- buffer is full 	(CTS should be not_asserted)
+ *	- buffer becomes full with this character (write char and assert CTS)
+ *
+ * Signals:
+ *	- Signals are captured at the ISR level and either dispatched or flag-set
+ *	- As RX ISR is a critical code region signal handling is stupid and fast
+ *	- signal characters are not put in the RX buffer
+ *
+ * Flow Control:
+ *	- Cuts off at the high water mark, re-enables at the low water mark
+ *	- $ex=1 uses in-band XON/XOFF; $ex=2 drives the RTS line directly from the
+ *	  RX ring watermarks (see xio_xoff/xon_usart()) and reacts within a
+ *	  character time. RTS mode does not trap 0x11/0x13 so the stream stays
+ *	  binary transparent. Watermarks for both modes are in xio_usart.h
+ *
+ *  See https://www.synthetos.com/wiki/index.php?title=Projects:TinyG-Module-Details#Notes_on_Circular_Buffers
+ *  for a discussion of how the circular buffers work
+ */
+
+ISR(USB_RX_ISR_vect)	//ISR(USARTC0_RXC_vect)	// serial port C0 RX int 
+{
+	char c = USBu.usart->DATA;					// can only read DATA once
+
+	if (tg.network_mode == NETWORK_MASTER) {	// forward character if you are a master
+		net_forward(c);
+	}
+	// trap async commands - do not insert character into RX queue
+	if (c == CHAR_RESET) {	 					// trap Kill signal
+		tg_request_reset();
+		return;
+	}
+	if (c == CHAR_FEEDHOLD) {					// trap feedhold signal
+		cm_request_feedhold();
+		return;
+	}
+	if (c == CHAR_QUEUE_FLUSH) {				// trap queue flush signal
+		cm_request_queue_flush();
+		return;
+	}
+	if (c == CHAR_CYCLE_START) {				// trap cycle start signal
+		cm_request_cycle_start();
+		return;
+	}
+	if (c == CHAR_JOB_ABORT) {					// trap job abort signal
+		cm_request_job_abort();
+		return;
+	}
+	if (c == CHAR_STATUS_REPORT) {				// trap status query signal
+		rpt_request_status_report(SR_IMMEDIATE_REQUEST);
+		return;
+	}
+	// trap in-band XON/XOFF only when that's the flow control in use. RTS/CTS
+	// mode must pass 0x11/0x13 through untouched (binary transparency) - a
+	// stray XOFF from a host that never sends XON would halt TX permanently.
+	if ((USB.flag_xoff) && (cfg.enable_flow_control == FLOW_CONTROL_XON)) {
+		if (c == XOFF) {						// trap incoming XON/XOFF signals
+			USBu.fc_state_tx = FC_IN_XOFF;
+			return;
+		}
+		if (c == XON) {
+			USBu.fc_state_tx = FC_IN_XON;
+#ifdef __USB_TX_DMA
+			_usb_tx_dma_kick();					// restart transmission
+#else
+			USBu.usart->CTRLA = CTRLA_RXON_TXOFF;// force a TX interrupt
+#endif
+			return;
+		}
+	}
+
+	// filter out CRs and LFs if they are to be ignored
+	if ((c == CR) && (USB.flag_ignorecr)) return;
+	if ((c == LF) && (USB.flag_ignorelf)) return;
+
+	// normal character path
+	advance_buffer(USBu.rx_buf_head, RX_BUFFER_SIZE);
+	if (USBu.rx_buf_head != USBu.rx_buf_tail) {	// buffer is not full
+		USBu.rx_buf[USBu.rx_buf_head] = c;		// write char unless full
+		USBu.rx_buf_count++;
+		USBu.io_rx_bytes++;						// I/O statistics - see "io" group
+		if ((c == CR) || (c == LF)) {			// a complete line is queued
+			USBu.rx_buf_lines++;
+			USBu.io_rx_lines++;
+			tg_set_event(EVENT_RX_bm);			// wake the controller the moment the line completes
+		}
+		buffer_t bufcount = xio_get_rx_bufcount_usart(&USBu);
+		if (bufcount > USBu.io_rx_max) { USBu.io_rx_max = bufcount;}
+		if (USB.flag_xoff) {
+			buffer_t hi_water = (cfg.enable_flow_control == FLOW_CONTROL_RTS) ?
+								(buffer_t)RTS_RX_HI_WATER_MARK : (buffer_t)XOFF_RX_HI_WATER_MARK;
+			if ((bufcount > hi_water) ||
+				(USBu.rx_buf_lines > RX_HI_WATER_LINES)) {
+				xio_xoff_usart(&USBu);
+				tg_set_event(EVENT_RX_bm);		// wake so an unterminated line is delivered truncated
+			}
+		}
+	} else { 											// buffer-full - toss the incoming character
+		if ((--USBu.rx_buf_head) == 0) {				// reset the head (undo the advance)
+			USBu.rx_buf_head = RX_BUFFER_SIZE-1;
+		}
+		USBu.rx_buf_count = RX_BUFFER_SIZE-1;			// reset count for good measure
+		USBu.io_rx_overruns++;							// the host overran our flow control
+	}
+}
+
+/*
+ * xio_get_usb_rx_free() - returns free space in the USB RX buffer
+ *
+ *	Remember: The RX queue fills from bottom to top, w/0 never used
+ */
+buffer_t xio_get_usb_rx_free(void)
+{
+	return (RX_BUFFER_SIZE - xio_get_rx_bufcount_usart(&USBu));
+}
+
+/*
+ * xio_reset_usb_rx_buffers() - clears the USB RX buffer
+ */
+void xio_reset_usb_rx_buffers(void)
+{
+	// reset xio_gets() buffer
+	USB.len = 0;
+	USB.flag_in_line = false;
+
+	// reset interrupt circular buffer
+	BUFFER_CRITICAL_ENTER();	// the ISRs own some of these indexes
+	USBu.rx_buf_head = 1;		// can't use location 0 in circular buffer
+	USBu.rx_buf_tail = 1;
+	USBu.rx_buf_lines = 0;
+	USBu.tx_buf_head = 1;
+	USBu.tx_buf_tail = 1;
+	BUFFER_CRITICAL_EXIT();
+
+	// reset the zero-copy line scanner
+	USBu.rx_buf_scan = 1;
+	USBu.rx_buf_scan_len = 0;
+	USBu.rx_line_pending = false;
+}
@@ -0,0 +1,265 @@
+/*
+ * xmega_crc.c - hardware CRC unit and background memory integrity scan
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* CRC support and memory integrity scanning
+ *
+ *	crc16() computes CRC-16-CCITT (poly 0x1021, seed 0xFFFF) over a block.
+ *	Parts that have the hardware CRC unit (A3U and later - the stock v8
+ *	board's ATxmega192A3 predates it) clock the bytes through the peripheral;
+ *	everything else falls back to a nibble-table software loop. Note that the
+ *	line/footer checksum protocol does NOT use this - that algorithm is
+ *	computed by hosts at the other end of the wire and cannot be swapped
+ *	(see compute_checksum() in util.c).
+ *
+ *	crc_scan() is a background scan of RAM integrity, dispatched from
+ *	_system_assertions() in controller.c. The magic-number scheme it extends
+ *	checked 19 boundary sentinels on every controller pass but was blind to
+ *	corruption in the interiors of the structs. The scan does better on both
+ *	counts:
+ *
+ *	  - Each full scan cycle starts by sweeping the same 19 sentinels, so
+ *		boundary overruns of the cm/gm/mb/mr/ar/st structs are still caught -
+ *		once per cycle instead of every pass, which is where the CPU saving
+ *		comes from.
+ *
+ *	  - The cycle then CRCs the interior of the cfg struct in CRC_SCAN_CHUNK
+ *		byte slices, one slice per pass, and compares the result against a
+ *		reference taken on the previous clean cycle. A flipped bit anywhere
+ *		in ~2K of settings shows up within one cycle.
+ *
+ *	cfg is mutable, so legitimate writers must call crc_scan_invalidate().
+ *	An invalidated (or torn - written mid-cycle) pass is discarded and the
+ *	next complete pass becomes the new reference; the cost of a missed hook
+ *	is therefore a false alarm, so the scan deliberately skips the fields
+ *	that are written continuously at machining or interrupt rates:
+ *	status_report_value[] (rewritten by every filtered status report) and
+ *	the per-motor power_timer down-counters (rewritten by the stepper and
+ *	RTC callbacks). Everything else - system settings, offsets, motor and
+ *	axis configs, PWM - is covered.
+ *
+ *	The scan keeps its running remainder in RAM rather than in the CRC unit
+ *	because the peripheral's internal state can't be saved and restored
+ *	across passes (and a one-shot crc16() call in between would trash it).
+ *
+ *	Fault values returned by crc_scan() follow the numbering that
+ *	_system_assertions() has always reported (offset by ALARM_MEMORY_OFFSET):
+ *	1-19 identify the corrupted sentinel, CRC_FAULT_CFG_BODY (20) means the
+ *	cfg interior changed with no invalidation - i.e. memory corruption.
+ */
+#include <stddef.h>				// for offsetof
+#include <stdio.h>				// precursor for xio.h
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "../tinyg.h"
+#include "../util.h"
+#include "../config.h"
+#include "../controller.h"
+#include "../canonical_machine.h"
+#include "../planner.h"
+#include "../plan_arc.h"
+#include "../stepper.h"
+#include "xmega_rtc.h"
+#include "xmega_crc.h"
+
+#define CRC_SCAN_REGIONS (3 + (2 * MOTORS))	// see _load_scan_regions()
+
+typedef struct crcScanRegion {
+	const uint8_t *start;
+	uint16_t length;
+} crcScanRegion_t;
+
+static struct crcScanState {
+	uint8_t region;				// index of region in flight; CRC_SCAN_REGIONS = between cycles
+	uint16_t bytes_left;		// bytes remaining in the region in flight
+	const uint8_t *ptr;			// next byte to hash
+	uint16_t crc;				// running remainder for the cycle in flight
+	uint16_t reference;			// CRC of the last clean cycle over the cfg body
+	uint8_t reference_valid;
+	uint8_t dirty;				// set by crc_scan_invalidate() - cfg was legitimately written
+	crcScanRegion_t regions[CRC_SCAN_REGIONS];
+} cs;
+
+/* CRC-16-CCITT, one nibble at a time (16 word table in flash, 2 lookups per byte) */
+
+static const uint16_t _crc_table[16] PROGMEM = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF };
+
+static uint16_t _crc16_add(uint16_t crc, uint8_t data)
+{
+	crc = (crc << 4) ^ pgm_read_word(&_crc_table[((crc >> 12) ^ (data >> 4)) & 0x0f]);
+	crc = (crc << 4) ^ pgm_read_word(&_crc_table[((crc >> 12) ^ data) & 0x0f]);
+	return (crc);
+}
+
+/*
+ * crc16() - one-shot CRC-16-CCITT of a memory block
+ */
+uint16_t crc16(const uint8_t *data, uint16_t length)
+{
+#ifdef CRC_SOURCE_gm			// only defined for parts that have the CRC unit
+	CRC.CTRL = CRC_RESET_RESET1_gc;				// seed the checksum with 0xFFFF
+	CRC.CTRL = CRC_SOURCE_IO_gc;				// CRC-16 fed from the IO interface
+	while (length--) { CRC.DATAIN = *data++; }
+	CRC.STATUS = CRC_BUSY_bm;					// signal end-of-data
+	uint16_t crc = ((uint16_t)CRC.CHECKSUM1 << 8) | CRC.CHECKSUM0;
+	CRC.CTRL = CRC_SOURCE_DISABLE_gc;
+	return (crc);
+#else
+	uint16_t crc = 0xFFFF;
+	while (length--) { crc = _crc16_add(crc, *data++); }
+	return (crc);
+#endif
+}
+
+/*
+ * _load_scan_regions() - build the table of cfg spans the scan covers
+ *
+ *	The spans are carved to exclude the continuously-written fields noted
+ *	in the file header. If fields move in cfgParameters_t the offsetof()
+ *	arithmetic follows them.
+ */
+static void _load_scan_regions(void)
+{
+	uint8_t r = 0;
+
+	// system settings through the status report list (excludes the sample values)
+	cs.regions[r].start = (const uint8_t *)&cfg + offsetof(cfgParameters_t, nvm_base_addr);
+	cs.regions[r].length = offsetof(cfgParameters_t, status_report_value) -
+						   offsetof(cfgParameters_t, nvm_base_addr);
+	r++;
+
+	// coordinate offsets
+	cs.regions[r].start = (const uint8_t *)&cfg.offset;
+	cs.regions[r].length = sizeof(cfg.offset);
+	r++;
+
+	// motor settings, split around the live power_timer down-counter
+	for (uint8_t m=0; m<MOTORS; m++) {
+		cs.regions[r].start = (const uint8_t *)&cfg.m[m];
+		cs.regions[r].length = offsetof(cfgMotor_t, power_timer);
+		r++;
+		cs.regions[r].start = (const uint8_t *)&cfg.m[m] + offsetof(cfgMotor_t, step_angle);
+		cs.regions[r].length = sizeof(cfgMotor_t) - offsetof(cfgMotor_t, step_angle);
+		r++;
+	}
+
+	// axis and PWM settings through to (but not including) the end sentinel
+	cs.regions[r].start = (const uint8_t *)&cfg.a;
+	cs.regions[r].length = offsetof(cfgParameters_t, magic_end) - offsetof(cfgParameters_t, a);
+}
+
+/*
+ * _check_sentinels() - sweep the struct boundary magic numbers
+ *
+ *	Returns 0 if all are intact, or the fault value _system_assertions()
+ *	has always reported for that sentinel.
+ */
+static uint8_t _check_sentinels(void)
+{
+	if (tg.magic_start		!= MAGICNUM) { return (1);}
+	if (tg.magic_end		!= MAGICNUM) { return (2);}
+	if (cm.magic_start 		!= MAGICNUM) { return (3);}
+	if (cm.magic_end		!= MAGICNUM) { return (4);}
+	if (gm.magic_start		!= MAGICNUM) { return (5);}
+	if (gm.magic_end 		!= MAGICNUM) { return (6);}
+	if (cfg.magic_start		!= MAGICNUM) { return (7);}
+	if (cfg.magic_end		!= MAGICNUM) { return (8);}
+	if (cmdStr.magic_start	!= MAGICNUM) { return (9);}
+	if (cmdStr.magic_end	!= MAGICNUM) { return (10);}
+	if (mb.magic_start		!= MAGICNUM) { return (11);}
+	if (mb.magic_end		!= MAGICNUM) { return (12);}
+	if (mr.magic_start		!= MAGICNUM) { return (13);}
+	if (mr.magic_end		!= MAGICNUM) { return (14);}
+	if (ar.magic_start		!= MAGICNUM) { return (15);}
+	if (ar.magic_end		!= MAGICNUM) { return (16);}
+	if (st_get_st_magic()	!= MAGICNUM) { return (17);}
+	if (st_get_sps_magic()	!= MAGICNUM) { return (18);}
+	if (rtc.magic_end 		!= MAGICNUM) { return (19);}
+	return (0);
+}
+
+/*
+ * crc_init() - initialize the CRC unit and the scan
+ */
+void crc_init(void)
+{
+#ifdef CRC_SOURCE_gm
+	CRC.CTRL = CRC_SOURCE_DISABLE_gc;
+#endif
+	_load_scan_regions();
+	cs.region = CRC_SCAN_REGIONS;	// start a fresh cycle on the first crc_scan()
+	cs.reference_valid = false;
+	cs.dirty = false;
+}
+
+/*
+ * crc_scan_invalidate() - note a legitimate write to the cfg struct
+ *
+ *	The cycle in flight (and its reference) are discarded at the next cycle
+ *	boundary; the first complete cycle after that re-references the CRC.
+ */
+void crc_scan_invalidate(void)
+{
+	cs.dirty = true;
+}
+
+/*
+ * crc_scan() - advance the background integrity scan by one chunk
+ *
+ *	Called once per controller pass via _system_assertions(). Returns 0
+ *	if nothing is (yet) known to be wrong, otherwise a fault value.
+ */
+uint8_t crc_scan(void)
+{
+	if (cs.region == CRC_SCAN_REGIONS) {		// between cycles - sweep sentinels and restart
+		uint8_t value = _check_sentinels();
+		if (value != 0) { return (value);}
+		if (cs.dirty) {							// cfg written since the reference was taken
+			cs.reference_valid = false;
+			cs.dirty = false;
+		}
+		cs.region = 0;
+		cs.ptr = cs.regions[0].start;
+		cs.bytes_left = cs.regions[0].length;
+		cs.crc = 0xFFFF;
+		return (0);
+	}
+	uint8_t chunk = (cs.bytes_left < CRC_SCAN_CHUNK) ? cs.bytes_left : CRC_SCAN_CHUNK;
+	cs.bytes_left -= chunk;
+	while (chunk--) { cs.crc = _crc16_add(cs.crc, *cs.ptr++); }
+
+	if (cs.bytes_left == 0) {
+		if (++cs.region < CRC_SCAN_REGIONS) {	// advance to the next region
+			cs.ptr = cs.regions[cs.region].start;
+			cs.bytes_left = cs.regions[cs.region].length;
+			return (0);
+		}
+		if (cs.dirty) { 						// written mid-cycle - the CRC may be torn
+			cs.reference_valid = false;			// discard; re-reference on the next cycle
+			cs.dirty = false;
+		} else if (cs.reference_valid == false) {
+			cs.reference = cs.crc;				// this cycle becomes the new reference
+			cs.reference_valid = true;
+		} else if (cs.crc != cs.reference) {
+			return (CRC_FAULT_CFG_BODY);		// cfg changed and nobody admits to it
+		}
+	}
+	return (0);
+}
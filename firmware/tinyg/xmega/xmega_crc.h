@@ -0,0 +1,33 @@
+/*
+ * xmega_crc.h - hardware CRC unit and background memory integrity scan
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef xmega_crc_h
+#define xmega_crc_h
+
+#define CRC_SCAN_CHUNK 16		// bytes hashed per crc_scan() call - bounds the per-pass cost
+#define CRC_FAULT_CFG_BODY 20	// crc_scan() fault value for corruption inside the cfg body
+								// (values 1-19 identify a struct boundary sentinel - see controller.c)
+
+void crc_init(void);			// initialize the CRC unit and the scan region table
+uint16_t crc16(const uint8_t *data, uint16_t length);	// one-shot CRC-CCITT of a block
+
+uint8_t crc_scan(void);			// advance the background scan one chunk; 0 if clean
+void crc_scan_invalidate(void);	// call after any legitimate write to the cfg struct
+
+#endif
@@ -84,6 +84,9 @@
 
 #include <stdbool.h>
 #include "xmega_eeprom.h"
+#ifdef __FRAM
+#include "xmega_fram.h"			// external SPI FRAM backend (see __FRAM in xmega_eeprom.h)
+#endif
 #include <string.h>
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
@@ -376,29 +379,63 @@ uint16_t EEPROM_ReadString(const uint16_t address, char *buf, const uint16_t siz
 #endif //__NNVM
 }
 
-/* 
+/*
  * EEPROM_WriteBytes() - write N bytes to EEPROM; may span multiple pages
  *
- *	This function writes a byte buffer to IO mapped EEPROM. 
- *	If memory mapped EEPROM is enabled this function will not work. 
- *	This functiom will cancel all ongoing EEPROM page buffer loading 
+ *	This function writes a byte buffer to IO mapped EEPROM.
+ *	If memory mapped EEPROM is enabled this function will not work.
+ *	This functiom will cancel all ongoing EEPROM page buffer loading
  *	operations, if any.
  *
  *	Returns address past the write
+ *
+ *	For each affected page the current contents are read back and compared
+ *	to the buffer. Unchanged pages are skipped entirely. For a changed page
+ *	only the bytes that differ are loaded into the EEPROM page buffer, then
+ *	a single atomic erase & write is run for the page. The xmega only erases
+ *	and programs the byte locations that were loaded into the page buffer,
+ *	so unloaded bytes are untouched. This is one page erase per dirty page
+ *	instead of one per byte written (the previous EEPROM_WriteByte() loop),
+ *	which matters both for speed and for the 100,000 erase endurance limit.
  */
 
 uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size)
 {
-#ifdef __NNVM
+#ifdef __FRAM
+	return (FRAM_WriteBytes(address, buf, size));	// no paging, no erase - see xmega_fram.c
+#elif defined (__NNVM)
 	NNVM_WriteBytes(address, buf, size);
 	return(address + size);
 #else
-	uint16_t i;
+	uint16_t i = 0;				// index into buf
 	uint16_t addr = address;	// local copy
+	int8_t current[EEPROM_PAGESIZE];
 
 	EEPROM_DisableMapping();
-	for (i=0; i<size; i++) {
-		EEPROM_WriteByte(addr++, buf[i]);
+	while (i < size) {
+		uint8_t byteidx = addr & EEPROM_BYTE_ADDR_MASK_gm;	// offset into this page
+		uint8_t page_bytes = min((uint16_t)(EEPROM_PAGESIZE - byteidx), (size - i));
+
+		(void)EEPROM_ReadBytes(addr, current, page_bytes);
+		uint8_t dirty = false;
+		for (uint8_t j=0; j<page_bytes; j++) {
+			if (current[j] != buf[i+j]) { dirty = true; break;}
+		}
+		if (dirty) {
+			EEPROM_FlushBuffer();				// prevent unintentional writes
+			NVM.CMD = NVM_CMD_LOAD_EEPROM_BUFFER_gc;
+			NVM.ADDR1 = (addr >> 8) & EEPROM_ADDR1_MASK_gm;	// pages are aligned -
+			NVM.ADDR2 = 0x00;								// high byte is constant in a page
+			for (uint8_t j=0; j<page_bytes; j++) {
+				if (current[j] == buf[i+j]) { continue;}	// load only bytes that change
+				NVM.ADDR0 = (addr + j) & 0xFF;
+				NVM.DATA0 = buf[i+j];		// writing DATA0 loads the byte into the page buffer
+			}
+			NVM.CMD = NVM_CMD_ERASE_WRITE_EEPROM_PAGE_gc;	// Atomic Write (Erase&Write)
+			NVM_EXEC_WRAPPER();	// write protection signature and execute command
+		}
+		addr += page_bytes;
+		i += page_bytes;
 	}
 	return (addr); 				// return next address in EEPROM
 #endif //__NNVM
@@ -414,7 +451,9 @@ uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint
 
 uint16_t EEPROM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size)
 {
-#ifdef __NNVM
+#ifdef __FRAM
+	return (FRAM_ReadBytes(address, buf, size));
+#elif defined (__NNVM)
 	NNVM_ReadBytes(address, buf, size);
 	return(address + size);
 #else
@@ -62,6 +62,13 @@
 //#define __NNVM				// uncomment to use non-non-volatile RAM
 #define NNVM_SIZE 2000 		// size of emulation RAM block - xmega192/256 has 4096
 
+// UNCOMMENT (or define in the machine profile) to back the persistence
+// functions with an external SPI FRAM instead of the internal EEPROM.
+// FRAM writes complete in microseconds with no endurance limit, which lets
+// the checkpoint / persistent-position / flight-recorder features write
+// continuously instead of periodically. See xmega_fram.h for the wiring.
+//#define __FRAM				// uncomment to use external SPI FRAM
+
 #ifndef MAPPED_EEPROM_START
 #define MAPPED_EEPROM_START 0x1000
 #endif //__NNVM
@@ -75,9 +82,9 @@
 
 /* function prototypes for TinyG added functions */
 uint16_t EEPROM_WriteString(const uint16_t address, const char *buf, const uint8_t terminate);
-uint16_t EEPROM_ReadString(const uint16_t address, char *buf, const uint16_t size);
-uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size);
-uint16_t EEPROM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size);
+uint16_t EEPROM_ReadString(const uint16_t address, char *buf, const uint16_t size);
+uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size);
+uint16_t EEPROM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size);
 
 //#ifdef __UNIT_TEST_EEPROM
 void EEPROM_unit_tests(void);
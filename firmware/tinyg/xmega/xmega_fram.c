@@ -0,0 +1,133 @@
+/*
+ * xmega_fram.c - SPI FRAM driver (Ramtron/Cypress FM25 series)
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Bit-banged SPI master for an FM25-series FRAM (mode 0, MSB first).
+ *
+ *	The FRAM has no write latency: bytes are committed as they clock in, so
+ *	there is no page buffer to manage, no erase, no busy polling (RDSR never
+ *	reports busy on these parts) and no endurance budget. A whole burst write
+ *	is WREN, then WRITE + address + data in one select. The write enable
+ *	latch self-clears when the select line rises.
+ *
+ *	Bit-banging matches the SPI comm channel (xio_spi.c runs BIT_BANG on the
+ *	same pins) and clocks a byte in a few microseconds at 32 MHz, which is
+ *	still ~1000x faster per byte than an EEPROM page erase/write cycle.
+ *	Interrupts are not masked: the stepper DDA may stretch a clock phase,
+ *	which SPI tolerates by design.
+ */
+
+#include <stdbool.h>
+#include <avr/io.h>
+
+#include "../tinyg.h"
+#include "xmega_fram.h"
+
+static uint8_t fram_initialized = false;
+
+/*
+ * _fram_init() - set up the SPI pins on first use
+ *
+ *	Lazy init so the EEPROM-compatible entry points below need no init hook
+ *	(the EEPROM functions have none either). Idles SCK low (mode 0) and the
+ *	select high (deselected).
+ */
+static void _fram_init(void)
+{
+	FRAM_DATA_PORT.DIRSET = (FRAM_SCK_bm | FRAM_MOSI_bm);
+	FRAM_DATA_PORT.DIRCLR = FRAM_MISO_bm;
+	FRAM_DATA_PORT.OUTCLR = FRAM_SCK_bm;
+	FRAM_SSEL_PORT.DIRSET = FRAM_SSEL_bm;
+	FRAM_SSEL_PORT.OUTSET = FRAM_SSEL_bm;
+	fram_initialized = true;
+}
+
+/*
+ * _xfer() - clock one byte out (and in) MSB first, SPI mode 0
+ */
+static uint8_t _xfer(uint8_t data)
+{
+	uint8_t in = 0;
+
+	for (uint8_t bit=0; bit<8; bit++) {
+		if (data & 0x80) {
+			FRAM_DATA_PORT.OUTSET = FRAM_MOSI_bm;
+		} else {
+			FRAM_DATA_PORT.OUTCLR = FRAM_MOSI_bm;
+		}
+		data <<= 1;
+		FRAM_DATA_PORT.OUTSET = FRAM_SCK_bm;		// slave samples MOSI on this edge
+		in <<= 1;
+		if (FRAM_DATA_PORT.IN & FRAM_MISO_bm) {
+			in |= 0x01;
+		}
+		FRAM_DATA_PORT.OUTCLR = FRAM_SCK_bm;		// slave shifts MISO on this edge
+	}
+	return (in);
+}
+
+static void _select(void)
+{
+	if (fram_initialized == false) { _fram_init();}
+	FRAM_SSEL_PORT.OUTCLR = FRAM_SSEL_bm;
+}
+
+static void _deselect(void)
+{
+	FRAM_SSEL_PORT.OUTSET = FRAM_SSEL_bm;
+}
+
+/*
+ * FRAM_WriteBytes() - write N bytes to FRAM as a single burst
+ *
+ *	Signature matches EEPROM_WriteBytes() so xmega_eeprom.c can route to it.
+ *	Returns address past the write. No dirty-page compare is done - unlike
+ *	EEPROM there is no erase to avoid, and the compare would cost a read
+ *	burst of the same length as the write.
+ */
+uint16_t FRAM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size)
+{
+	_select();
+	(void)_xfer(FRAM_WREN);				// write enable is a select of its own
+	_deselect();
+
+	_select();
+	(void)_xfer(FRAM_WRITE);
+	(void)_xfer(address >> 8);			// big-endian 16 bit address
+	(void)_xfer(address & 0xFF);
+	for (uint16_t i=0; i<size; i++) {
+		(void)_xfer(buf[i]);			// address auto-increments in the device
+	}
+	_deselect();						// rising select clears the write enable latch
+	return (address + size);
+}
+
+/*
+ * FRAM_ReadBytes() - read N bytes from FRAM as a single burst
+ */
+uint16_t FRAM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size)
+{
+	_select();
+	(void)_xfer(FRAM_READ);
+	(void)_xfer(address >> 8);
+	(void)_xfer(address & 0xFF);
+	for (uint16_t i=0; i<size; i++) {
+		buf[i] = _xfer(0);				// address auto-increments in the device
+	}
+	_deselect();
+	return (address + size);
+}
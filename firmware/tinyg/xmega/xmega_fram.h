@@ -0,0 +1,59 @@
+/*
+ * xmega_fram.h - SPI FRAM driver (Ramtron/Cypress FM25 series)
+ * Part of TinyG project
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* FRAM is ferroelectric RAM: byte writes complete in the SPI transfer itself
+ * (no page buffers, no erase, no write latency) and endurance is effectively
+ * unlimited (10^14 cycles on the FM25 parts). Used as an optional backend for
+ * the EEPROM persistence functions - see __FRAM in xmega_eeprom.h.
+ */
+
+#ifndef xmega_fram_h
+#define xmega_fram_h
+
+/* Pin configuration
+ *
+ * The FRAM shares the SPI bus data pins defined in xio_spi.h (the xmega SPI
+ * device pinout on PORTC) and is selected with the SS2 line, leaving SS1 for
+ * the SPI comm channel. Override these in a machine profile if the part is
+ * wired differently.
+ */
+#define FRAM_DATA_PORT PORTC				// port for SCK / MISO / MOSI
+#define FRAM_SCK_bp		7					// SCK - clock bit position
+#define FRAM_MISO_bp	6					// MISO - bit position
+#define FRAM_MOSI_bp	5					// MOSI - bit position
+#define FRAM_SSEL_PORT	PORTB				// slave select port (SS2 in xio_spi.h)
+#define FRAM_SSEL_bp	3					// slave select bit position
+
+#define FRAM_SCK_bm		(1<<FRAM_SCK_bp)	// bit masks for the above
+#define FRAM_MISO_bm	(1<<FRAM_MISO_bp)
+#define FRAM_MOSI_bm	(1<<FRAM_MOSI_bp)
+#define FRAM_SSEL_bm	(1<<FRAM_SSEL_bp)
+
+/* FM25 series opcodes */
+#define FRAM_WREN		0x06				// set write enable latch
+#define FRAM_WRDI		0x04				// reset write enable latch
+#define FRAM_RDSR		0x05				// read status register
+#define FRAM_WRSR		0x01				// write status register
+#define FRAM_READ		0x03				// read memory data
+#define FRAM_WRITE		0x02				// write memory data
+
+/* function prototypes - signatures match the EEPROM byte functions */
+uint16_t FRAM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size);
+uint16_t FRAM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size);
+
+#endif
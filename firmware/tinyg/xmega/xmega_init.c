@@ -84,12 +84,14 @@ void xmega_init_clocks(void)
 	OSC.CTRL &= ~OSC_RC2MEN_bm;				// disable internal 2 MHz clock
 #endif
 
-#ifdef __CLOCK_INTERNAL_32MHZ 				// 32 MHz internal clock (Boston Android code)
-	CCP = CCP_IOREG_gc; 					// Security Signature to modify clk
-	OSC.CTRL = OSC_RC32MEN_bm; 				// enable internal 32MHz oscillator
+#ifdef __CLOCK_INTERNAL_32MHZ 				// 32 MHz internal RC, DFLL calibrated
+	OSC.CTRL |= OSC_RC32MEN_bm | OSC_RC32KEN_bm; // enable 32 MHz osc and its 32.768 kHz DFLL reference
 	while(!(OSC.STATUS & OSC_RC32MRDY_bm)); // wait for oscillator ready
-	CCP = CCP_IOREG_gc; 					// Security Signature to modify clk
-	CLK.CTRL = 0x01; 						// select sysclock 32MHz osc
+	while(!(OSC.STATUS & OSC_RC32KRDY_bm)); // wait for DFLL reference ready
+	DFLLRC32M.CTRL = DFLL_ENABLE_bm;		// calibrate continuously against the 32.768 kHz osc;
+											// uncalibrated RC drift is too loose for 115200 baud
+	CCPWrite(&CLK.CTRL, CLK_SCLKSEL_RC32M_gc); // switch to 32 MHz osc
+	OSC.CTRL &= ~OSC_RC2MEN_bm;				// disable internal 2 MHz clock
 #endif
 }
 
@@ -1,9 +1,9 @@
-/*
+/*
  * xmega_rtc.h - real-time counter/clock
  * Part of TinyG project
- *
- * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
- *
+ *
+ * Copyright (c) 2010 - 2013 Alden S. Hart Jr.
+ *
  * This file ("the software") is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License, version 2 as published by the
  * Free Software Foundation. You should have received a copy of the GNU General Public
@@ -15,16 +15,18 @@
  * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
  * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
+ */
+
 #include <avr/io.h>
-#include <avr/interrupt.h>
+#include <avr/interrupt.h>
 
 #include "../tinyg.h"
 #include "../config.h"
+#include "../controller.h"
 #include "../report.h"
 #include "../gpio.h"
 #include "../stepper.h"
+#include "../pendant.h"
 #include "xmega_rtc.h"
 
 /* 
@@ -33,7 +35,7 @@
  * This routine follows the code in app note AVR1314.
  */
 
-void rtc_init()
+void rtc_init()
 {
 	OSC.CTRL |= OSC_RC32KEN_bm;							// Turn on internal 32kHz.
 	do {} while ((OSC.STATUS & OSC_RC32KRDY_bm) == 0);	// Wait for 32kHz oscillator to stabilize.
@@ -73,18 +75,75 @@ void rtc_init()
  *		RTC.INTCTRL = RTC_OVFINTLVL_LO_gc;	// enable interrupt
  */
 
+#ifdef __PC_PROFILE
+/*
+ * With __PC_PROFILE enabled the vector is a naked trampoline that stashes
+ * the interrupted PC into the (otherwise unused) GPIOR0-2 registers before
+ * jumping to the real handler - a normal (signal) function whose compiler
+ * prologue would otherwise bury the stacked PC at an unknowable depth.
+ * The hardware pushes the 3-byte PC big-endian, so at trampoline entry it
+ * sits at SP+1..SP+3 (SP+3..SP+5 off Z after the two saves below). Only Z
+ * is borrowed, and none of the instructions used touch SREG.
+ */
+static void _rtc_isr(void) __attribute__((signal, used));
+
+ISR(RTC_COMP_vect, ISR_NAKED)
+{
+	__asm__ volatile (
+		"push r30\n\t"
+		"push r31\n\t"
+		"in   r30, __SP_L__\n\t"
+		"in   r31, __SP_H__\n\t"
+		"ldd  __tmp_reg__, Z+3\n\t"		// PC bits 16-23 (word address)
+		"out  %[b2], __tmp_reg__\n\t"
+		"ldd  __tmp_reg__, Z+4\n\t"		// PC bits 8-15
+		"out  %[b1], __tmp_reg__\n\t"
+		"ldd  __tmp_reg__, Z+5\n\t"		// PC bits 0-7
+		"out  %[b0], __tmp_reg__\n\t"
+		"pop  r31\n\t"
+		"pop  r30\n\t"
+		"jmp  _rtc_isr\n\t"
+		:
+		: [b2] "I" (_SFR_IO_ADDR(GPIOR2)),
+		  [b1] "I" (_SFR_IO_ADDR(GPIOR1)),
+		  [b0] "I" (_SFR_IO_ADDR(GPIOR0)));
+}
+
+static void _rtc_isr(void)
+#else
 ISR(RTC_COMP_vect)
+#endif
 {
 	// callbacks to whatever you need to happen on each RTC tick go here:
 	gpio_rtc_callback();					// switch debouncing
 	rpt_status_report_rtc_callback();		// status report timing
 	st_disable_motors_rtc_callback();		// stepper disable timer
+	st_dwell_rtc_callback();				// dwell countdown
+	tg_cpu_load_rtc_callback();				// CPU load sampling
+#ifdef __ANALOG_PENDANT
+	pen_rtc_callback();						// feed override knob sampling
+#endif
+#ifdef __ISR_PROFILE
+	st_isr_profile_rtc_callback();			// ISR occupancy rollup
+#endif
 
 	// here's the default RTC timer clock
-	++rtc.clock_ticks;						// increment real time clock (unused)
+	++rtc.clock_ticks;						// increment real time clock
+
+	tg_set_event(EVENT_TICK_bm);			// wake the controller for time-based callbacks
+
+#ifdef __PC_PROFILE
+	// bin the sampled PC: one bucket per 8K words (16 KB) of flash. Boot
+	// section addresses clamp into the last bucket, but the profiler only
+	// runs application code so they should never appear.
+	uint8_t bucket = ((GPIOR2 & 0x01) << 3) | (GPIOR1 >> 5);
+	if (bucket >= PCP_BUCKETS) { bucket = PCP_BUCKETS-1;}
+	pcp.bucket[bucket]++;
+	pcp.samples++;
+#endif
 }
 
-void rtc_reset_rtc_clock()
+void rtc_reset_rtc_clock()
 {
 //	RTC.INTCTRL = RTC_OVFINTLVL_OFF_gc;		// disable interrupt
 	rtc.clock_ticks = 0;
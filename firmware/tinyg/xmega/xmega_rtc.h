@@ -35,4 +35,22 @@ rtClock_t rtc;
 
 void rtc_init(void);								// initialize and start general timer
 
+/* PC sampling profiler - only compiled in __PC_PROFILE builds
+ *
+ *	Every RTC tick the ISR captures the interrupted program counter and
+ *	bins it into a coarse histogram of 16 KB flash regions. Decode the
+ *	bucket boundaries against the build's .map file to attribute samples
+ *	to modules. See xmega_rtc.c for the capture mechanics.
+ */
+#ifdef __PC_PROFILE
+
+#define PCP_BUCKETS 12								// 16 KB per bucket covers the 192K application section
+
+typedef struct pcProfile {
+	volatile uint32_t samples;						// total samples taken
+	volatile uint32_t bucket[PCP_BUCKETS];			// sample counts by 16 KB flash region
+} pcProfile_t;
+pcProfile_t pcp;
+#endif
+
 #endif
@@ -0,0 +1,16 @@
+/*
+ * avr/interrupt.h - host-native shim for the simulator build (see simulator/Makefile)
+ *
+ * The simulator is single threaded, so interrupt control collapses to no-ops.
+ */
+#ifndef sim_avr_interrupt_h
+#define sim_avr_interrupt_h
+
+#include <avr/io.h>
+
+#define ISR(vector) void vector(void)
+#define ISR_NAKED
+#define sei()
+#define cli()
+
+#endif	// sim_avr_interrupt_h
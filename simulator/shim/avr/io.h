@@ -0,0 +1,66 @@
+/*
+ * avr/io.h - host-native shim for the simulator build (see simulator/Makefile)
+ *
+ * Provides just enough of the XMEGA register model for the application
+ * headers to compile on a desktop host. The hardware-facing translation
+ * units (stepper.c, xio, drivers) are never compiled by the simulator -
+ * only their headers are seen - so the types below exist for pointer and
+ * struct declarations and the instances are never touched.
+ */
+#ifndef sim_avr_io_h
+#define sim_avr_io_h
+
+#include <stdint.h>
+
+typedef volatile uint8_t register8_t;
+typedef volatile uint16_t register16_t;
+
+typedef struct PORT_struct {
+	register8_t DIR, DIRSET, DIRCLR, DIRTGL;
+	register8_t OUT, OUTSET, OUTCLR, OUTTGL;
+	register8_t IN, INTCTRL, INT0MASK, INT1MASK, INTFLAGS;
+	register8_t PIN0CTRL, PIN1CTRL, PIN2CTRL, PIN3CTRL;
+	register8_t PIN4CTRL, PIN5CTRL, PIN6CTRL, PIN7CTRL;
+} PORT_t;
+
+typedef struct USART_struct {
+	register8_t DATA, STATUS, CTRLA, CTRLB, CTRLC;
+	register8_t BAUDCTRLA, BAUDCTRLB;
+} USART_t;
+
+typedef struct TC0_struct {
+	register8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLE;
+	register8_t INTCTRLA, INTCTRLB;
+	register16_t CNT, PER, CCA, CCB, CCC, CCD;
+	register16_t PERBUF, CCABUF, CCBBUF, CCCBUF, CCDBUF;
+} TC0_t;
+typedef struct TC0_struct TC1_t;
+
+typedef struct EVSYS_struct {
+	register8_t CH0MUX, CH1MUX, CH2MUX, CH3MUX;
+	register8_t CH0CTRL, CH1CTRL, CH2CTRL, CH3CTRL;
+} EVSYS_t;
+
+extern PORT_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+extern TC0_t TCC0, TCD0, TCE0, TCF0;
+extern TC1_t TCC1, TCD1, TCE1;
+extern EVSYS_t EVSYS;
+
+// port interrupt constants referenced from headers (values match the XMEGA)
+#define PORT_ISC_BOTHEDGES_gc (0x00)
+#define PORT_ISC_LEVEL_gc (0x03)
+#define PORT_INT0LVL_HI_gc (0x03)
+#define PORT_INT0IF_bm (0x01)
+
+// event system / QDEC constants referenced from gpio.c (values match the XMEGA)
+#define EVSYS_QDEN_bm (0x08)
+#define EVSYS_DIGFILT_2SAMPLES_gc (0x01)
+#define EVSYS_CHMUX_PORTA_PIN6_gc (0x56)
+#define EVSYS_CHMUX_PORTD_PIN6_gc (0x6E)
+#define EVSYS_CHMUX_PORTE_PIN6_gc (0x76)
+#define EVSYS_CHMUX_PORTF_PIN6_gc (0x7E)
+#define TC_EVACT_QDEC_gc (0x06 << 5)
+#define TC_EVSEL_CH0_gc (0x08)
+#define TC_CLKSEL_DIV1_gc (0x01)
+
+#endif	// sim_avr_io_h
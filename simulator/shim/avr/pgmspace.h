@@ -0,0 +1,40 @@
+/*
+ * avr/pgmspace.h - host-native shim for the simulator build (see simulator/Makefile)
+ *
+ * On the host there is no separate flash address space, so PROGMEM data is
+ * ordinary data and the pgm_read / _P string functions collapse to plain
+ * dereferences and libc calls.
+ */
+#ifndef sim_pgmspace_h
+#define sim_pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define PGM_P const char *
+
+#define pgm_read_byte(addr)		(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)	(*(const uint32_t *)(addr))
+#define pgm_read_float(addr)	(*(const float *)(addr))
+
+#define strcpy_P	strcpy
+#define strncpy_P	strncpy
+#define strcat_P	strcat
+#define strlen_P	strlen
+#define strcmp_P	strcmp
+#define strncmp_P	strncmp
+#define strstr_P	strstr
+#define memcpy_P	memcpy
+#define printf_P	printf
+#define fprintf_P	fprintf
+#define sprintf_P	sprintf
+#define snprintf_P	snprintf
+#define sscanf_P	sscanf
+#define puts_P		puts
+#define fputs_P		fputs
+
+#endif	// sim_pgmspace_h
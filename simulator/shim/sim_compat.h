@@ -0,0 +1,17 @@
+/*
+ * sim_compat.h - force-included into every simulator TU (see Makefile -include)
+ *
+ * Covers the few avr-libc / avr-gcc builtins the application code uses
+ * without including a header for them, and pulls in the register shim
+ * early so headers that assume a prior <avr/io.h> still compile.
+ */
+#ifndef sim_compat_h
+#define sim_compat_h
+
+#include <avr/io.h>
+
+#define square(x) ((x)*(x))				// avr-libc math.h extension
+
+extern volatile uint8_t SREG;			// backing store defined in sim_stubs.c
+
+#endif	// sim_compat_h
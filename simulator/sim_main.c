@@ -0,0 +1,240 @@
+/*
+ * sim_main.c - host-native simulator driver for the TinyG motion core
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Reads gcode from stdin and runs it through the real planner, arc
+ * generator and segment execution code, emitting one trace line per
+ * prepped stepper segment on stdout (see sim_stubs.c for the format).
+ * Configuration comes from the same settings profile the firmware builds
+ * with (settings.h), so trapezoid and junction tuning measured here is the
+ * tuning the machine runs.
+ *
+ * The firmware's controller loop is replaced by a simple drain: after each
+ * gcode block the arc callback and move executor are called until both go
+ * idle, which is equivalent to a machine that always keeps up.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "settings.h"
+#include "controller.h"
+#include "gcode_parser.h"
+#include "canonical_machine.h"
+#include "plan_arc.h"
+#include "planner.h"
+#include "stepper.h"
+
+stat_t status_code;						// normally declared in main.c
+
+// segment trace counters maintained by the stepper stubs (sim_stubs.c)
+extern uint32_t sim_segments;
+extern double sim_move_time_us;
+
+/*
+ * _load_settings() - apply the settings profile the way cfg_init() would
+ *
+ *	The simulator links the motion core without config.c (whose cfgArray
+ *	drags in NVM, xio and reporting), so the motion-relevant defaults are
+ *	applied here directly from the settings.h profile macros, including
+ *	the derived steps_per_unit values (same formula as config.c).
+ */
+static void _load_settings(void)
+{
+	cfg.junction_acceleration = JUNCTION_ACCELERATION;
+	cfg.junction_model = JUNCTION_MODEL;
+	cfg.chordal_tolerance = CHORDAL_TOLERANCE;
+	cfg.min_segment_len = MIN_LINE_LENGTH;
+	cfg.arc_segment_len = ARC_SEGMENT_LENGTH;
+	cfg.estd_segment_usec = NOM_SEGMENT_USEC;
+	cfg.trap_fit_tolerance = TRAPEZOID_LENGTH_FIT_TOLERANCE;
+	cfg.trap_velocity_tol = TRAPEZOID_VELOCITY_TOLERANCE;
+	cfg.jerk_match_precision = JERK_MATCH_PRECISION;
+	cfg.shaper_frequency = SHAPER_FREQUENCY;
+	cfg.shaper_damping = SHAPER_DAMPING;
+	mp_config_input_shaper();				// normally run by the $zvf/$zvz setters
+
+	cfg.m[MOTOR_1].motor_map = M1_MOTOR_MAP;
+	cfg.m[MOTOR_2].motor_map = M2_MOTOR_MAP;
+	cfg.m[MOTOR_3].motor_map = M3_MOTOR_MAP;
+	cfg.m[MOTOR_4].motor_map = M4_MOTOR_MAP;
+	cfg.m[MOTOR_1].step_angle = M1_STEP_ANGLE;
+	cfg.m[MOTOR_2].step_angle = M2_STEP_ANGLE;
+	cfg.m[MOTOR_3].step_angle = M3_STEP_ANGLE;
+	cfg.m[MOTOR_4].step_angle = M4_STEP_ANGLE;
+	cfg.m[MOTOR_1].travel_rev = M1_TRAVEL_PER_REV;
+	cfg.m[MOTOR_2].travel_rev = M2_TRAVEL_PER_REV;
+	cfg.m[MOTOR_3].travel_rev = M3_TRAVEL_PER_REV;
+	cfg.m[MOTOR_4].travel_rev = M4_TRAVEL_PER_REV;
+	cfg.m[MOTOR_1].microsteps = M1_MICROSTEPS;
+	cfg.m[MOTOR_2].microsteps = M2_MICROSTEPS;
+	cfg.m[MOTOR_3].microsteps = M3_MICROSTEPS;
+	cfg.m[MOTOR_4].microsteps = M4_MICROSTEPS;
+
+	for (uint8_t m=MOTOR_1; m<MOTORS; m++) {	// derivations per _set_motor_steps_per_unit()
+		cfg.m[m].steps_per_unit = (360 / (cfg.m[m].step_angle / cfg.m[m].microsteps) / cfg.m[m].travel_rev);
+		cfg.m[m].substeps_per_unit = cfg.m[m].steps_per_unit * DDA_SUBSTEPS;
+		cfg.m[m].substeps_per_unit_i = (int32_t)(cfg.m[m].substeps_per_unit + 0.5);
+	}
+
+	cfg.a[AXIS_X].axis_mode = X_AXIS_MODE;
+	cfg.a[AXIS_Y].axis_mode = Y_AXIS_MODE;
+	cfg.a[AXIS_Z].axis_mode = Z_AXIS_MODE;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].axis_mode = A_AXIS_MODE;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].axis_mode = B_AXIS_MODE;
+	cfg.a[AXIS_C].axis_mode = C_AXIS_MODE;
+#endif
+	cfg.a[AXIS_X].velocity_max = X_VELOCITY_MAX;
+	cfg.a[AXIS_Y].velocity_max = Y_VELOCITY_MAX;
+	cfg.a[AXIS_Z].velocity_max = Z_VELOCITY_MAX;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].velocity_max = A_VELOCITY_MAX;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].velocity_max = B_VELOCITY_MAX;
+	cfg.a[AXIS_C].velocity_max = C_VELOCITY_MAX;
+#endif
+	cfg.a[AXIS_X].feedrate_max = X_FEEDRATE_MAX;
+	cfg.a[AXIS_Y].feedrate_max = Y_FEEDRATE_MAX;
+	cfg.a[AXIS_Z].feedrate_max = Z_FEEDRATE_MAX;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].feedrate_max = A_FEEDRATE_MAX;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].feedrate_max = B_FEEDRATE_MAX;
+	cfg.a[AXIS_C].feedrate_max = C_FEEDRATE_MAX;
+#endif
+	cfg.a[AXIS_X].jerk_max = X_JERK_MAX;
+	cfg.a[AXIS_Y].jerk_max = Y_JERK_MAX;
+	cfg.a[AXIS_Z].jerk_max = Z_JERK_MAX;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].jerk_max = A_JERK_MAX;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].jerk_max = B_JERK_MAX;
+	cfg.a[AXIS_C].jerk_max = C_JERK_MAX;
+#endif
+	cfg.a[AXIS_X].jerk_rapid = X_JERK_RAPID;
+	cfg.a[AXIS_Y].jerk_rapid = Y_JERK_RAPID;
+	cfg.a[AXIS_Z].jerk_rapid = Z_JERK_RAPID;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].jerk_rapid = A_JERK_RAPID;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].jerk_rapid = B_JERK_RAPID;
+	cfg.a[AXIS_C].jerk_rapid = C_JERK_RAPID;
+#endif
+	cfg.a[AXIS_X].junction_dev = X_JUNCTION_DEVIATION;
+	cfg.a[AXIS_Y].junction_dev = Y_JUNCTION_DEVIATION;
+	cfg.a[AXIS_Z].junction_dev = Z_JUNCTION_DEVIATION;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].junction_dev = A_JUNCTION_DEVIATION;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].junction_dev = B_JUNCTION_DEVIATION;
+	cfg.a[AXIS_C].junction_dev = C_JUNCTION_DEVIATION;
+#endif
+	cfg.a[AXIS_X].travel_max = X_TRAVEL_MAX;
+	cfg.a[AXIS_Y].travel_max = Y_TRAVEL_MAX;
+	cfg.a[AXIS_Z].travel_max = Z_TRAVEL_MAX;
+#if (AXES >= 4)
+	cfg.a[AXIS_A].travel_max = A_TRAVEL_MAX;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].travel_max = B_TRAVEL_MAX;
+	cfg.a[AXIS_C].travel_max = C_TRAVEL_MAX;
+#endif
+#if (AXES >= 4)
+	cfg.a[AXIS_A].radius = A_RADIUS;
+#endif
+#if (AXES >= 6)
+	cfg.a[AXIS_B].radius = B_RADIUS;
+	cfg.a[AXIS_C].radius = C_RADIUS;
+#endif
+}
+
+/*
+ * _apply_overrides() - apply tunable overrides given as name=value arguments
+ *
+ *	Lets the tuning harness (tune_planner.py) sweep the planner tolerances
+ *	without rebuilding. Names match the hidden config tokens ($tlf etc).
+ */
+static void _apply_overrides(int argc, char *argv[])
+{
+	for (int i=1; i<argc; i++) {
+		float value;
+		if (sscanf(argv[i], "tlf=%f", &value) == 1) { cfg.trap_fit_tolerance = value; continue;}
+		if (sscanf(argv[i], "tvt=%f", &value) == 1) { cfg.trap_velocity_tol = value; continue;}
+		if (sscanf(argv[i], "jmp=%f", &value) == 1) { cfg.jerk_match_precision = value; continue;}
+		if (sscanf(argv[i], "ja=%f",  &value) == 1) { cfg.junction_acceleration = value; continue;}
+		fprintf(stderr, "unrecognized argument: %s\n", argv[i]);
+		exit(2);
+	}
+}
+
+/*
+ * _drain() - run the continuations and move executor until the planner is empty
+ */
+static void _drain(void)
+{
+	for (;;) {
+		uint8_t drill_busy = (cm_drill_callback() != STAT_NOOP);
+		uint8_t arc_busy = (ar_arc_callback() != STAT_NOOP);
+		uint8_t exec_busy = (mp_exec_move() != STAT_NOOP);
+		if ((drill_busy == false) && (arc_busy == false) && (exec_busy == false)) { break;}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char line[256];
+	uint32_t blocks = 0;
+	uint32_t errors = 0;
+
+	_load_settings();
+	_apply_overrides(argc, argv);
+	mp_init();
+	cm_init();
+
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		line[strcspn(line, "\r\n")] = 0;
+		if (line[0] == 0) { continue;}
+		blocks++;
+		stat_t status = gc_gcode_parser(line);
+		if ((status != STAT_OK) && (status != STAT_COMPLETE)) {
+			fprintf(stderr, "error %d at block %lu: %s\n",
+					status, (unsigned long)blocks, line);
+			errors++;
+		}
+		_drain();
+	}
+	(void)mp_flush_coalesced_line();			// release any pending coalesced micro-move
+	mp_release_startup_hold();					// end of stream - release the startup fill gate
+	_drain();
+
+	fprintf(stderr, "blocks %lu  errors %lu  segments %lu  move time %.3f s\n",
+			(unsigned long)blocks, (unsigned long)errors,
+			(unsigned long)sim_segments, sim_move_time_us / 1000000);
+	return (errors == 0 ? 0 : 1);
+}
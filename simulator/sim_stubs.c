@@ -0,0 +1,139 @@
+/*
+ * sim_stubs.c - host-side stand-ins for the hardware layers (simulator build only)
+ * Part of TinyG project
+ *
+ * Copyright (c) 2013 Alden S. Hart Jr.
+ *
+ * This file ("the software") is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2 as published by the
+ * Free Software Foundation. You should have received a copy of the GNU General Public
+ * License, version 2 along with the software.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * THE SOFTWARE IS DISTRIBUTED IN THE HOPE THAT IT WILL BE USEFUL, BUT WITHOUT ANY
+ * WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT
+ * SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+ * OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* The motion core calls out to the stepper driver, reporting, switches and
+ * spindle/coolant control. The stepper prep calls are where planned motion
+ * becomes hardware reality, so those are replaced with trace emitters:
+ *
+ *	SEG,<usec>,<m1_steps>,<m2_steps>,<m3_steps>,<m4_steps>
+ *	DWELL,<usec>
+ *
+ * one line per segment on stdout. Everything else is a no-op that just
+ * keeps the core satisfied. Fake register instances back the externs
+ * declared in shim/avr/io.h (headers reference them; nothing writes them).
+ */
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "tinyg.h"
+#include "util.h"
+#include "config.h"
+#include "canonical_machine.h"
+#include "planner.h"
+#include "stepper.h"
+#include "spindle.h"
+#include "gpio.h"
+#include "report.h"
+#include "test.h"
+#include "xio/xio.h"
+#include "xmega/xmega_crc.h"
+
+PORT_t PORTA, PORTB, PORTC, PORTD, PORTE, PORTF;
+TC0_t TCC0, TCD0, TCE0, TCF0;
+TC1_t TCC1, TCD1, TCE1;
+
+tstBenchmark_t bm;						// benchmark accounting (test.c not compiled)
+tstDryRun_t dry;						// dry run flags (test.c not compiled)
+
+volatile uint8_t SREG;					// fake status register for tg_set_event()
+
+uint32_t sim_segments = 0;				// trace counters read by sim_main.c
+double sim_move_time_us = 0;
+
+/***** stepper driver *****/
+
+uint8_t st_isbusy() { return (false);}
+void st_request_exec_move() { return;}	// sim_main drains the planner explicitly
+void st_prep_null() { return;}
+
+void st_prep_dwell(float microseconds, uint8_t dwell_code)
+{
+	printf("DWELL,%0.0f\n", (double)microseconds);
+	sim_move_time_us += microseconds;
+	mp_end_dwell();			// on hardware the dwell timer ISR frees the buffer
+}
+
+stat_t st_prep_line(float steps[], float microseconds)
+{
+	printf("SEG,%0.0f,%0.2f,%0.2f,%0.2f,%0.2f\n", (double)microseconds,
+		(double)steps[MOTOR_1], (double)steps[MOTOR_2],
+		(double)steps[MOTOR_3], (double)steps[MOTOR_4]);
+	sim_segments++;
+	sim_move_time_us += microseconds;
+	return (STAT_OK);
+}
+
+void st_enable_motors() { return;}
+void st_kill_motors() { return;}
+void st_prep_sync_output(uint8_t sync) { return;}
+
+stat_t st_prep_line_substeps(int32_t steps_X_substeps[], uint32_t microseconds)
+{
+	printf("SEG,%lu,%ld,%ld,%ld,%ld\n", (unsigned long)microseconds,
+		(long)steps_X_substeps[MOTOR_1], (long)steps_X_substeps[MOTOR_2],
+		(long)steps_X_substeps[MOTOR_3], (long)steps_X_substeps[MOTOR_4]);
+	sim_segments++;
+	sim_move_time_us += microseconds;
+	return (STAT_OK);
+}
+
+/***** spindle, coolant, switches *****/
+
+stat_t cm_set_spindle_speed(float speed) { gm.spindle_speed = speed; return (STAT_OK);}
+stat_t cm_spindle_control(uint8_t spindle_mode) { gm.spindle_mode = spindle_mode; return (STAT_OK);}
+void gpio_set_bit_on(uint8_t b) { return;}
+void gpio_set_bit_off(uint8_t b) { return;}
+
+/***** homing and probing (no switches to read on the host) *****/
+
+stat_t cm_homing_cycle_start() { return (STAT_OK);}
+stat_t cm_probe_cycle_start() { return (STAT_OK);}
+
+/***** reporting, config persistence, comms *****/
+
+void rpt_exception(uint8_t status, int16_t value)
+{
+	fprintf(stderr, "exception: status %d value %d\n", status, value);
+}
+void rpt_request_status_report(uint8_t request_type) { return;}
+void rpt_mark_sr_dirty(uint8_t sources) { return;}
+void rpt_request_queue_report(int8_t buffers) { return;}
+void rpt_clear_queue_report() { return;}
+void rpt_reset_queue_metrics() { return;}
+void rpt_queue_starved() { return;}
+void rpt_watch_sample() { return;}
+void bbx_log_segment() { return;}
+
+stat_t job_call(const char *name, const uint16_t repeats) { return (STAT_OK);}	// no stored jobs on the host
+
+stat_t cmd_persist_offsets(uint8_t flag) { return (STAT_OK);}
+cmdObj_t *cmd_add_object(char *token) { return (NULL);}
+cmdObj_t *cmd_add_message(const char *string) { return (NULL);}
+
+void xio_reset_usb_rx_buffers() { return;}
+void crc_scan_invalidate() { return;}
+void tg_reset_source() { return;}
+
+// EEPROM that reads erased - $pmp restore finds no record (see canonical_machine.c)
+uint16_t EEPROM_ReadBytes(const uint16_t address, int8_t *buf, const uint16_t size)
+{
+	for (uint16_t i=0; i<size; i++) { buf[i] = 0xFF;}
+	return (address + size);
+}
+uint16_t EEPROM_WriteBytes(const uint16_t address, const int8_t *buf, const uint16_t size) { return (address + size);}
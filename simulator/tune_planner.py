@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+#
+# tune_planner.py - sweep the planner tolerances against the gcode samples
+# Part of TinyG project
+#
+# Runs ./tinyg_sim over a corpus of sample jobs for a grid of values of the
+# planner tuning constants ($tlf trapezoid fit tolerance, $tvt trapezoid
+# velocity tolerance, $jmp jerk match precision), scoring each combination
+# on total planned move time (machine cost), segment count and host wall
+# time (both proxies for planning/exec CPU cost), with any parse or planner
+# error disqualifying the combination outright.
+#
+# The recommendation is the cheapest-to-plan combination whose move time is
+# within TIME_SLACK of the best seen - i.e. relax the tolerances as far as
+# they will go without giving up cycle time. Apply the result on a machine
+# with $tlf/$tvt/$jmp (they persist in NVM) or bake it into the settings
+# profile for the machine class.
+#
+# Usage (from this directory, after make):
+#   python3 tune_planner.py                 # default corpus
+#   python3 tune_planner.py file.gcode ...  # explicit sample files
+#
+import os
+import subprocess
+import sys
+import time
+
+SIM = "./tinyg_sim"
+SAMPLES_DIR = "../gcode_samples"
+DEFAULT_CORPUS = [
+	"circles2.gcode",		# arcs
+	"boxes_400mm.gcode",	# long lines, sharp corners
+	"mudflap_10in.gcode",	# profile cut, many short segments
+	"zoetrope.gcode",		# mixed real-world job
+	"braid_300mm.gcode",	# dense short-line toolpath
+]
+
+TIME_SLACK = 0.001		# move time within 0.1% of best counts as "as fast"
+
+TLF_GRID = [0.00001, 0.0001, 0.001, 0.01]		# mm (default 0.0001)
+TVT_GRID = [0.5, 2.0, 10.0, 50.0]				# mm/min (default 2)
+JMP_GRID = [10.0, 1000.0, 100000.0, 10000000.0]	# mm/min^3 (default 1000)
+
+def run_one(sample, tlf, tvt, jmp):
+	args = [SIM, "tlf=%g" % tlf, "tvt=%g" % tvt, "jmp=%g" % jmp]
+	with open(sample) as infile:
+		start = time.time()
+		result = subprocess.run(args, stdin=infile,
+								stdout=subprocess.DEVNULL,
+								stderr=subprocess.PIPE)
+		wall = time.time() - start
+	summary = result.stderr.decode().strip().split("\n")[-1]
+	# "blocks N  errors N  segments N  move time T s"
+	fields = summary.split()
+	errors = int(fields[3])
+	segments = int(fields[5])
+	move_time = float(fields[8])
+	if result.returncode != 0:
+		errors = max(errors, 1)
+	return (errors, segments, move_time, wall)
+
+def main():
+	samples = sys.argv[1:]
+	if not samples:
+		samples = [os.path.join(SAMPLES_DIR, name) for name in DEFAULT_CORPUS]
+	samples = [s for s in samples if os.path.exists(s)]
+	if not samples:
+		sys.exit("no sample files found - run from the simulator directory")
+	if not os.path.exists(SIM):
+		sys.exit("%s not found - run make first" % SIM)
+
+	results = []	# (tlf, tvt, jmp, errors, segments, move_time, wall)
+	combos = [(tlf, tvt, jmp) for tlf in TLF_GRID
+								for tvt in TVT_GRID
+								for jmp in JMP_GRID]
+	print("sweeping %d combinations over %d samples" % (len(combos), len(samples)))
+	print("%10s %8s %12s | %6s %9s %10s %7s" %
+		  ("tlf", "tvt", "jmp", "errors", "segments", "move_time", "wall_s"))
+	for (tlf, tvt, jmp) in combos:
+		errors = segments = 0
+		move_time = wall = 0.0
+		for sample in samples:
+			(e, s, t, w) = run_one(sample, tlf, tvt, jmp)
+			errors += e
+			segments += s
+			move_time += t
+			wall += w
+		results.append((tlf, tvt, jmp, errors, segments, move_time, wall))
+		print("%10g %8g %12g | %6d %9d %10.3f %7.2f" %
+			  (tlf, tvt, jmp, errors, segments, move_time, wall))
+
+	clean = [r for r in results if r[3] == 0]
+	if not clean:
+		sys.exit("every combination produced errors - check the corpus")
+	best_time = min(r[5] for r in clean)
+	fast = [r for r in clean if r[5] <= best_time * (1 + TIME_SLACK)]
+	pick = min(fast, key=lambda r: r[6])	# cheapest planning among the fast ones
+
+	print("\nbest move time %.3f s; %d combination(s) within %.1f%%" %
+		  (best_time, len(fast), TIME_SLACK * 100))
+	print("recommended: $tlf=%g $tvt=%g $jmp=%g "
+		  "(move time %.3f s, %d segments, %.2f s wall)" %
+		  (pick[0], pick[1], pick[2], pick[5], pick[4], pick[6]))
+
+if __name__ == "__main__":
+	main()
@@ -86,6 +86,11 @@
 
 #define CMD_CRC                 'h'
 
+// Fast Update Commands
+#define CMD_CHECK_FAST_UPDATE   'f'
+#define CMD_FAST_BAUD           'k'
+#define CMD_FAST_BLOCK_LOAD     'w'
+
 // I2C Address Autonegotiation Commands
 #define CMD_AUTONEG_START       '@'
 #define CMD_AUTONEG_DONE        '#'
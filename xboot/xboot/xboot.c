@@ -54,6 +54,27 @@ unsigned char comm_mode;
 
 unsigned char buffer[SPM_PAGESIZE];
 
+#ifdef ENABLE_FAST_UPDATE
+// Fast update baud rate table, slowest first
+// Indexed by the CMD_FAST_BAUD parameter byte
+// Entries use the fractional baud rate generator (BSCALE -7),
+// so they are only defined for clocks where the error is known good
+#if defined(__AVR_XMEGA__) && defined(USE_UART) && (F_CPU == 32000000L) && !UART_CLK2X
+static const struct
+{
+        uint16_t bsel;
+        int8_t bscale;
+} fast_bauds[] = {
+        { 983, -7 },    // 230400, -0.01% error
+        { 428, -7 },    // 460800, -0.04% error
+        { 150, -7 },    // 921600, -0.08% error
+};
+#define FAST_BAUD_COUNT (sizeof(fast_bauds) / sizeof(fast_bauds[0]))
+#else
+#define FAST_BAUD_COUNT 0
+#endif
+#endif // ENABLE_FAST_UPDATE
+
 #ifdef NEED_CODE_PROTECTION
 unsigned char protected;
 #endif // NEED_CODE_PROTECTION
@@ -431,6 +452,56 @@ int main(void)
                         BlockRead(i, val, &address);
                 }
                 #endif // ENABLE_BLOCK_SUPPORT
+                #ifdef ENABLE_FAST_UPDATE
+                // Check fast update support
+                else if (val == CMD_CHECK_FAST_UPDATE)
+                {
+                        // yes, it is supported
+                        send_char(REPLY_YES);
+                        // Send number of selectable baud rates
+                        send_char(FAST_BAUD_COUNT);
+                }
+                // Switch to a faster baud rate
+                else if (val == CMD_FAST_BAUD)
+                {
+                        // Baud rate table index
+                        val = get_char();
+
+                        #if FAST_BAUD_COUNT > 0
+                        if (comm_mode == MODE_UART && val < FAST_BAUD_COUNT)
+                        {
+                                // acknowledge at the old rate and let the
+                                // frame clear the wire before switching
+                                #ifndef USE_INTERRUPTS
+                                UART_DEVICE.STATUS = USART_TXCIF_bm;
+                                #endif // USE_INTERRUPTS
+                                send_char(REPLY_ACK);
+                                #ifdef USE_INTERRUPTS
+                                while (tx_char_cnt) { }
+                                #else // USE_INTERRUPTS
+                                while (!(UART_DEVICE.STATUS & USART_TXCIF_bm)) { }
+                                #endif // USE_INTERRUPTS
+
+                                UART_DEVICE.BAUDCTRLA = (fast_bauds[val].bsel & USART_BSEL_gm);
+                                UART_DEVICE.BAUDCTRLB = ((fast_bauds[val].bscale << USART_BSCALE_gp) & USART_BSCALE_gm) | ((fast_bauds[val].bsel >> 8) & ~USART_BSCALE_gm);
+                        }
+                        else
+                        #endif // FAST_BAUD_COUNT
+                        {
+                                send_char(REPLY_ERROR);
+                        }
+                }
+                // CRC checked block load
+                else if (val == CMD_FAST_BLOCK_LOAD)
+                {
+                        // Block size
+                        i = get_2bytes();
+                        // Memory type
+                        val = get_char();
+                        // Load it
+                        send_char(FastBlockLoad(i, val, &address));
+                }
+                #endif // ENABLE_FAST_UPDATE
                 #ifdef ENABLE_FLASH_BYTE_SUPPORT
                 // Read program memory byte
                 else if (val == CMD_READ_BYTE)
@@ -1202,6 +1273,77 @@ unsigned char BlockLoad(unsigned int size, unsigned char mem, ADDR_T *address)
         }
 }
 
+#ifdef ENABLE_FAST_UPDATE
+unsigned char FastBlockLoad(unsigned int size, unsigned char mem, ADDR_T *address)
+{
+        ADDR_T tempaddress;
+        uint16_t crc = 0;
+        uint16_t host_crc;
+        int i;
+
+        #ifdef USE_WATCHDOG
+        WDT_Reset();
+        #endif // USE_WATCHDOG
+
+        // fill up buffer, computing the CRC on the fly
+        for (i = 0; i < SPM_PAGESIZE; i++)
+        {
+                char c = 0xff;
+
+                if (i < size)
+                {
+                        c = get_char();
+                        crc = _crc16_update(crc, c);
+                }
+
+                buffer[i] = c;
+        }
+
+        // trailing CRC, big endian
+        host_crc = get_char() << 8;
+        host_crc |= get_char();
+
+        // Corrupt block: the address is left alone, so the host
+        // resends just this block with the same command
+        if (crc != host_crc)
+        {
+                return REPLY_ERROR;
+        }
+
+        // Only flash blocks travel this path
+        if (mem != MEM_FLASH)
+        {
+                return REPLY_ERROR;
+        }
+
+        // NOTE: For flash programming, 'address' is given in words.
+        tempaddress = (*address) << 1;  // Store address in page.
+
+        (*address) += size >> 1;
+
+        // Skip pages that already hold the new contents
+        // (incremental updates rewrite mostly identical images)
+        for (i = 0; i < SPM_PAGESIZE; i++)
+        {
+                if (Flash_ReadByte(tempaddress + i) != buffer[i])
+                        break;
+                Flash_WaitForSPM();
+        }
+
+        if (i == SPM_PAGESIZE)
+        {
+                return REPLY_ACK; // Page is already programmed
+        }
+
+        #ifdef ENABLE_FLASH_ERASE_WRITE
+        Flash_ProgramPage(tempaddress, buffer, 1);
+        #else
+        Flash_ProgramPage(tempaddress, buffer, 0);
+        #endif
+
+        return REPLY_ACK; // Report programming OK
+}
+#endif // ENABLE_FAST_UPDATE
 
 
 void BlockRead(unsigned int size, unsigned char mem, ADDR_T *address)
@@ -388,6 +388,10 @@ void clear_buffer(void);
 unsigned char BlockLoad(unsigned int size, unsigned char mem, ADDR_T *address);
 void BlockRead(unsigned int size, unsigned char mem, ADDR_T *address);
 
+#ifdef ENABLE_FAST_UPDATE
+unsigned char FastBlockLoad(unsigned int size, unsigned char mem, ADDR_T *address);
+#endif // ENABLE_FAST_UPDATE
+
 uint16_t crc16_block(uint32_t start, uint32_t length);
 void install_firmware(void);
 